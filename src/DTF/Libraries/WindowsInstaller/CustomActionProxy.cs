@@ -142,6 +142,10 @@ namespace WixToolset.Dtf.WindowsInstaller
                 session.Log(ex.ToString());
                 return (int) ActionResult.Failure;
             }
+            finally
+            {
+                RemotableNativeMethods.FlushQueuedRequests();
+            }
         }
 
         /// <summary>
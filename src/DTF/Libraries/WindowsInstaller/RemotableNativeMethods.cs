@@ -3,6 +3,8 @@
 namespace WixToolset.Dtf.WindowsInstaller
 {
     using System;
+    using System.Collections.Generic;
+    using System.IO;
     using System.Text;
     using System.Runtime.InteropServices;
     using System.Diagnostics.CodeAnalysis;
@@ -64,6 +66,11 @@ namespace WixToolset.Dtf.WindowsInstaller
         MsiViewGetError,
         MsiViewGetColumnInfo,
         MsiViewModify,
+
+        // Batched requests. A host that doesn't know these doesn't return
+        // the stream field, and the client falls back to one request per call.
+        MsiViewFetchBatch,
+        Batch,
     }
 
     /// <summary>
@@ -92,6 +99,41 @@ namespace WixToolset.Dtf.WindowsInstaller
 
         private static MsiRemoteInvoke remotingDelegate;
 
+        // Must match the values in RemoteMsi.cpp.
+        private const int BATCH_FIELD_NULL = 0x1;
+        private const int BATCH_FIELD_STRING = 0x2;
+
+        private const int FETCH_BATCH_SIZE = 100;
+        private const int MAX_QUEUED_REQUESTS = 100;
+
+        private static int requestCount;
+        private static bool batchingUnsupported;
+        private static Dictionary<int, RemoteView> fetchedViews;
+        private static Dictionary<int, RemoteRecord> fetchedRecords;
+        private static List<int> queuedCloseHandles;
+
+        /// <summary>
+        /// Records fetched ahead from a remote view, in order.
+        /// </summary>
+        private class RemoteView
+        {
+            public Queue<int> Records = new Queue<int>();
+            public uint LastResult;
+        }
+
+        /// <summary>
+        /// Field values of a record that was fetched in a batch. The fields
+        /// are cleared when the record is changed, after which its values
+        /// are read remotely again.
+        /// </summary>
+        private class RemoteRecord
+        {
+            public int[] Flags;
+            public int[] IntValues;
+            public uint[] DataSizes;
+            public string[] Strings;
+        }
+
         /// <summary>
         /// Checks if the current process is using remoting to access the
         /// MSI session and database APIs.
@@ -118,6 +160,12 @@ namespace WixToolset.Dtf.WindowsInstaller
             {
                 RemotableNativeMethods.remotingDelegate = value;
 
+                RemotableNativeMethods.requestCount = 0;
+                RemotableNativeMethods.batchingUnsupported = false;
+                RemotableNativeMethods.fetchedViews = new Dictionary<int, RemoteView>();
+                RemotableNativeMethods.fetchedRecords = new Dictionary<int, RemoteRecord>();
+                RemotableNativeMethods.queuedCloseHandles = new List<int>();
+
                 if (value != null && requestBuf == IntPtr.Zero)
                 {
                     requestFieldDataOffset = Marshal.SizeOf(typeof(IntPtr));
@@ -128,6 +176,18 @@ namespace WixToolset.Dtf.WindowsInstaller
             }
         }
 
+        /// <summary>
+        /// Gets the number of requests sent through the remoting delegate
+        /// since it was set.
+        /// </summary>
+        internal static int RequestCount
+        {
+            get
+            {
+                return RemotableNativeMethods.requestCount;
+            }
+        }
+
         internal static bool IsRemoteHandle(int handle)
         {
             return (handle & Int32.MinValue) != 0;
@@ -251,6 +311,311 @@ namespace WixToolset.Dtf.WindowsInstaller
             Marshal.Copy(sPtr, sBuf, 0, count);
         }
 
+        private static void Invoke(RemoteMsiFunctionId id, IntPtr request, out IntPtr response)
+        {
+            RemotableNativeMethods.requestCount++;
+            RemotableNativeMethods.remotingDelegate(id, request, out response);
+        }
+
+        private static void WriteStream(IntPtr buf, int field, IntPtr value, int count)
+        {
+            // The length goes in the following field, where the host looks for it.
+            Marshal.WriteInt32(buf, (field * requestFieldSize), (int) VarEnum.VT_STREAM);
+            Marshal.WriteIntPtr(buf, (field * requestFieldSize) + requestFieldDataOffset, value);
+            WriteInt(buf, field + 1, count);
+        }
+
+        private static bool HasStream(IntPtr buf, int field)
+        {
+            return (VarEnum) Marshal.ReadInt32(buf, (field * requestFieldSize)) == VarEnum.VT_STREAM;
+        }
+
+        private static void WriteBatchString(BinaryWriter writer, string value)
+        {
+            writer.Write(value.Length);
+            writer.Write(Encoding.Unicode.GetBytes(value));
+            writer.Write((short) 0);
+            if ((value.Length & 1) == 0)
+            {
+                // Pad to a multiple of 4 bytes.
+                writer.Write((short) 0);
+            }
+        }
+
+        private static int ReadBatchInt(byte[] data, ref int offset)
+        {
+            if (offset + 4 > data.Length)
+            {
+                throw new InstallerException("Invalid data received from remote MSI function invocation.");
+            }
+
+            int value = BitConverter.ToInt32(data, offset);
+            offset += 4;
+            return value;
+        }
+
+        private static string ReadBatchString(byte[] data, ref int offset)
+        {
+            int length = ReadBatchInt(data, ref offset);
+            int size = ((length + 1) * 2 + 3) & ~3;
+            if (length < 0 || offset + size > data.Length)
+            {
+                throw new InstallerException("Invalid data received from remote MSI function invocation.");
+            }
+
+            string value = Encoding.Unicode.GetString(data, offset, length * 2);
+            offset += size;
+            return value;
+        }
+
+        /// <summary>
+        /// Sends several requests at once, and returns the response fields of each.
+        /// Fields are ints, strings, or null. Returns null if the host doesn't
+        /// support batched requests. Must be called with the remoting lock held.
+        /// </summary>
+        private static object[][] SendBatch(IList<RemoteMsiFunctionId> ids, IList<object[]> requests)
+        {
+            if (RemotableNativeMethods.batchingUnsupported)
+            {
+                return null;
+            }
+
+            byte[] data;
+            using (MemoryStream stream = new MemoryStream())
+            {
+                BinaryWriter writer = new BinaryWriter(stream);
+                for (int i = 0; i < ids.Count; i++)
+                {
+                    writer.Write((int) ids[i]);
+                    for (int field = 0; field < MAX_REQUEST_FIELDS; field++)
+                    {
+                        object value = field < requests[i].Length ? requests[i][field] : null;
+                        if (value is int)
+                        {
+                            writer.Write((int) VarEnum.VT_I4);
+                            writer.Write((int) value);
+                        }
+                        else if (value is string)
+                        {
+                            writer.Write((int) VarEnum.VT_LPWSTR);
+                            RemotableNativeMethods.WriteBatchString(writer, (string) value);
+                        }
+                        else
+                        {
+                            writer.Write((int) VarEnum.VT_EMPTY);
+                        }
+                    }
+                }
+                writer.Flush();
+                data = stream.ToArray();
+            }
+
+            IntPtr dataPtr = Marshal.AllocHGlobal(Math.Max(data.Length, 1));
+            try
+            {
+                Marshal.Copy(data, 0, dataPtr, data.Length);
+                ClearData(requestBuf);
+                WriteInt(requestBuf, 0, ids.Count);
+                WriteStream(requestBuf, 1, dataPtr, data.Length);
+                IntPtr resp;
+                Invoke(RemoteMsiFunctionId.Batch, requestBuf, out resp);
+
+                if (!RemotableNativeMethods.HasStream(resp, 1))
+                {
+                    RemotableNativeMethods.batchingUnsupported = true;
+                    return null;
+                }
+
+                uint ret = unchecked ((uint) ReadInt(resp, 0));
+                if (ret != 0)
+                {
+                    throw InstallerException.ExceptionFromReturnCode(ret);
+                }
+
+                data = new byte[ReadInt(resp, 2)];
+                if (data.Length > 0)
+                {
+                    ReadStream(resp, 1, data, data.Length);
+                }
+            }
+            finally
+            {
+                Marshal.FreeHGlobal(dataPtr);
+            }
+
+            object[][] responses = new object[ids.Count][];
+            int offset = 0;
+            for (int i = 0; i < responses.Length; i++)
+            {
+                responses[i] = new object[MAX_REQUEST_FIELDS];
+                for (int field = 0; field < MAX_REQUEST_FIELDS; field++)
+                {
+                    VarEnum vt = (VarEnum) ReadBatchInt(data, ref offset);
+                    if (vt == VarEnum.VT_I4 || vt == VarEnum.VT_UI4)
+                    {
+                        responses[i][field] = ReadBatchInt(data, ref offset);
+                    }
+                    else if (vt == VarEnum.VT_LPWSTR)
+                    {
+                        responses[i][field] = ReadBatchString(data, ref offset);
+                    }
+                }
+            }
+            return responses;
+        }
+
+        /// <summary>
+        /// Fetches the next batch of records of a remote view, along with all their field values.
+        /// Must be called with the remoting lock held.
+        /// </summary>
+        private static void FetchBatch(int hView, RemoteView view)
+        {
+            ClearData(requestBuf);
+            WriteInt(requestBuf, 0, hView);
+            WriteInt(requestBuf, 1, FETCH_BATCH_SIZE);
+            IntPtr resp;
+            Invoke(RemoteMsiFunctionId.MsiViewFetchBatch, requestBuf, out resp);
+
+            if (!RemotableNativeMethods.HasStream(resp, 1))
+            {
+                RemotableNativeMethods.batchingUnsupported = true;
+                return;
+            }
+
+            byte[] data = new byte[ReadInt(resp, 2)];
+            ReadStream(resp, 1, data, data.Length);
+            int recordCount = ReadInt(resp, 3);
+
+            int offset = 0;
+            view.LastResult = unchecked ((uint) ReadBatchInt(data, ref offset));
+            for (int i = 0; i < recordCount; i++)
+            {
+                int hRecord = ReadBatchInt(data, ref offset);
+                int fieldCount = ReadBatchInt(data, ref offset) + 1;
+
+                RemoteRecord record = new RemoteRecord();
+                record.Flags = new int[fieldCount];
+                record.IntValues = new int[fieldCount];
+                record.DataSizes = new uint[fieldCount];
+                record.Strings = new string[fieldCount];
+                for (int field = 0; field < fieldCount; field++)
+                {
+                    record.Flags[field] = ReadBatchInt(data, ref offset);
+                    record.IntValues[field] = ReadBatchInt(data, ref offset);
+                    record.DataSizes[field] = unchecked ((uint) ReadBatchInt(data, ref offset));
+                    if ((record.Flags[field] & BATCH_FIELD_STRING) != 0)
+                    {
+                        record.Strings[field] = ReadBatchString(data, ref offset);
+                    }
+                }
+
+                RemotableNativeMethods.fetchedRecords[hRecord] = record;
+                view.Records.Enqueue(hRecord);
+            }
+        }
+
+        /// <summary>
+        /// Gets the cached values of a record that was fetched in a batch,
+        /// or null if the field has to be read remotely.
+        /// Must be called with the remoting lock held.
+        /// </summary>
+        private static RemoteRecord GetFetchedRecord(int hRecord, uint iField)
+        {
+            RemoteRecord record;
+            if (RemotableNativeMethods.fetchedRecords.TryGetValue(hRecord, out record) &&
+                record.Flags != null && iField < record.Flags.Length)
+            {
+                return record;
+            }
+            return null;
+        }
+
+        private static void InvalidateFetchedRecord(int hRecord)
+        {
+            lock (RemotableNativeMethods.remotingDelegate)
+            {
+                RemoteRecord record;
+                if (RemotableNativeMethods.fetchedRecords.TryGetValue(hRecord, out record))
+                {
+                    record.Flags = null;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Closes the records that were fetched ahead but not handed out,
+        /// so the view can be re-executed or closed.
+        /// Must be called with the remoting lock held.
+        /// </summary>
+        private static void DiscardFetchedRecords(RemoteView view)
+        {
+            foreach (int hRecord in view.Records)
+            {
+                RemotableNativeMethods.fetchedRecords.Remove(hRecord);
+                RemotableNativeMethods.QueueCloseHandle(hRecord);
+            }
+            view.Records.Clear();
+            view.LastResult = 0;
+        }
+
+        private static void QueueCloseHandle(int hAny)
+        {
+            RemotableNativeMethods.queuedCloseHandles.Add(hAny);
+            if (RemotableNativeMethods.queuedCloseHandles.Count >= MAX_QUEUED_REQUESTS)
+            {
+                RemotableNativeMethods.FlushQueuedRequests();
+            }
+        }
+
+        /// <summary>
+        /// Sends any requests that were queued to be sent with the next batch.
+        /// </summary>
+        /// <remarks><p>
+        /// Closing a record that was fetched in a batch doesn't need its result,
+        /// so those are queued and sent together. The custom action proxy
+        /// flushes the queue when the custom action returns.
+        /// </p></remarks>
+        internal static void FlushQueuedRequests()
+        {
+            if (!RemotingEnabled)
+            {
+                return;
+            }
+
+            lock (RemotableNativeMethods.remotingDelegate)
+            {
+                List<int> handles = RemotableNativeMethods.queuedCloseHandles;
+                if (handles.Count == 0)
+                {
+                    return;
+                }
+                RemotableNativeMethods.queuedCloseHandles = new List<int>();
+
+                RemoteMsiFunctionId[] ids = new RemoteMsiFunctionId[handles.Count];
+                object[][] requests = new object[handles.Count][];
+                for (int i = 0; i < handles.Count; i++)
+                {
+                    ids[i] = RemoteMsiFunctionId.MsiCloseHandle;
+                    requests[i] = new object[] { handles[i] };
+                }
+
+                try
+                {
+                    if (RemotableNativeMethods.SendBatch(ids, requests) == null)
+                    {
+                        foreach (int hAny in handles)
+                        {
+                            RemotableNativeMethods.MsiFunc_III(RemoteMsiFunctionId.MsiCloseHandle, hAny, 0, 0);
+                        }
+                    }
+                }
+                catch (InstallerException)
+                {
+                    // Like closing a handle directly, a failure isn't reported to the caller.
+                }
+            }
+        }
+
         private static uint MsiFunc_III(RemoteMsiFunctionId id, int in1, int in2, int in3)
         {
             lock (RemotableNativeMethods.remotingDelegate)
@@ -260,7 +625,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 1, in2);
                 WriteInt(requestBuf, 2, in3);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 return unchecked ((uint) ReadInt(resp, 0));
             }
         }
@@ -274,7 +639,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 1, in2);
                 WriteString(requestBuf, 2, in3);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 2);
                 return unchecked ((uint) ReadInt(resp, 0));
             }
@@ -289,7 +654,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteString(requestBuf, 1, in2);
                 WriteInt(requestBuf, 2, in3);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 2);
                 return unchecked ((uint) ReadInt(resp, 0));
             }
@@ -304,7 +669,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteString(requestBuf, 1, in2);
                 WriteString(requestBuf, 2, in3);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 1);
                 FreeString(requestBuf, 2);
                 return unchecked ((uint) ReadInt(resp, 0));
@@ -319,7 +684,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 0, in1);
                 WriteInt(requestBuf, 1, in2);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 uint ret = unchecked ((uint) ReadInt(resp, 0));
                 out1 = ReadInt(resp, 1);
                 return ret;
@@ -336,7 +701,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 2, in3);
                 WriteInt(requestBuf, 3, in4);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 1);
                 uint ret = unchecked ((uint) ReadInt(resp, 0));
                 out1 = ReadInt(resp, 1);
@@ -352,7 +717,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 0, in1);
                 WriteString(requestBuf, 1, in2);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 1);
                 uint ret = unchecked ((uint) ReadInt(resp, 0));
                 out1 = ReadInt(resp, 1);
@@ -369,7 +734,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 0, in1);
                 WriteInt(requestBuf, 1, in2);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 uint ret = unchecked ((uint) ReadInt(resp, 0));
                 if (ret == 0) ReadString(resp, 1, out1, ref cchOut1);
                 return ret;
@@ -384,7 +749,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 0, in1);
                 WriteString(requestBuf, 1, in2);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 1);
                 uint ret = unchecked ((uint) ReadInt(resp, 0));
                 if (ret == 0) ReadString(resp, 1, out1, ref cchOut1);
@@ -402,7 +767,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(requestBuf, 2, in3);
                 WriteInt(requestBuf, 3, in4);
                 IntPtr resp;
-                remotingDelegate(id, requestBuf, out resp);
+                Invoke(id, requestBuf, out resp);
                 FreeString(requestBuf, 1);
                 uint ret = unchecked ((uint) ReadInt(resp, 0));
                 if (ret == 0) ReadString(resp, 1, out1, ref cchOut1);
@@ -430,7 +795,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 WriteInt(buf, 1, unchecked ((int) eMessageType));
                 WriteInt(buf, 2, RemotableNativeMethods.GetRemoteHandle(hRecord));
                 IntPtr resp;
-                remotingDelegate(RemoteMsiFunctionId.MsiProcessMessage, buf, out resp);
+                Invoke(RemoteMsiFunctionId.MsiProcessMessage, buf, out resp);
                 Marshal.FreeHGlobal(buf);
                 return ReadInt(resp, 0);
             }
@@ -440,9 +805,26 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hAny))
                 return NativeMethods.MsiCloseHandle(hAny);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
+            {
+                int hRemote = RemotableNativeMethods.GetRemoteHandle(hAny);
+
+                RemoteView view;
+                if (RemotableNativeMethods.fetchedViews.TryGetValue(hRemote, out view))
+                {
+                    RemotableNativeMethods.DiscardFetchedRecords(view);
+                    RemotableNativeMethods.fetchedViews.Remove(hRemote);
+                }
+
+                if (RemotableNativeMethods.fetchedRecords.Remove(hRemote))
+                {
+                    RemotableNativeMethods.QueueCloseHandle(hRemote);
+                    return 0;
+                }
+
                 return RemotableNativeMethods.MsiFunc_III(
-                    RemoteMsiFunctionId.MsiCloseHandle, RemotableNativeMethods.GetRemoteHandle(hAny), 0, 0);
+                    RemoteMsiFunctionId.MsiCloseHandle, hRemote, 0, 0);
+            }
         }
 
         internal static uint MsiGetProperty(int hInstall, string szName, StringBuilder szValueBuf, ref uint cchValueBuf)
@@ -474,6 +856,73 @@ namespace WixToolset.Dtf.WindowsInstaller
             }
         }
 
+        /// <summary>
+        /// Gets several properties with one remote request. Returns false without getting
+        /// any values if they have to be read one at a time, because the session isn't
+        /// remote or the custom action host doesn't support batched requests.
+        /// </summary>
+        internal static bool MsiGetProperties(int hInstall, string[] names, string[] values, uint[] errors)
+        {
+            if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hInstall))
+                return false;
+            else lock (RemotableNativeMethods.remotingDelegate)
+            {
+                RemoteMsiFunctionId[] ids = new RemoteMsiFunctionId[names.Length];
+                object[][] requests = new object[names.Length][];
+                for (int i = 0; i < names.Length; i++)
+                {
+                    ids[i] = RemoteMsiFunctionId.MsiGetProperty;
+                    requests[i] = new object[] { RemotableNativeMethods.GetRemoteHandle(hInstall), names[i] };
+                }
+
+                object[][] responses = RemotableNativeMethods.SendBatch(ids, requests);
+                if (responses == null)
+                {
+                    return false;
+                }
+
+                for (int i = 0; i < names.Length; i++)
+                {
+                    errors[i] = unchecked ((uint) (int) responses[i][0]);
+                    values[i] = (string) responses[i][1] ?? String.Empty;
+                }
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Sets several properties with one remote request. Returns false without setting
+        /// any values if they have to be set one at a time, because the session isn't
+        /// remote or the custom action host doesn't support batched requests.
+        /// </summary>
+        internal static bool MsiSetProperties(int hInstall, string[] names, string[] values, uint[] errors)
+        {
+            if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hInstall))
+                return false;
+            else lock (RemotableNativeMethods.remotingDelegate)
+            {
+                RemoteMsiFunctionId[] ids = new RemoteMsiFunctionId[names.Length];
+                object[][] requests = new object[names.Length][];
+                for (int i = 0; i < names.Length; i++)
+                {
+                    ids[i] = RemoteMsiFunctionId.MsiSetProperty;
+                    requests[i] = new object[] { RemotableNativeMethods.GetRemoteHandle(hInstall), names[i], values[i] };
+                }
+
+                object[][] responses = RemotableNativeMethods.SendBatch(ids, requests);
+                if (responses == null)
+                {
+                    return false;
+                }
+
+                for (int i = 0; i < names.Length; i++)
+                {
+                    errors[i] = unchecked ((uint) (int) responses[i][0]);
+                }
+                return true;
+            }
+        }
+
         internal static int MsiCreateRecord(uint cParams, int hAny)
         {
             // When remoting is enabled, we might need to create either a local or
@@ -496,8 +945,14 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hRecord))
                 return NativeMethods.MsiRecordGetFieldCount(hRecord);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                RemoteRecord record = RemotableNativeMethods.GetFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord), 0);
+                if (record != null)
+                {
+                    return (uint) record.Flags.Length - 1;
+                }
+
                 return RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiRecordGetFieldCount,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -510,8 +965,14 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hRecord))
                 return NativeMethods.MsiRecordGetInteger(hRecord, iField);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                RemoteRecord record = RemotableNativeMethods.GetFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord), iField);
+                if (record != null)
+                {
+                    return record.IntValues[iField];
+                }
+
                 return unchecked ((int) RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiRecordGetInteger,
                     RemotableNativeMethods.GetRemoteHandle(hRecord), 
@@ -526,8 +987,17 @@ namespace WixToolset.Dtf.WindowsInstaller
             {
                 return NativeMethods.MsiRecordGetString(hRecord, iField, szValueBuf, ref cchValueBuf);
             }
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                RemoteRecord record = RemotableNativeMethods.GetFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord), iField);
+                if (record != null && (record.Flags[iField] & BATCH_FIELD_STRING) != 0)
+                {
+                    szValueBuf.Remove(0, szValueBuf.Length);
+                    szValueBuf.Append(record.Strings[iField]);
+                    cchValueBuf = (uint) szValueBuf.Length;
+                    return 0;
+                }
+
                 return RemotableNativeMethods.MsiFunc_II_S(
                     RemoteMsiFunctionId.MsiRecordGetString,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -543,6 +1013,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 return NativeMethods.MsiRecordSetInteger(hRecord, iField, iValue);
             else
             {
+                RemotableNativeMethods.InvalidateFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord));
                 return RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiRecordSetInteger,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -557,6 +1028,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 return NativeMethods.MsiRecordSetString(hRecord, iField, szValue);
             else
             {
+                RemotableNativeMethods.InvalidateFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord));
                 return RemotableNativeMethods.MsiFunc_IIS(
                     RemoteMsiFunctionId.MsiRecordSetString,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -602,8 +1074,14 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hView))
                 return NativeMethods.MsiViewExecute(hView, hRecord);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                RemoteView view;
+                if (RemotableNativeMethods.fetchedViews.TryGetValue(RemotableNativeMethods.GetRemoteHandle(hView), out view))
+                {
+                    RemotableNativeMethods.DiscardFetchedRecords(view);
+                }
+
                 return RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiViewExecute,
                     RemotableNativeMethods.GetRemoteHandle(hView),
@@ -616,8 +1094,43 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hView))
                 return NativeMethods.MsiViewFetch(hView, out hRecord);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                if (!RemotableNativeMethods.batchingUnsupported)
+                {
+                    // Fetch records ahead in batches, and hand them out one at a time.
+                    int hRemoteView = RemotableNativeMethods.GetRemoteHandle(hView);
+                    RemoteView view;
+                    if (!RemotableNativeMethods.fetchedViews.TryGetValue(hRemoteView, out view))
+                    {
+                        view = new RemoteView();
+                        RemotableNativeMethods.fetchedViews[hRemoteView] = view;
+                    }
+
+                    if (view.Records.Count == 0 && view.LastResult == 0)
+                    {
+                        RemotableNativeMethods.FetchBatch(hRemoteView, view);
+                    }
+
+                    if (!RemotableNativeMethods.batchingUnsupported)
+                    {
+                        if (view.Records.Count > 0)
+                        {
+                            hRecord = RemotableNativeMethods.MakeRemoteHandle(view.Records.Dequeue());
+                            return 0;
+                        }
+
+                        // The end of the view is reported every time; other errors only once.
+                        uint lastResult = view.LastResult;
+                        if (lastResult != (uint) NativeMethods.Error.NO_MORE_ITEMS)
+                        {
+                            view.LastResult = 0;
+                        }
+                        hRecord = 0;
+                        return lastResult;
+                    }
+                }
+
                 uint err = RemotableNativeMethods.MsiFunc_II_I(
                     RemoteMsiFunctionId.MsiViewFetch,
                     RemotableNativeMethods.GetRemoteHandle(hView),
@@ -634,6 +1147,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 return NativeMethods.MsiViewModify(hView, iModifyMode, hRecord);
             else
             {
+                RemotableNativeMethods.InvalidateFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord));
                 return RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiViewModify,
                     RemotableNativeMethods.GetRemoteHandle(hView),
@@ -694,6 +1208,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 return NativeMethods.MsiRecordClearData(hRecord);
             else
             {
+                RemotableNativeMethods.InvalidateFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord));
                 return RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiRecordClearData,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -706,8 +1221,14 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hRecord))
                 return NativeMethods.MsiRecordIsNull(hRecord, iField);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                RemoteRecord record = RemotableNativeMethods.GetFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord), iField);
+                if (record != null)
+                {
+                    return (record.Flags[iField] & BATCH_FIELD_NULL) != 0;
+                }
+
                 return 0 != RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiRecordIsNull,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -952,13 +1473,19 @@ namespace WixToolset.Dtf.WindowsInstaller
         {
             if (!RemotingEnabled || !RemotableNativeMethods.IsRemoteHandle(hRecord))
                 return NativeMethods.MsiRecordDataSize(hRecord, iField);
-            else
+            else lock (RemotableNativeMethods.remotingDelegate)
             {
+                RemoteRecord record = RemotableNativeMethods.GetFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord), iField);
+                if (record != null)
+                {
+                    return record.DataSizes[iField];
+                }
+
                 return RemotableNativeMethods.MsiFunc_III(
                     RemoteMsiFunctionId.MsiRecordDataSize,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
                     (int) iField, 0);
-                }
+            }
         }
 
         internal static uint MsiRecordReadStream(int hRecord, uint iField, byte[] szDataBuf, ref uint cbDataBuf)
@@ -976,7 +1503,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                     WriteInt(requestBuf, 1, (int) iField);
                     WriteInt(requestBuf, 2, (int) cbDataBuf);
                     IntPtr resp;
-                    remotingDelegate(RemoteMsiFunctionId.MsiRecordReadStream, requestBuf, out resp);
+                    Invoke(RemoteMsiFunctionId.MsiRecordReadStream, requestBuf, out resp);
                     uint ret = (uint) ReadInt(resp, 0);
                     if (ret == 0)
                     {
@@ -997,6 +1524,7 @@ namespace WixToolset.Dtf.WindowsInstaller
                 return NativeMethods.MsiRecordSetStream(hRecord, iField, szFilePath);
             else
             {
+                RemotableNativeMethods.InvalidateFetchedRecord(RemotableNativeMethods.GetRemoteHandle(hRecord));
                 return RemotableNativeMethods.MsiFunc_IIS(
                     RemoteMsiFunctionId.MsiRecordSetStream,
                     RemotableNativeMethods.GetRemoteHandle(hRecord),
@@ -153,6 +153,119 @@ namespace WixToolset.Dtf.WindowsInstaller
             }
         }
 
+        /// <summary>
+        /// Gets the string values of several named installer properties.
+        /// </summary>
+        /// <param name="properties">Names of the properties to get.</param>
+        /// <returns>Values of the properties, in the same order as the names.</returns>
+        /// <exception cref="InvalidHandleException">the Session handle is invalid</exception>
+        /// <remarks><p>
+        /// When running in an out-of-proc custom action, all of the values are fetched
+        /// from the installer with one request, instead of one request per property.
+        /// </p><p>
+        /// Win32 MSI API:
+        /// <a href="http://msdn.microsoft.com/library/en-us/msi/setup/msigetproperty.asp">MsiGetProperty</a>
+        /// </p></remarks>
+        public string[] GetProperties(params string[] properties)
+        {
+            if (properties == null)
+            {
+                throw new ArgumentNullException("properties");
+            }
+
+            foreach (string property in properties)
+            {
+                if (String.IsNullOrEmpty(property))
+                {
+                    throw new ArgumentNullException("properties");
+                }
+
+                if (!this.sessionAccessValidated &&
+                    !Session.NonImmediatePropertyNames.Contains(property))
+                {
+                    this.ValidateSessionAccess();
+                }
+            }
+
+            string[] values = new string[properties.Length];
+            uint[] errors = new uint[properties.Length];
+            if (RemotableNativeMethods.MsiGetProperties((int) this.Handle, properties, values, errors))
+            {
+                foreach (uint ret in errors)
+                {
+                    if (ret != 0)
+                    {
+                        throw InstallerException.ExceptionFromReturnCode(ret);
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 0; i < properties.Length; i++)
+                {
+                    values[i] = this[properties[i]];
+                }
+            }
+            return values;
+        }
+
+        /// <summary>
+        /// Sets the string values of several named installer properties.
+        /// </summary>
+        /// <param name="properties">Names and values of the properties to set.
+        /// A null value is set as an empty string.</param>
+        /// <exception cref="InvalidHandleException">the Session handle is invalid</exception>
+        /// <remarks><p>
+        /// When running in an out-of-proc custom action, all of the values are sent
+        /// to the installer with one request, instead of one request per property.
+        /// </p><p>
+        /// Win32 MSI API:
+        /// <a href="http://msdn.microsoft.com/library/en-us/msi/setup/msisetproperty.asp">MsiSetProperty</a>
+        /// </p></remarks>
+        public void SetProperties(IDictionary<string, string> properties)
+        {
+            if (properties == null)
+            {
+                throw new ArgumentNullException("properties");
+            }
+
+            string[] names = new string[properties.Count];
+            string[] values = new string[properties.Count];
+            int i = 0;
+            foreach (KeyValuePair<string, string> property in properties)
+            {
+                if (String.IsNullOrEmpty(property.Key))
+                {
+                    throw new ArgumentNullException("properties");
+                }
+
+                names[i] = property.Key;
+                values[i] = property.Value ?? String.Empty;
+                i++;
+            }
+
+            this.ValidateSessionAccess();
+
+            uint[] errors = new uint[names.Length];
+            if (RemotableNativeMethods.MsiSetProperties((int) this.Handle, names, values, errors))
+            {
+                foreach (uint ret in errors)
+                {
+                    if (ret != 0)
+                    {
+                        throw InstallerException.ExceptionFromReturnCode(ret);
+                    }
+                }
+            }
+            else
+            {
+                for (i = 0; i < names.Length; i++)
+                {
+                    this[names[i]] = values[i];
+                }
+            }
+        }
+
         /// <summary>
         /// Creates a new Session object from an integer session handle.
         /// </summary>
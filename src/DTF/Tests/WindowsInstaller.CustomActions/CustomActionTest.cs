@@ -86,8 +86,77 @@ namespace WixToolset.Dtf.Test
             }
         }
 
+        [TestMethod]
+        public void CustomActionExtractedOnce()
+        {
+            Installer.SetInternalUI(InstallUIOptions.Silent);
+
+            const int count = 5;
+            List<string> customActions = new List<string>();
+            List<string> entryPoints = new List<string>();
+            for (int i = 0; i < count; i++)
+            {
+                customActions.Add("SampleCA1_" + i);
+                entryPoints.Add("SampleCA1");
+            }
+
+            // End with an action that cancels the install, so the product doesn't get installed.
+            customActions.Add("SampleCA2");
+            entryPoints.Add("SampleCA2");
+
+            #if DEBUG
+            string caDir = @"..\..\..\..\..\build\debug\x86\";
+            #else
+            string caDir = @"..\..\..\..\..\build\ship\x86\";
+            #endif
+            caDir = Path.GetFullPath(caDir);
+            string caFile = "WixToolset.Dtf.Samples.ManagedCA.dll";
+            string caProduct = "CustomActionExtractedOnce.msi";
+            string logFile = "CustomActionExtractedOnce.log";
+
+            this.CreateCustomActionProduct(caProduct, caDir + caFile, customActions, entryPoints, false);
+
+            Exception caughtEx = null;
+            try
+            {
+                Installer.EnableLog(InstallLogModes.Info, logFile);
+                Installer.InstallProduct(caProduct, String.Empty);
+            }
+            catch (Exception ex) { caughtEx = ex; }
+            finally
+            {
+                Installer.EnableLog(InstallLogModes.None, null);
+            }
+            Assert.IsInstanceOfType(caughtEx, typeof(InstallCanceledException),
+                "Exception thrown while installing product: " + caughtEx);
+
+            string logText = File.ReadAllText(logFile);
+            Assert.AreEqual<int>(1, CountOccurrences(logText, "SFXCA: Extracting custom action"),
+                "Checking that the custom action package was extracted once.");
+            Assert.AreEqual<int>(count, CountOccurrences(logText, "SFXCA: Using cached custom action directory"),
+                "Checking that the other invocations reused the extracted package.");
+            Assert.AreEqual<int>(count, CountOccurrences(logText, "Found file extracted in subdirectory."),
+                "Checking that every invocation ran from a complete directory.");
+        }
+
+        private static int CountOccurrences(string text, string value)
+        {
+            int count = 0;
+            for (int i = text.IndexOf(value, StringComparison.Ordinal); i >= 0; i = text.IndexOf(value, i + value.Length, StringComparison.Ordinal))
+            {
+                count++;
+            }
+            return count;
+        }
+
         private void CreateCustomActionProduct(
             string msiFile, string customActionFile, IList<string> customActions, bool sixtyFourBit)
+        {
+            this.CreateCustomActionProduct(msiFile, customActionFile, customActions, customActions, sixtyFourBit);
+        }
+
+        private void CreateCustomActionProduct(
+            string msiFile, string customActionFile, IList<string> customActions, IList<string> entryPoints, bool sixtyFourBit)
         {
             using (Database db = new Database(msiFile, DatabaseOpenMode.CreateDirect))
             {
@@ -119,7 +188,7 @@ namespace WixToolset.Dtf.Test
                         "INSERT INTO `CustomAction` (`Action`, `Type`, `Source`, `Target`) VALUES ('{0}', 1, '{1}', '{2}')",
                         customActions[i],
                         Path.GetFileName(customActionFile),
-                        customActions[i]);
+                        entryPoints[i]);
                     db.Execute(
                         "INSERT INTO `InstallExecuteSequence` (`Action`, `Condition`, `Sequence`) VALUES ('{0}', '', {1})",
                         customActions[i],
@@ -0,0 +1,587 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+namespace WixToolset.Dtf.Test
+{
+    using System;
+    using System.IO;
+    using System.Text;
+    using System.Reflection;
+    using System.Collections.Generic;
+    using System.Runtime.InteropServices;
+    using Microsoft.VisualStudio.TestTools.UnitTesting;
+    using WixToolset.Dtf.WindowsInstaller;
+    using View = WixToolset.Dtf.WindowsInstaller.View;
+
+    [TestClass]
+    public class RemoteSessionTest
+    {
+        [TestInitialize()]
+        public void Initialize()
+        {
+        }
+
+        [TestCleanup()]
+        public void Cleanup()
+        {
+        }
+
+        [TestMethod]
+        public void RemoteViewFetchBatched()
+        {
+            string dbFile = "RemoteViewFetchBatched.msi";
+
+            using (Database db = new Database(dbFile, DatabaseOpenMode.CreateDirect))
+            {
+                db.Execute("CREATE TABLE `Test` (`Id` SHORT NOT NULL, `Name` CHAR(64), `Value` LONG PRIMARY KEY `Id`)");
+                for (int i = 0; i < 500; i++)
+                {
+                    using (Record rec = new Record(3))
+                    {
+                        rec.SetInteger(1, i);
+                        if (i % 7 != 0)
+                        {
+                            rec.SetString(2, "Name" + i);
+                        }
+                        if (i % 5 != 0)
+                        {
+                            rec.SetInteger(3, i * 1000);
+                        }
+                        db.Execute("INSERT INTO `Test` (`Id`, `Name`, `Value`) VALUES (?, ?, ?)", rec);
+                    }
+                }
+
+                List<string> expected = RemoteSessionTest.ReadTestTable(db);
+                Assert.AreEqual(500, expected.Count);
+
+                int unbatchedRequests;
+                List<string> unbatched = RemoteSessionTest.ReadTestTableRemotely(db, false, out unbatchedRequests);
+                CollectionAssert.AreEqual(expected, unbatched);
+
+                int batchedRequests;
+                List<string> batched = RemoteSessionTest.ReadTestTableRemotely(db, true, out batchedRequests);
+                CollectionAssert.AreEqual(expected, batched);
+
+                Console.WriteLine("Remote requests: {0} unbatched, {1} batched", unbatchedRequests, batchedRequests);
+                Assert.IsTrue(batchedRequests * 20 < unbatchedRequests,
+                    "Expected batching to cut the number of remote requests.");
+            }
+        }
+
+        [TestMethod]
+        public void RemotePropertiesBatched()
+        {
+            string dbFile = "RemotePropertiesBatched.msi";
+
+            using (Database db = new Database(dbFile, DatabaseOpenMode.CreateDirect))
+            {
+                WindowsInstallerUtils.InitializeProductDatabase(db);
+                WindowsInstallerUtils.CreateTestProduct(db);
+                db.Commit();
+
+                using (Session session = Installer.OpenPackage(db, true))
+                {
+                    string[] names = new string[] { "TESTPROP1", "TESTPROP2", "TESTPROP3", "ProductCode", "NOSUCHPROP" };
+                    int[] requestCounts = new int[2];
+
+                    for (int pass = 0; pass < 2; pass++)
+                    {
+                        bool batching = (pass == 1);
+                        Dictionary<string, string> properties = new Dictionary<string, string>();
+                        properties["TESTPROP1"] = "Value1_" + pass;
+                        properties["TESTPROP2"] = String.Empty;
+                        properties["TESTPROP3"] = "Value3_" + pass;
+
+                        string[] values;
+                        using (RemoteSessionLoopback loopback = new RemoteSessionLoopback(batching))
+                        {
+                            Session remoteSession = Session.FromHandle(RemoteSessionLoopback.MakeRemoteHandle(session.Handle), false);
+                            remoteSession.SetProperties(properties);
+                            values = remoteSession.GetProperties(names);
+                            requestCounts[pass] = loopback.RequestCount;
+                        }
+
+                        Assert.AreEqual(names.Length, values.Length);
+                        for (int i = 0; i < names.Length; i++)
+                        {
+                            Assert.AreEqual(session[names[i]], values[i], "Property " + names[i]);
+                        }
+                        Assert.AreEqual("Value1_" + pass, values[0]);
+                        Assert.AreEqual(String.Empty, values[1]);
+                        Assert.AreEqual(String.Empty, values[4]);
+                    }
+
+                    Console.WriteLine("Remote requests: {0} unbatched, {1} batched", requestCounts[0], requestCounts[1]);
+                    Assert.IsTrue(requestCounts[1] < requestCounts[0],
+                        "Expected batching to cut the number of remote requests.");
+                }
+            }
+        }
+
+        private static List<string> ReadTestTable(Database db)
+        {
+            List<string> rows = new List<string>();
+            using (View view = db.OpenView("SELECT `Id`, `Name`, `Value` FROM `Test` ORDER BY `Id`"))
+            {
+                view.Execute();
+                foreach (Record rec in view)
+                {
+                    using (rec)
+                    {
+                        rows.Add(String.Format("{0}|{1}|{2}|{3}|{4}",
+                            rec.FieldCount,
+                            rec.GetInteger(1),
+                            rec.IsNull(2) ? "<null>" : rec.GetString(2),
+                            rec.IsNull(3) ? "<null>" : rec.GetInteger(3).ToString(),
+                            rec.GetDataSize(2)));
+                    }
+                }
+            }
+            return rows;
+        }
+
+        private static List<string> ReadTestTableRemotely(Database db, bool batching, out int requestCount)
+        {
+            List<string> rows;
+            using (RemoteSessionLoopback loopback = new RemoteSessionLoopback(batching))
+            {
+                using (Database remoteDb = Database.FromHandle(RemoteSessionLoopback.MakeRemoteHandle(db.Handle), false))
+                {
+                    rows = RemoteSessionTest.ReadTestTable(remoteDb);
+                }
+
+                loopback.Flush();
+                requestCount = loopback.RequestCount;
+                Assert.AreEqual(0, loopback.OpenRecordCount, "Records left open by the remote client.");
+            }
+            return rows;
+        }
+    }
+
+    /// <summary>
+    /// Stands in for the SfxCA remoting host, by passing requests from the remoting
+    /// delegate straight to the MSI API in this process, so the client side of the
+    /// protocol can be tested without an out-of-proc custom action.
+    /// </summary>
+    internal class RemoteSessionLoopback : IDisposable
+    {
+        private const int MAX_REQUEST_FIELDS = 4;
+        private const uint ERROR_INVALID_FUNCTION = 1;
+        private const uint ERROR_MORE_DATA = 234;
+        private const int BATCH_FIELD_NULL = 0x1;
+        private const int BATCH_FIELD_STRING = 0x2;
+
+        private delegate void InvokeHandler(int id, IntPtr request, out IntPtr response);
+
+        private static readonly int requestFieldSize = 2 * IntPtr.Size;
+        private static readonly int requestFieldDataOffset = IntPtr.Size;
+
+        private bool batching;
+        private InvokeHandler handler;
+        private Dictionary<int, string> functionNames;
+        private IntPtr responseBuf;
+        private List<IntPtr> responseAllocations;
+        private HashSet<int> openRecords;
+        private int requestCount;
+
+        public RemoteSessionLoopback(bool batching)
+        {
+            this.batching = batching;
+            this.handler = new InvokeHandler(this.Invoke);
+            this.responseBuf = Marshal.AllocHGlobal(requestFieldSize * MAX_REQUEST_FIELDS);
+            this.responseAllocations = new List<IntPtr>();
+            this.openRecords = new HashSet<int>();
+
+            Type functionIdType = RemoteSessionLoopback.GetInternalType("RemoteMsiFunctionId");
+            this.functionNames = new Dictionary<int, string>();
+            foreach (object value in Enum.GetValues(functionIdType))
+            {
+                this.functionNames[(int) value] = Enum.GetName(functionIdType, value);
+            }
+
+            // Keep a reference to the handler, so it isn't collected while the function pointer is in use.
+            Delegate remotingDelegate = Marshal.GetDelegateForFunctionPointer(
+                Marshal.GetFunctionPointerForDelegate(this.handler),
+                RemoteSessionLoopback.GetInternalType("MsiRemoteInvoke"));
+            RemoteSessionLoopback.SetRemotingDelegate(remotingDelegate);
+        }
+
+        public int RequestCount
+        {
+            get
+            {
+                return this.requestCount;
+            }
+        }
+
+        public int OpenRecordCount
+        {
+            get
+            {
+                return this.openRecords.Count;
+            }
+        }
+
+        public static IntPtr MakeRemoteHandle(IntPtr handle)
+        {
+            return (IntPtr) ((int) handle ^ Int32.MinValue);
+        }
+
+        public void Flush()
+        {
+            RemoteSessionLoopback.GetInternalType("RemotableNativeMethods")
+                .GetMethod("FlushQueuedRequests", BindingFlags.Static | BindingFlags.NonPublic)
+                .Invoke(null, null);
+        }
+
+        public void Dispose()
+        {
+            RemoteSessionLoopback.SetRemotingDelegate(null);
+
+            this.FreeResponseAllocations();
+            if (this.responseBuf != IntPtr.Zero)
+            {
+                Marshal.FreeHGlobal(this.responseBuf);
+                this.responseBuf = IntPtr.Zero;
+            }
+
+            foreach (int hRecord in this.openRecords)
+            {
+                MsiCloseHandle(hRecord);
+            }
+            this.openRecords.Clear();
+        }
+
+        private static Type GetInternalType(string name)
+        {
+            return typeof(Session).Assembly.GetType("WixToolset.Dtf.WindowsInstaller." + name, true);
+        }
+
+        private static void SetRemotingDelegate(Delegate remotingDelegate)
+        {
+            RemoteSessionLoopback.GetInternalType("RemotableNativeMethods")
+                .GetProperty("RemotingDelegate", BindingFlags.Static | BindingFlags.NonPublic)
+                .SetValue(null, remotingDelegate, null);
+        }
+
+        private void Invoke(int id, IntPtr request, out IntPtr response)
+        {
+            this.requestCount++;
+            this.FreeResponseAllocations();
+
+            string function;
+            if (!this.functionNames.TryGetValue(id, out function))
+            {
+                function = String.Empty;
+            }
+
+            object[] result = this.Process(function, RemoteSessionLoopback.ReadFields(request), true);
+            this.WriteFields(result);
+            response = this.responseBuf;
+        }
+
+        private object[] Process(string function, object[] request, bool topLevel)
+        {
+            int h = (request[0] is int ? (int) request[0] : 0);
+            uint field = (request[1] is int ? (uint) (int) request[1] : 0);
+            uint ret;
+            int hOut;
+            string value;
+
+            switch (function)
+            {
+                case "MsiCloseHandle":
+                    this.openRecords.Remove(h);
+                    return Result(MsiCloseHandle(h));
+
+                case "MsiDatabaseOpenView":
+                    ret = MsiDatabaseOpenViewW(h, (string) request[1], out hOut);
+                    return Result(ret, hOut);
+
+                case "MsiViewExecute":
+                    return Result(MsiViewExecute(h, (int) request[1]));
+
+                case "MsiViewFetch":
+                    ret = MsiViewFetch(h, out hOut);
+                    if (ret == 0)
+                    {
+                        this.openRecords.Add(hOut);
+                    }
+                    return Result(ret, hOut);
+
+                case "MsiRecordGetFieldCount":
+                    return Result(MsiRecordGetFieldCount(h));
+
+                case "MsiRecordGetInteger":
+                    return Result(unchecked ((uint) MsiRecordGetInteger(h, field)));
+
+                case "MsiRecordIsNull":
+                    return Result(MsiRecordIsNull(h, field) ? 1u : 0u);
+
+                case "MsiRecordDataSize":
+                    return Result(MsiRecordDataSize(h, field));
+
+                case "MsiRecordGetString":
+                    ret = RemoteSessionLoopback.GetRecordString(h, field, out value);
+                    return Result(ret, value);
+
+                case "MsiGetMode":
+                    return Result(MsiGetMode(h, field) ? 1u : 0u);
+
+                case "MsiGetProperty":
+                    ret = RemoteSessionLoopback.GetProperty(h, (string) request[1], out value);
+                    return Result(ret, value);
+
+                case "MsiSetProperty":
+                    return Result(MsiSetPropertyW(h, (string) request[1], (string) request[2]));
+
+                case "MsiViewFetchBatch":
+                    if (this.batching && topLevel)
+                    {
+                        return this.ProcessViewFetchBatch(h, (int) request[1]);
+                    }
+                    break;
+
+                case "Batch":
+                    if (this.batching && topLevel)
+                    {
+                        return this.ProcessBatch(h, (byte[]) request[1]);
+                    }
+                    break;
+            }
+
+            return Result(ERROR_INVALID_FUNCTION);
+        }
+
+        private object[] ProcessViewFetchBatch(int hView, int maxRecords)
+        {
+            int recordCount = 0;
+            uint ret = 0;
+            byte[] data;
+            using (MemoryStream stream = new MemoryStream())
+            {
+                BinaryWriter writer = new BinaryWriter(stream);
+                writer.Write(0);
+
+                while (recordCount < maxRecords)
+                {
+                    int hRecord;
+                    ret = MsiViewFetch(hView, out hRecord);
+                    if (ret != 0)
+                    {
+                        break;
+                    }
+
+                    this.openRecords.Add(hRecord);
+                    uint fieldCount = MsiRecordGetFieldCount(hRecord);
+                    writer.Write(hRecord);
+                    writer.Write((int) fieldCount);
+                    for (uint field = 0; field <= fieldCount; field++)
+                    {
+                        string value;
+                        uint retString = RemoteSessionLoopback.GetRecordString(hRecord, field, out value);
+                        writer.Write((MsiRecordIsNull(hRecord, field) ? BATCH_FIELD_NULL : 0) |
+                            (retString == 0 ? BATCH_FIELD_STRING : 0));
+                        writer.Write(MsiRecordGetInteger(hRecord, field));
+                        writer.Write(MsiRecordDataSize(hRecord, field));
+                        if (retString == 0)
+                        {
+                            RemoteSessionLoopback.WriteBatchString(writer, value);
+                        }
+                    }
+
+                    recordCount++;
+                }
+
+                writer.Seek(0, SeekOrigin.Begin);
+                writer.Write(ret);
+                writer.Flush();
+                data = stream.ToArray();
+            }
+
+            return new object[] { unchecked ((int) (recordCount > 0 ? 0 : ret)), data, data.Length, recordCount };
+        }
+
+        private object[] ProcessBatch(int count, byte[] requestData)
+        {
+            byte[] data;
+            using (MemoryStream responseStream = new MemoryStream())
+            {
+                BinaryReader reader = new BinaryReader(new MemoryStream(requestData));
+                BinaryWriter writer = new BinaryWriter(responseStream);
+                for (int i = 0; i < count; i++)
+                {
+                    int id = reader.ReadInt32();
+                    object[] request = new object[MAX_REQUEST_FIELDS];
+                    for (int field = 0; field < MAX_REQUEST_FIELDS; field++)
+                    {
+                        VarEnum vt = (VarEnum) reader.ReadInt32();
+                        if (vt == VarEnum.VT_I4 || vt == VarEnum.VT_UI4)
+                        {
+                            request[field] = reader.ReadInt32();
+                        }
+                        else if (vt == VarEnum.VT_LPWSTR)
+                        {
+                            int length = reader.ReadInt32();
+                            byte[] chars = reader.ReadBytes(((length + 1) * 2 + 3) & ~3);
+                            request[field] = Encoding.Unicode.GetString(chars, 0, length * 2);
+                        }
+                    }
+
+                    string function;
+                    this.functionNames.TryGetValue(id, out function);
+                    object[] response = this.Process(function ?? String.Empty, request, false);
+
+                    foreach (object value in response)
+                    {
+                        if (value is int)
+                        {
+                            writer.Write((int) VarEnum.VT_I4);
+                            writer.Write((int) value);
+                        }
+                        else if (value is string)
+                        {
+                            writer.Write((int) VarEnum.VT_LPWSTR);
+                            RemoteSessionLoopback.WriteBatchString(writer, (string) value);
+                        }
+                        else
+                        {
+                            writer.Write((int) VarEnum.VT_EMPTY);
+                        }
+                    }
+                }
+
+                writer.Flush();
+                data = responseStream.ToArray();
+            }
+
+            return new object[] { 0, data, data.Length, count };
+        }
+
+        private static object[] Result(uint ret, params object[] values)
+        {
+            object[] result = new object[MAX_REQUEST_FIELDS];
+            result[0] = unchecked ((int) ret);
+            Array.Copy(values, 0, result, 1, values.Length);
+            return result;
+        }
+
+        private static void WriteBatchString(BinaryWriter writer, string value)
+        {
+            writer.Write(value.Length);
+            writer.Write(Encoding.Unicode.GetBytes(value));
+            writer.Write(new byte[(((value.Length + 1) * 2 + 3) & ~3) - value.Length * 2]);
+        }
+
+        private static object[] ReadFields(IntPtr buf)
+        {
+            object[] fields = new object[MAX_REQUEST_FIELDS];
+            for (int field = 0; field < MAX_REQUEST_FIELDS; field++)
+            {
+                int offset = field * requestFieldSize;
+                VarEnum vt = (VarEnum) Marshal.ReadInt32(buf, offset);
+                if (vt == VarEnum.VT_I4 || vt == VarEnum.VT_UI4)
+                {
+                    fields[field] = Marshal.ReadInt32(buf, offset + requestFieldDataOffset);
+                }
+                else if (vt == VarEnum.VT_LPWSTR)
+                {
+                    fields[field] = Marshal.PtrToStringUni(Marshal.ReadIntPtr(buf, offset + requestFieldDataOffset));
+                }
+                else if (vt == VarEnum.VT_STREAM)
+                {
+                    // The length of a stream is in the following field.
+                    byte[] data = new byte[Marshal.ReadInt32(buf, offset + requestFieldSize + requestFieldDataOffset)];
+                    Marshal.Copy(Marshal.ReadIntPtr(buf, offset + requestFieldDataOffset), data, 0, data.Length);
+                    fields[field] = data;
+                }
+            }
+            return fields;
+        }
+
+        private void WriteFields(object[] fields)
+        {
+            for (int field = 0; field < MAX_REQUEST_FIELDS; field++)
+            {
+                int offset = field * requestFieldSize;
+                object value = fields[field];
+                if (value is int)
+                {
+                    Marshal.WriteInt32(this.responseBuf, offset, (int) VarEnum.VT_I4);
+                    Marshal.WriteIntPtr(this.responseBuf, offset + requestFieldDataOffset, IntPtr.Zero);
+                    Marshal.WriteInt32(this.responseBuf, offset + requestFieldDataOffset, (int) value);
+                }
+                else if (value is string)
+                {
+                    IntPtr stringPtr = Marshal.StringToHGlobalUni((string) value);
+                    this.responseAllocations.Add(stringPtr);
+                    Marshal.WriteInt32(this.responseBuf, offset, (int) VarEnum.VT_LPWSTR);
+                    Marshal.WriteIntPtr(this.responseBuf, offset + requestFieldDataOffset, stringPtr);
+                }
+                else if (value is byte[])
+                {
+                    byte[] data = (byte[]) value;
+                    IntPtr dataPtr = Marshal.AllocHGlobal(Math.Max(data.Length, 1));
+                    this.responseAllocations.Add(dataPtr);
+                    Marshal.Copy(data, 0, dataPtr, data.Length);
+                    Marshal.WriteInt32(this.responseBuf, offset, (int) VarEnum.VT_STREAM);
+                    Marshal.WriteIntPtr(this.responseBuf, offset + requestFieldDataOffset, dataPtr);
+                }
+                else
+                {
+                    Marshal.WriteInt32(this.responseBuf, offset, (int) VarEnum.VT_EMPTY);
+                    Marshal.WriteIntPtr(this.responseBuf, offset + requestFieldDataOffset, IntPtr.Zero);
+                }
+            }
+        }
+
+        private void FreeResponseAllocations()
+        {
+            foreach (IntPtr ptr in this.responseAllocations)
+            {
+                Marshal.FreeHGlobal(ptr);
+            }
+            this.responseAllocations.Clear();
+        }
+
+        private static uint GetRecordString(int hRecord, uint field, out string value)
+        {
+            StringBuilder buf = new StringBuilder(256);
+            uint cch = (uint) buf.Capacity;
+            uint ret = MsiRecordGetStringW(hRecord, field, buf, ref cch);
+            if (ret == ERROR_MORE_DATA)
+            {
+                buf.Capacity = (int) ++cch;
+                ret = MsiRecordGetStringW(hRecord, field, buf, ref cch);
+            }
+            value = (ret == 0 ? buf.ToString() : null);
+            return ret;
+        }
+
+        private static uint GetProperty(int hInstall, string name, out string value)
+        {
+            StringBuilder buf = new StringBuilder(256);
+            uint cch = (uint) buf.Capacity;
+            uint ret = MsiGetPropertyW(hInstall, name, buf, ref cch);
+            if (ret == ERROR_MORE_DATA)
+            {
+                buf.Capacity = (int) ++cch;
+                ret = MsiGetPropertyW(hInstall, name, buf, ref cch);
+            }
+            value = (ret == 0 ? buf.ToString() : null);
+            return ret;
+        }
+
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern uint MsiCloseHandle(int hAny);
+        [DllImport("msi.dll", CharSet=CharSet.Unicode, ExactSpelling=true)] private static extern uint MsiDatabaseOpenViewW(int hDatabase, string szQuery, out int hView);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern uint MsiViewExecute(int hView, int hRecord);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern uint MsiViewFetch(int hView, out int hRecord);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern uint MsiRecordGetFieldCount(int hRecord);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern int MsiRecordGetInteger(int hRecord, uint iField);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern bool MsiRecordIsNull(int hRecord, uint iField);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern uint MsiRecordDataSize(int hRecord, uint iField);
+        [DllImport("msi.dll", CharSet=CharSet.Unicode, ExactSpelling=true)] private static extern uint MsiRecordGetStringW(int hRecord, uint iField, StringBuilder szValueBuf, ref uint cchValueBuf);
+        [DllImport("msi.dll", ExactSpelling=true)] private static extern bool MsiGetMode(int hInstall, uint iRunMode);
+        [DllImport("msi.dll", CharSet=CharSet.Unicode, ExactSpelling=true)] private static extern uint MsiGetPropertyW(int hInstall, string szName, StringBuilder szValueBuf, ref uint cchValueBuf);
+        [DllImport("msi.dll", CharSet=CharSet.Unicode, ExactSpelling=true)] private static extern uint MsiSetPropertyW(int hInstall, string szName, string szValue);
+    }
+}
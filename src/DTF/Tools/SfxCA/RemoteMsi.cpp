@@ -251,6 +251,299 @@ UINT MsiFunc_ISII_SII(PMsiFunc_ISII_SII func, const RemoteMsiSession::RequestDat
     return ret;
 }
 
+//
+// Batched requests and responses carry their data in a single stream field, as a
+// sequence of 32-bit values. A string is its length in characters, followed by the
+// characters and a null terminator, padded to a multiple of 4 bytes. A set of request
+// fields is the VARENUM of each field followed by its value, if it's an int or string.
+//
+// MsiViewFetchBatch returns the result of the last fetch, then for each record its
+// handle and field count, and for fields 0 through the field count: flags, integer
+// value, data size, and the string value if BATCH_FIELD_STRING is set.
+//
+// Batch takes a count and a stream of requests, each an ID and a set of fields, and
+// returns the response fields of each request in order.
+//
+#define BATCH_FIELD_NULL   0x1
+#define BATCH_FIELD_STRING 0x2
+
+static DWORD BatchStringSize(DWORD cch)
+{
+    return ((cch + 1) * sizeof(WCHAR) + 3) & ~3;
+}
+
+static bool ReadBatchInt(const BYTE* pbData, DWORD cbData, __inout DWORD* pdwOffset, __out int* piValue)
+{
+    if (cbData - *pdwOffset < sizeof(int))
+    {
+        return false;
+    }
+
+    memcpy(piValue, pbData + *pdwOffset, sizeof(int));
+    *pdwOffset += sizeof(int);
+    return true;
+}
+
+static bool ReadBatchFields(const BYTE* pbData, DWORD cbData, __inout DWORD* pdwOffset, __out RemoteMsiSession::RequestData* pData)
+{
+    SecureZeroMemory(pData, sizeof(RemoteMsiSession::RequestData));
+
+    for (int i = 0; i < RemoteMsiSession::MAX_REQUEST_FIELDS; i++)
+    {
+        int vt;
+        if (!ReadBatchInt(pbData, cbData, pdwOffset, &vt))
+        {
+            return false;
+        }
+
+        pData->fields[i].vt = (VARENUM) vt;
+        if (vt == VT_I4 || vt == VT_UI4)
+        {
+            if (!ReadBatchInt(pbData, cbData, pdwOffset, &pData->fields[i].iValue))
+            {
+                return false;
+            }
+        }
+        else if (vt == VT_LPWSTR)
+        {
+            // The string is used in place, so it must be terminated within the data.
+            int cch;
+            if (!ReadBatchInt(pbData, cbData, pdwOffset, &cch) || cch < 0 ||
+                (DWORD) cch >= (cbData - *pdwOffset) / sizeof(WCHAR))
+            {
+                return false;
+            }
+
+            LPWSTR szValue = (LPWSTR) (pbData + *pdwOffset);
+            DWORD cbString = BatchStringSize((DWORD) cch);
+            if (szValue[cch] != L'\0' || cbData - *pdwOffset < cbString)
+            {
+                return false;
+            }
+
+            pData->fields[i].szValue = szValue;
+            *pdwOffset += cbString;
+        }
+        else if (vt != VT_EMPTY && vt != VT_NULL)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RemoteMsiSession::AppendBatchData(const void* pv, DWORD cb, __inout DWORD* pcbUsed)
+{
+    if (m_cbBufBatch - *pcbUsed < cb)
+    {
+        DWORD cbNew = max(max(m_cbBufBatch * 2, (DWORD) (MIN_BUFFER_STRING_SIZE * 2)), *pcbUsed + cb);
+        BYTE* pNew = new BYTE[cbNew];
+        if (pNew == NULL)
+        {
+            return false;
+        }
+
+        if (m_pBufBatch != NULL)
+        {
+            memcpy(pNew, m_pBufBatch, *pcbUsed);
+            SecureZeroMemory(m_pBufBatch, m_cbBufBatch);
+            delete[] m_pBufBatch;
+        }
+
+        m_pBufBatch = pNew;
+        m_cbBufBatch = cbNew;
+    }
+
+    memcpy(m_pBufBatch + *pcbUsed, pv, cb);
+    *pcbUsed += cb;
+    return true;
+}
+
+bool RemoteMsiSession::AppendBatchString(__in_ecount(cch + 1) const wchar_t* sz, DWORD cch, __inout DWORD* pcbUsed)
+{
+    static const BYTE rgbPadding[4] = { 0 };
+    int iCch = (int) cch;
+    DWORD cbChars = (cch + 1) * sizeof(WCHAR);
+
+    return AppendBatchData(&iCch, sizeof(int), pcbUsed) &&
+        AppendBatchData(sz, cbChars, pcbUsed) &&
+        AppendBatchData(rgbPadding, BatchStringSize(cch) - cbChars, pcbUsed);
+}
+
+bool RemoteMsiSession::AppendBatchFields(const RequestData* pData, __inout DWORD* pcbUsed)
+{
+    for (int i = 0; i < MAX_REQUEST_FIELDS; i++)
+    {
+        int vt = pData->fields[i].vt;
+        bool fAppended;
+
+        if (vt == VT_I4 || vt == VT_UI4)
+        {
+            fAppended = AppendBatchData(&vt, sizeof(int), pcbUsed) &&
+                AppendBatchData(&pData->fields[i].iValue, sizeof(int), pcbUsed);
+        }
+        else if (vt == VT_LPWSTR && pData->fields[i].szValue != NULL)
+        {
+            fAppended = AppendBatchData(&vt, sizeof(int), pcbUsed) &&
+                AppendBatchString(pData->fields[i].szValue, (DWORD) wcslen(pData->fields[i].szValue), pcbUsed);
+        }
+        else
+        {
+            vt = VT_EMPTY;
+            fAppended = AppendBatchData(&vt, sizeof(int), pcbUsed);
+        }
+
+        if (!fAppended)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// Fetches up to the requested number of records from a view, and returns them
+// together with the contents of all their fields, so the client doesn't have to
+// ask for each field separately. Stream fields are marked as not having a string
+// value; the client reads those with the regular requests.
+//
+UINT RemoteMsiSession::ProcessViewFetchBatch(const RequestData* pReq, RequestData* pResp)
+{
+    MSIHANDLE hView = (MSIHANDLE) pReq->fields[0].iValue;
+    int cMaxRecords = pReq->fields[1].iValue;
+    int cRecords = 0;
+    DWORD cbUsed = 0;
+    UINT ret = 0;
+
+    // The first value is the result of the last fetch, filled in at the end.
+    if (!AppendBatchData(&ret, sizeof(UINT), &cbUsed))
+    {
+        return ERROR_OUTOFMEMORY;
+    }
+
+    while (cRecords < cMaxRecords)
+    {
+        MSIHANDLE hRecord;
+        ret = ::MsiViewFetch(hView, &hRecord);
+        if (ret != 0)
+        {
+            break;
+        }
+
+        UINT cFields = ::MsiRecordGetFieldCount(hRecord);
+        int rgiRecord[2] = { (int) hRecord, (int) cFields };
+        bool fAppended = AppendBatchData(rgiRecord, sizeof(rgiRecord), &cbUsed);
+
+        for (UINT iField = 0; fAppended && iField <= cFields; iField++)
+        {
+            int rgiField[3];
+            rgiField[0] = ::MsiRecordIsNull(hRecord, iField) ? BATCH_FIELD_NULL : 0;
+            rgiField[1] = ::MsiRecordGetInteger(hRecord, iField);
+            rgiField[2] = (int) ::MsiRecordDataSize(hRecord, iField);
+
+            m_pBufSend[0] = L'\0';
+            DWORD cchValue = m_cbBufSend;
+            UINT retString = ::MsiRecordGetString(hRecord, iField, m_pBufSend, &cchValue);
+            if (retString == ERROR_MORE_DATA)
+            {
+                retString = EnsureBufSize(&m_pBufSend, &m_cbBufSend, ++cchValue);
+                if (retString == 0)
+                {
+                    retString = ::MsiRecordGetString(hRecord, iField, m_pBufSend, &cchValue);
+                }
+            }
+
+            if (retString == 0)
+            {
+                rgiField[0] |= BATCH_FIELD_STRING;
+            }
+
+            fAppended = AppendBatchData(rgiField, sizeof(rgiField), &cbUsed) &&
+                (retString != 0 || AppendBatchString(m_pBufSend, cchValue, &cbUsed));
+        }
+
+        if (!fAppended)
+        {
+            ::MsiCloseHandle(hRecord);
+            return ERROR_OUTOFMEMORY;
+        }
+
+        cRecords++;
+    }
+
+    memcpy(m_pBufBatch, &ret, sizeof(UINT));
+
+    pResp->fields[1].vt = VT_STREAM;
+    pResp->fields[1].sValue = m_pBufBatch;
+    pResp->fields[2].vt = VT_I4;
+    pResp->fields[2].uiValue = cbUsed;
+    pResp->fields[3].vt = VT_I4;
+    pResp->fields[3].iValue = cRecords;
+
+    return cRecords > 0 ? 0 : ret;
+}
+
+//
+// Processes a sequence of requests and returns all of their responses at once.
+// Requests that return a stream, or that are batches themselves, aren't allowed.
+//
+UINT RemoteMsiSession::ProcessBatch(const RequestData* pReq, RequestData* pResp)
+{
+    int cRequests = pReq->fields[0].iValue;
+    const BYTE* pbData = pReq->fields[1].sValue;
+    DWORD cbData = (pReq->fields[1].vt == VT_STREAM ? pReq->fields[1].cbValue : 0);
+    DWORD dwOffset = 0;
+    DWORD cbUsed = 0;
+
+    for (int i = 0; i < cRequests; i++)
+    {
+        int id;
+        RequestData req;
+        RequestData resp;
+        if (!ReadBatchInt(pbData, cbData, &dwOffset, &id) ||
+            !ReadBatchFields(pbData, cbData, &dwOffset, &req))
+        {
+            return ERROR_INVALID_DATA;
+        }
+
+        switch ((RequestId) id)
+        {
+            case RemoteMsiSession::EndSession:
+            case RemoteMsiSession::MsiRecordReadStream:
+            case RemoteMsiSession::MsiViewFetchBatch:
+            case RemoteMsiSession::Batch:
+            {
+                SecureZeroMemory(&resp, sizeof(RequestData));
+                resp.fields[0].vt = VT_UI4;
+                resp.fields[0].uiValue = ERROR_INVALID_FUNCTION;
+            }
+            break;
+
+            default:
+            {
+                ProcessRequest((RequestId) id, &req, &resp);
+            }
+            break;
+        }
+
+        if (!AppendBatchFields(&resp, &cbUsed))
+        {
+            return ERROR_OUTOFMEMORY;
+        }
+    }
+
+    pResp->fields[1].vt = VT_STREAM;
+    pResp->fields[1].sValue = m_pBufBatch;
+    pResp->fields[2].vt = VT_I4;
+    pResp->fields[2].uiValue = cbUsed;
+    pResp->fields[3].vt = VT_I4;
+    pResp->fields[3].iValue = cRequests;
+
+    return 0;
+}
+
 void RemoteMsiSession::ProcessRequest(RequestId id, const RequestData* pReq, RequestData* pResp)
 {
     SecureZeroMemory(pResp, sizeof(RequestData));
@@ -615,6 +908,16 @@ void RemoteMsiSession::ProcessRequest(RequestId id, const RequestData* pReq, Req
                 ret = ::MsiVerifyDiskSpace(hInstall);
             }
             break;
+            case RemoteMsiSession::MsiViewFetchBatch:
+            {
+                ret = ProcessViewFetchBatch(pReq, pResp);
+            }
+            break;
+            case RemoteMsiSession::Batch:
+            {
+                ret = ProcessBatch(pReq, pResp);
+            }
+            break;
             
             default:
             {
@@ -65,6 +65,11 @@ public:
         MsiViewGetError,
         MsiViewGetColumnInfo,
         MsiViewModify,
+
+        // Batched requests. A host that doesn't know these answers ERROR_INVALID_FUNCTION,
+        // and the client falls back to one request per call.
+        MsiViewFetchBatch,
+        Batch,
     };
 
     static const int MAX_REQUEST_FIELDS = 4;
@@ -120,6 +125,8 @@ public:
           m_cbBufReceive(0),
           m_pBufSend(NULL),
           m_cbBufSend(0),
+          m_pBufBatch(NULL),
+          m_cbBufBatch(0),
           ExitCode(ERROR_INSTALL_FAILURE)
     {   
         SecureZeroMemory(&m_overlapped, sizeof(OVERLAPPED));
@@ -161,6 +168,12 @@ public:
             delete[] m_pBufSend;
             m_pBufSend = NULL;
         }
+        if (m_pBufBatch != NULL)
+        {
+            SecureZeroMemory(m_pBufBatch, m_cbBufBatch);
+            delete[] m_pBufBatch;
+            m_pBufBatch = NULL;
+        }
         m_fConnecting = false;
         m_fConnected = false;
     }
@@ -491,6 +504,16 @@ private:
     //
     void ProcessRequest(RequestId id, const RequestData* pReq, RequestData* pResp);
 
+    //
+    // Called only by the server process, for the batched requests.
+    // These are implemented in RemoteMsi.cpp.
+    //
+    UINT ProcessViewFetchBatch(const RequestData* pReq, RequestData* pResp);
+    UINT ProcessBatch(const RequestData* pReq, RequestData* pResp);
+    bool AppendBatchData(const void* pv, DWORD cb, __inout DWORD* pcbUsed);
+    bool AppendBatchString(__in_ecount(cch + 1) const wchar_t* sz, DWORD cch, __inout DWORD* pcbUsed);
+    bool AppendBatchFields(const RequestData* pData, __inout DWORD* pcbUsed);
+
     //
     // Called only by the client process.
     // Send request data over the pipe.
@@ -887,6 +910,12 @@ private:
     // Current size of the send request buffer.
     DWORD m_cbBufSend;
 
+    // Dynamically-resized buffer for packing the results of a batched request.
+    BYTE* m_pBufBatch;
+
+    // Current size of the batch result buffer.
+    DWORD m_cbBufBatch;
+
     // True if this is the server process, false if this is the client process.
     const bool m_fServer;
 
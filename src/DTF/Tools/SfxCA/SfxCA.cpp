@@ -49,10 +49,22 @@ void __stdcall InvokeManagedCustomActionOutOfProc(
         if (szCmdLine[i] != L'\0') szCmdLine[i++] = L'\0';
         szEntryPoint = szCmdLine + i;
 
+        for (; szCmdLine[i] && szCmdLine[i] != L' '; i++);
+        if (szCmdLine[i] != L'\0') szCmdLine[i++] = L'\0';
+
+        // The launching process has already extracted the package to a quoted working directory.
+        const wchar_t* szWorkingDir = NULL;
+        if (szCmdLine[i] == L'"')
+        {
+                szWorkingDir = szCmdLine + ++i;
+                for (; szCmdLine[i] && szCmdLine[i] != L'"'; i++);
+                szCmdLine[i] = L'\0';
+        }
+
         g_pRemote = new RemoteMsiSession(szSessionName, false);
         g_pRemote->Connect();
 
-        int ret = InvokeCustomAction(hSession, NULL, szEntryPoint);
+        int ret = InvokeCustomAction(hSession, szWorkingDir, szEntryPoint);
 
         RemoteMsiSession::RequestData requestData;
         SecureZeroMemory(&requestData, sizeof(RemoteMsiSession::RequestData));
@@ -64,9 +76,11 @@ void __stdcall InvokeManagedCustomActionOutOfProc(
 
 /// <summary>
 /// Re-launch this CA DLL as a separate process, and setup a comm channel
-/// for remote MSI API calls back to this process.
+/// for remote MSI API calls back to this process. The new process
+/// runs the CA from the given already-extracted working directory.
 /// </summary>
-int InvokeOutOfProcManagedCustomAction(MSIHANDLE hSession, const wchar_t* szEntryPoint)
+int InvokeOutOfProcManagedCustomAction(MSIHANDLE hSession,
+        const wchar_t* szWorkingDir, const wchar_t* szEntryPoint)
 {
         wchar_t szSessionName[100] = {0};
         swprintf_s(szSessionName, 100, L"SfxCA_%d", ::GetTickCount());
@@ -97,9 +111,9 @@ int InvokeOutOfProcManagedCustomAction(MSIHANDLE hSession, const wchar_t* szEntr
         wcscat_s(szRunDll32Path, MAX_PATH, rundll32);
 
         const wchar_t* entry = L"zzzzInvokeManagedCustomActionOutOfProc";
-        wchar_t szCommandLine[1024] = {0};
-        swprintf_s(szCommandLine, 1024, L"%s \"%s\",%s %s %d %s",
-                rundll32, szModule, entry, szSessionName, hSession, szEntryPoint);
+        wchar_t szCommandLine[2048] = {0};
+        swprintf_s(szCommandLine, 2048, L"%s \"%s\",%s %s %d %s \"%s\"",
+                rundll32, szModule, entry, szSessionName, hSession, szEntryPoint, szWorkingDir);
 
         STARTUPINFO si;
         SecureZeroMemory(&si, sizeof(STARTUPINFO));
@@ -172,7 +186,8 @@ void __stdcall MsiRemoteInvoke(RemoteMsiSession::RequestId id, RemoteMsiSession:
 /// and the CustomAction.config file defining the entrypoints.
 /// This may be NULL, in which case the current module must have
 /// a concatenated cabinet containing those files, which will be
-/// extracted to a temporary directory.</param>
+/// extracted to a cache directory that is reused by later invocations
+/// of the same package from this process.</param>
 /// <param name="szEntryPoint">Name of the CA entrypoint to be invoked.
 /// This must be either an explicit &quot;AssemblyName!Namespace.Class.Method&quot;
 /// string, or a simple name that maps to a full entrypoint definition
@@ -182,23 +197,41 @@ void __stdcall MsiRemoteInvoke(RemoteMsiSession::RequestId id, RemoteMsiSession:
 int InvokeCustomAction(MSIHANDLE hSession,
         const wchar_t* szWorkingDir, const wchar_t* szEntryPoint)
 {
+        wchar_t szTempDir[MAX_PATH];
+        bool fDeleteTemp = false;
 #ifdef MANAGED_CAs_OUT_OF_PROC
         if (!g_fRunningOutOfProc && szWorkingDir == NULL)
         {
-                return InvokeOutOfProcManagedCustomAction(hSession, szEntryPoint);
+                if (!ExtractToCacheDirectory(hSession, g_hModule, szTempDir, MAX_PATH, &fDeleteTemp))
+                {
+                        return ERROR_INSTALL_FAILURE;
+                }
+
+                int iOutOfProcResult = InvokeOutOfProcManagedCustomAction(hSession, szTempDir, szEntryPoint);
+                if (fDeleteTemp)
+                {
+                        DeleteDirectory(szTempDir);
+                }
+                DeleteExitedCacheDirectories(g_hModule);
+                return iOutOfProcResult;
         }
 #endif
 
-        wchar_t szTempDir[MAX_PATH];
-        bool fDeleteTemp = false;
         if (szWorkingDir == NULL)
         {
-                if (!ExtractToTempDirectory(hSession, g_hModule, szTempDir, MAX_PATH))
+                if (g_fRunningOutOfProc)
+                {
+                        if (!ExtractToTempDirectory(hSession, g_hModule, szTempDir, MAX_PATH))
+                        {
+                                return ERROR_INSTALL_FAILURE;
+                        }
+                        fDeleteTemp = true;
+                }
+                else if (!ExtractToCacheDirectory(hSession, g_hModule, szTempDir, MAX_PATH, &fDeleteTemp))
                 {
                         return ERROR_INSTALL_FAILURE;
                 }
                 szWorkingDir = szTempDir;
-                fDeleteTemp = true;
         }
 
         wchar_t szConfigFilePath[MAX_PATH + 20];
@@ -243,6 +276,10 @@ int InvokeCustomAction(MSIHANDLE hSession,
         {
                 DeleteDirectory(szTempDir);
         }
+        if (!g_fRunningOutOfProc && szWorkingDir == szTempDir)
+        {
+                DeleteExitedCacheDirectories(g_hModule);
+        }
         return iResult;
 }
 
@@ -207,3 +207,206 @@ bool ExtractToTempDirectory(__in MSIHANDLE hSession, __in HMODULE hModule,
         return true;
 }
 
+
+/// <summary>
+/// Computes a 64-bit FNV-1a hash of the contents of a file.
+/// </summary>
+static bool HashFile(const wchar_t* szFile, ULONGLONG* pullHash)
+{
+        HANDLE hFile = CreateFile(szFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+                return false;
+        }
+
+        ULONGLONG ullHash = 14695981039346656037ULL;
+        BYTE rgbBuf[16 * 1024];
+        DWORD cbRead = 0;
+        bool fSuccess;
+        while ((fSuccess = ReadFile(hFile, rgbBuf, sizeof(rgbBuf), &cbRead, NULL) != 0) && cbRead > 0)
+        {
+                for (DWORD i = 0; i < cbRead; i++)
+                {
+                        ullHash ^= rgbBuf[i];
+                        ullHash *= 1099511628211ULL;
+                }
+        }
+        CloseHandle(hFile);
+
+        *pullHash = ullHash;
+        return fSuccess;
+}
+
+/// <summary>
+/// Checks whether the process that created a cache directory is still running.
+/// </summary>
+/// <remarks>
+/// The creation time guards against the process ID having been reused. A process
+/// that can't be opened for any reason other than not existing is assumed to be running.
+/// </remarks>
+static bool IsCacheOwnerRunning(DWORD dwProcessId, const FILETIME* pftCreated)
+{
+        HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | SYNCHRONIZE, FALSE, dwProcessId);
+        if (hProcess == NULL)
+        {
+                return GetLastError() != ERROR_INVALID_PARAMETER;
+        }
+
+        bool fRunning = true;
+        FILETIME ftCreated, ftExited, ftKernel, ftUser;
+        if (GetProcessTimes(hProcess, &ftCreated, &ftExited, &ftKernel, &ftUser))
+        {
+                fRunning = CompareFileTime(&ftCreated, pftCreated) == 0 &&
+                        WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT;
+        }
+        CloseHandle(hProcess);
+        return fRunning;
+}
+
+/// <summary>
+/// Deletes cache directories left behind by processes that have exited.
+/// </summary>
+/// <param name="szDir">Directory containing the cache directories,
+/// not including a trailing backslash.</param>
+static void DeleteStaleCacheDirectories(const wchar_t* szDir)
+{
+        wchar_t szPath[MAX_PATH];
+        if (FAILED(StringCchPrintf(szPath, MAX_PATH, L"%s\\SfxCA_*", szDir)))
+        {
+                return;
+        }
+
+        WIN32_FIND_DATA fd;
+        HANDLE hSearch = FindFirstFile(szPath, &fd);
+        while (hSearch != INVALID_HANDLE_VALUE)
+        {
+                ULONGLONG ullHash;
+                DWORD dwProcessId;
+                FILETIME ftCreated;
+                if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 &&
+                        swscanf_s(fd.cFileName, L"SfxCA_%16I64X_%lu_%8lX%8lX", &ullHash, &dwProcessId,
+                                &ftCreated.dwHighDateTime, &ftCreated.dwLowDateTime) == 4 &&
+                        !IsCacheOwnerRunning(dwProcessId, &ftCreated) &&
+                        SUCCEEDED(StringCchPrintf(szPath, MAX_PATH, L"%s\\%s", szDir, fd.cFileName)))
+                {
+                        // Files still locked are left for the next sweep.
+                        DeleteDirectory(szPath);
+                }
+
+                if (!FindNextFile(hSearch, &fd))
+                {
+                        FindClose(hSearch);
+                        hSearch = INVALID_HANDLE_VALUE;
+                }
+        }
+}
+
+/// <summary>
+/// Extracts a cabinet that is concatenated to a module to a cache
+/// directory that is shared by every invocation from the current
+/// process, or returns the existing cache directory if the same
+/// module contents were already extracted.
+/// </summary>
+/// <param name="hSession">Handle to the installer session,
+/// used just for logging.</param>
+/// <param name="hModule">Module that has the concatenated cabinet.</param>
+/// <param name="szCacheDir">Buffer for returning the path of the
+/// cache directory.</param>
+/// <param name="cchCacheDirBuf">Size in characters of the buffer.</param>
+/// <param name="pfDelete">Set to true if the files could only be extracted
+/// to a private temp directory, which the caller must delete when done.</param>
+/// <returns>True if the files were extracted or already cached, or false
+/// if the extraction failed.</returns>
+/// <remarks>
+/// The installer copies the module to a new temp file for every custom
+/// action, so the cache is keyed by a hash of the module contents. The
+/// directory name also records the owning process and its creation time;
+/// caches of processes that have exited are deleted before extracting
+/// and after each custom action (see <see cref="DeleteExitedCacheDirectories"/>).
+/// Files are extracted to a temp directory and then renamed into place,
+/// so a cache directory that exists is always complete.
+/// On disk this costs one extracted copy of each distinct package per live
+/// CA server process, next to the module in the installer's temp directory.
+/// </remarks>
+__success(return != false)
+bool ExtractToCacheDirectory(__in MSIHANDLE hSession, __in HMODULE hModule,
+        __out_ecount_z(cchCacheDirBuf) wchar_t* szCacheDir, DWORD cchCacheDirBuf, __out bool* pfDelete)
+{
+        *pfDelete = false;
+
+        wchar_t szModuleDir[MAX_PATH];
+        DWORD cchCopied = GetModuleFileName(hModule, szModuleDir, MAX_PATH - 1);
+        ULONGLONG ullHash;
+        FILETIME ftCreated, ftExited, ftKernel, ftUser;
+        wchar_t* szModuleName = wcsrchr(szModuleDir, L'\\');
+        if (cchCopied == 0 || cchCopied == MAX_PATH - 1 || szModuleName == NULL ||
+                !HashFile(szModuleDir, &ullHash) ||
+                !GetProcessTimes(GetCurrentProcess(), &ftCreated, &ftExited, &ftKernel, &ftUser))
+        {
+                *pfDelete = true;
+                return ExtractToTempDirectory(hSession, hModule, szCacheDir, cchCacheDirBuf);
+        }
+        *szModuleName = L'\0';
+
+        if (szCacheDir == NULL || FAILED(StringCchPrintf(szCacheDir, cchCacheDirBuf,
+                L"%s\\SfxCA_%016I64X_%lu_%08lX%08lX", szModuleDir, ullHash, GetCurrentProcessId(),
+                ftCreated.dwHighDateTime, ftCreated.dwLowDateTime)))
+        {
+                Log(hSession, L"Cache directory buffer is NULL or too small.");
+                return false;
+        }
+
+        if (!DirectoryExists(szCacheDir))
+        {
+                DeleteStaleCacheDirectories(szModuleDir);
+
+                wchar_t szTempDir[MAX_PATH];
+                if (!ExtractToTempDirectory(hSession, hModule, szTempDir, MAX_PATH))
+                {
+                        return false;
+                }
+
+                if (MoveFile(szTempDir, szCacheDir))
+                {
+                        return true;
+                }
+                else if (!DirectoryExists(szCacheDir))
+                {
+                        // The temp directory may be on another volume; use it for this invocation only.
+                        StringCchCopy(szCacheDir, cchCacheDirBuf, szTempDir);
+                        *pfDelete = true;
+                        return true;
+                }
+
+                // Another thread published the same contents first.
+                DeleteDirectory(szTempDir);
+        }
+
+        Log(hSession, L"Using cached custom action directory: %s\\", szCacheDir);
+        return true;
+}
+
+/// <summary>
+/// Deletes the cache directories next to a module whose owning process has exited.
+/// </summary>
+/// <param name="hModule">Module whose directory holds the cache directories.</param>
+/// <remarks>
+/// Called after a custom action returns, so the cache of a CA server that
+/// exited since the last extraction is removed during the install rather
+/// than only when another package is extracted. The current process's own
+/// cache is kept for its later invocations.
+/// </remarks>
+void DeleteExitedCacheDirectories(__in HMODULE hModule)
+{
+        wchar_t szModuleDir[MAX_PATH];
+        DWORD cchCopied = GetModuleFileName(hModule, szModuleDir, MAX_PATH - 1);
+        wchar_t* szModuleName = wcsrchr(szModuleDir, L'\\');
+        if (cchCopied == 0 || cchCopied == MAX_PATH - 1 || szModuleName == NULL)
+        {
+                return;
+        }
+        *szModuleName = L'\0';
+
+        DeleteStaleCacheDirectories(szModuleDir);
+}
@@ -12,6 +12,12 @@ __success(return != false)
 bool ExtractToTempDirectory(__in MSIHANDLE hSession, __in HMODULE hModule,
 	__out_ecount_z(cchTempDirBuf) wchar_t* szTempDir, DWORD cchTempDirBuf);
 
+__success(return != false)
+bool ExtractToCacheDirectory(__in MSIHANDLE hSession, __in HMODULE hModule,
+	__out_ecount_z(cchCacheDirBuf) wchar_t* szCacheDir, DWORD cchCacheDirBuf, __out bool* pfDelete);
+
+void DeleteExitedCacheDirectories(__in HMODULE hModule);
+
 bool LoadCLR(MSIHANDLE hSession, const wchar_t* szVersion, const wchar_t* szConfigFile,
 	const wchar_t* szPrimaryAssembly, ICorRuntimeHost** ppHost);
 
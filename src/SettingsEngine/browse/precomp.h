@@ -13,6 +13,7 @@
 #include "dutil.h"
 #include "pathutil.h"
 #include "memutil.h"
+#include "dictutil.h"
 #include "fileutil.h"
 #include "strutil.h"
 #include "timeutil.h"
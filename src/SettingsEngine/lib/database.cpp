@@ -98,7 +98,7 @@ HRESULT DatabaseSetupSchema(
 
     pdsSchema->rgTables[VALUE_INDEX_TABLE].wzName = L"ValueIndex";
     pdsSchema->rgTables[VALUE_INDEX_TABLE].cColumns = VALUE_INDEX_COLUMNS;
-    pdsSchema->rgTables[VALUE_INDEX_TABLE].cIndexes = 1;
+    pdsSchema->rgTables[VALUE_INDEX_TABLE].cIndexes = 2;
 
     pdsSchema->rgTables[VALUE_INDEX_HISTORY_TABLE].wzName = L"ValueIndexHistory";
     pdsSchema->rgTables[VALUE_INDEX_HISTORY_TABLE].cColumns = VALUE_INDEX_HISTORY_COLUMNS;
@@ -112,6 +112,10 @@ HRESULT DatabaseSetupSchema(
     pdsSchema->rgTables[DATABASE_GUID_LIST_TABLE].cColumns = DATABASE_GUID_LIST_COLUMNS;
     pdsSchema->rgTables[DATABASE_GUID_LIST_TABLE].cIndexes = 2;
 
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].wzName = L"SyncWatermark";
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].cColumns = SYNC_WATERMARK_COLUMNS;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].cIndexes = 2;
+
     if (DATABASE_TYPE_LOCAL == dbType)
     {
         pdsSchema->rgTables[DATABASE_INDEX_TABLE].wzName = L"DatabaseList";
@@ -227,9 +231,13 @@ HRESULT DatabaseSetupSchema(
     pdsSchema->rgTables[VALUE_INDEX_TABLE].rgColumns[VALUE_LAST_HISTORY_ID].wzRelationName = L"LastHistoryID";
     pdsSchema->rgTables[VALUE_INDEX_TABLE].rgColumns[VALUE_LAST_HISTORY_ID].dwForeignKeyTable = VALUE_INDEX_HISTORY_TABLE;
     pdsSchema->rgTables[VALUE_INDEX_TABLE].rgColumns[VALUE_LAST_HISTORY_ID].dwForeignKeyColumn = VALUE_COMMON_ID;
+    // History IDs only ever increase, so the newest changes for an AppID come first in this index
+    pdsSchema->rgTables[VALUE_INDEX_TABLE].rgColumns[VALUE_LAST_HISTORY_ID].fDescending = TRUE;
 
     static DWORD rgdwUserValueIndex1[] = { VALUE_COMMON_APPID, VALUE_COMMON_NAME };
+    static DWORD rgdwUserValueIndex2[] = { VALUE_COMMON_APPID, VALUE_LAST_HISTORY_ID };
     ASSIGN_INDEX_STRUCT(pdsSchema->rgTables[VALUE_INDEX_TABLE].rgIndexes[0], rgdwUserValueIndex1, L"AppID_Name");
+    ASSIGN_INDEX_STRUCT(pdsSchema->rgTables[VALUE_INDEX_TABLE].rgIndexes[1], rgdwUserValueIndex2, L"AppID_LastHistoryID");
 
     pdsSchema->rgTables[VALUE_INDEX_HISTORY_TABLE].rgColumns[VALUE_COMMON_ID].wzName = L"ID";
     pdsSchema->rgTables[VALUE_INDEX_HISTORY_TABLE].rgColumns[VALUE_COMMON_ID].dbtColumnType = DBTYPE_I4;
@@ -315,6 +323,24 @@ HRESULT DatabaseSetupSchema(
     ASSIGN_INDEX_STRUCT(pdsSchema->rgTables[DATABASE_GUID_LIST_TABLE].rgIndexes[0], rgdwDatabaseGuidIndex1, L"PrimaryKey");
     ASSIGN_INDEX_STRUCT(pdsSchema->rgTables[DATABASE_GUID_LIST_TABLE].rgIndexes[1], rgdwDatabaseGuidIndex2, L"Guid");
 
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_ID].wzName = L"ID";
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_ID].dbtColumnType = DBTYPE_I4;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_ID].fPrimaryKey = TRUE;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_ID].fAutoIncrement = TRUE;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_PEER_GUID].wzName = L"PeerGuid";
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_PEER_GUID].dbtColumnType = DBTYPE_WSTR;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_APPID].wzName = L"AppID";
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_APPID].dbtColumnType = DBTYPE_I4;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_SEQUENCE].wzName = L"Sequence";
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_SEQUENCE].dbtColumnType = DBTYPE_I4;
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_PEER_SEQUENCE].wzName = L"PeerSequence";
+    pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgColumns[SYNC_WATERMARK_PEER_SEQUENCE].dbtColumnType = DBTYPE_I4;
+
+    static DWORD rgdwSyncWatermarkIndex1[] = { SYNC_WATERMARK_ID };
+    static DWORD rgdwSyncWatermarkIndex2[] = { SYNC_WATERMARK_PEER_GUID, SYNC_WATERMARK_APPID };
+    ASSIGN_INDEX_STRUCT(pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgIndexes[0], rgdwSyncWatermarkIndex1, L"PrimaryKey");
+    ASSIGN_INDEX_STRUCT(pdsSchema->rgTables[SYNC_WATERMARK_TABLE].rgIndexes[1], rgdwSyncWatermarkIndex2, L"PeerGuid_AppID");
+
     if (DATABASE_TYPE_LOCAL == dbType)
     {
         pdsSchema->rgTables[DATABASE_INDEX_TABLE].rgColumns[DATABASE_INDEX_ID].wzName = L"ID";
@@ -32,13 +32,14 @@ enum USERTABLES
     VALUE_INDEX_HISTORY_TABLE = 4, // Stores user data history
     BINARY_CONTENT_TABLE = 5, // Stores user blobs
     DATABASE_GUID_LIST_TABLE = 6, // Associates each database GUID with a unique ID
+    SYNC_WATERMARK_TABLE = 7, // Remembers, per other database and product, the last value change that was fully synced
 
     // User-specific tables
-    DATABASE_INDEX_TABLE = 7, // Remembers databases you may want to connect to
-    USER_TABLES_NUMBER = 8, // not an actual table, just represents the number of tables
+    DATABASE_INDEX_TABLE = 8, // Remembers databases you may want to connect to
+    USER_TABLES_NUMBER = 9, // not an actual table, just represents the number of tables
 
     // Remote-specific tables
-    REMOTE_TABLES_NUMBER = 7 // not an actual table, just represents the number of tables
+    REMOTE_TABLES_NUMBER = 8 // not an actual table, just represents the number of tables
 };
 
 // User column enums
@@ -136,6 +137,16 @@ enum DATABASE_GUID_LIST_COLUMN
     DATABASE_GUID_LIST_COLUMNS = 2,
 };
 
+enum SYNC_WATERMARK_COLUMN
+{
+    SYNC_WATERMARK_ID = 0,
+    SYNC_WATERMARK_PEER_GUID = 1,
+    SYNC_WATERMARK_APPID = 2,
+    SYNC_WATERMARK_SEQUENCE = 3, // Highest LastHistoryID of this database's values for the AppID that the peer has seen
+    SYNC_WATERMARK_PEER_SEQUENCE = 4, // Peer's own watermark at the time, used to detect a peer that was replaced or restored
+    SYNC_WATERMARK_COLUMNS = 5
+};
+
 enum ADMINTABLES
 {
     ADMIN_PRODUCT_INDEX_TABLE = 0, // Associates a particular product name, version and public key with an ID number. This number is guaranteed unique within one DB, but isn't necessarily the same in another DB.
@@ -65,3 +65,4 @@
 #include "rgspcial.h"
 #include "backgrnd.h"
 #include "guidlist.h"
+#include "watermark.h"
@@ -23,11 +23,17 @@ HRESULT ProductFindRow(
     __in_z_opt LPCWSTR wzPublicKey,
     __out SCE_ROW_HANDLE *pSceRow
     );
+// Syncs values of the current product from pcdb1 into pcdb2. If fIncremental is set, only values whose LastHistoryID
+// is past dwWatermark are considered, otherwise all values are. pdwSequence receives the highest LastHistoryID
+// of the product in pcdb1 as of the start of the sync, suitable for use as the next watermark.
 HRESULT ProductSyncValues(
     __in CFGDB_STRUCT *pcdb1,
     __in CFGDB_STRUCT *pcdb2,
     __in BOOL fAllowLocalToReceiveData,
+    __in BOOL fIncremental,
+    __in DWORD dwWatermark,
     __in STRINGDICT_HANDLE shDictValuesSeen,
+    __out DWORD *pdwSequence,
     __out CONFLICT_PRODUCT **ppcpProduct
     );
 HRESULT ProductEnsureCreated(
@@ -74,3 +74,22 @@ extern "C" HRESULT TestHookOverrideGetSystemTime(
 
     return S_OK;
 }
+
+extern "C" HRESULT TestHookCollectSyncStatistics(
+    __in_z_opt LPCWSTR wzProductName
+    )
+{
+    memset(&SyncStatistics, 0, sizeof(SyncStatistics));
+    wzSyncStatisticsProductName = wzProductName;
+
+    return S_OK;
+}
+
+extern "C" HRESULT TestHookGetSyncStatistics(
+    __out SYNC_STATISTICS *pStatistics
+    )
+{
+    *pStatistics = SyncStatistics;
+
+    return S_OK;
+}
@@ -10,6 +10,13 @@ typedef void (WINAPI *PFN_GETSYSTEMTIME)(
     __out SYSTEMTIME *pst
     );
 
+struct SYNC_STATISTICS
+{
+    DWORD cFullSyncs; // Syncs of the product that compared every value
+    DWORD cIncrementalSyncs; // Syncs of the product that only compared values changed past the watermarks
+    DWORD cValuesCompared; // Values of the product compared between the two databases, in either direction
+};
+
 HRESULT __stdcall TestHookOverrideUserDatabasePath(
     __in_z LPCWSTR wzNewUserDatabasePath
     );
@@ -25,6 +32,13 @@ HRESULT __stdcall TestHookOverrideApplicationsPath(
 HRESULT __stdcall TestHookOverrideGetSystemTime(
     __in PFN_GETSYSTEMTIME systemTimeGetter
     );
+// Resets the sync statistics and starts collecting them for the named product, or stops collecting if wzProductName is NULL
+HRESULT __stdcall TestHookCollectSyncStatistics(
+    __in_z_opt LPCWSTR wzProductName
+    );
+HRESULT __stdcall TestHookGetSyncStatistics(
+    __out SYNC_STATISTICS *pStatistics
+    );
 
 #ifdef __cplusplus
 }
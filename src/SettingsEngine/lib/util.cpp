@@ -3,6 +3,8 @@
 #include "precomp.h"
 
 PFN_GETSYSTEMTIME SystemTimeGetter = GetSystemTime;
+LPCWSTR wzSyncStatisticsProductName = NULL;
+SYNC_STATISTICS SyncStatistics = { };
 
 const LEGACY_DIRECTORY_MAP LEGACY_DIRECTORIES[] = {
     { CSIDL_MYDOCUMENTS, L"MyDocumentsFolder:\\", NULL },
@@ -457,16 +459,62 @@ static HRESULT SyncSingleProduct(
 {
     HRESULT hr = S_OK;
     STRINGDICT_HANDLE shDictItemsSeen = NULL;
+    BOOL fIncremental = FALSE;
+    DWORD dwWatermark1 = 0;
+    DWORD dwPeerWatermark1 = 0;
+    DWORD dwWatermark2 = 0;
+    DWORD dwPeerWatermark2 = 0;
+    DWORD dwSequence1 = 0;
+    DWORD dwSequence2 = 0;
+    SYNC_STATISTICS *pStatistics = NULL;
 
     hr = DictCreateStringList(&shDictItemsSeen, 0, DICT_FLAG_CASEINSENSITIVE);
     ExitOnFailure(hr, "Failed to create dictionary of values seen");
 
-    hr = ProductSyncValues(pcdb1, pcdb2, fRegistered, shDictItemsSeen, ppcpProductTemp);
+    // Only trust the watermarks if both databases agree on them - if either side is missing its watermark, or
+    // the other database was replaced or restored from an older copy since, fall back to comparing every value
+    hr = WatermarkRead(pcdb1, pcdb2, &dwWatermark1, &dwPeerWatermark1);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to read sync watermark (1)");
+
+        hr = WatermarkRead(pcdb2, pcdb1, &dwWatermark2, &dwPeerWatermark2);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to read sync watermark (2)");
+
+            fIncremental = (dwPeerWatermark1 == dwWatermark2 && dwPeerWatermark2 == dwWatermark1);
+        }
+    }
+    hr = S_OK;
+
+    pStatistics = UtilSyncStatistics(pcdb1);
+    if (NULL != pStatistics && fIncremental)
+    {
+        ++pStatistics->cIncrementalSyncs;
+    }
+    else if (NULL != pStatistics)
+    {
+        ++pStatistics->cFullSyncs;
+    }
+
+    hr = ProductSyncValues(pcdb1, pcdb2, fRegistered, fIncremental, dwWatermark1, shDictItemsSeen, &dwSequence1, ppcpProductTemp);
     ExitOnFailure(hr, "Failed to sync product values for application (1)");
 
-    hr = ProductSyncValues(pcdb2, pcdb1, fRegistered, shDictItemsSeen, ppcpProductTemp);
+    hr = ProductSyncValues(pcdb2, pcdb1, fRegistered, fIncremental, dwWatermark2, shDictItemsSeen, &dwSequence2, ppcpProductTemp);
     ExitOnFailure(hr, "Failed to sync product values for application (2)");
 
+    // Unresolved conflicts must be found again next time, and an unregistered product's values don't all flow
+    // both ways, so only move the watermarks forward after a complete, conflict-free sync
+    if (fRegistered && NULL == *ppcpProductTemp)
+    {
+        hr = WatermarkWrite(pcdb1, pcdb2, dwSequence1, dwSequence2);
+        ExitOnFailure(hr, "Failed to write sync watermark (1)");
+
+        hr = WatermarkWrite(pcdb2, pcdb1, dwSequence2, dwSequence1);
+        ExitOnFailure(hr, "Failed to write sync watermark (2)");
+    }
+
 LExit:
     ReleaseDict(shDictItemsSeen);
 
@@ -692,3 +740,15 @@ BOOL UtilIs64BitSystem()
 
     return s_f64BitSystem;
 }
+
+SYNC_STATISTICS *UtilSyncStatistics(
+    __in const CFGDB_STRUCT *pcdb
+    )
+{
+    if (NULL == wzSyncStatisticsProductName || NULL == pcdb->sczProductName || CSTR_EQUAL != ::CompareStringW(LOCALE_INVARIANT, 0, pcdb->sczProductName, -1, wzSyncStatisticsProductName, -1))
+    {
+        return NULL;
+    }
+
+    return &SyncStatistics;
+}
@@ -7,6 +7,8 @@ extern "C" {
 #endif
 
 extern PFN_GETSYSTEMTIME SystemTimeGetter;
+extern LPCWSTR wzSyncStatisticsProductName;
+extern SYNC_STATISTICS SyncStatistics;
 
 struct LEGACY_DIRECTORY_MAP
 {
@@ -56,6 +58,10 @@ void UtilGetSystemTime(
     __inout SYSTEMTIME *pst
     );
 BOOL UtilIs64BitSystem();
+// Returns the statistics to count sync work for the product currently set in pcdb, or NULL if they aren't being collected for it
+SYNC_STATISTICS *UtilSyncStatistics(
+    __in const CFGDB_STRUCT *pcdb
+    );
 
 #ifdef __cplusplus
 }
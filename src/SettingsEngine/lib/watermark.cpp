@@ -0,0 +1,122 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+static HRESULT FindWatermarkRow(
+    __in CFGDB_STRUCT *pcdb,
+    __in CFGDB_STRUCT *pcdbPeer,
+    __out SCE_ROW_HANDLE *pSceRow
+    );
+
+HRESULT WatermarkRead(
+    __in CFGDB_STRUCT *pcdb,
+    __in CFGDB_STRUCT *pcdbPeer,
+    __out DWORD *pdwSequence,
+    __out DWORD *pdwPeerSequence
+    )
+{
+    HRESULT hr = S_OK;
+    SCE_ROW_HANDLE sceRow = NULL;
+
+    hr = FindWatermarkRow(pcdb, pcdbPeer, &sceRow);
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to find sync watermark for AppID %u with database %ls", pcdb->dwAppID, pcdbPeer->sczGuid);
+
+    hr = SceGetColumnDword(sceRow, SYNC_WATERMARK_SEQUENCE, pdwSequence);
+    ExitOnFailure(hr, "Failed to get sequence column from sync watermark row");
+
+    hr = SceGetColumnDword(sceRow, SYNC_WATERMARK_PEER_SEQUENCE, pdwPeerSequence);
+    ExitOnFailure(hr, "Failed to get peer sequence column from sync watermark row");
+
+LExit:
+    ReleaseSceRow(sceRow);
+
+    return hr;
+}
+
+HRESULT WatermarkWrite(
+    __in CFGDB_STRUCT *pcdb,
+    __in CFGDB_STRUCT *pcdbPeer,
+    __in DWORD dwSequence,
+    __in DWORD dwPeerSequence
+    )
+{
+    HRESULT hr = S_OK;
+    BOOL fInSceTransaction = FALSE;
+    SCE_ROW_HANDLE sceRow = NULL;
+
+    hr = SceBeginTransaction(pcdb->psceDb);
+    ExitOnFailure(hr, "Failed to begin transaction");
+    fInSceTransaction = TRUE;
+
+    hr = FindWatermarkRow(pcdb, pcdbPeer, &sceRow);
+    if (E_NOTFOUND == hr)
+    {
+        hr = ScePrepareInsert(pcdb->psceDb, SYNC_WATERMARK_TABLE, &sceRow);
+        ExitOnFailure(hr, "Failed to prepare for insert into sync watermark table");
+
+        hr = SceSetColumnString(sceRow, SYNC_WATERMARK_PEER_GUID, pcdbPeer->sczGuid);
+        ExitOnFailure(hr, "Failed to set peer guid column to: %ls", pcdbPeer->sczGuid);
+
+        hr = SceSetColumnDword(sceRow, SYNC_WATERMARK_APPID, pcdb->dwAppID);
+        ExitOnFailure(hr, "Failed to set AppID column to: %u", pcdb->dwAppID);
+    }
+    ExitOnFailure(hr, "Failed to find sync watermark for AppID %u with database %ls", pcdb->dwAppID, pcdbPeer->sczGuid);
+
+    hr = SceSetColumnDword(sceRow, SYNC_WATERMARK_SEQUENCE, dwSequence);
+    ExitOnFailure(hr, "Failed to set sequence column to: %u", dwSequence);
+
+    hr = SceSetColumnDword(sceRow, SYNC_WATERMARK_PEER_SEQUENCE, dwPeerSequence);
+    ExitOnFailure(hr, "Failed to set peer sequence column to: %u", dwPeerSequence);
+
+    hr = SceFinishUpdate(sceRow);
+    ExitOnFailure(hr, "Failed to finish update into sync watermark table");
+
+    hr = SceCommitTransaction(pcdb->psceDb);
+    ExitOnFailure(hr, "Failed to commit transaction");
+    fInSceTransaction = FALSE;
+
+LExit:
+    ReleaseSceRow(sceRow);
+    if (fInSceTransaction)
+    {
+        SceRollbackTransaction(pcdb->psceDb);
+    }
+
+    return hr;
+}
+
+static HRESULT FindWatermarkRow(
+    __in CFGDB_STRUCT *pcdb,
+    __in CFGDB_STRUCT *pcdbPeer,
+    __out SCE_ROW_HANDLE *pSceRow
+    )
+{
+    HRESULT hr = S_OK;
+    SCE_QUERY_HANDLE sqhHandle = NULL;
+
+    hr = SceBeginQuery(pcdb->psceDb, SYNC_WATERMARK_TABLE, 1, &sqhHandle);
+    ExitOnFailure(hr, "Failed to begin query into sync watermark table");
+
+    hr = SceSetQueryColumnString(sqhHandle, pcdbPeer->sczGuid);
+    ExitOnFailure(hr, "Failed to set query column string to: %ls", pcdbPeer->sczGuid);
+
+    hr = SceSetQueryColumnDword(sqhHandle, pcdb->dwAppID);
+    ExitOnFailure(hr, "Failed to set query column dword to: %u", pcdb->dwAppID);
+
+    hr = SceRunQueryExact(&sqhHandle, pSceRow);
+    if (E_NOTFOUND == hr)
+    {
+        // Don't pollute our log with unnecessary messages
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to query for sync watermark");
+
+LExit:
+    ReleaseSceQuery(sqhHandle);
+
+    return hr;
+}
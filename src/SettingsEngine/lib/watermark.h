@@ -0,0 +1,26 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reads the watermark recorded in pcdb for the currently set product, as last synced with pcdbPeer
+// Returns E_NOTFOUND if the product has never been fully synced with that database
+HRESULT WatermarkRead(
+    __in CFGDB_STRUCT *pcdb,
+    __in CFGDB_STRUCT *pcdbPeer,
+    __out DWORD *pdwSequence,
+    __out DWORD *pdwPeerSequence
+    );
+HRESULT WatermarkWrite(
+    __in CFGDB_STRUCT *pcdb,
+    __in CFGDB_STRUCT *pcdbPeer,
+    __in DWORD dwSequence,
+    __in DWORD dwPeerSequence
+    );
+
+#ifdef __cplusplus
+}
+#endif
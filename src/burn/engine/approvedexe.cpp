@@ -5,76 +5,47 @@
 
 // function definitions
 
-extern "C" HRESULT ApprovedExesParseFromXml(
+extern "C" HRESULT ApprovedExeParseFromXml(
     __in BURN_APPROVED_EXES* pApprovedExes,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
     LPWSTR scz = NULL;
+    BURN_APPROVED_EXE* pApprovedExe = NULL;
 
-    // select approved exe nodes
-    hr = XmlSelectNodes(pixnBundle, L"ApprovedExeForElevation", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select approved exe nodes.");
-
-    // get approved exe node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get approved exe node count.");
+    // allocate memory for the approved exe
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pApprovedExes->rgApprovedExes), pApprovedExes->cApprovedExes + 1, sizeof(BURN_APPROVED_EXE), pApprovedExes->cApprovedExes);
+    ExitOnFailure(hr, "Failed to allocate memory for approved exe structs.");
 
-    if (!cNodes)
-    {
-        ExitFunction();
-    }
+    pApprovedExe = &pApprovedExes->rgApprovedExes[pApprovedExes->cApprovedExes];
+    ++pApprovedExes->cApprovedExes;
 
-    // allocate memory for approved exes
-    pApprovedExes->rgApprovedExes = (BURN_APPROVED_EXE*)MemAlloc(sizeof(BURN_APPROVED_EXE) * cNodes, TRUE);
-    ExitOnNull(pApprovedExes->rgApprovedExes, hr, E_OUTOFMEMORY, "Failed to allocate memory for approved exe structs.");
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pApprovedExe->sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-    pApprovedExes->cApprovedExes = cNodes;
+    // @Key
+    hr = XmlReaderGetAttribute(pReader, L"Key", &pApprovedExe->sczKey);
+    ExitOnFailure(hr, "Failed to get @Key.");
 
-    // parse approved exe elements
-    for (DWORD i = 0; i < cNodes; ++i)
+    // @ValueName
+    hr = XmlReaderGetAttribute(pReader, L"ValueName", &pApprovedExe->sczValueName);
+    if (E_NOTFOUND != hr)
     {
-        BURN_APPROVED_EXE* pApprovedExe = &pApprovedExes->rgApprovedExes[i];
-
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
-
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &pApprovedExe->sczId);
-        ExitOnFailure(hr, "Failed to get @Id.");
-
-        // @Key
-        hr = XmlGetAttributeEx(pixnNode, L"Key", &pApprovedExe->sczKey);
-        ExitOnFailure(hr, "Failed to get @Key.");
-
-        // @ValueName
-        hr = XmlGetAttributeEx(pixnNode, L"ValueName", &pApprovedExe->sczValueName);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @ValueName.");
-        }
-
-        // @Win64
-        hr = XmlGetYesNoAttribute(pixnNode, L"Win64", &pApprovedExe->fWin64);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @Win64.");
-        }
+        ExitOnFailure(hr, "Failed to get @ValueName.");
+    }
 
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
-        ReleaseNullStr(scz);
+    // @Win64
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Win64", &pApprovedExe->fWin64);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Win64.");
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
     ReleaseStr(scz);
     return hr;
 }
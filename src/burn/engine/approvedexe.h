@@ -35,9 +35,9 @@ typedef struct _BURN_LAUNCH_APPROVED_EXE
 
 // function declarations
 
-HRESULT ApprovedExesParseFromXml(
+HRESULT ApprovedExeParseFromXml(
     __in BURN_APPROVED_EXES* pApprovedExes,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 
 void ApprovedExesUninitialize(
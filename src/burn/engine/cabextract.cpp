@@ -740,12 +740,31 @@ static UINT FAR DIAMONDAPI CabRead(
     BURN_CONTAINER_CONTEXT* pContext = vpContext;
     HANDLE hFile = (HANDLE)hf;
     DWORD cbRead = 0;
+    SIZE_T cbMappedRead = 0;
+    BURN_CONTAINER_CONTEXT_CABINET_VIRTUAL_FILE_POINTER* pVfp = NULL;
 
-    ReadIfVirtualFilePointer(&pContext->Cabinet, hFile, cb);
+    // The cabinet itself is copied straight out of the mapped view when there is one.
+    if (pContext->view.hMapping)
+    {
+        pVfp = GetVirtualFilePointer(&pContext->Cabinet, hFile);
+    }
 
-    if (!::ReadFile(hFile, pv, cb, &cbRead, NULL))
+    if (pVfp)
     {
-        ExitWithLastError(hr, "Failed to read during cabinet extraction.");
+        hr = FileMappedViewRead(&pContext->view, pVfp->liPosition.QuadPart, pv, cb, &cbMappedRead);
+        ExitOnFailure(hr, "Failed to read mapped container during cabinet extraction.");
+
+        pVfp->liPosition.QuadPart += cbMappedRead;
+        cbRead = static_cast<DWORD>(cbMappedRead);
+    }
+    else
+    {
+        ReadIfVirtualFilePointer(&pContext->Cabinet, hFile, cb);
+
+        if (!::ReadFile(hFile, pv, cb, &cbRead, NULL))
+        {
+            ExitWithLastError(hr, "Failed to read during cabinet extraction.");
+        }
     }
 
 LExit:
@@ -829,7 +848,8 @@ static long FAR DIAMONDAPI CabSeek(
         ExitOnFailure(hr, "Invalid seek type.");;
     }
 
-    if (SetIfVirtualFilePointer(&pContext->Cabinet, hFile, liDistance.QuadPart, &liNewPointer.QuadPart, seektype))
+    // Reads from a mapped container only use the virtual file pointer so the handle does not need to move.
+    if (SetIfVirtualFilePointer(&pContext->Cabinet, hFile, liDistance.QuadPart, &liNewPointer.QuadPart, seektype) && !pContext->view.hMapping)
     {
         // set file pointer
         if (!::SetFilePointerEx(hFile, liDistance, &liNewPointer, seektype))
@@ -5,59 +5,33 @@
 
 // function definitions
 
-extern "C" HRESULT CatalogsParseFromXml(
+extern "C" HRESULT CatalogParseFromXml(
     __in BURN_CATALOGS* pCatalogs,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
     LPWSTR scz = NULL;
+    BURN_CATALOG* pCatalog = NULL;
 
-    // select catalog nodes
-    hr = XmlSelectNodes(pixnBundle, L"Catalog", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select catalog nodes.");
-
-    // get catalog node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get payload node count.");
-    if (!cNodes)
-    {
-        ExitFunction();
-    }
-
-    // allocate memory for catalogs
-    pCatalogs->rgCatalogs = (BURN_CATALOG*)MemAlloc(sizeof(BURN_CATALOG) * cNodes, TRUE);
-    ExitOnNull(pCatalogs->rgCatalogs, hr, E_OUTOFMEMORY, "Failed to allocate memory for payload structs.");
-
-    pCatalogs->cCatalogs = cNodes;
-
-    // parse catalog elements
-    for (DWORD i = 0; i < cNodes; ++i)
-    {
-        BURN_CATALOG* pCatalog = &pCatalogs->rgCatalogs[i];
-        pCatalog->hFile = INVALID_HANDLE_VALUE;
+    // allocate memory for the catalog
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pCatalogs->rgCatalogs), pCatalogs->cCatalogs + 1, sizeof(BURN_CATALOG), pCatalogs->cCatalogs);
+    ExitOnFailure(hr, "Failed to allocate memory for catalog structs.");
 
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
+    pCatalog = &pCatalogs->rgCatalogs[pCatalogs->cCatalogs];
+    ++pCatalogs->cCatalogs;
 
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &pCatalog->sczKey);
-        ExitOnFailure(hr, "Failed to get @Id.");
+    pCatalog->hFile = INVALID_HANDLE_VALUE;
 
-        // @Payload
-        hr = XmlGetAttributeEx(pixnNode, L"Payload", &pCatalog->sczPayload);
-        ExitOnFailure(hr, "Failed to get @Payload.");
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pCatalog->sczKey);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
-    }
+    // @Payload
+    hr = XmlReaderGetAttribute(pReader, L"Payload", &pCatalog->sczPayload);
+    ExitOnFailure(hr, "Failed to get @Payload.");
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
     ReleaseStr(scz);
 
     return hr;
@@ -29,9 +29,9 @@ typedef struct _BURN_PAYLOADS BURN_PAYLOADS;
 
 // functions
 
-HRESULT CatalogsParseFromXml(
+HRESULT CatalogParseFromXml(
     __in BURN_CATALOGS* pCatalogs,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 HRESULT CatalogFindById(
     __in BURN_CATALOGS* pCatalogs,
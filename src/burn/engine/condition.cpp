@@ -216,32 +216,16 @@ LExit:
 
 HRESULT ConditionGlobalParseFromXml(
     __in BURN_CONDITION* pCondition,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNode* pixnNode = NULL;
-    BSTR bstrExpression = NULL;
 
-    // select variable nodes
-    hr = XmlSelectSingleNode(pixnBundle, L"Condition", &pixnNode);
-    if (S_FALSE == hr)
-    {
-        ExitFunction1(hr = S_OK);
-    }
-    ExitOnFailure(hr, "Failed to select condition node.");
-
-    // @Condition
-    hr = XmlGetText(pixnNode, &bstrExpression);
+    // Condition inner text
+    hr = XmlReaderReadElementText(pReader, &pCondition->sczConditionString);
     ExitOnFailure(hr, "Failed to get Condition inner text.");
 
-    hr = StrAllocString(&pCondition->sczConditionString, bstrExpression, 0);
-    ExitOnFailure(hr, "Failed to copy condition string from BSTR");
-
 LExit:
-    ReleaseBSTR(bstrExpression);
-    ReleaseObject(pixnNode);
-
     return hr;
 }
 
@@ -31,7 +31,7 @@ HRESULT ConditionGlobalCheck(
     );
 HRESULT ConditionGlobalParseFromXml(
     __in BURN_CONDITION* pBlock,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 
 #if defined(__cplusplus)
@@ -16,135 +16,107 @@ static HRESULT GetAttachedContainerInfo(
 
 // function definitions
 
-extern "C" HRESULT ContainersParseFromXml(
+extern "C" HRESULT ContainerParseFromXml(
     __in BURN_SECTION* pSection,
     __in BURN_CONTAINERS* pContainers,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
     LPWSTR scz = NULL;
+    BURN_CONTAINER* pContainer = NULL;
 
-    // select container nodes
-    hr = XmlSelectNodes(pixnBundle, L"Container", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select container nodes.");
+    // allocate memory for the container
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pContainers->rgContainers), pContainers->cContainers + 1, sizeof(BURN_CONTAINER), pContainers->cContainers);
+    ExitOnFailure(hr, "Failed to allocate memory for container structs.");
 
-    // get container node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get container node count.");
+    pContainer = &pContainers->rgContainers[pContainers->cContainers];
+    ++pContainers->cContainers;
 
-    if (!cNodes)
-    {
-        ExitFunction();
-    }
+    // TODO: Read type from manifest. Today only CABINET is supported.
+    pContainer->type = BURN_CONTAINER_TYPE_CABINET;
 
-    // allocate memory for searches
-    pContainers->rgContainers = (BURN_CONTAINER*)MemAlloc(sizeof(BURN_CONTAINER) * cNodes, TRUE);
-    ExitOnNull(pContainers->rgContainers, hr, E_OUTOFMEMORY, "Failed to allocate memory for container structs.");
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pContainer->sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-    pContainers->cContainers = cNodes;
+    // @Primary
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Primary", &pContainer->fPrimary);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Primary.");
+    }
 
-    // parse search elements
-    for (DWORD i = 0; i < cNodes; ++i)
+    // @Attached
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Attached", &pContainer->fAttached);
+    if (E_NOTFOUND != hr || pContainer->fPrimary) // if it is a primary container, it has to be attached
     {
-        BURN_CONTAINER* pContainer = &pContainers->rgContainers[i];
+        ExitOnFailure(hr, "Failed to get @Attached.");
+    }
 
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
+    // @AttachedIndex
+    hr = XmlReaderGetAttributeNumber(pReader, L"AttachedIndex", &pContainer->dwAttachedIndex);
+    if (E_NOTFOUND != hr || pContainer->fAttached) // if it is an attached container it must have an index
+    {
+        ExitOnFailure(hr, "Failed to get @AttachedIndex.");
+    }
 
-        // TODO: Read type from manifest. Today only CABINET is supported.
-        pContainer->type = BURN_CONTAINER_TYPE_CABINET;
+    // Attached containers are always found attached to the current process, so use the current proccess's
+    // name instead of what may be in the manifest.
+    if (pContainer->fAttached)
+    {
+        hr = PathForCurrentProcess(&scz, NULL);
+        ExitOnFailure(hr, "Failed to get path to current process for attached container.");
 
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &pContainer->sczId);
-        ExitOnFailure(hr, "Failed to get @Id.");
+        LPCWSTR wzFileName = PathFile(scz);
 
-        // @Primary
-        hr = XmlGetYesNoAttribute(pixnNode, L"Primary", &pContainer->fPrimary);
+        hr = StrAllocString(&pContainer->sczFilePath, wzFileName, 0);
+        ExitOnFailure(hr, "Failed to set attached container file path.");
+    }
+    else
+    {
+        // @FilePath
+        hr = XmlReaderGetAttribute(pReader, L"FilePath", &pContainer->sczFilePath);
         if (E_NOTFOUND != hr)
         {
-            ExitOnFailure(hr, "Failed to get @Primary.");
+            ExitOnFailure(hr, "Failed to get @FilePath.");
         }
+    }
 
-        // @Attached
-        hr = XmlGetYesNoAttribute(pixnNode, L"Attached", &pContainer->fAttached);
-        if (E_NOTFOUND != hr || pContainer->fPrimary) // if it is a primary container, it has to be attached
-        {
-            ExitOnFailure(hr, "Failed to get @Attached.");
-        }
-
-        // @AttachedIndex
-        hr = XmlGetAttributeNumber(pixnNode, L"AttachedIndex", &pContainer->dwAttachedIndex);
-        if (E_NOTFOUND != hr || pContainer->fAttached) // if it is an attached container it must have an index
-        {
-            ExitOnFailure(hr, "Failed to get @AttachedIndex.");
-        }
-
-        // Attached containers are always found attached to the current process, so use the current proccess's
-        // name instead of what may be in the manifest.
-        if (pContainer->fAttached)
-        {
-            hr = PathForCurrentProcess(&scz, NULL);
-            ExitOnFailure(hr, "Failed to get path to current process for attached container.");
-
-            LPCWSTR wzFileName = PathFile(scz);
-
-            hr = StrAllocString(&pContainer->sczFilePath, wzFileName, 0);
-            ExitOnFailure(hr, "Failed to set attached container file path.");
-        }
-        else
-        {
-            // @FilePath
-            hr = XmlGetAttributeEx(pixnNode, L"FilePath", &pContainer->sczFilePath);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @FilePath.");
-            }
-        }
-
-        // The source path starts as the file path.
-        hr = StrAllocString(&pContainer->sczSourcePath, pContainer->sczFilePath, 0);
-        ExitOnFailure(hr, "Failed to copy @FilePath");
-
-        // @DownloadUrl
-        hr = XmlGetAttributeEx(pixnNode, L"DownloadUrl", &pContainer->downloadSource.sczUrl);
-        if (E_NOTFOUND != hr || (!pContainer->fPrimary && !pContainer->sczSourcePath)) // if the package is not a primary package, it must have a source path or a download url
-        {
-            ExitOnFailure(hr, "Failed to get @DownloadUrl. Either @SourcePath or @DownloadUrl needs to be provided.");
-        }
+    // The source path starts as the file path.
+    hr = StrAllocString(&pContainer->sczSourcePath, pContainer->sczFilePath, 0);
+    ExitOnFailure(hr, "Failed to copy @FilePath");
 
-        // @Hash
-        hr = XmlGetAttributeEx(pixnNode, L"Hash", &pContainer->sczHash);
-        if (SUCCEEDED(hr))
-        {
-            hr = StrAllocHexDecode(pContainer->sczHash, &pContainer->pbHash, &pContainer->cbHash);
-            ExitOnFailure(hr, "Failed to hex decode the Container/@Hash.");
-        }
-        else if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @Hash.");
-        }
+    // @DownloadUrl
+    hr = XmlReaderGetAttribute(pReader, L"DownloadUrl", &pContainer->downloadSource.sczUrl);
+    if (E_NOTFOUND != hr || (!pContainer->fPrimary && !pContainer->sczSourcePath)) // if the package is not a primary package, it must have a source path or a download url
+    {
+        ExitOnFailure(hr, "Failed to get @DownloadUrl. Either @SourcePath or @DownloadUrl needs to be provided.");
+    }
 
-        // If the container is attached, make sure the information in the section matches what the
-        // manifest contained and get the offset to the container.
-        if (pContainer->fAttached)
-        {
-            hr = SectionGetAttachedContainerInfo(pSection, pContainer->dwAttachedIndex, pContainer->type, &pContainer->qwAttachedOffset, &pContainer->qwFileSize, &pContainer->fActuallyAttached);
-            ExitOnFailure(hr, "Failed to get attached container information.");
-        }
+    // @Hash
+    hr = XmlReaderGetAttribute(pReader, L"Hash", &pContainer->sczHash);
+    if (SUCCEEDED(hr))
+    {
+        hr = StrAllocHexDecode(pContainer->sczHash, &pContainer->pbHash, &pContainer->cbHash);
+        ExitOnFailure(hr, "Failed to hex decode the Container/@Hash.");
+    }
+    else if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Hash.");
+    }
 
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
+    // If the container is attached, make sure the information in the section matches what the
+    // manifest contained and get the offset to the container.
+    if (pContainer->fAttached)
+    {
+        hr = SectionGetAttachedContainerInfo(pSection, pContainer->dwAttachedIndex, pContainer->type, &pContainer->qwAttachedOffset, &pContainer->qwFileSize, &pContainer->fActuallyAttached);
+        ExitOnFailure(hr, "Failed to get attached container information.");
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
     ReleaseStr(scz);
 
     return hr;
@@ -248,6 +220,15 @@ extern "C" HRESULT ContainerOpen(
         ExitWithLastError(hr, "Failed to move file pointer to container offset.");
     }
 
+    // Stream the container out of a mapped view when possible. Reading through the handle still
+    // works when the file cannot be mapped so failure here is not fatal.
+    hr = FileMappedViewInitialize(&pContext->view, pContext->hFile, 0);
+    if (FAILED(hr))
+    {
+        LogStringLine(REPORT_VERBOSE, "Failed to map container, reading it instead, error: 0x%x", hr);
+        hr = S_OK;
+    }
+
     // open the archive
     switch (pContext->type)
     {
@@ -349,6 +330,7 @@ extern "C" HRESULT ContainerClose(
     }
 
 LExit:
+    FileMappedViewUninitialize(&pContext->view);
     ReleaseFile(pContext->hFile);
 
     if (SUCCEEDED(hr))
@@ -116,6 +116,7 @@ typedef struct _BURN_CONTAINER_CONTEXT
     HANDLE hFile;
     DWORD64 qwOffset;
     DWORD64 qwSize;
+    FILE_MAPPED_VIEW view;  // mapping of hFile, if it could be mapped.
 
     //PFN_EXTRACTOPEN pfnExtractOpen;
     //PFN_EXTRACTNEXTSTREAM pfnExtractNextStream;
@@ -134,10 +135,10 @@ typedef struct _BURN_CONTAINER_CONTEXT
 
 // functions
 
-HRESULT ContainersParseFromXml(
+HRESULT ContainerParseFromXml(
     __in BURN_SECTION* pSection,
     __in BURN_CONTAINERS* pContainers,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 void ContainersUninitialize(
     __in BURN_CONTAINERS* pContainers
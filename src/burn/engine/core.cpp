@@ -93,7 +93,11 @@ extern "C" HRESULT CoreInitialize(
     hr = ContainerStreamToBuffer(&containerContext, &pbBuffer, &cbBuffer);
     ExitOnFailure(hr, "Failed to get manifest stream from container.");
 
-    hr = ManifestLoadXmlFromBuffer(pbBuffer, cbBuffer, pEngineState);
+    // The manifest strings live as long as the engine so allocate them all together.
+    hr = MemArenaCreate(0, &pEngineState->hManifestArena);
+    ExitOnFailure(hr, "Failed to create manifest arena.");
+
+    hr = ManifestLoadFromBuffer(pbBuffer, cbBuffer, pEngineState);
     ExitOnFailure(hr, "Failed to load manifest.");
 
     // Parse command line.
@@ -124,7 +128,7 @@ extern "C" HRESULT CoreInitialize(
     }
 
     // Set BURN_BUNDLE_ORIGINAL_SOURCE, if it was passed in on the command line.
-    // Needs to be done after ManifestLoadXmlFromBuffer.
+    // Needs to be done after ManifestLoadFromBuffer.
     if (sczOriginalSource)
     {
         hr = VariableSetLiteralString(&pEngineState->variables, BURN_BUNDLE_ORIGINAL_SOURCE, sczOriginalSource, FALSE);
@@ -103,6 +103,7 @@ typedef struct _BURN_ENGINE_STATE
     BURN_PACKAGES packages;
     BURN_UPDATE update;
     BURN_APPROVED_EXES approvedExes;
+    MEM_ARENA_HANDLE hManifestArena; // strings parsed from the manifest, freed after everything that points into it.
 
     HWND hMessageWindow;
     HANDLE hMessageWindowThread;
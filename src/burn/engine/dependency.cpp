@@ -87,83 +87,52 @@ extern "C" void DependencyUninitialize(
     memset(pProvider, 0, sizeof(BURN_DEPENDENCY_PROVIDER));
 }
 
-extern "C" HRESULT DependencyParseProvidersFromXml(
+extern "C" HRESULT DependencyParseProviderFromXml(
     __in BURN_PACKAGE* pPackage,
-    __in IXMLDOMNode* pixnPackage
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    DWORD cNodes = 0;
-    IXMLDOMNode* pixnNode = NULL;
+    BURN_DEPENDENCY_PROVIDER* pDependencyProvider = NULL;
 
-    // Select dependency provider nodes.
-    hr = XmlSelectNodes(pixnPackage, L"Provides", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select dependency provider nodes.");
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->rgDependencyProviders), pPackage->cDependencyProviders + 1, sizeof(BURN_DEPENDENCY_PROVIDER), 2);
+    ExitOnFailure(hr, "Failed to allocate memory for dependency providers.");
 
-    // Get dependency provider node count.
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get the dependency provider node count.");
+    pDependencyProvider = &pPackage->rgDependencyProviders[pPackage->cDependencyProviders];
+    ++pPackage->cDependencyProviders;
 
-    if (!cNodes)
+    // @Key
+    hr = XmlReaderGetAttribute(pReader, L"Key", &pDependencyProvider->sczKey);
+    ExitOnFailure(hr, "Failed to get the Key attribute.");
+
+    // @Version
+    hr = XmlReaderGetAttribute(pReader, L"Version", &pDependencyProvider->sczVersion);
+    if (E_NOTFOUND != hr)
     {
-        ExitFunction1(hr = S_OK);
+        ExitOnFailure(hr, "Failed to get the Version attribute.");
     }
 
-    // Allocate memory for dependency provider pointers.
-    pPackage->rgDependencyProviders = (BURN_DEPENDENCY_PROVIDER*)MemAlloc(sizeof(BURN_DEPENDENCY_PROVIDER) * cNodes, TRUE);
-    ExitOnNull(pPackage->rgDependencyProviders, hr, E_OUTOFMEMORY, "Failed to allocate memory for dependency providers.");
-
-    pPackage->cDependencyProviders = cNodes;
-
-    // Parse dependency provider elements.
-    for (DWORD i = 0; i < cNodes; i++)
+    // @DisplayName
+    hr = XmlReaderGetAttribute(pReader, L"DisplayName", &pDependencyProvider->sczDisplayName);
+    if (E_NOTFOUND != hr)
     {
-        BURN_DEPENDENCY_PROVIDER* pDependencyProvider = &pPackage->rgDependencyProviders[i];
-
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get the next dependency provider node.");
-
-        // @Key
-        hr = XmlGetAttributeEx(pixnNode, L"Key", &pDependencyProvider->sczKey);
-        ExitOnFailure(hr, "Failed to get the Key attribute.");
-
-        // @Version
-        hr = XmlGetAttributeEx(pixnNode, L"Version", &pDependencyProvider->sczVersion);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get the Version attribute.");
-        }
-
-        // @DisplayName
-        hr = XmlGetAttributeEx(pixnNode, L"DisplayName", &pDependencyProvider->sczDisplayName);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get the DisplayName attribute.");
-        }
-
-        // @Imported
-        hr = XmlGetYesNoAttribute(pixnNode, L"Imported", &pDependencyProvider->fImported);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get the Imported attribute.");
-        }
-        else
-        {
-            pDependencyProvider->fImported = FALSE;
-            hr = S_OK;
-        }
+        ExitOnFailure(hr, "Failed to get the DisplayName attribute.");
+    }
 
-        // Prepare next iteration.
-        ReleaseNullObject(pixnNode);
+    // @Imported
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Imported", &pDependencyProvider->fImported);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get the Imported attribute.");
+    }
+    else
+    {
+        pDependencyProvider->fImported = FALSE;
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNode);
-    ReleaseObject(pixnNodes);
-
     return hr;
 }
 
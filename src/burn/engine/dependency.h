@@ -23,13 +23,13 @@ void DependencyUninitialize(
     );
 
 /********************************************************************
- DependencyParseProvidersFromXml - Parses dependency information
-  from the manifest for the specified package.
+ DependencyParseProviderFromXml - Parses a Provides element from
+  the manifest for the specified package.
 
 *********************************************************************/
-HRESULT DependencyParseProvidersFromXml(
+HRESULT DependencyParseProviderFromXml(
     __in BURN_PACKAGE* pPackage,
-    __in IXMLDOMNode* pixnPackage
+    __in XML_READER* pReader
     );
 
 /********************************************************************
@@ -294,6 +294,9 @@ static HRESULT InitializeEngineState(
     pEngineState->dwElevatedLoggingTlsId = TLS_OUT_OF_INDEXES;
     ::InitializeCriticalSection(&pEngineState->csActive);
     ::InitializeCriticalSection(&pEngineState->userExperience.csEngineActive);
+    ::InitializeCriticalSection(&pEngineState->userExperience.csProgress);
+    pEngineState->userExperience.dwProgressInterval = BURN_PROGRESS_DEFAULT_INTERVAL;
+    pEngineState->userExperience.dwProgressMinimumDelta = BURN_PROGRESS_DEFAULT_MINIMUM_DELTA;
     PipeConnectionInitialize(&pEngineState->companionConnection);
     PipeConnectionInitialize(&pEngineState->embeddedConnection);
 
@@ -351,6 +354,7 @@ static void UninitializeEngineState(
     ReleaseHandle(pEngineState->hMessageWindowThread);
 
     ::DeleteCriticalSection(&pEngineState->userExperience.csEngineActive);
+    ::DeleteCriticalSection(&pEngineState->userExperience.csProgress);
     UserExperienceUninitialize(&pEngineState->userExperience);
 
     ApprovedExesUninitialize(&pEngineState->approvedExes);
@@ -379,6 +383,9 @@ static void UninitializeEngineState(
 
     ::DeleteCriticalSection(&pEngineState->csActive);
 
+    // Last, since everything released above may still point into it.
+    ReleaseMemArena(pEngineState->hManifestArena);
+
     // clear struct
     memset(pEngineState, 0, sizeof(BURN_ENGINE_STATE));
 }
@@ -10,12 +10,12 @@ static HRESULT HandleExitCode(
     __in DWORD dwExitCode,
     __out BOOTSTRAPPER_APPLY_RESTART* pRestart
     );
-static HRESULT ParseCommandLineArgumentsFromXml(
-    __in IXMLDOMNode* pixnExePackage,
+static HRESULT ParseCommandLineArgumentFromXml(
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     );
-static HRESULT ParseExitCodesFromXml(
-    __in IXMLDOMNode* pixnExePackage,
+static HRESULT ParseExitCodeFromXml(
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     );
 
@@ -23,40 +23,38 @@ static HRESULT ParseExitCodesFromXml(
 // function definitions
 
 extern "C" HRESULT ExeEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnExePackage,
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
     LPWSTR scz = NULL;
 
     // @DetectCondition
-    hr = XmlGetAttributeEx(pixnExePackage, L"DetectCondition", &pPackage->Exe.sczDetectCondition);
+    hr = XmlReaderGetAttribute(pReader, L"DetectCondition", &pPackage->Exe.sczDetectCondition);
     ExitOnFailure(hr, "Failed to get @DetectCondition.");
 
     // @InstallArguments
-    hr = XmlGetAttributeEx(pixnExePackage, L"InstallArguments", &pPackage->Exe.sczInstallArguments);
+    hr = XmlReaderGetAttribute(pReader, L"InstallArguments", &pPackage->Exe.sczInstallArguments);
     ExitOnFailure(hr, "Failed to get @InstallArguments.");
 
     // @UninstallArguments
-    hr = XmlGetAttributeEx(pixnExePackage, L"UninstallArguments", &pPackage->Exe.sczUninstallArguments);
+    hr = XmlReaderGetAttribute(pReader, L"UninstallArguments", &pPackage->Exe.sczUninstallArguments);
     ExitOnFailure(hr, "Failed to get @UninstallArguments.");
 
     // @RepairArguments
-    hr = XmlGetAttributeEx(pixnExePackage, L"RepairArguments", &pPackage->Exe.sczRepairArguments);
+    hr = XmlReaderGetAttribute(pReader, L"RepairArguments", &pPackage->Exe.sczRepairArguments);
     ExitOnFailure(hr, "Failed to get @RepairArguments.");
 
     // @Repairable
-    hr = XmlGetYesNoAttribute(pixnExePackage, L"Repairable", &pPackage->Exe.fRepairable);
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Repairable", &pPackage->Exe.fRepairable);
     if (E_NOTFOUND != hr)
     {
         ExitOnFailure(hr, "Failed to get @Repairable.");
     }
 
     // @Protocol
-    hr = XmlGetAttributeEx(pixnExePackage, L"Protocol", &scz);
+    hr = XmlReaderGetAttribute(pReader, L"Protocol", &scz);
     if (SUCCEEDED(hr))
     {
         if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"burn", -1))
@@ -82,20 +80,36 @@ extern "C" HRESULT ExeEngineParsePackageFromXml(
         ExitOnFailure(hr, "Failed to get @Protocol.");
     }
 
-    hr = ParseExitCodesFromXml(pixnExePackage, pPackage);
-    ExitOnFailure(hr, "Failed to parse exit codes.");
-
-    hr = ParseCommandLineArgumentsFromXml(pixnExePackage, pPackage);
-    ExitOnFailure(hr, "Failed to parse command lines.");
+    hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
     ReleaseStr(scz);
 
     return hr;
 }
 
+extern "C" HRESULT ExeEngineParsePackageChildFromXml(
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE* pPackage
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pReader->wzName, -1, L"ExitCode", -1))
+    {
+        hr = ParseExitCodeFromXml(pReader, pPackage);
+        ExitOnFailure(hr, "Failed to parse exit code.");
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pReader->wzName, -1, L"CommandLine", -1))
+    {
+        hr = ParseCommandLineArgumentFromXml(pReader, pPackage);
+        ExitOnFailure(hr, "Failed to parse command line.");
+    }
+
+LExit:
+    return hr;
+}
+
 extern "C" void ExeEnginePackageUninitialize(
     __in BURN_PACKAGE* pPackage
     )
@@ -600,136 +614,77 @@ LExit:
 
 // internal helper functions
 
-static HRESULT ParseExitCodesFromXml(
-    __in IXMLDOMNode* pixnExePackage,
+static HRESULT ParseExitCodeFromXml(
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    LPWSTR scz = NULL;
-
-    // select exit code nodes
-    hr = XmlSelectNodes(pixnExePackage, L"ExitCode", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select exit code nodes.");
-
-    // get exit code node count
-    hr = pixnNodes->get_length((long*) &cNodes);
-    ExitOnFailure(hr, "Failed to get exit code node count.");
+    LPCWSTR wzCode = NULL;
+    BURN_EXE_EXIT_CODE* pExitCode = NULL;
 
-    if (cNodes)
-    {
-        // allocate memory for exit codes
-        pPackage->Exe.rgExitCodes = (BURN_EXE_EXIT_CODE*) MemAlloc(sizeof(BURN_EXE_EXIT_CODE) * cNodes, TRUE);
-        ExitOnNull(pPackage->Exe.rgExitCodes, hr, E_OUTOFMEMORY, "Failed to allocate memory for exit code structs.");
-
-        pPackage->Exe.cExitCodes = cNodes;
-
-        // parse package elements
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            BURN_EXE_EXIT_CODE* pExitCode = &pPackage->Exe.rgExitCodes[i];
-
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next node.");
+    // allocate memory for the exit code
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->Exe.rgExitCodes), pPackage->Exe.cExitCodes + 1, sizeof(BURN_EXE_EXIT_CODE), 5);
+    ExitOnFailure(hr, "Failed to allocate memory for exit code structs.");
 
-            // @Type
-            hr = XmlGetAttributeNumber(pixnNode, L"Type", (DWORD*)&pExitCode->type);
-            ExitOnFailure(hr, "Failed to get @Type.");
+    pExitCode = &pPackage->Exe.rgExitCodes[pPackage->Exe.cExitCodes];
+    ++pPackage->Exe.cExitCodes;
 
-            // @Code
-            hr = XmlGetAttributeEx(pixnNode, L"Code", &scz);
-            ExitOnFailure(hr, "Failed to get @Code.");
+    // @Type
+    hr = XmlReaderGetAttributeNumber(pReader, L"Type", (DWORD*)&pExitCode->type);
+    ExitOnFailure(hr, "Failed to get @Type.");
 
-            if (L'*' == scz[0])
-            {
-                pExitCode->fWildcard = TRUE;
-            }
-            else
-            {
-                hr = StrStringToUInt32(scz, 0, (UINT*) &pExitCode->dwCode);
-                ExitOnFailure(hr, "Failed to parse @Code value: %ls", scz);
-            }
+    // @Code
+    hr = XmlReaderGetAttributeValue(pReader, L"Code", &wzCode);
+    ExitOnFailure(hr, "Failed to get @Code.");
 
-            // prepare next iteration
-            ReleaseNullObject(pixnNode);
-        }
+    if (L'*' == wzCode[0])
+    {
+        pExitCode->fWildcard = TRUE;
+    }
+    else
+    {
+        hr = StrStringToUInt32(wzCode, 0, (UINT*) &pExitCode->dwCode);
+        ExitOnFailure(hr, "Failed to parse @Code value: %ls", wzCode);
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseStr(scz);
-
     return hr;
 }
 
-static HRESULT ParseCommandLineArgumentsFromXml(
-    __in IXMLDOMNode* pixnExePackage,
+static HRESULT ParseCommandLineArgumentFromXml(
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    LPWSTR scz = NULL;
+    BURN_EXE_COMMAND_LINE_ARGUMENT* pCommandLineArgument = NULL;
 
-    // Select command-line argument nodes.
-    hr = XmlSelectNodes(pixnExePackage, L"CommandLine", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select command-line argument nodes.");
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->Exe.rgCommandLineArguments), pPackage->Exe.cCommandLineArguments + 1, sizeof(BURN_EXE_COMMAND_LINE_ARGUMENT), 5);
+    ExitOnFailure(hr, "Failed to allocate memory for command-line argument structs.");
 
-    // Get command-line argument node count.
-    hr = pixnNodes->get_length((long*) &cNodes);
-    ExitOnFailure(hr, "Failed to get command-line argument count.");
+    pCommandLineArgument = &pPackage->Exe.rgCommandLineArguments[pPackage->Exe.cCommandLineArguments];
+    ++pPackage->Exe.cCommandLineArguments;
 
-    if (cNodes)
-    {
-        pPackage->Exe.rgCommandLineArguments = (BURN_EXE_COMMAND_LINE_ARGUMENT*) MemAlloc(sizeof(BURN_EXE_COMMAND_LINE_ARGUMENT) * cNodes, TRUE);
-        ExitOnNull(pPackage->Exe.rgCommandLineArguments, hr, E_OUTOFMEMORY, "Failed to allocate memory for command-line argument structs.");
+    // @InstallArgument
+    hr = XmlReaderGetAttribute(pReader, L"InstallArgument", &pCommandLineArgument->sczInstallArgument);
+    ExitOnFailure(hr, "Failed to get @InstallArgument.");
 
-        pPackage->Exe.cCommandLineArguments = cNodes;
+    // @UninstallArgument
+    hr = XmlReaderGetAttribute(pReader, L"UninstallArgument", &pCommandLineArgument->sczUninstallArgument);
+    ExitOnFailure(hr, "Failed to get @UninstallArgument.");
 
-        // Parse command-line argument elements.
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            BURN_EXE_COMMAND_LINE_ARGUMENT* pCommandLineArgument = &pPackage->Exe.rgCommandLineArguments[i];
-
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next command-line argument node.");
-
-            // @InstallArgument
-            hr = XmlGetAttributeEx(pixnNode, L"InstallArgument", &pCommandLineArgument->sczInstallArgument);
-            ExitOnFailure(hr, "Failed to get @InstallArgument.");
-
-            // @UninstallArgument
-            hr = XmlGetAttributeEx(pixnNode, L"UninstallArgument", &pCommandLineArgument->sczUninstallArgument);
-            ExitOnFailure(hr, "Failed to get @UninstallArgument.");
-
-            // @RepairArgument
-            hr = XmlGetAttributeEx(pixnNode, L"RepairArgument", &pCommandLineArgument->sczRepairArgument);
-            ExitOnFailure(hr, "Failed to get @RepairArgument.");
-
-            // @Condition
-            hr = XmlGetAttributeEx(pixnNode, L"Condition", &pCommandLineArgument->sczCondition);
-            ExitOnFailure(hr, "Failed to get @Condition.");
+    // @RepairArgument
+    hr = XmlReaderGetAttribute(pReader, L"RepairArgument", &pCommandLineArgument->sczRepairArgument);
+    ExitOnFailure(hr, "Failed to get @RepairArgument.");
 
-            // Prepare next iteration.
-            ReleaseNullObject(pixnNode);
-        }
-    }
-
-    hr = S_OK;
+    // @Condition
+    hr = XmlReaderGetAttribute(pReader, L"Condition", &pCommandLineArgument->sczCondition);
+    ExitOnFailure(hr, "Failed to get @Condition.");
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseStr(scz);
-
     return hr;
 }
 
@@ -10,7 +10,11 @@ extern "C" {
 // function declarations
 
 HRESULT ExeEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnExePackage,
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE* pPackage
+    );
+HRESULT ExeEngineParsePackageChildFromXml(
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     );
 void ExeEnginePackageUninitialize(
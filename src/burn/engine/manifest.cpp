@@ -3,8 +3,60 @@
 #include "precomp.h"
 
 
+// internal function declarations
+
+static HRESULT ParseManifest(
+    __in BURN_ENGINE_STATE* pEngineState,
+    __in XML_READER* pReader
+    );
+static HRESULT ParseLogFromXml(
+    __in BURN_ENGINE_STATE* pEngineState,
+    __in XML_READER* pReader
+    );
+static HRESULT ParseChainFromXml(
+    __in BURN_ENGINE_STATE* pEngineState,
+    __in XML_READER* pReader
+    );
+static BOOL IsSearchElement(
+    __in_z LPCWSTR wzElement
+    );
+
+
 // function definitions
 
+/********************************************************************
+ ManifestLoadFromBuffer - loads the compiled manifest the binder writes,
+                          falling back to xml for older bundles.
+
+********************************************************************/
+extern "C" HRESULT ManifestLoadFromBuffer(
+    __in_bcount(cbBuffer) BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in BURN_ENGINE_STATE* pEngineState
+    )
+{
+    HRESULT hr = S_OK;
+    XML_READER reader = { };
+
+    if (XmlReaderIsCompiled(pbBuffer, cbBuffer))
+    {
+        hr = XmlReaderInitializeFromCompiled(pbBuffer, cbBuffer, &reader);
+        ExitOnFailure(hr, "Failed to load compiled manifest.");
+    }
+    else
+    {
+        hr = XmlReaderInitializeFromBuffer(pbBuffer, cbBuffer, &reader);
+        ExitOnFailure(hr, "Failed to load manifest as XML document.");
+    }
+
+    hr = ParseManifest(pEngineState, &reader);
+    ExitOnFailure(hr, "Failed to parse manifest.");
+
+LExit:
+    XmlReaderUninitialize(&reader);
+    return hr;
+}
+
 extern "C" HRESULT ManifestLoadXmlFromBuffer(
     __in_bcount(cbBuffer) BYTE* pbBuffer,
     __in SIZE_T cbBuffer,
@@ -12,114 +64,299 @@ extern "C" HRESULT ManifestLoadXmlFromBuffer(
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMDocument* pixdDocument = NULL;
-    IXMLDOMElement* pixeBundle = NULL;
-    IXMLDOMNode* pixnLog = NULL;
-    IXMLDOMNode* pixnChain = NULL;
+    XML_READER reader = { };
 
     // load xml document
-    hr = XmlLoadDocumentFromBuffer(pbBuffer, cbBuffer, &pixdDocument);
+    hr = XmlReaderInitializeFromBuffer(pbBuffer, cbBuffer, &reader);
     ExitOnFailure(hr, "Failed to load manifest as XML document.");
 
+    hr = ParseManifest(pEngineState, &reader);
+    ExitOnFailure(hr, "Failed to parse manifest.");
+
+LExit:
+    XmlReaderUninitialize(&reader);
+    return hr;
+}
+
+
+// internal function definitions
+
+/********************************************************************
+ ParseManifest - loads the manifest in a single forward pass.
+
+ NOTE: Elements that refer to other elements by id must come after them,
+       which is the order the binder writes them in: catalogs and
+       containers before payloads, payloads and rollback boundaries
+       before the chain.
+********************************************************************/
+static HRESULT ParseManifest(
+    __in BURN_ENGINE_STATE* pEngineState,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzElement = NULL;
+    BOOL fLog = FALSE;
+    BOOL fCondition = FALSE;
+    BOOL fUserExperience = FALSE;
+    BOOL fRegistration = FALSE;
+    BOOL fUpdate = FALSE;
+    BOOL fChain = FALSE;
+
+    // Attribute values copied out of the manifest are allocated together when the engine has an arena for them.
+    pReader->hArena = pEngineState->hManifestArena;
+
     // get bundle element
-    hr = pixdDocument->get_documentElement(&pixeBundle);
+    hr = XmlReaderNextElement(pReader, 0, &wzElement);
+    if (S_FALSE == hr)
+    {
+        hr = E_INVALIDDATA;
+    }
     ExitOnFailure(hr, "Failed to get bundle element.");
 
-    // parse the log element, if present.
-    hr = XmlSelectSingleNode(pixeBundle, L"Log", &pixnLog);
-    ExitOnFailure(hr, "Failed to get Log element.");
-
-    if (S_OK == hr)
+    for (;;)
     {
-        hr = XmlGetAttributeEx(pixnLog, L"PathVariable", &pEngineState->log.sczPathVariable);
-        if (E_NOTFOUND != hr)
+        hr = XmlReaderNextElement(pReader, 1, &wzElement);
+        if (S_FALSE == hr)
         {
-            ExitOnFailure(hr, "Failed to get Log/@PathVariable.");
+            break;
         }
+        ExitOnFailure(hr, "Failed to read next bundle element.");
 
-        hr = XmlGetAttributeEx(pixnLog, L"Prefix", &pEngineState->log.sczPrefix);
-        ExitOnFailure(hr, "Failed to get Log/@Prefix attribute.");
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Log", -1))
+        {
+            if (fLog)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Manifest contains more than one Log element.");
+            }
+            fLog = TRUE;
 
-        hr = XmlGetAttributeEx(pixnLog, L"Extension", &pEngineState->log.sczExtension);
-        ExitOnFailure(hr, "Failed to get Log/@Extension attribute.");
-    }
+            hr = ParseLogFromXml(pEngineState, pReader);
+            ExitOnFailure(hr, "Failed to parse log.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Condition", -1))
+        {
+            if (fCondition)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Manifest contains more than one Condition element.");
+            }
+            fCondition = TRUE;
 
-    // get the chain element
-    hr = XmlSelectSingleNode(pixeBundle, L"Chain", &pixnChain);
-    ExitOnFailure(hr, "Failed to get chain element.");
+            // parse built-in condition
+            hr = ConditionGlobalParseFromXml(&pEngineState->condition, pReader);
+            ExitOnFailure(hr, "Failed to parse global condition.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Variable", -1))
+        {
+            hr = VariableParseFromXml(&pEngineState->variables, pReader);
+            ExitOnFailure(hr, "Failed to parse variables.");
+        }
+        else if (IsSearchElement(wzElement))
+        {
+            hr = SearchParseFromXml(&pEngineState->searches, pReader); // TODO: Modularization
+            ExitOnFailure(hr, "Failed to parse searches.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"UX", -1))
+        {
+            if (fUserExperience)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Manifest contains more than one UX element.");
+            }
+            fUserExperience = TRUE;
 
-    if (S_OK == hr)
-    {
-        // parse disable rollback
-        hr = XmlGetYesNoAttribute(pixnChain, L"DisableRollback", &pEngineState->fDisableRollback);
-        if (E_NOTFOUND != hr)
+            hr = UserExperienceParseFromXml(&pEngineState->userExperience, pReader);
+            ExitOnFailure(hr, "Failed to parse user experience.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Catalog", -1))
         {
-            ExitOnFailure(hr, "Failed to get Chain/@DisableRollback");
+            // payloads point into the catalog array so it cannot grow once they are parsed
+            if (pEngineState->payloads.cPayloads)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Catalog elements must precede Payload elements.");
+            }
+
+            hr = CatalogParseFromXml(&pEngineState->catalogs, pReader);
+            ExitOnFailure(hr, "Failed to parse catalog files.");
         }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"RelatedBundle", -1))
+        {
+            hr = RegistrationParseRelatedBundleFromXml(&pEngineState->registration, pReader);
+            ExitOnFailure(hr, "Failed to parse related bundles");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Registration", -1))
+        {
+            if (fRegistration)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Manifest contains more than one Registration element.");
+            }
+            fRegistration = TRUE;
 
-        // parse disable system restore
-        hr = XmlGetYesNoAttribute(pixnChain, L"DisableSystemRestore", &pEngineState->fDisableSystemRestore);
-        if (E_NOTFOUND != hr)
+            hr = RegistrationParseFromXml(&pEngineState->registration, pReader);
+            ExitOnFailure(hr, "Failed to parse registration.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Update", -1))
         {
-            ExitOnFailure(hr, "Failed to get Chain/@DisableSystemRestore");
+            if (fUpdate)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Manifest contains more than one Update element.");
+            }
+            fUpdate = TRUE;
+
+            hr = UpdateParseFromXml(&pEngineState->update, pReader);
+            ExitOnFailure(hr, "Failed to parse update.");
         }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Container", -1))
+        {
+            // payloads point into the container array so it cannot grow once they are parsed
+            if (pEngineState->payloads.cPayloads)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Container elements must precede Payload elements.");
+            }
 
-        // parse parallel cache
-        hr = XmlGetYesNoAttribute(pixnChain, L"ParallelCache", &pEngineState->fParallelCacheAndExecute);
-        if (E_NOTFOUND != hr)
+            hr = ContainerParseFromXml(&pEngineState->section, &pEngineState->containers, pReader);
+            ExitOnFailure(hr, "Failed to parse containers.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Payload", -1))
         {
-            ExitOnFailure(hr, "Failed to get Chain/@ParallelCache");
+            // packages point into the payload array so it cannot grow once they are parsed
+            if (fChain)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Payload elements must precede the Chain element.");
+            }
+
+            hr = PayloadParseFromXml(&pEngineState->payloads, &pEngineState->containers, &pEngineState->catalogs, pReader);
+            ExitOnFailure(hr, "Failed to parse payloads.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"RollbackBoundary", -1))
+        {
+            // packages point into the rollback boundary array so it cannot grow once they are parsed
+            if (fChain)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "RollbackBoundary elements must precede the Chain element.");
+            }
+
+            hr = PackagesParseRollbackBoundaryFromXml(&pEngineState->packages, pReader);
+            ExitOnFailure(hr, "Failed to parse rollback boundaries.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Chain", -1))
+        {
+            if (fChain)
+            {
+                hr = E_INVALIDDATA;
+                ExitOnRootFailure(hr, "Manifest contains more than one Chain element.");
+            }
+            fChain = TRUE;
+
+            hr = ParseChainFromXml(pEngineState, pReader);
+            ExitOnFailure(hr, "Failed to parse packages.");
         }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"PatchTargetCode", -1))
+        {
+            hr = PackagesParsePatchTargetCodeFromXml(&pEngineState->packages, pReader);
+            ExitOnFailure(hr, "Failed to parse target product codes.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"ApprovedExeForElevation", -1))
+        {
+            // parse approved exes for elevation
+            hr = ApprovedExeParseFromXml(&pEngineState->approvedExes, pReader);
+            ExitOnFailure(hr, "Failed to parse approved exes.");
+        }
+    }
+
+    if (!fUserExperience)
+    {
+        hr = E_NOTFOUND;
+        ExitOnFailure(hr, "Failed to select user experience node.");
+    }
+
+    if (!fRegistration)
+    {
+        hr = E_NOTFOUND;
+        ExitOnFailure(hr, "Failed to select registration node.");
     }
 
-    // parse built-in condition 
-    hr = ConditionGlobalParseFromXml(&pEngineState->condition, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse global condition.");
+    hr = S_OK;
+
+LExit:
+    return hr;
+}
+
+static HRESULT ParseLogFromXml(
+    __in BURN_ENGINE_STATE* pEngineState,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
 
-    // parse variables
-    hr = VariablesParseFromXml(&pEngineState->variables, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse variables.");
+    hr = XmlReaderGetAttribute(pReader, L"PathVariable", &pEngineState->log.sczPathVariable);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get Log/@PathVariable.");
+    }
 
-    // parse searches
-    hr = SearchesParseFromXml(&pEngineState->searches, pixeBundle); // TODO: Modularization
-    ExitOnFailure(hr, "Failed to parse searches.");
+    hr = XmlReaderGetAttribute(pReader, L"Prefix", &pEngineState->log.sczPrefix);
+    ExitOnFailure(hr, "Failed to get Log/@Prefix attribute.");
 
-    // parse user experience
-    hr = UserExperienceParseFromXml(&pEngineState->userExperience, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse user experience.");
+    hr = XmlReaderGetAttribute(pReader, L"Extension", &pEngineState->log.sczExtension);
+    ExitOnFailure(hr, "Failed to get Log/@Extension attribute.");
 
-    // parse catalog files
-    hr = CatalogsParseFromXml(&pEngineState->catalogs, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse catalog files.");
+LExit:
+    return hr;
+}
 
-    // parse registration
-    hr = RegistrationParseFromXml(&pEngineState->registration, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse registration.");
+static HRESULT ParseChainFromXml(
+    __in BURN_ENGINE_STATE* pEngineState,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
 
-    // parse update
-    hr = UpdateParseFromXml(&pEngineState->update, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse update.");
+    // parse disable rollback
+    hr = XmlReaderGetYesNoAttribute(pReader, L"DisableRollback", &pEngineState->fDisableRollback);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get Chain/@DisableRollback");
+    }
 
-    // parse containers
-    hr = ContainersParseFromXml(&pEngineState->section, &pEngineState->containers, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse containers.");
+    // parse disable system restore
+    hr = XmlReaderGetYesNoAttribute(pReader, L"DisableSystemRestore", &pEngineState->fDisableSystemRestore);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get Chain/@DisableSystemRestore");
+    }
 
-    // parse payloads
-    hr = PayloadsParseFromXml(&pEngineState->payloads, &pEngineState->containers, &pEngineState->catalogs, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse payloads.");
+    // parse parallel cache
+    hr = XmlReaderGetYesNoAttribute(pReader, L"ParallelCache", &pEngineState->fParallelCacheAndExecute);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get Chain/@ParallelCache");
+    }
 
     // parse packages
-    hr = PackagesParseFromXml(&pEngineState->packages, &pEngineState->payloads, pixeBundle);
+    hr = PackagesParseFromXml(&pEngineState->packages, &pEngineState->payloads, pReader);
     ExitOnFailure(hr, "Failed to parse packages.");
 
-    // parse approved exes for elevation
-    hr = ApprovedExesParseFromXml(&pEngineState->approvedExes, pixeBundle);
-    ExitOnFailure(hr, "Failed to parse approved exes.");
-
 LExit:
-    ReleaseObject(pixnChain);
-    ReleaseObject(pixnLog);
-    ReleaseObject(pixeBundle);
-    ReleaseObject(pixdDocument);
     return hr;
 }
+
+static BOOL IsSearchElement(
+    __in_z LPCWSTR wzElement
+    )
+{
+    return CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"DirectorySearch", -1) ||
+           CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"FileSearch", -1) ||
+           CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"RegistrySearch", -1) ||
+           CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsiComponentSearch", -1) ||
+           CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsiProductSearch", -1) ||
+           CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsiFeatureSearch", -1);
+}
@@ -13,7 +13,7 @@
 // internal function declarations
 
 static HRESULT ParseRelatedMsiFromXml(
-    __in IXMLDOMNode* pixnRelatedMsi,
+    __in XML_READER* pReader,
     __in BURN_RELATED_MSI* pRelatedMsi
     );
 static HRESULT EvaluateActionStateConditions(
@@ -54,267 +54,190 @@ static void RegisterSourceDirectory(
 // function definitions
 
 extern "C" HRESULT MsiEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnMsiPackage,
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    LPWSTR scz = NULL;
+    LPCWSTR wzVersion = NULL;
 
     // @ProductCode
-    hr = XmlGetAttributeEx(pixnMsiPackage, L"ProductCode", &pPackage->Msi.sczProductCode);
+    hr = XmlReaderGetAttribute(pReader, L"ProductCode", &pPackage->Msi.sczProductCode);
     ExitOnFailure(hr, "Failed to get @ProductCode.");
 
     // @Language
-    hr = XmlGetAttributeNumber(pixnMsiPackage, L"Language", &pPackage->Msi.dwLanguage);
+    hr = XmlReaderGetAttributeNumber(pReader, L"Language", &pPackage->Msi.dwLanguage);
     ExitOnFailure(hr, "Failed to get @Language.");
 
     // @Version
-    hr = XmlGetAttributeEx(pixnMsiPackage, L"Version", &scz);
+    hr = XmlReaderGetAttributeValue(pReader, L"Version", &wzVersion);
     ExitOnFailure(hr, "Failed to get @Version.");
 
-    hr = FileVersionFromStringEx(scz, 0, &pPackage->Msi.qwVersion);
-    ExitOnFailure(hr, "Failed to parse @Version: %ls", scz);
+    hr = FileVersionFromStringEx(wzVersion, 0, &pPackage->Msi.qwVersion);
+    ExitOnFailure(hr, "Failed to parse @Version: %ls", wzVersion);
 
     // @DisplayInternalUI
-    hr = XmlGetYesNoAttribute(pixnMsiPackage, L"DisplayInternalUI", &pPackage->Msi.fDisplayInternalUI);
+    hr = XmlReaderGetYesNoAttribute(pReader, L"DisplayInternalUI", &pPackage->Msi.fDisplayInternalUI);
     ExitOnFailure(hr, "Failed to get @DisplayInternalUI.");
 
     // @UpgradeCode
-    hr = XmlGetAttributeEx(pixnMsiPackage, L"UpgradeCode", &pPackage->Msi.sczUpgradeCode);
+    hr = XmlReaderGetAttribute(pReader, L"UpgradeCode", &pPackage->Msi.sczUpgradeCode);
     if (E_NOTFOUND != hr)
     {
         ExitOnFailure(hr, "Failed to get @UpgradeCode.");
     }
 
-    // select feature nodes
-    hr = XmlSelectNodes(pixnMsiPackage, L"MsiFeature", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select feature nodes.");
-
-    // get feature node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get feature node count.");
-
-    if (cNodes)
-    {
-        // allocate memory for features
-        pPackage->Msi.rgFeatures = (BURN_MSIFEATURE*)MemAlloc(sizeof(BURN_MSIFEATURE) * cNodes, TRUE);
-        ExitOnNull(pPackage->Msi.rgFeatures, hr, E_OUTOFMEMORY, "Failed to allocate memory for MSI feature structs.");
-
-        pPackage->Msi.cFeatures = cNodes;
-
-        // parse feature elements
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            BURN_MSIFEATURE* pFeature = &pPackage->Msi.rgFeatures[i];
-
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next node.");
-
-            // @Id
-            hr = XmlGetAttributeEx(pixnNode, L"Id", &pFeature->sczId);
-            ExitOnFailure(hr, "Failed to get @Id.");
-
-            // @AddLocalCondition
-            hr = XmlGetAttributeEx(pixnNode, L"AddLocalCondition", &pFeature->sczAddLocalCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @AddLocalCondition.");
-            }
+    hr = S_OK;
 
-            // @AddSourceCondition
-            hr = XmlGetAttributeEx(pixnNode, L"AddSourceCondition", &pFeature->sczAddSourceCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @AddSourceCondition.");
-            }
+LExit:
+    return hr;
+}
 
-            // @AdvertiseCondition
-            hr = XmlGetAttributeEx(pixnNode, L"AdvertiseCondition", &pFeature->sczAdvertiseCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @AdvertiseCondition.");
-            }
+extern "C" HRESULT MsiEngineParsePackageChildFromXml(
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE* pPackage
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzElement = pReader->wzName;
+    BURN_MSIFEATURE* pFeature = NULL;
+    BURN_RELATED_MSI* pRelatedMsi = NULL;
 
-            // @RollbackAddLocalCondition
-            hr = XmlGetAttributeEx(pixnNode, L"RollbackAddLocalCondition", &pFeature->sczRollbackAddLocalCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @RollbackAddLocalCondition.");
-            }
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsiFeature", -1))
+    {
+        // allocate memory for the feature
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->Msi.rgFeatures), pPackage->Msi.cFeatures + 1, sizeof(BURN_MSIFEATURE), 10);
+        ExitOnFailure(hr, "Failed to allocate memory for MSI feature structs.");
 
-            // @RollbackAddSourceCondition
-            hr = XmlGetAttributeEx(pixnNode, L"RollbackAddSourceCondition", &pFeature->sczRollbackAddSourceCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @RollbackAddSourceCondition.");
-            }
+        pFeature = &pPackage->Msi.rgFeatures[pPackage->Msi.cFeatures];
+        ++pPackage->Msi.cFeatures;
 
-            // @RollbackAdvertiseCondition
-            hr = XmlGetAttributeEx(pixnNode, L"RollbackAdvertiseCondition", &pFeature->sczRollbackAdvertiseCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @RollbackAdvertiseCondition.");
-            }
+        // @Id
+        hr = XmlReaderGetAttribute(pReader, L"Id", &pFeature->sczId);
+        ExitOnFailure(hr, "Failed to get @Id.");
 
-            // prepare next iteration
-            ReleaseNullObject(pixnNode);
+        // @AddLocalCondition
+        hr = XmlReaderGetAttribute(pReader, L"AddLocalCondition", &pFeature->sczAddLocalCondition);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @AddLocalCondition.");
         }
-    }
-
-    ReleaseNullObject(pixnNodes); // done with the MsiFeature elements.
-
-    hr = MsiEngineParsePropertiesFromXml(pixnMsiPackage, &pPackage->Msi.rgProperties, &pPackage->Msi.cProperties);
-    ExitOnFailure(hr, "Failed to parse properties from XML.");
 
-    // select related MSI nodes
-    hr = XmlSelectNodes(pixnMsiPackage, L"RelatedPackage", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select related MSI nodes.");
-
-    // get related MSI node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get related MSI node count.");
-
-    if (cNodes)
-    {
-        // allocate memory for related MSIs
-        pPackage->Msi.rgRelatedMsis = (BURN_RELATED_MSI*)MemAlloc(sizeof(BURN_RELATED_MSI) * cNodes, TRUE);
-        ExitOnNull(pPackage->Msi.rgRelatedMsis, hr, E_OUTOFMEMORY, "Failed to allocate memory for related MSI structs.");
+        // @AddSourceCondition
+        hr = XmlReaderGetAttribute(pReader, L"AddSourceCondition", &pFeature->sczAddSourceCondition);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @AddSourceCondition.");
+        }
 
-        pPackage->Msi.cRelatedMsis = cNodes;
+        // @AdvertiseCondition
+        hr = XmlReaderGetAttribute(pReader, L"AdvertiseCondition", &pFeature->sczAdvertiseCondition);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @AdvertiseCondition.");
+        }
 
-        // parse related MSI elements
-        for (DWORD i = 0; i < cNodes; ++i)
+        // @RollbackAddLocalCondition
+        hr = XmlReaderGetAttribute(pReader, L"RollbackAddLocalCondition", &pFeature->sczRollbackAddLocalCondition);
+        if (E_NOTFOUND != hr)
         {
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next node.");
+            ExitOnFailure(hr, "Failed to get @RollbackAddLocalCondition.");
+        }
 
-            // parse related MSI element
-            hr = ParseRelatedMsiFromXml(pixnNode, &pPackage->Msi.rgRelatedMsis[i]);
-            ExitOnFailure(hr, "Failed to parse related MSI element.");
+        // @RollbackAddSourceCondition
+        hr = XmlReaderGetAttribute(pReader, L"RollbackAddSourceCondition", &pFeature->sczRollbackAddSourceCondition);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @RollbackAddSourceCondition.");
+        }
 
-            // prepare next iteration
-            ReleaseNullObject(pixnNode);
+        // @RollbackAdvertiseCondition
+        hr = XmlReaderGetAttribute(pReader, L"RollbackAdvertiseCondition", &pFeature->sczRollbackAdvertiseCondition);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @RollbackAdvertiseCondition.");
         }
     }
-
-    ReleaseNullObject(pixnNodes); // done with the RelatedPackage elements.
-
-    // Select slipstream MSP nodes.
-    hr = XmlSelectNodes(pixnMsiPackage, L"SlipstreamMsp", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select related MSI nodes.");
-
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get related MSI node count.");
-
-    if (cNodes)
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsiProperty", -1))
+    {
+        hr = MsiEngineParsePropertyFromXml(pReader, &pPackage->Msi.rgProperties, &pPackage->Msi.cProperties);
+        ExitOnFailure(hr, "Failed to parse property from XML.");
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"RelatedPackage", -1))
     {
-        pPackage->Msi.rgpSlipstreamMspPackages = reinterpret_cast<BURN_PACKAGE**>(MemAlloc(sizeof(BURN_PACKAGE*) * cNodes, TRUE));
-        ExitOnNull(pPackage->Msi.rgpSlipstreamMspPackages, hr, E_OUTOFMEMORY, "Failed to allocate memory for slipstream MSP packages.");
+        // allocate memory for the related MSI
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->Msi.rgRelatedMsis), pPackage->Msi.cRelatedMsis + 1, sizeof(BURN_RELATED_MSI), 5);
+        ExitOnFailure(hr, "Failed to allocate memory for related MSI structs.");
 
-        pPackage->Msi.rgsczSlipstreamMspPackageIds = reinterpret_cast<LPWSTR*>(MemAlloc(sizeof(LPWSTR*) * cNodes, TRUE));
-        ExitOnNull(pPackage->Msi.rgsczSlipstreamMspPackageIds, hr, E_OUTOFMEMORY, "Failed to allocate memory for slipstream MSP ids.");
+        pRelatedMsi = &pPackage->Msi.rgRelatedMsis[pPackage->Msi.cRelatedMsis];
+        ++pPackage->Msi.cRelatedMsis;
 
-        pPackage->Msi.cSlipstreamMspPackages = cNodes;
+        // parse related MSI element
+        hr = ParseRelatedMsiFromXml(pReader, pRelatedMsi);
+        ExitOnFailure(hr, "Failed to parse related MSI element.");
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"SlipstreamMsp", -1))
+    {
+        // the package pointers and ids are parallel arrays so grow them together
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->Msi.rgpSlipstreamMspPackages), pPackage->Msi.cSlipstreamMspPackages + 1, sizeof(BURN_PACKAGE*), 5);
+        ExitOnFailure(hr, "Failed to allocate memory for slipstream MSP packages.");
 
-        // Parse slipstream MSP Ids.
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next slipstream MSP node.");
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->Msi.rgsczSlipstreamMspPackageIds), pPackage->Msi.cSlipstreamMspPackages + 1, sizeof(LPWSTR), 5);
+        ExitOnFailure(hr, "Failed to allocate memory for slipstream MSP ids.");
 
-            hr = XmlGetAttributeEx(pixnNode, L"Id", pPackage->Msi.rgsczSlipstreamMspPackageIds + i);
-            ExitOnFailure(hr, "Failed to parse slipstream MSP ids.");
+        ++pPackage->Msi.cSlipstreamMspPackages;
 
-            ReleaseNullObject(pixnNode);
-        }
+        hr = XmlReaderGetAttribute(pReader, L"Id", pPackage->Msi.rgsczSlipstreamMspPackageIds + pPackage->Msi.cSlipstreamMspPackages - 1);
+        ExitOnFailure(hr, "Failed to parse slipstream MSP ids.");
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseStr(scz);
-
     return hr;
 }
 
-extern "C" HRESULT MsiEngineParsePropertiesFromXml(
-    __in IXMLDOMNode* pixnPackage,
-    __out BURN_MSIPROPERTY** prgProperties,
-    __out DWORD* pcProperties
+extern "C" HRESULT MsiEngineParsePropertyFromXml(
+    __in XML_READER* pReader,
+    __inout BURN_MSIPROPERTY** prgProperties,
+    __inout DWORD* pcProperties
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
+    BURN_MSIPROPERTY* pProperty = NULL;
 
-    BURN_MSIPROPERTY* pProperties = NULL;
+    // allocate memory for the property
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(prgProperties), *pcProperties + 1, sizeof(BURN_MSIPROPERTY), 5);
+    ExitOnFailure(hr, "Failed to allocate memory for MSI property structs.");
 
-    // select property nodes
-    hr = XmlSelectNodes(pixnPackage, L"MsiProperty", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select property nodes.");
+    pProperty = *prgProperties + *pcProperties;
+    ++(*pcProperties);
 
-    // get property node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get property node count.");
-
-    if (cNodes)
-    {
-        // allocate memory for properties
-        pProperties = (BURN_MSIPROPERTY*)MemAlloc(sizeof(BURN_MSIPROPERTY) * cNodes, TRUE);
-        ExitOnNull(pProperties, hr, E_OUTOFMEMORY, "Failed to allocate memory for MSI property structs.");
-
-        // parse property elements
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            BURN_MSIPROPERTY* pProperty = &pProperties[i];
-
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next node.");
-
-            // @Id
-            hr = XmlGetAttributeEx(pixnNode, L"Id", &pProperty->sczId);
-            ExitOnFailure(hr, "Failed to get @Id.");
-
-            // @Value
-            hr = XmlGetAttributeEx(pixnNode, L"Value", &pProperty->sczValue);
-            ExitOnFailure(hr, "Failed to get @Value.");
-
-            // @RollbackValue
-            hr = XmlGetAttributeEx(pixnNode, L"RollbackValue", &pProperty->sczRollbackValue);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @RollbackValue.");
-            }
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pProperty->sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-            // @Condition
-            hr = XmlGetAttributeEx(pixnNode, L"Condition", &pProperty->sczCondition);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @Condition.");
-            }
+    // @Value
+    hr = XmlReaderGetAttribute(pReader, L"Value", &pProperty->sczValue);
+    ExitOnFailure(hr, "Failed to get @Value.");
 
-            // prepare next iteration
-            ReleaseNullObject(pixnNode);
-        }
+    // @RollbackValue
+    hr = XmlReaderGetAttribute(pReader, L"RollbackValue", &pProperty->sczRollbackValue);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @RollbackValue.");
     }
 
-    *pcProperties = cNodes;
-    *prgProperties = pProperties;
-    pProperties = NULL;
+    // @Condition
+    hr = XmlReaderGetAttribute(pReader, L"Condition", &pProperty->sczCondition);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Condition.");
+    }
 
     hr = S_OK;
 
 LExit:
-    ReleaseNullObject(pixnNodes);
-    ReleaseMem(pProperties);
-
     return hr;
 }
 
@@ -1394,100 +1317,93 @@ extern "C" INSTALLUILEVEL MsiEngineCalculateInstallUiLevel(
 // internal helper functions
 
 static HRESULT ParseRelatedMsiFromXml(
-    __in IXMLDOMNode* pixnRelatedMsi,
+    __in XML_READER* pReader,
     __in BURN_RELATED_MSI* pRelatedMsi
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    LPWSTR scz = NULL;
+    HRESULT hrLangInclusive = S_OK;
+    DWORD dwRelatedMsiDepth = pReader->dwDepth;
+    LPCWSTR wzVersion = NULL;
 
     // @Id
-    hr = XmlGetAttributeEx(pixnRelatedMsi, L"Id", &pRelatedMsi->sczUpgradeCode);
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pRelatedMsi->sczUpgradeCode);
     ExitOnFailure(hr, "Failed to get @Id.");
 
     // @MinVersion
-    hr = XmlGetAttributeEx(pixnRelatedMsi, L"MinVersion", &scz);
+    hr = XmlReaderGetAttributeValue(pReader, L"MinVersion", &wzVersion);
     if (E_NOTFOUND != hr)
     {
         ExitOnFailure(hr, "Failed to get @MinVersion.");
 
-        hr = FileVersionFromStringEx(scz, 0, &pRelatedMsi->qwMinVersion);
-        ExitOnFailure(hr, "Failed to parse @MinVersion: %ls", scz);
+        hr = FileVersionFromStringEx(wzVersion, 0, &pRelatedMsi->qwMinVersion);
+        ExitOnFailure(hr, "Failed to parse @MinVersion: %ls", wzVersion);
 
         // flag that we have a min version
         pRelatedMsi->fMinProvided = TRUE;
 
         // @MinInclusive
-        hr = XmlGetYesNoAttribute(pixnRelatedMsi, L"MinInclusive", &pRelatedMsi->fMinInclusive);
+        hr = XmlReaderGetYesNoAttribute(pReader, L"MinInclusive", &pRelatedMsi->fMinInclusive);
         ExitOnFailure(hr, "Failed to get @MinInclusive.");
     }
 
     // @MaxVersion
-    hr = XmlGetAttributeEx(pixnRelatedMsi, L"MaxVersion", &scz);
+    hr = XmlReaderGetAttributeValue(pReader, L"MaxVersion", &wzVersion);
     if (E_NOTFOUND != hr)
     {
         ExitOnFailure(hr, "Failed to get @MaxVersion.");
 
-        hr = FileVersionFromStringEx(scz, 0, &pRelatedMsi->qwMaxVersion);
-        ExitOnFailure(hr, "Failed to parse @MaxVersion: %ls", scz);
+        hr = FileVersionFromStringEx(wzVersion, 0, &pRelatedMsi->qwMaxVersion);
+        ExitOnFailure(hr, "Failed to parse @MaxVersion: %ls", wzVersion);
 
         // flag that we have a max version
         pRelatedMsi->fMaxProvided = TRUE;
 
         // @MaxInclusive
-        hr = XmlGetYesNoAttribute(pixnRelatedMsi, L"MaxInclusive", &pRelatedMsi->fMaxInclusive);
+        hr = XmlReaderGetYesNoAttribute(pReader, L"MaxInclusive", &pRelatedMsi->fMaxInclusive);
         ExitOnFailure(hr, "Failed to get @MaxInclusive.");
     }
 
     // @OnlyDetect
-    hr = XmlGetYesNoAttribute(pixnRelatedMsi, L"OnlyDetect", &pRelatedMsi->fOnlyDetect);
+    hr = XmlReaderGetYesNoAttribute(pReader, L"OnlyDetect", &pRelatedMsi->fOnlyDetect);
     ExitOnFailure(hr, "Failed to get @OnlyDetect.");
 
-    // select language nodes
-    hr = XmlSelectNodes(pixnRelatedMsi, L"Language", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select language nodes.");
-
-    // get language node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get language node count.");
+    // @LangInclusive is only required when there are languages, but the attributes
+    // are gone once the reader moves to the Language elements so read it now.
+    hrLangInclusive = XmlReaderGetYesNoAttribute(pReader, L"LangInclusive", &pRelatedMsi->fLangInclusive);
 
-    if (cNodes)
+    // parse language elements
+    for (;;)
     {
-        // @LangInclusive
-        hr = XmlGetYesNoAttribute(pixnRelatedMsi, L"LangInclusive", &pRelatedMsi->fLangInclusive);
-        ExitOnFailure(hr, "Failed to get @LangInclusive.");
+        hr = XmlReaderNextElement(pReader, dwRelatedMsiDepth, NULL);
+        if (S_FALSE == hr)
+        {
+            break;
+        }
+        ExitOnFailure(hr, "Failed to get next node.");
 
-        // allocate memory for language IDs
-        pRelatedMsi->rgdwLanguages = (DWORD*)MemAlloc(sizeof(DWORD) * cNodes, TRUE);
-        ExitOnNull(pRelatedMsi->rgdwLanguages, hr, E_OUTOFMEMORY, "Failed to allocate memory for language IDs.");
+        if (CSTR_EQUAL != ::CompareStringW(LOCALE_INVARIANT, 0, pReader->wzName, -1, L"Language", -1))
+        {
+            continue;
+        }
 
-        pRelatedMsi->cLanguages = cNodes;
+        hr = hrLangInclusive;
+        ExitOnFailure(hr, "Failed to get @LangInclusive.");
 
-        // parse language elements
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next node.");
+        // allocate memory for the language ID
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRelatedMsi->rgdwLanguages), pRelatedMsi->cLanguages + 1, sizeof(DWORD), 5);
+        ExitOnFailure(hr, "Failed to allocate memory for language IDs.");
 
-            // @Id
-            hr = XmlGetAttributeNumber(pixnNode, L"Id", &pRelatedMsi->rgdwLanguages[i]);
-            ExitOnFailure(hr, "Failed to get Language/@Id.");
+        ++pRelatedMsi->cLanguages;
 
-            // prepare next iteration
-            ReleaseNullObject(pixnNode);
-        }
+        // @Id
+        hr = XmlReaderGetAttributeNumber(pReader, L"Id", &pRelatedMsi->rgdwLanguages[pRelatedMsi->cLanguages - 1]);
+        ExitOnFailure(hr, "Failed to get Language/@Id.");
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseStr(scz);
-
     return hr;
 }
 
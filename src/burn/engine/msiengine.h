@@ -10,13 +10,17 @@ extern "C" {
 // function declarations
 
 HRESULT MsiEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnBundle,
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     );
-HRESULT MsiEngineParsePropertiesFromXml(
-    __in IXMLDOMNode* pixnPackage,
-    __out BURN_MSIPROPERTY** prgProperties,
-    __out DWORD* pcProperties
+HRESULT MsiEngineParsePackageChildFromXml(
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE* pPackage
+    );
+HRESULT MsiEngineParsePropertyFromXml(
+    __in XML_READER* pReader,
+    __inout BURN_MSIPROPERTY** prgProperties,
+    __inout DWORD* pcProperties
     );
 void MsiEnginePackageUninitialize(
     __in BURN_PACKAGE* pPackage
@@ -59,30 +59,44 @@ static HRESULT PlanTargetProduct(
 // function definitions
 
 extern "C" HRESULT MspEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnMspPackage,
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     )
 {
     HRESULT hr = S_OK;
 
     // @PatchCode
-    hr = XmlGetAttributeEx(pixnMspPackage, L"PatchCode", &pPackage->Msp.sczPatchCode);
+    hr = XmlReaderGetAttribute(pReader, L"PatchCode", &pPackage->Msp.sczPatchCode);
     ExitOnFailure(hr, "Failed to get @PatchCode.");
 
     // @PatchXml
-    hr = XmlGetAttributeEx(pixnMspPackage, L"PatchXml", &pPackage->Msp.sczApplicabilityXml);
+    hr = XmlReaderGetAttribute(pReader, L"PatchXml", &pPackage->Msp.sczApplicabilityXml);
     ExitOnFailure(hr, "Failed to get @PatchXml.");
 
     // @DisplayInternalUI
-    hr = XmlGetYesNoAttribute(pixnMspPackage, L"DisplayInternalUI", &pPackage->Msp.fDisplayInternalUI);
+    hr = XmlReaderGetYesNoAttribute(pReader, L"DisplayInternalUI", &pPackage->Msp.fDisplayInternalUI);
     ExitOnFailure(hr, "Failed to get @DisplayInternalUI.");
 
+LExit:
+
+    return hr;
+}
+
+extern "C" HRESULT MspEngineParsePackageChildFromXml(
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE* pPackage
+    )
+{
+    HRESULT hr = S_OK;
+
     // Read properties.
-    hr = MsiEngineParsePropertiesFromXml(pixnMspPackage, &pPackage->Msp.rgProperties, &pPackage->Msp.cProperties);
-    ExitOnFailure(hr, "Failed to parse properties from XML.");
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pReader->wzName, -1, L"MsiProperty", -1))
+    {
+        hr = MsiEngineParsePropertyFromXml(pReader, &pPackage->Msp.rgProperties, &pPackage->Msp.cProperties);
+        ExitOnFailure(hr, "Failed to parse property from XML.");
+    }
 
 LExit:
-
     return hr;
 }
 
@@ -19,7 +19,11 @@ extern "C" {
 // function declarations
 
 HRESULT MspEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnBundle,
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE* pPackage
+    );
+HRESULT MspEngineParsePackageChildFromXml(
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     );
 void MspEnginePackageUninitialize(
@@ -25,18 +25,18 @@ static HRESULT StopWUService(
 
 
 extern "C" HRESULT MsuEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnMsuPackage,
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     )
 {
     HRESULT hr = S_OK;
 
     // @KB
-    hr = XmlGetAttributeEx(pixnMsuPackage, L"KB", &pPackage->Msu.sczKB);
+    hr = XmlReaderGetAttribute(pReader, L"KB", &pPackage->Msu.sczKB);
     ExitOnFailure(hr, "Failed to get @KB.");
 
     // @DetectCondition
-    hr = XmlGetAttributeEx(pixnMsuPackage, L"DetectCondition", &pPackage->Msu.sczDetectCondition);
+    hr = XmlReaderGetAttribute(pReader, L"DetectCondition", &pPackage->Msu.sczDetectCondition);
     ExitOnFailure(hr, "Failed to get @DetectCondition.");
 
 LExit:
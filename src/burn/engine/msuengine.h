@@ -10,7 +10,7 @@ extern "C" {
 // function declarations
 
 HRESULT MsuEngineParsePackageFromXml(
-    __in IXMLDOMNode* pixnMsiPackage,
+    __in XML_READER* pReader,
     __in BURN_PACKAGE* pPackage
     );
 void MsuEnginePackageUninitialize(
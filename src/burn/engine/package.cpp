@@ -5,14 +5,16 @@
 
 // internal function declarations
 
-static HRESULT ParsePayloadRefsFromXml(
-    __in BURN_PACKAGE* pPackage,
+static HRESULT ParsePackageFromXml(
+    __in BURN_PACKAGES* pPackages,
     __in BURN_PAYLOADS* pPayloads,
-    __in IXMLDOMNode* pixnPackage
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE_TYPE type
     );
-static HRESULT ParsePatchTargetCode(
-    __in BURN_PACKAGES* pPackages,
-    __in IXMLDOMNode* pixnBundle
+static HRESULT ParsePayloadRefFromXml(
+    __in BURN_PACKAGE* pPackage,
+    __in BURN_PAYLOADS* pPayloads,
+    __in XML_READER* pReader
     );
 static HRESULT FindRollbackBoundaryById(
     __in BURN_PACKAGES* pPackages,
@@ -26,229 +28,50 @@ static HRESULT FindRollbackBoundaryById(
 extern "C" HRESULT PackagesParseFromXml(
     __in BURN_PACKAGES* pPackages,
     __in BURN_PAYLOADS* pPayloads,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    BSTR bstrNodeName = NULL;
+    DWORD dwChainDepth = pReader->dwDepth;
+    LPCWSTR wzElement = NULL;
+    BURN_PACKAGE_TYPE type = BURN_PACKAGE_TYPE_NONE;
     DWORD cMspPackages = 0;
-    LPWSTR scz = NULL;
-
-    // select rollback boundary nodes
-    hr = XmlSelectNodes(pixnBundle, L"RollbackBoundary", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select rollback boundary nodes.");
-
-    // get rollback boundary node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get rollback bundary node count.");
-
-    if (cNodes)
-    {
-        // allocate memory for rollback boundaries
-        pPackages->rgRollbackBoundaries = (BURN_ROLLBACK_BOUNDARY*)MemAlloc(sizeof(BURN_ROLLBACK_BOUNDARY) * cNodes, TRUE);
-        ExitOnNull(pPackages->rgRollbackBoundaries, hr, E_OUTOFMEMORY, "Failed to allocate memory for rollback boundary structs.");
-
-        pPackages->cRollbackBoundaries = cNodes;
-
-        // parse rollback boundary elements
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            BURN_ROLLBACK_BOUNDARY* pRollbackBoundary = &pPackages->rgRollbackBoundaries[i];
-
-            hr = XmlNextElement(pixnNodes, &pixnNode, &bstrNodeName);
-            ExitOnFailure(hr, "Failed to get next node.");
-
-            // @Id
-            hr = XmlGetAttributeEx(pixnNode, L"Id", &pRollbackBoundary->sczId);
-            ExitOnFailure(hr, "Failed to get @Id.");
-
-            // @Vital
-            hr = XmlGetYesNoAttribute(pixnNode, L"Vital", &pRollbackBoundary->fVital);
-            ExitOnFailure(hr, "Failed to get @Vital.");
-
-            // @Transaction
-            hr = XmlGetYesNoAttribute(pixnNode, L"Transaction", &pRollbackBoundary->fTransaction);
-            ExitOnFailure(hr, "Failed to get @Transaction.");
-
-            // prepare next iteration
-            ReleaseNullObject(pixnNode);
-            ReleaseNullBSTR(bstrNodeName);
-        }
-    }
-
-    ReleaseNullObject(pixnNodes); // done with the RollbackBoundary elements.
-
-    // select package nodes
-    hr = XmlSelectNodes(pixnBundle, L"Chain/ExePackage|Chain/MsiPackage|Chain/MspPackage|Chain/MsuPackage", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select package nodes.");
-
-    // get package node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get package node count.");
-
-    if (!cNodes)
-    {
-        ExitFunction1(hr = S_OK);
-    }
-
-    // allocate memory for packages
-    pPackages->rgPackages = (BURN_PACKAGE*)MemAlloc(sizeof(BURN_PACKAGE) * cNodes, TRUE);
-    ExitOnNull(pPackages->rgPackages, hr, E_OUTOFMEMORY, "Failed to allocate memory for package structs.");
-
-    pPackages->cPackages = cNodes;
 
     // parse package elements
-    for (DWORD i = 0; i < cNodes; ++i)
+    for (;;)
     {
-        BURN_PACKAGE* pPackage = &pPackages->rgPackages[i];
-
-        hr = XmlNextElement(pixnNodes, &pixnNode, &bstrNodeName);
-        ExitOnFailure(hr, "Failed to get next node.");
-
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &pPackage->sczId);
-        ExitOnFailure(hr, "Failed to get @Id.");
-
-        // @Cache
-        hr = XmlGetAttributeEx(pixnNode, L"Cache", &scz);
-        if (SUCCEEDED(hr))
-        {
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"no", -1))
-            {
-                pPackage->cacheType = BURN_CACHE_TYPE_NO;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"yes", -1))
-            {
-                pPackage->cacheType = BURN_CACHE_TYPE_YES;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"always", -1))
-            {
-                pPackage->cacheType = BURN_CACHE_TYPE_ALWAYS;
-            }
-            else
-            {
-                hr = E_UNEXPECTED;
-                ExitOnFailure(hr, "Invalid cache type: %ls", scz);
-            }
-        }
-        ExitOnFailure(hr, "Failed to get @Cache.");
-
-        // @CacheId
-        hr = XmlGetAttributeEx(pixnNode, L"CacheId", &pPackage->sczCacheId);
-        ExitOnFailure(hr, "Failed to get @CacheId.");
-
-        // @Size
-        hr = XmlGetAttributeLargeNumber(pixnNode, L"Size", &pPackage->qwSize);
-        ExitOnFailure(hr, "Failed to get @Size.");
-
-        // @InstallSize
-        hr = XmlGetAttributeLargeNumber(pixnNode, L"InstallSize", &pPackage->qwInstallSize);
-        ExitOnFailure(hr, "Failed to get @InstallSize.");
-
-        // @PerMachine
-        hr = XmlGetYesNoAttribute(pixnNode, L"PerMachine", &pPackage->fPerMachine);
-        ExitOnFailure(hr, "Failed to get @PerMachine.");
-
-        // @Permanent
-        hr = XmlGetYesNoAttribute(pixnNode, L"Permanent", &pPackage->fUninstallable);
-        ExitOnFailure(hr, "Failed to get @Permanent.");
-        pPackage->fUninstallable = !pPackage->fUninstallable; // TODO: change "Uninstallable" variable name to permanent, until then Uninstallable is the opposite of Permanent so fix the variable.
-
-        // @Vital
-        hr = XmlGetYesNoAttribute(pixnNode, L"Vital", &pPackage->fVital);
-        ExitOnFailure(hr, "Failed to get @Vital.");
-
-        // @LogPathVariable
-        hr = XmlGetAttributeEx(pixnNode, L"LogPathVariable", &pPackage->sczLogPathVariable);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @LogPathVariable.");
-        }
-
-        // @RollbackLogPathVariable
-        hr = XmlGetAttributeEx(pixnNode, L"RollbackLogPathVariable", &pPackage->sczRollbackLogPathVariable);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @RollbackLogPathVariable.");
-        }
-
-        // @InstallCondition
-        hr = XmlGetAttributeEx(pixnNode, L"InstallCondition", &pPackage->sczInstallCondition);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @InstallCondition.");
-        }
-
-        // @RollbackBoundaryForward
-        hr = XmlGetAttributeEx(pixnNode, L"RollbackBoundaryForward", &scz);
-        if (E_NOTFOUND != hr)
+        hr = XmlReaderNextElement(pReader, dwChainDepth, &wzElement);
+        if (S_FALSE == hr)
         {
-            ExitOnFailure(hr, "Failed to get @RollbackBoundaryForward.");
-
-            hr =  FindRollbackBoundaryById(pPackages, scz, &pPackage->pRollbackBoundaryForward);
-            ExitOnFailure(hr, "Failed to find forward transaction boundary: %ls", scz);
+            break;
         }
+        ExitOnFailure(hr, "Failed to read next chain element.");
 
-        // @RollbackBoundaryBackward
-        hr = XmlGetAttributeEx(pixnNode, L"RollbackBoundaryBackward", &scz);
-        if (E_NOTFOUND != hr)
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"ExePackage", -1))
         {
-            ExitOnFailure(hr, "Failed to get @RollbackBoundaryBackward.");
-
-            hr =  FindRollbackBoundaryById(pPackages, scz, &pPackage->pRollbackBoundaryBackward);
-            ExitOnFailure(hr, "Failed to find backward transaction boundary: %ls", scz);
+            type = BURN_PACKAGE_TYPE_EXE;
         }
-
-        // read type specific attributes
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"ExePackage", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsiPackage", -1))
         {
-            pPackage->type = BURN_PACKAGE_TYPE_EXE;
-
-            hr = ExeEngineParsePackageFromXml(pixnNode, pPackage); // TODO: Modularization
-            ExitOnFailure(hr, "Failed to parse EXE package.");
+            type = BURN_PACKAGE_TYPE_MSI;
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"MsiPackage", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MspPackage", -1))
         {
-            pPackage->type = BURN_PACKAGE_TYPE_MSI;
-
-            hr = MsiEngineParsePackageFromXml(pixnNode, pPackage); // TODO: Modularization
-            ExitOnFailure(hr, "Failed to parse MSI package.");
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"MspPackage", -1))
-        {
-            pPackage->type = BURN_PACKAGE_TYPE_MSP;
-
-            hr = MspEngineParsePackageFromXml(pixnNode, pPackage); // TODO: Modularization
-            ExitOnFailure(hr, "Failed to parse MSP package.");
-
+            type = BURN_PACKAGE_TYPE_MSP;
             ++cMspPackages;
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"MsuPackage", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"MsuPackage", -1))
         {
-            pPackage->type = BURN_PACKAGE_TYPE_MSU;
-
-            hr = MsuEngineParsePackageFromXml(pixnNode, pPackage); // TODO: Modularization
-            ExitOnFailure(hr, "Failed to parse MSU package.");
+            type = BURN_PACKAGE_TYPE_MSU;
         }
         else
         {
             // ignore other package types for now
+            continue;
         }
 
-        // parse payload references
-        hr = ParsePayloadRefsFromXml(pPackage, pPayloads, pixnNode);
-        ExitOnFailure(hr, "Failed to parse payload references.");
-
-        // parse dependency providers
-        hr = DependencyParseProvidersFromXml(pPackage, pixnNode);
-        ExitOnFailure(hr, "Failed to parse dependency providers.");
-
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
-        ReleaseNullBSTR(bstrNodeName);
+        hr = ParsePackageFromXml(pPackages, pPayloads, pReader, type);
+        ExitOnFailure(hr, "Failed to parse package.");
     }
 
     if (cMspPackages)
@@ -294,17 +117,72 @@ extern "C" HRESULT PackagesParseFromXml(
 
     AssertSz(pPackages->cPatchInfo == cMspPackages, "Count of packages patch info should be equal to the number of MSP packages.");
 
-    hr = ParsePatchTargetCode(pPackages, pixnBundle);
-    ExitOnFailure(hr, "Failed to parse target product codes.");
-
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseBSTR(bstrNodeName);
-    ReleaseStr(scz);
+    return hr;
+}
+
+extern "C" HRESULT PackagesParseRollbackBoundaryFromXml(
+    __in BURN_PACKAGES* pPackages,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    BURN_ROLLBACK_BOUNDARY* pRollbackBoundary = NULL;
+
+    // allocate memory for the rollback boundary
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackages->rgRollbackBoundaries), pPackages->cRollbackBoundaries + 1, sizeof(BURN_ROLLBACK_BOUNDARY), 5);
+    ExitOnFailure(hr, "Failed to allocate memory for rollback boundary structs.");
+
+    pRollbackBoundary = &pPackages->rgRollbackBoundaries[pPackages->cRollbackBoundaries];
+    ++pPackages->cRollbackBoundaries;
+
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pRollbackBoundary->sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
+
+    // @Vital
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Vital", &pRollbackBoundary->fVital);
+    ExitOnFailure(hr, "Failed to get @Vital.");
 
+    // @Transaction
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Transaction", &pRollbackBoundary->fTransaction);
+    ExitOnFailure(hr, "Failed to get @Transaction.");
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT PackagesParsePatchTargetCodeFromXml(
+    __in BURN_PACKAGES* pPackages,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    BURN_PATCH_TARGETCODE* pTargetCode = NULL;
+    BOOL fProduct = FALSE;
+
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackages->rgPatchTargetCodes), pPackages->cPatchTargetCodes + 1, sizeof(BURN_PATCH_TARGETCODE), 5);
+    ExitOnFailure(hr, "Failed to allocate memory for patch targetcodes.");
+
+    pTargetCode = pPackages->rgPatchTargetCodes + pPackages->cPatchTargetCodes;
+    ++pPackages->cPatchTargetCodes;
+
+    hr = XmlReaderGetAttribute(pReader, L"TargetCode", &pTargetCode->sczTargetCode);
+    ExitOnFailure(hr, "Failed to get @TargetCode attribute.");
+
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Product", &fProduct);
+    if (E_NOTFOUND == hr)
+    {
+        fProduct = FALSE;
+        hr = S_OK;
+    }
+    ExitOnFailure(hr, "Failed to get @Product.");
+
+    pTargetCode->type = fProduct ? BURN_PATCH_TARGETCODE_TYPE_PRODUCT : BURN_PATCH_TARGETCODE_TYPE_UPGRADE;
+
+LExit:
     return hr;
 }
 
@@ -529,125 +407,217 @@ LExit:
 
 // internal function declarations
 
-static HRESULT ParsePayloadRefsFromXml(
-    __in BURN_PACKAGE* pPackage,
+static HRESULT ParsePackageFromXml(
+    __in BURN_PACKAGES* pPackages,
     __in BURN_PAYLOADS* pPayloads,
-    __in IXMLDOMNode* pixnPackage
+    __in XML_READER* pReader,
+    __in BURN_PACKAGE_TYPE type
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    LPWSTR sczId = NULL;
+    BURN_PACKAGE* pPackage = NULL;
+    DWORD dwPackageDepth = pReader->dwDepth;
+    LPCWSTR wzElement = NULL;
+    LPWSTR scz = NULL;
 
-    // select package nodes
-    hr = XmlSelectNodes(pixnPackage, L"PayloadRef", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select package nodes.");
+    // allocate memory for the package, growing geometrically since chains can be long
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackages->rgPackages), pPackages->cPackages + 1, sizeof(BURN_PACKAGE), pPackages->cPackages);
+    ExitOnFailure(hr, "Failed to allocate memory for package structs.");
 
-    // get package node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get package node count.");
+    pPackage = &pPackages->rgPackages[pPackages->cPackages];
+    ++pPackages->cPackages;
 
-    if (!cNodes)
+    pPackage->type = type;
+
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pPackage->sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
+
+    // @Cache
+    hr = XmlReaderGetAttribute(pReader, L"Cache", &scz);
+    if (SUCCEEDED(hr))
     {
-        ExitFunction1(hr = S_OK);
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"no", -1))
+        {
+            pPackage->cacheType = BURN_CACHE_TYPE_NO;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"yes", -1))
+        {
+            pPackage->cacheType = BURN_CACHE_TYPE_YES;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"always", -1))
+        {
+            pPackage->cacheType = BURN_CACHE_TYPE_ALWAYS;
+        }
+        else
+        {
+            hr = E_UNEXPECTED;
+            ExitOnFailure(hr, "Invalid cache type: %ls", scz);
+        }
     }
+    ExitOnFailure(hr, "Failed to get @Cache.");
 
-    // allocate memory for payload pointers
-    pPackage->rgPayloads = (BURN_PACKAGE_PAYLOAD*)MemAlloc(sizeof(BURN_PACKAGE_PAYLOAD) * cNodes, TRUE);
-    ExitOnNull(pPackage->rgPayloads, hr, E_OUTOFMEMORY, "Failed to allocate memory for package payloads.");
+    // @CacheId
+    hr = XmlReaderGetAttribute(pReader, L"CacheId", &pPackage->sczCacheId);
+    ExitOnFailure(hr, "Failed to get @CacheId.");
 
-    pPackage->cPayloads = cNodes;
+    // @Size
+    hr = XmlReaderGetAttributeLargeNumber(pReader, L"Size", &pPackage->qwSize);
+    ExitOnFailure(hr, "Failed to get @Size.");
 
-    // parse package elements
-    for (DWORD i = 0; i < cNodes; ++i)
+    // @InstallSize
+    hr = XmlReaderGetAttributeLargeNumber(pReader, L"InstallSize", &pPackage->qwInstallSize);
+    ExitOnFailure(hr, "Failed to get @InstallSize.");
+
+    // @PerMachine
+    hr = XmlReaderGetYesNoAttribute(pReader, L"PerMachine", &pPackage->fPerMachine);
+    ExitOnFailure(hr, "Failed to get @PerMachine.");
+
+    // @Permanent
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Permanent", &pPackage->fUninstallable);
+    ExitOnFailure(hr, "Failed to get @Permanent.");
+    pPackage->fUninstallable = !pPackage->fUninstallable; // TODO: change "Uninstallable" variable name to permanent, until then Uninstallable is the opposite of Permanent so fix the variable.
+
+    // @Vital
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Vital", &pPackage->fVital);
+    ExitOnFailure(hr, "Failed to get @Vital.");
+
+    // @LogPathVariable
+    hr = XmlReaderGetAttribute(pReader, L"LogPathVariable", &pPackage->sczLogPathVariable);
+    if (E_NOTFOUND != hr)
     {
-        BURN_PACKAGE_PAYLOAD* pPackagePayload = &pPackage->rgPayloads[i];
+        ExitOnFailure(hr, "Failed to get @LogPathVariable.");
+    }
 
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
+    // @RollbackLogPathVariable
+    hr = XmlReaderGetAttribute(pReader, L"RollbackLogPathVariable", &pPackage->sczRollbackLogPathVariable);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @RollbackLogPathVariable.");
+    }
 
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &sczId);
-        ExitOnFailure(hr, "Failed to get Id attribute.");
+    // @InstallCondition
+    hr = XmlReaderGetAttribute(pReader, L"InstallCondition", &pPackage->sczInstallCondition);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @InstallCondition.");
+    }
 
-        // find payload
-        hr = PayloadFindById(pPayloads, sczId, &pPackagePayload->pPayload);
-        ExitOnFailure(hr, "Failed to find payload.");
+    // @RollbackBoundaryForward
+    hr = XmlReaderGetAttribute(pReader, L"RollbackBoundaryForward", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @RollbackBoundaryForward.");
 
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
+        hr =  FindRollbackBoundaryById(pPackages, scz, &pPackage->pRollbackBoundaryForward);
+        ExitOnFailure(hr, "Failed to find forward transaction boundary: %ls", scz);
     }
 
-    hr = S_OK;
+    // @RollbackBoundaryBackward
+    hr = XmlReaderGetAttribute(pReader, L"RollbackBoundaryBackward", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @RollbackBoundaryBackward.");
 
-LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseStr(sczId);
+        hr =  FindRollbackBoundaryById(pPackages, scz, &pPackage->pRollbackBoundaryBackward);
+        ExitOnFailure(hr, "Failed to find backward transaction boundary: %ls", scz);
+    }
 
-    return hr;
-}
+    // read type specific attributes, these must be read before moving to the child elements
+    switch (type)
+    {
+    case BURN_PACKAGE_TYPE_EXE:
+        hr = ExeEngineParsePackageFromXml(pReader, pPackage); // TODO: Modularization
+        ExitOnFailure(hr, "Failed to parse EXE package.");
+        break;
 
-static HRESULT ParsePatchTargetCode(
-    __in BURN_PACKAGES* pPackages,
-    __in IXMLDOMNode* pixnBundle
-    )
-{
-    HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    BSTR bstrNodeText = NULL;
-    BOOL fProduct;
+    case BURN_PACKAGE_TYPE_MSI:
+        hr = MsiEngineParsePackageFromXml(pReader, pPackage); // TODO: Modularization
+        ExitOnFailure(hr, "Failed to parse MSI package.");
+        break;
 
-    hr = XmlSelectNodes(pixnBundle, L"PatchTargetCode", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select PatchTargetCode nodes.");
+    case BURN_PACKAGE_TYPE_MSP:
+        hr = MspEngineParsePackageFromXml(pReader, pPackage); // TODO: Modularization
+        ExitOnFailure(hr, "Failed to parse MSP package.");
+        break;
 
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get PatchTargetCode node count.");
+    case BURN_PACKAGE_TYPE_MSU:
+        hr = MsuEngineParsePackageFromXml(pReader, pPackage); // TODO: Modularization
+        ExitOnFailure(hr, "Failed to parse MSU package.");
+        break;
+    }
 
-    if (!cNodes)
+    // parse child elements
+    for (;;)
     {
-        ExitFunction1(hr = S_OK);
+        hr = XmlReaderNextElement(pReader, dwPackageDepth, &wzElement);
+        if (S_FALSE == hr)
+        {
+            break;
+        }
+        ExitOnFailure(hr, "Failed to read next package element.");
+
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"PayloadRef", -1))
+        {
+            hr = ParsePayloadRefFromXml(pPackage, pPayloads, pReader);
+            ExitOnFailure(hr, "Failed to parse payload reference.");
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Provides", -1))
+        {
+            hr = DependencyParseProviderFromXml(pPackage, pReader);
+            ExitOnFailure(hr, "Failed to parse dependency provider.");
+        }
+        else if (BURN_PACKAGE_TYPE_EXE == type)
+        {
+            hr = ExeEngineParsePackageChildFromXml(pReader, pPackage);
+            ExitOnFailure(hr, "Failed to parse EXE package element: %ls", wzElement);
+        }
+        else if (BURN_PACKAGE_TYPE_MSI == type)
+        {
+            hr = MsiEngineParsePackageChildFromXml(pReader, pPackage);
+            ExitOnFailure(hr, "Failed to parse MSI package element: %ls", wzElement);
+        }
+        else if (BURN_PACKAGE_TYPE_MSP == type)
+        {
+            hr = MspEngineParsePackageChildFromXml(pReader, pPackage);
+            ExitOnFailure(hr, "Failed to parse MSP package element: %ls", wzElement);
+        }
     }
 
-    pPackages->rgPatchTargetCodes = (BURN_PATCH_TARGETCODE*)MemAlloc(sizeof(BURN_PATCH_TARGETCODE) * cNodes, TRUE);
-    ExitOnNull(pPackages->rgPatchTargetCodes, hr, E_OUTOFMEMORY, "Failed to allocate memory for patch targetcodes.");
+    hr = S_OK;
 
-    pPackages->cPatchTargetCodes = cNodes;
+LExit:
+    ReleaseStr(scz);
 
-    for (DWORD i = 0; i < cNodes; ++i)
-    {
-        BURN_PATCH_TARGETCODE* pTargetCode = pPackages->rgPatchTargetCodes + i;
+    return hr;
+}
 
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
+static HRESULT ParsePayloadRefFromXml(
+    __in BURN_PACKAGE* pPackage,
+    __in BURN_PAYLOADS* pPayloads,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzId = NULL;
+    BURN_PACKAGE_PAYLOAD* pPackagePayload = NULL;
 
-        hr = XmlGetAttributeEx(pixnNode, L"TargetCode", &pTargetCode->sczTargetCode);
-        ExitOnFailure(hr, "Failed to get @TargetCode attribute.");
+    // allocate memory for the payload pointer
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackage->rgPayloads), pPackage->cPayloads + 1, sizeof(BURN_PACKAGE_PAYLOAD), 5);
+    ExitOnFailure(hr, "Failed to allocate memory for package payloads.");
 
-        hr = XmlGetYesNoAttribute(pixnNode, L"Product", &fProduct);
-        if (E_NOTFOUND == hr)
-        {
-            fProduct = FALSE;
-            hr = S_OK;
-        }
-        ExitOnFailure(hr, "Failed to get @Product.");
+    pPackagePayload = &pPackage->rgPayloads[pPackage->cPayloads];
+    ++pPackage->cPayloads;
 
-        pTargetCode->type = fProduct ? BURN_PATCH_TARGETCODE_TYPE_PRODUCT : BURN_PATCH_TARGETCODE_TYPE_UPGRADE;
+    // @Id
+    hr = XmlReaderGetAttributeValue(pReader, L"Id", &wzId);
+    ExitOnFailure(hr, "Failed to get Id attribute.");
 
-        // prepare next iteration
-        ReleaseNullBSTR(bstrNodeText);
-        ReleaseNullObject(pixnNode);
-    }
+    // find payload
+    hr = PayloadFindById(pPayloads, wzId, &pPackagePayload->pPayload);
+    ExitOnFailure(hr, "Failed to find payload.");
 
 LExit:
-    ReleaseBSTR(bstrNodeText);
-    ReleaseObject(pixnNode);
-    ReleaseObject(pixnNodes);
-
     return hr;
 }
 
@@ -303,7 +303,15 @@ typedef struct _BURN_PACKAGES
 HRESULT PackagesParseFromXml(
     __in BURN_PACKAGES* pPackages,
     __in BURN_PAYLOADS* pPayloads,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
+    );
+HRESULT PackagesParseRollbackBoundaryFromXml(
+    __in BURN_PACKAGES* pPackages,
+    __in XML_READER* pReader
+    );
+HRESULT PackagesParsePatchTargetCodeFromXml(
+    __in BURN_PACKAGES* pPackages,
+    __in XML_READER* pReader
     );
 void PackageUninitialize(
     __in BURN_PACKAGE* pPackage
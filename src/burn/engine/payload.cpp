@@ -15,167 +15,154 @@ static HRESULT FindEmbeddedBySourcePath(
 
 // function definitions
 
-extern "C" HRESULT PayloadsParseFromXml(
+extern "C" HRESULT PayloadParseFromXml(
     __in BURN_PAYLOADS* pPayloads,
     __in_opt BURN_CONTAINERS* pContainers,
     __in_opt BURN_CATALOGS* pCatalogs,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
     LPWSTR scz = NULL;
+    BURN_PAYLOAD* pPayload = NULL;
+
+    // allocate memory for the payload
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPayloads->rgPayloads), pPayloads->cPayloads + 1, sizeof(BURN_PAYLOAD), pPayloads->cPayloads);
+    ExitOnFailure(hr, "Failed to allocate memory for payload structs.");
 
-    // select payload nodes
-    hr = XmlSelectNodes(pixnBundle, L"Payload", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select payload nodes.");
+    pPayload = &pPayloads->rgPayloads[pPayloads->cPayloads];
+    ++pPayloads->cPayloads;
 
-    // get payload node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get payload node count.");
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pPayload->sczKey);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-    if (!cNodes)
+    // index the payload by id, the first payload with a given id wins just like the linear search did
+    if (!pPayloads->sdPayloads)
     {
-        ExitFunction();
+        hr = DictCreateWithEmbeddedKey(&pPayloads->sdPayloads, 0, reinterpret_cast<void**>(&pPayloads->rgPayloads), offsetof(BURN_PAYLOAD, sczKey), DICT_FLAG_NONE);
+        ExitOnFailure(hr, "Failed to create payload dictionary.");
     }
 
-    // allocate memory for payloads
-    pPayloads->rgPayloads = (BURN_PAYLOAD*)MemAlloc(sizeof(BURN_PAYLOAD) * cNodes, TRUE);
-    ExitOnNull(pPayloads->rgPayloads, hr, E_OUTOFMEMORY, "Failed to allocate memory for payload structs.");
-
-    pPayloads->cPayloads = cNodes;
-
-    // parse search elements
-    for (DWORD i = 0; i < cNodes; ++i)
+    hr = DictKeyExists(pPayloads->sdPayloads, pPayload->sczKey);
+    if (E_NOTFOUND == hr)
     {
-        BURN_PAYLOAD* pPayload = &pPayloads->rgPayloads[i];
-
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
-
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &pPayload->sczKey);
-        ExitOnFailure(hr, "Failed to get @Id.");
+        hr = DictAddValue(pPayloads->sdPayloads, pPayload);
+        ExitOnFailure(hr, "Failed to add payload to dictionary: %ls", pPayload->sczKey);
+    }
+    ExitOnFailure(hr, "Failed to check payload dictionary for: %ls", pPayload->sczKey);
 
-        // @FilePath
-        hr = XmlGetAttributeEx(pixnNode, L"FilePath", &pPayload->sczFilePath);
-        ExitOnFailure(hr, "Failed to get @FilePath.");
+    // @FilePath
+    hr = XmlReaderGetAttribute(pReader, L"FilePath", &pPayload->sczFilePath);
+    ExitOnFailure(hr, "Failed to get @FilePath.");
 
-        // @Packaging
-        hr = XmlGetAttributeEx(pixnNode, L"Packaging", &scz);
-        ExitOnFailure(hr, "Failed to get @Packaging.");
+    // @Packaging
+    hr = XmlReaderGetAttribute(pReader, L"Packaging", &scz);
+    ExitOnFailure(hr, "Failed to get @Packaging.");
 
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"download", -1))
-        {
-            pPayload->packaging = BURN_PAYLOAD_PACKAGING_DOWNLOAD;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"embedded", -1))
-        {
-            pPayload->packaging = BURN_PAYLOAD_PACKAGING_EMBEDDED;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"external", -1))
-        {
-            pPayload->packaging = BURN_PAYLOAD_PACKAGING_EXTERNAL;
-        }
-        else
-        {
-            hr = E_INVALIDARG;
-            ExitOnFailure(hr, "Invalid value for @Packaging: %ls", scz);
-        }
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"download", -1))
+    {
+        pPayload->packaging = BURN_PAYLOAD_PACKAGING_DOWNLOAD;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"embedded", -1))
+    {
+        pPayload->packaging = BURN_PAYLOAD_PACKAGING_EMBEDDED;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"external", -1))
+    {
+        pPayload->packaging = BURN_PAYLOAD_PACKAGING_EXTERNAL;
+    }
+    else
+    {
+        hr = E_INVALIDARG;
+        ExitOnFailure(hr, "Invalid value for @Packaging: %ls", scz);
+    }
 
-        // @Container
-        if (pContainers)
+    // @Container
+    if (pContainers)
+    {
+        hr = XmlReaderGetAttribute(pReader, L"Container", &scz);
+        if (E_NOTFOUND != hr || BURN_PAYLOAD_PACKAGING_EMBEDDED == pPayload->packaging)
         {
-            hr = XmlGetAttributeEx(pixnNode, L"Container", &scz);
-            if (E_NOTFOUND != hr || BURN_PAYLOAD_PACKAGING_EMBEDDED == pPayload->packaging)
-            {
-                ExitOnFailure(hr, "Failed to get @Container.");
+            ExitOnFailure(hr, "Failed to get @Container.");
 
-                // find container
-                hr = ContainerFindById(pContainers, scz, &pPayload->pContainer);
-                ExitOnFailure(hr, "Failed to to find container: %ls", scz);
-            }
-        }
-
-        // @LayoutOnly
-        hr = XmlGetYesNoAttribute(pixnNode, L"LayoutOnly", &pPayload->fLayoutOnly);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @LayoutOnly.");
+            // find container
+            hr = ContainerFindById(pContainers, scz, &pPayload->pContainer);
+            ExitOnFailure(hr, "Failed to to find container: %ls", scz);
         }
+    }
 
-        // @SourcePath
-        hr = XmlGetAttributeEx(pixnNode, L"SourcePath", &pPayload->sczSourcePath);
-        if (E_NOTFOUND != hr || BURN_PAYLOAD_PACKAGING_DOWNLOAD != pPayload->packaging)
-        {
-            ExitOnFailure(hr, "Failed to get @SourcePath.");
-        }
+    // @LayoutOnly
+    hr = XmlReaderGetYesNoAttribute(pReader, L"LayoutOnly", &pPayload->fLayoutOnly);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @LayoutOnly.");
+    }
 
-        // @DownloadUrl
-        hr = XmlGetAttributeEx(pixnNode, L"DownloadUrl", &pPayload->downloadSource.sczUrl);
-        if (E_NOTFOUND != hr || BURN_PAYLOAD_PACKAGING_DOWNLOAD == pPayload->packaging)
-        {
-            ExitOnFailure(hr, "Failed to get @DownloadUrl.");
-        }
+    // @SourcePath
+    hr = XmlReaderGetAttribute(pReader, L"SourcePath", &pPayload->sczSourcePath);
+    if (E_NOTFOUND != hr || BURN_PAYLOAD_PACKAGING_DOWNLOAD != pPayload->packaging)
+    {
+        ExitOnFailure(hr, "Failed to get @SourcePath.");
+    }
 
-        // @FileSize
-        hr = XmlGetAttributeEx(pixnNode, L"FileSize", &scz);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @FileSize.");
+    // @DownloadUrl
+    hr = XmlReaderGetAttribute(pReader, L"DownloadUrl", &pPayload->downloadSource.sczUrl);
+    if (E_NOTFOUND != hr || BURN_PAYLOAD_PACKAGING_DOWNLOAD == pPayload->packaging)
+    {
+        ExitOnFailure(hr, "Failed to get @DownloadUrl.");
+    }
 
-            hr = StrStringToUInt64(scz, 0, &pPayload->qwFileSize);
-            ExitOnFailure(hr, "Failed to parse @FileSize.");
-        }
+    // @FileSize
+    hr = XmlReaderGetAttribute(pReader, L"FileSize", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @FileSize.");
 
-        // @CertificateAuthorityKeyIdentifier
-        hr = XmlGetAttributeEx(pixnNode, L"CertificateRootPublicKeyIdentifier", &scz);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @CertificateRootPublicKeyIdentifier.");
+        hr = StrStringToUInt64(scz, 0, &pPayload->qwFileSize);
+        ExitOnFailure(hr, "Failed to parse @FileSize.");
+    }
 
-            hr = StrAllocHexDecode(scz, &pPayload->pbCertificateRootPublicKeyIdentifier, &pPayload->cbCertificateRootPublicKeyIdentifier);
-            ExitOnFailure(hr, "Failed to hex decode @CertificateRootPublicKeyIdentifier.");
-        }
+    // @CertificateAuthorityKeyIdentifier
+    hr = XmlReaderGetAttribute(pReader, L"CertificateRootPublicKeyIdentifier", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @CertificateRootPublicKeyIdentifier.");
 
-        // @CertificateThumbprint
-        hr = XmlGetAttributeEx(pixnNode, L"CertificateRootThumbprint", &scz);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @CertificateRootThumbprint.");
+        hr = StrAllocHexDecode(scz, &pPayload->pbCertificateRootPublicKeyIdentifier, &pPayload->cbCertificateRootPublicKeyIdentifier);
+        ExitOnFailure(hr, "Failed to hex decode @CertificateRootPublicKeyIdentifier.");
+    }
 
-            hr = StrAllocHexDecode(scz, &pPayload->pbCertificateRootThumbprint, &pPayload->cbCertificateRootThumbprint);
-            ExitOnFailure(hr, "Failed to hex decode @CertificateRootThumbprint.");
-        }
+    // @CertificateThumbprint
+    hr = XmlReaderGetAttribute(pReader, L"CertificateRootThumbprint", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @CertificateRootThumbprint.");
 
-        // @Hash
-        hr = XmlGetAttributeEx(pixnNode, L"Hash", &scz);
-        ExitOnFailure(hr, "Failed to get @Hash.");
+        hr = StrAllocHexDecode(scz, &pPayload->pbCertificateRootThumbprint, &pPayload->cbCertificateRootThumbprint);
+        ExitOnFailure(hr, "Failed to hex decode @CertificateRootThumbprint.");
+    }
 
-        hr = StrAllocHexDecode(scz, &pPayload->pbHash, &pPayload->cbHash);
-        ExitOnFailure(hr, "Failed to hex decode the Payload/@Hash.");
+    // @Hash
+    hr = XmlReaderGetAttribute(pReader, L"Hash", &scz);
+    ExitOnFailure(hr, "Failed to get @Hash.");
 
-        // @Catalog
-        hr = XmlGetAttributeEx(pixnNode, L"Catalog", &scz);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @Catalog.");
+    hr = StrAllocHexDecode(scz, &pPayload->pbHash, &pPayload->cbHash);
+    ExitOnFailure(hr, "Failed to hex decode the Payload/@Hash.");
 
-            hr = CatalogFindById(pCatalogs, scz, &pPayload->pCatalog);
-            ExitOnFailure(hr, "Failed to find catalog.");
-        }
+    // @Catalog
+    hr = XmlReaderGetAttribute(pReader, L"Catalog", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Catalog.");
 
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
+        hr = CatalogFindById(pCatalogs, scz, &pPayload->pCatalog);
+        ExitOnFailure(hr, "Failed to find catalog.");
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
     ReleaseStr(scz);
 
     return hr;
@@ -205,6 +192,8 @@ extern "C" void PayloadsUninitialize(
         MemFree(pPayloads->rgPayloads);
     }
 
+    ReleaseDict(pPayloads->sdPayloads);
+
     // clear struct
     memset(pPayloads, 0, sizeof(BURN_PAYLOADS));
 }
@@ -288,6 +277,12 @@ extern "C" HRESULT PayloadFindById(
     HRESULT hr = S_OK;
     BURN_PAYLOAD* pPayload = NULL;
 
+    if (pPayloads->sdPayloads)
+    {
+        hr = DictGetValue(pPayloads->sdPayloads, wzId, reinterpret_cast<void**>(ppPayload));
+        ExitFunction();
+    }
+
     for (DWORD i = 0; i < pPayloads->cPayloads; ++i)
     {
         pPayload = &pPayloads->rgPayloads[i];
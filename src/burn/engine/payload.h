@@ -56,16 +56,18 @@ typedef struct _BURN_PAYLOADS
 {
     BURN_PAYLOAD* rgPayloads;
     DWORD cPayloads;
+
+    STRINGDICT_HANDLE sdPayloads; // payloads indexed by @Id, built while parsing the manifest
 } BURN_PAYLOADS;
 
 
 // functions
 
-HRESULT PayloadsParseFromXml(
+HRESULT PayloadParseFromXml(
     __in BURN_PAYLOADS* pPayloads,
     __in_opt BURN_CONTAINERS* pContainers,
     __in_opt BURN_CATALOGS* pCatalogs,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 void PayloadsUninitialize(
     __in BURN_PAYLOADS* pPayloads
@@ -50,6 +50,7 @@
 #include <wiutil.h>
 #include <wuautil.h>
 #include <xmlutil.h>
+#include <xmlreaderutil.h>
 #include <dictutil.h>
 #include <deputil.h>
 #include <dlutil.h>
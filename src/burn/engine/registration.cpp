@@ -34,10 +34,18 @@ const LPCWSTR REGISTRY_BUNDLE_VERSION_MINOR = L"VersionMinor";
 
 // internal function declarations
 
-static HRESULT ParseSoftwareTagsFromXml(
-    __in IXMLDOMNode* pixnRegistrationNode,
-    __out BURN_SOFTWARE_TAG** prgSoftwareTags,
-    __out DWORD* pcSoftwareTags
+static HRESULT ParseArpFromXml(
+    __in BURN_REGISTRATION* pRegistration,
+    __in XML_READER* pReader
+    );
+static HRESULT ParseSoftwareTagFromXml(
+    __in XML_READER* pReader,
+    __inout BURN_SOFTWARE_TAG** prgSoftwareTags,
+    __inout DWORD* pcSoftwareTags
+    );
+static HRESULT ParseUpdateRegistrationFromXml(
+    __in BURN_REGISTRATION* pRegistration,
+    __in XML_READER* pReader
     );
 static HRESULT SetPaths(
     __in BURN_REGISTRATION* pRegistration
@@ -58,10 +66,6 @@ static HRESULT UpdateResumeMode(
     __in BURN_RESUME_MODE resumeMode,
     __in BOOL fRestartInitiated
     );
-static HRESULT ParseRelatedCodes(
-    __in BURN_REGISTRATION* pRegistration,
-    __in IXMLDOMNode* pixnBundle
-    );
 static HRESULT FormatUpdateRegistrationKey(
     __in BURN_REGISTRATION* pRegistration,
     __out_z LPWSTR* psczKey
@@ -101,217 +105,134 @@ static HRESULT UpdateBundleNameRegistration(
 *******************************************************************/
 extern "C" HRESULT RegistrationParseFromXml(
     __in BURN_REGISTRATION* pRegistration,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNode* pixnRegistrationNode = NULL;
-    IXMLDOMNode* pixnArpNode = NULL;
-    IXMLDOMNode* pixnUpdateNode = NULL;
-    LPWSTR scz = NULL;
-
-    // select registration node
-    hr = XmlSelectSingleNode(pixnBundle, L"Registration", &pixnRegistrationNode);
-    if (S_FALSE == hr)
-    {
-        hr = E_NOTFOUND;
-    }
-    ExitOnFailure(hr, "Failed to select registration node.");
+    DWORD dwRegistrationDepth = pReader->dwDepth;
+    LPCWSTR wzElement = NULL;
+    LPCWSTR wzVersion = NULL;
 
     // @Id
-    hr = XmlGetAttributeEx(pixnRegistrationNode, L"Id", &pRegistration->sczId);
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pRegistration->sczId);
     ExitOnFailure(hr, "Failed to get @Id.");
 
     // @Tag
-    hr = XmlGetAttributeEx(pixnRegistrationNode, L"Tag", &pRegistration->sczTag);
+    hr = XmlReaderGetAttribute(pReader, L"Tag", &pRegistration->sczTag);
     ExitOnFailure(hr, "Failed to get @Tag.");
 
-    hr = ParseRelatedCodes(pRegistration, pixnBundle);
-    ExitOnFailure(hr, "Failed to parse related bundles");
-
     // @Version
-    hr = XmlGetAttributeEx(pixnRegistrationNode, L"Version", &scz);
+    hr = XmlReaderGetAttributeValue(pReader, L"Version", &wzVersion);
     ExitOnFailure(hr, "Failed to get @Version.");
 
-    hr = FileVersionFromStringEx(scz, 0, &pRegistration->qwVersion);
-    ExitOnFailure(hr, "Failed to parse @Version: %ls", scz);
+    hr = FileVersionFromStringEx(wzVersion, 0, &pRegistration->qwVersion);
+    ExitOnFailure(hr, "Failed to parse @Version: %ls", wzVersion);
 
     // @ProviderKey
-    hr = XmlGetAttributeEx(pixnRegistrationNode, L"ProviderKey", &pRegistration->sczProviderKey);
+    hr = XmlReaderGetAttribute(pReader, L"ProviderKey", &pRegistration->sczProviderKey);
     ExitOnFailure(hr, "Failed to get @ProviderKey.");
 
     // @ExecutableName
-    hr = XmlGetAttributeEx(pixnRegistrationNode, L"ExecutableName", &pRegistration->sczExecutableName);
+    hr = XmlReaderGetAttribute(pReader, L"ExecutableName", &pRegistration->sczExecutableName);
     ExitOnFailure(hr, "Failed to get @ExecutableName.");
 
     // @PerMachine
-    hr = XmlGetYesNoAttribute(pixnRegistrationNode, L"PerMachine", &pRegistration->fPerMachine);
+    hr = XmlReaderGetYesNoAttribute(pReader, L"PerMachine", &pRegistration->fPerMachine);
     ExitOnFailure(hr, "Failed to get @PerMachine.");
 
-    // select ARP node
-    hr = XmlSelectSingleNode(pixnRegistrationNode, L"Arp", &pixnArpNode);
-    if (S_FALSE != hr)
+    // parse child elements
+    for (;;)
     {
-        ExitOnFailure(hr, "Failed to select ARP node.");
-
-        // @Register
-        hr = XmlGetYesNoAttribute(pixnArpNode, L"Register", &pRegistration->fRegisterArp);
-        ExitOnFailure(hr, "Failed to get @Register.");
-
-        // @DisplayName
-        hr = XmlGetAttributeEx(pixnArpNode, L"DisplayName", &pRegistration->sczDisplayName);
-        if (E_NOTFOUND != hr)
+        hr = XmlReaderNextElement(pReader, dwRegistrationDepth, &wzElement);
+        if (S_FALSE == hr)
         {
-            ExitOnFailure(hr, "Failed to get @DisplayName.");
+            break;
         }
+        ExitOnFailure(hr, "Failed to read next registration element.");
 
-        // @DisplayVersion
-        hr = XmlGetAttributeEx(pixnArpNode, L"DisplayVersion", &pRegistration->sczDisplayVersion);
-        if (E_NOTFOUND != hr)
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Arp", -1))
         {
-            ExitOnFailure(hr, "Failed to get @DisplayVersion.");
+            hr = ParseArpFromXml(pRegistration, pReader);
+            ExitOnFailure(hr, "Failed to parse ARP registration.");
         }
-
-        // @Publisher
-        hr = XmlGetAttributeEx(pixnArpNode, L"Publisher", &pRegistration->sczPublisher);
-        if (E_NOTFOUND != hr)
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"SoftwareTag", -1))
         {
-            ExitOnFailure(hr, "Failed to get @Publisher.");
+            hr = ParseSoftwareTagFromXml(pReader, &pRegistration->softwareTags.rgSoftwareTags, &pRegistration->softwareTags.cSoftwareTags);
+            ExitOnFailure(hr, "Failed to parse software tag.");
         }
-
-        // @HelpLink
-        hr = XmlGetAttributeEx(pixnArpNode, L"HelpLink", &pRegistration->sczHelpLink);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @HelpLink.");
-        }
-
-        // @HelpTelephone
-        hr = XmlGetAttributeEx(pixnArpNode, L"HelpTelephone", &pRegistration->sczHelpTelephone);
-        if (E_NOTFOUND != hr)
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Update", -1))
         {
-            ExitOnFailure(hr, "Failed to get @HelpTelephone.");
+            hr = ParseUpdateRegistrationFromXml(pRegistration, pReader);
+            ExitOnFailure(hr, "Failed to parse update registration.");
         }
+    }
 
-        // @AboutUrl
-        hr = XmlGetAttributeEx(pixnArpNode, L"AboutUrl", &pRegistration->sczAboutUrl);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @AboutUrl.");
-        }
+    hr = SetPaths(pRegistration);
+    ExitOnFailure(hr, "Failed to set registration paths.");
 
-        // @UpdateUrl
-        hr = XmlGetAttributeEx(pixnArpNode, L"UpdateUrl", &pRegistration->sczUpdateUrl);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @UpdateUrl.");
-        }
+LExit:
+    return hr;
+}
 
-        // @ParentDisplayName
-        hr = XmlGetAttributeEx(pixnArpNode, L"ParentDisplayName", &pRegistration->sczParentDisplayName);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @ParentDisplayName.");
-        }
+extern "C" HRESULT RegistrationParseRelatedBundleFromXml(
+    __in BURN_REGISTRATION* pRegistration,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzAction = NULL;
+    LPWSTR sczId = NULL;
 
-        // @Comments
-        hr = XmlGetAttributeEx(pixnArpNode, L"Comments", &pRegistration->sczComments);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @Comments.");
-        }
+    hr = XmlReaderGetAttributeValue(pReader, L"Action", &wzAction);
+    ExitOnFailure(hr, "Failed to get @Action.");
 
-        // @Contact
-        hr = XmlGetAttributeEx(pixnArpNode, L"Contact", &pRegistration->sczContact);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @Contact.");
-        }
+    hr = XmlReaderGetAttribute(pReader, L"Id", &sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-        // @DisableModify
-        hr = XmlGetAttributeEx(pixnArpNode, L"DisableModify", &scz);
-        if (SUCCEEDED(hr))
-        {
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"button", -1))
-            {
-                pRegistration->modify = BURN_REGISTRATION_MODIFY_DISABLE_BUTTON;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"yes", -1))
-            {
-                pRegistration->modify = BURN_REGISTRATION_MODIFY_DISABLE;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"no", -1))
-            {
-                pRegistration->modify = BURN_REGISTRATION_MODIFY_ENABLED;
-            }
-            else
-            {
-                hr = E_UNEXPECTED;
-                ExitOnRootFailure(hr, "Invalid modify disabled type: %ls", scz);
-            }
-        }
-        else if (E_NOTFOUND == hr)
-        {
-            pRegistration->modify = BURN_REGISTRATION_MODIFY_ENABLED;
-            hr = S_OK;
-        }
-        ExitOnFailure(hr, "Failed to get @DisableModify.");
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzAction, -1, L"Detect", -1))
+    {
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczDetectCodes), pRegistration->cDetectCodes + 1, sizeof(LPWSTR), 5);
+        ExitOnFailure(hr, "Failed to resize Detect code array in registration");
 
-        // @DisableRemove
-        hr = XmlGetYesNoAttribute(pixnArpNode, L"DisableRemove", &pRegistration->fNoRemove);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @DisableRemove.");
-            pRegistration->fNoRemoveDefined = TRUE;
-        }
+        pRegistration->rgsczDetectCodes[pRegistration->cDetectCodes] = sczId;
+        sczId = NULL;
+        ++pRegistration->cDetectCodes;
     }
-
-    hr = ParseSoftwareTagsFromXml(pixnRegistrationNode, &pRegistration->softwareTags.rgSoftwareTags, &pRegistration->softwareTags.cSoftwareTags);
-    ExitOnFailure(hr, "Failed to parse software tag.");
-
-    // select Update node
-    hr = XmlSelectSingleNode(pixnRegistrationNode, L"Update", &pixnUpdateNode);
-    if (S_FALSE != hr)
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzAction, -1, L"Upgrade", -1))
     {
-        ExitOnFailure(hr, "Failed to select Update node.");
-
-        pRegistration->update.fRegisterUpdate = TRUE;
-
-        // @Manufacturer
-        hr = XmlGetAttributeEx(pixnUpdateNode, L"Manufacturer", &pRegistration->update.sczManufacturer);
-        ExitOnFailure(hr, "Failed to get @Manufacturer.");
-
-        // @Department
-        hr = XmlGetAttributeEx(pixnUpdateNode, L"Department", &pRegistration->update.sczDepartment);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @Department.");
-        }
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczUpgradeCodes), pRegistration->cUpgradeCodes + 1, sizeof(LPWSTR), 5);
+        ExitOnFailure(hr, "Failed to resize Upgrade code array in registration");
 
-        // @ProductFamily
-        hr = XmlGetAttributeEx(pixnUpdateNode, L"ProductFamily", &pRegistration->update.sczProductFamily);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get @ProductFamily.");
-        }
-
-        // @Name
-        hr = XmlGetAttributeEx(pixnUpdateNode, L"Name", &pRegistration->update.sczName);
-        ExitOnFailure(hr, "Failed to get @Name.");
+        pRegistration->rgsczUpgradeCodes[pRegistration->cUpgradeCodes] = sczId;
+        sczId = NULL;
+        ++pRegistration->cUpgradeCodes;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzAction, -1, L"Addon", -1))
+    {
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczAddonCodes), pRegistration->cAddonCodes + 1, sizeof(LPWSTR), 5);
+        ExitOnFailure(hr, "Failed to resize Addon code array in registration");
 
-        // @Classification
-        hr = XmlGetAttributeEx(pixnUpdateNode, L"Classification", &pRegistration->update.sczClassification);
-        ExitOnFailure(hr, "Failed to get @Classification.");
+        pRegistration->rgsczAddonCodes[pRegistration->cAddonCodes] = sczId;
+        sczId = NULL;
+        ++pRegistration->cAddonCodes;
     }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzAction, -1, L"Patch", -1))
+    {
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczPatchCodes), pRegistration->cPatchCodes + 1, sizeof(LPWSTR), 5);
+        ExitOnFailure(hr, "Failed to resize Patch code array in registration");
 
-    hr = SetPaths(pRegistration);
-    ExitOnFailure(hr, "Failed to set registration paths.");
+        pRegistration->rgsczPatchCodes[pRegistration->cPatchCodes] = sczId;
+        sczId = NULL;
+        ++pRegistration->cPatchCodes;
+    }
+    else
+    {
+        hr = E_INVALIDARG;
+        ExitOnFailure(hr, "Invalid value for @Action: %ls", wzAction);
+    }
 
 LExit:
-    ReleaseObject(pixnRegistrationNode);
-    ReleaseObject(pixnArpNode);
-    ReleaseObject(pixnUpdateNode);
-    ReleaseStr(scz);
+    ReleaseStr(sczId);
 
     return hr;
 }
@@ -1020,73 +941,204 @@ extern "C" HRESULT RegistrationGetResumeCommandLine(
 
 // internal helper functions
 
-static HRESULT ParseSoftwareTagsFromXml(
-    __in IXMLDOMNode* pixnRegistrationNode,
-    __out BURN_SOFTWARE_TAG** prgSoftwareTags,
-    __out DWORD* pcSoftwareTags
+static HRESULT ParseArpFromXml(
+    __in BURN_REGISTRATION* pRegistration,
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
+    LPCWSTR wzValue = NULL;
+
+    // @Register
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Register", &pRegistration->fRegisterArp);
+    ExitOnFailure(hr, "Failed to get @Register.");
 
-    BURN_SOFTWARE_TAG* pSoftwareTags = NULL;
-    BSTR bstrTagXml = NULL;
+    // @DisplayName
+    hr = XmlReaderGetAttribute(pReader, L"DisplayName", &pRegistration->sczDisplayName);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @DisplayName.");
+    }
 
-    // select tag nodes
-    hr = XmlSelectNodes(pixnRegistrationNode, L"SoftwareTag", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select software tag nodes.");
+    // @DisplayVersion
+    hr = XmlReaderGetAttribute(pReader, L"DisplayVersion", &pRegistration->sczDisplayVersion);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @DisplayVersion.");
+    }
 
-    // get tag node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get software tag count.");
+    // @Publisher
+    hr = XmlReaderGetAttribute(pReader, L"Publisher", &pRegistration->sczPublisher);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Publisher.");
+    }
 
-    if (cNodes)
+    // @HelpLink
+    hr = XmlReaderGetAttribute(pReader, L"HelpLink", &pRegistration->sczHelpLink);
+    if (E_NOTFOUND != hr)
     {
-        pSoftwareTags = (BURN_SOFTWARE_TAG*)MemAlloc(sizeof(BURN_SOFTWARE_TAG) * cNodes, TRUE);
-        ExitOnNull(pSoftwareTags, hr, E_OUTOFMEMORY, "Failed to allocate memory for software tag structs.");
+        ExitOnFailure(hr, "Failed to get @HelpLink.");
+    }
 
-        for (DWORD i = 0; i < cNodes; ++i)
-        {
-            BURN_SOFTWARE_TAG* pSoftwareTag = &pSoftwareTags[i];
+    // @HelpTelephone
+    hr = XmlReaderGetAttribute(pReader, L"HelpTelephone", &pRegistration->sczHelpTelephone);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @HelpTelephone.");
+    }
 
-            hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-            ExitOnFailure(hr, "Failed to get next node.");
+    // @AboutUrl
+    hr = XmlReaderGetAttribute(pReader, L"AboutUrl", &pRegistration->sczAboutUrl);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @AboutUrl.");
+    }
 
-            hr = XmlGetAttributeEx(pixnNode, L"Filename", &pSoftwareTag->sczFilename);
-            ExitOnFailure(hr, "Failed to get @Filename.");
+    // @UpdateUrl
+    hr = XmlReaderGetAttribute(pReader, L"UpdateUrl", &pRegistration->sczUpdateUrl);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @UpdateUrl.");
+    }
 
-            hr = XmlGetAttributeEx(pixnNode, L"Regid", &pSoftwareTag->sczRegid);
-            ExitOnFailure(hr, "Failed to get @Regid.");
+    // @ParentDisplayName
+    hr = XmlReaderGetAttribute(pReader, L"ParentDisplayName", &pRegistration->sczParentDisplayName);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @ParentDisplayName.");
+    }
 
-            hr = XmlGetText(pixnNode, &bstrTagXml);
-            ExitOnFailure(hr, "Failed to get SoftwareTag text.");
+    // @Comments
+    hr = XmlReaderGetAttribute(pReader, L"Comments", &pRegistration->sczComments);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Comments.");
+    }
 
-            hr = StrAnsiAllocString(&pSoftwareTag->sczTag, bstrTagXml, 0, CP_UTF8);
-            ExitOnFailure(hr, "Failed to convert SoftwareTag text to UTF-8");
+    // @Contact
+    hr = XmlReaderGetAttribute(pReader, L"Contact", &pRegistration->sczContact);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Contact.");
+    }
 
-            // prepare next iteration
-            ReleaseNullBSTR(bstrTagXml);
-            ReleaseNullObject(pixnNode);
+    // @DisableModify
+    hr = XmlReaderGetAttributeValue(pReader, L"DisableModify", &wzValue);
+    if (SUCCEEDED(hr))
+    {
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzValue, -1, L"button", -1))
+        {
+            pRegistration->modify = BURN_REGISTRATION_MODIFY_DISABLE_BUTTON;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzValue, -1, L"yes", -1))
+        {
+            pRegistration->modify = BURN_REGISTRATION_MODIFY_DISABLE;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzValue, -1, L"no", -1))
+        {
+            pRegistration->modify = BURN_REGISTRATION_MODIFY_ENABLED;
+        }
+        else
+        {
+            hr = E_UNEXPECTED;
+            ExitOnRootFailure(hr, "Invalid modify disabled type: %ls", wzValue);
         }
     }
+    else if (E_NOTFOUND == hr)
+    {
+        pRegistration->modify = BURN_REGISTRATION_MODIFY_ENABLED;
+        hr = S_OK;
+    }
+    ExitOnFailure(hr, "Failed to get @DisableModify.");
 
-    *pcSoftwareTags = cNodes;
-    *prgSoftwareTags = pSoftwareTags;
-    pSoftwareTags = NULL;
+    // @DisableRemove
+    hr = XmlReaderGetYesNoAttribute(pReader, L"DisableRemove", &pRegistration->fNoRemove);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @DisableRemove.");
+        pRegistration->fNoRemoveDefined = TRUE;
+    }
 
     hr = S_OK;
 
 LExit:
-    ReleaseBSTR(bstrTagXml);
-    ReleaseObject(pixnNode);
-    ReleaseObject(pixnNodes);
-    ReleaseMem(pSoftwareTags);
+    return hr;
+}
+
+static HRESULT ParseSoftwareTagFromXml(
+    __in XML_READER* pReader,
+    __inout BURN_SOFTWARE_TAG** prgSoftwareTags,
+    __inout DWORD* pcSoftwareTags
+    )
+{
+    HRESULT hr = S_OK;
+    BURN_SOFTWARE_TAG* pSoftwareTag = NULL;
+    LPWSTR sczTagXml = NULL;
+
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(prgSoftwareTags), *pcSoftwareTags + 1, sizeof(BURN_SOFTWARE_TAG), 1);
+    ExitOnFailure(hr, "Failed to allocate memory for software tag structs.");
+
+    pSoftwareTag = *prgSoftwareTags + *pcSoftwareTags;
+    ++(*pcSoftwareTags);
+
+    hr = XmlReaderGetAttribute(pReader, L"Filename", &pSoftwareTag->sczFilename);
+    ExitOnFailure(hr, "Failed to get @Filename.");
+
+    hr = XmlReaderGetAttribute(pReader, L"Regid", &pSoftwareTag->sczRegid);
+    ExitOnFailure(hr, "Failed to get @Regid.");
+
+    hr = XmlReaderReadElementText(pReader, &sczTagXml);
+    ExitOnFailure(hr, "Failed to get SoftwareTag text.");
+
+    hr = StrAnsiAllocString(&pSoftwareTag->sczTag, sczTagXml, 0, CP_UTF8);
+    ExitOnFailure(hr, "Failed to convert SoftwareTag text to UTF-8");
+
+LExit:
+    ReleaseStr(sczTagXml);
 
     return hr;
 }
 
+static HRESULT ParseUpdateRegistrationFromXml(
+    __in BURN_REGISTRATION* pRegistration,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+
+    pRegistration->update.fRegisterUpdate = TRUE;
+
+    // @Manufacturer
+    hr = XmlReaderGetAttribute(pReader, L"Manufacturer", &pRegistration->update.sczManufacturer);
+    ExitOnFailure(hr, "Failed to get @Manufacturer.");
+
+    // @Department
+    hr = XmlReaderGetAttribute(pReader, L"Department", &pRegistration->update.sczDepartment);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Department.");
+    }
+
+    // @ProductFamily
+    hr = XmlReaderGetAttribute(pReader, L"ProductFamily", &pRegistration->update.sczProductFamily);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @ProductFamily.");
+    }
+
+    // @Name
+    hr = XmlReaderGetAttribute(pReader, L"Name", &pRegistration->update.sczName);
+    ExitOnFailure(hr, "Failed to get @Name.");
+
+    // @Classification
+    hr = XmlReaderGetAttribute(pReader, L"Classification", &pRegistration->update.sczClassification);
+    ExitOnFailure(hr, "Failed to get @Classification.");
+
+LExit:
+    return hr;
+}
+
 static HRESULT SetPaths(
     __in BURN_REGISTRATION* pRegistration
     )
@@ -1267,87 +1319,6 @@ LExit:
     return hr;
 }
 
-static HRESULT ParseRelatedCodes(
-    __in BURN_REGISTRATION* pRegistration,
-    __in IXMLDOMNode* pixnBundle
-    )
-{
-    HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnElement = NULL;
-    LPWSTR sczAction = NULL;
-    LPWSTR sczId = NULL;
-    DWORD cElements = 0;
-
-    hr = XmlSelectNodes(pixnBundle, L"RelatedBundle", &pixnNodes);
-    ExitOnFailure(hr, "Failed to get RelatedBundle nodes");
-
-    hr = pixnNodes->get_length((long*)&cElements);
-    ExitOnFailure(hr, "Failed to get RelatedBundle element count.");
-
-    for (DWORD i = 0; i < cElements; ++i)
-    {
-        hr = XmlNextElement(pixnNodes, &pixnElement, NULL);
-        ExitOnFailure(hr, "Failed to get next RelatedBundle element.");
-
-        hr = XmlGetAttributeEx(pixnElement, L"Action", &sczAction);
-        ExitOnFailure(hr, "Failed to get @Action.");
-
-        hr = XmlGetAttributeEx(pixnElement, L"Id", &sczId);
-        ExitOnFailure(hr, "Failed to get @Id.");
-
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, sczAction, -1, L"Detect", -1))
-        {
-            hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczDetectCodes), pRegistration->cDetectCodes + 1, sizeof(LPWSTR), 5);
-            ExitOnFailure(hr, "Failed to resize Detect code array in registration");
-
-            pRegistration->rgsczDetectCodes[pRegistration->cDetectCodes] = sczId;
-            sczId = NULL;
-            ++pRegistration->cDetectCodes;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, sczAction, -1, L"Upgrade", -1))
-        {
-            hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczUpgradeCodes), pRegistration->cUpgradeCodes + 1, sizeof(LPWSTR), 5);
-            ExitOnFailure(hr, "Failed to resize Upgrade code array in registration");
-
-            pRegistration->rgsczUpgradeCodes[pRegistration->cUpgradeCodes] = sczId;
-            sczId = NULL;
-            ++pRegistration->cUpgradeCodes;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, sczAction, -1, L"Addon", -1))
-        {
-            hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczAddonCodes), pRegistration->cAddonCodes + 1, sizeof(LPWSTR), 5);
-            ExitOnFailure(hr, "Failed to resize Addon code array in registration");
-
-            pRegistration->rgsczAddonCodes[pRegistration->cAddonCodes] = sczId;
-            sczId = NULL;
-            ++pRegistration->cAddonCodes;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, sczAction, -1, L"Patch", -1))
-        {
-            hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pRegistration->rgsczPatchCodes), pRegistration->cPatchCodes + 1, sizeof(LPWSTR), 5);
-            ExitOnFailure(hr, "Failed to resize Patch code array in registration");
-
-            pRegistration->rgsczPatchCodes[pRegistration->cPatchCodes] = sczId;
-            sczId = NULL;
-            ++pRegistration->cPatchCodes;
-        }
-        else
-        {
-            hr = E_INVALIDARG;
-            ExitOnFailure(hr, "Invalid value for @Action: %ls", sczAction);
-        }
-    }
-
-LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnElement);
-    ReleaseStr(sczAction);
-    ReleaseStr(sczId);
-
-    return hr;
-}
-
 static HRESULT FormatUpdateRegistrationKey(
     __in BURN_REGISTRATION* pRegistration,
     __out_z LPWSTR* psczKey
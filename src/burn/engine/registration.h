@@ -154,7 +154,11 @@ typedef struct _BURN_REGISTRATION
 
 HRESULT RegistrationParseFromXml(
     __in BURN_REGISTRATION* pRegistration,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
+    );
+HRESULT RegistrationParseRelatedBundleFromXml(
+    __in BURN_REGISTRATION* pRegistration,
+    __in XML_READER* pReader
     );
 void RegistrationUninitialize(
     __in BURN_REGISTRATION* pRegistration
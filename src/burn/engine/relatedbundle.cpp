@@ -4,16 +4,27 @@
 
 // internal function declarations
 
+static HRESULT AddRelatedBundleCodes(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
+    __in_ecount(cCodes) LPWSTR* rgsczCodes,
+    __in DWORD cCodes,
+    __in BURN_RELATED_BUNDLE_CODE_TYPE type
+    );
+static DWORD MatchRelatedBundleCodes(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
+    __in_ecount(cCodes) LPWSTR* rgsczCodes,
+    __in DWORD cCodes
+    );
 static HRESULT LoadIfRelatedBundle(
     __in BOOL fPerMachine,
     __in HKEY hkUninstallKey,
     __in_z LPCWSTR sczRelatedBundleId,
-    __in BURN_REGISTRATION* pRegistration,
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
     __in BURN_RELATED_BUNDLES* pRelatedBundles
     );
 static HRESULT DetermineRelationType(
     __in HKEY hkBundleId,
-    __in BURN_REGISTRATION* pRegistration,
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
     __out BOOTSTRAPPER_RELATION_TYPE* pRelationType
     );
 static HRESULT LoadRelatedBundleFromKey(
@@ -37,6 +48,7 @@ extern "C" HRESULT RelatedBundlesInitializeForScope(
     HKEY hkRoot = fPerMachine ? HKEY_LOCAL_MACHINE : HKEY_CURRENT_USER;
     HKEY hkUninstallKey = NULL;
     LPWSTR sczRelatedBundleId = NULL;
+    BURN_RELATED_BUNDLE_CODES codes = { };
 
     hr = RegOpen(hkRoot, BURN_REGISTRATION_REGISTRY_UNINSTALL_KEY, KEY_READ, &hkUninstallKey);
     if (HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND) == hr || HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) == hr)
@@ -45,6 +57,9 @@ extern "C" HRESULT RelatedBundlesInitializeForScope(
     }
     ExitOnFailure(hr, "Failed to open uninstall registry key.");
 
+    hr = RelatedBundleCodesInitialize(pRegistration, &codes);
+    ExitOnFailure(hr, "Failed to index codes for related bundles.");
+
     for (DWORD dwIndex = 0; /* exit via break below */; ++dwIndex)
     {
         hr = RegKeyEnum(hkUninstallKey, dwIndex, &sczRelatedBundleId);
@@ -60,12 +75,13 @@ extern "C" HRESULT RelatedBundlesInitializeForScope(
         {
             // Ignore failures here since we'll often find products that aren't actually
             // related bundles (or even bundles at all).
-            HRESULT hrRelatedBundle = LoadIfRelatedBundle(fPerMachine, hkUninstallKey, sczRelatedBundleId, pRegistration, pRelatedBundles);
+            HRESULT hrRelatedBundle = LoadIfRelatedBundle(fPerMachine, hkUninstallKey, sczRelatedBundleId, &codes, pRelatedBundles);
             UNREFERENCED_PARAMETER(hrRelatedBundle);
         }
     }
 
 LExit:
+    RelatedBundleCodesUninitialize(&codes);
     ReleaseStr(sczRelatedBundleId);
     ReleaseRegKey(hkUninstallKey);
 
@@ -90,14 +106,188 @@ extern "C" void RelatedBundlesUninitialize(
     memset(pRelatedBundles, 0, sizeof(BURN_RELATED_BUNDLES));
 }
 
+extern "C" HRESULT RelatedBundleCodesInitialize(
+    __in BURN_REGISTRATION* pRegistration,
+    __in BURN_RELATED_BUNDLE_CODES* pCodes
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD cMaxCodes = pRegistration->cUpgradeCodes + pRegistration->cAddonCodes + pRegistration->cDetectCodes + pRegistration->cPatchCodes;
+
+    memset(pCodes, 0, sizeof(BURN_RELATED_BUNDLE_CODES));
+
+    if (cMaxCodes)
+    {
+        pCodes->rgCodes = static_cast<BURN_RELATED_BUNDLE_CODE*>(MemAlloc(sizeof(BURN_RELATED_BUNDLE_CODE) * cMaxCodes, TRUE));
+        ExitOnNull(pCodes->rgCodes, hr, E_OUTOFMEMORY, "Failed to allocate related bundle codes.");
+    }
+
+    // The array is allocated up front and never moves, so the dictionary can point straight into it.
+    hr = DictCreateWithEmbeddedKey(&pCodes->sdCodes, cMaxCodes, NULL, offsetof(BURN_RELATED_BUNDLE_CODE, wzCode), DICT_FLAG_CASEINSENSITIVE);
+    ExitOnFailure(hr, "Failed to create related bundle code dictionary.");
+
+    hr = AddRelatedBundleCodes(pCodes, pRegistration->rgsczUpgradeCodes, pRegistration->cUpgradeCodes, BURN_RELATED_BUNDLE_CODE_TYPE_UPGRADE);
+    ExitOnFailure(hr, "Failed to add %hs.", "upgrade codes");
+
+    hr = AddRelatedBundleCodes(pCodes, pRegistration->rgsczAddonCodes, pRegistration->cAddonCodes, BURN_RELATED_BUNDLE_CODE_TYPE_ADDON);
+    ExitOnFailure(hr, "Failed to add %hs.", "addon codes");
+
+    hr = AddRelatedBundleCodes(pCodes, pRegistration->rgsczDetectCodes, pRegistration->cDetectCodes, BURN_RELATED_BUNDLE_CODE_TYPE_DETECT);
+    ExitOnFailure(hr, "Failed to add %hs.", "detect codes");
+
+    hr = AddRelatedBundleCodes(pCodes, pRegistration->rgsczPatchCodes, pRegistration->cPatchCodes, BURN_RELATED_BUNDLE_CODE_TYPE_PATCH);
+    ExitOnFailure(hr, "Failed to add %hs.", "patch codes");
+
+LExit:
+    return hr;
+}
+
+extern "C" void RelatedBundleCodesUninitialize(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes
+    )
+{
+    ReleaseDict(pCodes->sdCodes);
+    ReleaseMem(pCodes->rgCodes);
+
+    memset(pCodes, 0, sizeof(BURN_RELATED_BUNDLE_CODES));
+}
+
+/********************************************************************
+ RelatedBundleCodesDetermineRelationType - determines how a bundle with
+                                           the given codes relates to
+                                           this bundle.
+
+ NOTE: The order of the checks decides the relation when more than one
+       applies.
+********************************************************************/
+extern "C" BOOTSTRAPPER_RELATION_TYPE RelatedBundleCodesDetermineRelationType(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
+    __in_ecount(cUpgradeCodes) LPWSTR* rgsczUpgradeCodes,
+    __in DWORD cUpgradeCodes,
+    __in_ecount(cAddonCodes) LPWSTR* rgsczAddonCodes,
+    __in DWORD cAddonCodes,
+    __in_ecount(cPatchCodes) LPWSTR* rgsczPatchCodes,
+    __in DWORD cPatchCodes,
+    __in_ecount(cDetectCodes) LPWSTR* rgsczDetectCodes,
+    __in DWORD cDetectCodes
+    )
+{
+    DWORD dwTypes = MatchRelatedBundleCodes(pCodes, rgsczUpgradeCodes, cUpgradeCodes);
+
+    // Upgrade relationship: when their upgrade codes match our upgrade codes.
+    if (dwTypes & BURN_RELATED_BUNDLE_CODE_TYPE_UPGRADE)
+    {
+        return BOOTSTRAPPER_RELATION_UPGRADE;
+    }
+
+    // Detect relationship: when their upgrade codes match our detect codes.
+    if (dwTypes & BURN_RELATED_BUNDLE_CODE_TYPE_DETECT)
+    {
+        return BOOTSTRAPPER_RELATION_DETECT;
+    }
+
+    // Dependent relationship: when their upgrade codes match our addon or patch codes.
+    if (dwTypes & (BURN_RELATED_BUNDLE_CODE_TYPE_ADDON | BURN_RELATED_BUNDLE_CODE_TYPE_PATCH))
+    {
+        return BOOTSTRAPPER_RELATION_DEPENDENT;
+    }
+
+    // Addon relationship: when their addon codes match our detect or upgrade codes.
+    dwTypes = MatchRelatedBundleCodes(pCodes, rgsczAddonCodes, cAddonCodes);
+    if (dwTypes & (BURN_RELATED_BUNDLE_CODE_TYPE_DETECT | BURN_RELATED_BUNDLE_CODE_TYPE_UPGRADE))
+    {
+        return BOOTSTRAPPER_RELATION_ADDON;
+    }
+
+    // Patch relationship: when their patch codes match our detect or upgrade codes.
+    dwTypes = MatchRelatedBundleCodes(pCodes, rgsczPatchCodes, cPatchCodes);
+    if (dwTypes & (BURN_RELATED_BUNDLE_CODE_TYPE_DETECT | BURN_RELATED_BUNDLE_CODE_TYPE_UPGRADE))
+    {
+        return BOOTSTRAPPER_RELATION_PATCH;
+    }
+
+    // Detect relationship: when their detect codes match our detect codes.
+    dwTypes = MatchRelatedBundleCodes(pCodes, rgsczDetectCodes, cDetectCodes);
+    if (dwTypes & BURN_RELATED_BUNDLE_CODE_TYPE_DETECT)
+    {
+        return BOOTSTRAPPER_RELATION_DETECT;
+    }
+
+    // Dependent relationship: when their detect codes match our addon or patch codes.
+    if (dwTypes & (BURN_RELATED_BUNDLE_CODE_TYPE_ADDON | BURN_RELATED_BUNDLE_CODE_TYPE_PATCH))
+    {
+        return BOOTSTRAPPER_RELATION_DEPENDENT;
+    }
+
+    return BOOTSTRAPPER_RELATION_NONE;
+}
+
 
 // internal helper functions
 
+static HRESULT AddRelatedBundleCodes(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
+    __in_ecount(cCodes) LPWSTR* rgsczCodes,
+    __in DWORD cCodes,
+    __in BURN_RELATED_BUNDLE_CODE_TYPE type
+    )
+{
+    HRESULT hr = S_OK;
+    BURN_RELATED_BUNDLE_CODE* pCode = NULL;
+
+    for (DWORD i = 0; i < cCodes; ++i)
+    {
+        if (!rgsczCodes[i])
+        {
+            continue;
+        }
+
+        // A code in more than one list shares one entry that remembers every list it is in.
+        hr = DictGetValue(pCodes->sdCodes, rgsczCodes[i], reinterpret_cast<void**>(&pCode));
+        if (E_NOTFOUND == hr)
+        {
+            pCode = pCodes->rgCodes + pCodes->cCodes;
+            pCode->wzCode = rgsczCodes[i];
+
+            hr = DictAddValue(pCodes->sdCodes, pCode);
+            ExitOnFailure(hr, "Failed to add related bundle code: %ls", rgsczCodes[i]);
+
+            ++pCodes->cCodes;
+        }
+        ExitOnFailure(hr, "Failed to find related bundle code: %ls", rgsczCodes[i]);
+
+        pCode->dwTypes |= type;
+    }
+
+LExit:
+    return hr;
+}
+
+static DWORD MatchRelatedBundleCodes(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
+    __in_ecount(cCodes) LPWSTR* rgsczCodes,
+    __in DWORD cCodes
+    )
+{
+    DWORD dwTypes = BURN_RELATED_BUNDLE_CODE_TYPE_NONE;
+    BURN_RELATED_BUNDLE_CODE* pCode = NULL;
+
+    for (DWORD i = 0; i < cCodes; ++i)
+    {
+        if (rgsczCodes[i] && SUCCEEDED(DictGetValue(pCodes->sdCodes, rgsczCodes[i], reinterpret_cast<void**>(&pCode))))
+        {
+            dwTypes |= pCode->dwTypes;
+        }
+    }
+
+    return dwTypes;
+}
+
 static HRESULT LoadIfRelatedBundle(
     __in BOOL fPerMachine,
     __in HKEY hkUninstallKey,
     __in_z LPCWSTR sczRelatedBundleId,
-    __in BURN_REGISTRATION* pRegistration,
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
     __in BURN_RELATED_BUNDLES* pRelatedBundles
     )
 {
@@ -108,7 +298,7 @@ static HRESULT LoadIfRelatedBundle(
     hr = RegOpen(hkUninstallKey, sczRelatedBundleId, KEY_READ, &hkBundleId);
     ExitOnFailure(hr, "Failed to open uninstall key for potential related bundle: %ls", sczRelatedBundleId);
 
-    hr = DetermineRelationType(hkBundleId, pRegistration, &relationType);
+    hr = DetermineRelationType(hkBundleId, pCodes, &relationType);
     if (FAILED(hr) || BOOTSTRAPPER_RELATION_NONE == relationType)
     {
         // Must not be a related bundle.
@@ -135,27 +325,24 @@ LExit:
 
 static HRESULT DetermineRelationType(
     __in HKEY hkBundleId,
-    __in BURN_REGISTRATION* pRegistration,
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
     __out BOOTSTRAPPER_RELATION_TYPE* pRelationType
     )
 {
     HRESULT hr = S_OK;
     LPWSTR* rgsczUpgradeCodes = NULL;
     DWORD cUpgradeCodes = 0;
-    STRINGDICT_HANDLE sdUpgradeCodes = NULL;
     LPWSTR* rgsczAddonCodes = NULL;
     DWORD cAddonCodes = 0;
-    STRINGDICT_HANDLE sdAddonCodes = NULL;
     LPWSTR* rgsczDetectCodes = NULL;
     DWORD cDetectCodes = 0;
-    STRINGDICT_HANDLE sdDetectCodes = NULL;
     LPWSTR* rgsczPatchCodes = NULL;
     DWORD cPatchCodes = 0;
-    STRINGDICT_HANDLE sdPatchCodes = NULL;
 
     *pRelationType = BOOTSTRAPPER_RELATION_NONE;
 
-    // All remaining operations should treat all related bundles as non-vital.
+    // All remaining operations should treat all related bundles as non-vital, so a list
+    // that can't be read is treated as empty.
     hr = RegReadStringArray(hkBundleId, BURN_REGISTRATION_REGISTRY_BUNDLE_UPGRADE_CODE, &rgsczUpgradeCodes, &cUpgradeCodes);
     if (HRESULT_FROM_WIN32(ERROR_INVALID_DATATYPE) == hr)
     {
@@ -171,216 +358,37 @@ static HRESULT DetermineRelationType(
         }
     }
 
-    // Compare upgrade codes.
-    if (SUCCEEDED(hr))
+    if (FAILED(hr))
     {
-        hr = DictCreateStringListFromArray(&sdUpgradeCodes, rgsczUpgradeCodes, cUpgradeCodes, DICT_FLAG_CASEINSENSITIVE);
-        ExitOnFailure(hr, "Failed to create string dictionary for %hs.", "upgrade codes");
-
-        // Upgrade relationship: when their upgrade codes match our upgrade codes.
-        hr = DictCompareStringListToArray(sdUpgradeCodes, const_cast<LPCWSTR*>(pRegistration->rgsczUpgradeCodes), pRegistration->cUpgradeCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for upgrade code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_UPGRADE;
-            ExitFunction();
-        }
-
-        // Detect relationship: when their upgrade codes match our detect codes.
-        hr = DictCompareStringListToArray(sdUpgradeCodes, const_cast<LPCWSTR*>(pRegistration->rgsczDetectCodes), pRegistration->cDetectCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for detect code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_DETECT;
-            ExitFunction();
-        }
-
-        // Dependent relationship: when their upgrade codes match our addon codes.
-        hr = DictCompareStringListToArray(sdUpgradeCodes, const_cast<LPCWSTR*>(pRegistration->rgsczAddonCodes), pRegistration->cAddonCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for addon code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_DEPENDENT;
-            ExitFunction();
-        }
-
-        // Dependent relationship: when their upgrade codes match our patch codes.
-        hr = DictCompareStringListToArray(sdUpgradeCodes, const_cast<LPCWSTR*>(pRegistration->rgsczPatchCodes), pRegistration->cPatchCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for addon code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_DEPENDENT;
-            ExitFunction();
-        }
-
-        ReleaseNullDict(sdUpgradeCodes);
         ReleaseNullStrArray(rgsczUpgradeCodes, cUpgradeCodes);
     }
 
-    // Compare addon codes.
     hr = RegReadStringArray(hkBundleId, BURN_REGISTRATION_REGISTRY_BUNDLE_ADDON_CODE, &rgsczAddonCodes, &cAddonCodes);
-    if (SUCCEEDED(hr))
+    if (FAILED(hr))
     {
-        hr = DictCreateStringListFromArray(&sdAddonCodes, rgsczAddonCodes, cAddonCodes, DICT_FLAG_CASEINSENSITIVE);
-        ExitOnFailure(hr, "Failed to create string dictionary for %hs.", "addon codes");
-
-        // Addon relationship: when their addon codes match our detect codes.
-        hr = DictCompareStringListToArray(sdAddonCodes, const_cast<LPCWSTR*>(pRegistration->rgsczDetectCodes), pRegistration->cDetectCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for addon code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_ADDON;
-            ExitFunction();
-        }
-
-        // Addon relationship: when their addon codes match our upgrade codes.
-        hr = DictCompareStringListToArray(sdAddonCodes, const_cast<LPCWSTR*>(pRegistration->rgsczUpgradeCodes), pRegistration->cUpgradeCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for addon code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_ADDON;
-            ExitFunction();
-        }
-
-        ReleaseNullDict(sdAddonCodes);
         ReleaseNullStrArray(rgsczAddonCodes, cAddonCodes);
     }
 
-    // Compare patch codes.
     hr = RegReadStringArray(hkBundleId, BURN_REGISTRATION_REGISTRY_BUNDLE_PATCH_CODE, &rgsczPatchCodes, &cPatchCodes);
-    if (SUCCEEDED(hr))
+    if (FAILED(hr))
     {
-        hr = DictCreateStringListFromArray(&sdPatchCodes, rgsczPatchCodes, cPatchCodes, DICT_FLAG_CASEINSENSITIVE);
-        ExitOnFailure(hr, "Failed to create string dictionary for %hs.", "patch codes");
-
-        // Patch relationship: when their patch codes match our detect codes.
-        hr = DictCompareStringListToArray(sdPatchCodes, const_cast<LPCWSTR*>(pRegistration->rgsczDetectCodes), pRegistration->cDetectCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for patch code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_PATCH;
-            ExitFunction();
-        }
-
-        // Patch relationship: when their patch codes match our upgrade codes.
-        hr = DictCompareStringListToArray(sdPatchCodes, const_cast<LPCWSTR*>(pRegistration->rgsczUpgradeCodes), pRegistration->cUpgradeCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for patch code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_PATCH;
-            ExitFunction();
-        }
-
-        ReleaseNullDict(sdPatchCodes);
         ReleaseNullStrArray(rgsczPatchCodes, cPatchCodes);
     }
 
-    // Compare detect codes.
     hr = RegReadStringArray(hkBundleId, BURN_REGISTRATION_REGISTRY_BUNDLE_DETECT_CODE, &rgsczDetectCodes, &cDetectCodes);
-    if (SUCCEEDED(hr))
+    if (FAILED(hr))
     {
-        hr = DictCreateStringListFromArray(&sdDetectCodes, rgsczDetectCodes, cDetectCodes, DICT_FLAG_CASEINSENSITIVE);
-        ExitOnFailure(hr, "Failed to create string dictionary for %hs.", "detect codes");
-
-        // Detect relationship: when their detect codes match our detect codes.
-        hr = DictCompareStringListToArray(sdDetectCodes, const_cast<LPCWSTR*>(pRegistration->rgsczDetectCodes), pRegistration->cDetectCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for detect code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_DETECT;
-            ExitFunction();
-        }
-
-        // Dependent relationship: when their detect codes match our addon codes.
-        hr = DictCompareStringListToArray(sdDetectCodes, const_cast<LPCWSTR*>(pRegistration->rgsczAddonCodes), pRegistration->cAddonCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for addon code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_DEPENDENT;
-            ExitFunction();
-        }
-
-        // Dependent relationship: when their detect codes match our patch codes.
-        hr = DictCompareStringListToArray(sdDetectCodes, const_cast<LPCWSTR*>(pRegistration->rgsczPatchCodes), pRegistration->cPatchCodes);
-        if (HRESULT_FROM_WIN32(ERROR_NO_MATCH) == hr)
-        {
-            hr = S_OK;
-        }
-        else
-        {
-            ExitOnFailure(hr, "Failed to do array search for addon code match.");
-
-            *pRelationType = BOOTSTRAPPER_RELATION_DEPENDENT;
-            ExitFunction();
-        }
-
-        ReleaseNullDict(sdDetectCodes);
         ReleaseNullStrArray(rgsczDetectCodes, cDetectCodes);
     }
 
-LExit:
-    if (SUCCEEDED(hr) && BOOTSTRAPPER_RELATION_NONE == *pRelationType)
-    {
-        hr = E_NOTFOUND;
-    }
+    *pRelationType = RelatedBundleCodesDetermineRelationType(pCodes, rgsczUpgradeCodes, cUpgradeCodes, rgsczAddonCodes, cAddonCodes, rgsczPatchCodes, cPatchCodes, rgsczDetectCodes, cDetectCodes);
 
-    ReleaseDict(sdUpgradeCodes);
+    hr = (BOOTSTRAPPER_RELATION_NONE == *pRelationType) ? E_NOTFOUND : S_OK;
+
+LExit:
     ReleaseStrArray(rgsczUpgradeCodes, cUpgradeCodes);
-    ReleaseDict(sdAddonCodes);
     ReleaseStrArray(rgsczAddonCodes, cAddonCodes);
-    ReleaseDict(sdDetectCodes);
     ReleaseStrArray(rgsczDetectCodes, cDetectCodes);
-    ReleaseDict(sdPatchCodes);
     ReleaseStrArray(rgsczPatchCodes, cPatchCodes);
 
     return hr;
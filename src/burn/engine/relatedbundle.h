@@ -6,6 +6,38 @@
 extern "C" {
 #endif
 
+// constants
+
+enum BURN_RELATED_BUNDLE_CODE_TYPE
+{
+    BURN_RELATED_BUNDLE_CODE_TYPE_NONE = 0x0,
+    BURN_RELATED_BUNDLE_CODE_TYPE_UPGRADE = 0x1,
+    BURN_RELATED_BUNDLE_CODE_TYPE_ADDON = 0x2,
+    BURN_RELATED_BUNDLE_CODE_TYPE_DETECT = 0x4,
+    BURN_RELATED_BUNDLE_CODE_TYPE_PATCH = 0x8,
+};
+
+
+// structs
+
+typedef struct _BURN_RELATED_BUNDLE_CODE
+{
+    LPCWSTR wzCode;
+    DWORD dwTypes; // BURN_RELATED_BUNDLE_CODE_TYPE flags of every list this bundle has the code in.
+} BURN_RELATED_BUNDLE_CODE;
+
+// The upgrade, addon, detect and patch codes of this bundle, indexed once so each
+// potential related bundle only needs a lookup per code instead of its own dictionaries.
+typedef struct _BURN_RELATED_BUNDLE_CODES
+{
+    BURN_RELATED_BUNDLE_CODE* rgCodes;
+    DWORD cCodes;
+    STRINGDICT_HANDLE sdCodes;
+} BURN_RELATED_BUNDLE_CODES;
+
+
+// function declarations
+
 HRESULT RelatedBundlesInitializeForScope(
     __in BOOL fPerMachine,
     __in BURN_REGISTRATION* pRegistration,
@@ -14,6 +46,24 @@ HRESULT RelatedBundlesInitializeForScope(
 void RelatedBundlesUninitialize(
     __in BURN_RELATED_BUNDLES* pRelatedBundles
     );
+HRESULT RelatedBundleCodesInitialize(
+    __in BURN_REGISTRATION* pRegistration,
+    __in BURN_RELATED_BUNDLE_CODES* pCodes
+    );
+void RelatedBundleCodesUninitialize(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes
+    );
+BOOTSTRAPPER_RELATION_TYPE RelatedBundleCodesDetermineRelationType(
+    __in BURN_RELATED_BUNDLE_CODES* pCodes,
+    __in_ecount(cUpgradeCodes) LPWSTR* rgsczUpgradeCodes,
+    __in DWORD cUpgradeCodes,
+    __in_ecount(cAddonCodes) LPWSTR* rgsczAddonCodes,
+    __in DWORD cAddonCodes,
+    __in_ecount(cPatchCodes) LPWSTR* rgsczPatchCodes,
+    __in DWORD cPatchCodes,
+    __in_ecount(cDetectCodes) LPWSTR* rgsczDetectCodes,
+    __in DWORD cDetectCodes
+    );
 
 #if defined(__cplusplus)
 }
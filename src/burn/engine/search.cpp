@@ -49,347 +49,317 @@ static HRESULT MsiFeatureSearch(
 
 // function definitions
 
-extern "C" HRESULT SearchesParseFromXml(
+extern "C" HRESULT SearchParseFromXml(
     __in BURN_SEARCHES* pSearches,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
-    BSTR bstrNodeName = NULL;
+    LPCWSTR wzNodeName = pReader->wzName;
     LPWSTR scz = NULL;
+    BURN_SEARCH* pSearch = NULL;
 
-    // select search nodes
-    hr = XmlSelectNodes(pixnBundle, L"DirectorySearch|FileSearch|RegistrySearch|MsiComponentSearch|MsiProductSearch|MsiFeatureSearch", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select search nodes.");
+    // allocate memory for the search
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pSearches->rgSearches), pSearches->cSearches + 1, sizeof(BURN_SEARCH), pSearches->cSearches);
+    ExitOnFailure(hr, "Failed to allocate memory for search structs.");
 
-    // get search node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get search node count.");
+    pSearch = &pSearches->rgSearches[pSearches->cSearches];
+    ++pSearches->cSearches;
 
-    if (!cNodes)
-    {
-        ExitFunction();
-    }
-
-    // allocate memory for searches
-    pSearches->rgSearches = (BURN_SEARCH*)MemAlloc(sizeof(BURN_SEARCH) * cNodes, TRUE);
-    ExitOnNull(pSearches->rgSearches, hr, E_OUTOFMEMORY, "Failed to allocate memory for search structs.");
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &pSearch->sczKey);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-    pSearches->cSearches = cNodes;
+    // @Variable
+    hr = XmlReaderGetAttribute(pReader, L"Variable", &pSearch->sczVariable);
+    ExitOnFailure(hr, "Failed to get @Variable.");
 
-    // parse search elements
-    for (DWORD i = 0; i < cNodes; ++i)
+    // @Condition
+    hr = XmlReaderGetAttribute(pReader, L"Condition", &pSearch->sczCondition);
+    if (E_NOTFOUND != hr)
     {
-        BURN_SEARCH* pSearch = &pSearches->rgSearches[i];
+        ExitOnFailure(hr, "Failed to get @Condition.");
+    }
 
-        hr = XmlNextElement(pixnNodes, &pixnNode, &bstrNodeName);
-        ExitOnFailure(hr, "Failed to get next node.");
+    // read type specific attributes
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzNodeName, -1, L"DirectorySearch", -1))
+    {
+        pSearch->Type = BURN_SEARCH_TYPE_DIRECTORY;
 
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &pSearch->sczKey);
-        ExitOnFailure(hr, "Failed to get @Id.");
+        // @Path
+        hr = XmlReaderGetAttribute(pReader, L"Path", &pSearch->DirectorySearch.sczPath);
+        ExitOnFailure(hr, "Failed to get @Path.");
 
-        // @Variable
-        hr = XmlGetAttributeEx(pixnNode, L"Variable", &pSearch->sczVariable);
-        ExitOnFailure(hr, "Failed to get @Variable.");
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-        // @Condition
-        hr = XmlGetAttributeEx(pixnNode, L"Condition", &pSearch->sczCondition);
-        if (E_NOTFOUND != hr)
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"exists", -1))
         {
-            ExitOnFailure(hr, "Failed to get @Condition.");
+            pSearch->DirectorySearch.Type = BURN_DIRECTORY_SEARCH_TYPE_EXISTS;
         }
-
-        // read type specific attributes
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"DirectorySearch", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"path", -1))
+        {
+            pSearch->DirectorySearch.Type = BURN_DIRECTORY_SEARCH_TYPE_PATH;
+        }
+        else
         {
-            pSearch->Type = BURN_SEARCH_TYPE_DIRECTORY;
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+        }
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzNodeName, -1, L"FileSearch", -1))
+    {
+        pSearch->Type = BURN_SEARCH_TYPE_FILE;
 
-            // @Path
-            hr = XmlGetAttributeEx(pixnNode, L"Path", &pSearch->DirectorySearch.sczPath);
-            ExitOnFailure(hr, "Failed to get @Path.");
+        // @Path
+        hr = XmlReaderGetAttribute(pReader, L"Path", &pSearch->FileSearch.sczPath);
+        ExitOnFailure(hr, "Failed to get @Path.");
 
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"exists", -1))
-            {
-                pSearch->DirectorySearch.Type = BURN_DIRECTORY_SEARCH_TYPE_EXISTS;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"path", -1))
-            {
-                pSearch->DirectorySearch.Type = BURN_DIRECTORY_SEARCH_TYPE_PATH;
-            }
-            else
-            {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
-            }
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"exists", -1))
+        {
+            pSearch->FileSearch.Type = BURN_FILE_SEARCH_TYPE_EXISTS;
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"FileSearch", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
         {
-            pSearch->Type = BURN_SEARCH_TYPE_FILE;
-
-            // @Path
-            hr = XmlGetAttributeEx(pixnNode, L"Path", &pSearch->FileSearch.sczPath);
-            ExitOnFailure(hr, "Failed to get @Path.");
+            pSearch->FileSearch.Type = BURN_FILE_SEARCH_TYPE_VERSION;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"path", -1))
+        {
+            pSearch->FileSearch.Type = BURN_FILE_SEARCH_TYPE_PATH;
+        }
+        else
+        {
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+        }
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzNodeName, -1, L"RegistrySearch", -1))
+    {
+        pSearch->Type = BURN_SEARCH_TYPE_REGISTRY;
 
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
+        // @Root
+        hr = XmlReaderGetAttribute(pReader, L"Root", &scz);
+        ExitOnFailure(hr, "Failed to get @Root.");
 
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"exists", -1))
-            {
-                pSearch->FileSearch.Type = BURN_FILE_SEARCH_TYPE_EXISTS;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
-            {
-                pSearch->FileSearch.Type = BURN_FILE_SEARCH_TYPE_VERSION;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"path", -1))
-            {
-                pSearch->FileSearch.Type = BURN_FILE_SEARCH_TYPE_PATH;
-            }
-            else
-            {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
-            }
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKCR", -1))
+        {
+            pSearch->RegistrySearch.hRoot = HKEY_CLASSES_ROOT;
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"RegistrySearch", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKCU", -1))
         {
-            pSearch->Type = BURN_SEARCH_TYPE_REGISTRY;
+            pSearch->RegistrySearch.hRoot = HKEY_CURRENT_USER;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKLM", -1))
+        {
+            pSearch->RegistrySearch.hRoot = HKEY_LOCAL_MACHINE;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKU", -1))
+        {
+            pSearch->RegistrySearch.hRoot = HKEY_USERS;
+        }
+        else
+        {
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Root: %ls", scz);
+        }
 
-            // @Root
-            hr = XmlGetAttributeEx(pixnNode, L"Root", &scz);
-            ExitOnFailure(hr, "Failed to get @Root.");
+        // @Key
+        hr = XmlReaderGetAttribute(pReader, L"Key", &pSearch->RegistrySearch.sczKey);
+        ExitOnFailure(hr, "Failed to get Key attribute.");
 
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKCR", -1))
-            {
-                pSearch->RegistrySearch.hRoot = HKEY_CLASSES_ROOT;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKCU", -1))
-            {
-                pSearch->RegistrySearch.hRoot = HKEY_CURRENT_USER;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKLM", -1))
-            {
-                pSearch->RegistrySearch.hRoot = HKEY_LOCAL_MACHINE;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"HKU", -1))
-            {
-                pSearch->RegistrySearch.hRoot = HKEY_USERS;
-            }
-            else
-            {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Root: %ls", scz);
-            }
+        // @Value
+        hr = XmlReaderGetAttribute(pReader, L"Value", &pSearch->RegistrySearch.sczValue);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get Value attribute.");
+        }
+
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-            // @Key
-            hr = XmlGetAttributeEx(pixnNode, L"Key", &pSearch->RegistrySearch.sczKey);
-            ExitOnFailure(hr, "Failed to get Key attribute.");
+        hr = XmlReaderGetYesNoAttribute(pReader, L"Win64", &pSearch->RegistrySearch.fWin64);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get Win64 attribute.");
+        }
 
-            // @Value
-            hr = XmlGetAttributeEx(pixnNode, L"Value", &pSearch->RegistrySearch.sczValue);
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"exists", -1))
+        {
+            pSearch->RegistrySearch.Type = BURN_REGISTRY_SEARCH_TYPE_EXISTS;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"value", -1))
+        {
+            pSearch->RegistrySearch.Type = BURN_REGISTRY_SEARCH_TYPE_VALUE;
+
+            // @ExpandEnvironment
+            hr = XmlReaderGetYesNoAttribute(pReader, L"ExpandEnvironment", &pSearch->RegistrySearch.fExpandEnvironment);
             if (E_NOTFOUND != hr)
             {
-                ExitOnFailure(hr, "Failed to get Value attribute.");
+                ExitOnFailure(hr, "Failed to get @ExpandEnvironment.");
             }
 
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
+            // @VariableType
+            hr = XmlReaderGetAttribute(pReader, L"VariableType", &scz);
+            ExitOnFailure(hr, "Failed to get @VariableType.");
 
-            hr = XmlGetYesNoAttribute(pixnNode, L"Win64", &pSearch->RegistrySearch.fWin64);
-            if (E_NOTFOUND != hr)
+            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"numeric", -1))
             {
-                ExitOnFailure(hr, "Failed to get Win64 attribute.");
+                pSearch->RegistrySearch.VariableType = BURN_VARIANT_TYPE_NUMERIC;
             }
-
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"exists", -1))
+            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"string", -1))
             {
-                pSearch->RegistrySearch.Type = BURN_REGISTRY_SEARCH_TYPE_EXISTS;
+                pSearch->RegistrySearch.VariableType = BURN_VARIANT_TYPE_STRING;
             }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"value", -1))
+            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
             {
-                pSearch->RegistrySearch.Type = BURN_REGISTRY_SEARCH_TYPE_VALUE;
-
-                // @ExpandEnvironment
-                hr = XmlGetYesNoAttribute(pixnNode, L"ExpandEnvironment", &pSearch->RegistrySearch.fExpandEnvironment);
-                if (E_NOTFOUND != hr)
-                {
-                    ExitOnFailure(hr, "Failed to get @ExpandEnvironment.");
-                }
-
-                // @VariableType
-                hr = XmlGetAttributeEx(pixnNode, L"VariableType", &scz);
-                ExitOnFailure(hr, "Failed to get @VariableType.");
-
-                if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"numeric", -1))
-                {
-                    pSearch->RegistrySearch.VariableType = BURN_VARIANT_TYPE_NUMERIC;
-                }
-                else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"string", -1))
-                {
-                    pSearch->RegistrySearch.VariableType = BURN_VARIANT_TYPE_STRING;
-                }
-                else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
-                {
-                    pSearch->RegistrySearch.VariableType = BURN_VARIANT_TYPE_VERSION;
-                }
-                else
-                {
-                    hr = E_INVALIDARG;
-                    ExitOnFailure(hr, "Invalid value for @VariableType: %ls", scz);
-                }
+                pSearch->RegistrySearch.VariableType = BURN_VARIANT_TYPE_VERSION;
             }
             else
             {
                 hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+                ExitOnFailure(hr, "Invalid value for @VariableType: %ls", scz);
             }
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"MsiComponentSearch", -1))
+        else
         {
-            pSearch->Type = BURN_SEARCH_TYPE_MSI_COMPONENT;
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+        }
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzNodeName, -1, L"MsiComponentSearch", -1))
+    {
+        pSearch->Type = BURN_SEARCH_TYPE_MSI_COMPONENT;
 
-            // @ProductCode
-            hr = XmlGetAttributeEx(pixnNode, L"ProductCode", &pSearch->MsiComponentSearch.sczProductCode);
-            if (E_NOTFOUND != hr)
-            {
-                ExitOnFailure(hr, "Failed to get @ProductCode.");
-            }
+        // @ProductCode
+        hr = XmlReaderGetAttribute(pReader, L"ProductCode", &pSearch->MsiComponentSearch.sczProductCode);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @ProductCode.");
+        }
 
-            // @ComponentId
-            hr = XmlGetAttributeEx(pixnNode, L"ComponentId", &pSearch->MsiComponentSearch.sczComponentId);
-            ExitOnFailure(hr, "Failed to get @ComponentId.");
+        // @ComponentId
+        hr = XmlReaderGetAttribute(pReader, L"ComponentId", &pSearch->MsiComponentSearch.sczComponentId);
+        ExitOnFailure(hr, "Failed to get @ComponentId.");
 
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"keyPath", -1))
-            {
-                pSearch->MsiComponentSearch.Type = BURN_MSI_COMPONENT_SEARCH_TYPE_KEYPATH;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"state", -1))
-            {
-                pSearch->MsiComponentSearch.Type = BURN_MSI_COMPONENT_SEARCH_TYPE_STATE;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"directory", -1))
-            {
-                pSearch->MsiComponentSearch.Type = BURN_MSI_COMPONENT_SEARCH_TYPE_DIRECTORY;
-            }
-            else
-            {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
-            }
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"keyPath", -1))
+        {
+            pSearch->MsiComponentSearch.Type = BURN_MSI_COMPONENT_SEARCH_TYPE_KEYPATH;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"state", -1))
+        {
+            pSearch->MsiComponentSearch.Type = BURN_MSI_COMPONENT_SEARCH_TYPE_STATE;
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"MsiProductSearch", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"directory", -1))
         {
-            pSearch->Type = BURN_SEARCH_TYPE_MSI_PRODUCT;
-            pSearch->MsiProductSearch.GuidType = BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_NONE;
+            pSearch->MsiComponentSearch.Type = BURN_MSI_COMPONENT_SEARCH_TYPE_DIRECTORY;
+        }
+        else
+        {
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+        }
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzNodeName, -1, L"MsiProductSearch", -1))
+    {
+        pSearch->Type = BURN_SEARCH_TYPE_MSI_PRODUCT;
+        pSearch->MsiProductSearch.GuidType = BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_NONE;
 
-            // @ProductCode (if we don't find a product code then look for an upgrade code)
-            hr = XmlGetAttributeEx(pixnNode, L"ProductCode", &pSearch->MsiProductSearch.sczGuid);
+        // @ProductCode (if we don't find a product code then look for an upgrade code)
+        hr = XmlReaderGetAttribute(pReader, L"ProductCode", &pSearch->MsiProductSearch.sczGuid);
+        if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "Failed to get @ProductCode.");
+            pSearch->MsiProductSearch.GuidType = BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_PRODUCTCODE;
+        }
+        else
+        {
+            // @UpgradeCode
+            hr = XmlReaderGetAttribute(pReader, L"UpgradeCode", &pSearch->MsiProductSearch.sczGuid);
             if (E_NOTFOUND != hr)
             {
-                ExitOnFailure(hr, "Failed to get @ProductCode.");
-                pSearch->MsiProductSearch.GuidType = BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_PRODUCTCODE;
-            }
-            else
-            {
-                // @UpgradeCode
-                hr = XmlGetAttributeEx(pixnNode, L"UpgradeCode", &pSearch->MsiProductSearch.sczGuid);
-                if (E_NOTFOUND != hr)
-                {
-                    ExitOnFailure(hr, "Failed to get @UpgradeCode.");
-                    pSearch->MsiProductSearch.GuidType = BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_UPGRADECODE;
-                }
+                ExitOnFailure(hr, "Failed to get @UpgradeCode.");
+                pSearch->MsiProductSearch.GuidType = BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_UPGRADECODE;
             }
+        }
 
-            // make sure we found either a product or upgrade code
-            if (BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_NONE == pSearch->MsiProductSearch.GuidType)
-            {
-                hr = E_NOTFOUND;
-                ExitOnFailure(hr, "Failed to get @ProductCode or @UpgradeCode.");
-            }
+        // make sure we found either a product or upgrade code
+        if (BURN_MSI_PRODUCT_SEARCH_GUID_TYPE_NONE == pSearch->MsiProductSearch.GuidType)
+        {
+            hr = E_NOTFOUND;
+            ExitOnFailure(hr, "Failed to get @ProductCode or @UpgradeCode.");
+        }
 
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
-            {
-                pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_VERSION;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"language", -1))
-            {
-                pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_LANGUAGE;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"state", -1))
-            {
-                pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_STATE;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"assignment", -1))
-            {
-                pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_ASSIGNMENT;
-            }
-            else
-            {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
-            }
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
+        {
+            pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_VERSION;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"language", -1))
+        {
+            pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_LANGUAGE;
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrNodeName, -1, L"MsiFeatureSearch", -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"state", -1))
         {
-            pSearch->Type = BURN_SEARCH_TYPE_MSI_FEATURE;
+            pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_STATE;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"assignment", -1))
+        {
+            pSearch->MsiProductSearch.Type = BURN_MSI_PRODUCT_SEARCH_TYPE_ASSIGNMENT;
+        }
+        else
+        {
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+        }
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzNodeName, -1, L"MsiFeatureSearch", -1))
+    {
+        pSearch->Type = BURN_SEARCH_TYPE_MSI_FEATURE;
 
-            // @ProductCode
-            hr = XmlGetAttributeEx(pixnNode, L"ProductCode", &pSearch->MsiFeatureSearch.sczProductCode);
-            ExitOnFailure(hr, "Failed to get @ProductCode.");
+        // @ProductCode
+        hr = XmlReaderGetAttribute(pReader, L"ProductCode", &pSearch->MsiFeatureSearch.sczProductCode);
+        ExitOnFailure(hr, "Failed to get @ProductCode.");
 
-            // @FeatureId
-            hr = XmlGetAttributeEx(pixnNode, L"FeatureId", &pSearch->MsiFeatureSearch.sczFeatureId);
-            ExitOnFailure(hr, "Failed to get @FeatureId.");
+        // @FeatureId
+        hr = XmlReaderGetAttribute(pReader, L"FeatureId", &pSearch->MsiFeatureSearch.sczFeatureId);
+        ExitOnFailure(hr, "Failed to get @FeatureId.");
 
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"state", -1))
-            {
-                pSearch->MsiFeatureSearch.Type = BURN_MSI_FEATURE_SEARCH_TYPE_STATE;
-            }
-            else
-            {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
-            }
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"state", -1))
+        {
+            pSearch->MsiFeatureSearch.Type = BURN_MSI_FEATURE_SEARCH_TYPE_STATE;
         }
         else
         {
-            hr = E_UNEXPECTED;
-            ExitOnFailure(hr, "Unexpected element name: %ls", bstrNodeName);
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
         }
-
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
-        ReleaseNullBSTR(bstrNodeName);
+    }
+    else
+    {
+        hr = E_UNEXPECTED;
+        ExitOnFailure(hr, "Unexpected element name: %ls", wzNodeName);
     }
 
     hr = S_OK;
 
 LExit:
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseBSTR(bstrNodeName);
     ReleaseStr(scz);
     return hr;
 }
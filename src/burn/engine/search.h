@@ -134,9 +134,9 @@ typedef struct _BURN_SEARCHES
 
 // function declarations
 
-HRESULT SearchesParseFromXml(
+HRESULT SearchParseFromXml(
     __in BURN_SEARCHES* pSearches,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 HRESULT SearchesExecute(
     __in BURN_SEARCHES* pSearches,
@@ -29,6 +29,14 @@ typedef struct _BURN_SECTION_HEADER
     DWORD rgcbContainers[1];
 } BURN_SECTION_HEADER;
 
+static HRESULT ReadSectionData(
+    __in HANDLE hFile,
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __out_bcount_part(cb, *pcbRead) LPVOID pv,
+    __in DWORD cb,
+    __out DWORD* pcbRead
+    );
 static HRESULT VerifySectionMatchesMemoryPEHeader(
     __in REFGUID pSection
     );
@@ -39,17 +47,40 @@ extern "C" HRESULT SectionInitialize(
     __in HANDLE hEngineFile,
     __in HANDLE hSourceEngineFile
     )
+{
+    HRESULT hr = S_OK;
+    GUID guidBundleId = { };
+
+    hr = SectionParse(pSection, hEngineFile, hSourceEngineFile, TRUE, 0, &guidBundleId);
+    ExitOnFailure(hr, "Failed to parse Burn section.");
+
+    // TODO: verify more than just the GUID.
+    hr = VerifySectionMatchesMemoryPEHeader(guidBundleId);
+    ExitOnRootFailure(hr, "PE Header from file didn't match PE Header in memory.");
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT SectionParse(
+    __in BURN_SECTION* pSection,
+    __in HANDLE hEngineFile,
+    __in HANDLE hSourceEngineFile,
+    __in BOOL fMapped,
+    __in SIZE_T cbMappedWindow,
+    __out GUID* pguidBundleId
+    )
 {
     HRESULT hr = S_OK;
     DWORD cbRead = 0;
-    LARGE_INTEGER li = { };
     LONGLONG llSize = 0;
+    FILE_MAPPED_VIEW view = { };
     IMAGE_DOS_HEADER dosHeader = { };
     IMAGE_NT_HEADERS ntHeader = { };
     DWORD dwChecksumOffset = 0;
     DWORD dwCertificateTableOffset = 0;
-    DWORD dwSignatureOffset = 0;
-    DWORD cbSignature = 0;
+    IMAGE_DATA_DIRECTORY certificateTable = { };
+    DWORD64 qwSectionHeaderOffset = 0;
     IMAGE_SECTION_HEADER sectionHeader = { };
     DWORD dwOriginalChecksumAndSignatureOffset = 0;
     BURN_SECTION_HEADER* pBurnSectionHeader = NULL;
@@ -59,20 +90,25 @@ extern "C" HRESULT SectionInitialize(
 
     pSection->hSourceEngineFile = INVALID_HANDLE_VALUE == hSourceEngineFile ? hEngineFile : hSourceEngineFile;
 
+    // Mapping the engine turns the header reads below into copies out of memory. It is only
+    // an optimization so fall back to reading through the handle when the file cannot be mapped.
+    if (fMapped)
+    {
+        hr = FileMappedViewInitialize(&view, pSection->hEngineFile, cbMappedWindow);
+        if (FAILED(hr))
+        {
+            LogStringLine(REPORT_VERBOSE, "Failed to map engine file, reading it instead, error: 0x%x", hr);
+            hr = S_OK;
+        }
+    }
+
     //
     // First, make sure we have a valid DOS signature.
     //
-    if (!::SetFilePointerEx(pSection->hEngineFile, li, NULL, FILE_BEGIN))
-    {
-        ExitWithLastError(hr, "Failed to seek to start of file.");
-    }
+    hr = ReadSectionData(pSection->hEngineFile, &view, 0, &dosHeader, sizeof(IMAGE_DOS_HEADER), &cbRead);
+    ExitOnFailure(hr, "Failed to read DOS header.");
 
-    // read DOS header
-    if (!::ReadFile(pSection->hEngineFile, &dosHeader, sizeof(IMAGE_DOS_HEADER), &cbRead, NULL))
-    {
-        ExitWithLastError(hr, "Failed to read DOS header.");
-    }
-    else if (sizeof(IMAGE_DOS_HEADER) > cbRead || IMAGE_DOS_SIGNATURE != dosHeader.e_magic)
+    if (sizeof(IMAGE_DOS_HEADER) > cbRead || IMAGE_DOS_SIGNATURE != dosHeader.e_magic)
     {
         hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
         ExitOnRootFailure(hr, "Failed to find valid DOS image header in buffer.");
@@ -81,20 +117,10 @@ extern "C" HRESULT SectionInitialize(
     //
     // Now, make sure we have a valid NT signature.
     //
+    hr = ReadSectionData(pSection->hEngineFile, &view, dosHeader.e_lfanew, &ntHeader, sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER), &cbRead);
+    ExitOnFailure(hr, "Failed to read NT header.");
 
-    // seek to new header
-    li.QuadPart = dosHeader.e_lfanew;
-    if (!::SetFilePointerEx(pSection->hEngineFile, li, NULL, FILE_BEGIN))
-    {
-        ExitWithLastError(hr, "Failed to seek to NT header.");
-    }
-
-    // read NT header
-    if (!::ReadFile(pSection->hEngineFile, &ntHeader, sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER), &cbRead, NULL))
-    {
-        ExitWithLastError(hr, "Failed to read NT header.");
-    }
-    else if ((sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER)) > cbRead || IMAGE_NT_SIGNATURE != ntHeader.Signature)
+    if ((sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER)) > cbRead || IMAGE_NT_SIGNATURE != ntHeader.Signature)
     {
         hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
         ExitOnRootFailure(hr, "Failed to find valid NT image header in buffer.");
@@ -104,42 +130,24 @@ extern "C" HRESULT SectionInitialize(
     dwChecksumOffset = dosHeader.e_lfanew + sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER) + (sizeof(DWORD) * 16);
     dwCertificateTableOffset = dosHeader.e_lfanew + sizeof(IMAGE_NT_HEADERS) - (sizeof(IMAGE_DATA_DIRECTORY) * (IMAGE_NUMBEROF_DIRECTORY_ENTRIES - IMAGE_DIRECTORY_ENTRY_SECURITY));
 
-    // Seek into the certificate table to get the signature size.
-    li.QuadPart = dwCertificateTableOffset;
-    if (!::SetFilePointerEx(pSection->hEngineFile, li, NULL, FILE_BEGIN))
-    {
-        ExitWithLastError(hr, "Failed to seek to section info.");
-    }
-
-    if (!::ReadFile(pSection->hEngineFile, &dwSignatureOffset, sizeof(dwSignatureOffset), &cbRead, NULL))
-    {
-        ExitWithLastError(hr, "Failed to read signature offset.");
-    }
-
-    if (!::ReadFile(pSection->hEngineFile, &cbSignature, sizeof(cbSignature), &cbRead, NULL))
-    {
-        ExitWithLastError(hr, "Failed to read signature size.");
-    }
+    // Read the certificate table to get the signature offset and size.
+    hr = ReadSectionData(pSection->hEngineFile, &view, dwCertificateTableOffset, &certificateTable, sizeof(certificateTable), &cbRead);
+    ExitOnFailure(hr, "Failed to read signature offset and size.");
 
     //
     // Finally, get into the section table and look for the Burn section info.
     //
 
-    // seek past optional headers
-    li.QuadPart = dosHeader.e_lfanew + sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER) + ntHeader.FileHeader.SizeOfOptionalHeader;
-    if (!::SetFilePointerEx(pSection->hEngineFile, li, NULL, FILE_BEGIN))
-    {
-        ExitWithLastError(hr, "Failed to seek past optional headers.");
-    }
+    // skip past optional headers
+    qwSectionHeaderOffset = dosHeader.e_lfanew + sizeof(IMAGE_NT_HEADERS) - sizeof(IMAGE_OPTIONAL_HEADER) + ntHeader.FileHeader.SizeOfOptionalHeader;
 
     // read sections one by one until we find our section
     for (DWORD i = 0; ; ++i)
     {
         // read section
-        if (!::ReadFile(pSection->hEngineFile, &sectionHeader, sizeof(IMAGE_SECTION_HEADER), &cbRead, NULL))
-        {
-            ExitWithLastError(hr, "Failed to read image section header, index: %u", i);
-        }
+        hr = ReadSectionData(pSection->hEngineFile, &view, qwSectionHeaderOffset + i * sizeof(IMAGE_SECTION_HEADER), &sectionHeader, sizeof(IMAGE_SECTION_HEADER), &cbRead);
+        ExitOnFailure(hr, "Failed to read image section header, index: %u", i);
+
         if (sizeof(IMAGE_SECTION_HEADER) > cbRead)
         {
             hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
@@ -176,22 +184,14 @@ extern "C" HRESULT SectionInitialize(
     pBurnSectionHeader = (BURN_SECTION_HEADER*)MemAlloc(sectionHeader.SizeOfRawData, TRUE);
     ExitOnNull(pBurnSectionHeader, hr, E_OUTOFMEMORY, "Failed to allocate buffer for section info.");
 
-    // seek to section info
-    li.QuadPart = sectionHeader.PointerToRawData;
-    if (!::SetFilePointerEx(pSection->hEngineFile, li, NULL, FILE_BEGIN))
-    {
-        ExitWithLastError(hr, "Failed to seek to section info.");
-    }
-
     // Note the location of original checksum and signature information in the burn section header.
     dwOriginalChecksumAndSignatureOffset = sectionHeader.PointerToRawData + (reinterpret_cast<LPBYTE>(&pBurnSectionHeader->dwOriginalChecksum) - reinterpret_cast<LPBYTE>(pBurnSectionHeader));
 
     // read section info
-    if (!::ReadFile(pSection->hEngineFile, pBurnSectionHeader, sectionHeader.SizeOfRawData, &cbRead, NULL))
-    {
-        ExitWithLastError(hr, "Failed to read section info.");
-    }
-    else if (sectionHeader.SizeOfRawData > cbRead)
+    hr = ReadSectionData(pSection->hEngineFile, &view, sectionHeader.PointerToRawData, pBurnSectionHeader, sectionHeader.SizeOfRawData, &cbRead);
+    ExitOnFailure(hr, "Failed to read section info.");
+
+    if (sectionHeader.SizeOfRawData > cbRead)
     {
         hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
         ExitOnRootFailure(hr, "Failed to read complete section info.");
@@ -214,9 +214,9 @@ extern "C" HRESULT SectionInitialize(
     {
         pSection->cbEngineSize = pBurnSectionHeader->dwOriginalSignatureOffset + pBurnSectionHeader->dwOriginalSignatureSize;
     }
-    else if (dwSignatureOffset) // if there is a signature, use it.
+    else if (certificateTable.VirtualAddress) // if there is a signature, use it.
     {
-        pSection->cbEngineSize = dwSignatureOffset + cbSignature;
+        pSection->cbEngineSize = certificateTable.VirtualAddress + certificateTable.Size;
     }
     else // just use the stub and UX container as the size of the engine.
     {
@@ -240,12 +240,11 @@ extern "C" HRESULT SectionInitialize(
 
     memcpy(pSection->rgcbContainers, pBurnSectionHeader->rgcbContainers, sizeof(DWORD) * pSection->cContainers);
 
-    // TODO: verify more than just the GUID.
-    hr = VerifySectionMatchesMemoryPEHeader(pBurnSectionHeader->guidBundleId);
-    ExitOnRootFailure(hr, "PE Header from file didn't match PE Header in memory.");
+    *pguidBundleId = pBurnSectionHeader->guidBundleId;
 
 LExit:
     ReleaseMem(pBurnSectionHeader);
+    FileMappedViewUninitialize(&view);
 
     return hr;
 }
@@ -397,3 +396,37 @@ HRESULT VerifySectionMatchesMemoryPEHeader(
 LExit:
     return hr;
 }
+
+static HRESULT ReadSectionData(
+    __in HANDLE hFile,
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __out_bcount_part(cb, *pcbRead) LPVOID pv,
+    __in DWORD cb,
+    __out DWORD* pcbRead
+    )
+{
+    HRESULT hr = S_OK;
+    SIZE_T cbRead = 0;
+
+    if (pView->hMapping)
+    {
+        hr = FileMappedViewRead(pView, qwOffset, pv, cb, &cbRead);
+        ExitOnFailure(hr, "Failed to read from mapped engine file.");
+
+        *pcbRead = static_cast<DWORD>(cbRead);
+    }
+    else
+    {
+        hr = FileSetPointer(hFile, qwOffset, NULL, FILE_BEGIN);
+        ExitOnFailure(hr, "Failed to seek in engine file.");
+
+        if (!::ReadFile(hFile, pv, cb, pcbRead, NULL))
+        {
+            ExitWithLastError(hr, "Failed to read engine file.");
+        }
+    }
+
+LExit:
+    return hr;
+}
@@ -37,6 +37,14 @@ HRESULT SectionInitialize(
     __in HANDLE hEngineFile,
     __in HANDLE hSourceEngineFile
     );
+HRESULT SectionParse(
+    __in BURN_SECTION* pSection,
+    __in HANDLE hEngineFile,
+    __in HANDLE hSourceEngineFile,
+    __in BOOL fMapped,
+    __in SIZE_T cbMappedWindow,
+    __out GUID* pguidBundleId
+    );
 void SectionUninitialize(
     __in BURN_SECTION* pSection
     );
@@ -10,26 +10,16 @@
 
 extern "C" HRESULT UpdateParseFromXml(
     __in BURN_UPDATE* pUpdate,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNode* pixnUpdateNode = NULL;
-
-    hr = XmlSelectSingleNode(pixnBundle, L"Update", &pixnUpdateNode);
-    if (S_FALSE == hr)
-    {
-        ExitFunction1(hr = S_OK);
-    }
-    ExitOnFailure(hr, "Failed to select Bundle/Update node.");
 
     // @Location
-    hr = XmlGetAttributeEx(pixnUpdateNode, L"Location", &pUpdate->sczUpdateSource);
+    hr = XmlReaderGetAttribute(pReader, L"Location", &pUpdate->sczUpdateSource);
     ExitOnFailure(hr, "Failed to get Update@Location.");
 
 LExit:
-    ReleaseObject(pixnUpdateNode);
-
     return hr;
 }
 
@@ -22,7 +22,7 @@ typedef struct _BURN_UPDATE
 
 HRESULT UpdateParseFromXml(
     __in BURN_UPDATE* pUpdate,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 void UpdateUninitialize(
     __in BURN_UPDATE* pUpdate
@@ -17,6 +17,14 @@ static HRESULT FilterExecuteResult(
     __in LPCWSTR sczEventName
     );
 
+static BOOL ShouldDeliverProgress(
+    __in BURN_USER_EXPERIENCE* pUserExperience,
+    __in BURN_USER_EXPERIENCE_PROGRESS* pProgress,
+    __in_opt LPCVOID pvSource,
+    __in DWORD dwPercentage,
+    __in BOOL fFinal
+    );
+
 
 // function definitions
 
@@ -26,30 +34,36 @@ static HRESULT FilterExecuteResult(
 *******************************************************************/
 extern "C" HRESULT UserExperienceParseFromXml(
     __in BURN_USER_EXPERIENCE* pUserExperience,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNode* pixnUserExperienceNode = NULL;
-
-    // select UX node
-    hr = XmlSelectSingleNode(pixnBundle, L"UX", &pixnUserExperienceNode);
-    if (S_FALSE == hr)
-    {
-        hr = E_NOTFOUND;
-    }
-    ExitOnFailure(hr, "Failed to select user experience node.");
+    DWORD dwUserExperienceDepth = pReader->dwDepth;
+    LPCWSTR wzElement = NULL;
 
     // parse splash screen
-    hr = XmlGetYesNoAttribute(pixnUserExperienceNode, L"SplashScreen", &pUserExperience->fSplashScreen);
+    hr = XmlReaderGetYesNoAttribute(pReader, L"SplashScreen", &pUserExperience->fSplashScreen);
     if (E_NOTFOUND != hr)
     {
         ExitOnFailure(hr, "Failed to to get UX/@SplashScreen");
     }
 
     // parse payloads
-    hr = PayloadsParseFromXml(&pUserExperience->payloads, NULL, NULL, pixnUserExperienceNode);
-    ExitOnFailure(hr, "Failed to parse user experience payloads.");
+    for (;;)
+    {
+        hr = XmlReaderNextElement(pReader, dwUserExperienceDepth, &wzElement);
+        if (S_FALSE == hr)
+        {
+            break;
+        }
+        ExitOnFailure(hr, "Failed to read next user experience element.");
+
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"Payload", -1))
+        {
+            hr = PayloadParseFromXml(&pUserExperience->payloads, NULL, NULL, pReader);
+            ExitOnFailure(hr, "Failed to parse user experience payloads.");
+        }
+    }
 
     // make sure we have at least one payload
     if (0 == pUserExperience->payloads.cPayloads)
@@ -58,9 +72,9 @@ extern "C" HRESULT UserExperienceParseFromXml(
         ExitOnFailure(hr, "Too few UX payloads.");
     }
 
-LExit:
-    ReleaseObject(pixnUserExperienceNode);
+    hr = S_OK;
 
+LExit:
     return hr;
 }
 
@@ -306,10 +320,19 @@ EXTERN_C BAAPI UserExperienceOnApplyBegin(
     args.dwPhaseCount = dwPhaseCount;
 
     results.cbSize = sizeof(results);
+    results.dwProgressInterval = pUserExperience->dwProgressInterval;
+    results.dwProgressMinimumDelta = pUserExperience->dwProgressMinimumDelta;
 
     hr = pUserExperience->pfnBAProc(BOOTSTRAPPER_APPLICATION_MESSAGE_ONAPPLYBEGIN, &args, &results, pUserExperience->pvBAProcContext);
     ExitOnFailure(hr, "BA OnApplyBegin failed.");
 
+    // The cache and execute threads are not running yet so the progress state can be reset without the lock.
+    pUserExperience->dwProgressInterval = results.dwProgressInterval;
+    pUserExperience->dwProgressMinimumDelta = results.dwProgressMinimumDelta;
+    memset(&pUserExperience->cacheAcquireProgress, 0, sizeof(pUserExperience->cacheAcquireProgress));
+    memset(&pUserExperience->executeProgress, 0, sizeof(pUserExperience->executeProgress));
+    memset(&pUserExperience->overallProgress, 0, sizeof(pUserExperience->overallProgress));
+
     if (results.fCancel)
     {
         hr = HRESULT_FROM_WIN32(ERROR_INSTALL_USEREXIT);
@@ -425,6 +448,11 @@ EXTERN_C BAAPI UserExperienceOnCacheAcquireProgress(
     BA_ONCACHEACQUIREPROGRESS_ARGS args = { };
     BA_ONCACHEACQUIREPROGRESS_RESULTS results = { };
 
+    if (!ShouldDeliverProgress(pUserExperience, &pUserExperience->cacheAcquireProgress, wzPayloadId ? wzPayloadId : wzPackageOrContainerId, dwOverallPercentage, dw64Progress == dw64Total))
+    {
+        ExitFunction();
+    }
+
     args.cbSize = sizeof(args);
     args.wzPackageOrContainerId = wzPackageOrContainerId;
     args.wzPayloadId = wzPayloadId;
@@ -1304,6 +1332,11 @@ EXTERN_C BAAPI UserExperienceOnExecuteProgress(
     BA_ONEXECUTEPROGRESS_ARGS args = { };
     BA_ONEXECUTEPROGRESS_RESULTS results = { };
 
+    if (!ShouldDeliverProgress(pUserExperience, &pUserExperience->executeProgress, wzPackageId, dwProgressPercentage, 100 <= dwProgressPercentage))
+    {
+        ExitFunction();
+    }
+
     args.cbSize = sizeof(args);
     args.wzPackageId = wzPackageId;
     args.dwProgressPercentage = dwProgressPercentage;
@@ -1657,13 +1690,18 @@ EXTERN_C BAAPI UserExperienceOnProgress(
     BA_ONPROGRESS_ARGS args = { };
     BA_ONPROGRESS_RESULTS results = { };
 
-    args.cbSize = sizeof(args);
-    args.dwProgressPercentage = dwProgressPercentage;
-    args.dwOverallPercentage = dwOverallPercentage;
+    // Rollback ticks are rare and always delivered. A coalesced tick still has to report an apply error.
+    if (ShouldDeliverProgress(pUserExperience, &pUserExperience->overallProgress, NULL, dwOverallPercentage, fRollback || 100 <= dwOverallPercentage))
+    {
+        args.cbSize = sizeof(args);
+        args.dwProgressPercentage = dwProgressPercentage;
+        args.dwOverallPercentage = dwOverallPercentage;
 
-    results.cbSize = sizeof(results);
+        results.cbSize = sizeof(results);
+
+        hr = pUserExperience->pfnBAProc(BOOTSTRAPPER_APPLICATION_MESSAGE_ONPROGRESS, &args, &results, pUserExperience->pvBAProcContext);
+    }
 
-    hr = pUserExperience->pfnBAProc(BOOTSTRAPPER_APPLICATION_MESSAGE_ONPROGRESS, &args, &results, pUserExperience->pvBAProcContext);
     hr = FilterExecuteResult(pUserExperience, hr, fRollback, results.fCancel, L"OnProgress");
 
     return hr;
@@ -2120,3 +2158,49 @@ static HRESULT FilterExecuteResult(
 LExit:
     return hr;
 }
+
+static BOOL ShouldDeliverProgress(
+    __in BURN_USER_EXPERIENCE* pUserExperience,
+    __in BURN_USER_EXPERIENCE_PROGRESS* pProgress,
+    __in_opt LPCVOID pvSource,
+    __in DWORD dwPercentage,
+    __in BOOL fFinal
+    )
+{
+    BOOL fDeliver = FALSE;
+    DWORD dwNow = ::GetTickCount();
+    DWORD dwElapsed = 0;
+    DWORD dwDelta = 0;
+    DWORD dwPollInterval = 0;
+
+    ::EnterCriticalSection(&pUserExperience->csProgress);
+
+    // The first tick, the final tick and the first tick from a new package or payload are always delivered.
+    if (fFinal || !pProgress->fDelivered || pvSource != pProgress->pvLastSource)
+    {
+        fDeliver = TRUE;
+    }
+    else
+    {
+        dwElapsed = dwNow - pProgress->dwLastTick;
+        if (dwElapsed >= pUserExperience->dwProgressInterval)
+        {
+            dwDelta = dwPercentage > pProgress->dwLastPercentage ? dwPercentage - pProgress->dwLastPercentage : pProgress->dwLastPercentage - dwPercentage;
+            dwPollInterval = max(pUserExperience->dwProgressInterval, BURN_PROGRESS_POLL_INTERVAL);
+
+            fDeliver = dwDelta >= pUserExperience->dwProgressMinimumDelta || dwElapsed >= dwPollInterval;
+        }
+    }
+
+    if (fDeliver)
+    {
+        pProgress->fDelivered = TRUE;
+        pProgress->dwLastTick = dwNow;
+        pProgress->dwLastPercentage = dwPercentage;
+        pProgress->pvLastSource = pvSource;
+    }
+
+    ::LeaveCriticalSection(&pUserExperience->csProgress);
+
+    return fDeliver;
+}
@@ -12,11 +12,27 @@ extern "C" {
 
 const DWORD MB_RETRYTRYAGAIN = 0xF;
 
+// Progress callbacks of the same kind closer together than the interval, or that moved less than
+// the minimum delta, are coalesced. Both can be changed by the UX in OnApplyBegin(). A tick that
+// passes the interval but not the delta is still delivered after the poll interval so the UX always
+// gets a chance to cancel.
+const DWORD BURN_PROGRESS_DEFAULT_INTERVAL = 100;
+const DWORD BURN_PROGRESS_DEFAULT_MINIMUM_DELTA = 1;
+const DWORD BURN_PROGRESS_POLL_INTERVAL = 500;
+
 
 // structs
 
 struct BOOTSTRAPPER_ENGINE_CONTEXT;
 
+typedef struct _BURN_USER_EXPERIENCE_PROGRESS
+{
+    BOOL fDelivered;
+    DWORD dwLastTick;
+    DWORD dwLastPercentage;
+    LPCVOID pvLastSource;
+} BURN_USER_EXPERIENCE_PROGRESS;
+
 typedef struct _BURN_USER_EXPERIENCE
 {
     BOOL fSplashScreen;
@@ -46,13 +62,21 @@ typedef struct _BURN_USER_EXPERIENCE
                                         // during Detect.
 
     DWORD dwExitCode;                   // Exit code returned by the user experience for the engine overall.
+
+    CRITICAL_SECTION csProgress;        // Guards the progress coalescing state since both the cache and execute threads
+                                        // report overall progress. Never held across a UX callback.
+    DWORD dwProgressInterval;           // Minimum milliseconds between two progress callbacks of the same kind.
+    DWORD dwProgressMinimumDelta;       // Minimum change in percentage for a progress callback to be delivered.
+    BURN_USER_EXPERIENCE_PROGRESS cacheAcquireProgress;
+    BURN_USER_EXPERIENCE_PROGRESS executeProgress;
+    BURN_USER_EXPERIENCE_PROGRESS overallProgress;
 } BURN_USER_EXPERIENCE;
 
 // functions
 
 HRESULT UserExperienceParseFromXml(
     __in BURN_USER_EXPERIENCE* pUserExperience,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 void UserExperienceUninitialize(
     __in BURN_USER_EXPERIENCE* pUserExperience
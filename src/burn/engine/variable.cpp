@@ -282,15 +282,12 @@ LExit:
     return hr;
 }
 
-extern "C" HRESULT VariablesParseFromXml(
+extern "C" HRESULT VariableParseFromXml(
     __in BURN_VARIABLES* pVariables,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pixnNodes = NULL;
-    IXMLDOMNode* pixnNode = NULL;
-    DWORD cNodes = 0;
     LPWSTR sczId = NULL;
     LPWSTR scz = NULL;
     BURN_VARIANT value = { };
@@ -301,126 +298,104 @@ extern "C" HRESULT VariablesParseFromXml(
 
     ::EnterCriticalSection(&pVariables->csAccess);
 
-    // select variable nodes
-    hr = XmlSelectNodes(pixnBundle, L"Variable", &pixnNodes);
-    ExitOnFailure(hr, "Failed to select variable nodes.");
+    // @Id
+    hr = XmlReaderGetAttribute(pReader, L"Id", &sczId);
+    ExitOnFailure(hr, "Failed to get @Id.");
 
-    // get variable node count
-    hr = pixnNodes->get_length((long*)&cNodes);
-    ExitOnFailure(hr, "Failed to get variable node count.");
+    // @Hidden
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Hidden", &fHidden);
+    ExitOnFailure(hr, "Failed to get @Hidden.");
 
-    // parse package elements
-    for (DWORD i = 0; i < cNodes; ++i)
-    {
-        hr = XmlNextElement(pixnNodes, &pixnNode, NULL);
-        ExitOnFailure(hr, "Failed to get next node.");
+    // @Persisted
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Persisted", &fPersisted);
+    ExitOnFailure(hr, "Failed to get @Persisted.");
 
-        // @Id
-        hr = XmlGetAttributeEx(pixnNode, L"Id", &sczId);
-        ExitOnFailure(hr, "Failed to get @Id.");
+    // @Value
+    hr = XmlReaderGetAttribute(pReader, L"Value", &scz);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get @Value.");
 
-        // @Hidden
-        hr = XmlGetYesNoAttribute(pixnNode, L"Hidden", &fHidden);
-        ExitOnFailure(hr, "Failed to get @Hidden.");
+        hr = BVariantSetString(&value, scz, 0);
+        ExitOnFailure(hr, "Failed to set variant value.");
 
-        // @Persisted
-        hr = XmlGetYesNoAttribute(pixnNode, L"Persisted", &fPersisted);
-        ExitOnFailure(hr, "Failed to get @Persisted.");
+        // @Type
+        hr = XmlReaderGetAttribute(pReader, L"Type", &scz);
+        ExitOnFailure(hr, "Failed to get @Type.");
 
-        // @Value
-        hr = XmlGetAttributeEx(pixnNode, L"Value", &scz);
-        if (E_NOTFOUND != hr)
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"numeric", -1))
         {
-            ExitOnFailure(hr, "Failed to get @Value.");
-
-            hr = BVariantSetString(&value, scz, 0);
-            ExitOnFailure(hr, "Failed to set variant value.");
-
-            // @Type
-            hr = XmlGetAttributeEx(pixnNode, L"Type", &scz);
-            ExitOnFailure(hr, "Failed to get @Type.");
-
-            if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"numeric", -1))
-            {
-                if (!fHidden)
-                {
-                    LogStringLine(REPORT_STANDARD, "Initializing numeric variable '%ls' to value '%ls'", sczId, value.sczValue);
-                }
-                valueType = BURN_VARIANT_TYPE_NUMERIC;
-            }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"string", -1))
+            if (!fHidden)
             {
-                if (!fHidden)
-                {
-                    LogStringLine(REPORT_STANDARD, "Initializing string variable '%ls' to value '%ls'", sczId, value.sczValue);
-                }
-                valueType = BURN_VARIANT_TYPE_STRING;
+                LogStringLine(REPORT_STANDARD, "Initializing numeric variable '%ls' to value '%ls'", sczId, value.sczValue);
             }
-            else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
+            valueType = BURN_VARIANT_TYPE_NUMERIC;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"string", -1))
+        {
+            if (!fHidden)
             {
-                if (!fHidden)
-                {
-                    LogStringLine(REPORT_STANDARD, "Initializing version variable '%ls' to value '%ls'", sczId, value.sczValue);
-                }
-                valueType = BURN_VARIANT_TYPE_VERSION;
+                LogStringLine(REPORT_STANDARD, "Initializing string variable '%ls' to value '%ls'", sczId, value.sczValue);
             }
-            else
+            valueType = BURN_VARIANT_TYPE_STRING;
+        }
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, scz, -1, L"version", -1))
+        {
+            if (!fHidden)
             {
-                hr = E_INVALIDARG;
-                ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
+                LogStringLine(REPORT_STANDARD, "Initializing version variable '%ls' to value '%ls'", sczId, value.sczValue);
             }
+            valueType = BURN_VARIANT_TYPE_VERSION;
         }
         else
         {
-            valueType = BURN_VARIANT_TYPE_NONE;
+            hr = E_INVALIDARG;
+            ExitOnFailure(hr, "Invalid value for @Type: %ls", scz);
         }
+    }
+    else
+    {
+        valueType = BURN_VARIANT_TYPE_NONE;
+    }
 
-        if (fHidden)
-        {
-            LogStringLine(REPORT_STANDARD, "Initializing hidden variable '%ls'", sczId);
-        }
+    if (fHidden)
+    {
+        LogStringLine(REPORT_STANDARD, "Initializing hidden variable '%ls'", sczId);
+    }
 
-        // change value variant to correct type
-        hr = BVariantChangeType(&value, valueType);
-        ExitOnFailure(hr, "Failed to change variant type.");
+    // change value variant to correct type
+    hr = BVariantChangeType(&value, valueType);
+    ExitOnFailure(hr, "Failed to change variant type.");
 
-        // find existing variable
-        hr = FindVariableIndexByName(pVariables, sczId, &iVariable);
-        ExitOnFailure(hr, "Failed to find variable value '%ls'.", sczId);
+    // find existing variable
+    hr = FindVariableIndexByName(pVariables, sczId, &iVariable);
+    ExitOnFailure(hr, "Failed to find variable value '%ls'.", sczId);
 
-        // insert element if not found
-        if (S_FALSE == hr)
-        {
-            hr = InsertVariable(pVariables, sczId, iVariable);
-            ExitOnFailure(hr, "Failed to insert variable '%ls'.", sczId);
-        }
-        else if (BURN_VARIABLE_INTERNAL_TYPE_NORMAL < pVariables->rgVariables[iVariable].internalType)
-        {
-            hr = E_INVALIDARG;
-            ExitOnRootFailure(hr, "Attempt to set built-in variable value: %ls", sczId);
-        }
-        pVariables->rgVariables[iVariable].fHidden = fHidden;
-        pVariables->rgVariables[iVariable].fPersisted = fPersisted;
-
-        // update variable value
-        hr = BVariantSetValue(&pVariables->rgVariables[iVariable].Value, &value);
-        ExitOnFailure(hr, "Failed to set value of variable: %ls", sczId);
+    // insert element if not found
+    if (S_FALSE == hr)
+    {
+        hr = InsertVariable(pVariables, sczId, iVariable);
+        ExitOnFailure(hr, "Failed to insert variable '%ls'.", sczId);
+    }
+    else if (BURN_VARIABLE_INTERNAL_TYPE_NORMAL < pVariables->rgVariables[iVariable].internalType)
+    {
+        hr = E_INVALIDARG;
+        ExitOnRootFailure(hr, "Attempt to set built-in variable value: %ls", sczId);
+    }
+    pVariables->rgVariables[iVariable].fHidden = fHidden;
+    pVariables->rgVariables[iVariable].fPersisted = fPersisted;
 
-        hr = BVariantSetEncryption(&pVariables->rgVariables[iVariable].Value, fHidden);
-        ExitOnFailure(hr, "Failed to set variant encryption");
+    // update variable value
+    hr = BVariantSetValue(&pVariables->rgVariables[iVariable].Value, &value);
+    ExitOnFailure(hr, "Failed to set value of variable: %ls", sczId);
 
-        // prepare next iteration
-        ReleaseNullObject(pixnNode);
-        BVariantUninitialize(&value);
-        ReleaseNullStrSecure(scz);
-    }
+    hr = BVariantSetEncryption(&pVariables->rgVariables[iVariable].Value, fHidden);
+    ExitOnFailure(hr, "Failed to set variant encryption");
 
 LExit:
     ::LeaveCriticalSection(&pVariables->csAccess);
 
-    ReleaseObject(pixnNodes);
-    ReleaseObject(pixnNode);
-    ReleaseStr(scz);
+    ReleaseNullStrSecure(scz);
     ReleaseStr(sczId);
     BVariantUninitialize(&value);
 
@@ -820,11 +795,19 @@ extern "C" HRESULT VariableSerialize(
     LONGLONG ll = 0;
     LPWSTR scz = NULL;
     DWORD64 qw = 0;
+    BUFF_WRITER writer = { };
 
     ::EnterCriticalSection(&pVariables->csAccess);
 
+    hr = BuffWriterAttach(&writer, *ppbBuffer, *piBuffer);
+    ExitOnFailure(hr, "Failed to attach to serialization buffer.");
+
+    // Most variables serialize to well under this, so this avoids most of the growth along the way.
+    hr = BuffWriterReserve(&writer, pVariables->cVariables * 64);
+    ExitOnFailure(hr, "Failed to reserve space for variables.");
+
     // Write variable count.
-    hr = BuffWriteNumber(ppbBuffer, piBuffer, pVariables->cVariables);
+    hr = BuffWriterWriteNumber(&writer, pVariables->cVariables);
     ExitOnFailure(hr, "Failed to write variable count.");
 
     // Write variables.
@@ -838,7 +821,7 @@ extern "C" HRESULT VariableSerialize(
                     (fPersisting && pVariable->fPersisted);
 
         // Write included flag.
-        hr = BuffWriteNumber(ppbBuffer, piBuffer, (DWORD)fIncluded);
+        hr = BuffWriterWriteNumber(&writer, (DWORD)fIncluded);
         ExitOnFailure(hr, "Failed to write included flag.");
 
         if (!fIncluded)
@@ -847,11 +830,11 @@ extern "C" HRESULT VariableSerialize(
         }
 
         // Write variable name.
-        hr = BuffWriteString(ppbBuffer, piBuffer, pVariable->sczName);
+        hr = BuffWriterWriteString(&writer, pVariable->sczName);
         ExitOnFailure(hr, "Failed to write variable name.");
 
         // Write variable value type.
-        hr = BuffWriteNumber(ppbBuffer, piBuffer, (DWORD)pVariable->Value.Type);
+        hr = BuffWriterWriteNumber(&writer, (DWORD)pVariable->Value.Type);
         ExitOnFailure(hr, "Failed to write variable value type.");
 
         // Write variable value.
@@ -863,7 +846,7 @@ extern "C" HRESULT VariableSerialize(
             hr = BVariantGetNumeric(&pVariable->Value, &ll);
             ExitOnFailure(hr, "Failed to get numeric.");
 
-            hr = BuffWriteNumber64(ppbBuffer, piBuffer, static_cast<DWORD64>(ll));
+            hr = BuffWriterWriteNumber64(&writer, static_cast<DWORD64>(ll));
             ExitOnFailure(hr, "Failed to write variable value as number.");
 
             SecureZeroMemory(&ll, sizeof(ll));
@@ -872,7 +855,7 @@ extern "C" HRESULT VariableSerialize(
             hr = BVariantGetVersion(&pVariable->Value, &qw);
             ExitOnFailure(hr, "Failed to get version.");
 
-            hr = BuffWriteNumber64(ppbBuffer, piBuffer, qw);
+            hr = BuffWriterWriteNumber64(&writer, qw);
             ExitOnFailure(hr, "Failed to write variable value as number.");
 
             SecureZeroMemory(&qw, sizeof(qw));
@@ -881,7 +864,7 @@ extern "C" HRESULT VariableSerialize(
             hr = BVariantGetString(&pVariable->Value, &scz);
             ExitOnFailure(hr, "Failed to get string.");
 
-            hr = BuffWriteString(ppbBuffer, piBuffer, scz);
+            hr = BuffWriterWriteString(&writer, scz);
             ExitOnFailure(hr, "Failed to write variable value as string.");
 
             ReleaseNullStrSecure(scz);
@@ -892,12 +875,19 @@ extern "C" HRESULT VariableSerialize(
         }
 
         // Write literal flag.
-        hr = BuffWriteNumber(ppbBuffer, piBuffer, (DWORD)pVariable->fLiteral);
+        hr = BuffWriterWriteNumber(&writer, (DWORD)pVariable->fLiteral);
         ExitOnFailure(hr, "Failed to write literal flag.");
     }
 
 LExit:
     ::LeaveCriticalSection(&pVariables->csAccess);
+
+    // hand back whatever was written, even on failure, since the buffer may have moved
+    if (writer.pbData)
+    {
+        BuffWriterDetach(&writer, ppbBuffer, piBuffer);
+    }
+
     SecureZeroMemory(&ll, sizeof(ll));
     SecureZeroMemory(&qw, sizeof(qw));
     StrSecureZeroFreeString(scz);
@@ -919,20 +909,24 @@ extern "C" HRESULT VariableDeserialize(
     BOOL fIncluded = FALSE;
     BOOL fLiteral = FALSE;
     BURN_VARIANT value = { };
-    LPWSTR scz = NULL;
+    LPCWSTR wz = NULL;
+    DWORD cch = 0;
     DWORD64 qw = 0;
+    BUFF_READER reader = { };
+
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, *piBuffer);
 
     ::EnterCriticalSection(&pVariables->csAccess);
 
     // Read variable count.
-    hr = BuffReadNumber(pbBuffer, cbBuffer, piBuffer, &cVariables);
+    hr = BuffReaderReadNumber(&reader, &cVariables);
     ExitOnFailure(hr, "Failed to read variable count.");
 
     // Read variables.
     for (DWORD i = 0; i < cVariables; ++i)
     {
         // Read variable included flag.
-        hr = BuffReadNumber(pbBuffer, cbBuffer, piBuffer, (DWORD*)&fIncluded);
+        hr = BuffReaderReadNumber(&reader, (DWORD*)&fIncluded);
         ExitOnFailure(hr, "Failed to read variable included flag.");
 
         if (!fIncluded)
@@ -941,11 +935,14 @@ extern "C" HRESULT VariableDeserialize(
         }
 
         // Read variable name.
-        hr = BuffReadString(pbBuffer, cbBuffer, piBuffer, &sczName);
+        hr = BuffReaderReadStringView(&reader, &wz, &cch);
         ExitOnFailure(hr, "Failed to read variable name.");
 
+        hr = StrAllocString(&sczName, wz, cch);
+        ExitOnFailure(hr, "Failed to copy variable name.");
+
         // Read variable value type.
-        hr = BuffReadNumber(pbBuffer, cbBuffer, piBuffer, (DWORD*)&value.Type);
+        hr = BuffReaderReadNumber(&reader, (DWORD*)&value.Type);
         ExitOnFailure(hr, "Failed to read variable value type.");
 
         // Read variable value.
@@ -954,7 +951,7 @@ extern "C" HRESULT VariableDeserialize(
         case BURN_VARIANT_TYPE_NONE:
             break;
         case BURN_VARIANT_TYPE_NUMERIC:
-            hr = BuffReadNumber64(pbBuffer, cbBuffer, piBuffer, &qw);
+            hr = BuffReaderReadNumber64(&reader, &qw);
             ExitOnFailure(hr, "Failed to read variable value as number.");
 
             hr = BVariantSetNumeric(&value, static_cast<LONGLONG>(qw));
@@ -963,7 +960,7 @@ extern "C" HRESULT VariableDeserialize(
             SecureZeroMemory(&qw, sizeof(qw));
             break;
         case BURN_VARIANT_TYPE_VERSION:
-            hr = BuffReadNumber64(pbBuffer, cbBuffer, piBuffer, &qw);
+            hr = BuffReaderReadNumber64(&reader, &qw);
             ExitOnFailure(hr, "Failed to read variable value as number.");
 
             hr = BVariantSetVersion(&value, qw);
@@ -972,13 +969,12 @@ extern "C" HRESULT VariableDeserialize(
             SecureZeroMemory(&qw, sizeof(qw));
             break;
         case BURN_VARIANT_TYPE_STRING:
-            hr = BuffReadString(pbBuffer, cbBuffer, piBuffer, &scz);
+            // Set straight from the buffer so the value is not copied into an intermediate string.
+            hr = BuffReaderReadStringView(&reader, &wz, &cch);
             ExitOnFailure(hr, "Failed to read variable value as string.");
 
-            hr = BVariantSetString(&value, scz, NULL);
+            hr = BVariantSetString(&value, wz, cch);
             ExitOnFailure(hr, "Failed to set variable value.");
-
-            ReleaseNullStrSecure(scz);
             break;
         default:
             hr = E_INVALIDARG;
@@ -986,7 +982,7 @@ extern "C" HRESULT VariableDeserialize(
         }
 
         // Read variable literal flag.
-        hr = BuffReadNumber(pbBuffer, cbBuffer, piBuffer, (DWORD*)&fLiteral);
+        hr = BuffReaderReadNumber(&reader, (DWORD*)&fLiteral);
         ExitOnFailure(hr, "Failed to read variable literal flag.");
 
         // Set variable.
@@ -1000,10 +996,11 @@ extern "C" HRESULT VariableDeserialize(
 LExit:
     ::LeaveCriticalSection(&pVariables->csAccess);
 
+    *piBuffer = reader.iData;
+
     ReleaseStr(sczName);
     BVariantUninitialize(&value);
     SecureZeroMemory(&qw, sizeof(qw));
-    StrSecureZeroFreeString(scz);
 
     return hr;
 }
@@ -63,9 +63,9 @@ typedef struct _BURN_VARIABLES
 HRESULT VariableInitialize(
     __in BURN_VARIABLES* pVariables
     );
-HRESULT VariablesParseFromXml(
+HRESULT VariableParseFromXml(
     __in BURN_VARIABLES* pVariables,
-    __in IXMLDOMNode* pixnBundle
+    __in XML_READER* pReader
     );
 void VariablesUninitialize(
     __in BURN_VARIABLES* pVariables
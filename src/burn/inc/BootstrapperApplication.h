@@ -244,6 +244,11 @@ struct BA_ONAPPLYBEGIN_RESULTS
 {
     DWORD cbSize;
     BOOL fCancel;
+
+    // Rate of OnCacheAcquireProgress, OnExecuteProgress and OnProgress for this apply. The engine
+    // fills in its current values. Set both to zero to receive every progress tick.
+    DWORD dwProgressInterval; // milliseconds
+    DWORD dwProgressMinimumDelta; // percentage points
 };
 
 struct BA_ONAPPLYCOMPLETE_ARGS
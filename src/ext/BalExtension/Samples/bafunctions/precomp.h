@@ -15,7 +15,7 @@
 // Standard WiX header files, include as required
 #include "dutil.h"
 //#include "memutil.h"
-//#include "dictutil.h"
+#include "dictutil.h"
 //#include "dirutil.h"
 #include "fileutil.h"
 #include "locutil.h"
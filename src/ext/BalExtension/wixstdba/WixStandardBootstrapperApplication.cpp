@@ -1711,6 +1711,7 @@ private: // privates
     {
         HRESULT hr = S_OK;
         LPWSTR sczModulePath = NULL;
+        LPWSTR sczManifestPath = NULL;
         IXMLDOMDocument *pixdManifest = NULL;
 
         hr = BalManifestLoad(m_hModule, &pixdManifest);
@@ -1731,7 +1732,11 @@ private: // privates
         hr = LoadTheme(sczModulePath, m_sczLanguage);
         ExitOnFailure(hr, "Failed to load theme.");
 
-        hr = BalInfoParseFromXml(&m_Bundle, pixdManifest);
+        // The bundle and package information is read straight from the file rather than from the DOM.
+        hr = PathRelativeToModule(&sczManifestPath, BAL_MANIFEST_FILENAME, m_hModule);
+        BalExitOnFailure(hr, "Failed to get path to bootstrapper application manifest.");
+
+        hr = BalInfoParseFromFile(&m_Bundle, sczManifestPath);
         BalExitOnFailure(hr, "Failed to load bundle information.");
 
         hr = BalConditionsParseFromXml(&m_Conditions, pixdManifest, m_pWixLoc);
@@ -1756,6 +1761,7 @@ private: // privates
 
     LExit:
         ReleaseObject(pixdManifest);
+        ReleaseStr(sczManifestPath);
         ReleaseStr(sczModulePath);
 
         return hr;
@@ -1159,10 +1159,15 @@ static HRESULT RemoveComponents(
 {
     HRESULT hr = S_OK;
 
+    CPI_COLLECTION_INDEX idxComp;
+    ::ZeroMemory(&idxComp, sizeof(idxComp));
+
+    CpiCollectionIndexInitialize(piCompColl, &idxComp);
+
     for (CPI_COMPONENT* pItm = pCompList; pItm; pItm = pItm->pNext)
     {
         // remove
-        hr = CpiRemoveCollectionObject(piCompColl, pItm->wzCLSID, NULL, FALSE);
+        hr = CpiCollectionIndexRemoveByStringKey(&idxComp, pItm->wzCLSID);
         ExitOnFailure(hr, "Failed to remove component");
 
         if (S_FALSE == hr)
@@ -1172,6 +1177,9 @@ static HRESULT RemoveComponents(
     hr = S_OK;
 
 LExit:
+    // clean up
+    CpiCollectionIndexUninitialize(&idxComp);
+
     return hr;
 }
 
@@ -1301,7 +1309,8 @@ static HRESULT ConfigureComponents(
     ICatalogCollection* piCompColl = NULL;
     ICatalogObject* piCompObj = NULL;
 
-    long lChanges = 0;
+    CPI_COLLECTION_INDEX idxComp;
+    ::ZeroMemory(&idxComp, sizeof(idxComp));
 
     // get components collection
     hr = CpiGetComponentsCollection(pwzPartID, pwzAppID, &piCompColl);
@@ -1312,6 +1321,8 @@ static HRESULT ConfigureComponents(
             ExitFunction1(hr = S_OK);
     ExitOnFailure(hr, "Failed to get components collection");
 
+    CpiCollectionIndexInitialize(piCompColl, &idxComp);
+
     // read components
     for (CPI_COMPONENT* pItm = pCompList; pItm; pItm = pItm->pNext)
     {
@@ -1326,7 +1337,7 @@ static HRESULT ConfigureComponents(
         }
 
         // find component
-        hr = CpiFindCollectionObjectByStringKey(piCompColl, pItm->wzCLSID, &piCompObj);
+        hr = CpiCollectionIndexFindByStringKey(&idxComp, pItm->wzCLSID, &piCompObj);
         if (S_FALSE == hr)
             if (fCreate)
                 hr = HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
@@ -1335,7 +1346,7 @@ static HRESULT ConfigureComponents(
         ExitOnFailure(hr, "Failed to find component object");
 
         // properties
-        hr = CpiPutCollectionObjectValues(piCompObj, pItm->pPropertyList);
+        hr = CpiCollectionIndexPutObjectValues(&idxComp, piCompObj, pItm->pPropertyList);
         ExitOnFailure(hr, "Failed to write properties");
 
         // read roles
@@ -1357,15 +1368,14 @@ static HRESULT ConfigureComponents(
     }
 
     // save changes
-    hr = piCompColl->SaveChanges(&lChanges);
-    if (COMADMIN_E_OBJECTERRORS == hr)
-        CpiLogCatalogErrorInfo();
+    hr = CpiCollectionIndexSaveChanges(&idxComp);
     ExitOnFailure(hr, "Failed to save changes");
 
     hr = S_OK;
 
 LExit:
     // clean up
+    CpiCollectionIndexUninitialize(&idxComp);
     ReleaseObject(piCompColl);
     ReleaseObject(piCompObj);
 
@@ -1384,7 +1394,8 @@ static HRESULT ConfigureInterfaces(
     ICatalogCollection* piIntfColl = NULL;
     ICatalogObject* piIntfObj = NULL;
 
-    long lChanges = 0;
+    CPI_COLLECTION_INDEX idxIntf;
+    ::ZeroMemory(&idxIntf, sizeof(idxIntf));
 
     // get interfaces collection
     hr = CpiGetInterfacesCollection(piCompColl, piCompObj, &piIntfColl);
@@ -1395,11 +1406,13 @@ static HRESULT ConfigureInterfaces(
             ExitFunction1(hr = S_OK);
     ExitOnFailure(hr, "Failed to get interfaces collection");
 
+    CpiCollectionIndexInitialize(piIntfColl, &idxIntf);
+
     // read interfaces
     for (CPI_INTERFACE* pItm = pIntfList; pItm; pItm = pItm->pNext)
     {
         // find interface
-        hr = CpiFindCollectionObjectByStringKey(piIntfColl, pItm->wzIID, &piIntfObj);
+        hr = CpiCollectionIndexFindByStringKey(&idxIntf, pItm->wzIID, &piIntfObj);
         if (S_FALSE == hr)
             if (fCreate)
                 hr = HRESULT_FROM_WIN32(ERROR_NOT_FOUND);
@@ -1408,7 +1421,7 @@ static HRESULT ConfigureInterfaces(
         ExitOnFailure(hr, "Failed to find interface object");
 
         // properties
-        hr = CpiPutCollectionObjectValues(piIntfObj, pItm->pPropertyList);
+        hr = CpiCollectionIndexPutObjectValues(&idxIntf, piIntfObj, pItm->pPropertyList);
         ExitOnFailure(hr, "Failed to write properties");
 
         // read roles
@@ -1430,15 +1443,14 @@ static HRESULT ConfigureInterfaces(
     }
 
     // save changes
-    hr = piIntfColl->SaveChanges(&lChanges);
-    if (COMADMIN_E_OBJECTERRORS == hr)
-        CpiLogCatalogErrorInfo();
+    hr = CpiCollectionIndexSaveChanges(&idxIntf);
     ExitOnFailure(hr, "Failed to save changes");
 
     hr = S_OK;
 
 LExit:
     // clean up
+    CpiCollectionIndexUninitialize(&idxIntf);
     ReleaseObject(piIntfColl);
     ReleaseObject(piIntfObj);
 
@@ -1457,7 +1469,8 @@ static HRESULT ConfigureMethods(
     ICatalogCollection* piMethColl = NULL;
     ICatalogObject* piMethObj = NULL;
 
-    long lChanges = 0;
+    CPI_COLLECTION_INDEX idxMeth;
+    ::ZeroMemory(&idxMeth, sizeof(idxMeth));
 
     // get methods collection
     hr = CpiGetMethodsCollection(piIntfColl, piIntfObj, &piMethColl);
@@ -1468,14 +1481,16 @@ static HRESULT ConfigureMethods(
             ExitFunction1(hr = S_OK);
     ExitOnFailure(hr, "Failed to get methods collection");
 
+    CpiCollectionIndexInitialize(piMethColl, &idxMeth);
+
     // read methods
     for (CPI_METHOD* pItm = pMethList; pItm; pItm = pItm->pNext)
     {
         // find method
         if (*pItm->wzIndex)
-            hr = CpiFindCollectionObjectByIntegerKey(piMethColl, _wtol(pItm->wzIndex), &piMethObj);
+            hr = CpiCollectionIndexFindByIntegerKey(&idxMeth, _wtol(pItm->wzIndex), &piMethObj);
         else
-            hr = CpiFindCollectionObjectByName(piMethColl, pItm->wzName, &piMethObj);
+            hr = CpiCollectionIndexFindByName(&idxMeth, pItm->wzName, &piMethObj);
 
         if (S_FALSE == hr)
             if (fCreate)
@@ -1485,7 +1500,7 @@ static HRESULT ConfigureMethods(
         ExitOnFailure(hr, "Failed to find method object");
 
         // properties
-        hr = CpiPutCollectionObjectValues(piMethObj, pItm->pPropertyList);
+        hr = CpiCollectionIndexPutObjectValues(&idxMeth, piMethObj, pItm->pPropertyList);
         ExitOnFailure(hr, "Failed to write properties");
 
         // read roles
@@ -1500,15 +1515,14 @@ static HRESULT ConfigureMethods(
     }
 
     // save changes
-    hr = piMethColl->SaveChanges(&lChanges);
-    if (COMADMIN_E_OBJECTERRORS == hr)
-        CpiLogCatalogErrorInfo();
+    hr = CpiCollectionIndexSaveChanges(&idxMeth);
     ExitOnFailure(hr, "Failed to save changes");
 
     hr = S_OK;
 
 LExit:
     // clean up
+    CpiCollectionIndexUninitialize(&idxMeth);
     ReleaseObject(piMethColl);
     ReleaseObject(piMethObj);
 
@@ -60,6 +60,20 @@ static HRESULT ReadFileAll(
     PBYTE pbBuffer,
     DWORD dwBufferLength
     );
+static HRESULT EnsureCollectionIndex(
+    CPI_COLLECTION_INDEX* pIndex
+    );
+static HRESULT BuildCollectionIndex(
+    CPI_COLLECTION_INDEX* pIndex
+    );
+static void FreeCollectionIndexObjects(
+    CPI_COLLECTION_INDEX* pIndex
+    );
+static HRESULT FindCollectionIndexObject(
+    STRINGDICT_HANDLE shDict,
+    LPCWSTR pwzKey,
+    CPI_COLLECTION_OBJECT** ppItm
+    );
 
 
 // variables
@@ -894,6 +908,193 @@ LExit:
     return hr;
 }
 
+void CpiCollectionIndexInitialize(
+    ICatalogCollection* piColl,
+    CPI_COLLECTION_INDEX* pIndex
+    )
+{
+    ::ZeroMemory(pIndex, sizeof(CPI_COLLECTION_INDEX));
+
+    pIndex->piColl = piColl;
+    pIndex->piColl->AddRef();
+}
+
+void CpiCollectionIndexUninitialize(
+    CPI_COLLECTION_INDEX* pIndex
+    )
+{
+    FreeCollectionIndexObjects(pIndex);
+    ReleaseObject(pIndex->piColl);
+
+    ::ZeroMemory(pIndex, sizeof(CPI_COLLECTION_INDEX));
+}
+
+HRESULT CpiCollectionIndexFindByStringKey(
+    CPI_COLLECTION_INDEX* pIndex,
+    LPCWSTR pwzKey,
+    ICatalogObject** ppiObj
+    )
+{
+    HRESULT hr = S_OK;
+    CPI_COLLECTION_OBJECT* pItm = NULL;
+
+    hr = EnsureCollectionIndex(pIndex);
+    ExitOnFailure(hr, "Failed to index collection");
+
+    hr = FindCollectionIndexObject(pIndex->shKeys, pwzKey, &pItm);
+    ExitOnFailure(hr, "Failed to find object by key: %S", pwzKey);
+
+    if (S_OK == hr && ppiObj)
+    {
+        *ppiObj = pItm->piObj;
+        (*ppiObj)->AddRef();
+    }
+
+LExit:
+    return hr;
+}
+
+HRESULT CpiCollectionIndexFindByIntegerKey(
+    CPI_COLLECTION_INDEX* pIndex,
+    long lKey,
+    ICatalogObject** ppiObj
+    )
+{
+    HRESULT hr = S_OK;
+    WCHAR wzKey[12]; // long as a string, with sign and terminator
+    CPI_COLLECTION_OBJECT* pItm = NULL;
+
+    hr = ::StringCchPrintfW(wzKey, countof(wzKey), L"%ld", lKey);
+    ExitOnFailure(hr, "Failed to format integer key");
+
+    hr = EnsureCollectionIndex(pIndex);
+    ExitOnFailure(hr, "Failed to index collection");
+
+    hr = FindCollectionIndexObject(pIndex->shIntegerKeys, wzKey, &pItm);
+    ExitOnFailure(hr, "Failed to find object by integer key: %ld", lKey);
+
+    if (S_OK == hr && ppiObj)
+    {
+        *ppiObj = pItm->piObj;
+        (*ppiObj)->AddRef();
+    }
+
+LExit:
+    return hr;
+}
+
+HRESULT CpiCollectionIndexFindByName(
+    CPI_COLLECTION_INDEX* pIndex,
+    LPCWSTR pwzName,
+    ICatalogObject** ppiObj
+    )
+{
+    HRESULT hr = S_OK;
+    CPI_COLLECTION_OBJECT* pItm = NULL;
+
+    hr = EnsureCollectionIndex(pIndex);
+    ExitOnFailure(hr, "Failed to index collection");
+
+    hr = FindCollectionIndexObject(pIndex->shNames, pwzName, &pItm);
+    ExitOnFailure(hr, "Failed to find object by name: %S", pwzName);
+
+    if (S_OK == hr && ppiObj)
+    {
+        *ppiObj = pItm->piObj;
+        (*ppiObj)->AddRef();
+    }
+
+LExit:
+    return hr;
+}
+
+HRESULT CpiCollectionIndexPutObjectValues(
+    CPI_COLLECTION_INDEX* pIndex,
+    ICatalogObject* piObj,
+    CPI_PROPERTY* pPropList
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (pPropList)
+    {
+        // the changes are saved with the rest of the collection
+        pIndex->fChanged = TRUE;
+
+        hr = CpiPutCollectionObjectValues(piObj, pPropList);
+        ExitOnFailure(hr, "Failed to write properties");
+    }
+
+LExit:
+    return hr;
+}
+
+HRESULT CpiCollectionIndexRemoveByStringKey(
+    CPI_COLLECTION_INDEX* pIndex,
+    LPCWSTR pwzKey
+    )
+{
+    HRESULT hr = S_OK;
+    CPI_COLLECTION_OBJECT* pItm = NULL;
+
+    hr = EnsureCollectionIndex(pIndex);
+    ExitOnFailure(hr, "Failed to index collection");
+
+    hr = FindCollectionIndexObject(pIndex->shKeys, pwzKey, &pItm);
+    ExitOnFailure(hr, "Failed to find object by key: %S", pwzKey);
+
+    if (S_FALSE == hr)
+        ExitFunction();
+
+    // remove object
+    hr = pIndex->piColl->Remove(pItm->lIndex);
+    ExitOnFailure(hr, "Failed to remove object from collection");
+
+    pIndex->fChanged = TRUE;
+
+    // the objects after the removed one move up in the collection
+    for (long i = (long)(pItm - pIndex->rgObjects) + 1; i < pIndex->cObjects; i++)
+    {
+        if (pIndex->rgObjects[i].piObj)
+            pIndex->rgObjects[i].lIndex--;
+    }
+
+    ReleaseNullObject(pItm->piObj);
+    pItm->lIndex = -1;
+
+    hr = S_OK;
+
+LExit:
+    return hr;
+}
+
+HRESULT CpiCollectionIndexSaveChanges(
+    CPI_COLLECTION_INDEX* pIndex
+    )
+{
+    HRESULT hr = S_OK;
+    long lChanges = 0;
+
+    if (!pIndex->fChanged)
+        ExitFunction();
+
+    // save changes
+    hr = pIndex->piColl->SaveChanges(&lChanges);
+    if (COMADMIN_E_OBJECTERRORS == hr)
+        CpiLogCatalogErrorInfo();
+    ExitOnFailure(hr, "Failed to save changes");
+
+    // the catalog may have changed the saved objects, so the index is rebuilt on the next lookup
+    FreeCollectionIndexObjects(pIndex);
+    pIndex->fRepopulate = TRUE;
+    pIndex->fChanged = FALSE;
+
+    hr = S_OK;
+
+LExit:
+    return hr;
+}
+
 HRESULT CpiGetPartitionsCollection(
     ICatalogCollection** ppiPartColl
     )
@@ -1879,3 +2080,204 @@ static HRESULT ReadFileAll(
 LExit:
     return hr;
 }
+
+static HRESULT EnsureCollectionIndex(
+    CPI_COLLECTION_INDEX* pIndex
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (pIndex->fIndexed)
+        ExitFunction();
+
+    // the collection was populated when it was retrieved, it only needs to be refreshed after changes were saved
+    if (pIndex->fRepopulate)
+    {
+        hr = pIndex->piColl->Populate();
+        ExitOnFailure(hr, "Failed to populate collection");
+
+        pIndex->fRepopulate = FALSE;
+    }
+
+    hr = BuildCollectionIndex(pIndex);
+    ExitOnFailure(hr, "Failed to build collection index");
+
+    pIndex->fIndexed = TRUE;
+
+LExit:
+    return hr;
+}
+
+static HRESULT BuildCollectionIndex(
+    CPI_COLLECTION_INDEX* pIndex
+    )
+{
+    HRESULT hr = S_OK;
+
+    IDispatch* piDisp = NULL;
+    ICatalogObject* piObj = NULL;
+    CPI_COLLECTION_OBJECT* pItm = NULL;
+
+    VARIANT vtKey;
+    VARIANT vtVal;
+    ::VariantInit(&vtKey);
+    ::VariantInit(&vtVal);
+
+    long lCnt;
+    hr = pIndex->piColl->get_Count(&lCnt);
+    ExitOnFailure(hr, "Failed to get to number of items in collection");
+
+    if (lCnt)
+    {
+        pIndex->rgObjects = (CPI_COLLECTION_OBJECT*)::HeapAlloc(::GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(CPI_COLLECTION_OBJECT) * lCnt);
+        ExitOnNull(pIndex->rgObjects, hr, E_OUTOFMEMORY, "Failed to allocate collection index");
+    }
+
+    // the array is never reallocated, so the dictionaries can point straight into it
+    hr = DictCreateWithEmbeddedKey(&pIndex->shKeys, lCnt, NULL, offsetof(CPI_COLLECTION_OBJECT, pwzKey), DICT_FLAG_CASEINSENSITIVE);
+    ExitOnFailure(hr, "Failed to create key dictionary");
+
+    hr = DictCreateWithEmbeddedKey(&pIndex->shIntegerKeys, lCnt, NULL, offsetof(CPI_COLLECTION_OBJECT, pwzIntegerKey), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create integer key dictionary");
+
+    hr = DictCreateWithEmbeddedKey(&pIndex->shNames, lCnt, NULL, offsetof(CPI_COLLECTION_OBJECT, pwzName), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create name dictionary");
+
+    for (long i = 0; i < lCnt; i++)
+    {
+        pItm = &pIndex->rgObjects[i];
+        pIndex->cObjects = i + 1;
+        pItm->lIndex = i;
+
+        // get ICatalogObject interface
+        hr = pIndex->piColl->get_Item(i, &piDisp);
+        ExitOnFailure(hr, "Failed to get object from collection");
+
+        hr = piDisp->QueryInterface(IID_ICatalogObject, (void**)&piObj);
+        ExitOnFailure(hr, "Failed to get IID_ICatalogObject interface");
+
+        // key
+        hr = piObj->get_Key(&vtKey);
+        ExitOnFailure(hr, "Failed to get key");
+
+        hr = ::VariantChangeType(&vtVal, &vtKey, 0, VT_BSTR);
+        ExitOnFailure(hr, "Failed to change variant type");
+
+        hr = StrAllocString(&pItm->pwzKey, vtVal.bstrVal, 0);
+        ExitOnFailure(hr, "Failed to copy key");
+
+        ::VariantClear(&vtVal);
+
+        // integer key, only some collections have one
+        if (SUCCEEDED(::VariantChangeType(&vtVal, &vtKey, 0, VT_I4)))
+        {
+            hr = StrAllocFormatted(&pItm->pwzIntegerKey, L"%ld", vtVal.lVal);
+            ExitOnFailure(hr, "Failed to format integer key");
+        }
+
+        ::VariantClear(&vtVal);
+
+        // name
+        hr = piObj->get_Name(&vtVal);
+        ExitOnFailure(hr, "Failed to get name");
+
+        hr = ::VariantChangeType(&vtVal, &vtVal, 0, VT_BSTR);
+        ExitOnFailure(hr, "Failed to change variant type");
+
+        hr = StrAllocString(&pItm->pwzName, vtVal.bstrVal, 0);
+        ExitOnFailure(hr, "Failed to copy name");
+
+        // index the object, the first of any duplicates wins like it did for a linear search
+        if (S_OK != DictKeyExists(pIndex->shKeys, pItm->pwzKey))
+        {
+            hr = DictAddValue(pIndex->shKeys, pItm);
+            ExitOnFailure(hr, "Failed to index object by key");
+        }
+
+        if (pItm->pwzIntegerKey && S_OK != DictKeyExists(pIndex->shIntegerKeys, pItm->pwzIntegerKey))
+        {
+            hr = DictAddValue(pIndex->shIntegerKeys, pItm);
+            ExitOnFailure(hr, "Failed to index object by integer key");
+        }
+
+        if (S_OK != DictKeyExists(pIndex->shNames, pItm->pwzName))
+        {
+            hr = DictAddValue(pIndex->shNames, pItm);
+            ExitOnFailure(hr, "Failed to index object by name");
+        }
+
+        pItm->piObj = piObj;
+        piObj = NULL;
+
+        // clean up
+        ReleaseNullObject(piDisp);
+
+        ::VariantClear(&vtKey);
+        ::VariantClear(&vtVal);
+    }
+
+    hr = S_OK;
+
+LExit:
+    if (FAILED(hr))
+        FreeCollectionIndexObjects(pIndex);
+
+    // clean up
+    ReleaseObject(piDisp);
+    ReleaseObject(piObj);
+
+    ::VariantClear(&vtKey);
+    ::VariantClear(&vtVal);
+
+    return hr;
+}
+
+static void FreeCollectionIndexObjects(
+    CPI_COLLECTION_INDEX* pIndex
+    )
+{
+    ReleaseDict(pIndex->shKeys);
+    ReleaseDict(pIndex->shIntegerKeys);
+    ReleaseDict(pIndex->shNames);
+
+    if (pIndex->rgObjects)
+    {
+        for (long i = 0; i < pIndex->cObjects; i++)
+        {
+            ReleaseStr(pIndex->rgObjects[i].pwzKey);
+            ReleaseStr(pIndex->rgObjects[i].pwzIntegerKey);
+            ReleaseStr(pIndex->rgObjects[i].pwzName);
+            ReleaseObject(pIndex->rgObjects[i].piObj);
+        }
+
+        ::HeapFree(::GetProcessHeap(), 0, pIndex->rgObjects);
+    }
+
+    pIndex->shKeys = NULL;
+    pIndex->shIntegerKeys = NULL;
+    pIndex->shNames = NULL;
+    pIndex->rgObjects = NULL;
+    pIndex->cObjects = 0;
+    pIndex->fIndexed = FALSE;
+}
+
+static HRESULT FindCollectionIndexObject(
+    STRINGDICT_HANDLE shDict,
+    LPCWSTR pwzKey,
+    CPI_COLLECTION_OBJECT** ppItm
+    )
+{
+    HRESULT hr = S_OK;
+
+    hr = DictGetValue(shDict, pwzKey, (void**)ppItm);
+    if (E_NOTFOUND == hr)
+        ExitFunction1(hr = S_FALSE);
+    ExitOnFailure(hr, "Failed to look up object");
+
+    // removed objects stay in the dictionaries until the index is rebuilt
+    if (!(*ppItm)->piObj)
+        hr = S_FALSE;
+
+LExit:
+    return hr;
+}
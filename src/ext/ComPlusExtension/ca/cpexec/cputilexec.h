@@ -25,6 +25,30 @@ struct CPI_ROLLBACK_DATA
     CPI_ROLLBACK_DATA* pNext;
 };
 
+struct CPI_COLLECTION_OBJECT
+{
+    LPWSTR pwzKey;
+    LPWSTR pwzIntegerKey;
+    LPWSTR pwzName;
+    long lIndex;
+    ICatalogObject* piObj; // NULL once the object is removed
+};
+
+struct CPI_COLLECTION_INDEX
+{
+    ICatalogCollection* piColl;
+    BOOL fRepopulate; // the collection was saved since it was indexed
+    BOOL fChanged;
+
+    BOOL fIndexed;
+    CPI_COLLECTION_OBJECT* rgObjects;
+    long cObjects;
+
+    STRINGDICT_HANDLE shKeys;
+    STRINGDICT_HANDLE shIntegerKeys;
+    STRINGDICT_HANDLE shNames;
+};
+
 
 // function prototypes
 
@@ -105,6 +129,40 @@ HRESULT CpiFindUserCollectionObject(
     PSID pSid,
     ICatalogObject** ppiObj
     );
+void CpiCollectionIndexInitialize(
+    ICatalogCollection* piColl,
+    CPI_COLLECTION_INDEX* pIndex
+    );
+void CpiCollectionIndexUninitialize(
+    CPI_COLLECTION_INDEX* pIndex
+    );
+HRESULT CpiCollectionIndexFindByStringKey(
+    CPI_COLLECTION_INDEX* pIndex,
+    LPCWSTR pwzKey,
+    ICatalogObject** ppiObj
+    );
+HRESULT CpiCollectionIndexFindByIntegerKey(
+    CPI_COLLECTION_INDEX* pIndex,
+    long lKey,
+    ICatalogObject** ppiObj
+    );
+HRESULT CpiCollectionIndexFindByName(
+    CPI_COLLECTION_INDEX* pIndex,
+    LPCWSTR pwzName,
+    ICatalogObject** ppiObj
+    );
+HRESULT CpiCollectionIndexPutObjectValues(
+    CPI_COLLECTION_INDEX* pIndex,
+    ICatalogObject* piObj,
+    CPI_PROPERTY* pPropList
+    );
+HRESULT CpiCollectionIndexRemoveByStringKey(
+    CPI_COLLECTION_INDEX* pIndex,
+    LPCWSTR pwzKey
+    );
+HRESULT CpiCollectionIndexSaveChanges(
+    CPI_COLLECTION_INDEX* pIndex
+    );
 HRESULT CpiGetPartitionsCollection(
     ICatalogCollection** ppiPartColl
     );
@@ -17,6 +17,7 @@
 #include "memutil.h"
 #include "strutil.h"
 #include "wiutil.h"
+#include "dictutil.h"
 
 #include "CustomMsiErrors.h"
 
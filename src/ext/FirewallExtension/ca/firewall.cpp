@@ -335,23 +335,17 @@ LExit:
 
 /******************************************************************
  FSupportProfiles - Returns true if we support profiles on this machine.
-  (Only on Vista or later)
+  (Only on Vista or later) The rules are returned so every exception
+  can share the same policy object.
 
 ********************************************************************/
-static BOOL FSupportProfiles()
+static BOOL FSupportProfiles(
+    __out INetFwRules** ppNetFwRules
+    )
 {
-    BOOL fSupportProfiles = FALSE;
-    INetFwRules* pNetFwRules = NULL;
-
     // We only support profiles if we can co-create an instance of NetFwPolicy2. 
     // This will not work on pre-vista machines.
-    if (SUCCEEDED(GetFirewallRules(TRUE, &pNetFwRules)) &&  pNetFwRules != NULL)
-    {
-        fSupportProfiles = TRUE;
-        ReleaseObject(pNetFwRules);
-    }
-
-    return fSupportProfiles;
+    return SUCCEEDED(GetFirewallRules(TRUE, ppNetFwRules)) && NULL != *ppNetFwRules;
 }
 
 /******************************************************************
@@ -422,6 +416,9 @@ LExit:
 
 ********************************************************************/
 static HRESULT AddApplicationException(
+    __in INetFwRules* pNetFwRules,
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in FW_RULE_ACTION action,
     __in LPCWSTR wzFile, 
     __in LPCWSTR wzName,
     __in int iProfile,
@@ -435,7 +432,6 @@ static HRESULT AddApplicationException(
     HRESULT hr = S_OK;
     BSTR bstrFile = NULL;
     BSTR bstrName = NULL;
-    INetFwRules* pNetFwRules = NULL;
     INetFwRule* pNetFwRule = NULL;
 
     // convert to BSTRs to make COM happy
@@ -444,16 +440,16 @@ static HRESULT AddApplicationException(
     bstrName = ::SysAllocString(wzName);
     ExitOnNull(bstrName, hr, E_OUTOFMEMORY, "failed SysAllocString for name");
 
-    // get the collection of firewall rules
-    hr = GetFirewallRules(fIgnoreFailures, &pNetFwRules);
-    ExitOnFailure(hr, "failed to get firewall rules object");
-    if (S_FALSE == hr) // user or package author chose to ignore missing firewall
+    // try to find it (i.e., support reinstall), unless the snapshot says it doesn't exist
+    if (FW_RULE_ACTION_ENABLE == action)
     {
-        ExitFunction();
+        hr = pNetFwRules->Item(bstrName, &pNetFwRule);
+    }
+    else
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
     }
 
-    // try to find it (i.e., support reinstall)
-    hr = pNetFwRules->Item(bstrName, &pNetFwRule);
     if (HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) == hr)
     {
         hr = CreateFwRuleObject(bstrName, iProfile, wzRemoteAddresses, wzPort, iProtocol, wzDescription, &pNetFwRule);
@@ -474,6 +470,9 @@ static HRESULT AddApplicationException(
         // add it to the list of authorized apps
         hr = pNetFwRules->Add(pNetFwRule);
         ExitOnFailure(hr, "failed to add app to the authorized apps list");
+
+        hr = FwRuleSnapshotAdd(pSnapshot, wzName);
+        ExitOnFailure(hr, "failed to remember added app exception");
     }
     else
     {
@@ -487,7 +486,6 @@ static HRESULT AddApplicationException(
 LExit:
     ReleaseBSTR(bstrName);
     ReleaseBSTR(bstrFile);
-    ReleaseObject(pNetFwRules);
     ReleaseObject(pNetFwRule);
 
     return fIgnoreFailures ? S_OK : hr;
@@ -584,6 +582,9 @@ LExit:
 
 ********************************************************************/
 static HRESULT AddPortException(
+    __in INetFwRules* pNetFwRules,
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in FW_RULE_ACTION action,
     __in LPCWSTR wzName,
     __in int iProfile,
     __in_opt LPCWSTR wzRemoteAddresses,
@@ -595,23 +596,22 @@ static HRESULT AddPortException(
 {
     HRESULT hr = S_OK;
     BSTR bstrName = NULL;
-    INetFwRules* pNetFwRules = NULL;
     INetFwRule* pNetFwRule = NULL;
 
     // convert to BSTRs to make COM happy
     bstrName = ::SysAllocString(wzName);
     ExitOnNull(bstrName, hr, E_OUTOFMEMORY, "failed SysAllocString for name");
 
-    // get the collection of firewall rules
-    hr = GetFirewallRules(fIgnoreFailures, &pNetFwRules);
-    ExitOnFailure(hr, "failed to get firewall rules object");
-    if (S_FALSE == hr) // user or package author chose to ignore missing firewall
+    // try to find it (i.e., support reinstall), unless the snapshot says it doesn't exist
+    if (FW_RULE_ACTION_ENABLE == action)
     {
-        ExitFunction();
+        hr = pNetFwRules->Item(bstrName, &pNetFwRule);
+    }
+    else
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
     }
 
-    // try to find it (i.e., support reinstall)
-    hr = pNetFwRules->Item(bstrName, &pNetFwRule);
     if (HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) == hr)
     {
         hr = CreateFwRuleObject(bstrName, iProfile, wzRemoteAddresses, wzPort, iProtocol, wzDescription, &pNetFwRule);
@@ -624,6 +624,9 @@ static HRESULT AddPortException(
         // add it to the list of authorized ports
         hr = pNetFwRules->Add(pNetFwRule);
         ExitOnFailure(hr, "failed to add app to the authorized ports list");
+
+        hr = FwRuleSnapshotAdd(pSnapshot, wzName);
+        ExitOnFailure(hr, "failed to remember added port exception");
     }
     else
     {
@@ -636,7 +639,6 @@ static HRESULT AddPortException(
 
 LExit:
     ReleaseBSTR(bstrName);
-    ReleaseObject(pNetFwRules);
     ReleaseObject(pNetFwRule);
 
     return fIgnoreFailures ? S_OK : hr;
@@ -715,31 +717,22 @@ LExit:
 
 ********************************************************************/
 static HRESULT RemoveException(
+    __in INetFwRules* pNetFwRules,
     __in LPCWSTR wzName, 
     __in BOOL fIgnoreFailures
     )
 {
     HRESULT hr = S_OK;;
-    INetFwRules* pNetFwRules = NULL;
 
     // convert to BSTRs to make COM happy
     BSTR bstrName = ::SysAllocString(wzName);
     ExitOnNull(bstrName, hr, E_OUTOFMEMORY, "failed SysAllocString for path");
 
-    // get the collection of firewall rules
-    hr = GetFirewallRules(fIgnoreFailures, &pNetFwRules);
-    ExitOnFailure(hr, "failed to get firewall rules object");
-    if (S_FALSE == hr) // user or package author chose to ignore missing firewall
-    {
-        ExitFunction();
-    }
-
     hr = pNetFwRules->Remove(bstrName);
     ExitOnFailure(hr, "failed to remove authorized app");
 
 LExit:
     ReleaseBSTR(bstrName);
-    ReleaseObject(pNetFwRules);
 
     return fIgnoreFailures ? S_OK : hr;
 }
@@ -817,7 +810,9 @@ LExit:
 }
 
 static HRESULT AddApplicationException(
-    __in BOOL fSupportProfiles,
+    __in_opt INetFwRules* pNetFwRules,
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in FW_RULE_ACTION action,
     __in LPCWSTR wzFile, 
     __in LPCWSTR wzName,
     __in int iProfile,
@@ -830,9 +825,9 @@ static HRESULT AddApplicationException(
 {
     HRESULT hr = S_OK;
 
-    if (fSupportProfiles)
+    if (pNetFwRules)
     {
-        hr = AddApplicationException(wzFile, wzName, iProfile, wzRemoteAddresses, fIgnoreFailures, wzPort, iProtocol, wzDescription);
+        hr = AddApplicationException(pNetFwRules, pSnapshot, action, wzFile, wzName, iProfile, wzRemoteAddresses, fIgnoreFailures, wzPort, iProtocol, wzDescription);
     }
     else
     {
@@ -853,7 +848,9 @@ static HRESULT AddApplicationException(
 }
 
 static HRESULT AddPortException(
-    __in BOOL fSupportProfiles,
+    __in_opt INetFwRules* pNetFwRules,
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in FW_RULE_ACTION action,
     __in LPCWSTR wzName,
     __in int iProfile,
     __in_opt LPCWSTR wzRemoteAddresses,
@@ -865,9 +862,9 @@ static HRESULT AddPortException(
 {
     HRESULT hr = S_OK;
 
-    if (fSupportProfiles)
+    if (pNetFwRules)
     {
-        hr = AddPortException(wzName, iProfile, wzRemoteAddresses, fIgnoreFailures, wzPort, iProtocol, wzDescription);
+        hr = AddPortException(pNetFwRules, pSnapshot, action, wzName, iProfile, wzRemoteAddresses, fIgnoreFailures, wzPort, iProtocol, wzDescription);
     }
     else
     {
@@ -878,7 +875,7 @@ static HRESULT AddPortException(
 }
 
 static HRESULT RemoveApplicationException(
-    __in BOOL fSupportProfiles,
+    __in_opt INetFwRules* pNetFwRules,
     __in LPCWSTR wzName,
     __in LPCWSTR wzFile, 
     __in BOOL fIgnoreFailures,
@@ -888,9 +885,9 @@ static HRESULT RemoveApplicationException(
 {
     HRESULT hr = S_OK;
 
-    if (fSupportProfiles)
+    if (pNetFwRules)
     {
-        hr = RemoveException(wzName, fIgnoreFailures);
+        hr = RemoveException(pNetFwRules, wzName, fIgnoreFailures);
     }
     else
     {
@@ -907,7 +904,7 @@ static HRESULT RemoveApplicationException(
 }
 
 static HRESULT RemovePortException(
-    __in BOOL fSupportProfiles,
+    __in_opt INetFwRules* pNetFwRules,
     __in LPCWSTR wzName,
     __in LPCWSTR wzPort,
     __in int iProtocol,
@@ -916,9 +913,9 @@ static HRESULT RemovePortException(
 {
     HRESULT hr = S_OK;
 
-    if (fSupportProfiles)
+    if (pNetFwRules)
     {
-        hr = RemoveException(wzName, fIgnoreFailures);
+        hr = RemoveException(pNetFwRules, wzName, fIgnoreFailures);
     }
     else
     {
@@ -938,7 +935,9 @@ extern "C" UINT __stdcall ExecFirewallExceptions(
     )
 {
     HRESULT hr = S_OK;
-    BOOL fSupportProfiles = FALSE;
+    INetFwRules* pNetFwRules = NULL;
+    FW_RULE_SNAPSHOT snapshot = { };
+    FW_RULE_ACTION action = FW_RULE_ACTION_NONE;
     LPWSTR pwz = NULL;
     LPWSTR pwzCustomActionData = NULL;
     int iTodo = WCA_TODO_UNKNOWN;
@@ -963,8 +962,19 @@ extern "C" UINT __stdcall ExecFirewallExceptions(
     hr = ::CoInitialize(NULL);
     ExitOnFailure(hr, "failed to initialize COM");
 
-    // Find out if we support profiles (only on Vista or later)
-    fSupportProfiles = FSupportProfiles();
+    // Find out if we support profiles (only on Vista or later) and if so, snapshot the names
+    // of the existing rules once instead of looking up each exception.
+    if (FSupportProfiles(&pNetFwRules))
+    {
+        hr = FwRuleSnapshotInitialize(pNetFwRules, &snapshot);
+        if (FAILED(hr))
+        {
+            // without a snapshot every exception is looked up like before
+            WcaLog(LOGMSG_STANDARD, "Failed to snapshot existing firewall rules, hr: 0x%x", hr);
+            FwRuleSnapshotUninitialize(&snapshot);
+            hr = S_OK;
+        }
+    }
 
     // loop through all the passed in data
     pwz = pwzCustomActionData;
@@ -1014,6 +1024,14 @@ extern "C" UINT __stdcall ExecFirewallExceptions(
         hr = WcaReadStringFromCaData(&pwz, &pwzDescription);
         ExitOnFailure(hr, "failed to read protocol from custom action data");
 
+        // the current profile doesn't have a snapshot, so it handles every exception like before
+        action = FwRulePlanAction(iTodo, !pNetFwRules || FwRuleSnapshotContains(&snapshot, pwzName));
+        if (FW_RULE_ACTION_NONE == action)
+        {
+            WcaLog(LOGMSG_VERBOSE, "Firewall exception %ls doesn't exist, so there's nothing to remove", pwzName);
+            continue;
+        }
+
         switch (iTarget)
         {
         case fetPort:
@@ -1022,13 +1040,13 @@ extern "C" UINT __stdcall ExecFirewallExceptions(
             case WCA_TODO_INSTALL:
             case WCA_TODO_REINSTALL:
                 WcaLog(LOGMSG_STANDARD, "Installing firewall exception2 %ls on port %ls, protocol %d", pwzName, pwzPort, iProtocol);
-                hr = AddPortException(fSupportProfiles, pwzName, iProfile, pwzRemoteAddresses, fIgnoreFailures, pwzPort, iProtocol, pwzDescription);
+                hr = AddPortException(pNetFwRules, &snapshot, action, pwzName, iProfile, pwzRemoteAddresses, fIgnoreFailures, pwzPort, iProtocol, pwzDescription);
                 ExitOnFailure(hr, "failed to add/update port exception for name '%ls' on port %ls, protocol %d", pwzName, pwzPort, iProtocol);
                 break;
 
             case WCA_TODO_UNINSTALL:
                 WcaLog(LOGMSG_STANDARD, "Uninstalling firewall exception2 %ls on port %ls, protocol %d", pwzName, pwzPort, iProtocol);
-                hr = RemovePortException(fSupportProfiles, pwzName, pwzPort, iProtocol, fIgnoreFailures);
+                hr = RemovePortException(pNetFwRules, pwzName, pwzPort, iProtocol, fIgnoreFailures);
                 ExitOnFailure(hr, "failed to remove port exception for name '%ls' on port %ls, protocol %d", pwzName, pwzPort, iProtocol);
                 break;
             }
@@ -1040,13 +1058,13 @@ extern "C" UINT __stdcall ExecFirewallExceptions(
             case WCA_TODO_INSTALL:
             case WCA_TODO_REINSTALL:
                 WcaLog(LOGMSG_STANDARD, "Installing firewall exception2 %ls (%ls)", pwzName, pwzFile);
-                hr = AddApplicationException(fSupportProfiles, pwzFile, pwzName, iProfile, pwzRemoteAddresses, fIgnoreFailures, pwzPort, iProtocol, pwzDescription);
+                hr = AddApplicationException(pNetFwRules, &snapshot, action, pwzFile, pwzName, iProfile, pwzRemoteAddresses, fIgnoreFailures, pwzPort, iProtocol, pwzDescription);
                 ExitOnFailure(hr, "failed to add/update application exception for name '%ls', file '%ls'", pwzName, pwzFile);
                 break;
 
             case WCA_TODO_UNINSTALL:
                 WcaLog(LOGMSG_STANDARD, "Uninstalling firewall exception2 %ls (%ls)", pwzName, pwzFile);
-                hr = RemoveApplicationException(fSupportProfiles, pwzName, pwzFile, fIgnoreFailures, pwzPort, iProtocol);
+                hr = RemoveApplicationException(pNetFwRules, pwzName, pwzFile, fIgnoreFailures, pwzPort, iProtocol);
                 ExitOnFailure(hr, "failed to remove application exception for name '%ls', file '%ls'", pwzName, pwzFile);
                 break;
             }
@@ -1061,6 +1079,8 @@ LExit:
     ReleaseStr(pwzFile);
     ReleaseStr(pwzPort);
     ReleaseStr(pwzDescription);
+    FwRuleSnapshotUninitialize(&snapshot);
+    ReleaseObject(pNetFwRules);
     ::CoUninitialize();
 
     return WcaFinalize(FAILED(hr) ? ERROR_INSTALL_FAILURE : ERROR_SUCCESS);
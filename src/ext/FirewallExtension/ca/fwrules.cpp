@@ -0,0 +1,147 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+
+/******************************************************************
+ FwRuleSnapshotInitialize - enumerates the names of all firewall rules
+   once so each exception doesn't have to look itself up.
+
+********************************************************************/
+HRESULT FwRuleSnapshotInitialize(
+    __in INetFwRules* pNetFwRules,
+    __in FW_RULE_SNAPSHOT* pSnapshot
+    )
+{
+    HRESULT hr = S_OK;
+    long cRules = 0;
+    IUnknown* pUnknown = NULL;
+    IEnumVARIANT* pEnum = NULL;
+    VARIANT var;
+    INetFwRule* pNetFwRule = NULL;
+    BSTR bstrName = NULL;
+
+    ::VariantInit(&var);
+    memset(pSnapshot, 0, sizeof(FW_RULE_SNAPSHOT));
+
+    hr = pNetFwRules->get_Count(&cRules);
+    ExitOnFailure(hr, "failed to get count of firewall rules");
+
+    // The firewall doesn't care about the case of rule names.
+    hr = DictCreateStringList(&pSnapshot->sdNames, static_cast<DWORD>(cRules), DICT_FLAG_CASEINSENSITIVE);
+    ExitOnFailure(hr, "failed to create firewall rule name dictionary");
+
+    hr = pNetFwRules->get__NewEnum(&pUnknown);
+    ExitOnFailure(hr, "failed to get enumerator of firewall rules");
+
+    hr = pUnknown->QueryInterface(__uuidof(IEnumVARIANT), reinterpret_cast<void**>(&pEnum));
+    ExitOnFailure(hr, "failed to query enumerator of firewall rules");
+
+    while (S_OK == (hr = pEnum->Next(1, &var, NULL)))
+    {
+        hr = V_DISPATCH(&var)->QueryInterface(__uuidof(INetFwRule), reinterpret_cast<void**>(&pNetFwRule));
+        ExitOnFailure(hr, "failed to query firewall rule");
+
+        hr = pNetFwRule->get_Name(&bstrName);
+        ExitOnFailure(hr, "failed to get name of firewall rule");
+
+        if (bstrName)
+        {
+            hr = FwRuleSnapshotAdd(pSnapshot, bstrName);
+            ExitOnFailure(hr, "failed to add firewall rule to snapshot: %ls", bstrName);
+        }
+
+        ReleaseNullBSTR(bstrName);
+        ReleaseNullObject(pNetFwRule);
+        ::VariantClear(&var);
+    }
+
+    // reaching the end of the rules is not an error
+    if (S_FALSE == hr)
+    {
+        hr = S_OK;
+    }
+    ExitOnFailure(hr, "failed to enumerate firewall rules");
+
+    WcaLog(LOGMSG_VERBOSE, "Found %u existing firewall rule names.", pSnapshot->cNames);
+
+LExit:
+    ReleaseBSTR(bstrName);
+    ReleaseObject(pNetFwRule);
+    ::VariantClear(&var);
+    ReleaseObject(pEnum);
+    ReleaseObject(pUnknown);
+
+    return hr;
+}
+
+void FwRuleSnapshotUninitialize(
+    __in FW_RULE_SNAPSHOT* pSnapshot
+    )
+{
+    ReleaseDict(pSnapshot->sdNames);
+
+    memset(pSnapshot, 0, sizeof(FW_RULE_SNAPSHOT));
+}
+
+/******************************************************************
+ FwRuleSnapshotContains - returns whether a rule with the name may
+   exist.
+
+ NOTE: Without a snapshot every rule may exist, so callers fall back
+       to looking the rule up.
+********************************************************************/
+BOOL FwRuleSnapshotContains(
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzName
+    )
+{
+    return !pSnapshot->sdNames || S_OK == DictKeyExists(pSnapshot->sdNames, wzName);
+}
+
+/******************************************************************
+ FwRuleSnapshotAdd - records a rule so a later exception with the same
+   name enables it instead of adding a duplicate.
+
+********************************************************************/
+HRESULT FwRuleSnapshotAdd(
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzName
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (pSnapshot->sdNames && S_OK != DictKeyExists(pSnapshot->sdNames, wzName))
+    {
+        hr = DictAddKey(pSnapshot->sdNames, wzName);
+        ExitOnFailure(hr, "failed to add firewall rule name: %ls", wzName);
+
+        ++pSnapshot->cNames;
+    }
+
+LExit:
+    return hr;
+}
+
+/******************************************************************
+ FwRulePlanAction - decides what has to be done to a rule given
+   whether it may already exist.
+
+********************************************************************/
+FW_RULE_ACTION FwRulePlanAction(
+    __in int iTodo,
+    __in BOOL fExists
+    )
+{
+    switch (iTodo)
+    {
+    case WCA_TODO_INSTALL:
+    case WCA_TODO_REINSTALL:
+        return fExists ? FW_RULE_ACTION_ENABLE : FW_RULE_ACTION_ADD;
+
+    case WCA_TODO_UNINSTALL:
+        return fExists ? FW_RULE_ACTION_REMOVE : FW_RULE_ACTION_NONE;
+    }
+
+    return FW_RULE_ACTION_NONE;
+}
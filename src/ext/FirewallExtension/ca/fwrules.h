@@ -0,0 +1,38 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+enum FW_RULE_ACTION
+{
+    FW_RULE_ACTION_NONE,
+    FW_RULE_ACTION_ADD,
+    FW_RULE_ACTION_ENABLE,
+    FW_RULE_ACTION_REMOVE,
+};
+
+// Names of the firewall rules that existed when the snapshot was taken plus the ones added since.
+struct FW_RULE_SNAPSHOT
+{
+    STRINGDICT_HANDLE sdNames;
+    DWORD cNames;
+};
+
+HRESULT FwRuleSnapshotInitialize(
+    __in INetFwRules* pNetFwRules,
+    __in FW_RULE_SNAPSHOT* pSnapshot
+    );
+void FwRuleSnapshotUninitialize(
+    __in FW_RULE_SNAPSHOT* pSnapshot
+    );
+BOOL FwRuleSnapshotContains(
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzName
+    );
+HRESULT FwRuleSnapshotAdd(
+    __in FW_RULE_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzName
+    );
+FW_RULE_ACTION FwRulePlanAction(
+    __in int iTodo,
+    __in BOOL fExists
+    );
@@ -12,6 +12,8 @@
 #include "fileutil.h"
 #include "pathutil.h"
 #include "strutil.h"
+#include "dictutil.h"
 
 #include "CustomMsiErrors.h"
 #include "cost.h"
+#include "fwrules.h"
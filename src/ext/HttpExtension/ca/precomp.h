@@ -11,7 +11,9 @@
 #include "dutil.h"
 #include "memutil.h"
 #include "strutil.h"
+#include "dictutil.h"
 #include "aclutil.h"
 
 #include "CustomMsiErrors.h"
 #include "cost.h"
+#include "urlacl.h"
@@ -0,0 +1,294 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+static URLACL_ACTION DiffEntry(
+    __in URLACL_ENTRY* pEntry,
+    __in_z_opt LPCWSTR wzExistingSddl
+    );
+static HRESULT QueryExact(
+    __in_z LPCWSTR wzUrl,
+    __deref_out_z LPWSTR* psczSddl
+    );
+
+/******************************************************************
+ UrlAclSnapshotInitialize - enumerates every URL reservation once so
+   each authored URL can be looked up without querying HTTP.sys.
+
+ NOTE: HttpInitialize() must have been called with HTTP_INITIALIZE_CONFIG.
+       HTTP.sys canonicalizes URL prefixes (for example by appending
+       a trailing '/'), so authored URLs missing from the enumeration
+       are asked for exactly and added under their authored spelling.
+********************************************************************/
+HRESULT UrlAclSnapshotInitialize(
+    __in_opt URLACL_SNAPSHOT* pAuthored,
+    __in URLACL_SNAPSHOT* pSnapshot
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+    HTTP_SERVICE_CONFIG_URLACL_QUERY query = { };
+    HTTP_SERVICE_CONFIG_URLACL_SET* pSet = NULL;
+    ULONG cbSet = 0;
+    ULONG cbSetRequired = 0;
+    LPWSTR sczSddl = NULL;
+
+    memset(pSnapshot, 0, sizeof(URLACL_SNAPSHOT));
+
+    query.QueryDesc = HttpServiceConfigQueryNext;
+
+    for (query.dwToken = 0; ; ++query.dwToken)
+    {
+        er = ::HttpQueryServiceConfiguration(NULL, HttpServiceConfigUrlAclInfo, &query, sizeof(query), pSet, cbSet, &cbSetRequired, NULL);
+        if (ERROR_INSUFFICIENT_BUFFER == er)
+        {
+            // The buffer is reused for the rest of the enumeration, so only grow it.
+            ReleaseMem(pSet);
+            cbSet = cbSetRequired;
+
+            pSet = reinterpret_cast<HTTP_SERVICE_CONFIG_URLACL_SET*>(MemAlloc(cbSet, TRUE));
+            ExitOnNull(pSet, hr, E_OUTOFMEMORY, "Failed to allocate query URLACL buffer.");
+
+            er = ::HttpQueryServiceConfiguration(NULL, HttpServiceConfigUrlAclInfo, &query, sizeof(query), pSet, cbSet, &cbSetRequired, NULL);
+        }
+
+        if (ERROR_NO_MORE_ITEMS == er)
+        {
+            break;
+        }
+        ExitOnWin32Error(er, hr, "Failed to enumerate URL reservation %u.", query.dwToken);
+
+        hr = UrlAclSnapshotAdd(pSnapshot, pSet->KeyDesc.pUrlPrefix, pSet->ParamDesc.pStringSecurityDescriptor ? pSet->ParamDesc.pStringSecurityDescriptor : L"", WCA_TODO_UNKNOWN, 0);
+        ExitOnFailure(hr, "Failed to add URL reservation to snapshot.");
+    }
+
+    hr = UrlAclSnapshotIndex(pSnapshot);
+    ExitOnFailure(hr, "Failed to index URL reservations.");
+
+    for (DWORD i = 0; pAuthored && i < pAuthored->cEntries; ++i)
+    {
+        if (UrlAclSnapshotFind(pSnapshot, pAuthored->rgEntries[i].sczUrl))
+        {
+            continue;
+        }
+
+        hr = QueryExact(pAuthored->rgEntries[i].sczUrl, &sczSddl);
+        ExitOnFailure(hr, "Failed to query reservation: %ls", pAuthored->rgEntries[i].sczUrl);
+
+        if (S_OK == hr)
+        {
+            hr = UrlAclSnapshotAdd(pSnapshot, pAuthored->rgEntries[i].sczUrl, sczSddl, WCA_TODO_UNKNOWN, 0);
+            ExitOnFailure(hr, "Failed to add URL reservation to snapshot: %ls", pAuthored->rgEntries[i].sczUrl);
+
+            // Adding may have moved the entries the index points to.
+            hr = UrlAclSnapshotIndex(pSnapshot);
+            ExitOnFailure(hr, "Failed to index URL reservations.");
+        }
+    }
+
+    WcaLog(LOGMSG_VERBOSE, "Found %u existing URL reservations.", pSnapshot->cEntries);
+
+LExit:
+    ReleaseStr(sczSddl);
+    ReleaseMem(pSet);
+
+    return hr;
+}
+
+void UrlAclSnapshotUninitialize(
+    __in URLACL_SNAPSHOT* pSnapshot
+    )
+{
+    ReleaseDict(pSnapshot->sdUrls);
+
+    for (DWORD i = 0; i < pSnapshot->cEntries; ++i)
+    {
+        ReleaseStr(pSnapshot->rgEntries[i].sczUrl);
+        ReleaseStr(pSnapshot->rgEntries[i].sczSddl);
+    }
+
+    ReleaseMem(pSnapshot->rgEntries);
+
+    memset(pSnapshot, 0, sizeof(URLACL_SNAPSHOT));
+}
+
+/******************************************************************
+ UrlAclSnapshotAdd - appends a reservation to the snapshot.
+
+ NOTE: The snapshot has to be indexed again before it is searched.
+********************************************************************/
+HRESULT UrlAclSnapshotAdd(
+    __in URLACL_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzUrl,
+    __in_z LPCWSTR wzSddl,
+    __in WCA_TODO todo,
+    __in int iHandleExisting
+    )
+{
+    HRESULT hr = S_OK;
+    URLACL_ENTRY* pEntry = NULL;
+
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pSnapshot->rgEntries), pSnapshot->cEntries + 1, sizeof(URLACL_ENTRY), 64);
+    ExitOnFailure(hr, "Failed to grow URL reservation snapshot.");
+
+    pEntry = pSnapshot->rgEntries + pSnapshot->cEntries;
+    ++pSnapshot->cEntries;
+
+    pEntry->todo = todo;
+    pEntry->iHandleExisting = iHandleExisting;
+
+    hr = StrAllocString(&pEntry->sczUrl, wzUrl, 0);
+    ExitOnFailure(hr, "Failed to copy URL of reservation.");
+
+    hr = StrAllocString(&pEntry->sczSddl, wzSddl, 0);
+    ExitOnFailure(hr, "Failed to copy SDDL of reservation: %ls", wzUrl);
+
+LExit:
+    return hr;
+}
+
+HRESULT UrlAclSnapshotIndex(
+    __in URLACL_SNAPSHOT* pSnapshot
+    )
+{
+    HRESULT hr = S_OK;
+
+    ReleaseNullDict(pSnapshot->sdUrls);
+
+    // HTTP.sys matches URL prefixes case-insensitively.
+    hr = DictCreateWithEmbeddedKey(&pSnapshot->sdUrls, pSnapshot->cEntries, NULL, offsetof(URLACL_ENTRY, sczUrl), DICT_FLAG_CASEINSENSITIVE);
+    ExitOnFailure(hr, "Failed to create URL reservation dictionary.");
+
+    for (DWORD i = 0; i < pSnapshot->cEntries; ++i)
+    {
+        if (S_OK != DictKeyExists(pSnapshot->sdUrls, pSnapshot->rgEntries[i].sczUrl))
+        {
+            hr = DictAddValue(pSnapshot->sdUrls, pSnapshot->rgEntries + i);
+            ExitOnFailure(hr, "Failed to index URL reservation: %ls", pSnapshot->rgEntries[i].sczUrl);
+        }
+    }
+
+LExit:
+    return hr;
+}
+
+/******************************************************************
+ UrlAclSnapshotFind - gets the SDDL of the reservation for the URL,
+   or NULL if the indexed snapshot doesn't have one.
+
+********************************************************************/
+LPCWSTR UrlAclSnapshotFind(
+    __in URLACL_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzUrl
+    )
+{
+    URLACL_ENTRY* pEntry = NULL;
+
+    if (pSnapshot->sdUrls && SUCCEEDED(DictGetValue(pSnapshot->sdUrls, wzUrl, reinterpret_cast<void**>(&pEntry))))
+    {
+        return pEntry->sczSddl;
+    }
+
+    return NULL;
+}
+
+/******************************************************************
+ UrlAclSnapshotDiff - decides what has to be done to each authored
+   reservation given the reservations that already exist.
+
+ NOTE: pBefore must be indexed. rgActions is parallel to the entries
+       of pAfter.
+********************************************************************/
+void UrlAclSnapshotDiff(
+    __in URLACL_SNAPSHOT* pBefore,
+    __in URLACL_SNAPSHOT* pAfter,
+    __out_ecount(pAfter->cEntries) URLACL_ACTION* rgActions
+    )
+{
+    for (DWORD i = 0; i < pAfter->cEntries; ++i)
+    {
+        rgActions[i] = DiffEntry(pAfter->rgEntries + i, UrlAclSnapshotFind(pBefore, pAfter->rgEntries[i].sczUrl));
+    }
+}
+
+/******************************************************************
+ DiffEntry - decides what has to be done to one authored reservation.
+
+ NOTE: An existing reservation that has to fail the install still needs
+       to reach ExecHttpUrlReservations so it fails there. Uninstall
+       always removes, since a reservation that isn't there is ignored.
+********************************************************************/
+static URLACL_ACTION DiffEntry(
+    __in URLACL_ENTRY* pEntry,
+    __in_z_opt LPCWSTR wzExistingSddl
+    )
+{
+    HRESULT hr = S_OK;
+    BOOL fEqual = FALSE;
+
+    if (WCA_TODO_UNINSTALL == pEntry->todo)
+    {
+        return URLACL_ACTION_REMOVE;
+    }
+    else if (!wzExistingSddl)
+    {
+        return URLACL_ACTION_ADD;
+    }
+    else if (heIgnore == pEntry->iHandleExisting)
+    {
+        return URLACL_ACTION_NONE;
+    }
+    else if (heReplace == pEntry->iHandleExisting)
+    {
+        // HTTP.sys returns its own spelling of the SDDL, so compare what it describes.
+        hr = AclCompareSecurityDescriptorStrings(wzExistingSddl, pEntry->sczSddl, &fEqual);
+        if (SUCCEEDED(hr) && fEqual)
+        {
+            return URLACL_ACTION_NONE;
+        }
+    }
+
+    return URLACL_ACTION_CHANGE;
+}
+
+static HRESULT QueryExact(
+    __in_z LPCWSTR wzUrl,
+    __deref_out_z LPWSTR* psczSddl
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+    HTTP_SERVICE_CONFIG_URLACL_QUERY query = { };
+    HTTP_SERVICE_CONFIG_URLACL_SET* pSet = NULL;
+    ULONG cbSet = 0;
+
+    query.QueryDesc = HttpServiceConfigQueryExact;
+    query.KeyDesc.pUrlPrefix = const_cast<LPWSTR>(wzUrl);
+
+    er = ::HttpQueryServiceConfiguration(NULL, HttpServiceConfigUrlAclInfo, &query, sizeof(query), pSet, cbSet, &cbSet, NULL);
+    if (ERROR_INSUFFICIENT_BUFFER == er)
+    {
+        pSet = reinterpret_cast<HTTP_SERVICE_CONFIG_URLACL_SET*>(MemAlloc(cbSet, TRUE));
+        ExitOnNull(pSet, hr, E_OUTOFMEMORY, "Failed to allocate query URLACL buffer.");
+
+        er = ::HttpQueryServiceConfiguration(NULL, HttpServiceConfigUrlAclInfo, &query, sizeof(query), pSet, cbSet, &cbSet, NULL);
+    }
+
+    if (ERROR_SUCCESS == er)
+    {
+        hr = StrAllocString(psczSddl, pSet->ParamDesc.pStringSecurityDescriptor ? pSet->ParamDesc.pStringSecurityDescriptor : L"", 0);
+    }
+    else if (ERROR_FILE_NOT_FOUND == er)
+    {
+        hr = S_FALSE;
+    }
+    else
+    {
+        hr = HRESULT_FROM_WIN32(er);
+    }
+
+LExit:
+    ReleaseMem(pSet);
+
+    return hr;
+}
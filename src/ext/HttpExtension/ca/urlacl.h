@@ -0,0 +1,59 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+enum eHandleExisting { heReplace = 0, heIgnore = 1, heFail = 2 };
+
+enum URLACL_ACTION
+{
+    URLACL_ACTION_NONE,   // already up to date
+    URLACL_ACTION_ADD,    // no reservation yet
+    URLACL_ACTION_CHANGE, // replaces the existing reservation or fails, per HandleExisting
+    URLACL_ACTION_REMOVE,
+};
+
+struct URLACL_ENTRY
+{
+    LPWSTR sczUrl;
+    LPWSTR sczSddl;
+
+    // only set for authored reservations
+    WCA_TODO todo;
+    int iHandleExisting;
+};
+
+// A set of URL reservations: either the ones HTTP.sys had when the snapshot
+// was taken, indexed by URL prefix, or the ones being installed or uninstalled.
+struct URLACL_SNAPSHOT
+{
+    URLACL_ENTRY* rgEntries;
+    DWORD cEntries;
+    STRINGDICT_HANDLE sdUrls;
+};
+
+HRESULT UrlAclSnapshotInitialize(
+    __in_opt URLACL_SNAPSHOT* pAuthored,
+    __in URLACL_SNAPSHOT* pSnapshot
+    );
+void UrlAclSnapshotUninitialize(
+    __in URLACL_SNAPSHOT* pSnapshot
+    );
+HRESULT UrlAclSnapshotAdd(
+    __in URLACL_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzUrl,
+    __in_z LPCWSTR wzSddl,
+    __in WCA_TODO todo,
+    __in int iHandleExisting
+    );
+HRESULT UrlAclSnapshotIndex(
+    __in URLACL_SNAPSHOT* pSnapshot
+    );
+LPCWSTR UrlAclSnapshotFind(
+    __in URLACL_SNAPSHOT* pSnapshot,
+    __in_z LPCWSTR wzUrl
+    );
+void UrlAclSnapshotDiff(
+    __in URLACL_SNAPSHOT* pBefore,
+    __in URLACL_SNAPSHOT* pAfter,
+    __out_ecount(pAfter->cEntries) URLACL_ACTION* rgActions
+    );
@@ -10,7 +10,7 @@ static HRESULT AppendUrlAce(
 static HRESULT WriteHttpUrlReservation(
     __in WCA_TODO action,
     __in LPWSTR wzUrl,
-    __in LPWSTR wzSDDL,
+    __in LPCWSTR wzSDDL,
     __in int iHandleExisting,
     __in LPWSTR* psczCustomActionData
     );
@@ -18,10 +18,6 @@ static HRESULT AddUrlReservation(
     __in LPWSTR wzUrl,
     __in LPWSTR wzSddl
     );
-static HRESULT GetUrlReservation(
-    __in LPWSTR wzUrl,
-    __deref_out_z LPWSTR* psczSddl
-    );
 static HRESULT RemoveUrlReservation(
     __in LPWSTR wzUrl
     );
@@ -40,8 +36,6 @@ LPCWSTR vcsHttpUrlAceQuery =
     L"WHERE `WixHttpUrlAce`.`WixHttpUrlReservation_`=?";
 enum eHttpUrlAceQuery { huaqSecurityPrincipal = 1, huaqRights };
 
-enum eHandleExisting { heReplace = 0, heIgnore = 1, heFail = 2 };
-
 /******************************************************************
  SchedHttpUrlReservations - immediate custom action worker to 
    prepare configuring URL reservations.
@@ -56,6 +50,11 @@ static UINT SchedHttpUrlReservations(
     UINT er = ERROR_SUCCESS;
     BOOL fAceTableExists = FALSE;
     BOOL fHttpInitialized = FALSE;
+    URLACL_SNAPSHOT authored = { };
+    URLACL_SNAPSHOT existing = { };
+    URLACL_ACTION* rgActions = NULL;
+    URLACL_ENTRY* pEntry = NULL;
+    LPCWSTR wzExistingSDDL = NULL;
     DWORD cUrlReservations = 0;
 
     PMSIHANDLE hView = NULL;
@@ -74,7 +73,6 @@ static UINT SchedHttpUrlReservations(
     int iRights = 0;
     int iHandleExisting = 0;
 
-    LPWSTR sczExistingSDDL = NULL;
     LPWSTR sczSDDL = NULL;
 
     // Initialize.
@@ -98,11 +96,6 @@ static UINT SchedHttpUrlReservations(
     hr = WcaOpenExecuteView(vcsHttpUrlReservationQuery, &hView);
     ExitOnFailure(hr, "Failed to open view on the WixHttpUrlReservation table.");
 
-    hr = HRESULT_FROM_WIN32(::HttpInitialize(vcHttpVersion, vcHttpFlags, NULL));
-    ExitOnFailure(hr, "Failed to initialize HTTP Server configuration.");
-
-    fHttpInitialized = TRUE;
-
     while (S_OK == (hr = WcaFetchRecord(hView, &hRec)))
     {
         hr = WcaGetRecordString(hRec, hurqId, &sczId);
@@ -167,15 +160,8 @@ static UINT SchedHttpUrlReservations(
             ExitOnFailure(hr, "Failed to get WixHttpUrlReservation.SDDL");
         }
 
-        hr = GetUrlReservation(sczUrl, &sczExistingSDDL);
-        ExitOnFailure(hr, "Failed to get the existing SDDL for %ls", sczUrl);
-
-        hr = WriteHttpUrlReservation(todoComponent, sczUrl, sczExistingSDDL ? sczExistingSDDL : L"", iHandleExisting, &sczRollbackCustomActionData);
-        ExitOnFailure(hr, "Failed to write URL Reservation to rollback custom action data.");
-
-        hr = WriteHttpUrlReservation(todoComponent, sczUrl, sczSDDL, iHandleExisting, &sczCustomActionData);
-        ExitOnFailure(hr, "Failed to write URL reservation to custom action data.");
-        ++cUrlReservations;
+        hr = UrlAclSnapshotAdd(&authored, sczUrl, sczSDDL, todoComponent, iHandleExisting);
+        ExitOnFailure(hr, "Failed to add URL reservation '%ls'.", sczId);
     }
 
     // Reaching the end of the list is not an error.
@@ -185,6 +171,43 @@ static UINT SchedHttpUrlReservations(
     }
     ExitOnFailure(hr, "Failure occurred while processing WixHttpUrlReservation table.");
 
+    if (authored.cEntries)
+    {
+        hr = HRESULT_FROM_WIN32(::HttpInitialize(vcHttpVersion, vcHttpFlags, NULL));
+        ExitOnFailure(hr, "Failed to initialize HTTP Server configuration.");
+
+        fHttpInitialized = TRUE;
+
+        // Read all existing reservations once instead of querying HTTP.sys for each URL.
+        hr = UrlAclSnapshotInitialize(&authored, &existing);
+        ExitOnFailure(hr, "Failed to read existing URL reservations.");
+
+        rgActions = static_cast<URLACL_ACTION*>(MemAlloc(sizeof(URLACL_ACTION) * authored.cEntries, TRUE));
+        ExitOnNull(rgActions, hr, E_OUTOFMEMORY, "Failed to allocate URL reservation actions.");
+
+        UrlAclSnapshotDiff(&existing, &authored, rgActions);
+
+        for (DWORD i = 0; i < authored.cEntries; ++i)
+        {
+            pEntry = authored.rgEntries + i;
+
+            if (URLACL_ACTION_NONE == rgActions[i])
+            {
+                WcaLog(LOGMSG_VERBOSE, "URL reservation for '%ls' is already up to date.", pEntry->sczUrl);
+                continue;
+            }
+
+            wzExistingSDDL = UrlAclSnapshotFind(&existing, pEntry->sczUrl);
+
+            hr = WriteHttpUrlReservation(pEntry->todo, pEntry->sczUrl, wzExistingSDDL ? wzExistingSDDL : L"", pEntry->iHandleExisting, &sczRollbackCustomActionData);
+            ExitOnFailure(hr, "Failed to write URL Reservation to rollback custom action data.");
+
+            hr = WriteHttpUrlReservation(pEntry->todo, pEntry->sczUrl, pEntry->sczSddl, pEntry->iHandleExisting, &sczCustomActionData);
+            ExitOnFailure(hr, "Failed to write URL reservation to custom action data.");
+            ++cUrlReservations;
+        }
+    }
+
     // Schedule ExecHttpUrlReservations if there's anything to do.
     if (cUrlReservations)
     {
@@ -212,13 +235,15 @@ static UINT SchedHttpUrlReservations(
     }
 LExit:
     ReleaseStr(sczSDDL);
-    ReleaseStr(sczExistingSDDL);
     ReleaseStr(sczSecurityPrincipal);
     ReleaseStr(sczUrl)
     ReleaseStr(sczComponent);
     ReleaseStr(sczId);
     ReleaseStr(sczRollbackCustomActionData);
     ReleaseStr(sczCustomActionData);
+    ReleaseMem(rgActions);
+    UrlAclSnapshotUninitialize(&existing);
+    UrlAclSnapshotUninitialize(&authored);
 
     if (fHttpInitialized)
     {
@@ -265,7 +290,7 @@ LExit:
 static HRESULT WriteHttpUrlReservation(
     __in WCA_TODO action,
     __in LPWSTR wzUrl,
-    __in LPWSTR wzSDDL,
+    __in LPCWSTR wzSDDL,
     __in int iHandleExisting,
     __in LPWSTR* psczCustomActionData
     )
@@ -457,48 +482,6 @@ LExit:
     return hr;
 }
 
-static HRESULT GetUrlReservation(
-    __in LPWSTR wzUrl,
-    __deref_out_z LPWSTR* psczSddl
-    )
-{
-    HRESULT hr = S_OK;
-    DWORD er = ERROR_SUCCESS;
-    HTTP_SERVICE_CONFIG_URLACL_QUERY query = { };
-    HTTP_SERVICE_CONFIG_URLACL_SET* pSet = NULL;
-    ULONG cbSet = 0;
-
-    query.QueryDesc = HttpServiceConfigQueryExact;
-    query.KeyDesc.pUrlPrefix = wzUrl;
-
-    er = ::HttpQueryServiceConfiguration(NULL, HttpServiceConfigUrlAclInfo, &query, sizeof(query), pSet, cbSet, &cbSet, NULL);
-    if (ERROR_INSUFFICIENT_BUFFER == er)
-    {
-        pSet = reinterpret_cast<HTTP_SERVICE_CONFIG_URLACL_SET*>(MemAlloc(cbSet, TRUE));
-        ExitOnNull(pSet, hr, E_OUTOFMEMORY, "Failed to allocate query URLACL buffer.");
-
-        er = ::HttpQueryServiceConfiguration(NULL, HttpServiceConfigUrlAclInfo, &query, sizeof(query), pSet, cbSet, &cbSet, NULL);
-    }
-    
-    if (ERROR_SUCCESS == er)
-    {
-        hr = StrAllocString(psczSddl, pSet->ParamDesc.pStringSecurityDescriptor, 0);
-    }
-    else if (ERROR_FILE_NOT_FOUND == er)
-    {
-        hr = S_FALSE;
-    }
-    else
-    {
-        hr = HRESULT_FROM_WIN32(er);
-    }
-
-LExit:
-    ReleaseMem(pSet);
-
-    return hr;
-}
-
 static HRESULT RemoveUrlReservation(
     __in LPWSTR wzUrl
     )
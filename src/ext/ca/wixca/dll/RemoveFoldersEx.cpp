@@ -17,84 +17,48 @@ static HRESULT RecursePath(
     )
 {
     HRESULT hr = S_OK;
-    DWORD er;
-    LPWSTR sczSearch = NULL;
+    LPWSTR* rgsczDirectories = NULL;
+    DWORD cDirectories = 0;
     LPWSTR sczProperty = NULL;
-    HANDLE hFind = INVALID_HANDLE_VALUE;
-    WIN32_FIND_DATAW wfd;
-    LPWSTR sczNext = NULL;
 
-    // First recurse down to all the child directories.
-    hr = StrAllocFormatted(&sczSearch, L"%s*", wzPath);
-    ExitOnFailure(hr, "Failed to allocate file search string in path: %S", wzPath);
+    // First find all the child directories.
+    hr = DirEnumerateTree(wzPath, 0, &rgsczDirectories, &cDirectories);
+    ExitOnFailure(hr, "Failed to find all directories in path: %S", wzPath);
 
-    hFind = ::FindFirstFileW(sczSearch, &wfd);
-    if (INVALID_HANDLE_VALUE == hFind)
+    if (S_FALSE == hr)
     {
-        er = ::GetLastError();
-        if (ERROR_PATH_NOT_FOUND == er)
-        {
-            WcaLog(LOGMSG_STANDARD, "Search path not found: %ls", sczSearch);
-            ExitFunction1(hr = S_FALSE);
-        }
-        else
-        {
-            hr = HRESULT_FROM_WIN32(er);
-        }
-        ExitOnFailure(hr, "Failed to find all files in path: %S", wzPath);
+        WcaLog(LOGMSG_STANDARD, "Search path not found: %ls", wzPath);
+        ExitFunction();
     }
 
-    do
-    {
-        // Skip files and the dot directories.
-        if (FILE_ATTRIBUTE_DIRECTORY != (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || L'.' == wfd.cFileName[0] && (L'\0' == wfd.cFileName[1] || (L'.' == wfd.cFileName[1] && L'\0' == wfd.cFileName[2])))
-        {
-            continue;
-        }
-
-        hr = StrAllocFormatted(&sczNext, L"%s%s\\", wzPath, wfd.cFileName);
-        ExitOnFailure(hr, "Failed to concat filename '%S' to string: %S", wfd.cFileName, wzPath);
-
-        hr = RecursePath(sczNext, wzId, wzComponent, wzProperty, iMode, pdwCounter, phTable, phColumns);
-        ExitOnFailure(hr, "Failed to recurse path: %S", sczNext);
-    } while (::FindNextFileW(hFind, &wfd));
+    WcaLog(LOGMSG_VERBOSE, "Found %u directories in path: %ls", cDirectories, wzPath);
 
-    er = ::GetLastError();
-    if (ERROR_NO_MORE_FILES == er)
+    // Then add the rows for all of them, children before their parents.
+    for (DWORD i = cDirectories; i > 0; --i)
     {
-        hr = S_OK;
-    }
-    else
-    {
-        hr = HRESULT_FROM_WIN32(er);
-        ExitOnFailure(hr, "Failed while looping through files in directory: %S", wzPath);
-    }
-
-    // Finally, set a property that points at our path.
-    hr = StrAllocFormatted(&sczProperty, L"_%s_%u", wzProperty, *pdwCounter);
-    ExitOnFailure(hr, "Failed to allocate Property for RemoveFile table with property: %S.", wzProperty);
+        LPCWSTR wzDirectory = rgsczDirectories[i - 1];
 
-    ++(*pdwCounter);
+        // Set a property that points at the directory.
+        hr = StrAllocFormatted(&sczProperty, L"_%s_%u", wzProperty, *pdwCounter);
+        ExitOnFailure(hr, "Failed to allocate Property for RemoveFile table with property: %S.", wzProperty);
 
-    hr = WcaSetProperty(sczProperty, wzPath);
-    ExitOnFailure(hr, "Failed to set Property: %S with path: %S", sczProperty, wzPath);
+        ++(*pdwCounter);
 
-    // Add the row to remove any files and another row to remove the folder.
-    hr = WcaAddTempRecord(phTable, phColumns, L"RemoveFile", NULL, 1, 5, L"RfxFiles", wzComponent, L"*.*", sczProperty, iMode);
-    ExitOnFailure(hr, "Failed to add row to remove all files for WixRemoveFolderEx row: %S under path:", wzId, wzPath);
+        hr = WcaSetProperty(sczProperty, wzDirectory);
+        ExitOnFailure(hr, "Failed to set Property: %S with path: %S", sczProperty, wzDirectory);
 
-    hr = WcaAddTempRecord(phTable, phColumns, L"RemoveFile", NULL, 1, 5, L"RfxFolder", wzComponent, NULL, sczProperty, iMode);
-    ExitOnFailure(hr, "Failed to add row to remove folder for WixRemoveFolderEx row: %S under path: %S", wzId, wzPath);
+        // Add the row to remove any files and another row to remove the folder.
+        hr = WcaAddTempRecord(phTable, phColumns, L"RemoveFile", NULL, 1, 5, L"RfxFiles", wzComponent, L"*.*", sczProperty, iMode);
+        ExitOnFailure(hr, "Failed to add row to remove all files for WixRemoveFolderEx row: %S under path: %S", wzId, wzDirectory);
 
-LExit:
-    if (INVALID_HANDLE_VALUE != hFind)
-    {
-        ::FindClose(hFind);
+        hr = WcaAddTempRecord(phTable, phColumns, L"RemoveFile", NULL, 1, 5, L"RfxFolder", wzComponent, NULL, sczProperty, iMode);
+        ExitOnFailure(hr, "Failed to add row to remove folder for WixRemoveFolderEx row: %S under path: %S", wzId, wzDirectory);
     }
 
-    ReleaseStr(sczNext);
+LExit:
     ReleaseStr(sczProperty);
-    ReleaseStr(sczSearch);
+    ReleaseStrArray(rgsczDirectories, cDirectories);
+
     return hr;
 }
 
@@ -316,17 +316,17 @@ LExit:
 static HRESULT BeginChangeFile(
     __in LPCWSTR pwzFile,
     __in int iCompAttributes,
-    __inout LPWSTR* ppwzCustomActionData
+    __in DWORD iFile,
+    __inout LPWSTR* ppwzCustomActionData,
+    __inout LPWSTR* ppwzCommitCustomActionData
     )
 {
-    Assert(pwzFile && *pwzFile && ppwzCustomActionData);
+    Assert(pwzFile && *pwzFile && ppwzCustomActionData && ppwzCommitCustomActionData);
 
     HRESULT hr = S_OK;
     BOOL fIs64Bit = iCompAttributes & msidbComponentAttributes64bit;
 
-    LPBYTE pbData = NULL;
-    DWORD cbData = 0;
-
+    LPWSTR pwzJournalKey = NULL;
     LPWSTR pwzRollbackCustomActionData = NULL;
 
     if (fIs64Bit)
@@ -343,11 +343,18 @@ static HRESULT BeginChangeFile(
     hr = WcaWriteStringToCaData(pwzFile, ppwzCustomActionData);
     ExitOnFailure(hr, "failed to write file to custom action data: %ls", pwzFile);
 
-    // If the file already exits, then we have to put it back the way it was on failure
-    if (FileExistsEx(pwzFile, NULL))
+    // ExecXmlConfig journals the file before changing it so rollback can put it back the way it was.
+    // Without rollback there is nothing to restore and no commit to remove the journal, so skip it.
+    if (::MsiGetMode(WcaGetInstallHandle(), MSIRUNMODE_ROLLBACKENABLED))
     {
-        hr = FileRead(&pbData, &cbData, pwzFile);
-        ExitOnFailure(hr, "failed to read file: %ls", pwzFile);
+        hr = XmlJournalCreateKey(iFile, &pwzJournalKey);
+        ExitOnFailure(hr, "failed to create rollback journal key for file: %ls", pwzFile);
+
+        hr = WcaWriteStringToCaData(pwzJournalKey, ppwzCustomActionData);
+        ExitOnFailure(hr, "failed to write rollback journal key to custom action data: %ls", pwzJournalKey);
+
+        hr = WcaWriteStringToCaData(pwzJournalKey, ppwzCommitCustomActionData);
+        ExitOnFailure(hr, "failed to write rollback journal key to commit custom action data: %ls", pwzJournalKey);
 
         // Set up the rollback for this file
         hr = WcaWriteIntegerToCaData((int)fIs64Bit, &pwzRollbackCustomActionData);
@@ -356,74 +363,27 @@ static HRESULT BeginChangeFile(
         hr = WcaWriteStringToCaData(pwzFile, &pwzRollbackCustomActionData);
         ExitOnFailure(hr, "failed to write file name to rollback custom action data: %ls", pwzFile);
 
-        hr = WcaWriteStreamToCaData(pbData, cbData, &pwzRollbackCustomActionData);
-        ExitOnFailure(hr, "failed to write file contents to rollback custom action data.");
+        hr = WcaWriteStringToCaData(pwzJournalKey, &pwzRollbackCustomActionData);
+        ExitOnFailure(hr, "failed to write rollback journal key to rollback custom action data: %ls", pwzJournalKey);
 
         hr = WcaDoDeferredAction(PLATFORM_DECORATION(L"ExecXmlConfigRollback"), pwzRollbackCustomActionData, COST_XMLFILE);
         ExitOnFailure(hr, "failed to schedule ExecXmlConfigRollback for file: %ls", pwzFile);
-
-        ReleaseStr(pwzRollbackCustomActionData);
-    }
-LExit:
-    ReleaseMem(pbData);
-
-    return hr;
-}
-
-
-static HRESULT WriteChangeData(
-    __in XML_CONFIG_CHANGE* pxfc,
-    __in eXmlAction action,
-    __inout LPWSTR* ppwzCustomActionData
-    )
-{
-    Assert(pxfc && ppwzCustomActionData);
-
-    HRESULT hr = S_OK;
-    XML_CONFIG_CHANGE* pxfcAdditionalChanges = NULL;
-
-    hr = WcaWriteStringToCaData(pxfc->pwzElementPath, ppwzCustomActionData);
-    ExitOnFailure(hr, "failed to write ElementPath to custom action data: %ls", pxfc->pwzElementPath);
-
-    hr = WcaWriteStringToCaData(pxfc->pwzVerifyPath, ppwzCustomActionData);
-    ExitOnFailure(hr, "failed to write VerifyPath to custom action data: %ls", pxfc->pwzVerifyPath);
-
-    hr = WcaWriteStringToCaData(pxfc->wzName, ppwzCustomActionData);
-    ExitOnFailure(hr, "failed to write Name to custom action data: %ls", pxfc->wzName);
-
-    hr = WcaWriteStringToCaData(pxfc->pwzValue, ppwzCustomActionData);
-    ExitOnFailure(hr, "failed to write Value to custom action data: %ls", pxfc->pwzValue);
-
-    if (pxfc->iXmlFlags & XMLCONFIG_CREATE && pxfc->iXmlFlags & XMLCONFIG_ELEMENT && xaCreateElement == action && pxfc->pxfcAdditionalChanges)
-    {
-        hr = WcaWriteIntegerToCaData(pxfc->cAdditionalChanges, ppwzCustomActionData);
-        ExitOnFailure(hr, "failed to write additional changes value to custom action data");
-
-        pxfcAdditionalChanges = pxfc->pxfcAdditionalChanges;
-        while (pxfcAdditionalChanges)
-        {
-            Assert((0 == lstrcmpW(pxfcAdditionalChanges->wzComponent, pxfc->wzComponent)) && 0 == pxfcAdditionalChanges->iXmlFlags && (0 == lstrcmpW(pxfcAdditionalChanges->wzFile, pxfc->wzFile)));
-
-            hr = WcaWriteStringToCaData(pxfcAdditionalChanges->wzName, ppwzCustomActionData);
-            ExitOnFailure(hr, "failed to write Name to custom action data: %ls", pxfc->wzName);
-
-            hr = WcaWriteStringToCaData(pxfcAdditionalChanges->pwzValue, ppwzCustomActionData);
-            ExitOnFailure(hr, "failed to write Value to custom action data: %ls", pxfc->pwzValue);
-
-            pxfcAdditionalChanges = pxfcAdditionalChanges->pxfcNext;
-        }
     }
     else
     {
-        hr = WcaWriteIntegerToCaData(0, ppwzCustomActionData);
-        ExitOnFailure(hr, "failed to write additional changes value to custom action data");
+        hr = WcaWriteStringToCaData(L"", ppwzCustomActionData);
+        ExitOnFailure(hr, "failed to write empty rollback journal key to custom action data");
     }
 
 LExit:
+    ReleaseStr(pwzRollbackCustomActionData);
+    ReleaseStr(pwzJournalKey);
+
     return hr;
 }
 
 
+
 /******************************************************************
  SchedXmlConfig - entry point for XmlConfig Custom Action
 
@@ -451,6 +411,7 @@ extern "C" UINT __stdcall SchedXmlConfig(
     eXmlPreserveDate xd;
 
     LPWSTR pwzCustomActionData = NULL;
+    LPWSTR pwzCommitCustomActionData = NULL;
 
     DWORD cFiles = 0;
 
@@ -527,7 +488,7 @@ extern "C" UINT __stdcall SchedXmlConfig(
         {
             if (fCurrentFileChanged)
             {
-                hr = BeginChangeFile(pwzCurrentFile, pxfc->iCompAttributes, &pwzCustomActionData);
+                hr = BeginChangeFile(pwzCurrentFile, pxfc->iCompAttributes, cFiles, &pwzCustomActionData, &pwzCommitCustomActionData);
                 ExitOnFailure(hr, "failed to begin file change for file: %ls", pwzCurrentFile);
 
                 fCurrentFileChanged = FALSE;
@@ -559,11 +520,19 @@ extern "C" UINT __stdcall SchedXmlConfig(
 
         hr = WcaDoDeferredAction(PLATFORM_DECORATION(L"ExecXmlConfig"), pwzCustomActionData, cFiles * COST_XMLFILE);
         ExitOnFailure(hr, "failed to schedule ExecXmlConfig action");
+
+        // Once the install can no longer roll back, the journals aren't needed
+        if (pwzCommitCustomActionData && *pwzCommitCustomActionData)
+        {
+            hr = WcaDoDeferredAction(PLATFORM_DECORATION(L"ExecXmlConfigCommit"), pwzCommitCustomActionData, 0);
+            ExitOnFailure(hr, "failed to schedule ExecXmlConfigCommit action");
+        }
     }
 
 LExit:
     ReleaseStr(pwzCurrentFile);
     ReleaseStr(pwzCustomActionData);
+    ReleaseStr(pwzCommitCustomActionData);
 
     FreeXmlConfigChangeList(pxfcHead);
 
@@ -595,6 +564,7 @@ extern "C" UINT __stdcall ExecXmlConfig(
     LPWSTR pwzCustomActionData = NULL;
     LPWSTR pwzData = NULL;
     LPWSTR pwzFile = NULL;
+    LPWSTR pwzJournalKey = NULL;
     LPWSTR pwzElementPath = NULL;
     LPWSTR pwzVerifyPath = NULL;
     LPWSTR pwzName = NULL;
@@ -651,6 +621,9 @@ extern "C" UINT __stdcall ExecXmlConfig(
         hr = WcaReadStringFromCaData(&pwz, &pwzFile);
         ExitOnFailure(hr, "failed to read file name from custom action data");
 
+        hr = WcaReadStringFromCaData(&pwz, &pwzJournalKey);
+        ExitOnFailure(hr, "failed to read rollback journal key from custom action data");
+
         // Default to not preserve date, preserve it if any modifications require us to
         fPreserveDate = FALSE;
 
@@ -671,6 +644,13 @@ extern "C" UINT __stdcall ExecXmlConfig(
             fIsFSRedirectDisabled = TRUE;
         }
 
+        // If the file already exists and rollback is enabled, then we have to put it back the way it was on failure
+        if (*pwzJournalKey && FileExistsEx(pwzFile, NULL))
+        {
+            hr = XmlJournalBackupFile(pwzJournalKey, pwzFile);
+            ExitOnFailure(hr, "failed to journal file: %ls", pwzFile);
+        }
+
         hr = XmlLoadDocumentFromFileEx(pwzFile, XML_LOAD_PRESERVE_WHITESPACE, &pixd);
         if (FAILED(hr))
         {
@@ -965,6 +945,7 @@ LExit:
     ReleaseStr(pwzCustomActionData);
     ReleaseStr(pwzData);
     ReleaseStr(pwzFile);
+    ReleaseStr(pwzJournalKey);
     ReleaseStr(pwzElementPath);
     ReleaseStr(pwzVerifyPath);
     ReleaseStr(pwzName);
@@ -1006,13 +987,7 @@ extern "C" UINT __stdcall ExecXmlConfigRollback(
     LPWSTR pwzCustomActionData = NULL;
     LPWSTR pwz = NULL;
     LPWSTR pwzFileName = NULL;
-    LPBYTE pbData = NULL;
-    DWORD_PTR cbData = 0;
-    DWORD cbDataWritten = 0;
-
-    FILETIME ft;
-
-    HANDLE hFile = INVALID_HANDLE_VALUE;
+    LPWSTR pwzJournalKey = NULL;
 
     // initialize
     hr = WcaInitialize(hInstall, "ExecXmlConfigRollback");
@@ -1032,8 +1007,8 @@ extern "C" UINT __stdcall ExecXmlConfigRollback(
     hr = WcaReadStringFromCaData(&pwz, &pwzFileName);
     ExitOnFailure(hr, "failed to read file name from custom action data");
 
-    hr = WcaReadStreamFromCaData(&pwz, &pbData, &cbData);
-    ExitOnFailure(hr, "failed to read file contents from custom action data");
+    hr = WcaReadStringFromCaData(&pwz, &pwzJournalKey);
+    ExitOnFailure(hr, "failed to read rollback journal key from custom action data");
 
     fIs64Bit = (BOOL)iIs64Bit;
 
@@ -1056,39 +1031,67 @@ extern "C" UINT __stdcall ExecXmlConfigRollback(
         ExitOnFailure(hr, "Custom action was told to rollback a 64-bit component, but was unable to Disable Filesystem Redirection through the Wow64 API.");
     }
 
-    hr = FileGetTime(pwzFileName, NULL, NULL, &ft);
-    ExitOnFailure(hr, "Failed to get modified date of file %ls.", pwzFileName);
+    hr = XmlJournalRestoreFile(pwzJournalKey, pwzFileName);
+    ExitOnFailure(hr, "failed to restore file: %ls", pwzFileName);
 
-    // Open the file
-    hFile = ::CreateFileW(pwzFileName, GENERIC_WRITE, NULL, NULL, TRUNCATE_EXISTING, NULL, NULL);
-    ExitOnInvalidHandleWithLastError(hFile, hr, "failed to open file: %ls", pwzFileName);
+LExit:
+    ReleaseStr(pwzCustomActionData);
+    ReleaseStr(pwzFileName);
+    ReleaseStr(pwzJournalKey);
 
-    // Write out the old data
-    if (!::WriteFile(hFile, pbData, (DWORD)cbData, &cbDataWritten, NULL))
+    if (fIs64Bit)
     {
-        ExitOnLastError(hr, "failed to write to file: %ls", pwzFileName);
+        WcaRevertWow64FSRedirection();
+        WcaFinalizeWow64();
     }
 
-    Assert(cbData == cbDataWritten);
+    if (FAILED(hr))
+    {
+        er = ERROR_INSTALL_FAILURE;
+    }
+    return WcaFinalize(er);
+}
 
-    ReleaseFile(hFile);
 
-    hr = FileSetTime(pwzFileName, NULL, NULL, &ft);
-    ExitOnFailure(hr, "Failed to set modified date of file %ls.", pwzFileName);
+/******************************************************************
+ ExecXmlConfigCommit - entry point for XmlConfig commit Custom Action
 
-LExit:
-    ReleaseStr(pwzCustomActionData);
-    ReleaseStr(pwzFileName);
+ Note: This is a commit CustomAction.
+*******************************************************************/
+extern "C" UINT __stdcall ExecXmlConfigCommit(
+    __in MSIHANDLE hInstall
+    )
+{
+//    AssertSz(FALSE, "debug ExecXmlConfigCommit");
+    HRESULT hr = S_OK;
+    UINT er = ERROR_SUCCESS;
 
-    ReleaseFile(hFile);
+    LPWSTR pwzCustomActionData = NULL;
+    LPWSTR pwz = NULL;
+    LPWSTR pwzJournalKey = NULL;
 
-    if (fIs64Bit)
+    // initialize
+    hr = WcaInitialize(hInstall, "ExecXmlConfigCommit");
+    ExitOnFailure(hr, "failed to initialize");
+
+    hr = WcaGetProperty( L"CustomActionData", &pwzCustomActionData);
+    ExitOnFailure(hr, "failed to get CustomActionData");
+
+    WcaLog(LOGMSG_TRACEONLY, "CustomActionData: %ls", pwzCustomActionData);
+
+    pwz = pwzCustomActionData;
+
+    while (pwz && *pwz)
     {
-        WcaRevertWow64FSRedirection();
-        WcaFinalizeWow64();
+        hr = WcaReadStringFromCaData(&pwz, &pwzJournalKey);
+        ExitOnFailure(hr, "failed to read rollback journal key from custom action data");
+
+        XmlJournalDelete(pwzJournalKey);
     }
 
-    ReleaseMem(pbData);
+LExit:
+    ReleaseStr(pwzCustomActionData);
+    ReleaseStr(pwzJournalKey);
 
     if (FAILED(hr))
     {
@@ -1096,4 +1099,3 @@ LExit:
     }
     return WcaFinalize(er);
 }
-
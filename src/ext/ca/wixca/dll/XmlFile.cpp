@@ -202,16 +202,17 @@ LExit:
 static HRESULT BeginChangeFile(
     __in LPCWSTR pwzFile,
     __in XML_FILE_CHANGE* pxfc,
-    __inout LPWSTR* ppwzCustomActionData
+    __in DWORD iFile,
+    __inout LPWSTR* ppwzCustomActionData,
+    __inout LPWSTR* ppwzCommitCustomActionData
     )
 {
-    Assert(pwzFile && *pwzFile && ppwzCustomActionData);
+    Assert(pwzFile && *pwzFile && ppwzCustomActionData && ppwzCommitCustomActionData);
 
     HRESULT hr = S_OK;
     BOOL fIs64Bit = pxfc->iCompAttributes & msidbComponentAttributes64bit;
     BOOL fUseXPath = pxfc->iXmlFlags & XMLFILE_USE_XPATH;
-    LPBYTE pbData = NULL;
-    DWORD cbData = 0;
+    LPWSTR pwzJournalKey = NULL;
 
     LPWSTR pwzRollbackCustomActionData = NULL;
 
@@ -238,11 +239,18 @@ static HRESULT BeginChangeFile(
     hr = WcaWriteStringToCaData(pwzFile, ppwzCustomActionData);
     ExitOnFailure(hr, "failed to write file to custom action data: %ls", pwzFile);
 
-    // If the file already exits, then we have to put it back the way it was on failure
-    if (FileExistsEx(pwzFile, NULL))
+    // ExecXmlFile journals the file before changing it so rollback can put it back the way it was.
+    // Without rollback there is nothing to restore and no commit to remove the journal, so skip it.
+    if (::MsiGetMode(WcaGetInstallHandle(), MSIRUNMODE_ROLLBACKENABLED))
     {
-        hr = FileRead(&pbData, &cbData, pwzFile);
-        ExitOnFailure(hr, "failed to read file: %ls", pwzFile);
+        hr = XmlJournalCreateKey(iFile, &pwzJournalKey);
+        ExitOnFailure(hr, "failed to create rollback journal key for file: %ls", pwzFile);
+
+        hr = WcaWriteStringToCaData(pwzJournalKey, ppwzCustomActionData);
+        ExitOnFailure(hr, "failed to write rollback journal key to custom action data: %ls", pwzJournalKey);
+
+        hr = WcaWriteStringToCaData(pwzJournalKey, ppwzCommitCustomActionData);
+        ExitOnFailure(hr, "failed to write rollback journal key to commit custom action data: %ls", pwzJournalKey);
 
         // Set up the rollback for this file
         hr = WcaWriteIntegerToCaData((int)fIs64Bit, &pwzRollbackCustomActionData);
@@ -251,16 +259,21 @@ static HRESULT BeginChangeFile(
         hr = WcaWriteStringToCaData(pwzFile, &pwzRollbackCustomActionData);
         ExitOnFailure(hr, "failed to write file name to rollback custom action data: %ls", pwzFile);
 
-        hr = WcaWriteStreamToCaData(pbData, cbData, &pwzRollbackCustomActionData);
-        ExitOnFailure(hr, "failed to write file contents to rollback custom action data.");
+        hr = WcaWriteStringToCaData(pwzJournalKey, &pwzRollbackCustomActionData);
+        ExitOnFailure(hr, "failed to write rollback journal key to rollback custom action data: %ls", pwzJournalKey);
 
         hr = WcaDoDeferredAction(PLATFORM_DECORATION(L"ExecXmlFileRollback"), pwzRollbackCustomActionData, COST_XMLFILE);
         ExitOnFailure(hr, "failed to schedule ExecXmlFileRollback for file: %ls", pwzFile);
-
-        ReleaseStr(pwzRollbackCustomActionData);
     }
+    else
+    {
+        hr = WcaWriteStringToCaData(L"", ppwzCustomActionData);
+        ExitOnFailure(hr, "failed to write empty rollback journal key to custom action data");
+    }
+
 LExit:
-    ReleaseMem(pbData);
+    ReleaseStr(pwzRollbackCustomActionData);
+    ReleaseStr(pwzJournalKey);
 
     return hr;
 }
@@ -315,6 +328,7 @@ extern "C" UINT __stdcall SchedXmlFile(
     XML_FILE_CHANGE* pxfcUninstall = NULL;
 
     LPWSTR pwzCustomActionData = NULL;
+    LPWSTR pwzCommitCustomActionData = NULL;
 
     DWORD cFiles = 0;
 
@@ -351,7 +365,7 @@ extern "C" UINT __stdcall SchedXmlFile(
                         {
                             if (!fCurrentFileChanged)
                             {
-                                hr = BeginChangeFile(pwzCurrentFile, pxfcUninstall, &pwzCustomActionData);
+                                hr = BeginChangeFile(pwzCurrentFile, pxfcUninstall, cFiles, &pwzCustomActionData, &pwzCommitCustomActionData);
                                 ExitOnFailure(hr, "failed to begin file change for file: %ls", pwzCurrentFile);
 
                                 fCurrentFileChanged = TRUE;
@@ -400,7 +414,7 @@ extern "C" UINT __stdcall SchedXmlFile(
         {
             if (!fCurrentFileChanged)
             {
-                hr = BeginChangeFile(pwzCurrentFile, pxfc, &pwzCustomActionData);
+                hr = BeginChangeFile(pwzCurrentFile, pxfc, cFiles, &pwzCustomActionData, &pwzCommitCustomActionData);
                 ExitOnFailure(hr, "failed to begin file change for file: %ls", pwzCurrentFile);
                 fCurrentFileChanged = TRUE;
                 ++cFiles;
@@ -456,11 +470,19 @@ extern "C" UINT __stdcall SchedXmlFile(
 
         hr = WcaDoDeferredAction(PLATFORM_DECORATION(L"ExecXmlFile"), pwzCustomActionData, cFiles * COST_XMLFILE);
         ExitOnFailure(hr, "failed to schedule ExecXmlFile action");
+
+        // Once the install can no longer roll back, the journals aren't needed
+        if (pwzCommitCustomActionData && *pwzCommitCustomActionData)
+        {
+            hr = WcaDoDeferredAction(PLATFORM_DECORATION(L"ExecXmlFileCommit"), pwzCommitCustomActionData, 0);
+            ExitOnFailure(hr, "failed to schedule ExecXmlFileCommit action");
+        }
     }
 
 LExit:
     ReleaseStr(pwzCurrentFile);
     ReleaseStr(pwzCustomActionData);
+    ReleaseStr(pwzCommitCustomActionData);
 
     if (FAILED(hr))
         er = ERROR_INSTALL_FAILURE;
@@ -490,6 +512,7 @@ extern "C" UINT __stdcall ExecXmlFile(
     LPWSTR pwzCustomActionData = NULL;
     LPWSTR pwzData = NULL;
     LPWSTR pwzFile = NULL;
+    LPWSTR pwzJournalKey = NULL;
     LPWSTR pwzXPath = NULL;
     LPWSTR pwzName = NULL;
     LPWSTR pwzValue = NULL;
@@ -548,6 +571,9 @@ extern "C" UINT __stdcall ExecXmlFile(
         hr = WcaReadStringFromCaData(&pwz, &pwzFile);
         ExitOnFailure(hr, "failed to read file name from custom action data");
 
+        hr = WcaReadStringFromCaData(&pwz, &pwzJournalKey);
+        ExitOnFailure(hr, "failed to read rollback journal key from custom action data");
+
         // Default to not preserve the modified date
         fPreserveDate = FALSE;
 
@@ -568,6 +594,13 @@ extern "C" UINT __stdcall ExecXmlFile(
             fIsFSRedirectDisabled = TRUE;
         }
 
+        // If the file already exists and rollback is enabled, then we have to put it back the way it was on failure
+        if (*pwzJournalKey && FileExistsEx(pwzFile, NULL))
+        {
+            hr = XmlJournalBackupFile(pwzJournalKey, pwzFile);
+            ExitOnFailure(hr, "failed to journal file: %ls", pwzFile);
+        }
+
         hr = XmlLoadDocumentFromFileEx(pwzFile, XML_LOAD_PRESERVE_WHITESPACE, &pixd);
         if (FAILED(hr))
         {
@@ -813,6 +846,7 @@ LExit:
     ReleaseStr(pwzCustomActionData);
     ReleaseStr(pwzData);
     ReleaseStr(pwzFile);
+    ReleaseStr(pwzJournalKey);
     ReleaseStr(pwzXPath);
     ReleaseStr(pwzName);
     ReleaseStr(pwzValue);
@@ -851,13 +885,7 @@ extern "C" UINT __stdcall ExecXmlFileRollback(
     LPWSTR pwzCustomActionData = NULL;
     LPWSTR pwz = NULL;
     LPWSTR pwzFileName = NULL;
-    LPBYTE pbData = NULL;
-    DWORD_PTR cbData = 0;
-    DWORD cbDataWritten = 0;
-
-    FILETIME ft;
-
-    HANDLE hFile = INVALID_HANDLE_VALUE;
+    LPWSTR pwzJournalKey = NULL;
 
     // initialize
     hr = WcaInitialize(hInstall, "ExecXmlFileRollback");
@@ -877,8 +905,8 @@ extern "C" UINT __stdcall ExecXmlFileRollback(
     hr = WcaReadStringFromCaData(&pwz, &pwzFileName);
     ExitOnFailure(hr, "failed to read file name from custom action data");
 
-    hr = WcaReadStreamFromCaData(&pwz, &pbData, &cbData);
-    ExitOnFailure(hr, "failed to read file contents from custom action data");
+    hr = WcaReadStringFromCaData(&pwz, &pwzJournalKey);
+    ExitOnFailure(hr, "failed to read rollback journal key from custom action data");
 
     fIs64Bit = (BOOL)iIs64Bit;
 
@@ -901,31 +929,14 @@ extern "C" UINT __stdcall ExecXmlFileRollback(
         ExitOnFailure(hr, "Custom action was told to rollback a 64-bit component, but was unable to Disable Filesystem Redirection through the Wow64 API.");
     }
 
-    // Always preserve the modified date on rollback
-    hr = FileGetTime(pwzFileName, NULL, NULL, &ft);
-    ExitOnFailure(hr, "Failed to get modified date of file %ls.", pwzFileName);
-
-    // Open the file
-    hFile = ::CreateFileW(pwzFileName, GENERIC_WRITE, NULL, NULL, TRUNCATE_EXISTING, NULL, NULL);
-    ExitOnInvalidHandleWithLastError(hFile, hr, "failed to open file: %ls", pwzFileName);
-
-    // Write out the old data
-    if (!::WriteFile(hFile, pbData, (DWORD)cbData, &cbDataWritten, NULL))
-        ExitOnLastError(hr, "failed to write to file: %ls", pwzFileName);
-
-    Assert(cbData == cbDataWritten);
-
-    ReleaseFile(hFile);
-
-    // Always preserve the modified date on rollback
-    hr = FileSetTime(pwzFileName, NULL, NULL, &ft);
-    ExitOnFailure(hr, "Failed to set modified date of file %ls.", pwzFileName);
+    // The journal also restores the modified date the file had before it was changed
+    hr = XmlJournalRestoreFile(pwzJournalKey, pwzFileName);
+    ExitOnFailure(hr, "failed to restore file: %ls", pwzFileName);
 
 LExit:
     ReleaseStr(pwzCustomActionData);
     ReleaseStr(pwzFileName);
-
-    ReleaseFile(hFile);
+    ReleaseStr(pwzJournalKey);
 
     if (fIs64Bit)
     {
@@ -933,10 +944,53 @@ LExit:
         WcaFinalizeWow64();
     }
 
-    ReleaseMem(pbData);
-
     if (FAILED(hr))
         er = ERROR_INSTALL_FAILURE;
     return WcaFinalize(er);
 }
 
+
+/******************************************************************
+ ExecXmlFileCommit - entry point for XmlFile commit Custom Action
+
+ Note: This is a commit CustomAction.
+*******************************************************************/
+extern "C" UINT __stdcall ExecXmlFileCommit(
+    __in MSIHANDLE hInstall
+    )
+{
+//    AssertSz(FALSE, "debug ExecXmlFileCommit");
+    HRESULT hr = S_OK;
+    UINT er = ERROR_SUCCESS;
+
+    LPWSTR pwzCustomActionData = NULL;
+    LPWSTR pwz = NULL;
+    LPWSTR pwzJournalKey = NULL;
+
+    // initialize
+    hr = WcaInitialize(hInstall, "ExecXmlFileCommit");
+    ExitOnFailure(hr, "failed to initialize");
+
+    hr = WcaGetProperty( L"CustomActionData", &pwzCustomActionData);
+    ExitOnFailure(hr, "failed to get CustomActionData");
+
+    WcaLog(LOGMSG_TRACEONLY, "CustomActionData: %ls", pwzCustomActionData);
+
+    pwz = pwzCustomActionData;
+
+    while (pwz && *pwz)
+    {
+        hr = WcaReadStringFromCaData(&pwz, &pwzJournalKey);
+        ExitOnFailure(hr, "failed to read rollback journal key from custom action data");
+
+        XmlJournalDelete(pwzJournalKey);
+    }
+
+LExit:
+    ReleaseStr(pwzCustomActionData);
+    ReleaseStr(pwzJournalKey);
+
+    if (FAILED(hr))
+        er = ERROR_INSTALL_FAILURE;
+    return WcaFinalize(er);
+}
@@ -0,0 +1,286 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+// The rollback journal for an XmlFile or XmlConfig file is a ca script that holds
+// a header followed by the original contents of the file.
+const DWORD XML_JOURNAL_MAGIC = 0x4C4E524A; // "JRNL"
+const DWORD XML_JOURNAL_VERSION = 1;
+
+struct XML_JOURNAL_HEADER
+{
+    DWORD dwMagic;
+    DWORD dwVersion;
+    DWORD64 qwSize;
+    FILETIME ftCreation;
+    FILETIME ftLastAccess;
+    FILETIME ftLastWrite;
+    BYTE rgbHash[SHA1_HASH_LEN];
+};
+
+static HRESULT OpenJournal(
+    __in_z LPCWSTR wzJournalKey,
+    __in BOOL fAppend,
+    __out WCA_CASCRIPT_HANDLE* phJournal
+    );
+
+
+/********************************************************************
+ XmlJournalCreateKey - creates the key of the journal for the iFile'th
+                       file changed by the calling CustomAction.
+
+********************************************************************/
+HRESULT XmlJournalCreateKey(
+    __in DWORD iFile,
+    __deref_out_z LPWSTR* psczJournalKey
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR sczScriptKey = NULL;
+
+    hr = WcaCaScriptCreateKey(&sczScriptKey);
+    ExitOnFailure(hr, "failed to create script key");
+
+    hr = StrAllocFormatted(psczJournalKey, L"%ls.%u", sczScriptKey, iFile);
+    ExitOnFailure(hr, "failed to create journal key");
+
+LExit:
+    ReleaseStr(sczScriptKey);
+
+    return hr;
+}
+
+
+/********************************************************************
+ XmlJournalBackupFile - copies the file into its rollback journal
+                        before it is changed.
+
+********************************************************************/
+HRESULT XmlJournalBackupFile(
+    __in_z LPCWSTR wzJournalKey,
+    __in_z LPCWSTR wzFile
+    )
+{
+    HRESULT hr = S_OK;
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    WCA_CASCRIPT_HANDLE hJournal = NULL;
+    BOOL fJournalComplete = FALSE;
+    XML_JOURNAL_HEADER header = { };
+    DWORD64 cbCopied = 0;
+
+    hFile = ::CreateFileW(wzFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    ExitOnInvalidHandleWithLastError(hFile, hr, "failed to open file: %ls", wzFile);
+
+    if (!::GetFileTime(hFile, &header.ftCreation, &header.ftLastAccess, &header.ftLastWrite))
+    {
+        ExitWithLastError(hr, "failed to get times of file: %ls", wzFile);
+    }
+
+    hr = CrypHashFileHandle(hFile, PROV_RSA_FULL, CALG_SHA1, header.rgbHash, sizeof(header.rgbHash), &header.qwSize);
+    ExitOnFailure(hr, "failed to hash file: %ls", wzFile);
+
+    header.dwMagic = XML_JOURNAL_MAGIC;
+    header.dwVersion = XML_JOURNAL_VERSION;
+
+    hr = FileSetPointer(hFile, 0, NULL, FILE_BEGIN);
+    ExitOnFailure(hr, "failed to seek to beginning of file: %ls", wzFile);
+
+    hr = OpenJournal(wzJournalKey, FALSE, &hJournal);
+    ExitOnFailure(hr, "failed to create rollback journal: %ls", wzJournalKey);
+
+    hr = FileWriteHandle(hJournal->hScriptFile, reinterpret_cast<LPCBYTE>(&header), sizeof(header));
+    ExitOnFailure(hr, "failed to write rollback journal header: %ls", hJournal->pwzScriptPath);
+
+    hr = FileCopyUsingHandles(hFile, hJournal->hScriptFile, header.qwSize, &cbCopied);
+    ExitOnFailure(hr, "failed to copy file: %ls to rollback journal: %ls", wzFile, hJournal->pwzScriptPath);
+
+    if (cbCopied != header.qwSize)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        ExitOnFailure(hr, "file changed while it was copied to the rollback journal: %ls", wzFile);
+    }
+
+    WcaCaScriptFlush(hJournal);
+    fJournalComplete = TRUE;
+
+    WcaLog(LOGMSG_VERBOSE, "Journaled %I64u bytes of file: %ls to: %ls", header.qwSize, wzFile, hJournal->pwzScriptPath);
+
+LExit:
+    // A partial journal must never be restored.
+    WcaCaScriptClose(hJournal, fJournalComplete ? WCA_CASCRIPT_CLOSE_PRESERVE : WCA_CASCRIPT_CLOSE_DELETE);
+    ReleaseFile(hFile);
+
+    return hr;
+}
+
+
+/********************************************************************
+ XmlJournalRestoreFile - puts the file back the way it was journaled
+                         and deletes the journal.
+
+ NOTE: If there is no journal the file was never changed, so there is
+       nothing to restore.
+********************************************************************/
+HRESULT XmlJournalRestoreFile(
+    __in_z LPCWSTR wzJournalKey,
+    __in_z LPCWSTR wzFile
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+    WCA_CASCRIPT_HANDLE hJournal = NULL;
+    HANDLE hJournalRead = INVALID_HANDLE_VALUE;
+    HANDLE hTempFile = INVALID_HANDLE_VALUE;
+    LPWSTR sczTempFile = NULL;
+    LONGLONG llJournalSize = 0;
+    XML_JOURNAL_HEADER header = { };
+    DWORD cbRead = 0;
+    DWORD64 cbCopied = 0;
+    BYTE rgbHash[SHA1_HASH_LEN] = { };
+
+    // Opening the journal for append creates an empty one if the file was never journaled,
+    // which avoids logging a failure for a file that simply wasn't reached.
+    hr = OpenJournal(wzJournalKey, TRUE, &hJournal);
+    ExitOnFailure(hr, "failed to open rollback journal: %ls", wzJournalKey);
+
+    hr = FileSizeByHandle(hJournal->hScriptFile, &llJournalSize);
+    ExitOnFailure(hr, "failed to get size of rollback journal: %ls", hJournal->pwzScriptPath);
+
+    if (0 == llJournalSize)
+    {
+        WcaLog(LOGMSG_VERBOSE, "No rollback journal for file: %ls, nothing to restore.", wzFile);
+        ExitFunction();
+    }
+
+    hJournalRead = ::CreateFileW(hJournal->pwzScriptPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    ExitOnInvalidHandleWithLastError(hJournalRead, hr, "failed to open rollback journal: %ls", hJournal->pwzScriptPath);
+
+    if (!::ReadFile(hJournalRead, &header, sizeof(header), &cbRead, NULL))
+    {
+        ExitWithLastError(hr, "failed to read rollback journal header: %ls", hJournal->pwzScriptPath);
+    }
+
+    if (sizeof(header) != cbRead || XML_JOURNAL_MAGIC != header.dwMagic || XML_JOURNAL_VERSION != header.dwVersion ||
+        static_cast<DWORD64>(llJournalSize) - sizeof(header) != header.qwSize)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        ExitOnFailure(hr, "invalid rollback journal: %ls", hJournal->pwzScriptPath);
+    }
+
+    // Rebuild the file next to the original so it can be swapped in place in one step.
+    hr = StrAllocFormatted(&sczTempFile, L"%ls.rollback", wzFile);
+    ExitOnFailure(hr, "failed to allocate path to temporary file");
+
+    hTempFile = ::CreateFileW(sczTempFile, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    ExitOnInvalidHandleWithLastError(hTempFile, hr, "failed to create temporary file: %ls", sczTempFile);
+
+    hr = FileCopyUsingHandles(hJournalRead, hTempFile, header.qwSize, &cbCopied);
+    ExitOnFailure(hr, "failed to copy rollback journal: %ls to temporary file: %ls", hJournal->pwzScriptPath, sczTempFile);
+
+    hr = FileSetPointer(hTempFile, 0, NULL, FILE_BEGIN);
+    ExitOnFailure(hr, "failed to seek to beginning of temporary file: %ls", sczTempFile);
+
+    hr = CrypHashFileHandle(hTempFile, PROV_RSA_FULL, CALG_SHA1, rgbHash, sizeof(rgbHash), NULL);
+    ExitOnFailure(hr, "failed to hash temporary file: %ls", sczTempFile);
+
+    if (cbCopied != header.qwSize || 0 != memcmp(rgbHash, header.rgbHash, sizeof(rgbHash)))
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_CRC);
+        ExitOnFailure(hr, "rollback journal is corrupt: %ls", hJournal->pwzScriptPath);
+    }
+
+    if (!::FlushFileBuffers(hTempFile))
+    {
+        ExitWithLastError(hr, "failed to flush temporary file: %ls", sczTempFile);
+    }
+
+    ReleaseFile(hTempFile);
+
+    if (!::ReplaceFileW(wzFile, sczTempFile, NULL, REPLACEFILE_IGNORE_MERGE_ERRORS, NULL, NULL))
+    {
+        er = ::GetLastError();
+        if (ERROR_FILE_NOT_FOUND != er)
+        {
+            ExitOnWin32Error(er, hr, "failed to replace file: %ls", wzFile);
+        }
+
+        // The file is gone, so there's nothing to swap with.
+        if (!::MoveFileExW(sczTempFile, wzFile, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        {
+            ExitWithLastError(hr, "failed to move temporary file: %ls to: %ls", sczTempFile, wzFile);
+        }
+    }
+
+    hr = FileSetTime(wzFile, &header.ftCreation, &header.ftLastAccess, &header.ftLastWrite);
+    ExitOnFailure(hr, "failed to restore times of file: %ls", wzFile);
+
+    WcaLog(LOGMSG_VERBOSE, "Restored %I64u bytes of file: %ls from: %ls", header.qwSize, wzFile, hJournal->pwzScriptPath);
+
+LExit:
+    ReleaseFile(hTempFile);
+    ReleaseFile(hJournalRead);
+
+    if (sczTempFile && FAILED(hr))
+    {
+        ::DeleteFileW(sczTempFile);
+    }
+
+    // Keep the journal if it couldn't be restored so the file can still be recovered by hand.
+    WcaCaScriptClose(hJournal, SUCCEEDED(hr) ? WCA_CASCRIPT_CLOSE_DELETE : WCA_CASCRIPT_CLOSE_PRESERVE);
+    ReleaseStr(sczTempFile);
+
+    return hr;
+}
+
+
+/********************************************************************
+ XmlJournalDelete - best effort removal of a rollback journal that is
+                    no longer needed.
+
+********************************************************************/
+void XmlJournalDelete(
+    __in_z LPCWSTR wzJournalKey
+    )
+{
+    HRESULT hr = S_OK;
+    WCA_CASCRIPT_HANDLE hJournal = NULL;
+
+    // Open for append so a file that was never journaled doesn't log a failure.
+    hr = OpenJournal(wzJournalKey, TRUE, &hJournal);
+    if (SUCCEEDED(hr))
+    {
+        WcaCaScriptClose(hJournal, WCA_CASCRIPT_CLOSE_DELETE);
+    }
+    else
+    {
+        WcaLog(LOGMSG_VERBOSE, "Failed to clean up rollback journal: %ls, hr: 0x%x", wzJournalKey, hr);
+    }
+}
+
+
+/********************************************************************
+ OpenJournal - creates or opens the journal where the deferred action
+               running it can write.
+
+ NOTE: the exec, rollback and commit actions all run with the same
+       token, so they all pick the same location.
+********************************************************************/
+static HRESULT OpenJournal(
+    __in_z LPCWSTR wzJournalKey,
+    __in BOOL fAppend,
+    __out WCA_CASCRIPT_HANDLE* phJournal
+    )
+{
+    HRESULT hr = S_OK;
+    BOOL fElevated = FALSE;
+
+    // Only an elevated action can write to %WINDIR%\Installer. A per-user install runs
+    // its deferred actions with the user's own token, so its journals go to %TEMP%.
+    hr = ProcElevated(::GetCurrentProcess(), &fElevated);
+    ExitOnFailure(hr, "failed to check whether the custom action is elevated");
+
+    hr = WcaCaScriptCreate(WCA_ACTION_INSTALL, WCA_CASCRIPT_ROLLBACK, !fElevated, wzJournalKey, fAppend, phJournal);
+
+LExit:
+    return hr;
+}
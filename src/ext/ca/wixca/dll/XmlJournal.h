@@ -0,0 +1,19 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+HRESULT XmlJournalCreateKey(
+    __in DWORD iFile,
+    __deref_out_z LPWSTR* psczJournalKey
+    );
+HRESULT XmlJournalBackupFile(
+    __in_z LPCWSTR wzJournalKey,
+    __in_z LPCWSTR wzFile
+    );
+HRESULT XmlJournalRestoreFile(
+    __in_z LPCWSTR wzJournalKey,
+    __in_z LPCWSTR wzFile
+    );
+void XmlJournalDelete(
+    __in_z LPCWSTR wzJournalKey
+    );
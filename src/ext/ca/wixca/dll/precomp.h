@@ -20,6 +20,7 @@
 #include "wcautil.h"
 #include "wcawow64.h"
 #include "aclutil.h"
+#include "cryputil.h"
 #include "dirutil.h"
 #include "fileutil.h"
 #include "memutil.h"
@@ -30,11 +31,13 @@
 #include "sczutil.h"
 #include "rmutil.h"
 #include "xmlutil.h"
+#include "dictutil.h"
 #include "wiutil.h"
 #include "osutil.h"
 #include "shelutil.h"
 
 #include "CustomMsiErrors.h"
 #include "cost.h"
+#include "XmlJournal.h"
 
 #include "caSuffix.h"
@@ -16,6 +16,17 @@ enum eQUERY_SECURESERVICEINSTALL { QSSI_NAME = 1 };
 
 enum eOBJECTTYPE { OT_UNKNOWN, OT_SERVICE, OT_FOLDER, OT_FILE, OT_REGISTRY };
 
+// every permission row for one object, so its DACL is only read and written once
+struct SECURE_OBJECT
+{
+    LPWSTR sczKey;          // table and target path
+    LPWSTR sczTargetPath;
+    LPWSTR sczTable;
+
+    DWORD cEntries;
+    LPWSTR sczEntries;      // CustomActionData for each permission, domain and user
+};
+
 static eOBJECTTYPE EObjectTypeFromString(
     __in LPCWSTR pwzTable
     )
@@ -306,6 +317,87 @@ LExit:
     return hr;
 }
 
+static HRESULT GetSecureObjectSid(
+    __in LPCWSTR pwzDomain,
+    __in LPCWSTR pwzUser,
+    __out PSID* ppsid
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR pwzAccount = NULL;
+
+    // figure out the right user to put into the access block
+    if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Everyone"))
+    {
+        hr = AclGetWellKnownSid(WinWorldSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Administrators"))
+    {
+        hr = AclGetWellKnownSid(WinBuiltinAdministratorsSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"LocalSystem"))
+    {
+        hr = AclGetWellKnownSid(WinLocalSystemSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"LocalService"))
+    {
+        hr = AclGetWellKnownSid(WinLocalServiceSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"NetworkService"))
+    {
+        hr = AclGetWellKnownSid(WinNetworkServiceSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"AuthenticatedUser"))
+    {
+        hr = AclGetWellKnownSid(WinAuthenticatedUserSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Guests"))
+    {
+        hr = AclGetWellKnownSid(WinBuiltinGuestsSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"CREATOR OWNER"))
+    {
+        hr = AclGetWellKnownSid(WinCreatorOwnerSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"INTERACTIVE"))
+    {
+        hr = AclGetWellKnownSid(WinInteractiveSid, ppsid);
+    }
+    else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Users"))
+    {
+        hr = AclGetWellKnownSid(WinBuiltinUsersSid, ppsid);
+    }
+    else
+    {
+        hr = StrAllocFormatted(&pwzAccount, L"%s%s%s", pwzDomain, *pwzDomain ? L"\\" : L"", pwzUser);
+        ExitOnFailure(hr, "failed to build domain user name");
+
+        hr = AclGetAccountSid(NULL, pwzAccount, ppsid);
+    }
+    ExitOnFailure(hr, "failed to get sid for account: %ls%ls%ls", pwzDomain, *pwzDomain ? L"\\" : L"", pwzUser);
+
+LExit:
+    ReleaseStr(pwzAccount);
+
+    return hr;
+}
+
+static void FreeSecureObjects(
+    __in_ecount_opt(cObjects) SECURE_OBJECT* rgObjects,
+    __in DWORD cObjects
+    )
+{
+    for (DWORD i = 0; i < cObjects; ++i)
+    {
+        ReleaseStr(rgObjects[i].sczKey);
+        ReleaseStr(rgObjects[i].sczTargetPath);
+        ReleaseStr(rgObjects[i].sczTable);
+        ReleaseStr(rgObjects[i].sczEntries);
+    }
+
+    ReleaseMem(rgObjects);
+}
+
 /******************************************************************
  SchedSecureObjects - entry point for SchedSecureObjects Custom Action
 
@@ -324,6 +416,7 @@ extern "C" UINT __stdcall SchedSecureObjects(
     LPWSTR pwzData = NULL;
     LPWSTR pwzTable = NULL;
     LPWSTR pwzTargetPath = NULL;
+    LPWSTR pwzKey = NULL;
 
     PMSIHANDLE hView = NULL;
     PMSIHANDLE hRec = NULL;
@@ -333,7 +426,10 @@ extern "C" UINT __stdcall SchedSecureObjects(
 
     LPWSTR pwzCustomActionData = NULL;
 
+    SECURE_OBJECT* rgObjects = NULL;
+    SECURE_OBJECT* pObject = NULL;
     DWORD cObjects = 0;
+    STRINGDICT_HANDLE sdhObjects = NULL;
     eOBJECTTYPE eType = OT_UNKNOWN;
 
     //
@@ -349,6 +445,9 @@ extern "C" UINT __stdcall SchedSecureObjects(
         ExitFunction();
     }
 
+    hr = DictCreateWithEmbeddedKey(&sdhObjects, 0, reinterpret_cast<void**>(&rgObjects), offsetof(SECURE_OBJECT, sczKey), DICT_FLAG_CASEINSENSITIVE);
+    ExitOnFailure(hr, "failed to create dictionary of objects to secure");
+
     //
     // loop through all the objects to be secured
     //
@@ -403,32 +502,50 @@ extern "C" UINT __stdcall SchedSecureObjects(
 
         if (WcaIsInstalling(isInstalled, isAction))
         {
-            hr = WcaWriteStringToCaData(pwzTargetPath, &pwzCustomActionData);
-            ExitOnFailure(hr, "failed to add data to CustomActionData");
+            // group the permissions by object so each object is only secured once
+            hr = StrAllocFormatted(&pwzKey, L"%ls\t%ls", pwzTable, pwzTargetPath);
+            ExitOnFailure(hr, "failed to build key for object: %ls", pwzTargetPath);
+
+            hr = DictGetValue(sdhObjects, pwzKey, reinterpret_cast<void**>(&pObject));
+            if (E_NOTFOUND == hr)
+            {
+                hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&rgObjects), cObjects + 1, sizeof(SECURE_OBJECT), 10);
+                ExitOnFailure(hr, "failed to grow array of objects to secure");
+
+                pObject = rgObjects + cObjects;
+                ++cObjects;
+
+                pObject->sczKey = pwzKey;
+                pwzKey = NULL;
 
-            // add the data to the CustomActionData
-            hr = WcaGetRecordString(hRec, QSO_SECUREOBJECT, &pwzData);
-            ExitOnFailure(hr, "failed to get name of object");
+                hr = StrAllocString(&pObject->sczTargetPath, pwzTargetPath, 0);
+                ExitOnFailure(hr, "failed to copy target path of object: %ls", pwzTargetPath);
 
-            hr = WcaWriteStringToCaData(pwzTable, &pwzCustomActionData);
+                hr = StrAllocString(&pObject->sczTable, pwzTable, 0);
+                ExitOnFailure(hr, "failed to copy table of object: %ls", pwzTargetPath);
+
+                hr = DictAddValue(sdhObjects, pObject);
+            }
+            ExitOnFailure(hr, "failed to find object to secure: %ls", pwzTargetPath);
+
+            // add the data to the object's entries, permission first since the
+            // domain is often blank and a blank first field would lose its delimiter
+            hr = WcaGetRecordString(hRec, QSO_PERMISSION, &pwzData);
+            ExitOnFailure(hr, "failed to get permission to configure object");
+            hr = WcaWriteStringToCaData(pwzData, &pObject->sczEntries);
             ExitOnFailure(hr, "failed to add data to CustomActionData");
 
             hr = WcaGetRecordFormattedString(hRec, QSO_DOMAIN, &pwzData);
             ExitOnFailure(hr, "failed to get domain for user to configure object");
-            hr = WcaWriteStringToCaData(pwzData, &pwzCustomActionData);
+            hr = WcaWriteStringToCaData(pwzData, &pObject->sczEntries);
             ExitOnFailure(hr, "failed to add data to CustomActionData");
 
             hr = WcaGetRecordFormattedString(hRec, QSO_USER, &pwzData);
             ExitOnFailure(hr, "failed to get user to configure object");
-            hr = WcaWriteStringToCaData(pwzData, &pwzCustomActionData);
-            ExitOnFailure(hr, "failed to add data to CustomActionData");
-
-            hr = WcaGetRecordString(hRec, QSO_PERMISSION, &pwzData);
-            ExitOnFailure(hr, "failed to get permission to configure object");
-            hr = WcaWriteStringToCaData(pwzData, &pwzCustomActionData);
+            hr = WcaWriteStringToCaData(pwzData, &pObject->sczEntries);
             ExitOnFailure(hr, "failed to add data to CustomActionData");
 
-            ++cObjects;
+            ++pObject->cEntries;
         }
     }
 
@@ -437,6 +554,21 @@ extern "C" UINT __stdcall SchedSecureObjects(
         hr = S_OK;
     ExitOnFailure(hr, "failed while looping through all objects to secure");
 
+    for (DWORD i = 0; i < cObjects; ++i)
+    {
+        hr = WcaWriteStringToCaData(rgObjects[i].sczTargetPath, &pwzCustomActionData);
+        ExitOnFailure(hr, "failed to add data to CustomActionData");
+
+        hr = WcaWriteStringToCaData(rgObjects[i].sczTable, &pwzCustomActionData);
+        ExitOnFailure(hr, "failed to add data to CustomActionData");
+
+        hr = WcaWriteIntegerToCaData(rgObjects[i].cEntries, &pwzCustomActionData);
+        ExitOnFailure(hr, "failed to add data to CustomActionData");
+
+        hr = WcaWriteStringToCaData(rgObjects[i].sczEntries, &pwzCustomActionData);
+        ExitOnFailure(hr, "failed to add data to CustomActionData");
+    }
+
     //
     // schedule the custom action and add to progress bar
     //
@@ -449,6 +581,9 @@ extern "C" UINT __stdcall SchedSecureObjects(
     }
 
 LExit:
+    ReleaseDict(sdhObjects);
+    FreeSecureObjects(rgObjects, cObjects);
+    ReleaseStr(pwzKey);
     ReleaseStr(pwzSecureObject);
     ReleaseStr(pwzCustomActionData);
     ReleaseStr(pwzData);
@@ -479,12 +614,14 @@ extern "C" UINT __stdcall SchedSecureObjectsRollback(
     LPWSTR pwzSecureObject = NULL;
     LPWSTR pwzTable = NULL;
     LPWSTR pwzTargetPath = NULL;
+    LPWSTR pwzKey = NULL;
 
     PMSIHANDLE hView = NULL;
     PMSIHANDLE hRec = NULL;
 
     LPWSTR pwzCustomActionData = NULL;
 
+    STRINGDICT_HANDLE sdhScheduled = NULL;
     eOBJECTTYPE eType = OT_UNKNOWN;
 
     //
@@ -493,6 +630,9 @@ extern "C" UINT __stdcall SchedSecureObjectsRollback(
     hr = WcaInitialize(hInstall, "SchedSecureObjectsRollback");
     ExitOnFailure(hr, "failed to initialize");
 
+    hr = DictCreateStringList(&sdhScheduled, 0, DICT_FLAG_CASEINSENSITIVE);
+    ExitOnFailure(hr, "failed to create list of objects scheduled for rollback");
+
     //
     // loop through all the objects to be secured
     //
@@ -536,6 +676,23 @@ extern "C" UINT __stdcall SchedSecureObjectsRollback(
         hr = GetTargetPath(eType, pwzSecureObject, &pwzTargetPath);
         ExitOnFailure(hr, "failed to get target path of object '%ls' in order to schedule rollback", pwzSecureObject);
 
+        // the original DACL only needs to be captured once no matter how many permissions the object has
+        hr = StrAllocFormatted(&pwzKey, L"%ls\t%ls", pwzTable, pwzTargetPath);
+        ExitOnFailure(hr, "failed to build key for object: %ls", pwzTargetPath);
+
+        hr = DictKeyExists(sdhScheduled, pwzKey);
+        if (S_OK == hr)
+        {
+            continue;
+        }
+        else if (E_NOTFOUND != hr)
+        {
+            ExitOnFailure(hr, "failed to check whether rollback is already scheduled for object: %ls", pwzTargetPath);
+        }
+
+        hr = DictAddKey(sdhScheduled, pwzKey);
+        ExitOnFailure(hr, "failed to remember rollback is scheduled for object: %ls", pwzTargetPath);
+
         hr = StoreACLRollbackInfo(pwzTargetPath, pwzTable);
         if (FAILED(hr))
         {
@@ -551,7 +708,9 @@ extern "C" UINT __stdcall SchedSecureObjectsRollback(
     ExitOnFailure(hr, "failed while looping through all objects to schedule rollback for");
 
 LExit:
+    ReleaseDict(sdhScheduled);
     ReleaseStr(pwzCustomActionData);
+    ReleaseStr(pwzKey);
     ReleaseStr(pwzSecureObject);
     ReleaseStr(pwzTable);
     ReleaseStr(pwzTargetPath);
@@ -568,7 +727,7 @@ LExit:
                    called as Type 1025 CustomAction (deferred binary DLL)
 
  NOTE: deferred CustomAction since it modifies the machine
- NOTE: CustomActionData == wzObject\twzTable\twzDomain\twzUser\tdwPermissions\twzObject\t...
+ NOTE: CustomActionData == wzObject\twzTable\tcEntries\tdwPermissions\twzDomain\twzUser\t...\twzObject\t...
 ******************************************************************/
 extern "C" UINT __stdcall ExecSecureObjects(
     __in MSIHANDLE hInstall
@@ -586,10 +745,11 @@ extern "C" UINT __stdcall ExecSecureObjects(
     DWORD dwRevision = 0;
     LPWSTR pwzUser = NULL;
     DWORD dwPermissions = 0;
-    LPWSTR pwzAccount = NULL;
-    PSID psid = NULL;
+    int cEntries = 0;
+    DWORD cSids = 0;
 
-    EXPLICIT_ACCESSW ea = {0};
+    EXPLICIT_ACCESSW* rgEntries = NULL;
+    PSID* rgSids = NULL;
     SE_OBJECT_TYPE objectType = SE_UNKNOWN_OBJECT_TYPE;
     PSECURITY_DESCRIPTOR psd = NULL;
     SECURITY_DESCRIPTOR_CONTROL sdc = {0};
@@ -622,116 +782,92 @@ extern "C" UINT __stdcall ExecSecureObjects(
 
         hr = WcaReadStringFromCaData(&pwz, &pwzTable);
         ExitOnFailure(hr, "failed to process CustomActionData");
-        hr = WcaReadStringFromCaData(&pwz, &pwzDomain);
+        hr = WcaReadIntegerFromCaData(&pwz, &cEntries);
         ExitOnFailure(hr, "failed to process CustomActionData");
-        hr = WcaReadStringFromCaData(&pwz, &pwzUser);
-        ExitOnFailure(hr, "failed to process CustomActionData");
-        hr = WcaReadIntegerFromCaData(&pwz, reinterpret_cast<int*>(&dwPermissions));
-        ExitOnFailure(hr, "failed to processCustomActionData");
-
-        WcaLog(LOGMSG_VERBOSE, "Securing Object: %ls Type: %ls User: %ls", pwzObject, pwzTable, pwzUser);
-
-        //
-        // create the appropriate SID
-        //
 
-        // figure out the right user to put into the access block
-        if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Everyone"))
-        {
-            hr = AclGetWellKnownSid(WinWorldSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Administrators"))
-        {
-            hr = AclGetWellKnownSid(WinBuiltinAdministratorsSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"LocalSystem"))
-        {
-            hr = AclGetWellKnownSid(WinLocalSystemSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"LocalService"))
-        {
-            hr = AclGetWellKnownSid(WinLocalServiceSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"NetworkService"))
-        {
-            hr = AclGetWellKnownSid(WinNetworkServiceSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"AuthenticatedUser"))
-        {
-            hr = AclGetWellKnownSid(WinAuthenticatedUserSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Guests"))
-        {
-            hr = AclGetWellKnownSid(WinBuiltinGuestsSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"CREATOR OWNER"))
-        {
-            hr = AclGetWellKnownSid(WinCreatorOwnerSid, &psid);
-        }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"INTERACTIVE"))
+        objectType = SEObjectTypeFromString(const_cast<LPCWSTR> (pwzTable));
+        if (SE_UNKNOWN_OBJECT_TYPE == objectType)
         {
-            hr = AclGetWellKnownSid(WinInteractiveSid, &psid);
+            MessageExitOnFailure(hr = E_UNEXPECTED, msierrSecureObjectsUnknownType, "unknown object type: %ls", pwzTable);
         }
-        else if (!*pwzDomain && 0 == lstrcmpW(pwzUser, L"Users"))
+        else if (0 >= cEntries)
         {
-            hr = AclGetWellKnownSid(WinBuiltinUsersSid, &psid);
+            ExitOnFailure(hr = E_INVALIDARG, "no permissions to set for object: %ls", pwzObject);
         }
-        else
-        {
-            hr = StrAllocFormatted(&pwzAccount, L"%s%s%s", pwzDomain, *pwzDomain ? L"\\" : L"", pwzUser);
-            ExitOnFailure(hr, "failed to build domain user name");
 
-            hr = AclGetAccountSid(NULL, pwzAccount, &psid);
-        }
-        ExitOnFailure(hr, "failed to get sid for account: %ls%ls%ls", pwzDomain, *pwzDomain ? L"\\" : L"", pwzUser);
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&rgEntries), cEntries, sizeof(EXPLICIT_ACCESSW), 0);
+        ExitOnFailure(hr, "failed to allocate explicit access entries for object: %ls", pwzObject);
+
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&rgSids), cEntries, sizeof(PSID), 0);
+        ExitOnFailure(hr, "failed to allocate sids for object: %ls", pwzObject);
 
         //
-        // build up the explicit access
+        // build up the explicit access for every user, so the DACL is only rewritten (and
+        // inheritance only propagated through a folder's children) once per object
         //
-        ea.grfAccessMode = SET_ACCESS;
-
-        if (0 == lstrcmpW(L"CreateFolder", pwzTable))
+        for (int i = 0; i < cEntries; ++i)
         {
-            ea.grfInheritance = SUB_CONTAINERS_AND_OBJECTS_INHERIT;
-        }
-        else
-        {
-            ea.grfInheritance = NO_INHERITANCE;
-        }
+            hr = WcaReadIntegerFromCaData(&pwz, reinterpret_cast<int*>(&dwPermissions));
+            ExitOnFailure(hr, "failed to processCustomActionData");
+            hr = WcaReadStringFromCaData(&pwz, &pwzDomain);
+            ExitOnFailure(hr, "failed to process CustomActionData");
+            hr = WcaReadStringFromCaData(&pwz, &pwzUser);
+            ExitOnFailure(hr, "failed to process CustomActionData");
 
-#pragma prefast(push)
-#pragma prefast(disable:25029)
-        ::BuildTrusteeWithSidW(&ea.Trustee, psid);
-#pragma prefast(pop)
+            WcaLog(LOGMSG_VERBOSE, "Securing Object: %ls Type: %ls User: %ls", pwzObject, pwzTable, pwzUser);
 
-        objectType = SEObjectTypeFromString(const_cast<LPCWSTR> (pwzTable));
+            hr = GetSecureObjectSid(pwzDomain, pwzUser, &rgSids[cSids]);
+            ExitOnFailure(hr, "failed to get sid for object: %ls", pwzObject);
 
-        // always add these permissions for services
-        // these are basic permissions that are often forgotten
-        if (0 == lstrcmpW(L"ServiceInstall", pwzTable))
-        {
-            dwPermissions |= SERVICE_QUERY_CONFIG | SERVICE_QUERY_STATUS | SERVICE_ENUMERATE_DEPENDENTS | SERVICE_INTERROGATE;
-        }
+            ++cSids;
 
-        ea.grfAccessPermissions = dwPermissions;
+            EXPLICIT_ACCESSW* pea = rgEntries + i;
+            memset(pea, 0, sizeof(EXPLICIT_ACCESSW));
 
-        if (SE_UNKNOWN_OBJECT_TYPE != objectType)
-        {
-            er = ::GetNamedSecurityInfoW(pwzObject, objectType, DACL_SECURITY_INFORMATION, NULL, NULL, &pAclExisting, NULL, &psd);
-            ExitOnFailure(hr = HRESULT_FROM_WIN32(er), "failed to get security info for object: %ls", pwzObject);
+            pea->grfAccessMode = SET_ACCESS;
 
-            //Need to see if DACL is protected so getting Descriptor information
-            if (!::GetSecurityDescriptorControl(psd, &sdc, &dwRevision))
+            if (0 == lstrcmpW(L"CreateFolder", pwzTable))
             {
-                ExitOnLastError(hr, "failed to get security descriptor control for object: %ls", pwzObject);
+                pea->grfInheritance = SUB_CONTAINERS_AND_OBJECTS_INHERIT;
+            }
+            else
+            {
+                pea->grfInheritance = NO_INHERITANCE;
             }
 
 #pragma prefast(push)
 #pragma prefast(disable:25029)
-            er = ::SetEntriesInAclW(1, &ea, pAclExisting, &pAclNew);
+            ::BuildTrusteeWithSidW(&pea->Trustee, rgSids[i]);
 #pragma prefast(pop)
-            ExitOnFailure(hr = HRESULT_FROM_WIN32(er), "failed to add ACLs for object: %ls", pwzObject);
 
+            // always add these permissions for services
+            // these are basic permissions that are often forgotten
+            if (0 == lstrcmpW(L"ServiceInstall", pwzTable))
+            {
+                dwPermissions |= SERVICE_QUERY_CONFIG | SERVICE_QUERY_STATUS | SERVICE_ENUMERATE_DEPENDENTS | SERVICE_INTERROGATE;
+            }
+
+            pea->grfAccessPermissions = dwPermissions;
+        }
+
+        er = ::GetNamedSecurityInfoW(pwzObject, objectType, DACL_SECURITY_INFORMATION, NULL, NULL, &pAclExisting, NULL, &psd);
+        ExitOnFailure(hr = HRESULT_FROM_WIN32(er), "failed to get security info for object: %ls", pwzObject);
+
+        //Need to see if DACL is protected so getting Descriptor information
+        if (!::GetSecurityDescriptorControl(psd, &sdc, &dwRevision))
+        {
+            ExitOnLastError(hr, "failed to get security descriptor control for object: %ls", pwzObject);
+        }
+
+        hr = AclMergeExplicitAccess(pAclExisting, rgEntries, cEntries, &pAclNew);
+        ExitOnFailure(hr, "failed to add ACLs for object: %ls", pwzObject);
+
+        if (S_FALSE == hr)
+        {
+            WcaLog(LOGMSG_VERBOSE, "Object: %ls already has the requested permissions, skipping", pwzObject);
+        }
+        else
+        {
             if (sdc & SE_DACL_PROTECTED)
             {
                 si = DACL_SECURITY_INFORMATION | PROTECTED_DACL_SECURITY_INFORMATION;
@@ -743,14 +879,22 @@ extern "C" UINT __stdcall ExecSecureObjects(
             er = ::SetNamedSecurityInfoW(pwzObject, objectType, si, NULL, NULL, pAclNew, NULL);
             MessageExitOnFailure(hr = HRESULT_FROM_WIN32(er), msierrSecureObjectsFailedSet, "failed to set security info for object: %ls", pwzObject);
         }
-        else
-        {
-            MessageExitOnFailure(hr = E_UNEXPECTED, msierrSecureObjectsUnknownType, "unknown object type: %ls", pwzTable);
-        }
 
         hr = WcaProgressMessage(COST_SECUREOBJECT, FALSE);
         ExitOnFailure(hr, "failed to send progress message");
 
+        AclFreeDacl(pAclNew);
+        pAclNew = NULL;
+
+        ::LocalFree(psd);
+        psd = NULL;
+
+        for (DWORD i = 0; i < cSids; ++i)
+        {
+            AclFreeSid(rgSids[i]);
+        }
+        cSids = 0;
+
         objectType = SE_UNKNOWN_OBJECT_TYPE;
     }
 
@@ -760,20 +904,21 @@ LExit:
     ReleaseStr(pwzTable);
     ReleaseStr(pwzObject);
     ReleaseStr(pwzData);
-    ReleaseStr(pwzAccount);
 
     if (pAclNew)
     {
-        ::LocalFree(pAclNew);
+        AclFreeDacl(pAclNew);
     }
     if (psd)
     {
         ::LocalFree(psd);
     }
-    if (psid)
+    for (DWORD i = 0; i < cSids; ++i)
     {
-        AclFreeSid(psid);
+        AclFreeSid(rgSids[i]);
     }
+    ReleaseMem(rgSids);
+    ReleaseMem(rgEntries);
 
     if (FAILED(hr))
     {
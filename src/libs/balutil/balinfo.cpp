@@ -3,49 +3,35 @@
 #include "precomp.h"
 
 // prototypes
-static HRESULT ParsePackagesFromXml(
+static HRESULT ParseBundleDataFromXml(
+    __in BAL_INFO_BUNDLE* pBundle,
+    __in XML_READER* pReader
+    );
+static HRESULT ParseBundlePropertiesFromXml(
+    __in BAL_INFO_BUNDLE* pBundle,
+    __in XML_READER* pReader
+    );
+static HRESULT ParsePackageFromXml(
     __in BAL_INFO_PACKAGES* pPackages,
-    __in IXMLDOMDocument* pixdManifest
+    __in XML_READER* pReader
     );
 
 
-DAPI_(HRESULT) BalInfoParseFromXml(
+DAPI_(HRESULT) BalInfoParseFromFile(
     __in BAL_INFO_BUNDLE* pBundle,
-    __in IXMLDOMDocument* pixdManifest
+    __in_z LPCWSTR wzPath
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNode* pNode = NULL;
-
-    hr = XmlSelectSingleNode(pixdManifest, L"/BootstrapperApplicationData/WixBundleProperties", &pNode);
-    ExitOnFailure(hr, "Failed to select bundle information.");
-
-    if (S_OK == hr)
-    {
-        hr = XmlGetYesNoAttribute(pNode, L"PerMachine", &pBundle->fPerMachine);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to read bundle information per-machine.");
-        }
+    XML_READER reader = { };
 
-        hr = XmlGetAttributeEx(pNode, L"DisplayName", &pBundle->sczName);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to read bundle information display name.");
-        }
-
-        hr = XmlGetAttributeEx(pNode, L"LogPathVariable", &pBundle->sczLogVariable);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to read bundle information log path variable.");
-        }
-    }
+    hr = XmlReaderInitializeFromFile(wzPath, &reader);
+    ExitOnFailure(hr, "Failed to load bootstrapper application data from path: %ls", wzPath);
 
-    hr = ParsePackagesFromXml(&pBundle->packages, pixdManifest);
-    BalExitOnFailure(hr, "Failed to parse package information from bootstrapper application data.");
+    hr = ParseBundleDataFromXml(pBundle, &reader);
 
 LExit:
-    ReleaseObject(pNode);
+    XmlReaderUninitialize(&reader);
 
     return hr;
 }
@@ -153,136 +139,185 @@ DAPI_(void) BalInfoUninitialize(
 }
 
 
-static HRESULT ParsePackagesFromXml(
-    __in BAL_INFO_PACKAGES* pPackages,
-    __in IXMLDOMDocument* pixdManifest
+static HRESULT ParseBundleDataFromXml(
+    __in BAL_INFO_BUNDLE* pBundle,
+    __in XML_READER* pReader
     )
 {
     HRESULT hr = S_OK;
-    IXMLDOMNodeList* pNodeList = NULL;
-    IXMLDOMNode* pNode = NULL;
-    BAL_INFO_PACKAGE* prgPackages = NULL;
-    DWORD cPackages = 0;
-    LPWSTR scz = NULL;
-
-    hr = XmlSelectNodes(pixdManifest, L"/BootstrapperApplicationData/WixPackageProperties", &pNodeList);
-    ExitOnFailure(hr, "Failed to select all packages.");
+    LPCWSTR wzElement = NULL;
 
-    hr = pNodeList->get_length(reinterpret_cast<long*>(&cPackages));
-    ExitOnFailure(hr, "Failed to get the package count.");
+    hr = XmlReaderNextElement(pReader, 0, &wzElement);
+    ExitOnFailure(hr, "Failed to read bootstrapper application data element.");
 
-    prgPackages = static_cast<BAL_INFO_PACKAGE*>(MemAlloc(sizeof(BAL_INFO_PACKAGE) * cPackages, TRUE));
-    ExitOnNull(prgPackages, hr, E_OUTOFMEMORY, "Failed to allocate memory for packages.");
-
-    DWORD iPackage = 0;
-    while (S_OK == (hr = XmlNextElement(pNodeList, &pNode, NULL)))
+    if (S_FALSE == hr || CSTR_EQUAL != ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"BootstrapperApplicationData", -1))
     {
-        hr = XmlGetAttributeEx(pNode, L"Package", &prgPackages[iPackage].sczId);
-        ExitOnFailure(hr, "Failed to get package identifier for package.");
-
-        hr = XmlGetAttributeEx(pNode, L"DisplayName", &prgPackages[iPackage].sczDisplayName);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get display name for package.");
-        }
+        hr = E_INVALIDDATA;
+        ExitOnRootFailure(hr, "Failed to find BootstrapperApplicationData element.");
+    }
 
-        hr = XmlGetAttributeEx(pNode, L"Description", &prgPackages[iPackage].sczDescription);
-        if (E_NOTFOUND != hr)
+    for (;;)
+    {
+        hr = XmlReaderNextElement(pReader, 1, &wzElement);
+        if (S_FALSE == hr)
         {
-            ExitOnFailure(hr, "Failed to get description for package.");
+            break;
         }
+        ExitOnFailure(hr, "Failed to read next bootstrapper application data element.");
 
-        hr = XmlGetAttributeEx(pNode, L"PackageType", &scz);
-        ExitOnFailure(hr, "Failed to get package type for package.");
-
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Exe", -1, scz, -1))
-        {
-            prgPackages[iPackage].type = BAL_INFO_PACKAGE_TYPE_EXE;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Msi", -1, scz, -1))
+        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"WixBundleProperties", -1))
         {
-            prgPackages[iPackage].type = BAL_INFO_PACKAGE_TYPE_MSI;
+            hr = ParseBundlePropertiesFromXml(pBundle, pReader);
+            BalExitOnFailure(hr, "Failed to parse bundle information from bootstrapper application data.");
         }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Msp", -1, scz, -1))
+        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzElement, -1, L"WixPackageProperties", -1))
         {
-            prgPackages[iPackage].type = BAL_INFO_PACKAGE_TYPE_MSP;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Msu", -1, scz, -1))
-        {
-            prgPackages[iPackage].type = BAL_INFO_PACKAGE_TYPE_MSU;
+            hr = ParsePackageFromXml(&pBundle->packages, pReader);
+            BalExitOnFailure(hr, "Failed to parse package information from bootstrapper application data.");
         }
+    }
 
-        hr = XmlGetYesNoAttribute(pNode, L"Permanent", &prgPackages[iPackage].fPermanent);
-        ExitOnFailure(hr, "Failed to get permanent setting for package.");
+    hr = S_OK;
 
-        hr = XmlGetYesNoAttribute(pNode, L"Vital", &prgPackages[iPackage].fVital);
-        ExitOnFailure(hr, "Failed to get vital setting for package.");
+LExit:
+    return hr;
+}
 
-        hr = XmlGetYesNoAttribute(pNode, L"DisplayInternalUI", &prgPackages[iPackage].fDisplayInternalUI);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get DisplayInternalUI setting for package.");
-        }
 
-        hr = XmlGetAttributeEx(pNode, L"ProductCode", &prgPackages[iPackage].sczProductCode);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get product code for package.");
-        }
+static HRESULT ParseBundlePropertiesFromXml(
+    __in BAL_INFO_BUNDLE* pBundle,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
 
-        hr = XmlGetAttributeEx(pNode, L"UpgradeCode", &prgPackages[iPackage].sczUpgradeCode);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get upgrade code for package.");
-        }
+    hr = XmlReaderGetYesNoAttribute(pReader, L"PerMachine", &pBundle->fPerMachine);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to read bundle information per-machine.");
+    }
 
-        hr = XmlGetAttributeEx(pNode, L"Version", &prgPackages[iPackage].sczVersion);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get version for package.");
-        }
+    hr = XmlReaderGetAttribute(pReader, L"DisplayName", &pBundle->sczName);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to read bundle information display name.");
+    }
 
-        hr = XmlGetAttributeEx(pNode, L"InstallCondition", &prgPackages[iPackage].sczInstallCondition);
-        if (E_NOTFOUND != hr)
-        {
-            ExitOnFailure(hr, "Failed to get install condition for package.");
-        }
+    hr = XmlReaderGetAttribute(pReader, L"LogPathVariable", &pBundle->sczLogVariable);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to read bundle information log path variable.");
+    }
 
-        hr = XmlGetAttributeEx(pNode, L"Cache", &scz);
-        ExitOnFailure(hr, "Failed to get cache type for package.");
+    hr = S_OK;
 
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, scz, -1, L"no", -1))
-        {
-            prgPackages[iPackage].cacheType = BAL_INFO_CACHE_TYPE_NO;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, scz, -1, L"yes", -1))
-        {
-            prgPackages[iPackage].cacheType = BAL_INFO_CACHE_TYPE_YES;
-        }
-        else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, scz, -1, L"always", -1))
-        {
-            prgPackages[iPackage].cacheType = BAL_INFO_CACHE_TYPE_ALWAYS;
-        }
+LExit:
+    return hr;
+}
+
+
+static HRESULT ParsePackageFromXml(
+    __in BAL_INFO_PACKAGES* pPackages,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    BAL_INFO_PACKAGE* pPackage = NULL;
+    LPCWSTR wz = NULL;
 
-        ++iPackage;
-        ReleaseNullObject(pNode);
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pPackages->rgPackages), pPackages->cPackages + 1, sizeof(BAL_INFO_PACKAGE), pPackages->cPackages);
+    ExitOnFailure(hr, "Failed to allocate memory for packages.");
+
+    pPackage = pPackages->rgPackages + pPackages->cPackages;
+    ++pPackages->cPackages;
+
+    hr = XmlReaderGetAttribute(pReader, L"Package", &pPackage->sczId);
+    ExitOnFailure(hr, "Failed to get package identifier for package.");
+
+    hr = XmlReaderGetAttribute(pReader, L"DisplayName", &pPackage->sczDisplayName);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get display name for package.");
     }
-    ExitOnFailure(hr, "Failed to parse all package property elements.");
 
-    if (S_FALSE == hr)
+    hr = XmlReaderGetAttribute(pReader, L"Description", &pPackage->sczDescription);
+    if (E_NOTFOUND != hr)
     {
-        hr = S_OK;
+        ExitOnFailure(hr, "Failed to get description for package.");
     }
 
-    pPackages->cPackages = cPackages;
-    pPackages->rgPackages = prgPackages;
-    prgPackages = NULL;
+    hr = XmlReaderGetAttributeValue(pReader, L"PackageType", &wz);
+    ExitOnFailure(hr, "Failed to get package type for package.");
 
-LExit:
-    ReleaseStr(scz);
-    ReleaseMem(prgPackages);
-    ReleaseObject(pNode);
-    ReleaseObject(pNodeList);
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Exe", -1, wz, -1))
+    {
+        pPackage->type = BAL_INFO_PACKAGE_TYPE_EXE;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Msi", -1, wz, -1))
+    {
+        pPackage->type = BAL_INFO_PACKAGE_TYPE_MSI;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Msp", -1, wz, -1))
+    {
+        pPackage->type = BAL_INFO_PACKAGE_TYPE_MSP;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, L"Msu", -1, wz, -1))
+    {
+        pPackage->type = BAL_INFO_PACKAGE_TYPE_MSU;
+    }
+
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Permanent", &pPackage->fPermanent);
+    ExitOnFailure(hr, "Failed to get permanent setting for package.");
+
+    hr = XmlReaderGetYesNoAttribute(pReader, L"Vital", &pPackage->fVital);
+    ExitOnFailure(hr, "Failed to get vital setting for package.");
+
+    hr = XmlReaderGetYesNoAttribute(pReader, L"DisplayInternalUI", &pPackage->fDisplayInternalUI);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get DisplayInternalUI setting for package.");
+    }
+
+    hr = XmlReaderGetAttribute(pReader, L"ProductCode", &pPackage->sczProductCode);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get product code for package.");
+    }
 
+    hr = XmlReaderGetAttribute(pReader, L"UpgradeCode", &pPackage->sczUpgradeCode);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get upgrade code for package.");
+    }
+
+    hr = XmlReaderGetAttribute(pReader, L"Version", &pPackage->sczVersion);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get version for package.");
+    }
+
+    hr = XmlReaderGetAttribute(pReader, L"InstallCondition", &pPackage->sczInstallCondition);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to get install condition for package.");
+    }
+
+    hr = XmlReaderGetAttributeValue(pReader, L"Cache", &wz);
+    ExitOnFailure(hr, "Failed to get cache type for package.");
+
+    if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, wz, -1, L"no", -1))
+    {
+        pPackage->cacheType = BAL_INFO_CACHE_TYPE_NO;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, wz, -1, L"yes", -1))
+    {
+        pPackage->cacheType = BAL_INFO_CACHE_TYPE_YES;
+    }
+    else if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, wz, -1, L"always", -1))
+    {
+        pPackage->cacheType = BAL_INFO_CACHE_TYPE_ALWAYS;
+    }
+
+LExit:
     return hr;
 }
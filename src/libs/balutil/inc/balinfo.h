@@ -60,13 +60,13 @@ typedef struct _BAL_INFO_BUNDLE
 
 
 /*******************************************************************
- BalInfoParseFromXml - loads the bundle and package info from the UX
-                       manifest.
+ BalInfoParseFromFile - loads the bundle and package info from the UX
+                        manifest file without building a DOM.
 
 ********************************************************************/
-DAPI_(HRESULT) BalInfoParseFromXml(
+DAPI_(HRESULT) BalInfoParseFromFile(
     __in BAL_INFO_BUNDLE* pBundle,
-    __in IXMLDOMDocument* pixdManifest
+    __in_z LPCWSTR wzPath
     );
 
 
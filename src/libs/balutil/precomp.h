@@ -9,12 +9,14 @@
 #include <CommCtrl.h>
 
 #include <dutil.h>
+#include <dictutil.h>
 #include <pathutil.h>
 #include <locutil.h>
 #include <memutil.h>
 #include <strutil.h>
 #include <thmutil.h>
 #include <xmlutil.h>
+#include <xmlreaderutil.h>
 
 #include "BootstrapperEngine.h"
 #include "BootstrapperApplication.h"
@@ -527,6 +527,109 @@ extern "C" HRESULT DAPI AclMergeDacls(
 }
 
 
+/********************************************************************
+AclMergeExplicitAccess - creates a new DACL from an existing ACL plus
+                         all of the explicit access entries in one pass
+
+NOTE: entries are merged as if they were applied one at a time, so a
+      SET_ACCESS or REVOKE_ACCESS entry for a SID trustee discards any
+      earlier entries for the same SID.
+      returns S_FALSE if the new DACL is identical to pAclExisting, in
+      which case the caller can skip rewriting (and re-propagating) it.
+********************************************************************/
+extern "C" HRESULT DAPI AclMergeExplicitAccess(
+    __in_opt const ACL* pAclExisting,
+    __in_ecount(cEntries) const EXPLICIT_ACCESSW* rgEntries,
+    __in DWORD cEntries,
+    __deref_out ACL** ppAclNew
+    )
+{
+    Assert(rgEntries && 0 < cEntries && ppAclNew);
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+
+    EXPLICIT_ACCESSW* rgMerged = NULL;
+    DWORD cMerged = 0;
+    PACL pAclMerged = NULL;
+    ACL* pAclNew = NULL;
+    ACL_SIZE_INFORMATION asiExisting = { };
+    ACL_SIZE_INFORMATION asiMerged = { };
+    BOOL fSuperseded = FALSE;
+
+    rgMerged = static_cast<EXPLICIT_ACCESSW*>(MemAlloc(sizeof(EXPLICIT_ACCESSW) * cEntries, TRUE));
+    ExitOnNull(rgMerged, hr, E_OUTOFMEMORY, "failed to allocate memory for %u explicit access entries", cEntries);
+
+    // drop entries that a later entry for the same SID would have thrown away anyway
+    for (DWORD i = 0; i < cEntries; ++i)
+    {
+        fSuperseded = FALSE;
+
+        if (TRUSTEE_IS_SID == rgEntries[i].Trustee.TrusteeForm)
+        {
+            for (DWORD j = i + 1; j < cEntries && !fSuperseded; ++j)
+            {
+                fSuperseded = TRUSTEE_IS_SID == rgEntries[j].Trustee.TrusteeForm &&
+                              (SET_ACCESS == rgEntries[j].grfAccessMode || REVOKE_ACCESS == rgEntries[j].grfAccessMode) &&
+                              ::EqualSid(reinterpret_cast<PSID>(rgEntries[i].Trustee.ptstrName), reinterpret_cast<PSID>(rgEntries[j].Trustee.ptstrName));
+            }
+        }
+
+        if (!fSuperseded)
+        {
+            rgMerged[cMerged] = rgEntries[i];
+            ++cMerged;
+        }
+    }
+
+#pragma prefast(push)
+#pragma prefast(disable:25029)
+    er = ::SetEntriesInAclW(cMerged, rgMerged, const_cast<PACL>(pAclExisting), &pAclMerged);
+#pragma prefast(pop)
+    ExitOnWin32Error(er, hr, "failed to merge %u explicit access entries into ACL", cMerged);
+
+    // copy out of the LocalAlloc'd ACL so the caller can free it like any other DACL from here
+    pAclNew = static_cast<ACL*>(MemAlloc(pAclMerged->AclSize, FALSE));
+    ExitOnNull(pAclNew, hr, E_OUTOFMEMORY, "failed to allocate memory for merged ACL");
+
+    memcpy(pAclNew, pAclMerged, pAclMerged->AclSize);
+
+    if (pAclExisting)
+    {
+        if (!::GetAclInformation(const_cast<PACL>(pAclExisting), &asiExisting, sizeof(asiExisting), AclSizeInformation))
+        {
+            ExitWithLastError(hr, "failed to get information about existing ACL");
+        }
+
+        if (!::GetAclInformation(pAclMerged, &asiMerged, sizeof(asiMerged), AclSizeInformation))
+        {
+            ExitWithLastError(hr, "failed to get information about merged ACL");
+        }
+
+        // the ACEs follow the header, which also holds the allocated size, so only compare what's in use after it
+        if (asiExisting.AceCount == asiMerged.AceCount && asiExisting.AclBytesInUse == asiMerged.AclBytesInUse &&
+            0 == memcmp(pAclExisting + 1, pAclMerged + 1, asiMerged.AclBytesInUse - sizeof(ACL)))
+        {
+            hr = S_FALSE;
+        }
+    }
+
+    *ppAclNew = pAclNew;
+    pAclNew = NULL;
+
+LExit:
+    ReleaseMem(pAclNew);
+
+    if (pAclMerged)
+    {
+        ::LocalFree(pAclMerged);
+    }
+
+    ReleaseMem(rgMerged);
+
+    return hr;
+}
+
+
 /********************************************************************
 AclCreateDaclOld - creates a DACL from an ACL_ACCESS structure
 
@@ -802,6 +905,53 @@ LExit:
 }
 
 
+/********************************************************************
+AclCompareSecurityDescriptorStrings - compares two SDDL strings by the
+                                      security descriptors they describe
+
+NOTE: SDDL has several spellings for the same descriptor (for example
+      "GX" and "0x20000000", or "SY" and "S-1-5-18"), so comparing the
+      strings themselves reports differences that do not exist.
+********************************************************************/
+extern "C" HRESULT DAPI AclCompareSecurityDescriptorStrings(
+    __in_z LPCWSTR wzSddl1,
+    __in_z LPCWSTR wzSddl2,
+    __out BOOL* pfEqual
+    )
+{
+    Assert(wzSddl1 && wzSddl2 && pfEqual);
+    HRESULT hr = S_OK;
+    SECURITY_DESCRIPTOR* psd1 = NULL;
+    SECURITY_DESCRIPTOR* psd2 = NULL;
+    DWORD cbSD1 = 0;
+
+    *pfEqual = FALSE;
+
+    hr = AclCreateSecurityDescriptorFromString(&psd1, L"%ls", wzSddl1);
+    ExitOnFailure(hr, "failed to create security descriptor from SDDL: %ls", wzSddl1);
+
+    hr = AclCreateSecurityDescriptorFromString(&psd2, L"%ls", wzSddl2);
+    ExitOnFailure(hr, "failed to create security descriptor from SDDL: %ls", wzSddl2);
+
+    // Both are self-relative, so equal descriptors are byte for byte identical.
+    cbSD1 = ::GetSecurityDescriptorLength(psd1);
+    *pfEqual = cbSD1 == ::GetSecurityDescriptorLength(psd2) && 0 == memcmp(psd1, psd2, cbSD1);
+
+LExit:
+    if (psd2)
+    {
+        AclFreeSecurityDescriptor(psd2);
+    }
+
+    if (psd1)
+    {
+        AclFreeSecurityDescriptor(psd1);
+    }
+
+    return hr;
+}
+
+
 /********************************************************************
 AclDuplicateSecurityDescriptor - creates a copy of a self-relative security descriptor 
 
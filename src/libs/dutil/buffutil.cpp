@@ -10,9 +10,19 @@
 
 // helper function declarations
 
-static HRESULT EnsureBufferSize(
-    __deref_out_bcount(cbSize) BYTE** ppbBuffer,
-    __in SIZE_T cbSize
+static HRESULT EnsureWriterCapacity(
+    __in BUFF_WRITER* pWriter,
+    __in SIZE_T cbAdditional
+    );
+static void WriteBytes(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cb) const void* pv,
+    __in SIZE_T cb
+    );
+static HRESULT ReadBytes(
+    __in BUFF_READER* pReader,
+    __in SIZE_T cb,
+    __deref_out_bcount(cb) const BYTE** ppb
     );
 
 
@@ -30,21 +40,14 @@ extern "C" HRESULT BuffReadNumber(
     Assert(pdw);
 
     HRESULT hr = S_OK;
-    SIZE_T cbAvailable = 0;
+    BUFF_READER reader = { };
 
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size.");
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, *piBuffer);
 
-    // verify buffer size
-    if (sizeof(DWORD) > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small.");
-    }
+    hr = BuffReaderReadNumber(&reader, pdw);
+    ExitOnFailure(hr, "Failed to read number.");
 
-    *pdw = *(const DWORD*)(pbBuffer + *piBuffer);
-    *piBuffer += sizeof(DWORD);
+    *piBuffer = reader.iData;
 
 LExit:
     return hr;
@@ -62,21 +65,14 @@ extern "C" HRESULT BuffReadNumber64(
     Assert(pdw64);
 
     HRESULT hr = S_OK;
-    SIZE_T cbAvailable = 0;
+    BUFF_READER reader = { };
 
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size.");
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, *piBuffer);
 
-    // verify buffer size
-    if (sizeof(DWORD64) > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small.");
-    }
+    hr = BuffReaderReadNumber64(&reader, pdw64);
+    ExitOnFailure(hr, "Failed to read 64-bit number.");
 
-    *pdw64 = *(const DWORD64*)(pbBuffer + *piBuffer);
-    *piBuffer += sizeof(DWORD64);
+    *piBuffer = reader.iData;
 
 LExit:
     return hr;
@@ -94,46 +90,14 @@ extern "C" HRESULT BuffReadString(
     Assert(pscz);
 
     HRESULT hr = S_OK;
-    DWORD cch = 0;
-    DWORD cb = 0;
-    SIZE_T cbAvailable = 0;
-
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size for character count.");
-
-    // verify buffer size
-    if (sizeof(DWORD) > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small.");
-    }
-
-    // read character count
-    cch = *(const DWORD*)(pbBuffer + *piBuffer);
-
-    hr = ::DWordMult(cch, static_cast<DWORD>(sizeof(WCHAR)), &cb);
-    ExitOnRootFailure(hr, "Overflow while multiplying to calculate buffer size");
-
-    hr = ::SIZETAdd(*piBuffer, sizeof(DWORD), piBuffer);
-    ExitOnRootFailure(hr, "Overflow while adding to calculate buffer size");
+    BUFF_READER reader = { };
 
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size for character buffer.");
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, *piBuffer);
 
-    // verify buffer size
-    if (cb > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small to hold character data.");
-    }
-
-    // copy character data
-    hr = StrAllocString(pscz, cch ? (LPCWSTR)(pbBuffer + *piBuffer) : L"", cch);
-    ExitOnFailure(hr, "Failed to copy character data.");
+    hr = BuffReaderReadString(&reader, pscz);
+    ExitOnFailure(hr, "Failed to read string.");
 
-    *piBuffer += cb;
+    *piBuffer = reader.iData;
 
 LExit:
     return hr;
@@ -151,46 +115,14 @@ extern "C" HRESULT BuffReadStringAnsi(
     Assert(pscz);
 
     HRESULT hr = S_OK;
-    DWORD cch = 0;
-    DWORD cb = 0;
-    SIZE_T cbAvailable = 0;
+    BUFF_READER reader = { };
 
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size for character count.");
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, *piBuffer);
 
-    // verify buffer size
-    if (sizeof(DWORD) > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small.");
-    }
-
-    // read character count
-    cch = *(const DWORD*)(pbBuffer + *piBuffer);
-
-    hr = ::DWordMult(cch, static_cast<DWORD>(sizeof(CHAR)), &cb);
-    ExitOnRootFailure(hr, "Overflow while multiplying to calculate buffer size");
+    hr = BuffReaderReadStringAnsi(&reader, pscz);
+    ExitOnFailure(hr, "Failed to read ANSI string.");
 
-    hr = ::SIZETAdd(*piBuffer, sizeof(DWORD), piBuffer);
-    ExitOnRootFailure(hr, "Overflow while adding to calculate buffer size");
-
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size for character buffer.");
-
-    // verify buffer size
-    if (cb > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small to hold character count.");
-    }
-
-    // copy character data
-    hr = StrAnsiAllocStringAnsi(pscz, cch ? (LPCSTR)(pbBuffer + *piBuffer) : "", cch);
-    ExitOnFailure(hr, "Failed to copy character data.");
-
-    *piBuffer += cb;
+    *piBuffer = reader.iData;
 
 LExit:
     return hr;
@@ -210,45 +142,14 @@ extern "C" HRESULT BuffReadStream(
     Assert(pcbStream);
 
     HRESULT hr = S_OK;
-    DWORD64 cb = 0;
-    SIZE_T cbAvailable = 0;
-
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size for stream size.");
-
-    // verify buffer size
-    if (sizeof(DWORD64) > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small.");
-    }
+    BUFF_READER reader = { };
 
-    // read stream size
-    cb = *(const DWORD64*)(pbBuffer + *piBuffer);
-    *piBuffer += sizeof(DWORD64);
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, *piBuffer);
 
-    // get availiable data size
-    hr = ::SIZETSub(cbBuffer, *piBuffer, &cbAvailable);
-    ExitOnRootFailure(hr, "Failed to calculate available data size for stream buffer.");
+    hr = BuffReaderReadStream(&reader, ppbStream, pcbStream);
+    ExitOnFailure(hr, "Failed to read stream.");
 
-    // verify buffer size
-    if (cb > cbAvailable)
-    {
-        hr = E_INVALIDARG;
-        ExitOnRootFailure(hr, "Buffer too small to hold byte count.");
-    }
-
-    // allocate buffer
-    *ppbStream = (BYTE*)MemAlloc((SIZE_T)cb, TRUE);
-    ExitOnNull(*ppbStream, hr, E_OUTOFMEMORY, "Failed to allocate stream.");
-
-    // read stream data
-    memcpy_s(*ppbStream, cbBuffer - *piBuffer, pbBuffer + *piBuffer, (SIZE_T)cb);
-    *piBuffer += (SIZE_T)cb;
-
-    // return stream size
-    *pcbStream = (SIZE_T)cb;
+    *piBuffer = reader.iData;
 
 LExit:
     return hr;
@@ -264,14 +165,14 @@ extern "C" HRESULT BuffWriteNumber(
     Assert(piBuffer);
 
     HRESULT hr = S_OK;
+    BUFF_WRITER writer = { };
 
-    // make sure we have a buffer with sufficient space
-    hr = EnsureBufferSize(ppbBuffer, *piBuffer + sizeof(DWORD));
-    ExitOnFailure(hr, "Failed to ensure buffer size.");
+    hr = BuffWriterAttach(&writer, *ppbBuffer, *piBuffer);
+    ExitOnFailure(hr, "Failed to attach to buffer.");
 
-    // copy data to buffer
-    *(DWORD*)(*ppbBuffer + *piBuffer) = dw;
-    *piBuffer += sizeof(DWORD);
+    hr = BuffWriterWriteNumber(&writer, dw);
+    BuffWriterDetach(&writer, ppbBuffer, piBuffer);
+    ExitOnFailure(hr, "Failed to write number.");
 
 LExit:
     return hr;
@@ -287,14 +188,14 @@ extern "C" HRESULT BuffWriteNumber64(
     Assert(piBuffer);
 
     HRESULT hr = S_OK;
+    BUFF_WRITER writer = { };
 
-    // make sure we have a buffer with sufficient space
-    hr = EnsureBufferSize(ppbBuffer, *piBuffer + sizeof(DWORD64));
-    ExitOnFailure(hr, "Failed to ensure buffer size.");
+    hr = BuffWriterAttach(&writer, *ppbBuffer, *piBuffer);
+    ExitOnFailure(hr, "Failed to attach to buffer.");
 
-    // copy data to buffer
-    *(DWORD64*)(*ppbBuffer + *piBuffer) = dw64;
-    *piBuffer += sizeof(DWORD64);
+    hr = BuffWriterWriteNumber64(&writer, dw64);
+    BuffWriterDetach(&writer, ppbBuffer, piBuffer);
+    ExitOnFailure(hr, "Failed to write 64-bit number.");
 
 LExit:
     return hr;
@@ -310,20 +211,14 @@ extern "C" HRESULT BuffWriteString(
     Assert(piBuffer);
 
     HRESULT hr = S_OK;
-    DWORD cch = (DWORD)lstrlenW(scz);
-    SIZE_T cb = cch * sizeof(WCHAR);
+    BUFF_WRITER writer = { };
 
-    // make sure we have a buffer with sufficient space
-    hr = EnsureBufferSize(ppbBuffer, *piBuffer + (sizeof(DWORD) + cb));
-    ExitOnFailure(hr, "Failed to ensure buffer size.");
-
-    // copy character count to buffer
-    *(DWORD*)(*ppbBuffer + *piBuffer) = cch;
-    *piBuffer += sizeof(DWORD);
+    hr = BuffWriterAttach(&writer, *ppbBuffer, *piBuffer);
+    ExitOnFailure(hr, "Failed to attach to buffer.");
 
-    // copy data to buffer
-    memcpy_s(*ppbBuffer + *piBuffer, cb, scz, cb);
-    *piBuffer += cb;
+    hr = BuffWriterWriteString(&writer, scz);
+    BuffWriterDetach(&writer, ppbBuffer, piBuffer);
+    ExitOnFailure(hr, "Failed to write string.");
 
 LExit:
     return hr;
@@ -339,20 +234,14 @@ extern "C" HRESULT BuffWriteStringAnsi(
     Assert(piBuffer);
 
     HRESULT hr = S_OK;
-    DWORD cch = (DWORD)lstrlenA(scz);
-    SIZE_T cb = cch * sizeof(CHAR);
-
-    // make sure we have a buffer with sufficient space
-    hr = EnsureBufferSize(ppbBuffer, *piBuffer + (sizeof(DWORD) + cb));
-    ExitOnFailure(hr, "Failed to ensure buffer size.");
+    BUFF_WRITER writer = { };
 
-    // copy character count to buffer
-    *(DWORD*)(*ppbBuffer + *piBuffer) = cch;
-    *piBuffer += sizeof(DWORD);
+    hr = BuffWriterAttach(&writer, *ppbBuffer, *piBuffer);
+    ExitOnFailure(hr, "Failed to attach to buffer.");
 
-    // copy data to buffer
-    memcpy_s(*ppbBuffer + *piBuffer, cb, scz, cb);
-    *piBuffer += cb;
+    hr = BuffWriterWriteStringAnsi(&writer, scz);
+    BuffWriterDetach(&writer, ppbBuffer, piBuffer);
+    ExitOnFailure(hr, "Failed to write ANSI string.");
 
 LExit:
     return hr;
@@ -369,20 +258,408 @@ extern "C" HRESULT BuffWriteStream(
     Assert(piBuffer);
     Assert(pbStream);
 
+    HRESULT hr = S_OK;
+    BUFF_WRITER writer = { };
+
+    hr = BuffWriterAttach(&writer, *ppbBuffer, *piBuffer);
+    ExitOnFailure(hr, "Failed to attach to buffer.");
+
+    hr = BuffWriterWriteStream(&writer, pbStream, cbStream);
+    BuffWriterDetach(&writer, ppbBuffer, piBuffer);
+    ExitOnFailure(hr, "Failed to write stream.");
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffWriterAttach(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount_opt(cbBuffer) BYTE* pbBuffer,
+    __in SIZE_T cbBuffer
+    )
+{
+    Assert(pWriter);
+
+    HRESULT hr = S_OK;
+    SIZE_T cbCapacity = 0;
+
+    if (pbBuffer)
+    {
+        cbCapacity = MemSize(pbBuffer);
+        if (-1 == cbCapacity || cbBuffer > cbCapacity)
+        {
+            hr = E_INVALIDARG;
+            ExitOnRootFailure(hr, "Buffer size is larger than its allocation.");
+        }
+    }
+    else if (cbBuffer)
+    {
+        hr = E_INVALIDARG;
+        ExitOnRootFailure(hr, "Buffer size given without a buffer.");
+    }
+
+    pWriter->pbData = pbBuffer;
+    pWriter->cbData = cbBuffer;
+    pWriter->cbCapacity = cbCapacity;
+
+LExit:
+    return hr;
+}
+
+extern "C" void BuffWriterDetach(
+    __in BUFF_WRITER* pWriter,
+    __deref_out_bcount(*pcbBuffer) BYTE** ppbBuffer,
+    __out SIZE_T* pcbBuffer
+    )
+{
+    Assert(pWriter);
+    Assert(ppbBuffer);
+    Assert(pcbBuffer);
+
+    *ppbBuffer = pWriter->pbData;
+    *pcbBuffer = pWriter->cbData;
+
+    memset(pWriter, 0, sizeof(BUFF_WRITER));
+}
+
+extern "C" void BuffWriterUninitialize(
+    __in BUFF_WRITER* pWriter
+    )
+{
+    ReleaseMem(pWriter->pbData);
+    memset(pWriter, 0, sizeof(BUFF_WRITER));
+}
+
+extern "C" HRESULT BuffWriterReserve(
+    __in BUFF_WRITER* pWriter,
+    __in SIZE_T cbAdditional
+    )
+{
+    Assert(pWriter);
+
+    HRESULT hr = S_OK;
+
+    hr = EnsureWriterCapacity(pWriter, cbAdditional);
+    ExitOnFailure(hr, "Failed to reserve buffer space.");
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffWriterWriteNumber(
+    __in BUFF_WRITER* pWriter,
+    __in DWORD dw
+    )
+{
+    Assert(pWriter);
+
+    HRESULT hr = S_OK;
+
+    hr = EnsureWriterCapacity(pWriter, sizeof(DWORD));
+    ExitOnFailure(hr, "Failed to ensure buffer size.");
+
+    WriteBytes(pWriter, &dw, sizeof(DWORD));
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffWriterWriteNumber64(
+    __in BUFF_WRITER* pWriter,
+    __in DWORD64 dw64
+    )
+{
+    Assert(pWriter);
+
+    HRESULT hr = S_OK;
+
+    hr = EnsureWriterCapacity(pWriter, sizeof(DWORD64));
+    ExitOnFailure(hr, "Failed to ensure buffer size.");
+
+    WriteBytes(pWriter, &dw64, sizeof(DWORD64));
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffWriterWriteString(
+    __in BUFF_WRITER* pWriter,
+    __in_z_opt LPCWSTR wz
+    )
+{
+    Assert(pWriter);
+
+    HRESULT hr = S_OK;
+    DWORD cch = (DWORD)lstrlenW(wz);
+    SIZE_T cb = cch * sizeof(WCHAR);
+
+    hr = EnsureWriterCapacity(pWriter, sizeof(DWORD) + cb);
+    ExitOnFailure(hr, "Failed to ensure buffer size.");
+
+    // character count followed by the characters, no terminator
+    WriteBytes(pWriter, &cch, sizeof(DWORD));
+    WriteBytes(pWriter, wz, cb);
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffWriterWriteStringAnsi(
+    __in BUFF_WRITER* pWriter,
+    __in_z_opt LPCSTR sz
+    )
+{
+    Assert(pWriter);
+
+    HRESULT hr = S_OK;
+    DWORD cch = (DWORD)lstrlenA(sz);
+    SIZE_T cb = cch * sizeof(CHAR);
+
+    hr = EnsureWriterCapacity(pWriter, sizeof(DWORD) + cb);
+    ExitOnFailure(hr, "Failed to ensure buffer size.");
+
+    // character count followed by the characters, no terminator
+    WriteBytes(pWriter, &cch, sizeof(DWORD));
+    WriteBytes(pWriter, sz, cb);
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffWriterWriteStream(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cbStream) const BYTE* pbStream,
+    __in SIZE_T cbStream
+    )
+{
+    Assert(pWriter);
+    Assert(pbStream);
+
     HRESULT hr = S_OK;
     DWORD64 cb = cbStream;
+    SIZE_T cbTotal = 0;
 
-    // make sure we have a buffer with sufficient space
-    hr = EnsureBufferSize(ppbBuffer, *piBuffer + cbStream + sizeof(DWORD64));
+    hr = ::SIZETAdd(cbStream, sizeof(DWORD64), &cbTotal);
+    ExitOnRootFailure(hr, "Overflow while calculating stream size.");
+
+    hr = EnsureWriterCapacity(pWriter, cbTotal);
     ExitOnFailure(hr, "Failed to ensure buffer size.");
 
-    // copy byte count to buffer
-    *(DWORD64*)(*ppbBuffer + *piBuffer) = cb;
-    *piBuffer += sizeof(DWORD64);
+    // byte count followed by the bytes
+    WriteBytes(pWriter, &cb, sizeof(DWORD64));
+    WriteBytes(pWriter, pbStream, cbStream);
+
+LExit:
+    return hr;
+}
+
+extern "C" void BuffReaderInitialize(
+    __in BUFF_READER* pReader,
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in SIZE_T iBuffer
+    )
+{
+    Assert(pReader);
+
+    pReader->pbData = pbBuffer;
+    pReader->cbData = cbBuffer;
+    pReader->iData = iBuffer;
+}
+
+extern "C" HRESULT BuffReaderReadNumber(
+    __in BUFF_READER* pReader,
+    __out DWORD* pdw
+    )
+{
+    Assert(pReader);
+    Assert(pdw);
+
+    HRESULT hr = S_OK;
+    const BYTE* pb = NULL;
 
-    // copy data to buffer
-    memcpy_s(*ppbBuffer + *piBuffer, cbStream, pbStream, cbStream);
-    *piBuffer += cbStream;
+    hr = ReadBytes(pReader, sizeof(DWORD), &pb);
+    ExitOnFailure(hr, "Failed to read number.");
+
+    *pdw = *(const DWORD*)pb;
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffReaderReadNumber64(
+    __in BUFF_READER* pReader,
+    __out DWORD64* pdw64
+    )
+{
+    Assert(pReader);
+    Assert(pdw64);
+
+    HRESULT hr = S_OK;
+    const BYTE* pb = NULL;
+
+    hr = ReadBytes(pReader, sizeof(DWORD64), &pb);
+    ExitOnFailure(hr, "Failed to read 64-bit number.");
+
+    *pdw64 = *(const DWORD64*)pb;
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffReaderReadString(
+    __in BUFF_READER* pReader,
+    __deref_out_z LPWSTR* pscz
+    )
+{
+    Assert(pReader);
+    Assert(pscz);
+
+    HRESULT hr = S_OK;
+    LPCWSTR wz = NULL;
+    DWORD cch = 0;
+
+    hr = BuffReaderReadStringView(pReader, &wz, &cch);
+    ExitOnFailure(hr, "Failed to read character data.");
+
+    hr = StrAllocString(pscz, wz, cch);
+    ExitOnFailure(hr, "Failed to copy character data.");
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffReaderReadStringAnsi(
+    __in BUFF_READER* pReader,
+    __deref_out_z LPSTR* pscz
+    )
+{
+    Assert(pReader);
+    Assert(pscz);
+
+    HRESULT hr = S_OK;
+    SIZE_T iStart = pReader->iData;
+    DWORD cch = 0;
+    const BYTE* pb = NULL;
+
+    hr = BuffReaderReadNumber(pReader, &cch);
+    ExitOnFailure(hr, "Failed to read character count.");
+
+    hr = ReadBytes(pReader, cch * sizeof(CHAR), &pb);
+    if (FAILED(hr))
+    {
+        pReader->iData = iStart;
+    }
+    ExitOnFailure(hr, "Buffer too small to hold character data.");
+
+    hr = StrAnsiAllocStringAnsi(pscz, cch ? (LPCSTR)pb : "", cch);
+    ExitOnFailure(hr, "Failed to copy character data.");
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffReaderReadStringView(
+    __in BUFF_READER* pReader,
+    __deref_out_ecount(*pcch) LPCWSTR* pwz,
+    __out DWORD* pcch
+    )
+{
+    Assert(pReader);
+    Assert(pwz);
+    Assert(pcch);
+
+    HRESULT hr = S_OK;
+    SIZE_T iStart = pReader->iData;
+    DWORD cch = 0;
+    DWORD cb = 0;
+    const BYTE* pb = NULL;
+
+    hr = BuffReaderReadNumber(pReader, &cch);
+    ExitOnFailure(hr, "Failed to read character count.");
+
+    hr = ::DWordMult(cch, static_cast<DWORD>(sizeof(WCHAR)), &cb);
+    if (SUCCEEDED(hr))
+    {
+        hr = ReadBytes(pReader, cb, &pb);
+    }
+
+    if (FAILED(hr))
+    {
+        pReader->iData = iStart;
+    }
+    ExitOnFailure(hr, "Buffer too small to hold character data.");
+
+    // The characters are not terminated in the buffer so callers must honor the count.
+    // An empty string still gets a valid pointer.
+    *pwz = cch ? (LPCWSTR)pb : L"";
+    *pcch = cch;
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffReaderReadStream(
+    __in BUFF_READER* pReader,
+    __deref_out_bcount(*pcbStream) BYTE** ppbStream,
+    __out SIZE_T* pcbStream
+    )
+{
+    Assert(pReader);
+    Assert(ppbStream);
+    Assert(pcbStream);
+
+    HRESULT hr = S_OK;
+    SIZE_T iStart = pReader->iData;
+    const BYTE* pbStream = NULL;
+    SIZE_T cbStream = 0;
+
+    hr = BuffReaderReadStreamView(pReader, &pbStream, &cbStream);
+    ExitOnFailure(hr, "Failed to read stream.");
+
+    *ppbStream = (BYTE*)MemAlloc(cbStream, TRUE);
+    if (!*ppbStream)
+    {
+        pReader->iData = iStart;
+    }
+    ExitOnNull(*ppbStream, hr, E_OUTOFMEMORY, "Failed to allocate stream.");
+
+    memcpy_s(*ppbStream, cbStream, pbStream, cbStream);
+    *pcbStream = cbStream;
+
+LExit:
+    return hr;
+}
+
+extern "C" HRESULT BuffReaderReadStreamView(
+    __in BUFF_READER* pReader,
+    __deref_out_bcount(*pcbStream) const BYTE** ppbStream,
+    __out SIZE_T* pcbStream
+    )
+{
+    Assert(pReader);
+    Assert(ppbStream);
+    Assert(pcbStream);
+
+    HRESULT hr = S_OK;
+    SIZE_T iStart = pReader->iData;
+    DWORD64 cb = 0;
+
+    hr = BuffReaderReadNumber64(pReader, &cb);
+    ExitOnFailure(hr, "Failed to read stream size.");
+
+    // compare before narrowing so a huge count cannot wrap on 32-bit
+    if (pReader->iData > pReader->cbData || cb > pReader->cbData - pReader->iData)
+    {
+        pReader->iData = iStart;
+
+        hr = E_INVALIDARG;
+        ExitOnRootFailure(hr, "Buffer too small to hold byte count.");
+    }
+
+    *ppbStream = pReader->pbData + pReader->iData;
+    *pcbStream = (SIZE_T)cb;
+    pReader->iData += (SIZE_T)cb;
 
 LExit:
     return hr;
@@ -391,29 +668,90 @@ LExit:
 
 // helper functions
 
-static HRESULT EnsureBufferSize(
-    __deref_out_bcount(cbSize) BYTE** ppbBuffer,
-    __in SIZE_T cbSize
+static HRESULT EnsureWriterCapacity(
+    __in BUFF_WRITER* pWriter,
+    __in SIZE_T cbAdditional
     )
 {
     HRESULT hr = S_OK;
-    SIZE_T cbTarget = ((cbSize / BUFFER_INCREMENT) + 1) * BUFFER_INCREMENT;
+    SIZE_T cbRequired = 0;
+    SIZE_T cbTarget = 0;
+    LPVOID pv = NULL;
 
-    if (*ppbBuffer)
+    hr = ::SIZETAdd(pWriter->cbData, cbAdditional, &cbRequired);
+    ExitOnRootFailure(hr, "Overflow while calculating buffer size.");
+
+    if (cbRequired <= pWriter->cbCapacity)
     {
-        if (MemSize(*ppbBuffer) < cbTarget)
-        {
-            LPVOID pv = MemReAlloc(*ppbBuffer, cbTarget, TRUE);
-            ExitOnNull(pv, hr, E_OUTOFMEMORY, "Failed to reallocate buffer.");
-            *ppbBuffer = (BYTE*)pv;
-        }
+        ExitFunction();
+    }
+
+    // Double the capacity so appending n bytes costs O(n) copies in total,
+    // but never allocate less than what was asked for.
+    cbTarget = pWriter->cbCapacity;
+    if (FAILED(::SIZETMult(cbTarget, 2, &cbTarget)) || cbTarget < cbRequired)
+    {
+        cbTarget = cbRequired;
+    }
+
+    if (BUFFER_INCREMENT > cbTarget)
+    {
+        cbTarget = BUFFER_INCREMENT;
+    }
+
+    if (pWriter->pbData)
+    {
+        pv = MemReAlloc(pWriter->pbData, cbTarget, TRUE);
+        ExitOnNull(pv, hr, E_OUTOFMEMORY, "Failed to reallocate buffer.");
     }
     else
     {
-        *ppbBuffer = (BYTE*)MemAlloc(cbTarget, TRUE);
-        ExitOnNull(*ppbBuffer, hr, E_OUTOFMEMORY, "Failed to allocate buffer.");
+        pv = MemAlloc(cbTarget, TRUE);
+        ExitOnNull(pv, hr, E_OUTOFMEMORY, "Failed to allocate buffer.");
     }
 
+    pWriter->pbData = static_cast<BYTE*>(pv);
+    pWriter->cbCapacity = cbTarget;
+
+LExit:
+    return hr;
+}
+
+static void WriteBytes(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cb) const void* pv,
+    __in SIZE_T cb
+    )
+{
+    // caller already ensured the capacity
+    if (cb)
+    {
+        memcpy_s(pWriter->pbData + pWriter->cbData, pWriter->cbCapacity - pWriter->cbData, pv, cb);
+        pWriter->cbData += cb;
+    }
+}
+
+static HRESULT ReadBytes(
+    __in BUFF_READER* pReader,
+    __in SIZE_T cb,
+    __deref_out_bcount(cb) const BYTE** ppb
+    )
+{
+    HRESULT hr = S_OK;
+    SIZE_T cbAvailable = 0;
+
+    hr = ::SIZETSub(pReader->cbData, pReader->iData, &cbAvailable);
+    ExitOnRootFailure(hr, "Failed to calculate available data size.");
+
+    if (cb > cbAvailable)
+    {
+        hr = E_INVALIDARG;
+        ExitOnRootFailure(hr, "Buffer too small.");
+    }
+
+    *ppb = pReader->pbData + pReader->iData;
+    pReader->iData += cb;
+
 LExit:
     return hr;
 }
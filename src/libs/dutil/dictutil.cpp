@@ -18,8 +18,9 @@ const DWORD MAX_BUCKET_SIZES[] = {
     2148059509
     };
 
-// However many items are in the cab, let's keep the buckets at least 8 times that to avoid collisions
-#define MAX_BUCKETS_TO_ITEMS_RATIO 8
+// Grow once the table is half full. Each bucket caches the full hash of its key, so probing past
+// a collision costs a DWORD compare rather than a string compare, and a 50% load keeps probe runs short.
+#define MAX_BUCKETS_TO_ITEMS_RATIO 2
 
 enum DICT_TYPE
 {
@@ -28,6 +29,15 @@ enum DICT_TYPE
     DICT_STRING_LIST = 2
 };
 
+struct DICT_BUCKET
+{
+    // Stored value (or offset into the value array, see TranslateValueToOffset()), NULL if the bucket is empty
+    void *pvValue;
+
+    // Full (unreduced) hash of the key stored in this bucket
+    DWORD dwHash;
+};
+
 struct STRINGDICT_STRUCT
 {
     DICT_TYPE dtType;
@@ -46,7 +56,7 @@ struct STRINGDICT_STRUCT
     size_t cByteOffset;
 
     // The actual stored buckets
-    void **ppvBuckets;
+    DICT_BUCKET *rgBuckets;
 
     // The actual stored items in the order they were added (used for auto freeing or enumerating)
     void **ppvItemList;
@@ -57,15 +67,17 @@ struct STRINGDICT_STRUCT
 
 const int STRINGDICT_HANDLE_BYTES = sizeof(STRINGDICT_STRUCT);
 
-static HRESULT StringHash(
+static DWORD StringHash(
     __in const STRINGDICT_STRUCT *psd,
-    __in DWORD dwNumBuckets,
-    __in_z LPCWSTR pszString,
-    __out LPDWORD pdwHash
+    __in_z LPCWSTR pszString
+    );
+static WCHAR FoldChar(
+    __in WCHAR wc
     );
 static BOOL IsMatchExact(
     __in const STRINGDICT_STRUCT *psd,
     __in DWORD dwMatchIndex,
+    __in DWORD dwHash,
     __in_z LPCWSTR wzOriginalString
     );
 static HRESULT GetValue(
@@ -74,14 +86,15 @@ static HRESULT GetValue(
     __out_opt void **ppvValue
     );
 static HRESULT GetInsertIndex(
-    __in const STRINGDICT_STRUCT *psd,
     __in DWORD dwBucketCount,
-    __in void **ppvBuckets,
-    __in_z LPCWSTR pszString,
+    __in DICT_BUCKET *rgBuckets,
+    __in DWORD dwHash,
+    __in_z_opt LPCWSTR pszString,
     __out DWORD *pdwOutput
     );
 static HRESULT GetIndex(
     __in const STRINGDICT_STRUCT *psd,
+    __in DWORD dwHash,
     __in_z LPCWSTR pszString,
     __out DWORD *pdwOutput
     );
@@ -89,6 +102,9 @@ static LPCWSTR GetKey(
     __in const STRINGDICT_STRUCT *psd,
     __in void *pvValue
     );
+static HRESULT EnsureCapacity(
+    __inout STRINGDICT_STRUCT *psd
+    );
 static HRESULT GrowDictionary(
     __inout STRINGDICT_STRUCT *psd
     );
@@ -103,6 +119,18 @@ static void * TranslateValueToOffset(
     __in void *pvValue
     );
 
+// Upper-case fold for the ASCII range, so the common case never leaves the table.
+static const WCHAR ASCII_FOLD[128] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+    0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4A, 0x4B, 0x4C, 0x4D, 0x4E, 0x4F,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+    };
+
 // The dict will store a set of keys (as wide-char strings) and a set of values associated with those keys (as void *'s).
 // However, to support collision checking, the key needs to be represented in the "value" object (pointed to
 // by the void *). The "stByteOffset" parameter tells this dict the byte offset of the "key" string pointer
@@ -150,8 +178,8 @@ extern "C" HRESULT DAPI DictCreateWithEmbeddedKey(
     }
 
     // Finally, allocate our initial buckets
-    psd->ppvBuckets = static_cast<void**>(MemAlloc(sizeof(void *) * MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], TRUE));
-    ExitOnNull(psd->ppvBuckets, hr, E_OUTOFMEMORY, "Failed to allocate buckets for dictionary");
+    psd->rgBuckets = static_cast<DICT_BUCKET*>(MemAlloc(sizeof(DICT_BUCKET) * MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], TRUE));
+    ExitOnNull(psd->rgBuckets, hr, E_OUTOFMEMORY, "Failed to allocate buckets for dictionary");
 
 LExit:
     return hr;
@@ -194,8 +222,8 @@ extern "C" HRESULT DAPI DictCreateStringList(
     }
 
     // Finally, allocate our initial buckets
-    psd->ppvBuckets = static_cast<void**>(MemAlloc(sizeof(void *) * MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], TRUE));
-    ExitOnNull(psd->ppvBuckets, hr, E_OUTOFMEMORY, "Failed to allocate buckets for dictionary");
+    psd->rgBuckets = static_cast<DICT_BUCKET*>(MemAlloc(sizeof(DICT_BUCKET) * MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], TRUE));
+    ExitOnNull(psd->rgBuckets, hr, E_OUTOFMEMORY, "Failed to allocate buckets for dictionary");
 
 LExit:
     return hr;
@@ -263,7 +291,6 @@ LExit:
     return hr;
 }
 
-// Todo: Dict should resize itself when (number of items) exceeds (number of buckets / MAX_BUCKETS_TO_ITEMS_RATIO)
 extern "C" HRESULT DAPI DictAddKey(
     __in_bcount(STRINGDICT_HANDLE_BYTES) STRINGDICT_HANDLE sdHandle,
     __in_z LPCWSTR pszString
@@ -271,54 +298,45 @@ extern "C" HRESULT DAPI DictAddKey(
 {
     HRESULT hr = S_OK;
     DWORD dwIndex = 0;
+    DWORD dwHash = 0;
+    LPWSTR sczKey = NULL;
     STRINGDICT_STRUCT *psd = static_cast<STRINGDICT_STRUCT *>(sdHandle);
 
     ExitOnNull(sdHandle, hr, E_INVALIDARG, "Handle not specified while adding value to dict");
     ExitOnNull(pszString, hr, E_INVALIDARG, "String not specified while adding value to dict");
 
-    if (psd->dwBucketSizeIndex >= countof(MAX_BUCKET_SIZES))
-    {
-        hr = E_INVALIDARG;
-        ExitOnFailure(hr, "Invalid dictionary - bucket size index is out of range");
-    }
-
     if (DICT_STRING_LIST != psd->dtType)
     {
         hr = E_INVALIDARG;
         ExitOnFailure(hr, "Tried to add key without value to wrong dictionary type! This dictionary type is: %d", psd->dtType);
     }
 
-    if ((psd->dwNumItems + 1) >= MAX_BUCKET_SIZES[psd->dwBucketSizeIndex] / MAX_BUCKETS_TO_ITEMS_RATIO)
-    {
-        hr = GrowDictionary(psd);
-        if (HRESULT_FROM_WIN32(ERROR_DATABASE_FULL) == hr)
-        {
-            // If we fail to proactively grow the dictionary, don't fail unless the dictionary is completely full
-            if (psd->dwNumItems < MAX_BUCKET_SIZES[psd->dwBucketSizeIndex])
-            {
-                hr = S_OK;
-            }
-        }
-        ExitOnFailure(hr, "Failed to grow dictionary");
-    }
+    hr = EnsureCapacity(psd);
+    ExitOnFailure(hr, "Failed to grow dictionary");
 
-    hr = GetInsertIndex(psd, MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], psd->ppvBuckets, pszString, &dwIndex);
+    dwHash = StringHash(psd, pszString);
+
+    hr = GetInsertIndex(MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], psd->rgBuckets, dwHash, pszString, &dwIndex);
     ExitOnFailure(hr, "Failed to get index to insert into");
 
     hr = MemEnsureArraySize(reinterpret_cast<void **>(&(psd->ppvItemList)), psd->dwNumItems + 1, sizeof(void *), 1000);
     ExitOnFailure(hr, "Failed to resize list of items in dictionary");
-    ++psd->dwNumItems;
 
-    hr = StrAllocString(reinterpret_cast<LPWSTR *>(&(psd->ppvBuckets[dwIndex])), pszString, 0);
+    hr = StrAllocString(&sczKey, pszString, 0);
     ExitOnFailure(hr, "Failed to allocate copy of string");
 
-    psd->ppvItemList[psd->dwNumItems-1] = psd->ppvBuckets[dwIndex];
+    psd->rgBuckets[dwIndex].pvValue = sczKey;
+    psd->rgBuckets[dwIndex].dwHash = dwHash;
+    psd->ppvItemList[psd->dwNumItems] = sczKey;
+    ++psd->dwNumItems;
+    sczKey = NULL;
 
 LExit:
+    ReleaseStr(sczKey);
+
     return hr;
 }
 
-// Todo: Dict should resize itself when (number of items) exceeds (number of buckets / MAX_BUCKETS_TO_ITEMS_RATIO)
 extern "C" HRESULT DAPI DictAddValue(
     __in_bcount(STRINGDICT_HANDLE_BYTES) STRINGDICT_HANDLE sdHandle,
     __in void *pvValue
@@ -328,17 +346,12 @@ extern "C" HRESULT DAPI DictAddValue(
     void *pvOffset = NULL;
     LPCWSTR wzKey = NULL;
     DWORD dwIndex = 0;
+    DWORD dwHash = 0;
     STRINGDICT_STRUCT *psd = static_cast<STRINGDICT_STRUCT *>(sdHandle);
 
     ExitOnNull(sdHandle, hr, E_INVALIDARG, "Handle not specified while adding value to dict");
     ExitOnNull(pvValue, hr, E_INVALIDARG, "Value not specified while adding value to dict");
 
-    if (psd->dwBucketSizeIndex >= countof(MAX_BUCKET_SIZES))
-    {
-        hr = E_INVALIDARG;
-        ExitOnFailure(hr, "Invalid dictionary - bucket size index is out of range");
-    }
-
     if (DICT_EMBEDDED_KEY != psd->dtType)
     {
         hr = E_INVALIDARG;
@@ -348,21 +361,12 @@ extern "C" HRESULT DAPI DictAddValue(
     wzKey = GetKey(psd, pvValue);
     ExitOnNull(wzKey, hr, E_INVALIDARG, "String not specified while adding value to dict");
 
-    if ((psd->dwNumItems + 1) >= MAX_BUCKET_SIZES[psd->dwBucketSizeIndex] / MAX_BUCKETS_TO_ITEMS_RATIO)
-    {
-        hr = GrowDictionary(psd);
-        if (HRESULT_FROM_WIN32(ERROR_DATABASE_FULL) == hr && psd->dwNumItems + 1 )
-        {
-            // If we fail to proactively grow the dictionary, don't fail unless the dictionary is completely full
-            if (psd->dwNumItems < MAX_BUCKET_SIZES[psd->dwBucketSizeIndex])
-            {
-                hr = S_OK;
-            }
-        }
-        ExitOnFailure(hr, "Failed to grow dictionary");
-    }
+    hr = EnsureCapacity(psd);
+    ExitOnFailure(hr, "Failed to grow dictionary");
+
+    dwHash = StringHash(psd, wzKey);
 
-    hr = GetInsertIndex(psd, MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], psd->ppvBuckets, wzKey, &dwIndex);
+    hr = GetInsertIndex(MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], psd->rgBuckets, dwHash, wzKey, &dwIndex);
     ExitOnFailure(hr, "Failed to get index to insert into");
 
     hr = MemEnsureArraySize(reinterpret_cast<void **>(&(psd->ppvItemList)), psd->dwNumItems + 1, sizeof(void *), 1000);
@@ -370,7 +374,8 @@ extern "C" HRESULT DAPI DictAddValue(
     ++psd->dwNumItems;
 
     pvOffset = TranslateValueToOffset(psd, pvValue);
-    psd->ppvBuckets[dwIndex] = pvOffset;
+    psd->rgBuckets[dwIndex].pvValue = pvOffset;
+    psd->rgBuckets[dwIndex].dwHash = dwHash;
     psd->ppvItemList[psd->dwNumItems-1] = pvOffset;
 
 LExit:
@@ -448,56 +453,76 @@ extern "C" void DAPI DictDestroy(
     }
 
     ReleaseMem(psd->ppvItemList);
-    ReleaseMem(psd->ppvBuckets);
+    ReleaseMem(psd->rgBuckets);
     ReleaseMem(psd);
 }
 
-static HRESULT StringHash(
+// Hashes the string in place. Case-insensitive dictionaries fold each character to upper case as
+// it is consumed instead of allocating an upper-cased copy of the key.
+static DWORD StringHash(
     __in const STRINGDICT_STRUCT *psd,
-    __in DWORD dwNumBuckets,
-    __in_z LPCWSTR pszString,
-    __out DWORD *pdwHash
+    __in_z LPCWSTR pszString
     )
 {
-    HRESULT hr = S_OK;
-    LPCWSTR wzKey = NULL;
-    LPWSTR sczNewKey = NULL;
     DWORD result = 0;
+    LPCWSTR wz = pszString;
 
     if (DICT_FLAG_CASEINSENSITIVE & psd->dfFlags)
     {
-        hr = StrAllocStringToUpperInvariant(&sczNewKey, pszString, 0);
-        ExitOnFailure(hr, "Failed to convert the string to upper-case.");
-
-        wzKey = sczNewKey;
+        while (*wz)
+        {
+            result = ~(FoldChar(*wz++) * 509) + result * 65599;
+        }
     }
     else
     {
-        wzKey = pszString;
+        while (*wz)
+        {
+            result = ~(*wz++ * 509) + result * 65599;
+        }
     }
 
-    while (*wzKey)
-    {
-        result = ~(*wzKey++ * 509) + result * 65599;
-    }
+    return result;
+}
 
-    *pdwHash = result % dwNumBuckets;
+static WCHAR FoldChar(
+    __in WCHAR wc
+    )
+{
+    WCHAR wcFolded = wc;
 
-LExit:
-    ReleaseStr(sczNewKey);
+    if (wc < countof(ASCII_FOLD))
+    {
+        wcFolded = ASCII_FOLD[wc];
+    }
+    else if (1 != ::LCMapStringW(LOCALE_INVARIANT, LCMAP_UPPERCASE, &wc, 1, &wcFolded, 1))
+    {
+        // Characters that don't map to a single character hash as themselves.
+        wcFolded = wc;
+    }
 
-    return hr;
+    return wcFolded;
 }
 
 static BOOL IsMatchExact(
     __in const STRINGDICT_STRUCT *psd,
     __in DWORD dwMatchIndex,
+    __in DWORD dwHash,
     __in_z LPCWSTR wzOriginalString
     )
 {
-    LPCWSTR wzMatchString = GetKey(psd, TranslateOffsetToValue(psd, psd->ppvBuckets[dwMatchIndex]));
+    const DICT_BUCKET *pBucket = psd->rgBuckets + dwMatchIndex;
+    LPCWSTR wzMatchString = NULL;
     DWORD dwFlags = 0;
 
+    // Different hashes can never be equal keys, so only fall through to the string compare on a full hash match.
+    if (dwHash != pBucket->dwHash)
+    {
+        return FALSE;
+    }
+
+    wzMatchString = GetKey(psd, TranslateOffsetToValue(psd, pBucket->pvValue));
+
     if (DICT_FLAG_CASEINSENSITIVE & psd->dfFlags)
     {
         dwFlags |= NORM_IGNORECASE;
@@ -518,37 +543,12 @@ static HRESULT GetValue(
     )
 {
     HRESULT hr = S_OK;
-    DWORD dwOriginalIndexCandidate = 0;
-    void *pvCandidateValue = NULL;
     DWORD dwIndex = 0;
 
     ExitOnNull(psd, hr, E_INVALIDARG, "Handle not specified while searching dict");
     ExitOnNull(pszString, hr, E_INVALIDARG, "String not specified while searching dict");
 
-    if (psd->dwBucketSizeIndex >= countof(MAX_BUCKET_SIZES))
-    {
-        hr = E_INVALIDARG;
-        ExitOnFailure(hr, "Invalid dictionary - bucket size index is out of range");
-    }
-
-    hr = StringHash(psd, MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], pszString, &dwOriginalIndexCandidate);
-    ExitOnFailure(hr, "Failed to hash the string.");
-
-    DWORD dwIndexCandidate = dwOriginalIndexCandidate;
-
-    pvCandidateValue = TranslateOffsetToValue(psd, psd->ppvBuckets[dwIndexCandidate]);
-
-    // If no match exists in the dict
-    if (NULL == pvCandidateValue)
-    {
-        if (NULL != ppvValue)
-        {
-            *ppvValue = NULL;
-        }
-        ExitFunction1(hr = E_NOTFOUND);
-    }
-
-    hr = GetIndex(psd, pszString, &dwIndex);
+    hr = GetIndex(psd, StringHash(psd, pszString), pszString, &dwIndex);
     if (E_NOTFOUND == hr)
     {
         ExitFunction();
@@ -557,7 +557,7 @@ static HRESULT GetValue(
 
     if (NULL != ppvValue)
     {
-        *ppvValue = TranslateOffsetToValue(psd, psd->ppvBuckets[dwIndex]);
+        *ppvValue = TranslateOffsetToValue(psd, psd->rgBuckets[dwIndex].pvValue);
     }
 
 LExit:
@@ -570,25 +570,21 @@ LExit:
 }
 
 static HRESULT GetInsertIndex(
-    __in const STRINGDICT_STRUCT *psd,
     __in DWORD dwBucketCount,
-    __in void **ppvBuckets,
-    __in_z LPCWSTR pszString,
+    __in DICT_BUCKET *rgBuckets,
+    __in DWORD dwHash,
+    __in_z_opt LPCWSTR pszString,
     __out DWORD *pdwOutput
     )
 {
     HRESULT hr = S_OK;
-    DWORD dwOriginalIndexCandidate = 0;
-
-    hr = StringHash(psd, dwBucketCount, pszString, &dwOriginalIndexCandidate);
-    ExitOnFailure(hr, "Failed to hash the string.");
-
+    DWORD dwOriginalIndexCandidate = dwHash % dwBucketCount;
     DWORD dwIndexCandidate = dwOriginalIndexCandidate;
 
     // If we collide, keep iterating forward from our intended position, even wrapping around to zero, until we find an empty bucket
 #pragma prefast(push)
 #pragma prefast(disable:26007)
-    while (NULL != ppvBuckets[dwIndexCandidate])
+    while (NULL != rgBuckets[dwIndexCandidate].pvValue)
 #pragma prefast(pop)
     {
         ++dwIndexCandidate;
@@ -604,7 +600,7 @@ static HRESULT GetInsertIndex(
         {
             // The dict table is full - this error seems to be a reasonably close match 
             hr = HRESULT_FROM_WIN32(ERROR_DATABASE_FULL);
-            ExitOnRootFailure(hr, "Failed to add item '%ls' to dict table because dict table is full of items", pszString);
+            ExitOnRootFailure(hr, "Failed to add item '%ls' to dict table because dict table is full of items", pszString ? pszString : L"");
         }
     }
 
@@ -616,12 +612,15 @@ LExit:
 
 static HRESULT GetIndex(
     __in const STRINGDICT_STRUCT *psd,
+    __in DWORD dwHash,
     __in_z LPCWSTR pszString,
     __out DWORD *pdwOutput
     )
 {
     HRESULT hr = S_OK;
+    DWORD dwBucketCount = 0;
     DWORD dwOriginalIndexCandidate = 0;
+    DWORD dwIndexCandidate = 0;
 
     if (psd->dwBucketSizeIndex >= countof(MAX_BUCKET_SIZES))
     {
@@ -629,35 +628,35 @@ static HRESULT GetIndex(
         ExitOnFailure(hr, "Invalid dictionary - bucket size index is out of range");
     }
 
-    hr = StringHash(psd, MAX_BUCKET_SIZES[psd->dwBucketSizeIndex], pszString, &dwOriginalIndexCandidate);
-    ExitOnFailure(hr, "Failed to hash the string.");
-
-    DWORD dwIndexCandidate = dwOriginalIndexCandidate;
+    dwBucketCount = MAX_BUCKET_SIZES[psd->dwBucketSizeIndex];
+    dwOriginalIndexCandidate = dwHash % dwBucketCount;
+    dwIndexCandidate = dwOriginalIndexCandidate;
 
-    while (!IsMatchExact(psd, dwIndexCandidate, pszString))
+    // An empty bucket ends the probe run, so the key isn't in the dict
+    while (NULL != psd->rgBuckets[dwIndexCandidate].pvValue)
     {
+        if (IsMatchExact(psd, dwIndexCandidate, dwHash, pszString))
+        {
+            *pdwOutput = dwIndexCandidate;
+            ExitFunction();
+        }
+
         ++dwIndexCandidate;
 
         // If we got to the end of the array, wrap around to zero index
-        if (dwIndexCandidate >= MAX_BUCKET_SIZES[psd->dwBucketSizeIndex])
+        if (dwIndexCandidate >= dwBucketCount)
         {
             dwIndexCandidate = 0;
         }
 
-        // If no match exists in the dict
-        if (NULL == psd->ppvBuckets[dwIndexCandidate])
-        {
-            ExitFunction1(hr = E_NOTFOUND);
-        }
-
         // If we wrapped all the way back around to our original index, the dict is full and we found nothing, so return as such
         if (dwIndexCandidate == dwOriginalIndexCandidate)
         {
-            ExitFunction1(hr = E_NOTFOUND);
+            break;
         }
     }
 
-    *pdwOutput = dwIndexCandidate;
+    hr = E_NOTFOUND;
 
 LExit:
     return hr;
@@ -685,16 +684,46 @@ static LPCWSTR GetKey(
     }
 }
 
+static HRESULT EnsureCapacity(
+    __inout STRINGDICT_STRUCT *psd
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (psd->dwBucketSizeIndex >= countof(MAX_BUCKET_SIZES))
+    {
+        hr = E_INVALIDARG;
+        ExitOnFailure(hr, "Invalid dictionary - bucket size index is out of range");
+    }
+
+    if ((psd->dwNumItems + 1) >= MAX_BUCKET_SIZES[psd->dwBucketSizeIndex] / MAX_BUCKETS_TO_ITEMS_RATIO)
+    {
+        hr = GrowDictionary(psd);
+        if (HRESULT_FROM_WIN32(ERROR_DATABASE_FULL) == hr)
+        {
+            // If we fail to proactively grow the dictionary, don't fail unless the dictionary is completely full
+            if (psd->dwNumItems + 1 < MAX_BUCKET_SIZES[psd->dwBucketSizeIndex])
+            {
+                hr = S_OK;
+            }
+        }
+        ExitOnFailure(hr, "Failed to grow dictionary");
+    }
+
+LExit:
+    return hr;
+}
+
 static HRESULT GrowDictionary(
     __inout STRINGDICT_STRUCT *psd
     )
 {
     HRESULT hr = S_OK;
     DWORD dwInsertIndex = 0;
-    LPCWSTR wzKey = NULL;
     DWORD dwNewBucketSizeIndex = 0;
     size_t cbAllocSize = 0;
-    void **ppvNewBuckets = NULL;
+    DICT_BUCKET *rgNewBuckets = NULL;
+    const DWORD dwOldBucketCount = MAX_BUCKET_SIZES[psd->dwBucketSizeIndex];
 
     dwNewBucketSizeIndex = psd->dwBucketSizeIndex + 1;
 
@@ -703,30 +732,33 @@ static HRESULT GrowDictionary(
         ExitFunction1(hr = HRESULT_FROM_WIN32(ERROR_DATABASE_FULL));
     }
 
-    hr = ::SizeTMult(sizeof(void *), MAX_BUCKET_SIZES[dwNewBucketSizeIndex], &cbAllocSize);
+    hr = ::SizeTMult(sizeof(DICT_BUCKET), MAX_BUCKET_SIZES[dwNewBucketSizeIndex], &cbAllocSize);
     ExitOnFailure(hr, "Overflow while calculating allocation size to grow dictionary");
 
-    ppvNewBuckets = static_cast<void**>(MemAlloc(cbAllocSize, TRUE));
-    ExitOnNull(ppvNewBuckets, hr, E_OUTOFMEMORY, "Failed to allocate %u buckets while growing dictionary", MAX_BUCKET_SIZES[dwNewBucketSizeIndex]);
+    rgNewBuckets = static_cast<DICT_BUCKET*>(MemAlloc(cbAllocSize, TRUE));
+    ExitOnNull(rgNewBuckets, hr, E_OUTOFMEMORY, "Failed to allocate %u buckets while growing dictionary", MAX_BUCKET_SIZES[dwNewBucketSizeIndex]);
 
-    for (DWORD i = 0; i < psd->dwNumItems; ++i)
+    // Rehash from the cached hashes, so no key is touched while growing.
+    for (DWORD i = 0; i < dwOldBucketCount; ++i)
     {
-        wzKey = GetKey(psd, TranslateOffsetToValue(psd, psd->ppvItemList[i]));
-        ExitOnNull(wzKey, hr, E_INVALIDARG, "String not specified in existing dict value");
+        const DICT_BUCKET *pBucket = psd->rgBuckets + i;
 
-        hr = GetInsertIndex(psd, MAX_BUCKET_SIZES[dwNewBucketSizeIndex], ppvNewBuckets, wzKey, &dwInsertIndex);
-        ExitOnFailure(hr, "Failed to get index to insert into");
+        if (NULL != pBucket->pvValue)
+        {
+            hr = GetInsertIndex(MAX_BUCKET_SIZES[dwNewBucketSizeIndex], rgNewBuckets, pBucket->dwHash, NULL, &dwInsertIndex);
+            ExitOnFailure(hr, "Failed to get index to insert into");
 
-        ppvNewBuckets[dwInsertIndex] = psd->ppvItemList[i];
+            rgNewBuckets[dwInsertIndex] = *pBucket;
+        }
     }
 
     psd->dwBucketSizeIndex = dwNewBucketSizeIndex;
-    ReleaseMem(psd->ppvBuckets);
-    psd->ppvBuckets = ppvNewBuckets;
-    ppvNewBuckets = NULL;
+    ReleaseMem(psd->rgBuckets);
+    psd->rgBuckets = rgNewBuckets;
+    rgNewBuckets = NULL;
 
 LExit:
-    ReleaseMem(ppvNewBuckets);
+    ReleaseMem(rgNewBuckets);
 
     return hr;
 }
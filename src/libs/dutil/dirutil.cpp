@@ -2,6 +2,46 @@
 
 #include "precomp.h"
 
+#ifndef FIND_FIRST_EX_LARGE_FETCH
+#define FIND_FIRST_EX_LARGE_FETCH 0x00000002
+#endif
+
+// Cleared the first time FindFirstFileExW rejects the basic info level or large fetch (before Windows 7).
+static volatile BOOL vfFindExBasic = TRUE;
+
+struct DIR_ENUMERATE_CHILDREN
+{
+    HRESULT hr;
+    LPWSTR* rgsczChildren;
+    DWORD cChildren;
+};
+
+struct DIR_ENUMERATE_LEVEL
+{
+    LPWSTR* rgsczDirectories;
+    DIR_ENUMERATE_CHILDREN* rgChildren;
+    DWORD cDirectories;
+    volatile LONG iNext;
+    volatile LONG fFailed;
+};
+
+static HRESULT EnumerateLevel(
+    __in DIR_ENUMERATE_LEVEL* pLevel,
+    __in DWORD cMaxThreads
+    );
+static DWORD WINAPI EnumerateLevelThreadProc(
+    __in LPVOID pvContext
+    );
+static HRESULT EnumerateChildDirectories(
+    __in_z LPCWSTR wzPath,
+    __deref_out_ecount_opt(*pcChildren) LPWSTR** prgsczChildren,
+    __out DWORD* pcChildren
+    );
+static int __cdecl CompareDirectories(
+    __in const void* pvLeft,
+    __in const void* pvRight
+    );
+
 
 /*******************************************************************
  DirExists
@@ -337,6 +377,129 @@ LExit:
 }
 
 
+/*******************************************************************
+ DirEnumerateTree - finds the directory and every directory below it.
+
+ NOTE: The directories are backslash terminated and breadth first, so
+       every directory comes after its parent and reversing the list
+       puts every directory before its parent. Children are sorted by
+       name within their parent so the order doesn't depend on the file
+       system or the number of threads. Directories that disappear during
+       the walk are skipped and S_FALSE is returned if wzPath doesn't
+       exist. Free the directories with ReleaseStrArray.
+*******************************************************************/
+extern "C" HRESULT DAPI DirEnumerateTree(
+    __in_z LPCWSTR wzPath,
+    __in DWORD cMaxThreads,
+    __deref_out_ecount_opt(*pcDirectories) LPWSTR** prgsczDirectories,
+    __out DWORD* pcDirectories
+    )
+{
+    Assert(wzPath && *wzPath && prgsczDirectories && pcDirectories);
+
+    HRESULT hr = S_OK;
+    SYSTEM_INFO si = { };
+    LPWSTR* rgsczDirectories = NULL;
+    DWORD cDirectories = 0;
+    DWORD iLevel = 0;
+    DWORD cLevel = 0;
+    DWORD cFound = 0;
+    DIR_ENUMERATE_LEVEL level = { };
+
+    if (0 == cMaxThreads)
+    {
+        ::GetSystemInfo(&si);
+        cMaxThreads = min(si.dwNumberOfProcessors, DIR_ENUMERATE_DEFAULT_MAX_THREADS);
+    }
+
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&rgsczDirectories), 1, sizeof(LPWSTR), 64);
+    ExitOnFailure(hr, "Failed to allocate directories.");
+
+    hr = StrAllocString(&rgsczDirectories[0], wzPath, 0);
+    ExitOnFailure(hr, "Failed to copy path: %ls", wzPath);
+
+    cDirectories = 1;
+
+    hr = PathBackslashTerminate(&rgsczDirectories[0]);
+    ExitOnFailure(hr, "Failed to backslash terminate path: %ls", wzPath);
+
+    // Each level is enumerated in parallel, then its children become the next level in order.
+    for (cLevel = 1; cLevel; iLevel += cLevel, cLevel = cDirectories - iLevel)
+    {
+        level.rgsczDirectories = rgsczDirectories + iLevel;
+        level.cDirectories = cLevel;
+        level.iNext = 0;
+        level.fFailed = FALSE;
+
+        level.rgChildren = static_cast<DIR_ENUMERATE_CHILDREN*>(MemAlloc(sizeof(DIR_ENUMERATE_CHILDREN) * cLevel, TRUE));
+        ExitOnNull(level.rgChildren, hr, E_OUTOFMEMORY, "Failed to allocate children of %u directories.", cLevel);
+
+        hr = EnumerateLevel(&level, cMaxThreads);
+        ExitOnFailure(hr, "Failed to enumerate directories under: %ls", wzPath);
+
+        for (DWORD i = 0; i < cLevel; ++i)
+        {
+            DIR_ENUMERATE_CHILDREN* pChildren = level.rgChildren + i;
+
+            if (S_FALSE == pChildren->hr)
+            {
+                ReleaseNullStr(level.rgsczDirectories[i]);
+            }
+
+            if (pChildren->cChildren)
+            {
+                hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&rgsczDirectories), cDirectories + pChildren->cChildren, sizeof(LPWSTR), 1024);
+                ExitOnFailure(hr, "Failed to grow directories.");
+
+                level.rgsczDirectories = rgsczDirectories + iLevel;
+
+                // The strings now belong to the directories.
+                memcpy(rgsczDirectories + cDirectories, pChildren->rgsczChildren, sizeof(LPWSTR) * pChildren->cChildren);
+                cDirectories += pChildren->cChildren;
+
+                ReleaseNullMem(pChildren->rgsczChildren);
+                pChildren->cChildren = 0;
+            }
+        }
+
+        ReleaseNullMem(level.rgChildren);
+    }
+
+    // Squeeze out the directories that disappeared.
+    for (DWORD i = 0; i < cDirectories; ++i)
+    {
+        if (rgsczDirectories[i])
+        {
+            rgsczDirectories[cFound] = rgsczDirectories[i];
+            ++cFound;
+        }
+    }
+
+    cDirectories = cFound;
+    hr = cDirectories ? S_OK : S_FALSE;
+
+    *prgsczDirectories = rgsczDirectories;
+    rgsczDirectories = NULL;
+    *pcDirectories = cDirectories;
+    cDirectories = 0;
+
+LExit:
+    if (level.rgChildren)
+    {
+        for (DWORD i = 0; i < level.cDirectories; ++i)
+        {
+            ReleaseStrArray(level.rgChildren[i].rgsczChildren, level.rgChildren[i].cChildren);
+        }
+
+        MemFree(level.rgChildren);
+    }
+
+    ReleaseStrArray(rgsczDirectories, cDirectories);
+
+    return hr;
+}
+
+
 /*******************************************************************
  DirGetCurrent - gets the current directory.
 
@@ -393,3 +556,177 @@ extern "C" HRESULT DAPI DirSetCurrent(
 LExit:
     return hr;
 }
+
+
+// internal helper functions
+
+static HRESULT EnumerateLevel(
+    __in DIR_ENUMERATE_LEVEL* pLevel,
+    __in DWORD cMaxThreads
+    )
+{
+    HRESULT hr = S_OK;
+    HANDLE rghThreads[MAXIMUM_WAIT_OBJECTS] = { };
+    DWORD cThreads = 0;
+    DWORD cWorkers = min(min(cMaxThreads, pLevel->cDirectories), static_cast<DWORD>(MAXIMUM_WAIT_OBJECTS) + 1);
+
+    // The calling thread is one of the workers, so a single directory or thread never starts a thread.
+    for (DWORD i = 1; i < cWorkers; ++i)
+    {
+        rghThreads[cThreads] = ::CreateThread(NULL, 0, EnumerateLevelThreadProc, pLevel, 0, NULL);
+        if (!rghThreads[cThreads])
+        {
+            // Fewer threads only makes the walk slower.
+            TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to create directory enumeration thread.");
+            break;
+        }
+
+        ++cThreads;
+    }
+
+    EnumerateLevelThreadProc(pLevel);
+
+    if (cThreads && WAIT_OBJECT_0 != ::WaitForMultipleObjects(cThreads, rghThreads, TRUE, INFINITE))
+    {
+        ExitWithLastError(hr, "Failed to wait for directory enumeration threads.");
+    }
+
+    // Report the first failure in order so the result doesn't depend on the threads.
+    for (DWORD i = 0; i < pLevel->cDirectories; ++i)
+    {
+        hr = pLevel->rgChildren[i].hr;
+        ExitOnFailure(hr, "Failed to enumerate directory: %ls", pLevel->rgsczDirectories[i]);
+    }
+
+    hr = S_OK;
+
+LExit:
+    for (DWORD i = 0; i < cThreads; ++i)
+    {
+        ReleaseHandle(rghThreads[i]);
+    }
+
+    return hr;
+}
+
+static DWORD WINAPI EnumerateLevelThreadProc(
+    __in LPVOID pvContext
+    )
+{
+    DIR_ENUMERATE_LEVEL* pLevel = static_cast<DIR_ENUMERATE_LEVEL*>(pvContext);
+    LONG i = 0;
+
+    while (!pLevel->fFailed && static_cast<DWORD>(i = ::InterlockedIncrement(&pLevel->iNext) - 1) < pLevel->cDirectories)
+    {
+        DIR_ENUMERATE_CHILDREN* pChildren = pLevel->rgChildren + i;
+
+        pChildren->hr = EnumerateChildDirectories(pLevel->rgsczDirectories[i], &pChildren->rgsczChildren, &pChildren->cChildren);
+        if (FAILED(pChildren->hr))
+        {
+            ::InterlockedExchange(&pLevel->fFailed, TRUE);
+        }
+    }
+
+    return 0;
+}
+
+static HRESULT EnumerateChildDirectories(
+    __in_z LPCWSTR wzPath,
+    __deref_out_ecount_opt(*pcChildren) LPWSTR** prgsczChildren,
+    __out DWORD* pcChildren
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+    LPWSTR sczSearch = NULL;
+    HANDLE hFind = INVALID_HANDLE_VALUE;
+    WIN32_FIND_DATAW wfd = { };
+    LPWSTR* rgsczChildren = NULL;
+    DWORD cChildren = 0;
+
+    hr = StrAllocFormatted(&sczSearch, L"%ls*", wzPath);
+    ExitOnFailure(hr, "Failed to allocate search string for path: %ls", wzPath);
+
+    // Only the names and attributes are needed, so skip the short names and fetch in bigger batches.
+    if (vfFindExBasic)
+    {
+        hFind = ::FindFirstFileExW(sczSearch, FindExInfoBasic, &wfd, FindExSearchLimitToDirectories, NULL, FIND_FIRST_EX_LARGE_FETCH);
+        if (INVALID_HANDLE_VALUE == hFind && ERROR_INVALID_PARAMETER == ::GetLastError())
+        {
+            vfFindExBasic = FALSE;
+        }
+    }
+
+    if (!vfFindExBasic)
+    {
+        hFind = ::FindFirstFileExW(sczSearch, FindExInfoStandard, &wfd, FindExSearchLimitToDirectories, NULL, 0);
+    }
+
+    if (INVALID_HANDLE_VALUE == hFind)
+    {
+        er = ::GetLastError();
+        if (ERROR_PATH_NOT_FOUND == er || ERROR_FILE_NOT_FOUND == er)
+        {
+            ExitFunction1(hr = ERROR_PATH_NOT_FOUND == er ? S_FALSE : S_OK);
+        }
+
+        ExitOnWin32Error(er, hr, "Failed to find directories in path: %ls", wzPath);
+    }
+
+    do
+    {
+        // Limiting the search to directories is only a hint, so skip files and the dot directories.
+        if (FILE_ATTRIBUTE_DIRECTORY != (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || L'.' == wfd.cFileName[0] && (L'\0' == wfd.cFileName[1] || (L'.' == wfd.cFileName[1] && L'\0' == wfd.cFileName[2])))
+        {
+            continue;
+        }
+
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&rgsczChildren), cChildren + 1, sizeof(LPWSTR), 16);
+        ExitOnFailure(hr, "Failed to grow child directories of path: %ls", wzPath);
+
+        hr = StrAllocFormatted(&rgsczChildren[cChildren], L"%ls%ls\\", wzPath, wfd.cFileName);
+        ExitOnFailure(hr, "Failed to concat directory '%ls' to path: %ls", wfd.cFileName, wzPath);
+
+        ++cChildren;
+    } while (::FindNextFileW(hFind, &wfd));
+
+    er = ::GetLastError();
+    if (ERROR_NO_MORE_FILES != er)
+    {
+        ExitOnWin32Error(er, hr, "Failed while looping through directories in path: %ls", wzPath);
+    }
+
+    hr = S_OK;
+
+    if (1 < cChildren)
+    {
+        qsort(rgsczChildren, cChildren, sizeof(LPWSTR), CompareDirectories);
+    }
+
+    *prgsczChildren = rgsczChildren;
+    rgsczChildren = NULL;
+    *pcChildren = cChildren;
+    cChildren = 0;
+
+LExit:
+    if (INVALID_HANDLE_VALUE != hFind)
+    {
+        ::FindClose(hFind);
+    }
+
+    ReleaseStrArray(rgsczChildren, cChildren);
+    ReleaseStr(sczSearch);
+
+    return hr;
+}
+
+static int __cdecl CompareDirectories(
+    __in const void* pvLeft,
+    __in const void* pvRight
+    )
+{
+    LPCWSTR wzLeft = *static_cast<const LPCWSTR*>(pvLeft);
+    LPCWSTR wzRight = *static_cast<const LPCWSTR*>(pvRight);
+
+    return ::CompareStringW(LOCALE_INVARIANT, NORM_IGNORECASE, wzLeft, -1, wzRight, -1) - CSTR_EQUAL;
+}
@@ -10,6 +10,52 @@ const BYTE UTF16BOM[] = {0xFF, 0xFE};
 const LPCWSTR REGISTRY_PENDING_FILE_RENAME_KEY = L"SYSTEM\\CurrentControlSet\\Control\\Session Manager";
 const LPCWSTR REGISTRY_PENDING_FILE_RENAME_VALUE = L"PendingFileRenameOperations";
 
+// PrefetchVirtualMemory is only available starting with Windows 8 so it is looked up at runtime.
+typedef struct _FILE_MEMORY_RANGE_ENTRY
+{
+    PVOID VirtualAddress;
+    SIZE_T NumberOfBytes;
+} FILE_MEMORY_RANGE_ENTRY;
+typedef BOOL (WINAPI *PFN_PREFETCHVIRTUALMEMORY)(HANDLE, ULONG_PTR, FILE_MEMORY_RANGE_ENTRY*, ULONG);
+
+static HRESULT MapViewWindow(
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __in SIZE_T cb
+    );
+static HRESULT CopyFromView(
+    __out_bcount(cb) LPVOID pvDestination,
+    __in_bcount(cb) const BYTE* pbSource,
+    __in SIZE_T cb
+    );
+static HRESULT BeginCopyRead(
+    __in HANDLE hFile,
+    __out_bcount(cb) BYTE* pb,
+    __in DWORD cb,
+    __in DWORD64 qwOffset,
+    __in OVERLAPPED* pOverlapped,
+    __out BOOL* pfPending
+    );
+static HRESULT BeginCopyWrite(
+    __in HANDLE hFile,
+    __in_bcount(cb) const BYTE* pb,
+    __in DWORD cb,
+    __in DWORD64 qwOffset,
+    __in OVERLAPPED* pOverlapped,
+    __out BOOL* pfPending
+    );
+static HRESULT EndCopyIo(
+    __in HANDLE hFile,
+    __in OVERLAPPED* pOverlapped,
+    __inout BOOL* pfPending,
+    __out DWORD* pcbTransferred
+    );
+static void CancelCopyIo(
+    __in HANDLE hFile,
+    __in OVERLAPPED* pOverlapped,
+    __inout BOOL* pfPending
+    );
+
 /*******************************************************************
  FileFromPath -  returns a pointer to the file part of the path
 
@@ -597,6 +643,165 @@ LExit:
 }
 
 
+/*******************************************************************
+ FileMappedViewInitialize - creates a read-only mapping of a file that
+                            is viewed at most cbWindowMax bytes at a time.
+
+ NOTE: pass 0 for cbWindowMax to use FILE_MAPPED_VIEW_DEFAULT_WINDOW.
+********************************************************************/
+extern "C" HRESULT DAPI FileMappedViewInitialize(
+    __in FILE_MAPPED_VIEW* pView,
+    __in HANDLE hFile,
+    __in SIZE_T cbWindowMax
+    )
+{
+    HRESULT hr = S_OK;
+    LARGE_INTEGER li = { };
+    SYSTEM_INFO si = { };
+
+    memset(pView, 0, sizeof(FILE_MAPPED_VIEW));
+
+    if (!::GetFileSizeEx(hFile, &li))
+    {
+        ExitWithLastError(hr, "Failed to get size of file to map.");
+    }
+
+    if (0 == li.QuadPart)
+    {
+        // An empty file cannot be mapped.
+        ExitFunction1(hr = HRESULT_FROM_WIN32(ERROR_FILE_INVALID));
+    }
+
+    pView->hMapping = ::CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    ExitOnNullWithLastError(pView->hMapping, hr, "Failed to create file mapping.");
+
+    // Windows always start on the allocation granularity so the window must be at least that large.
+    ::GetSystemInfo(&si);
+
+    pView->qwFileSize = static_cast<DWORD64>(li.QuadPart);
+    pView->cbWindowMax = max(0 == cbWindowMax ? FILE_MAPPED_VIEW_DEFAULT_WINDOW : cbWindowMax, 2 * si.dwAllocationGranularity);
+
+LExit:
+    if (FAILED(hr))
+    {
+        FileMappedViewUninitialize(pView);
+    }
+
+    return hr;
+}
+
+
+/*******************************************************************
+ FileMappedViewGet - returns a pointer to cb bytes of the file starting
+                     at qwOffset, moving the window if necessary.
+
+ NOTE: the pointer is only valid until the next call with the view.
+********************************************************************/
+extern "C" HRESULT DAPI FileMappedViewGet(
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __in SIZE_T cb,
+    __deref_out_bcount(cb) const BYTE** ppb
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (qwOffset > pView->qwFileSize || cb > pView->qwFileSize - qwOffset)
+    {
+        ExitOnFailure(hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF), "Cannot view past the end of the mapped file.");
+    }
+
+    if (!pView->pbWindow || qwOffset < pView->qwWindowOffset || qwOffset + cb > pView->qwWindowOffset + pView->cbWindow)
+    {
+        hr = MapViewWindow(pView, qwOffset, cb);
+        ExitOnFailure(hr, "Failed to map view of file at offset: %I64u", qwOffset);
+    }
+
+    *ppb = pView->pbWindow + (qwOffset - pView->qwWindowOffset);
+
+LExit:
+    return hr;
+}
+
+
+/*******************************************************************
+ FileMappedViewRead - copies up to cb bytes of the file starting at
+                      qwOffset, stopping at the end of the file.
+
+********************************************************************/
+extern "C" HRESULT DAPI FileMappedViewRead(
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __out_bcount_part(cb, *pcbRead) LPVOID pv,
+    __in SIZE_T cb,
+    __out SIZE_T* pcbRead
+    )
+{
+    HRESULT hr = S_OK;
+    BYTE* pbDestination = static_cast<BYTE*>(pv);
+    const BYTE* pbSource = NULL;
+    SIZE_T cbChunk = 0;
+
+    *pcbRead = 0;
+
+    if (qwOffset >= pView->qwFileSize)
+    {
+        ExitFunction();
+    }
+
+    if (cb > pView->qwFileSize - qwOffset)
+    {
+        cb = static_cast<SIZE_T>(pView->qwFileSize - qwOffset);
+    }
+
+    // Copy a window at a time so reads larger than the window still succeed.
+    while (cb)
+    {
+        if (pView->pbWindow && qwOffset >= pView->qwWindowOffset && qwOffset < pView->qwWindowOffset + pView->cbWindow)
+        {
+            cbChunk = min(cb, static_cast<SIZE_T>(pView->qwWindowOffset + pView->cbWindow - qwOffset));
+        }
+        else
+        {
+            cbChunk = min(cb, pView->cbWindowMax / 2);
+        }
+
+        hr = FileMappedViewGet(pView, qwOffset, cbChunk, &pbSource);
+        ExitOnFailure(hr, "Failed to get view of file to read.");
+
+        hr = CopyFromView(pbDestination, pbSource, cbChunk);
+        ExitOnFailure(hr, "Failed to read from view of file at offset: %I64u", qwOffset);
+
+        pbDestination += cbChunk;
+        qwOffset += cbChunk;
+        cb -= cbChunk;
+        *pcbRead += cbChunk;
+    }
+
+LExit:
+    return hr;
+}
+
+
+/*******************************************************************
+ FileMappedViewUninitialize
+
+********************************************************************/
+extern "C" void DAPI FileMappedViewUninitialize(
+    __in FILE_MAPPED_VIEW* pView
+    )
+{
+    if (pView->pbWindow)
+    {
+        ::UnmapViewOfFile(pView->pbWindow);
+    }
+
+    ReleaseHandle(pView->hMapping);
+
+    memset(pView, 0, sizeof(FILE_MAPPED_VIEW));
+}
+
+
 /*******************************************************************
  FileExistsEx
 
@@ -1057,27 +1262,69 @@ extern "C" HRESULT DAPI FileCopyUsingHandles(
     __in DWORD64 cbCopy,
     __out_opt DWORD64* pcbCopied
     )
+{
+    return FileCopyUsingHandlesEx(hSource, hTarget, cbCopy, 0, NULL, NULL, pcbCopied);
+}
+
+
+/*******************************************************************
+ FileCopyUsingHandlesEx - copies from the current position of the source
+                          handle to the current position of the target
+                          handle using a buffer of cbBuffer bytes (0 for
+                          the default).
+
+ NOTE: cbCopy of 0 copies until the end of the source.
+*******************************************************************/
+extern "C" HRESULT DAPI FileCopyUsingHandlesEx(
+    __in HANDLE hSource,
+    __in HANDLE hTarget,
+    __in DWORD64 cbCopy,
+    __in DWORD cbBuffer,
+    __in_opt PFN_FILE_COPY_PROGRESS pfnProgress,
+    __in_opt LPVOID pvContext,
+    __out_opt DWORD64* pcbCopied
+    )
 {
     HRESULT hr = S_OK;
     DWORD64 cbTotalCopied = 0;
-    BYTE rgbData[4 * 1024];
+    BYTE* pbData = NULL;
     DWORD cbRead = 0;
 
+    if (0 == cbBuffer)
+    {
+        cbBuffer = FILE_COPY_DEFAULT_BUFFER;
+    }
+
+    // Don't allocate more than a small copy needs.
+    if (cbCopy && cbCopy < cbBuffer)
+    {
+        cbBuffer = static_cast<DWORD>(cbCopy);
+    }
+
+    pbData = static_cast<BYTE*>(MemAlloc(cbBuffer, FALSE));
+    ExitOnNull(pbData, hr, E_OUTOFMEMORY, "Failed to allocate copy buffer.");
+
     do
     {
-        cbRead = static_cast<DWORD>((0 == cbCopy) ? countof(rgbData) : min(countof(rgbData), cbCopy - cbTotalCopied));
-        if (!::ReadFile(hSource, rgbData, cbRead, &cbRead, NULL))
+        cbRead = static_cast<DWORD>((0 == cbCopy) ? cbBuffer : min(cbBuffer, cbCopy - cbTotalCopied));
+        if (!::ReadFile(hSource, pbData, cbRead, &cbRead, NULL))
         {
             ExitWithLastError(hr, "Failed to read from source.");
         }
 
         if (cbRead)
         {
-            hr = FileWriteHandle(hTarget, rgbData, cbRead);
+            hr = FileWriteHandle(hTarget, pbData, cbRead);
             ExitOnFailure(hr, "Failed to write to target.");
-        }
 
-        cbTotalCopied += cbRead;
+            cbTotalCopied += cbRead;
+
+            if (pfnProgress)
+            {
+                hr = pfnProgress(cbTotalCopied, cbCopy, pvContext);
+                ExitOnFailure(hr, "Copy was canceled by progress callback.");
+            }
+        }
     } while (cbTotalCopied < cbCopy && 0 != cbRead);
 
     if (pcbCopied)
@@ -1086,6 +1333,204 @@ extern "C" HRESULT DAPI FileCopyUsingHandles(
     }
 
 LExit:
+    ReleaseMem(pbData);
+
+    return hr;
+}
+
+
+/*******************************************************************
+ FileCopy - copies a file with two large buffers so the next block is
+            read while the previous one is written.
+
+ NOTE: Files of at least FILE_COPY_UNBUFFERED_THRESHOLD bytes bypass the
+       system cache when FILE_COPY_FLAGS_UNBUFFERED is set. The target is
+       deleted if the copy fails.
+*******************************************************************/
+extern "C" HRESULT DAPI FileCopy(
+    __in_z LPCWSTR wzSource,
+    __in_z LPCWSTR wzTarget,
+    __in DWORD dwFlags,
+    __in DWORD cbBuffer,
+    __in_opt PFN_FILE_COPY_PROGRESS pfnProgress,
+    __in_opt LPVOID pvContext,
+    __out_opt DWORD64* pcbCopied
+    )
+{
+    HRESULT hr = S_OK;
+    HANDLE hSource = INVALID_HANDLE_VALUE;
+    HANDLE hTarget = INVALID_HANDLE_VALUE;
+    BOOL fTargetCreated = FALSE;
+    BOOL fUnbuffered = FALSE;
+    LONGLONG llSize = 0;
+    FILETIME ftLastWrite = { };
+    LARGE_INTEGER li = { };
+    BYTE* pbBuffers = NULL;
+    BYTE* rgpbBuffer[2] = { };
+    OVERLAPPED rgReadOverlapped[2] = { };
+    OVERLAPPED rgWriteOverlapped[2] = { };
+    BOOL rgfReadPending[2] = { };
+    BOOL rgfWritePending[2] = { };
+    DWORD64 qwReadOffset = 0;
+    DWORD64 qwCopied = 0;
+    DWORD iBuffer = 0;
+    DWORD cbRead = 0;
+    DWORD cbWrite = 0;
+    DWORD cbWritten = 0;
+
+    if (0 == cbBuffer)
+    {
+        cbBuffer = FILE_COPY_DEFAULT_BUFFER;
+    }
+
+    // Unbuffered I/O has to start on and transfer whole sectors, so keep every block a multiple of the alignment.
+    cbBuffer = (cbBuffer + FILE_COPY_ALIGNMENT - 1) & ~static_cast<DWORD>(FILE_COPY_ALIGNMENT - 1);
+
+    hr = FileSize(wzSource, &llSize);
+    ExitOnFailure(hr, "Failed to get size of source file: %ls", wzSource);
+
+    fUnbuffered = (dwFlags & FILE_COPY_FLAGS_UNBUFFERED) && FILE_COPY_UNBUFFERED_THRESHOLD <= llSize;
+
+    hSource = ::CreateFileW(wzSource, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | (fUnbuffered ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN), NULL);
+    ExitOnInvalidHandleWithLastError(hSource, hr, "Failed to open source file: %ls", wzSource);
+
+    if (!::GetFileTime(hSource, NULL, NULL, &ftLastWrite))
+    {
+        ExitWithLastError(hr, "Failed to get last write time of source file: %ls", wzSource);
+    }
+
+    hTarget = ::CreateFileW(wzTarget, GENERIC_WRITE, 0, NULL, (dwFlags & FILE_COPY_FLAGS_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | (fUnbuffered ? FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH : FILE_FLAG_SEQUENTIAL_SCAN), NULL);
+    ExitOnInvalidHandleWithLastError(hTarget, hr, "Failed to create target file: %ls", wzTarget);
+
+    fTargetCreated = TRUE;
+
+    // Size the target up front so the file system can allocate it in one go.
+    if (llSize)
+    {
+        li.QuadPart = llSize;
+        if (!::SetFilePointerEx(hTarget, li, NULL, FILE_BEGIN) || !::SetEndOfFile(hTarget))
+        {
+            ExitWithLastError(hr, "Failed to set size of target file: %ls", wzTarget);
+        }
+    }
+
+    // VirtualAlloc returns page aligned memory, which is what unbuffered I/O needs.
+    pbBuffers = static_cast<BYTE*>(::VirtualAlloc(NULL, 2 * static_cast<SIZE_T>(cbBuffer), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    ExitOnNullWithLastError(pbBuffers, hr, "Failed to allocate copy buffers.");
+
+    for (DWORD i = 0; i < countof(rgpbBuffer); ++i)
+    {
+        rgpbBuffer[i] = pbBuffers + i * static_cast<SIZE_T>(cbBuffer);
+
+        rgReadOverlapped[i].hEvent = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        ExitOnNullWithLastError(rgReadOverlapped[i].hEvent, hr, "Failed to create read event.");
+
+        rgWriteOverlapped[i].hEvent = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        ExitOnNullWithLastError(rgWriteOverlapped[i].hEvent, hr, "Failed to create write event.");
+    }
+
+    hr = BeginCopyRead(hSource, rgpbBuffer[0], cbBuffer, qwReadOffset, &rgReadOverlapped[0], &rgfReadPending[0]);
+    ExitOnFailure(hr, "Failed to read from source file: %ls", wzSource);
+
+    for (;;)
+    {
+        hr = EndCopyIo(hSource, &rgReadOverlapped[iBuffer], &rgfReadPending[iBuffer], &cbRead);
+        ExitOnFailure(hr, "Failed to read from source file: %ls", wzSource);
+
+        if (0 == cbRead)
+        {
+            break;
+        }
+
+        qwReadOffset += cbRead;
+
+        // The other buffer is free to be read into once the write from it is done.
+        hr = EndCopyIo(hTarget, &rgWriteOverlapped[iBuffer ^ 1], &rgfWritePending[iBuffer ^ 1], &cbWritten);
+        ExitOnFailure(hr, "Failed to write to target file: %ls", wzTarget);
+
+        if (cbRead == cbBuffer)
+        {
+            hr = BeginCopyRead(hSource, rgpbBuffer[iBuffer ^ 1], cbBuffer, qwReadOffset, &rgReadOverlapped[iBuffer ^ 1], &rgfReadPending[iBuffer ^ 1]);
+            ExitOnFailure(hr, "Failed to read from source file: %ls", wzSource);
+        }
+
+        // Unbuffered writes have to be whole sectors, the extra is truncated when the copy is done.
+        cbWrite = fUnbuffered ? (cbRead + FILE_COPY_ALIGNMENT - 1) & ~static_cast<DWORD>(FILE_COPY_ALIGNMENT - 1) : cbRead;
+
+        hr = BeginCopyWrite(hTarget, rgpbBuffer[iBuffer], cbWrite, qwCopied, &rgWriteOverlapped[iBuffer], &rgfWritePending[iBuffer]);
+        ExitOnFailure(hr, "Failed to write to target file: %ls", wzTarget);
+
+        qwCopied += cbRead;
+
+        if (pfnProgress)
+        {
+            hr = pfnProgress(qwCopied, static_cast<DWORD64>(llSize), pvContext);
+            ExitOnFailure(hr, "Copy was canceled by progress callback.");
+        }
+
+        // A short read means the end of the file was reached.
+        if (cbRead < cbBuffer)
+        {
+            break;
+        }
+
+        iBuffer ^= 1;
+    }
+
+    for (DWORD i = 0; i < countof(rgWriteOverlapped); ++i)
+    {
+        hr = EndCopyIo(hTarget, &rgWriteOverlapped[i], &rgfWritePending[i], &cbWritten);
+        ExitOnFailure(hr, "Failed to write to target file: %ls", wzTarget);
+    }
+
+    // A short read before the expected end means the source changed underneath the copy.
+    if (qwCopied != static_cast<DWORD64>(llSize))
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        ExitOnRootFailure(hr, "Source file changed size during copy: %ls", wzSource);
+    }
+
+    // Trim what was padded for unbuffered writes.
+    li.QuadPart = qwCopied;
+    if (!::SetFilePointerEx(hTarget, li, NULL, FILE_BEGIN) || !::SetEndOfFile(hTarget))
+    {
+        ExitWithLastError(hr, "Failed to set size of target file: %ls", wzTarget);
+    }
+
+    if (!::SetFileTime(hTarget, NULL, NULL, &ftLastWrite))
+    {
+        ExitWithLastError(hr, "Failed to set last write time of target file: %ls", wzTarget);
+    }
+
+    if (pcbCopied)
+    {
+        *pcbCopied = qwCopied;
+    }
+
+LExit:
+    // Nothing in flight may still reference the buffers when they are freed.
+    for (DWORD i = 0; i < countof(rgpbBuffer); ++i)
+    {
+        CancelCopyIo(hSource, &rgReadOverlapped[i], &rgfReadPending[i]);
+        CancelCopyIo(hTarget, &rgWriteOverlapped[i], &rgfWritePending[i]);
+
+        ReleaseHandle(rgReadOverlapped[i].hEvent);
+        ReleaseHandle(rgWriteOverlapped[i].hEvent);
+    }
+
+    if (pbBuffers)
+    {
+        ::VirtualFree(pbBuffers, 0, MEM_RELEASE);
+    }
+
+    ReleaseFile(hTarget);
+    ReleaseFile(hSource);
+
+    if (FAILED(hr) && fTargetCreated)
+    {
+        ::DeleteFileW(wzTarget);
+    }
+
     return hr;
 }
 
@@ -1858,3 +2303,195 @@ LExit:
 
     return hr;
 }
+
+
+static HRESULT MapViewWindow(
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __in SIZE_T cb
+    )
+{
+    HRESULT hr = S_OK;
+    SYSTEM_INFO si = { };
+    DWORD64 qwWindowOffset = 0;
+    SIZE_T cbWindow = 0;
+    BYTE* pbWindow = NULL;
+    PFN_PREFETCHVIRTUALMEMORY pfnPrefetchVirtualMemory = NULL;
+    FILE_MEMORY_RANGE_ENTRY range = { };
+
+    ::GetSystemInfo(&si);
+
+    // Start the window on the allocation granularity at or before the requested offset and make it
+    // as large as allowed so sequential readers cross as few windows as possible.
+    qwWindowOffset = qwOffset - (qwOffset % si.dwAllocationGranularity);
+    cbWindow = static_cast<SIZE_T>(min(static_cast<DWORD64>(pView->cbWindowMax), pView->qwFileSize - qwWindowOffset));
+
+    if (qwOffset + cb > qwWindowOffset + cbWindow)
+    {
+        ExitOnFailure(hr = E_INVALIDARG, "Requested view of %Iu bytes is larger than the window.", cb);
+    }
+
+    pbWindow = static_cast<BYTE*>(::MapViewOfFile(pView->hMapping, FILE_MAP_READ, static_cast<DWORD>(qwWindowOffset >> 32), static_cast<DWORD>(qwWindowOffset), cbWindow));
+    ExitOnNullWithLastError(pbWindow, hr, "Failed to map view of file.");
+
+    if (pView->pbWindow)
+    {
+        ::UnmapViewOfFile(pView->pbWindow);
+    }
+
+    pView->pbWindow = pbWindow;
+    pView->qwWindowOffset = qwWindowOffset;
+    pView->cbWindow = cbWindow;
+
+    // Ask for the rest of the window in large reads rather than a page fault at a time. This is
+    // only a hint so failure is ignored.
+    pfnPrefetchVirtualMemory = reinterpret_cast<PFN_PREFETCHVIRTUALMEMORY>(::GetProcAddress(::GetModuleHandleW(L"kernel32"), "PrefetchVirtualMemory"));
+    if (pfnPrefetchVirtualMemory)
+    {
+        range.VirtualAddress = pbWindow + (qwOffset - qwWindowOffset);
+        range.NumberOfBytes = cbWindow - static_cast<SIZE_T>(qwOffset - qwWindowOffset);
+
+        pfnPrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0);
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT CopyFromView(
+    __out_bcount(cb) LPVOID pvDestination,
+    __in_bcount(cb) const BYTE* pbSource,
+    __in SIZE_T cb
+    )
+{
+    HRESULT hr = S_OK;
+
+    // A mapped file on a network share that goes away raises an in-page error instead of
+    // failing a read, so turn that into the error ReadFile would have returned.
+    __try
+    {
+        memcpy(pvDestination, pbSource, cb);
+    }
+    __except (EXCEPTION_IN_PAGE_ERROR == ::GetExceptionCode() ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
+    }
+
+    return hr;
+}
+
+static HRESULT BeginCopyRead(
+    __in HANDLE hFile,
+    __out_bcount(cb) BYTE* pb,
+    __in DWORD cb,
+    __in DWORD64 qwOffset,
+    __in OVERLAPPED* pOverlapped,
+    __out BOOL* pfPending
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+
+    pOverlapped->Offset = static_cast<DWORD>(qwOffset);
+    pOverlapped->OffsetHigh = static_cast<DWORD>(qwOffset >> 32);
+    pOverlapped->Internal = 0;
+    pOverlapped->InternalHigh = 0;
+
+    // Whether it completes now or later, the result is collected by EndCopyIo().
+    if (!::ReadFile(hFile, pb, cb, NULL, pOverlapped))
+    {
+        er = ::GetLastError();
+        if (ERROR_IO_PENDING != er && ERROR_HANDLE_EOF != er)
+        {
+            ExitOnWin32Error(er, hr, "Failed to begin read.");
+        }
+    }
+
+    *pfPending = (ERROR_HANDLE_EOF != er);
+
+LExit:
+    return hr;
+}
+
+static HRESULT BeginCopyWrite(
+    __in HANDLE hFile,
+    __in_bcount(cb) const BYTE* pb,
+    __in DWORD cb,
+    __in DWORD64 qwOffset,
+    __in OVERLAPPED* pOverlapped,
+    __out BOOL* pfPending
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+
+    pOverlapped->Offset = static_cast<DWORD>(qwOffset);
+    pOverlapped->OffsetHigh = static_cast<DWORD>(qwOffset >> 32);
+    pOverlapped->Internal = 0;
+    pOverlapped->InternalHigh = 0;
+
+    if (!::WriteFile(hFile, pb, cb, NULL, pOverlapped))
+    {
+        er = ::GetLastError();
+        if (ERROR_IO_PENDING != er)
+        {
+            ExitOnWin32Error(er, hr, "Failed to begin write.");
+        }
+    }
+
+    *pfPending = TRUE;
+
+LExit:
+    return hr;
+}
+
+static HRESULT EndCopyIo(
+    __in HANDLE hFile,
+    __in OVERLAPPED* pOverlapped,
+    __inout BOOL* pfPending,
+    __out DWORD* pcbTransferred
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD er = ERROR_SUCCESS;
+
+    *pcbTransferred = 0;
+
+    if (!*pfPending)
+    {
+        ExitFunction();
+    }
+
+    *pfPending = FALSE;
+
+    if (!::GetOverlappedResult(hFile, pOverlapped, pcbTransferred, TRUE))
+    {
+        er = ::GetLastError();
+        if (ERROR_HANDLE_EOF != er)
+        {
+            ExitOnWin32Error(er, hr, "Failed to complete I/O.");
+        }
+
+        *pcbTransferred = 0;
+    }
+
+LExit:
+    return hr;
+}
+
+static void CancelCopyIo(
+    __in HANDLE hFile,
+    __in OVERLAPPED* pOverlapped,
+    __inout BOOL* pfPending
+    )
+{
+    DWORD cbTransferred = 0;
+
+    if (*pfPending)
+    {
+        ::CancelIo(hFile);
+        ::GetOverlappedResult(hFile, pOverlapped, &cbTransferred, TRUE);
+
+        *pfPending = FALSE;
+    }
+}
@@ -81,6 +81,12 @@ HRESULT DAPI AclMergeDacls(
     __in const ACL* pAcl2,
     __deref_out ACL** ppAclNew
     );
+HRESULT DAPI AclMergeExplicitAccess(
+    __in_opt const ACL* pAclExisting,
+    __in_ecount(cEntries) const EXPLICIT_ACCESSW* rgEntries,
+    __in DWORD cEntries,
+    __deref_out ACL** ppAclNew
+    );
 HRESULT DAPI AclCreateDaclOld(
     __in_ecount(cAclAccesses) ACL_ACCESS* paa,
     __in DWORD cAclAccesses,
@@ -100,6 +106,11 @@ HRESULT __cdecl AclCreateSecurityDescriptorFromString(
     __in_z __format_string LPCWSTR wzSddlFormat,
     ...
     );
+HRESULT DAPI AclCompareSecurityDescriptorStrings(
+    __in_z LPCWSTR wzSddl1,
+    __in_z LPCWSTR wzSddl2,
+    __out BOOL* pfEqual
+    );
 HRESULT DAPI AclDuplicateSecurityDescriptor(
     __in SECURITY_DESCRIPTOR* psd,
     __deref_out SECURITY_DESCRIPTOR** ppsd
@@ -14,6 +14,27 @@ extern "C" {
 #define BuffFree MemFree
 
 
+// structs
+
+// Appends to a MemAlloc'd buffer in the same wire format as the BuffWrite* functions.
+// Capacity is tracked here and grows geometrically, so a long run of writes does not
+// reallocate the buffer on every call.
+typedef struct _BUFF_WRITER
+{
+    BYTE* pbData;
+    SIZE_T cbData;
+    SIZE_T cbCapacity;
+} BUFF_WRITER;
+
+// Bounds checked cursor over a buffer written by BUFF_WRITER or the BuffWrite* functions.
+typedef struct _BUFF_READER
+{
+    const BYTE* pbData;
+    SIZE_T cbData;
+    SIZE_T iData;
+} BUFF_READER;
+
+
 // function declarations
 
 HRESULT BuffReadNumber(
@@ -75,6 +96,83 @@ HRESULT BuffWriteStream(
     __in SIZE_T cbStream
     );
 
+HRESULT BuffWriterAttach(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount_opt(cbBuffer) BYTE* pbBuffer,
+    __in SIZE_T cbBuffer
+    );
+void BuffWriterDetach(
+    __in BUFF_WRITER* pWriter,
+    __deref_out_bcount(*pcbBuffer) BYTE** ppbBuffer,
+    __out SIZE_T* pcbBuffer
+    );
+void BuffWriterUninitialize(
+    __in BUFF_WRITER* pWriter
+    );
+HRESULT BuffWriterReserve(
+    __in BUFF_WRITER* pWriter,
+    __in SIZE_T cbAdditional
+    );
+HRESULT BuffWriterWriteNumber(
+    __in BUFF_WRITER* pWriter,
+    __in DWORD dw
+    );
+HRESULT BuffWriterWriteNumber64(
+    __in BUFF_WRITER* pWriter,
+    __in DWORD64 dw64
+    );
+HRESULT BuffWriterWriteString(
+    __in BUFF_WRITER* pWriter,
+    __in_z_opt LPCWSTR wz
+    );
+HRESULT BuffWriterWriteStringAnsi(
+    __in BUFF_WRITER* pWriter,
+    __in_z_opt LPCSTR sz
+    );
+HRESULT BuffWriterWriteStream(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cbStream) const BYTE* pbStream,
+    __in SIZE_T cbStream
+    );
+
+void BuffReaderInitialize(
+    __in BUFF_READER* pReader,
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in SIZE_T iBuffer
+    );
+HRESULT BuffReaderReadNumber(
+    __in BUFF_READER* pReader,
+    __out DWORD* pdw
+    );
+HRESULT BuffReaderReadNumber64(
+    __in BUFF_READER* pReader,
+    __out DWORD64* pdw64
+    );
+HRESULT BuffReaderReadString(
+    __in BUFF_READER* pReader,
+    __deref_out_z LPWSTR* pscz
+    );
+HRESULT BuffReaderReadStringAnsi(
+    __in BUFF_READER* pReader,
+    __deref_out_z LPSTR* pscz
+    );
+HRESULT BuffReaderReadStringView(
+    __in BUFF_READER* pReader,
+    __deref_out_ecount(*pcch) LPCWSTR* pwz,
+    __out DWORD* pcch
+    );
+HRESULT BuffReaderReadStream(
+    __in BUFF_READER* pReader,
+    __deref_out_bcount(*pcbStream) BYTE** ppbStream,
+    __out SIZE_T* pcbStream
+    );
+HRESULT BuffReaderReadStreamView(
+    __in BUFF_READER* pReader,
+    __deref_out_bcount(*pcbStream) const BYTE** ppbStream,
+    __out SIZE_T* pcbStream
+    );
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,6 +9,9 @@ typedef enum DIR_DELETE
     DIR_DELETE_SCHEDULE = 4,
 } DIR_DELETE;
 
+// The most threads DirEnumerateTree uses when the caller leaves it to choose.
+const DWORD DIR_ENUMERATE_DEFAULT_MAX_THREADS = 8;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +43,13 @@ HRESULT DAPI DirEnsureDeleteEx(
     __in DWORD dwFlags
     );
 
+HRESULT DAPI DirEnumerateTree(
+    __in_z LPCWSTR wzPath,
+    __in DWORD cMaxThreads,
+    __deref_out_ecount_opt(*pcDirectories) LPWSTR** prgsczDirectories,
+    __out DWORD* pcDirectories
+    );
+
 HRESULT DAPI DirGetCurrent(
     __deref_out_z LPWSTR* psczCurrentDirectory
     );
@@ -130,6 +130,9 @@ template<typename T> static void countofVerify(T *const, T *const *) throw() {};
 
 typedef const BYTE* LPCBYTE;
 
+// Declared here rather than in memutil.h so strutil.h and friends can take an arena.
+typedef void* MEM_ARENA_HANDLE;
+
 #define E_FILENOTFOUND HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND)
 #define E_PATHNOTFOUND HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND)
 #define E_INVALIDDATA HRESULT_FROM_WIN32(ERROR_INVALID_DATA)
@@ -33,6 +33,45 @@ typedef enum FILE_ENCODING
     FILE_ENCODING_UTF16_WITH_BOM,
 } FILE_ENCODING;
 
+// Default size of the window a FILE_MAPPED_VIEW maps at a time. Files smaller than the window are mapped whole.
+#ifdef _WIN64
+#define FILE_MAPPED_VIEW_DEFAULT_WINDOW (256 * 1024 * 1024)
+#else
+#define FILE_MAPPED_VIEW_DEFAULT_WINDOW (32 * 1024 * 1024)
+#endif
+
+typedef struct _FILE_MAPPED_VIEW
+{
+    HANDLE hMapping;
+    DWORD64 qwFileSize;
+    SIZE_T cbWindowMax;
+
+    DWORD64 qwWindowOffset;
+    BYTE* pbWindow;
+    SIZE_T cbWindow;
+} FILE_MAPPED_VIEW;
+
+// Default size of each of the two buffers FileCopy uses. Buffers are rounded up to FILE_COPY_ALIGNMENT.
+#define FILE_COPY_DEFAULT_BUFFER (1024 * 1024)
+#define FILE_COPY_ALIGNMENT (64 * 1024)
+
+// Files at least this big bypass the system cache when FILE_COPY_FLAGS_UNBUFFERED is set.
+#define FILE_COPY_UNBUFFERED_THRESHOLD (64 * 1024 * 1024)
+
+typedef enum FILE_COPY_FLAGS
+{
+    FILE_COPY_FLAGS_NONE = 0x0,
+    FILE_COPY_FLAGS_FAIL_IF_EXISTS = 0x1,
+    FILE_COPY_FLAGS_UNBUFFERED = 0x2,
+} FILE_COPY_FLAGS;
+
+// Called after each block is written. Returning a failure cancels the copy.
+typedef HRESULT (CALLBACK *PFN_FILE_COPY_PROGRESS)(
+    __in DWORD64 qwCopied,
+    __in DWORD64 qwTotal,
+    __in_opt LPVOID pvContext
+    );
+
 
 LPWSTR DAPI FileFromPath(
     __in_z LPCWSTR wzPath
@@ -83,6 +122,27 @@ HRESULT DAPI FileSizeByHandle(
     __in HANDLE hFile, 
     __out LONGLONG* pllSize
     );
+HRESULT DAPI FileMappedViewInitialize(
+    __in FILE_MAPPED_VIEW* pView,
+    __in HANDLE hFile,
+    __in SIZE_T cbWindowMax
+    );
+HRESULT DAPI FileMappedViewGet(
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __in SIZE_T cb,
+    __deref_out_bcount(cb) const BYTE** ppb
+    );
+HRESULT DAPI FileMappedViewRead(
+    __in FILE_MAPPED_VIEW* pView,
+    __in DWORD64 qwOffset,
+    __out_bcount_part(cb, *pcbRead) LPVOID pv,
+    __in SIZE_T cb,
+    __out SIZE_T* pcbRead
+    );
+void DAPI FileMappedViewUninitialize(
+    __in FILE_MAPPED_VIEW* pView
+    );
 BOOL DAPI FileExistsEx(
     __in_z LPCWSTR wzPath, 
     __out_opt DWORD *pdwAttributes
@@ -148,6 +208,24 @@ HRESULT DAPI FileCopyUsingHandles(
     __in DWORD64 cbCopy,
     __out_opt DWORD64* pcbCopied
     );
+HRESULT DAPI FileCopyUsingHandlesEx(
+    __in HANDLE hSource,
+    __in HANDLE hTarget,
+    __in DWORD64 cbCopy,
+    __in DWORD cbBuffer,
+    __in_opt PFN_FILE_COPY_PROGRESS pfnProgress,
+    __in_opt LPVOID pvContext,
+    __out_opt DWORD64* pcbCopied
+    );
+HRESULT DAPI FileCopy(
+    __in_z LPCWSTR wzSource,
+    __in_z LPCWSTR wzTarget,
+    __in DWORD dwFlags,
+    __in DWORD cbBuffer,
+    __in_opt PFN_FILE_COPY_PROGRESS pfnProgress,
+    __in_opt LPVOID pvContext,
+    __out_opt DWORD64* pcbCopied
+    );
 HRESULT DAPI FileEnsureCopy(
     __in_z LPCWSTR wzSource,
     __in_z LPCWSTR wzTarget,
@@ -36,6 +36,10 @@ struct WIX_LOCALIZATION
 
     DWORD cLocControls;
     LOC_CONTROL* rgLocControls;
+
+    // Hash indexes of rgLocStrings by wzId and rgLocControls by wzControl.
+    STRINGDICT_HANDLE sdhLocStrings;
+    STRINGDICT_HANDLE sdhLocControls;
 };
 
 /********************************************************************
@@ -81,6 +85,9 @@ void DAPI LocFree(
 /********************************************************************
  LocLocalizeString - replace any #(loc.id) in a string with the
                     correct sub string
+
+ NOTE: The string is rewritten in a single pass, so #(loc.id) tokens
+       in the replacement text are not localized again.
 *******************************************************************/
 HRESULT DAPI LocLocalizeString(
     __in const WIX_LOCALIZATION* pWixLoc,
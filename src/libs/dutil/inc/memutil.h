@@ -8,6 +8,11 @@ extern "C" {
 
 #define ReleaseMem(p) if (p) { MemFree(p); }
 #define ReleaseNullMem(p) if (p) { MemFree(p); p = NULL; }
+#define ReleaseMemArena(h) if (h) { MemArenaDestroy(h); }
+#define ReleaseNullMemArena(h) if (h) { MemArenaDestroy(h); h = NULL; }
+
+// Default size of the blocks an arena carves its allocations out of.
+#define MEM_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
 
 HRESULT DAPI MemInitialize();
 void DAPI MemUninitialize();
@@ -67,6 +72,42 @@ void DAPI MemArraySwapItems(
     __in SIZE_T cbArrayType
     );
 
+/********************************************************************
+ MemArena - bump-pointer allocation for object graphs that are built
+            once and freed all at once.
+
+ Arena allocations can be handed to MemFree(), MemReAlloc() and
+ MemSize() like any other. MemFree() leaves the memory in the arena
+ and MemReAlloc() moves a growing allocation to the heap, so strutil
+ strings can still be modified in place. Everything still in the arena
+ is freed by MemArenaDestroy().
+
+ Arena blocks are committed from one address range reserved for all
+ arenas, so telling arena and heap allocations apart takes no lock.
+ MemArenaAlloc() returns NULL when an allocation is larger than a block
+ can be or that range is full; allocate from the heap instead.
+
+ NOTE: an arena must only be allocated from by one thread at a time.
+********************************************************************/
+HRESULT DAPI MemArenaCreate(
+    __in SIZE_T cbBlock,
+    __out MEM_ARENA_HANDLE* phArena
+    );
+LPVOID DAPI MemArenaAlloc(
+    __in MEM_ARENA_HANDLE hArena,
+    __in SIZE_T cbSize,
+    __in BOOL fZero
+    );
+void DAPI MemArenaGetStatistics(
+    __in MEM_ARENA_HANDLE hArena,
+    __out_opt DWORD* pcAllocations,
+    __out_opt DWORD* pcBlocks,
+    __out_opt SIZE_T* pcbAllocated
+    );
+void DAPI MemArenaDestroy(
+    __in MEM_ARENA_HANDLE hArena
+    );
+
 HRESULT DAPI MemFree(
     __in LPVOID pv
     );
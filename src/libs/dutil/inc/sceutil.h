@@ -132,6 +132,19 @@ HRESULT DAPI ScePrepareInsert(
 HRESULT DAPI SceFinishUpdate(
     __in_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE rowHandle
     );
+// Begins a transaction and returns a row to insert many rows into a table with. Set the columns
+// and call SceFinishUpdate() for each row, the row is then ready for the next one. Inserted rows
+// can't be read back through the row. Finish with SceEndInsertBatch(), not SceFreeRow().
+HRESULT DAPI SceBeginInsertBatch(
+    __in SCE_DATABASE *pDatabase,
+    __in DWORD dwTableIndex,
+    __deref_out_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE *pRowHandle
+    );
+// Commits or rolls back the rows inserted since SceBeginInsertBatch() and frees the row
+HRESULT DAPI SceEndInsertBatch(
+    __inout_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE *pRowHandle,
+    __in BOOL fCommit
+    );
 HRESULT DAPI SceSetColumnBinary(
     __in_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE rowHandle,
     __in DWORD dwColumnIndex,
@@ -48,6 +48,17 @@ HRESULT DAPI StrAllocString(
     __in_z LPCWSTR wzSource,
     __in DWORD_PTR cchSource
     );
+HRESULT DAPI StrAllocArena(
+    __in_opt MEM_ARENA_HANDLE hArena,
+    __deref_out_ecount_part(cch, 0) LPWSTR* ppwz,
+    __in DWORD_PTR cch
+    );
+HRESULT DAPI StrAllocStringArena(
+    __in_opt MEM_ARENA_HANDLE hArena,
+    __deref_out_ecount_z(cchSource+1) LPWSTR* ppwz,
+    __in_z LPCWSTR wzSource,
+    __in DWORD_PTR cchSource
+    );
 HRESULT DAPI StrAllocStringSecure(
     __deref_out_ecount_z(cchSource + 1) LPWSTR* ppwz,
     __in_z LPCWSTR wzSource,
@@ -132,6 +132,27 @@ struct THEME_ASSIGN_CONTROL_ID
 
 const DWORD THEME_FIRST_ASSIGN_CONTROL_ID = 1024; // Recommended first control id to be assigned.
 
+// THEME_IMAGE_SOURCE - Where an image or icon comes from, as authored in the theme. Images are
+//                      only decoded from their source the first time they are needed.
+struct THEME_IMAGE_SOURCE
+{
+    LPWSTR sczResource; // ImageResource or IconResource attribute
+    LPWSTR sczFile;     // ImageFile or IconFile attribute, relative to the theme or its module
+
+    // state variables that should be ignored
+    BOOL fLoaded; // set once decoding was attempted, even if it failed
+};
+
+struct THEME_IMAGELIST
+{
+    LPWSTR sczName;
+
+    DWORD cImages;
+    THEME_IMAGE_SOURCE* rgImages;
+
+    HIMAGELIST hImageList; // created the first time a list view control using it is loaded
+};
+
 struct THEME_CONTROL
 {
     THEME_CONTROL_TYPE type;
@@ -155,10 +176,13 @@ struct THEME_CONTROL
     LPWSTR sczVisibleCondition;
     BOOL fDisableVariableFunctionality;
 
-    HBITMAP hImage;
+    THEME_IMAGE_SOURCE imageSource;
+    THEME_IMAGE_SOURCE iconSource;
+    HBITMAP hImage; // decoded from imageSource the first time the control is drawn
     HICON hIcon;
 
-    // Don't free these; it's just a handle to the central image lists stored in THEME. The handle is freed once, there.
+    // Don't free these; they point at the central image lists stored in THEME. The lists are freed once, there.
+    THEME_IMAGELIST* rgpImageList[4];
     HIMAGELIST rghImageList[4];
 
     DWORD dwStyle;
@@ -211,13 +235,6 @@ struct THEME_CONTROL
 };
 
 
-struct THEME_IMAGELIST
-{
-    LPWSTR sczName;
-
-    HIMAGELIST hImageList;
-};
-
 struct THEME_SAVEDVARIABLE
 {
     LPWSTR wzName;
@@ -237,6 +254,10 @@ struct THEME_PAGE
 
 struct THEME_FONT
 {
+    LOGFONTW lf;
+    DWORD dwSystemForeground; // system color index, or 0 when crForeground is a fixed color
+    DWORD dwSystemBackground; // system color index, or 0 when crBackground is a fixed color
+
     HFONT hFont;
     COLORREF crForeground;
     HBRUSH hForeground;
@@ -253,6 +274,7 @@ struct THEME
 
     DWORD dwStyle;
     DWORD dwFontId;
+    THEME_IMAGE_SOURCE iconSource;
     HANDLE hIcon;
     LPWSTR sczCaption;
     int nHeight;
@@ -263,6 +285,7 @@ struct THEME
     int nSourceY;
     UINT uStringId;
 
+    THEME_IMAGE_SOURCE imageSource;
     HBITMAP hImage;
 
     DWORD cFonts;
@@ -282,6 +305,9 @@ struct THEME
     HWND hwndHover; // current hwnd hovered over
     DWORD dwCurrentPageId;
     HWND hwndTooltip;
+    MEM_ARENA_HANDLE hArena; // strings parsed from the theme
+    HMODULE hModule; // module that image resources are loaded from
+    LPWSTR sczRelativePath; // directory that image files are relative to, or NULL for hModule's directory
 
     // callback functions
     PFNTHM_EVALUATE_VARIABLE_CONDITION pfnEvaluateCondition;
@@ -329,6 +355,35 @@ DAPI_(HRESULT) ThemeLoadFromResource(
     __out THEME** ppTheme
     );
 
+/********************************************************************
+ ThemeLoadFromBuffer - loads a theme saved by ThemeSaveToBuffer without
+                       parsing any XML.
+
+ NOTE: ThemeLoadFromFile and ThemeLoadFromResource also recognize a
+       saved theme, so one can be shipped in place of the XML.
+*******************************************************************/
+DAPI_(HRESULT) ThemeLoadFromBuffer(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in_opt HMODULE hModule,
+    __in_z_opt LPCWSTR wzRelativePath,
+    __out THEME** ppTheme
+    );
+
+/********************************************************************
+ ThemeSaveToBuffer - saves the parsed theme in a precompiled form that
+                     loads without XML. Images are saved by source and
+                     still decoded when they are first needed.
+
+ NOTE: Save the theme before its controls are loaded or its strings
+       are localized. Free the buffer with MemFree().
+*******************************************************************/
+DAPI_(HRESULT) ThemeSaveToBuffer(
+    __in const THEME* pTheme,
+    __deref_out_bcount(*pcbBuffer) BYTE** ppbBuffer,
+    __out SIZE_T* pcbBuffer
+    );
+
 /********************************************************************
  ThemeFree - frees any memory associated with a theme.
 
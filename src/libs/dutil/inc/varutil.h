@@ -28,6 +28,7 @@ typedef enum VARIABLE_VALUE_TYPE
     VARIABLE_VALUE_TYPE_NUMERIC,
     VARIABLE_VALUE_TYPE_STRING,
     VARIABLE_VALUE_TYPE_VERSION,
+    VARIABLE_VALUE_TYPE_FORMATTED,
 } VARIABLE_VALUE_TYPE;
 
 typedef struct _VARIABLE_VALUE
@@ -98,6 +99,11 @@ HRESULT DAPI VarSetString(
     __in_z LPCWSTR wzVariable,
     __in_z_opt LPCWSTR wzValue
     );
+HRESULT DAPI VarSetFormatted(
+    __in VARIABLES_HANDLE pVariables,
+    __in_z LPCWSTR wzVariable,
+    __in_z_opt LPCWSTR wzValue
+    );
 HRESULT DAPI VarSetVersion(
     __in VARIABLES_HANDLE pVariables,
     __in_z LPCWSTR wzVariable,
@@ -0,0 +1,171 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum XML_READER_NODE
+{
+    XML_READER_NODE_NONE,
+    XML_READER_NODE_ELEMENT,
+    XML_READER_NODE_END_ELEMENT,
+    XML_READER_NODE_TEXT,
+} XML_READER_NODE;
+
+typedef struct _XML_READER_ATTRIBUTE
+{
+    LPCWSTR wzName;
+    LPCWSTR wzValue;
+} XML_READER_ATTRIBUTE;
+
+// A compiled document is the header followed by the node records, the attribute records and
+// the string table. Strings are null terminated and referenced by their offset in characters,
+// so the reader hands them out without copying or decoding anything.
+const DWORD XML_READER_COMPILED_SIGNATURE = 0x4C4D5842; // "BXML"
+const DWORD XML_READER_COMPILED_VERSION = 1;
+
+typedef struct _XML_READER_COMPILED_HEADER
+{
+    DWORD dwSignature;
+    DWORD dwVersion;
+    DWORD cNodes;
+    DWORD cAttributes;
+    DWORD cchStrings;
+} XML_READER_COMPILED_HEADER;
+
+typedef struct _XML_READER_COMPILED_NODE
+{
+    DWORD node; // XML_READER_NODE, empty elements are followed by their end element
+    DWORD iString; // element name or text
+    DWORD iFirstAttribute;
+    DWORD cAttributes;
+} XML_READER_COMPILED_NODE;
+
+typedef struct _XML_READER_COMPILED_ATTRIBUTE
+{
+    DWORD iName;
+    DWORD iValue;
+} XML_READER_COMPILED_ATTRIBUTE;
+
+// Forward-only reader over an in-memory document. Names, attribute values and text are
+// decoded in place, so every string the reader hands out stays valid until it is uninitialized.
+typedef struct _XML_READER
+{
+    LPWSTR sczXml;
+    LPWSTR pwz;
+    BOOL fTagPending; // the '<' at pwz was overwritten when the preceding text was terminated
+    BOOL fDocumentElementRead;
+
+    XML_READER_NODE node;
+    DWORD dwDepth; // the document element is at depth 1
+    LPCWSTR wzName;
+    LPCWSTR wzText;
+    BOOL fEmptyElement;
+
+    XML_READER_ATTRIBUTE* rgAttributes;
+    DWORD cAttributes;
+
+    LPCWSTR* rgwzElements;
+    DWORD cElements;
+
+    // set when reading a compiled document
+    BYTE* pbCompiled;
+    const XML_READER_COMPILED_NODE* rgCompiledNodes;
+    DWORD cCompiledNodes;
+    DWORD iCompiledNode;
+    const XML_READER_COMPILED_ATTRIBUTE* rgCompiledAttributes;
+    LPCWSTR wzCompiledStrings;
+
+    // optional, set after initializing to copy attribute values out of the reader into an arena
+    MEM_ARENA_HANDLE hArena;
+} XML_READER;
+
+
+DAPI_(HRESULT) XmlReaderInitialize(
+    __in_z LPCWSTR wzXml,
+    __in XML_READER* pReader
+    );
+
+DAPI_(HRESULT) XmlReaderInitializeFromBuffer(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in XML_READER* pReader
+    );
+
+DAPI_(HRESULT) XmlReaderInitializeFromFile(
+    __in_z LPCWSTR wzPath,
+    __in XML_READER* pReader
+    );
+
+DAPI_(BOOL) XmlReaderIsCompiled(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer
+    );
+
+DAPI_(HRESULT) XmlReaderInitializeFromCompiled(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in XML_READER* pReader
+    );
+
+DAPI_(HRESULT) XmlReaderCompile(
+    __in XML_READER* pReader,
+    __deref_out_bcount(*pcbCompiled) BYTE** ppbCompiled,
+    __out SIZE_T* pcbCompiled
+    );
+
+DAPI_(void) XmlReaderUninitialize(
+    __in XML_READER* pReader
+    );
+
+DAPI_(HRESULT) XmlReaderRead(
+    __in XML_READER* pReader,
+    __out_opt XML_READER_NODE* pNode
+    );
+
+DAPI_(HRESULT) XmlReaderNextElement(
+    __in XML_READER* pReader,
+    __in DWORD dwParentDepth,
+    __out_opt LPCWSTR* pwzElement
+    );
+
+DAPI_(HRESULT) XmlReaderReadElementText(
+    __in XML_READER* pReader,
+    __deref_out_z LPWSTR* psczText
+    );
+
+DAPI_(HRESULT) XmlReaderGetAttributeValue(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out_z LPCWSTR* pwzValue
+    );
+
+DAPI_(HRESULT) XmlReaderGetAttribute(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __deref_out_z LPWSTR* psczValue
+    );
+
+DAPI_(HRESULT) XmlReaderGetYesNoAttribute(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out BOOL* pfYes
+    );
+
+DAPI_(HRESULT) XmlReaderGetAttributeNumber(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out DWORD* pdwValue
+    );
+
+DAPI_(HRESULT) XmlReaderGetAttributeLargeNumber(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out DWORD64* pdw64Value
+    );
+
+#ifdef __cplusplus
+}
+#endif
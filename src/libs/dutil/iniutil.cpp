@@ -22,9 +22,22 @@ struct INI_STRUCT
     INI_VALUE *rgivValues;
     DWORD cValues;
 
+    // Contents of the parsed file. Lines are terminated in place and parsed values point into this buffer.
+    LPWSTR sczContents;
+    DWORD cchContents;
+
+    // Fully qualified (section\name) names of parsed values, packed into one buffer.
+    LPWSTR sczNames;
+    DWORD cchNames;
+
+    // Lines of the parsed file (pointing into sczContents), NULL for lines that are regenerated on write.
     LPWSTR *rgsczLines;
     DWORD cLines;
 
+    // Value name to INI_VALUE, rebuilt lazily whenever values move within rgivValues.
+    STRINGDICT_HANDLE sdValues;
+    BOOL fIndexStale;
+
     FILE_ENCODING feEncoding;
     BOOL fModified;
 };
@@ -36,8 +49,42 @@ static HRESULT GetSectionPrefixFromName(
     __deref_out_z LPWSTR* psczOutput
     );
 static void UninitializeIniValue(
+    __in const INI_STRUCT *pi,
     INI_VALUE *pivValue
     );
+static HRESULT ParseLine(
+    __in INI_STRUCT *pi,
+    __in DWORD dwLine,
+    __deref_inout_z_opt LPWSTR *pwzCurrentSection,
+    __inout DWORD *pcchNamesUsed
+    );
+static HRESULT AppendName(
+    __in INI_STRUCT *pi,
+    __inout DWORD *pcchNamesUsed,
+    __in_z_opt LPCWSTR wzSection,
+    __in_ecount(cchName) LPCWSTR wzName,
+    __in DWORD cchName,
+    __out DWORD *pdwNameOffset
+    );
+static LPWSTR TrimInPlace(
+    __in_z LPWSTR wz
+    );
+static HRESULT FindValue(
+    __in INI_STRUCT *pi,
+    __in_z LPCWSTR wzValueName,
+    __out INI_VALUE **ppValue
+    );
+static HRESULT EnsureIndex(
+    __in INI_STRUCT *pi
+    );
+static BOOL IsParsedString(
+    __in const INI_STRUCT *pi,
+    __in_z_opt LPCWSTR wz
+    );
+static void ReleaseIniString(
+    __in const INI_STRUCT *pi,
+    __in_z_opt LPCWSTR wz
+    );
 
 extern "C" HRESULT DAPI IniInitialize(
     __out_bcount(INI_HANDLE_BYTES) INI_HANDLE* piHandle
@@ -74,11 +121,14 @@ extern "C" void DAPI IniUninitialize(
 
     for (DWORD i = 0; i < pi->cValues; ++i)
     {
-        UninitializeIniValue(pi->rgivValues + i);
+        UninitializeIniValue(pi, pi->rgivValues + i);
     }
     ReleaseMem(pi->rgivValues);
 
-    ReleaseStrArray(pi->rgsczLines, pi->cLines);
+    ReleaseDict(pi->sdValues);
+    ReleaseMem(pi->rgsczLines);
+    ReleaseStr(pi->sczNames);
+    ReleaseStr(pi->sczContents);
 
     ReleaseMem(pi);
 }
@@ -203,32 +253,18 @@ extern "C" HRESULT DAPI IniParse(
     )
 {
     HRESULT hr = S_OK;
-    DWORD dwValuePrefixLength = 0;
-    DWORD dwValueSeparatorExceptionLength = 0;
-    LPWSTR sczContents = NULL;
-    LPWSTR sczCurrentSection = NULL;
-    LPWSTR sczName = NULL;
-    LPWSTR sczNameTrimmed = NULL;
-    LPWSTR sczValue = NULL;
-    LPWSTR sczValueTrimmed = NULL;
-    LPWSTR wzOpenTagPrefix = NULL;
-    LPWSTR wzOpenTagPostfix = NULL;
-    LPWSTR wzValuePrefix = NULL;
-    LPWSTR wzValueNameStart = NULL;
-    LPWSTR wzValueSeparator = NULL;
-    LPWSTR wzCommentLinePrefix = NULL;
-    LPWSTR wzValueBegin = NULL;
-    LPCWSTR wzTemp = NULL;
+    LPWSTR wzLine = NULL;
+    LPWSTR wzLineEnd = NULL;
+    LPWSTR wzCurrentSection = NULL;
+    DWORD cchNamesUsed = 0;
+    DWORD dwValuesStart = 0;
 
     INI_STRUCT *pi = static_cast<INI_STRUCT *>(piHandle);
 
-    BOOL fSections = (NULL != pi->sczOpenTagPrefix) && (NULL != pi->sczOpenTagPostfix);
-    BOOL fValuePrefix = (NULL != pi->sczValuePrefix);
-
     hr = StrAllocString(&pi->sczPath, wzPath, 0);
     ExitOnFailure(hr, "Failed to copy path to ini struct: %ls", wzPath);
 
-    hr = FileToString(pi->sczPath, &sczContents, &pi->feEncoding);
+    hr = FileToString(pi->sczPath, &pi->sczContents, &pi->feEncoding);
     ExitOnFailure(hr, "Failed to convert file to string: %ls", pi->sczPath);
 
     if (pfeEncodingFound)
@@ -236,162 +272,55 @@ extern "C" HRESULT DAPI IniParse(
         *pfeEncodingFound = pi->feEncoding;
     }
 
-    if (!sczContents || !*sczContents)
+    if (!pi->sczContents || !*pi->sczContents)
     {
         // Empty string, nothing to parse
         ExitFunction1(hr = S_OK);
     }
 
-    dwValuePrefixLength = lstrlenW(pi->sczValuePrefix);
-    hr = StrSplitAllocArray(&pi->rgsczLines, reinterpret_cast<UINT *>(&pi->cLines), sczContents, L"\n");
-    ExitOnFailure(hr, "Failed to split INI file into lines");
+    pi->cchContents = lstrlenW(pi->sczContents) + 1;
+    dwValuesStart = pi->cValues;
 
-    for (DWORD i = 0; i < pi->cLines; ++i)
+    // Walk the contents once, terminating each line in place. Like splitting on
+    // newlines, empty lines are dropped and don't count towards line numbers.
+    for (wzLine = pi->sczContents; *wzLine; wzLine = wzLineEnd)
     {
-        if (!*pi->rgsczLines[i] || '\r' == *pi->rgsczLines[i])
-        {
-            continue;
-        }
-
-        if (pi->sczCommentLinePrefix)
-        {
-            wzCommentLinePrefix = wcsstr(pi->rgsczLines[i], pi->sczCommentLinePrefix);
-
-            if (wzCommentLinePrefix && wzCommentLinePrefix <= pi->rgsczLines[i] + 1)
-            {
-                continue;
-            }
-        }
-
-        if (pi->sczOpenTagPrefix)
+        wzLineEnd = wcschr(wzLine, L'\n');
+        if (wzLineEnd)
         {
-            wzOpenTagPrefix = wcsstr(pi->rgsczLines[i], pi->sczOpenTagPrefix);
-            if (wzOpenTagPrefix)
-            {
-                // If there is an open tag prefix but there is anything but whitespace before it, then it's NOT an open tag prefix
-                // This is important, for example, to support values with names like "Array[0]=blah" in INI format
-                for (wzTemp = pi->rgsczLines[i]; wzTemp < wzOpenTagPrefix; ++wzTemp)
-                {
-                    if (*wzTemp != L' ' && *wzTemp != L'\t')
-                    {
-                        wzOpenTagPrefix = NULL;
-                        break;
-                    }
-                }
-            }
-        }
-
-        if (pi->sczOpenTagPostfix)
-        {
-            wzOpenTagPostfix = wcsstr(pi->rgsczLines[i], pi->sczOpenTagPostfix);
-        }
-
-        if (pi->sczValuePrefix)
-        {
-            wzValuePrefix = wcsstr(pi->rgsczLines[i], pi->sczValuePrefix);
-            if (wzValuePrefix != NULL)
-            {
-                wzValueNameStart = wzValuePrefix + dwValuePrefixLength;
-            }
+            *wzLineEnd = L'\0';
+            ++wzLineEnd;
         }
         else
         {
-            wzValueNameStart = pi->rgsczLines[i];
+            wzLineEnd = wzLine + lstrlenW(wzLine);
         }
 
-        if (pi->sczValueSeparator && NULL != wzValueNameStart && *wzValueNameStart != L'\0')
+        if (!*wzLine)
         {
-            dwValueSeparatorExceptionLength = 0;
-            for (DWORD j = 0; j < pi->cValueSeparatorExceptions; ++j)
-            {
-                if (pi->rgsczLines[i] == wcsstr(pi->rgsczLines[i], pi->rgsczValueSeparatorExceptions[j]))
-                {
-                    dwValueSeparatorExceptionLength = lstrlenW(pi->rgsczValueSeparatorExceptions[j]);
-                    break;
-                }
-            }
-
-            wzValueSeparator = wcsstr(wzValueNameStart + dwValueSeparatorExceptionLength, pi->sczValueSeparator);
-        }
-
-        // Don't keep the endline
-        if (pi->rgsczLines[i][lstrlenW(pi->rgsczLines[i])-1] == L'\r')
-        {
-            pi->rgsczLines[i][lstrlenW(pi->rgsczLines[i])-1] = L'\0';
-        }
-
-        if (fSections && wzOpenTagPrefix && wzOpenTagPostfix && wzOpenTagPrefix < wzOpenTagPostfix && (NULL == wzCommentLinePrefix || wzOpenTagPrefix < wzCommentLinePrefix))
-        {
-            // There is an section starting here, let's keep track of it and move on
-            hr = StrAllocString(&sczCurrentSection, wzOpenTagPrefix + lstrlenW(pi->sczOpenTagPrefix), wzOpenTagPostfix - (wzOpenTagPrefix + lstrlenW(pi->sczOpenTagPrefix)));
-            ExitOnFailure(hr, "Failed to record section name for line: %ls of INI file: %ls", pi->rgsczLines[i], pi->sczPath);
-
-            // Sections will be calculated dynamically after any set operations, so don't include this in the list of lines to remember for output
-            ReleaseNullStr(pi->rgsczLines[i]);
+            continue;
         }
-        else if (wzValueSeparator && (NULL == wzCommentLinePrefix || wzValueSeparator < wzCommentLinePrefix)
-            && (!fValuePrefix || wzValuePrefix))
-        {
-            if (fValuePrefix)
-            {
-                wzValueBegin = wzValuePrefix + lstrlenW(pi->sczValuePrefix);
-            }
-            else
-            {
-                wzValueBegin = pi->rgsczLines[i];
-            }
 
-            hr = MemEnsureArraySize(reinterpret_cast<void **>(&pi->rgivValues), pi->cValues + 1, sizeof(INI_VALUE), 100);
-            ExitOnFailure(hr, "Failed to increase array size for value array");
+        hr = MemEnsureArraySize(reinterpret_cast<void **>(&pi->rgsczLines), pi->cLines + 1, sizeof(LPWSTR), 100);
+        ExitOnFailure(hr, "Failed to increase array size for line array");
 
-            if (sczCurrentSection)
-            {
-                hr = StrAllocString(&sczName, sczCurrentSection, 0);
-                ExitOnFailure(hr, "Failed to copy current section name");
-
-                hr = StrAllocConcat(&sczName, wzSectionSeparator, 0);
-                ExitOnFailure(hr, "Failed to copy current section name");
-            }
-
-            hr = StrAllocConcat(&sczName, wzValueBegin, wzValueSeparator - wzValueBegin);
-            ExitOnFailure(hr, "Failed to copy name");
+        pi->rgsczLines[pi->cLines] = wzLine;
+        ++pi->cLines;
 
-            hr = StrAllocString(&sczValue, wzValueSeparator + lstrlenW(pi->sczValueSeparator), 0);
-            ExitOnFailure(hr, "Failed to copy value");
-
-            hr = StrTrimWhitespace(&sczNameTrimmed, sczName);
-            ExitOnFailure(hr, "Failed to trim whitespace from name");
-
-            hr = StrTrimWhitespace(&sczValueTrimmed, sczValue);
-            ExitOnFailure(hr, "Failed to trim whitespace from value");
-
-            pi->rgivValues[pi->cValues].wzName = const_cast<LPCWSTR>(sczNameTrimmed);
-            sczNameTrimmed = NULL;
-            pi->rgivValues[pi->cValues].wzValue = const_cast<LPCWSTR>(sczValueTrimmed);
-            sczValueTrimmed = NULL;
-            pi->rgivValues[pi->cValues].dwLineNumber = i + 1;
-
-            ++pi->cValues;
-
-            // Values will be calculated dynamically after any set operations, so don't include this in the list of lines to remember for output
-            ReleaseNullStr(pi->rgsczLines[i]);
-        }
-        else
-        {
-            // Must be a comment, so ignore it and keep it in the list to output
-        }
+        hr = ParseLine(pi, pi->cLines - 1, &wzCurrentSection, &cchNamesUsed);
+        ExitOnFailure(hr, "Failed to parse line %u of INI file: %ls", pi->cLines, pi->sczPath);
+    }
 
-        ReleaseNullStr(sczName);
+    // The names buffer is done growing, so turn the recorded offsets into pointers.
+    for (DWORD i = dwValuesStart; i < pi->cValues; ++i)
+    {
+        pi->rgivValues[i].wzName = pi->sczNames + reinterpret_cast<DWORD_PTR>(pi->rgivValues[i].wzName);
+        pi->rgivValues[i].wzName = TrimInPlace(const_cast<LPWSTR>(pi->rgivValues[i].wzName));
     }
 
-LExit:
-    ReleaseStr(sczCurrentSection);
-    ReleaseStr(sczContents);
-    ReleaseStr(sczName);
-    ReleaseStr(sczNameTrimmed);
-    ReleaseStr(sczValue);
-    ReleaseStr(sczValueTrimmed);
+    pi->fIndexStale = TRUE;
 
+LExit:
     return hr;
 }
 
@@ -422,20 +351,8 @@ extern "C" HRESULT DAPI IniGetValue(
     INI_STRUCT *pi = static_cast<INI_STRUCT *>(piHandle);
     INI_VALUE *pValue = NULL;
 
-    for (DWORD i = 0; i < pi->cValues; ++i)
-    {
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pi->rgivValues[i].wzName, -1, wzValueName, -1))
-        {
-            pValue = pi->rgivValues + i;
-            break;
-        }
-    }
-
-    if (NULL == pValue)
-    {
-        hr = E_NOTFOUND;
-        ExitOnFailure(hr, "Failed to check for INI value: %ls", wzValueName);
-    }
+    hr = FindValue(pi, wzValueName, &pValue);
+    ExitOnFailure(hr, "Failed to check for INI value: %ls", wzValueName);
 
     if (NULL == pValue->wzValue)
     {
@@ -464,14 +381,12 @@ extern "C" HRESULT DAPI IniSetValue(
     INI_STRUCT *pi = static_cast<INI_STRUCT *>(piHandle);
     INI_VALUE *pValue = NULL;
 
-    for (DWORD i = 0; i < pi->cValues; ++i)
+    hr = FindValue(pi, wzValueName, &pValue);
+    if (E_NOTFOUND == hr)
     {
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pi->rgivValues[i].wzName, -1, wzValueName, -1))
-        {
-            pValue = pi->rgivValues + i;
-            break;
-        }
+        hr = S_OK;
     }
+    ExitOnFailure(hr, "Failed to check for INI value: %ls", wzValueName);
 
     // We're killing the value
     if (NULL == wzValue)
@@ -479,9 +394,8 @@ extern "C" HRESULT DAPI IniSetValue(
         if (pValue && pValue->wzValue)
         {
             pi->fModified = TRUE;
-            sczValue = const_cast<LPWSTR>(pValue->wzValue);
+            ReleaseIniString(pi, pValue->wzValue);
             pValue->wzValue = NULL;
-            ReleaseNullStr(sczValue);
         }
 
         ExitFunction();
@@ -493,8 +407,14 @@ extern "C" HRESULT DAPI IniSetValue(
             if (CSTR_EQUAL != ::CompareStringW(LOCALE_INVARIANT, 0, pValue->wzValue, -1, wzValue, -1))
             {
                 pi->fModified = TRUE;
-                hr = StrAllocString(const_cast<LPWSTR *>(&pValue->wzValue), wzValue, 0);
+
+                // Parsed values live in the file buffer, so always replace rather than reallocate in place
+                hr = StrAllocString(&sczValue, wzValue, 0);
                 ExitOnFailure(hr, "Failed to update value INI value named: %ls", wzValueName);
+
+                ReleaseIniString(pi, pValue->wzValue);
+                pValue->wzValue = sczValue;
+                sczValue = NULL;
             }
 
             ExitFunction1(hr = S_OK);
@@ -559,6 +479,17 @@ extern "C" HRESULT DAPI IniSetValue(
             sczValue = NULL;
 
             ++pi->cValues;
+
+            // Appending keeps every other value where the index expects it, inserting shifts them
+            if (dwInsertIndex + 1 == pi->cValues && pi->sdValues && !pi->fIndexStale)
+            {
+                hr = DictAddValue(pi->sdValues, pi->rgivValues + dwInsertIndex);
+                ExitOnFailure(hr, "Failed to index INI value: %ls", wzValueName);
+            }
+            else
+            {
+                pi->fIndexStale = TRUE;
+            }
         }
     }
 
@@ -616,7 +547,7 @@ extern "C" HRESULT DAPI IniWriteFile(
     // Insert any beginning lines we didn't understand like comments
     if (0 < pi->cLines)
     {
-        while (pi->rgsczLines[dwLineArrayIndex])
+        while (dwLineArrayIndex < pi->cLines && pi->rgsczLines[dwLineArrayIndex])
         {
             hr = StrAllocConcat(&sczContents, pi->rgsczLines[dwLineArrayIndex], 0);
             ExitOnFailure(hr, "Failed to add previous line to ini output buffer in-memory");
@@ -664,7 +595,7 @@ extern "C" HRESULT DAPI IniWriteFile(
         }
 
         // Inserting lines we read before the current value if appropriate
-        while (pi->rgivValues[i].dwLineNumber > dwLineArrayIndex)
+        while (pi->rgivValues[i].dwLineNumber > dwLineArrayIndex && dwLineArrayIndex < pi->cLines)
         {
             // Skip any lines were purposely forgot
             if (NULL == pi->rgsczLines[dwLineArrayIndex])
@@ -724,11 +655,12 @@ LExit:
 }
 
 static void UninitializeIniValue(
+    __in const INI_STRUCT *pi,
     INI_VALUE *pivValue
     )
 {
-    ReleaseStr(const_cast<LPWSTR>(pivValue->wzName));
-    ReleaseStr(const_cast<LPWSTR>(pivValue->wzValue));
+    ReleaseIniString(pi, pivValue->wzName);
+    ReleaseIniString(pi, pivValue->wzValue);
 }
 
 static HRESULT GetSectionPrefixFromName(
@@ -751,3 +683,291 @@ static HRESULT GetSectionPrefixFromName(
 LExit:
     return hr;
 }
+
+static HRESULT ParseLine(
+    __in INI_STRUCT *pi,
+    __in DWORD dwLine,
+    __deref_inout_z_opt LPWSTR *pwzCurrentSection,
+    __inout DWORD *pcchNamesUsed
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD dwValueSeparatorExceptionLength = 0;
+    DWORD dwNameOffset = 0;
+    DWORD cchLine = 0;
+    LPWSTR wzLine = pi->rgsczLines[dwLine];
+    LPWSTR wzOpenTagPrefix = NULL;
+    LPWSTR wzOpenTagPostfix = NULL;
+    LPWSTR wzValuePrefix = NULL;
+    LPWSTR wzValueNameStart = NULL;
+    LPWSTR wzValueSeparator = NULL;
+    LPWSTR wzCommentLinePrefix = NULL;
+    LPWSTR wzValueBegin = NULL;
+    LPCWSTR wzTemp = NULL;
+    BOOL fSections = (NULL != pi->sczOpenTagPrefix) && (NULL != pi->sczOpenTagPostfix);
+    BOOL fValuePrefix = (NULL != pi->sczValuePrefix);
+
+    if ('\r' == *wzLine)
+    {
+        ExitFunction();
+    }
+
+    if (pi->sczCommentLinePrefix)
+    {
+        wzCommentLinePrefix = wcsstr(wzLine, pi->sczCommentLinePrefix);
+
+        if (wzCommentLinePrefix && wzCommentLinePrefix <= wzLine + 1)
+        {
+            ExitFunction();
+        }
+    }
+
+    if (pi->sczOpenTagPrefix)
+    {
+        wzOpenTagPrefix = wcsstr(wzLine, pi->sczOpenTagPrefix);
+        if (wzOpenTagPrefix)
+        {
+            // If there is an open tag prefix but there is anything but whitespace before it, then it's NOT an open tag prefix
+            // This is important, for example, to support values with names like "Array[0]=blah" in INI format
+            for (wzTemp = wzLine; wzTemp < wzOpenTagPrefix; ++wzTemp)
+            {
+                if (*wzTemp != L' ' && *wzTemp != L'\t')
+                {
+                    wzOpenTagPrefix = NULL;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (pi->sczOpenTagPostfix)
+    {
+        wzOpenTagPostfix = wcsstr(wzLine, pi->sczOpenTagPostfix);
+    }
+
+    if (fValuePrefix)
+    {
+        wzValuePrefix = wcsstr(wzLine, pi->sczValuePrefix);
+        if (wzValuePrefix != NULL)
+        {
+            wzValueNameStart = wzValuePrefix + lstrlenW(pi->sczValuePrefix);
+        }
+    }
+    else
+    {
+        wzValueNameStart = wzLine;
+    }
+
+    if (pi->sczValueSeparator && NULL != wzValueNameStart && *wzValueNameStart != L'\0')
+    {
+        for (DWORD j = 0; j < pi->cValueSeparatorExceptions; ++j)
+        {
+            if (wzLine == wcsstr(wzLine, pi->rgsczValueSeparatorExceptions[j]))
+            {
+                dwValueSeparatorExceptionLength = lstrlenW(pi->rgsczValueSeparatorExceptions[j]);
+                break;
+            }
+        }
+
+        wzValueSeparator = wcsstr(wzValueNameStart + dwValueSeparatorExceptionLength, pi->sczValueSeparator);
+    }
+
+    // Don't keep the endline
+    cchLine = lstrlenW(wzLine);
+    if (wzLine[cchLine - 1] == L'\r')
+    {
+        wzLine[cchLine - 1] = L'\0';
+    }
+
+    if (fSections && wzOpenTagPrefix && wzOpenTagPostfix && wzOpenTagPrefix < wzOpenTagPostfix && (NULL == wzCommentLinePrefix || wzOpenTagPrefix < wzCommentLinePrefix))
+    {
+        // There is an section starting here, let's keep track of it and move on
+        *pwzCurrentSection = wzOpenTagPrefix + lstrlenW(pi->sczOpenTagPrefix);
+        *wzOpenTagPostfix = L'\0';
+
+        // Sections will be calculated dynamically after any set operations, so don't include this in the list of lines to remember for output
+        pi->rgsczLines[dwLine] = NULL;
+    }
+    else if (wzValueSeparator && (NULL == wzCommentLinePrefix || wzValueSeparator < wzCommentLinePrefix)
+        && (!fValuePrefix || wzValuePrefix))
+    {
+        if (fValuePrefix)
+        {
+            wzValueBegin = wzValuePrefix + lstrlenW(pi->sczValuePrefix);
+        }
+        else
+        {
+            wzValueBegin = wzLine;
+        }
+
+        hr = MemEnsureArraySize(reinterpret_cast<void **>(&pi->rgivValues), pi->cValues + 1, sizeof(INI_VALUE), 100);
+        ExitOnFailure(hr, "Failed to increase array size for value array");
+
+        hr = AppendName(pi, pcchNamesUsed, *pwzCurrentSection, wzValueBegin, static_cast<DWORD>(wzValueSeparator - wzValueBegin), &dwNameOffset);
+        ExitOnFailure(hr, "Failed to copy name");
+
+        // The names buffer may still move, so remember the offset until parsing is done
+        pi->rgivValues[pi->cValues].wzName = reinterpret_cast<LPCWSTR>(static_cast<DWORD_PTR>(dwNameOffset));
+        pi->rgivValues[pi->cValues].wzValue = TrimInPlace(wzValueSeparator + lstrlenW(pi->sczValueSeparator));
+        pi->rgivValues[pi->cValues].dwLineNumber = dwLine + 1;
+
+        ++pi->cValues;
+
+        // Values will be calculated dynamically after any set operations, so don't include this in the list of lines to remember for output
+        pi->rgsczLines[dwLine] = NULL;
+    }
+    else
+    {
+        // Must be a comment, so ignore it and keep it in the list to output
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT AppendName(
+    __in INI_STRUCT *pi,
+    __inout DWORD *pcchNamesUsed,
+    __in_z_opt LPCWSTR wzSection,
+    __in_ecount(cchName) LPCWSTR wzName,
+    __in DWORD cchName,
+    __out DWORD *pdwNameOffset
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD cchSection = wzSection ? lstrlenW(wzSection) + lstrlenW(wzSectionSeparator) : 0;
+    DWORD cchRequired = *pcchNamesUsed + cchSection + cchName + 1;
+    DWORD cchCapacity = 0;
+    LPWSTR wzWrite = NULL;
+
+    if (cchRequired > pi->cchNames)
+    {
+        cchCapacity = max(cchRequired, pi->cchNames * 2);
+        cchCapacity = max(cchCapacity, 256);
+
+        hr = StrAlloc(&pi->sczNames, cchCapacity);
+        ExitOnFailure(hr, "Failed to grow INI value name buffer");
+
+        pi->cchNames = cchCapacity;
+    }
+
+    *pdwNameOffset = *pcchNamesUsed;
+    wzWrite = pi->sczNames + *pcchNamesUsed;
+
+    if (wzSection)
+    {
+        memcpy(wzWrite, wzSection, sizeof(WCHAR) * (cchSection - lstrlenW(wzSectionSeparator)));
+        wzWrite += cchSection - lstrlenW(wzSectionSeparator);
+
+        memcpy(wzWrite, wzSectionSeparator, sizeof(WCHAR) * lstrlenW(wzSectionSeparator));
+        wzWrite += lstrlenW(wzSectionSeparator);
+    }
+
+    memcpy(wzWrite, wzName, sizeof(WCHAR) * cchName);
+    wzWrite[cchName] = L'\0';
+
+    *pcchNamesUsed = cchRequired;
+
+LExit:
+    return hr;
+}
+
+// Trims spaces and tabs from both ends, terminating the string in place.
+static LPWSTR TrimInPlace(
+    __in_z LPWSTR wz
+    )
+{
+    LPWSTR wzEnd = NULL;
+
+    while (L' ' == *wz || L'\t' == *wz)
+    {
+        ++wz;
+    }
+
+    wzEnd = wz + lstrlenW(wz);
+    while (wzEnd > wz && (L' ' == *(wzEnd - 1) || L'\t' == *(wzEnd - 1)))
+    {
+        --wzEnd;
+    }
+    *wzEnd = L'\0';
+
+    return wz;
+}
+
+static HRESULT FindValue(
+    __in INI_STRUCT *pi,
+    __in_z LPCWSTR wzValueName,
+    __out INI_VALUE **ppValue
+    )
+{
+    HRESULT hr = S_OK;
+
+    *ppValue = NULL;
+
+    if (!wzValueName || !pi->cValues)
+    {
+        ExitFunction1(hr = E_NOTFOUND);
+    }
+
+    hr = EnsureIndex(pi);
+    ExitOnFailure(hr, "Failed to index INI values");
+
+    hr = DictGetValue(pi->sdValues, wzValueName, reinterpret_cast<void **>(ppValue));
+
+LExit:
+    return hr;
+}
+
+static HRESULT EnsureIndex(
+    __in INI_STRUCT *pi
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (pi->sdValues && !pi->fIndexStale)
+    {
+        ExitFunction();
+    }
+
+    ReleaseNullDict(pi->sdValues);
+
+    hr = DictCreateWithEmbeddedKey(&pi->sdValues, pi->cValues, reinterpret_cast<void **>(&pi->rgivValues), offsetof(INI_VALUE, wzName), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create INI value index");
+
+    for (DWORD i = 0; i < pi->cValues; ++i)
+    {
+        hr = DictAddValue(pi->sdValues, pi->rgivValues + i);
+        ExitOnFailure(hr, "Failed to index INI value: %ls", pi->rgivValues[i].wzName);
+    }
+
+    pi->fIndexStale = FALSE;
+
+LExit:
+    if (FAILED(hr))
+    {
+        ReleaseNullDict(pi->sdValues);
+    }
+
+    return hr;
+}
+
+static BOOL IsParsedString(
+    __in const INI_STRUCT *pi,
+    __in_z_opt LPCWSTR wz
+    )
+{
+    return (pi->sczContents && pi->sczContents <= wz && wz < pi->sczContents + pi->cchContents) ||
+           (pi->sczNames && pi->sczNames <= wz && wz < pi->sczNames + pi->cchNames);
+}
+
+// Frees strings that were allocated for a value, leaving ones that point into the parsed buffers alone.
+static void ReleaseIniString(
+    __in const INI_STRUCT *pi,
+    __in_z_opt LPCWSTR wz
+    )
+{
+    if (wz && !IsParsedString(pi, wz))
+    {
+        StrFree(const_cast<LPWSTR>(wz));
+    }
+}
@@ -25,6 +25,17 @@ static HRESULT ParseWxlControl(
     __in DWORD dwIdx,
     __in WIX_LOCALIZATION* pWixLoc
     );
+static HRESULT IndexWxl(
+    __in WIX_LOCALIZATION* pWixLoc
+    );
+static HRESULT AddToIndex(
+    __in STRINGDICT_HANDLE sdhIndex,
+    __in_z_opt LPCWSTR wzKey,
+    __in void* pvValue
+    );
+
+#define LOC_TOKEN_PREFIX L"#(loc."
+#define LOC_TOKEN_PREFIX_LENGTH 6
 
 // from Winnls.h
 #ifndef MUI_LANGUAGE_ID
@@ -263,6 +274,8 @@ extern "C" void DAPI LocFree(
             ReleaseStr(pWixLoc->rgLocControls[idx].wzText);
         }
 
+        ReleaseDict(pWixLoc->sdhLocStrings);
+        ReleaseDict(pWixLoc->sdhLocControls);
         ReleaseMem(pWixLoc->rgLocStrings);
         ReleaseMem(pWixLoc->rgLocControls);
         ReleaseMem(pWixLoc);
@@ -276,14 +289,76 @@ extern "C" HRESULT DAPI LocLocalizeString(
 {
     Assert(ppsczInput && pWixLoc);
     HRESULT hr = S_OK;
+    LPCWSTR wzNext = *ppsczInput;
+    LPCWSTR wzCopied = *ppsczInput;
+    LPCWSTR wzToken = NULL;
+    LPCWSTR wzTokenEnd = NULL;
+    LPWSTR sczToken = NULL;
+    LPWSTR sczOutput = NULL;
+    LOC_STRING* pLocString = NULL;
 
-    for (DWORD i = 0; i < pWixLoc->cLocStrings; ++i)
+    // Walk the tokens left to right and look each one up, instead of searching
+    // the whole string once per localization string.
+    while (wzNext && NULL != (wzToken = wcsstr(wzNext, LOC_TOKEN_PREFIX)))
+    {
+        wzTokenEnd = wcschr(wzToken + LOC_TOKEN_PREFIX_LENGTH, L')');
+        if (!wzTokenEnd)
+        {
+            break;
+        }
+
+        hr = StrAllocString(&sczToken, wzToken, wzTokenEnd - wzToken + 1);
+        ExitOnFailure(hr, "Failed to copy localization token.");
+
+        hr = DictGetValue(pWixLoc->sdhLocStrings, sczToken, reinterpret_cast<void**>(&pLocString));
+        if (E_NOTFOUND == hr)
+        {
+            // Leave unknown tokens alone, but keep looking inside them for one that starts later.
+            wzNext = wzToken + 1;
+            continue;
+        }
+        ExitOnFailure(hr, "Failed to look up localization string: %ls", sczToken);
+
+        if (wzToken > wzCopied)
+        {
+            hr = StrAllocConcat(&sczOutput, wzCopied, wzToken - wzCopied);
+            ExitOnFailure(hr, "Failed to copy text before localization token.");
+        }
+
+        if (pLocString->wzText && *pLocString->wzText)
+        {
+            hr = StrAllocConcat(&sczOutput, pLocString->wzText, 0);
+            ExitOnFailure(hr, "Failed to copy localized text.");
+        }
+        else if (!sczOutput)
+        {
+            hr = StrAllocString(&sczOutput, L"", 0);
+            ExitOnFailure(hr, "Failed to allocate localized string.");
+        }
+
+        wzNext = wzCopied = wzTokenEnd + 1;
+    }
+
+    // Only replace the input if a token was localized.
+    if (sczOutput)
     {
-        hr = StrReplaceStringAll(ppsczInput, pWixLoc->rgLocStrings[i].wzId, pWixLoc->rgLocStrings[i].wzText);
-        ExitOnFailure(hr, "Localizing string failed.");
+        if (*wzCopied)
+        {
+            hr = StrAllocConcat(&sczOutput, wzCopied, 0);
+            ExitOnFailure(hr, "Failed to copy text after localization tokens.");
+        }
+
+        ReleaseStr(*ppsczInput);
+        *ppsczInput = sczOutput;
+        sczOutput = NULL;
     }
 
+    hr = S_OK;
+
 LExit:
+    ReleaseStr(sczOutput);
+    ReleaseStr(sczToken);
+
     return hr;
 }
 
@@ -296,18 +371,14 @@ extern "C" HRESULT DAPI LocGetControl(
     HRESULT hr = S_OK;
     LOC_CONTROL* pLocControl = NULL;
 
-    for (DWORD i = 0; i < pWixLoc->cLocControls; ++i)
+    hr = DictGetValue(pWixLoc->sdhLocControls, wzId, reinterpret_cast<void**>(&pLocControl));
+    if (E_NOTFOUND == hr)
     {
-        pLocControl = &pWixLoc->rgLocControls[i];
-
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pLocControl->wzControl, -1, wzId, -1))
-        {
-            *ppLocControl = pLocControl;
-            ExitFunction1(hr = S_OK);
-        }
+        ExitFunction();
     }
+    ExitOnFailure(hr, "Failed to look up localized control: %ls", wzId);
 
-    hr = E_NOTFOUND;
+    *ppLocControl = pLocControl;
 
 LExit:
     return hr;
@@ -319,21 +390,19 @@ extern "C" HRESULT DAPI LocGetString(
     __out LOC_STRING** ppLocString
     )
 {
-    HRESULT hr = E_NOTFOUND;
+    HRESULT hr = S_OK;
     LOC_STRING* pLocString = NULL;
 
-    for (DWORD i = 0; i < pWixLoc->cLocStrings; ++i)
+    hr = DictGetValue(pWixLoc->sdhLocStrings, wzId, reinterpret_cast<void**>(&pLocString));
+    if (E_NOTFOUND == hr)
     {
-        pLocString = pWixLoc->rgLocStrings + i;
-
-        if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pLocString->wzId, -1, wzId, -1))
-        {
-            *ppLocString = pLocString;
-            hr = S_OK;
-            break;
-        }
+        ExitFunction();
     }
+    ExitOnFailure(hr, "Failed to look up localization string: %ls", wzId);
 
+    *ppLocString = pLocString;
+
+LExit:
     return hr;
 }
 
@@ -360,6 +429,15 @@ extern "C" HRESULT DAPI LocAddString(
 
     pLocString->bOverridable = bOverridable;
 
+    if (!pWixLoc->sdhLocStrings)
+    {
+        hr = DictCreateWithEmbeddedKey(&pWixLoc->sdhLocStrings, pWixLoc->cLocStrings, reinterpret_cast<void**>(&pWixLoc->rgLocStrings), offsetof(LOC_STRING, wzId), DICT_FLAG_NONE);
+        ExitOnFailure(hr, "Failed to create index of localization strings.");
+    }
+
+    hr = AddToIndex(pWixLoc->sdhLocStrings, pLocString->wzId, pLocString);
+    ExitOnFailure(hr, "Failed to index localization string.");
+
 LExit:
     return hr;
 }
@@ -398,11 +476,19 @@ static HRESULT ParseWxl(
     hr = ParseWxlControls(pWxlElement, pWixLoc);
     ExitOnFailure(hr, "Parsing localization controls failed.");
 
+    hr = IndexWxl(pWixLoc);
+    ExitOnFailure(hr, "Indexing localization failed.");
+
     *ppWixLoc = pWixLoc;
     pWixLoc = NULL;
 
 LExit:
     ReleaseObject(pWxlElement);
+    if (pWixLoc)
+    {
+        ReleaseDict(pWixLoc->sdhLocStrings);
+        ReleaseDict(pWixLoc->sdhLocControls);
+    }
     ReleaseMem(pWixLoc);
 
     return hr;
@@ -611,3 +697,60 @@ LExit:
 
     return hr;
 }
+
+static HRESULT IndexWxl(
+    __in WIX_LOCALIZATION* pWixLoc
+    )
+{
+    HRESULT hr = S_OK;
+
+    hr = DictCreateWithEmbeddedKey(&pWixLoc->sdhLocStrings, pWixLoc->cLocStrings, reinterpret_cast<void**>(&pWixLoc->rgLocStrings), offsetof(LOC_STRING, wzId), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create index of localization strings.");
+
+    for (DWORD i = 0; i < pWixLoc->cLocStrings; ++i)
+    {
+        hr = AddToIndex(pWixLoc->sdhLocStrings, pWixLoc->rgLocStrings[i].wzId, pWixLoc->rgLocStrings + i);
+        ExitOnFailure(hr, "Failed to index localization string.");
+    }
+
+    hr = DictCreateWithEmbeddedKey(&pWixLoc->sdhLocControls, pWixLoc->cLocControls, reinterpret_cast<void**>(&pWixLoc->rgLocControls), offsetof(LOC_CONTROL, wzControl), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create index of localized controls.");
+
+    for (DWORD i = 0; i < pWixLoc->cLocControls; ++i)
+    {
+        hr = AddToIndex(pWixLoc->sdhLocControls, pWixLoc->rgLocControls[i].wzControl, pWixLoc->rgLocControls + i);
+        ExitOnFailure(hr, "Failed to index localized control.");
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT AddToIndex(
+    __in STRINGDICT_HANDLE sdhIndex,
+    __in_z_opt LPCWSTR wzKey,
+    __in void* pvValue
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (!wzKey)
+    {
+        ExitFunction();
+    }
+
+    // Duplicates keep the first entry, which is the one the linear search used to find.
+    hr = DictKeyExists(sdhIndex, wzKey);
+    if (E_NOTFOUND == hr)
+    {
+        hr = DictAddValue(sdhIndex, pvValue);
+        ExitOnFailure(hr, "Failed to add to localization index: %ls", wzKey);
+    }
+    else
+    {
+        ExitOnFailure(hr, "Failed to check localization index for: %ls", wzKey);
+    }
+
+LExit:
+    return hr;
+}
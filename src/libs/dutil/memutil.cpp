@@ -9,6 +9,68 @@
 static BOOL vfMemInitialized = FALSE;
 #endif
 
+// Arena allocations are preceded by a header holding their size, rounded up so the
+// allocation itself keeps the heap's alignment.
+#define MEM_ARENA_ALLOCATION_HEADER_SIZE roundup_typed(sizeof(MEM_ARENA_ALLOCATION), MEMORY_ALLOCATION_ALIGNMENT, SIZE_T)
+#define MEM_ARENA_BLOCK_HEADER_SIZE roundup_typed(sizeof(MEM_ARENA_BLOCK), MEMORY_ALLOCATION_ALIGNMENT, SIZE_T)
+
+typedef struct _MEM_ARENA_ALLOCATION
+{
+    SIZE_T cbSize;
+} MEM_ARENA_ALLOCATION;
+
+typedef struct _MEM_ARENA_BLOCK
+{
+    _MEM_ARENA_BLOCK* pNext;
+    BYTE* pbFree;
+    BYTE* pbEnd;
+} MEM_ARENA_BLOCK;
+
+typedef struct _MEM_ARENA
+{
+    MEM_ARENA_BLOCK* pBlocks; // the block being allocated from is first
+    SIZE_T cbBlock;
+
+    DWORD cAllocations;
+    DWORD cBlocks;
+    SIZE_T cbAllocated;
+} MEM_ARENA;
+
+// Arena blocks are committed out of one address range reserved for them, so MemFree() and
+// friends tell arena allocations from heap allocations with a bounds check and no lock. Each
+// bit in vrglArenaPages marks a page in use. A block never spans two words so it can be
+// claimed with a single interlocked compare and exchange.
+#define MEM_ARENA_PAGE_SIZE 4096
+#define MEM_ARENA_PAGES_PER_WORD 32
+#define MEM_ARENA_REGION_WORDS 256
+#define MEM_ARENA_REGION_SIZE (static_cast<SIZE_T>(MEM_ARENA_PAGE_SIZE) * MEM_ARENA_PAGES_PER_WORD * MEM_ARENA_REGION_WORDS)
+
+static BYTE* volatile vpbArenaRegion = NULL;
+static volatile LONG vrglArenaPages[MEM_ARENA_REGION_WORDS] = { };
+
+static HRESULT ArenaAddBlock(
+    __in MEM_ARENA* pArena,
+    __in SIZE_T cbRequired,
+    __out MEM_ARENA_BLOCK** ppBlock
+    );
+static void ArenaFreeBlock(
+    __in MEM_ARENA_BLOCK* pBlock
+    );
+static MEM_ARENA_ALLOCATION* ArenaGetAllocation(
+    __in LPCVOID pv
+    );
+static HRESULT ArenaEnsureRegion(
+    __out BYTE** ppbRegion
+    );
+static HRESULT ArenaClaimPages(
+    __in DWORD cPages,
+    __out DWORD* piPage
+    );
+static void ArenaReleasePages(
+    __in DWORD iPage,
+    __in DWORD cPages
+    );
+
 extern "C" HRESULT DAPI MemInitialize()
 {
 #if DEBUG
@@ -43,7 +105,29 @@ extern "C" LPVOID DAPI MemReAlloc(
 {
 //    AssertSz(vfMemInitialized, "MemInitialize() not called, this would normally crash");
     AssertSz(0 < cbSize, "MemReAlloc() called with invalid size");
-    return ::HeapReAlloc(::GetProcessHeap(), fZero ? HEAP_ZERO_MEMORY : 0, pv, cbSize);
+
+    LPVOID pvNew = NULL;
+    MEM_ARENA_ALLOCATION* pArenaAllocation = ArenaGetAllocation(pv);
+
+    if (!pArenaAllocation)
+    {
+        pvNew = ::HeapReAlloc(::GetProcessHeap(), fZero ? HEAP_ZERO_MEMORY : 0, pv, cbSize);
+    }
+    else if (cbSize <= pArenaAllocation->cbSize)
+    {
+        // Arena allocations never shrink.
+        pvNew = pv;
+    }
+    else // an arena allocation that grows moves to the heap, the old copy is freed with the arena.
+    {
+        pvNew = MemAlloc(cbSize, fZero);
+        if (pvNew)
+        {
+            memcpy(pvNew, pv, pArenaAllocation->cbSize);
+        }
+    }
+
+    return pvNew;
 }
 
 
@@ -63,7 +147,16 @@ extern "C" HRESULT DAPI MemReAllocSecure(
     LPVOID pvNew = NULL;
 
     dwFlags |= fZero ? HEAP_ZERO_MEMORY : 0;
-    pvNew = ::HeapReAlloc(::GetProcessHeap(), dwFlags, pv, cbSize);
+    if (ArenaGetAllocation(pv))
+    {
+        // Arena allocations can only be "reallocated in place" when they do not grow.
+        pvNew = cbSize <= MemSize(pv) ? pv : NULL;
+    }
+    else
+    {
+        pvNew = ::HeapReAlloc(::GetProcessHeap(), dwFlags, pv, cbSize);
+    }
+
     if (!pvNew)
     {
         pvNew = MemAlloc(cbSize, fZero);
@@ -310,6 +403,12 @@ extern "C" HRESULT DAPI MemFree(
     )
 {
 //    AssertSz(vfMemInitialized, "MemInitialize() not called, this would normally crash");
+    if (ArenaGetAllocation(pv))
+    {
+        // Freed with the rest of the arena.
+        return S_OK;
+    }
+
     return ::HeapFree(::GetProcessHeap(), 0, pv) ? S_OK : HRESULT_FROM_WIN32(::GetLastError());
 }
 
@@ -319,5 +418,302 @@ extern "C" SIZE_T DAPI MemSize(
     )
 {
 //    AssertSz(vfMemInitialized, "MemInitialize() not called, this would normally crash");
+    MEM_ARENA_ALLOCATION* pArenaAllocation = ArenaGetAllocation(pv);
+    if (pArenaAllocation)
+    {
+        return pArenaAllocation->cbSize;
+    }
+
     return ::HeapSize(::GetProcessHeap(), 0, pv);
 }
+
+
+/********************************************************************
+ MemArenaCreate - creates an arena that allocates out of blocks of
+                  cbBlock bytes.
+
+ NOTE: pass 0 for cbBlock to use MEM_ARENA_DEFAULT_BLOCK_SIZE.
+********************************************************************/
+extern "C" HRESULT DAPI MemArenaCreate(
+    __in SIZE_T cbBlock,
+    __out MEM_ARENA_HANDLE* phArena
+    )
+{
+    HRESULT hr = S_OK;
+    MEM_ARENA* pArena = NULL;
+
+    pArena = static_cast<MEM_ARENA*>(MemAlloc(sizeof(MEM_ARENA), TRUE));
+    ExitOnNull(pArena, hr, E_OUTOFMEMORY, "Failed to allocate arena.");
+
+    pArena->cbBlock = 0 == cbBlock ? MEM_ARENA_DEFAULT_BLOCK_SIZE : cbBlock;
+
+    *phArena = pArena;
+    pArena = NULL;
+
+LExit:
+    ReleaseMem(pArena);
+
+    return hr;
+}
+
+
+extern "C" LPVOID DAPI MemArenaAlloc(
+    __in MEM_ARENA_HANDLE hArena,
+    __in SIZE_T cbSize,
+    __in BOOL fZero
+    )
+{
+    AssertSz(0 < cbSize, "MemArenaAlloc() called with invalid size");
+
+    HRESULT hr = S_OK;
+    MEM_ARENA* pArena = static_cast<MEM_ARENA*>(hArena);
+    MEM_ARENA_BLOCK* pBlock = NULL;
+    MEM_ARENA_ALLOCATION* pAllocation = NULL;
+    SIZE_T cbRequired = 0;
+    LPVOID pv = NULL;
+
+    if (cbSize > MAXSIZE_T - MEM_ARENA_ALLOCATION_HEADER_SIZE - MEM_ARENA_BLOCK_HEADER_SIZE - MEMORY_ALLOCATION_ALIGNMENT)
+    {
+        ExitOnFailure(hr = E_OUTOFMEMORY, "Arena allocation is too large: %Iu", cbSize);
+    }
+
+    cbRequired = MEM_ARENA_ALLOCATION_HEADER_SIZE + roundup_typed(cbSize, MEMORY_ALLOCATION_ALIGNMENT, SIZE_T);
+
+    pBlock = pArena->pBlocks;
+    if (!pBlock || static_cast<SIZE_T>(pBlock->pbEnd - pBlock->pbFree) < cbRequired)
+    {
+        hr = ArenaAddBlock(pArena, cbRequired, &pBlock);
+        if (FAILED(hr))
+        {
+            // Too large for an arena block or the arena region is full, callers fall back to the heap.
+            ExitFunction();
+        }
+    }
+
+    pAllocation = reinterpret_cast<MEM_ARENA_ALLOCATION*>(pBlock->pbFree);
+    pAllocation->cbSize = cbSize;
+    pBlock->pbFree += cbRequired;
+
+    pv = reinterpret_cast<BYTE*>(pAllocation) + MEM_ARENA_ALLOCATION_HEADER_SIZE;
+    if (fZero)
+    {
+        memset(pv, 0, cbSize);
+    }
+
+    ++pArena->cAllocations;
+    pArena->cbAllocated += cbSize;
+
+LExit:
+    return pv;
+}
+
+
+extern "C" void DAPI MemArenaGetStatistics(
+    __in MEM_ARENA_HANDLE hArena,
+    __out_opt DWORD* pcAllocations,
+    __out_opt DWORD* pcBlocks,
+    __out_opt SIZE_T* pcbAllocated
+    )
+{
+    const MEM_ARENA* pArena = static_cast<const MEM_ARENA*>(hArena);
+
+    if (pcAllocations)
+    {
+        *pcAllocations = pArena->cAllocations;
+    }
+
+    if (pcBlocks)
+    {
+        *pcBlocks = pArena->cBlocks;
+    }
+
+    if (pcbAllocated)
+    {
+        *pcbAllocated = pArena->cbAllocated;
+    }
+}
+
+
+extern "C" void DAPI MemArenaDestroy(
+    __in MEM_ARENA_HANDLE hArena
+    )
+{
+    MEM_ARENA* pArena = static_cast<MEM_ARENA*>(hArena);
+    MEM_ARENA_BLOCK* pBlock = pArena->pBlocks;
+
+    while (pBlock)
+    {
+        MEM_ARENA_BLOCK* pNext = pBlock->pNext;
+
+        ArenaFreeBlock(pBlock);
+
+        pBlock = pNext;
+    }
+
+    MemFree(pArena);
+}
+
+
+static HRESULT ArenaAddBlock(
+    __in MEM_ARENA* pArena,
+    __in SIZE_T cbRequired,
+    __out MEM_ARENA_BLOCK** ppBlock
+    )
+{
+    HRESULT hr = S_OK;
+    SIZE_T cbBlock = roundup_typed(MEM_ARENA_BLOCK_HEADER_SIZE + max(pArena->cbBlock, cbRequired), MEM_ARENA_PAGE_SIZE, SIZE_T);
+    BYTE* pbRegion = NULL;
+    DWORD iPage = 0;
+    MEM_ARENA_BLOCK* pBlock = NULL;
+
+    if (cbBlock > MEM_ARENA_PAGE_SIZE * MEM_ARENA_PAGES_PER_WORD)
+    {
+        ExitFunction1(hr = E_OUTOFMEMORY);
+    }
+
+    hr = ArenaEnsureRegion(&pbRegion);
+    ExitOnFailure(hr, "Failed to reserve arena region.");
+
+    hr = ArenaClaimPages(static_cast<DWORD>(cbBlock / MEM_ARENA_PAGE_SIZE), &iPage);
+    if (FAILED(hr))
+    {
+        // The region is full, not an error worth tracing since callers fall back to the heap.
+        ExitFunction();
+    }
+
+    pBlock = static_cast<MEM_ARENA_BLOCK*>(::VirtualAlloc(pbRegion + static_cast<SIZE_T>(iPage) * MEM_ARENA_PAGE_SIZE, cbBlock, MEM_COMMIT, PAGE_READWRITE));
+    if (!pBlock)
+    {
+        ArenaReleasePages(iPage, static_cast<DWORD>(cbBlock / MEM_ARENA_PAGE_SIZE));
+        ExitWithLastError(hr, "Failed to commit arena block of size: %Iu", cbBlock);
+    }
+
+    pBlock->pbFree = reinterpret_cast<BYTE*>(pBlock) + MEM_ARENA_BLOCK_HEADER_SIZE;
+    pBlock->pbEnd = reinterpret_cast<BYTE*>(pBlock) + cbBlock;
+
+    // An oversized allocation gets a block of its own behind the current one so the rest of
+    // the current block is not wasted.
+    if (pArena->pBlocks && cbRequired > pArena->cbBlock)
+    {
+        pBlock->pNext = pArena->pBlocks->pNext;
+        pArena->pBlocks->pNext = pBlock;
+    }
+    else
+    {
+        pBlock->pNext = pArena->pBlocks;
+        pArena->pBlocks = pBlock;
+    }
+
+    *ppBlock = pBlock;
+    ++pArena->cBlocks;
+
+LExit:
+    return hr;
+}
+
+static void ArenaFreeBlock(
+    __in MEM_ARENA_BLOCK* pBlock
+    )
+{
+    SIZE_T cbBlock = pBlock->pbEnd - reinterpret_cast<BYTE*>(pBlock);
+    DWORD iPage = static_cast<DWORD>((reinterpret_cast<BYTE*>(pBlock) - vpbArenaRegion) / MEM_ARENA_PAGE_SIZE);
+
+    // Decommit before the pages can be claimed again.
+    ::VirtualFree(pBlock, cbBlock, MEM_DECOMMIT);
+    ArenaReleasePages(iPage, static_cast<DWORD>(cbBlock / MEM_ARENA_PAGE_SIZE));
+}
+
+static MEM_ARENA_ALLOCATION* ArenaGetAllocation(
+    __in LPCVOID pv
+    )
+{
+    const BYTE* pb = static_cast<const BYTE*>(pv);
+    const BYTE* pbRegion = vpbArenaRegion;
+
+    // Nothing but arena blocks is ever committed in the region.
+    if (pbRegion && pb >= pbRegion && pb < pbRegion + MEM_ARENA_REGION_SIZE)
+    {
+        return reinterpret_cast<MEM_ARENA_ALLOCATION*>(const_cast<BYTE*>(pb) - MEM_ARENA_ALLOCATION_HEADER_SIZE);
+    }
+
+    return NULL;
+}
+
+static HRESULT ArenaEnsureRegion(
+    __out BYTE** ppbRegion
+    )
+{
+    HRESULT hr = S_OK;
+    BYTE* pbRegion = vpbArenaRegion;
+
+    if (!pbRegion)
+    {
+        // Only address space is reserved, pages are committed as blocks need them.
+        pbRegion = static_cast<BYTE*>(::VirtualAlloc(NULL, MEM_ARENA_REGION_SIZE, MEM_RESERVE, PAGE_NOACCESS));
+        ExitOnNullWithLastError(pbRegion, hr, "Failed to reserve arena region.");
+
+        // Another thread may have won the race, if so use its region.
+        BYTE* pbExisting = static_cast<BYTE*>(::InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&vpbArenaRegion), pbRegion, NULL));
+        if (pbExisting)
+        {
+            ::VirtualFree(pbRegion, 0, MEM_RELEASE);
+            pbRegion = pbExisting;
+        }
+    }
+
+    *ppbRegion = pbRegion;
+
+LExit:
+    return hr;
+}
+
+static HRESULT ArenaClaimPages(
+    __in DWORD cPages,
+    __out DWORD* piPage
+    )
+{
+    DWORD dwRun = MEM_ARENA_PAGES_PER_WORD == cPages ? 0xFFFFFFFF : (1UL << cPages) - 1;
+
+    for (DWORD iWord = 0; iWord < MEM_ARENA_REGION_WORDS; ++iWord)
+    {
+        LONG lPages = vrglArenaPages[iWord];
+
+        for (DWORD iBit = 0; iBit + cPages <= MEM_ARENA_PAGES_PER_WORD; )
+        {
+            DWORD dwMask = dwRun << iBit;
+
+            if (static_cast<DWORD>(lPages) & dwMask)
+            {
+                ++iBit;
+                continue;
+            }
+
+            LONG lPrevious = ::InterlockedCompareExchange(&vrglArenaPages[iWord], lPages | static_cast<LONG>(dwMask), lPages);
+            if (lPrevious == lPages)
+            {
+                *piPage = iWord * MEM_ARENA_PAGES_PER_WORD + iBit;
+                return S_OK;
+            }
+
+            // Another block changed the word, look again from the same bit.
+            lPages = lPrevious;
+        }
+    }
+
+    return E_OUTOFMEMORY;
+}
+
+static void ArenaReleasePages(
+    __in DWORD iPage,
+    __in DWORD cPages
+    )
+{
+    DWORD iWord = iPage / MEM_ARENA_PAGES_PER_WORD;
+    DWORD dwMask = (MEM_ARENA_PAGES_PER_WORD == cPages ? 0xFFFFFFFF : (1UL << cPages) - 1) << (iPage % MEM_ARENA_PAGES_PER_WORD);
+    LONG lPages = 0;
+
+    do
+    {
+        lPages = vrglArenaPages[iWord];
+    } while (lPages != ::InterlockedCompareExchange(&vrglArenaPages[iWord], lPages & ~static_cast<LONG>(dwMask), lPages));
+}
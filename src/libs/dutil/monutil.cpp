@@ -2,21 +2,23 @@
 
 #include "precomp.h"
 
-const int MON_THREAD_GROWTH = 5;
 const int MON_ARRAY_GROWTH = 40;
-const int MON_MAX_MONITORS_PER_THREAD = 63;
 const int MON_THREAD_INIT_RETRIES = 1000;
 const int MON_THREAD_INIT_RETRY_PERIOD_IN_MS = 10;
 const int MON_THREAD_NETWORK_FAIL_RETRY_IN_MS = 1000*60; // if we know we failed to connect, retry every minute
 const int MON_THREAD_NETWORK_SUCCESSFUL_RETRY_IN_MS = 1000*60*20; // if we're just checking for remote servers dieing, check much less frequently
 const int MON_THREAD_WAIT_REMOVE_DEVICE = 5000;
+const int MON_THREAD_WAIT_CANCELLED_IN_MS = 5000; // how long the waiter thread waits on shutdown for cancelled directory reads to complete
+const int MON_COMPLETION_BATCH = 64; // completions dequeued before the silence period timers are checked again
+const int MON_DIRECTORY_BUFFER_SIZE = 1024; // the changes themselves are never read, and a read whose buffer overflows still completes
+const int MON_TIMER_WHEEL_SLOTS = 256; // this and the resolution must be powers of two, so slots stay in order when GetTickCount() wraps
+const int MON_TIMER_WHEEL_RESOLUTION_IN_MS = 16;
 const LPCWSTR MONUTIL_WINDOW_CLASS = L"MonUtilClass";
 
 enum MON_MESSAGE
 {
     MON_MESSAGE_ADD = WM_APP + 1,
     MON_MESSAGE_REMOVE,
-    MON_MESSAGE_REMOVED, // Sent by waiter thread back to coordinator thread to indicate a remove occurred
     MON_MESSAGE_NETWORK_WAIT_FAILED, // Sent by waiter thread back to coordinator thread to indicate a network wait failed. Coordinator thread will periodically trigger retries (via MON_MESSAGE_NETWORK_STATUS_UPDATE messages).
     MON_MESSAGE_NETWORK_WAIT_SUCCEEDED, // Sent by waiter thread back to coordinator thread to indicate a previously failing network wait is now succeeding. Coordinator thread will stop triggering retries if no other failing waits exist.
     MON_MESSAGE_NETWORK_STATUS_UPDATE, // Some change to network connectivity occurred (a network connection was connected or disconnected for example)
@@ -39,6 +41,14 @@ enum MON_TYPE
     MON_REGKEY = 2
 };
 
+enum MON_COMPLETION_KEY
+{
+    MON_COMPLETION_KEY_MESSAGE = 1, // Thread messages were posted to the waiter thread
+    MON_COMPLETION_KEY_WAIT, // A directory read or registry notification completed, the overlapped pointer is its MON_WAIT
+};
+
+struct MON_WAIT;
+
 struct MON_REQUEST
 {
     MON_TYPE type;
@@ -60,11 +70,18 @@ struct MON_REQUEST
     LPWSTR *rgsczPathHierarchy;
     DWORD cPathHierarchy;
 
-    // If the notify fires, fPendingFire gets set to TRUE, and we wait to see if other writes are occurring, and only after the configured silence period do we notify of changes
-    // after notification, we set fPendingFire back to FALSE
+    // The outstanding directory read or registry notification, NULL while the request is failing
+    MON_WAIT *pWait;
+
+    // Signaled by the waiter thread once it started watching, so the thread that added the request doesn't miss changes it makes right away
+    HANDLE hAdded;
+
+    // If the notify fires, fPendingFire gets set to TRUE and the request goes in the timer wheel until it has been "silent" for the silence period.
+    // Each further change pushes dwFireTime out again. After notification, we set fPendingFire back to FALSE
     BOOL fPendingFire;
-    BOOL fSkipDeltaAdd;
-    DWORD dwSilencePeriodInMs;
+    DWORD dwFireTime;
+    DWORD dwTimerSlot;
+    MON_REQUEST *pNextTimer;
 
     union
     {
@@ -80,10 +97,39 @@ struct MON_REQUEST
     };
 };
 
-struct MON_ADD_MESSAGE
+// A single directory read or registry notification. Its completion can still be queued after the request moved on to a new wait
+// or was removed, so an abandoned wait stays allocated until the waiter thread dequeues that completion.
+struct MON_WAIT
+{
+    OVERLAPPED overlapped; // Must be first, completions hand back a pointer to it
+    MON_REQUEST *pRequest; // NULL once abandoned
+    MON_TYPE type;
+    BOOL fPending; // A completion for this wait is or will be queued to the completion port
+
+    union
+    {
+        struct
+        {
+            HANDLE hDirectory;
+            BYTE *pbBuffer; // MON_DIRECTORY_BUFFER_SIZE bytes allocated right after this struct
+        } directory;
+        struct
+        {
+            HANDLE hEvent;
+            HANDLE hRegisteredWait;
+            HANDLE hCompletionPort;
+            volatile LONG fPosted; // Set by the thread pool callback once it queued the completion
+        } regkey;
+    };
+};
+
+// Requests waiting out their silence period, chained into slots by the time they're due. The waiter thread only looks at
+// the slots it passes, so a change costs the same no matter how many requests are being monitored.
+struct MON_TIMER_WHEEL
 {
-    MON_REQUEST request;
-    HANDLE handle;
+    MON_REQUEST *rgpSlots[MON_TIMER_WHEEL_SLOTS];
+    DWORD dwLastTime;
+    DWORD cPending;
 };
 
 struct MON_REMOVE_MESSAGE
@@ -114,6 +160,10 @@ struct MON_WAITER_CONTEXT
     DWORD dwWaiterThreadId;
     BOOL fWaiterThreadMessageQueueInitialized;
 
+    // Every directory read and registry notification completes to this port, and it is also used to wake the
+    // waiter thread when a message was posted to it
+    HANDLE hCompletionPort;
+
     // Callbacks
     PFN_MONGENERAL vpfMonGeneral;
     PFN_MONDIRECTORY vpfMonDirectory;
@@ -122,29 +172,15 @@ struct MON_WAITER_CONTEXT
     // Context for callbacks
     LPVOID pvContext;
 
-    // HANDLEs are in their own array for easy use with WaitForMultipleObjects()
-    // After initialization, the very first handle is just to wake the listener thread to have it re-wait on a new list
-    // Because this array is read by both coordinator thread and waiter thread, to avoid locking between both threads, it must start at the maximum size
-    HANDLE *rgHandles;
-    DWORD cHandles;
-
     // Requested things to monitor
-    MON_REQUEST *rgRequests;
+    MON_REQUEST **rgpRequests;
     DWORD cRequests;
 
-    // Number of pending notifications
-    DWORD cRequestsPending;
-
-    // Number of requests in a failed state (couldn't initiate wait)
-    DWORD cRequestsFailing;
-};
-
-// Info stored about each waiter by the coordinator
-struct MON_WAITER_INFO
-{
-    DWORD cMonitorCount;
+    // Number of waits whose completion hasn't been dequeued yet, including abandoned ones
+    DWORD cWaitsPending;
 
-    MON_WAITER_CONTEXT *pWaiterContext;
+    // Pending notifications
+    MON_TIMER_WHEEL timers;
 };
 
 // This struct is used when Thread A wants to send a task to another thread B (and get notified when the task finishes)
@@ -176,7 +212,7 @@ struct MON_STRUCT
 
     // Invisible window for receiving network status & drive added/removal messages
     HWND hwnd;
-    // Used by window procedure for sending request and waiting for response from waiter threads
+    // Used by window procedure for sending request and waiting for response from waiter thread
     // such as in event of a request to remove a device
     MON_INTERNAL_TEMPORARY_WAIT internalWait;
 
@@ -189,9 +225,8 @@ struct MON_STRUCT
     // Context for callbacks
     LPVOID pvContext;
 
-    // Waiter thread array
-    MON_WAITER_INFO *rgWaiterThreads;
-    DWORD cWaiterThreads;
+    // The single waiter thread, which watches every request through one completion port
+    MON_WAITER_CONTEXT *pWaiterContext;
 };
 
 const int MON_HANDLE_BYTES = sizeof(MON_STRUCT);
@@ -199,26 +234,98 @@ const int MON_HANDLE_BYTES = sizeof(MON_STRUCT);
 static DWORD WINAPI CoordinatorThread(
     __in_bcount(sizeof(MON_STRUCT)) LPVOID pvContext
     );
-// Initiates (or if *pHandle is non-null, continues) wait on the directory or subkey
+static HRESULT WaiterCreate(
+    __in MON_STRUCT *pm
+    );
+static void WaiterDestroy(
+    __in MON_STRUCT *pm
+    );
+static HRESULT PostWaiterMessage(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in UINT uMsg,
+    __in WPARAM wParam,
+    __in LPARAM lParam
+    );
+static HRESULT WakeWaiter(
+    __in MON_WAITER_CONTEXT *pWaiterContext
+    );
+// Hands the request to the waiter thread, and unless called from the waiter thread, waits until it is being watched
+static HRESULT SendAddRequest(
+    __in MON_STRUCT *pm,
+    __inout MON_REQUEST **ppRequest
+    );
+// Initiates (or if the request already has a wait, restarts) wait on the directory or subkey
 // if the directory or subkey doesn't exist, instead calls it on the first existing parent directory or subkey
 // writes to pRequest->dwPathHierarchyIndex with the array index that was waited on
 static HRESULT InitiateWait(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST *pRequest
+    );
+static HRESULT StartDirectoryWait(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
     __inout MON_REQUEST *pRequest,
-    __inout HANDLE *pHandle
+    __in DWORD dwIndex
+    );
+static HRESULT WaitCreate(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in MON_REQUEST *pRequest,
+    __out MON_WAIT **ppWait
+    );
+// Detaches the request from its wait, which is freed now or when its completion is dequeued
+static void AbandonWait(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST *pRequest
+    );
+static void WaitDestroy(
+    __in_opt MON_WAIT *pWait
+    );
+static VOID CALLBACK RegKeyWaitCallback(
+    __in PVOID pvContext,
+    __in BOOLEAN fTimedOut
     );
 static DWORD WINAPI WaiterThread(
     __in_bcount(sizeof(MON_WAITER_CONTEXT)) LPVOID pvContext
     );
+static HRESULT ProcessWaiterMessages(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST **ppAddRequest,
+    __inout MON_REMOVE_MESSAGE **ppRemoveMessage,
+    __out BOOL *pfStop
+    );
+static HRESULT WaitCompleted(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in MON_WAIT *pWait
+    );
+static void TimerWheelSchedule(
+    __inout MON_TIMER_WHEEL *pTimers,
+    __inout MON_REQUEST *pRequest,
+    __in DWORD dwNow
+    );
+static void TimerWheelInsert(
+    __inout MON_TIMER_WHEEL *pTimers,
+    __inout MON_REQUEST *pRequest
+    );
+static void TimerWheelRemove(
+    __inout MON_TIMER_WHEEL *pTimers,
+    __inout MON_REQUEST *pRequest
+    );
+// Notifies every request whose silence period has elapsed
+static void TimerWheelAdvance(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in DWORD dwNow
+    );
+// Returns how long the waiter thread can wait before it has to advance the wheel again
+static DWORD TimerWheelGetWait(
+    __in MON_TIMER_WHEEL *pTimers,
+    __in DWORD dwNow
+    );
 static void Notify(
     __in HRESULT hr,
     __in MON_WAITER_CONTEXT *pWaiterContext,
     __in MON_REQUEST *pRequest
     );
 static void MonRequestDestroy(
-    __in MON_REQUEST *pRequest
-    );
-static void MonAddMessageDestroy(
-    __in MON_ADD_MESSAGE *pMessage
+    __in_opt MON_REQUEST *pRequest
     );
 static void MonRemoveMessageDestroy(
     __in MON_REMOVE_MESSAGE *pMessage
@@ -232,17 +339,13 @@ static HRESULT FindRequestIndex(
     __in MON_REMOVE_MESSAGE *pMessage,
     __out DWORD *pdwIndex
     );
-static HRESULT RemoveRequest(
+static void RemoveRequest(
     __inout MON_WAITER_CONTEXT *pWaiterContext,
     __in DWORD dwRequestIndex
     );
 static REGSAM GetRegKeyBitness(
     __in MON_REQUEST *pRequest
     );
-static HRESULT DuplicateRemoveMessage(
-    __in MON_REMOVE_MESSAGE *pMessage,
-    __out MON_REMOVE_MESSAGE **ppMessage
-    );
 static LRESULT CALLBACK MonWndProc(
     __in HWND hWnd,
     __in UINT uMsg,
@@ -261,8 +364,7 @@ static HRESULT WaitForNetworkChanges(
 static HRESULT UpdateWaitStatus(
     __in HRESULT hrNewStatus,
     __inout MON_WAITER_CONTEXT *pWaiterContext,
-    __in DWORD dwRequestIndex,
-    __out DWORD *pdwNewRequestIndex
+    __inout MON_REQUEST *pRequest
     );
 
 extern "C" HRESULT DAPI MonCreate(
@@ -291,11 +393,21 @@ extern "C" HRESULT DAPI MonCreate(
     pm->vpfMonRegKey = vpfMonRegKey;
     pm->pvContext = pvContext;
 
+    hr = WaiterCreate(pm);
+    if (FAILED(hr))
+    {
+        WaiterDestroy(pm);
+        ExitOnFailure(hr, "Failed to create waiter thread.");
+    }
+
     pm->hCoordinatorThread = ::CreateThread(NULL, 0, CoordinatorThread, pm, 0, &pm->dwCoordinatorThreadId);
     if (!pm->hCoordinatorThread)
     {
-        ExitWithLastError(hr, "Failed to create waiter thread.");
+        hr = HRESULT_FROM_WIN32(::GetLastError());
+        WaiterDestroy(pm);
+        ExitOnFailure(hr, "Failed to create coordinator thread.");
     }
+    pm->pWaiterContext->dwCoordinatorThreadId = pm->dwCoordinatorThreadId;
 
     // Ensure the created thread initializes its message queue. It does this first thing, so if it doesn't within 10 seconds, there must be a huge problem.
     while (!pm->fCoordinatorThreadMessageQueueInitialized && 0 < dwRetries)
@@ -307,7 +419,7 @@ extern "C" HRESULT DAPI MonCreate(
     if (0 == dwRetries)
     {
         hr = E_UNEXPECTED;
-        ExitOnFailure(hr, "Waiter thread apparently never initialized its message queue.");
+        ExitOnFailure(hr, "Coordinator thread apparently never initialized its message queue.");
     }
 
 LExit:
@@ -326,7 +438,7 @@ extern "C" HRESULT DAPI MonAddDirectory(
     MON_STRUCT *pm = static_cast<MON_STRUCT *>(handle);
     LPWSTR sczDirectory = NULL;
     LPWSTR sczOriginalPathRequest = NULL;
-    MON_ADD_MESSAGE *pMessage = NULL;
+    MON_REQUEST *pRequest = NULL;
 
     hr = StrAllocString(&sczOriginalPathRequest, wzDirectory, 0);
     ExitOnFailure(hr, "Failed to convert directory string to UNC path");
@@ -334,19 +446,19 @@ extern "C" HRESULT DAPI MonAddDirectory(
     hr = PathBackslashTerminate(&sczOriginalPathRequest);
     ExitOnFailure(hr, "Failed to ensure directory ends in backslash");
 
-    pMessage = reinterpret_cast<MON_ADD_MESSAGE *>(MemAlloc(sizeof(MON_ADD_MESSAGE), TRUE));
-    ExitOnNull(pMessage, hr, E_OUTOFMEMORY, "Failed to allocate memory for message");
+    pRequest = reinterpret_cast<MON_REQUEST *>(MemAlloc(sizeof(MON_REQUEST), TRUE));
+    ExitOnNull(pRequest, hr, E_OUTOFMEMORY, "Failed to allocate memory for request");
 
     if (sczOriginalPathRequest[0] == L'\\' && sczOriginalPathRequest[1] == L'\\')
     {
-        pMessage->request.fNetwork = TRUE;
+        pRequest->fNetwork = TRUE;
     }
     else
     {
         hr = UncConvertFromMountedDrive(&sczDirectory, sczOriginalPathRequest);
         if (SUCCEEDED(hr))
         {
-            pMessage->request.fNetwork = TRUE;
+            pRequest->fNetwork = TRUE;
         }
     }
 
@@ -359,32 +471,27 @@ extern "C" HRESULT DAPI MonAddDirectory(
         ExitOnFailure(hr, "Failed to copy original path request: %ls", sczOriginalPathRequest);
     }
 
-    pMessage->handle = INVALID_HANDLE_VALUE;
-    pMessage->request.type = MON_DIRECTORY;
-    pMessage->request.fRecursive = fRecursive;
-    pMessage->request.dwMaxSilencePeriodInMs = dwSilencePeriodInMs;
-    pMessage->request.hwnd = pm->hwnd;
-    pMessage->request.pvContext = pvDirectoryContext;
-    pMessage->request.sczOriginalPathRequest = sczOriginalPathRequest;
+    pRequest->type = MON_DIRECTORY;
+    pRequest->fRecursive = fRecursive;
+    pRequest->dwMaxSilencePeriodInMs = dwSilencePeriodInMs;
+    pRequest->hwnd = pm->hwnd;
+    pRequest->pvContext = pvDirectoryContext;
+    pRequest->sczOriginalPathRequest = sczOriginalPathRequest;
     sczOriginalPathRequest = NULL;
 
-    hr = PathGetHierarchyArray(sczDirectory, &pMessage->request.rgsczPathHierarchy, reinterpret_cast<LPUINT>(&pMessage->request.cPathHierarchy));
+    hr = PathGetHierarchyArray(sczDirectory, &pRequest->rgsczPathHierarchy, reinterpret_cast<LPUINT>(&pRequest->cPathHierarchy));
     ExitOnFailure(hr, "Failed to get hierarchy array for path %ls", sczDirectory);
 
-    if (0 < pMessage->request.cPathHierarchy)
+    if (0 < pRequest->cPathHierarchy)
     {
-        pMessage->request.hrStatus = InitiateWait(&pMessage->request, &pMessage->handle);
-        if (!::PostThreadMessageW(pm->dwCoordinatorThreadId, MON_MESSAGE_ADD, reinterpret_cast<WPARAM>(pMessage), 0))
-        {
-            ExitWithLastError(hr, "Failed to send message to worker thread to add directory wait for path %ls", sczDirectory);
-        }
-        pMessage = NULL;
+        hr = SendAddRequest(pm, &pRequest);
+        ExitOnFailure(hr, "Failed to add directory wait for path %ls", sczDirectory);
     }
 
 LExit:
     ReleaseStr(sczDirectory);
     ReleaseStr(sczOriginalPathRequest);
-    MonAddMessageDestroy(pMessage);
+    MonRequestDestroy(pRequest);
 
     return hr;
 }
@@ -402,7 +509,7 @@ extern "C" HRESULT DAPI MonAddRegKey(
     HRESULT hr = S_OK;
     MON_STRUCT *pm = static_cast<MON_STRUCT *>(handle);
     LPWSTR sczSubKey = NULL;
-    MON_ADD_MESSAGE *pMessage = NULL;
+    MON_REQUEST *pRequest = NULL;
 
     hr = StrAllocString(&sczSubKey, wzSubKey, 0);
     ExitOnFailure(hr, "Failed to copy subkey string");
@@ -410,38 +517,29 @@ extern "C" HRESULT DAPI MonAddRegKey(
     hr = PathBackslashTerminate(&sczSubKey);
     ExitOnFailure(hr, "Failed to ensure subkey path ends in backslash");
 
-    pMessage = reinterpret_cast<MON_ADD_MESSAGE *>(MemAlloc(sizeof(MON_ADD_MESSAGE), TRUE));
-    ExitOnNull(pMessage, hr, E_OUTOFMEMORY, "Failed to allocate memory for message");
-
-    pMessage->handle = ::CreateEventW(NULL, TRUE, FALSE, NULL);
-    ExitOnNullWithLastError(pMessage->handle, hr, "Failed to create anonymous event for regkey monitor");
+    pRequest = reinterpret_cast<MON_REQUEST *>(MemAlloc(sizeof(MON_REQUEST), TRUE));
+    ExitOnNull(pRequest, hr, E_OUTOFMEMORY, "Failed to allocate memory for request");
 
-    pMessage->request.type = MON_REGKEY;
-    pMessage->request.regkey.hkRoot = hkRoot;
-    pMessage->request.regkey.kbKeyBitness = kbKeyBitness;
-    pMessage->request.fRecursive = fRecursive;
-    pMessage->request.dwMaxSilencePeriodInMs = dwSilencePeriodInMs,
-    pMessage->request.hwnd = pm->hwnd;
-    pMessage->request.pvContext = pvRegKeyContext;
+    pRequest->type = MON_REGKEY;
+    pRequest->regkey.hkRoot = hkRoot;
+    pRequest->regkey.kbKeyBitness = kbKeyBitness;
+    pRequest->fRecursive = fRecursive;
+    pRequest->dwMaxSilencePeriodInMs = dwSilencePeriodInMs,
+    pRequest->hwnd = pm->hwnd;
+    pRequest->pvContext = pvRegKeyContext;
 
-    hr = PathGetHierarchyArray(sczSubKey, &pMessage->request.rgsczPathHierarchy, reinterpret_cast<LPUINT>(&pMessage->request.cPathHierarchy));
+    hr = PathGetHierarchyArray(sczSubKey, &pRequest->rgsczPathHierarchy, reinterpret_cast<LPUINT>(&pRequest->cPathHierarchy));
     ExitOnFailure(hr, "Failed to get hierarchy array for subkey %ls", sczSubKey);
 
-    if (0 < pMessage->request.cPathHierarchy)
+    if (0 < pRequest->cPathHierarchy)
     {
-        pMessage->request.hrStatus = InitiateWait(&pMessage->request, &pMessage->handle);
-        ExitOnFailure(hr, "Failed to initiate wait");
-
-        if (!::PostThreadMessageW(pm->dwCoordinatorThreadId, MON_MESSAGE_ADD, reinterpret_cast<WPARAM>(pMessage), 0))
-        {
-            ExitWithLastError(hr, "Failed to send message to worker thread to add directory wait for regkey %ls", sczSubKey);
-        }
-        pMessage = NULL;
+        hr = SendAddRequest(pm, &pRequest);
+        ExitOnFailure(hr, "Failed to add wait for regkey %ls", sczSubKey);
     }
 
 LExit:
     ReleaseStr(sczSubKey);
-    MonAddMessageDestroy(pMessage);
+    MonRequestDestroy(pRequest);
 
     return hr;
 }
@@ -472,13 +570,17 @@ extern "C" HRESULT DAPI MonRemoveDirectory(
     hr = StrAllocString(&pMessage->directory.sczDirectory, sczDirectory, 0);
     ExitOnFailure(hr, "Failed to allocate copy of directory string");
 
-    if (!::PostThreadMessageW(pm->dwCoordinatorThreadId, MON_MESSAGE_REMOVE, reinterpret_cast<WPARAM>(pMessage), 0))
+    if (!::PostThreadMessageW(pm->pWaiterContext->dwWaiterThreadId, MON_MESSAGE_REMOVE, reinterpret_cast<WPARAM>(pMessage), 0))
     {
-        ExitWithLastError(hr, "Failed to send message to worker thread to add directory wait for path %ls", sczDirectory);
+        ExitWithLastError(hr, "Failed to send message to waiter thread to remove directory wait for path %ls", sczDirectory);
     }
     pMessage = NULL;
 
+    hr = WakeWaiter(pm->pWaiterContext);
+    ExitOnFailure(hr, "Failed to wake waiter thread to remove directory wait for path %ls", sczDirectory);
+
 LExit:
+    ReleaseStr(sczDirectory);
     MonRemoveMessageDestroy(pMessage);
 
     return hr;
@@ -514,12 +616,15 @@ extern "C" HRESULT DAPI MonRemoveRegKey(
     hr = StrAllocString(&pMessage->regkey.sczSubKey, sczSubKey, 0);
     ExitOnFailure(hr, "Failed to allocate copy of directory string");
 
-    if (!::PostThreadMessageW(pm->dwCoordinatorThreadId, MON_MESSAGE_REMOVE, reinterpret_cast<WPARAM>(pMessage), 0))
+    if (!::PostThreadMessageW(pm->pWaiterContext->dwWaiterThreadId, MON_MESSAGE_REMOVE, reinterpret_cast<WPARAM>(pMessage), 0))
     {
-        ExitWithLastError(hr, "Failed to send message to worker thread to add directory wait for path %ls", sczSubKey);
+        ExitWithLastError(hr, "Failed to send message to waiter thread to remove wait for regkey %ls", sczSubKey);
     }
     pMessage = NULL;
 
+    hr = WakeWaiter(pm->pWaiterContext);
+    ExitOnFailure(hr, "Failed to wake waiter thread to remove wait for regkey %ls", sczSubKey);
+
 LExit:
     ReleaseStr(sczSubKey);
     MonRemoveMessageDestroy(pMessage);
@@ -557,7 +662,7 @@ LExit:
 }
 
 static void MonRequestDestroy(
-    __in MON_REQUEST *pRequest
+    __in_opt MON_REQUEST *pRequest
     )
 {
     if (NULL != pRequest)
@@ -573,26 +678,8 @@ static void MonRequestDestroy(
         }
         ReleaseStr(pRequest->sczOriginalPathRequest);
         ReleaseStrArray(pRequest->rgsczPathHierarchy, pRequest->cPathHierarchy);
-    }
-}
-
-static void MonAddMessageDestroy(
-    __in MON_ADD_MESSAGE *pMessage
-    )
-{
-    if (NULL != pMessage)
-    {
-        MonRequestDestroy(&pMessage->request);
-        if (MON_DIRECTORY == pMessage->request.type && INVALID_HANDLE_VALUE != pMessage->handle)
-        {
-            ::FindCloseChangeNotification(pMessage->handle);
-        }
-        else if (MON_REGKEY == pMessage->request.type)
-        {
-            ReleaseHandle(pMessage->handle);
-        }
 
-        ReleaseMem(pMessage);
+        ReleaseMem(pRequest);
     }
 }
 
@@ -624,12 +711,7 @@ static DWORD WINAPI CoordinatorThread(
 {
     HRESULT hr = S_OK;
     MSG msg = { };
-    DWORD dwThreadIndex = DWORD_MAX;
-    DWORD dwRetries;
     DWORD dwFailingNetworkWaits = 0;
-    MON_WAITER_CONTEXT *pWaiterContext = NULL;
-    MON_REMOVE_MESSAGE *pRemoveMessage = NULL;
-    MON_REMOVE_MESSAGE *pTempRemoveMessage = NULL;
     MON_STRUCT *pm = reinterpret_cast<MON_STRUCT*>(pvContext);
     WSADATA wsaData = { };
     HANDLE hMonitor = NULL;
@@ -666,124 +748,6 @@ static DWORD WINAPI CoordinatorThread(
         {
             switch (msg.message)
             {
-            case MON_MESSAGE_ADD:
-                dwThreadIndex = DWORD_MAX;
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    if (pm->rgWaiterThreads[i].cMonitorCount < MON_MAX_MONITORS_PER_THREAD)
-                    {
-                        dwThreadIndex = i;
-                        break;
-                    }
-                }
-
-                if (dwThreadIndex < pm->cWaiterThreads)
-                {
-                    pWaiterContext = pm->rgWaiterThreads[dwThreadIndex].pWaiterContext;
-                }
-                else
-                {
-                    hr = MemEnsureArraySize(reinterpret_cast<void **>(&pm->rgWaiterThreads), pm->cWaiterThreads + 1, sizeof(MON_WAITER_INFO), MON_THREAD_GROWTH);
-                    ExitOnFailure(hr, "Failed to grow waiter thread array size");
-                    ++pm->cWaiterThreads;
-
-                    dwThreadIndex = pm->cWaiterThreads - 1;
-                    pm->rgWaiterThreads[dwThreadIndex].pWaiterContext = reinterpret_cast<MON_WAITER_CONTEXT*>(MemAlloc(sizeof(MON_WAITER_CONTEXT), TRUE));
-                    ExitOnNull(pm->rgWaiterThreads[dwThreadIndex].pWaiterContext, hr, E_OUTOFMEMORY, "Failed to allocate waiter context struct");
-                    pWaiterContext = pm->rgWaiterThreads[dwThreadIndex].pWaiterContext;
-                    pWaiterContext->dwCoordinatorThreadId = ::GetCurrentThreadId();
-                    pWaiterContext->vpfMonGeneral = pm->vpfMonGeneral;
-                    pWaiterContext->vpfMonDirectory = pm->vpfMonDirectory;
-                    pWaiterContext->vpfMonRegKey = pm->vpfMonRegKey;
-                    pWaiterContext->pvContext = pm->pvContext;
-
-                    hr = MemEnsureArraySize(reinterpret_cast<void **>(&pWaiterContext->rgHandles), MON_MAX_MONITORS_PER_THREAD + 1, sizeof(HANDLE), 0);
-                    ExitOnFailure(hr, "Failed to allocate first handle");
-                    pWaiterContext->cHandles = 1;
-
-                    pWaiterContext->rgHandles[0] = ::CreateEventW(NULL, FALSE, FALSE, NULL);
-                    ExitOnNullWithLastError(pWaiterContext->rgHandles[0], hr, "Failed to create general event");
-
-                    pWaiterContext->hWaiterThread = ::CreateThread(NULL, 0, WaiterThread, pWaiterContext, 0, &pWaiterContext->dwWaiterThreadId);
-                    if (!pWaiterContext->hWaiterThread)
-                    {
-                        ExitWithLastError(hr, "Failed to create waiter thread.");
-                    }
-
-                    dwRetries = MON_THREAD_INIT_RETRIES;
-                    while (!pWaiterContext->fWaiterThreadMessageQueueInitialized && 0 < dwRetries)
-                    {
-                        ::Sleep(MON_THREAD_INIT_RETRY_PERIOD_IN_MS);
-                        --dwRetries;
-                    }
-
-                    if (0 == dwRetries)
-                    {
-                        hr = E_UNEXPECTED;
-                        ExitOnFailure(hr, "Waiter thread apparently never initialized its message queue.");
-                    }
-                }
-
-                ++pm->rgWaiterThreads[dwThreadIndex].cMonitorCount;
-                if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_ADD, msg.wParam, 0))
-                {
-                    ExitWithLastError(hr, "Failed to send message to waiter thread to add monitor");
-                }
-
-                if (!::SetEvent(pWaiterContext->rgHandles[0]))
-                {
-                    ExitWithLastError(hr, "Failed to set event to notify waiter thread of incoming message");
-                }
-                break;
-
-            case MON_MESSAGE_REMOVE:
-                // Send remove to all waiter threads. They'll ignore it if they don't have that monitor.
-                // If they do have that monitor, they'll remove it from their list, and tell coordinator they have another
-                // empty slot via MON_MESSAGE_REMOVED message
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
-                    pRemoveMessage = reinterpret_cast<MON_REMOVE_MESSAGE *>(msg.wParam);
-
-                    hr = DuplicateRemoveMessage(pRemoveMessage, &pTempRemoveMessage);
-                    ExitOnFailure(hr, "Failed to duplicate remove message");
-
-                    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_REMOVE, reinterpret_cast<WPARAM>(pTempRemoveMessage), msg.lParam))
-                    {
-                        ExitWithLastError(hr, "Failed to send message to waiter thread to add monitor");
-                    }
-                    pTempRemoveMessage = NULL;
-
-                    if (!::SetEvent(pWaiterContext->rgHandles[0]))
-                    {
-                        ExitWithLastError(hr, "Failed to set event to notify waiter thread of incoming remove message");
-                    }
-                }
-                MonRemoveMessageDestroy(pRemoveMessage);
-                pRemoveMessage = NULL;
-                break;
-
-            case MON_MESSAGE_REMOVED:
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    if (pm->rgWaiterThreads[i].pWaiterContext->dwWaiterThreadId == static_cast<DWORD>(msg.wParam))
-                    {
-                        Assert(pm->rgWaiterThreads[i].cMonitorCount > 0);
-                        --pm->rgWaiterThreads[i].cMonitorCount;
-                        if (0 == pm->rgWaiterThreads[i].cMonitorCount)
-                        {
-                            if (!::PostThreadMessageW(pm->rgWaiterThreads[i].pWaiterContext->dwWaiterThreadId, MON_MESSAGE_STOP, msg.wParam, msg.lParam))
-                            {
-                                ExitWithLastError(hr, "Failed to send message to waiter thread to stop");
-                            }
-                            MemRemoveFromArray(reinterpret_cast<LPVOID>(pm->rgWaiterThreads), i, 1, pm->cWaiterThreads, sizeof(MON_WAITER_INFO), TRUE);
-                            --pm->cWaiterThreads;
-                            --i; // reprocess this index in the for loop, which will now contain the item after the one we removed
-                        }
-                    }
-                }
-                break;
-
             case MON_MESSAGE_NETWORK_WAIT_FAILED:
                 if (0 == dwFailingNetworkWaits)
                 {
@@ -812,39 +776,15 @@ static DWORD WINAPI CoordinatorThread(
                 hr = WaitForNetworkChanges(&hMonitor, pm);
                 ExitOnFailure(hr, "Failed to re-wait for network changes");
 
-                // Propagate any network status update messages to all waiter threads
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
-
-                    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_NETWORK_STATUS_UPDATE, 0, 0))
-                    {
-                        ExitWithLastError(hr, "Failed to send message to waiter thread to notify of network status update");
-                    }
-
-                    if (!::SetEvent(pWaiterContext->rgHandles[0]))
-                    {
-                        ExitWithLastError(hr, "Failed to set event to notify waiter thread of incoming network status update message");
-                    }
-                }
+                // Propagate any network status update messages to the waiter thread
+                hr = PostWaiterMessage(pm->pWaiterContext, MON_MESSAGE_NETWORK_STATUS_UPDATE, 0, 0);
+                ExitOnFailure(hr, "Failed to send message to waiter thread to notify of network status update");
                 break;
 
             case WM_TIMER:
                 // Timer means some network wait is failing, and we need to retry every so often in case a remote server goes back up
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
-
-                    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, msg.wParam == uTimerFailedNetworkRetry ? MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS : MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS, 0, 0))
-                    {
-                        ExitWithLastError(hr, "Failed to send message to waiter thread to notify of network status update");
-                    }
-
-                    if (!::SetEvent(pWaiterContext->rgHandles[0]))
-                    {
-                        ExitWithLastError(hr, "Failed to set event to notify waiter thread of incoming network status update message");
-                    }
-                }
+                hr = PostWaiterMessage(pm->pWaiterContext, msg.wParam == uTimerFailedNetworkRetry ? MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS : MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS, 0, 0);
+                ExitOnFailure(hr, "Failed to send message to waiter thread to retry network waits");
                 break;
 
             case MON_MESSAGE_DRIVE_STATUS_UPDATE:
@@ -854,21 +794,9 @@ static DWORD WINAPI CoordinatorThread(
                     pm->vpfMonDriveStatus(static_cast<WCHAR>(msg.wParam), static_cast<BOOL>(msg.lParam), pm->pvContext);
                 }
 
-                // Propagate any drive status update messages to all waiter threads
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
-
-                    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_DRIVE_STATUS_UPDATE, msg.wParam, msg.lParam))
-                    {
-                        ExitWithLastError(hr, "Failed to send message to waiter thread to notify of drive status update");
-                    }
-
-                    if (!::SetEvent(pWaiterContext->rgHandles[0]))
-                    {
-                        ExitWithLastError(hr, "Failed to set event to notify waiter thread of incoming drive status update message");
-                    }
-                }
+                // Propagate any drive status update messages to the waiter thread
+                hr = PostWaiterMessage(pm->pWaiterContext, MON_MESSAGE_DRIVE_STATUS_UPDATE, msg.wParam, msg.lParam);
+                ExitOnFailure(hr, "Failed to send message to waiter thread to notify of drive status update");
                 break;
 
             case MON_MESSAGE_STOP:
@@ -898,84 +826,212 @@ LExit:
         ::CloseWindow(pm->hwnd);
     }
 
-    // Tell all waiter threads to shutdown
-    for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
+    if (hMonitor != NULL)
     {
-        pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
-        if (NULL != pWaiterContext->rgHandles[0])
-        {
-            if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_STOP, msg.wParam, msg.lParam))
-            {
-                TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to send message to waiter thread to stop");
-            }
+        ::WSALookupServiceEnd(hMonitor);
+    }
 
-            if (!::SetEvent(pWaiterContext->rgHandles[0]))
-            {
-                TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to set event to notify waiter thread of incoming message");
-            }
-        }
+    // Tell the waiter thread to shutdown and confirm it actually did before returning
+    WaiterDestroy(pm);
+
+    if (FAILED(hr))
+    {
+        // If coordinator thread fails, notify general callback of an error
+        Assert(pm->vpfMonGeneral);
+        pm->vpfMonGeneral(hr, pm->pvContext);
     }
 
-    if (hMonitor != NULL)
+    ::WSACleanup();
+
+    return hr;
+}
+
+static HRESULT WaiterCreate(
+    __in MON_STRUCT *pm
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD dwRetries = MON_THREAD_INIT_RETRIES;
+    MON_WAITER_CONTEXT *pWaiterContext = NULL;
+
+    pWaiterContext = reinterpret_cast<MON_WAITER_CONTEXT*>(MemAlloc(sizeof(MON_WAITER_CONTEXT), TRUE));
+    ExitOnNull(pWaiterContext, hr, E_OUTOFMEMORY, "Failed to allocate waiter context struct");
+    pm->pWaiterContext = pWaiterContext;
+
+    pWaiterContext->vpfMonGeneral = pm->vpfMonGeneral;
+    pWaiterContext->vpfMonDirectory = pm->vpfMonDirectory;
+    pWaiterContext->vpfMonRegKey = pm->vpfMonRegKey;
+    pWaiterContext->pvContext = pm->pvContext;
+
+    pWaiterContext->hCompletionPort = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    ExitOnNullWithLastError(pWaiterContext->hCompletionPort, hr, "Failed to create completion port for waiter thread");
+
+    pWaiterContext->hWaiterThread = ::CreateThread(NULL, 0, WaiterThread, pWaiterContext, 0, &pWaiterContext->dwWaiterThreadId);
+    if (!pWaiterContext->hWaiterThread)
     {
-        ::WSALookupServiceEnd(hMonitor);
+        ExitWithLastError(hr, "Failed to create waiter thread.");
+    }
+
+    while (!pWaiterContext->fWaiterThreadMessageQueueInitialized && 0 < dwRetries)
+    {
+        ::Sleep(MON_THREAD_INIT_RETRY_PERIOD_IN_MS);
+        --dwRetries;
+    }
+
+    if (0 == dwRetries)
+    {
+        hr = E_UNEXPECTED;
+        ExitOnFailure(hr, "Waiter thread apparently never initialized its message queue.");
     }
 
-    // Now confirm they're actually shut down before returning
-    for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
+LExit:
+    return hr;
+}
+
+static void WaiterDestroy(
+    __in MON_STRUCT *pm
+    )
+{
+    HRESULT hr = S_OK;
+    MON_WAITER_CONTEXT *pWaiterContext = pm->pWaiterContext;
+
+    if (NULL != pWaiterContext)
     {
-        pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
         if (NULL != pWaiterContext->hWaiterThread)
         {
+            hr = PostWaiterMessage(pWaiterContext, MON_MESSAGE_STOP, 0, 0);
+            if (FAILED(hr))
+            {
+                TraceError(hr, "Failed to send message to waiter thread to stop");
+            }
+
             ::WaitForSingleObject(pWaiterContext->hWaiterThread, INFINITE);
             ::CloseHandle(pWaiterContext->hWaiterThread);
         }
 
-        // Waiter thread can't release these, because coordinator thread uses it to try communicating with waiter thread
-        ReleaseHandle(pWaiterContext->rgHandles[0]);
-        ReleaseMem(pWaiterContext->rgHandles);
+        // Waiter thread can't release this, because coordinator thread uses it to try communicating with waiter thread
+        ReleaseHandle(pWaiterContext->hCompletionPort);
 
         ReleaseMem(pWaiterContext);
+        pm->pWaiterContext = NULL;
     }
+}
 
-    if (FAILED(hr))
+static HRESULT PostWaiterMessage(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in UINT uMsg,
+    __in WPARAM wParam,
+    __in LPARAM lParam
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, uMsg, wParam, lParam))
     {
-        // If coordinator thread fails, notify general callback of an error
-        Assert(pm->vpfMonGeneral);
-        pm->vpfMonGeneral(hr, pm->pvContext);
+        ExitWithLastError(hr, "Failed to post message %u to waiter thread", uMsg);
     }
-    MonRemoveMessageDestroy(pRemoveMessage);
-    MonRemoveMessageDestroy(pTempRemoveMessage);
 
-    ::WSACleanup();
+    hr = WakeWaiter(pWaiterContext);
+    ExitOnFailure(hr, "Failed to notify waiter thread of incoming message %u", uMsg);
 
+LExit:
     return hr;
 }
 
-static HRESULT InitiateWait(
-    __inout MON_REQUEST *pRequest,
-    __inout HANDLE *pHandle
+static HRESULT WakeWaiter(
+    __in MON_WAITER_CONTEXT *pWaiterContext
     )
 {
     HRESULT hr = S_OK;
-    HRESULT hrTemp = S_OK;
-    DEV_BROADCAST_HANDLE dev = { };
-    BOOL fRedo = FALSE;
-    BOOL fHandleFound;
-    DWORD er = ERROR_SUCCESS;
-    DWORD dwIndex = 0;
-    HKEY hk = NULL;
-    HANDLE hTemp = INVALID_HANDLE_VALUE;
 
-    if (pRequest->hNotify)
+    if (!::PostQueuedCompletionStatus(pWaiterContext->hCompletionPort, 0, MON_COMPLETION_KEY_MESSAGE, NULL))
     {
-        UnregisterDeviceNotification(pRequest->hNotify);
-        pRequest->hNotify = NULL;
+        ExitWithLastError(hr, "Failed to queue message completion to waiter thread");
     }
 
-    do
-    {
-        fRedo = FALSE;
+LExit:
+    return hr;
+}
+
+static HRESULT SendAddRequest(
+    __in MON_STRUCT *pm,
+    __inout MON_REQUEST **ppRequest
+    )
+{
+    HRESULT hr = S_OK;
+    MON_WAITER_CONTEXT *pWaiterContext = pm->pWaiterContext;
+    HANDLE hAdded = NULL;
+    HANDLE rgHandles[2] = { };
+    DWORD dwRet = WAIT_FAILED;
+
+    // Callbacks are called from the waiter thread, which can't wait on itself
+    if (::GetCurrentThreadId() != pWaiterContext->dwWaiterThreadId)
+    {
+        hAdded = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        ExitOnNullWithLastError(hAdded, hr, "Failed to create event to wait for request to be added");
+        (*ppRequest)->hAdded = hAdded;
+    }
+
+    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_ADD, reinterpret_cast<WPARAM>(*ppRequest), 0))
+    {
+        ExitWithLastError(hr, "Failed to send message to waiter thread to add request");
+    }
+    *ppRequest = NULL;
+
+    hr = WakeWaiter(pWaiterContext);
+    ExitOnFailure(hr, "Failed to wake waiter thread to add request");
+
+    if (hAdded)
+    {
+        rgHandles[0] = hAdded;
+        rgHandles[1] = pWaiterContext->hWaiterThread;
+
+        dwRet = ::WaitForMultipleObjects(countof(rgHandles), rgHandles, FALSE, INFINITE);
+        if (WAIT_OBJECT_0 + 1 == dwRet)
+        {
+            hr = E_ABORT;
+            ExitOnFailure(hr, "Waiter thread stopped before the request was added");
+        }
+        else if (WAIT_OBJECT_0 != dwRet)
+        {
+            ExitWithLastError(hr, "Failed to wait for request to be added");
+        }
+    }
+
+LExit:
+    // Once the waiter thread owns the request it signals the event, so only close it when that can no longer happen
+    if (hAdded && (*ppRequest || WAIT_OBJECT_0 == dwRet || WAIT_OBJECT_0 + 1 == dwRet))
+    {
+        if (*ppRequest)
+        {
+            (*ppRequest)->hAdded = NULL;
+        }
+        ::CloseHandle(hAdded);
+    }
+
+    return hr;
+}
+
+static HRESULT InitiateWait(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST *pRequest
+    )
+{
+    HRESULT hr = S_OK;
+    HRESULT hrTemp = S_OK;
+    DEV_BROADCAST_HANDLE dev = { };
+    BOOL fRedo = FALSE;
+    BOOL fHandleFound;
+    DWORD er = ERROR_SUCCESS;
+    DWORD dwIndex = 0;
+    HKEY hk = NULL;
+    HANDLE hTemp = INVALID_HANDLE_VALUE;
+
+    AbandonWait(pWaiterContext, pRequest);
+
+    do
+    {
+        fRedo = FALSE;
         fHandleFound = FALSE;
 
         for (DWORD i = 0; i < pRequest->cPathHierarchy && !fHandleFound; ++i)
@@ -984,27 +1040,16 @@ static HRESULT InitiateWait(
             switch (pRequest->type)
             {
             case MON_DIRECTORY:
-                if (INVALID_HANDLE_VALUE != *pHandle)
-                {
-                    ::FindCloseChangeNotification(*pHandle);
-                    *pHandle = INVALID_HANDLE_VALUE;
-                }
+                AbandonWait(pWaiterContext, pRequest);
 
-                *pHandle = ::FindFirstChangeNotificationW(pRequest->rgsczPathHierarchy[dwIndex], GetRecursiveFlag(pRequest, dwIndex), FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SECURITY);
-                if (INVALID_HANDLE_VALUE == *pHandle)
+                hr = StartDirectoryWait(pWaiterContext, pRequest, dwIndex);
+                if (E_FILENOTFOUND == hr || E_PATHNOTFOUND == hr || E_ACCESSDENIED == hr)
                 {
-                    hr = HRESULT_FROM_WIN32(::GetLastError());
-                    if (E_FILENOTFOUND == hr || E_PATHNOTFOUND == hr || E_ACCESSDENIED == hr)
-                    {
-                        continue;
-                    }
-                    ExitOnWin32Error(er, hr, "Failed to wait on path %ls", pRequest->rgsczPathHierarchy[dwIndex]);
-                }
-                else
-                {
-                    fHandleFound = TRUE;
-                    hr = S_OK;
+                    continue;
                 }
+                ExitOnFailure(hr, "Failed to wait on path %ls", pRequest->rgsczPathHierarchy[dwIndex]);
+
+                fHandleFound = TRUE;
                 break;
             case MON_REGKEY:
                 ReleaseRegKey(pRequest->regkey.hkSubKey);
@@ -1015,8 +1060,15 @@ static HRESULT InitiateWait(
                 }
                 ExitOnFailure(hr, "Failed to open regkey %ls", pRequest->rgsczPathHierarchy[dwIndex]);
 
-                er = ::RegNotifyChangeKeyValue(pRequest->regkey.hkSubKey, GetRecursiveFlag(pRequest, dwIndex), REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_CHANGE_SECURITY, *pHandle, TRUE);
-                ReleaseRegKey(hk);
+                // The thread pool wait isn't registered until the right key was found, so the same event can be reused until then
+                if (!pRequest->pWait)
+                {
+                    hr = WaitCreate(pWaiterContext, pRequest, &pRequest->pWait);
+                    ExitOnFailure(hr, "Failed to create wait for regkey %ls", pRequest->rgsczPathHierarchy[dwIndex]);
+                }
+                ::ResetEvent(pRequest->pWait->regkey.hEvent);
+
+                er = ::RegNotifyChangeKeyValue(pRequest->regkey.hkSubKey, GetRecursiveFlag(pRequest, dwIndex), REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_CHANGE_SECURITY, pRequest->pWait->regkey.hEvent, TRUE);
                 hr = HRESULT_FROM_WIN32(er);
                 if (E_FILENOTFOUND == hr || E_PATHNOTFOUND == hr || HRESULT_FROM_WIN32(ERROR_KEY_DELETED) == hr)
                 {
@@ -1044,10 +1096,10 @@ static HRESULT InitiateWait(
             switch (pRequest->type)
             {
             case MON_DIRECTORY:
-                hTemp = ::FindFirstChangeNotificationW(pRequest->rgsczPathHierarchy[dwIndex + 1], GetRecursiveFlag(pRequest, dwIndex + 1), FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SECURITY);
+                hTemp = ::CreateFileW(pRequest->rgsczPathHierarchy[dwIndex + 1], FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
                 if (INVALID_HANDLE_VALUE != hTemp)
                 {
-                    ::FindCloseChangeNotification(hTemp);
+                    ::CloseHandle(hTemp);
                     fRedo = TRUE;
                 }
                 break;
@@ -1068,460 +1120,698 @@ static HRESULT InitiateWait(
     {
         dev.dbch_size = sizeof(dev);
         dev.dbch_devicetype = DBT_DEVTYP_HANDLE;
-        dev.dbch_handle = *pHandle;
+        dev.dbch_handle = pRequest->pWait->directory.hDirectory;
         // Ignore failure on this - some drives by design don't support it (like network paths), and the worst that can happen is a
         // removable device will be left in use so user cannot gracefully remove
         pRequest->hNotify = RegisterDeviceNotification(pRequest->hwnd, &dev, DEVICE_NOTIFY_WINDOW_HANDLE);
     }
+    else if (MON_REGKEY == pRequest->type)
+    {
+        // Registry notifications can only signal an event, so a thread pool wait queues them to the completion port along with everything else
+        if (!::RegisterWaitForSingleObject(&pRequest->pWait->regkey.hRegisteredWait, pRequest->pWait->regkey.hEvent, RegKeyWaitCallback, pRequest->pWait, INFINITE, WT_EXECUTEONLYONCE | WT_EXECUTEINWAITTHREAD))
+        {
+            ExitWithLastError(hr, "Failed to register wait for subkey %ls", pRequest->rgsczPathHierarchy[pRequest->dwPathHierarchyIndex]);
+        }
+        pRequest->pWait->fPending = TRUE;
+        ++pWaiterContext->cWaitsPending;
+    }
 
 LExit:
+    if (FAILED(hr))
+    {
+        AbandonWait(pWaiterContext, pRequest);
+    }
     ReleaseRegKey(hk);
 
     return hr;
 }
 
+static HRESULT StartDirectoryWait(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST *pRequest,
+    __in DWORD dwIndex
+    )
+{
+    HRESULT hr = S_OK;
+    MON_WAIT *pWait = NULL;
+
+    hr = WaitCreate(pWaiterContext, pRequest, &pWait);
+    ExitOnFailure(hr, "Failed to create wait for path %ls", pRequest->rgsczPathHierarchy[dwIndex]);
+
+    pWait->directory.hDirectory = ::CreateFileW(pRequest->rgsczPathHierarchy[dwIndex], FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (INVALID_HANDLE_VALUE == pWait->directory.hDirectory)
+    {
+        // Missing directories are expected while waiting for them to be created, so leave tracing to the caller
+        ExitFunction1(hr = HRESULT_FROM_WIN32(::GetLastError()));
+    }
+
+    if (!::CreateIoCompletionPort(pWait->directory.hDirectory, pWaiterContext->hCompletionPort, MON_COMPLETION_KEY_WAIT, 0))
+    {
+        ExitWithLastError(hr, "Failed to associate path %ls with completion port", pRequest->rgsczPathHierarchy[dwIndex]);
+    }
+
+    if (!::ReadDirectoryChangesW(pWait->directory.hDirectory, pWait->directory.pbBuffer, MON_DIRECTORY_BUFFER_SIZE, GetRecursiveFlag(pRequest, dwIndex), FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SECURITY, NULL, &pWait->overlapped, NULL))
+    {
+        ExitWithLastError(hr, "Failed to read changes in path %ls", pRequest->rgsczPathHierarchy[dwIndex]);
+    }
+
+    pWait->fPending = TRUE;
+    ++pWaiterContext->cWaitsPending;
+
+    pRequest->pWait = pWait;
+    pWait = NULL;
+
+LExit:
+    WaitDestroy(pWait);
+
+    return hr;
+}
+
+static HRESULT WaitCreate(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in MON_REQUEST *pRequest,
+    __out MON_WAIT **ppWait
+    )
+{
+    HRESULT hr = S_OK;
+    MON_WAIT *pWait = NULL;
+
+    pWait = reinterpret_cast<MON_WAIT *>(MemAlloc(sizeof(MON_WAIT) + (MON_DIRECTORY == pRequest->type ? MON_DIRECTORY_BUFFER_SIZE : 0), TRUE));
+    ExitOnNull(pWait, hr, E_OUTOFMEMORY, "Failed to allocate wait");
+
+    pWait->pRequest = pRequest;
+    pWait->type = pRequest->type;
+
+    switch (pRequest->type)
+    {
+    case MON_DIRECTORY:
+        pWait->directory.hDirectory = INVALID_HANDLE_VALUE;
+        pWait->directory.pbBuffer = reinterpret_cast<BYTE *>(pWait + 1);
+        break;
+    case MON_REGKEY:
+        pWait->regkey.hCompletionPort = pWaiterContext->hCompletionPort;
+        pWait->regkey.hEvent = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        ExitOnNullWithLastError(pWait->regkey.hEvent, hr, "Failed to create anonymous event for regkey monitor");
+        break;
+    default:
+        Assert(false);
+    }
+
+    *ppWait = pWait;
+    pWait = NULL;
+
+LExit:
+    WaitDestroy(pWait);
+
+    return hr;
+}
+
+static void AbandonWait(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST *pRequest
+    )
+{
+    MON_WAIT *pWait = pRequest->pWait;
+
+    if (pRequest->hNotify)
+    {
+        UnregisterDeviceNotification(pRequest->hNotify);
+        pRequest->hNotify = NULL;
+    }
+
+    if (NULL != pWait)
+    {
+        pRequest->pWait = NULL;
+        pWait->pRequest = NULL;
+
+        switch (pWait->type)
+        {
+        case MON_DIRECTORY:
+            // Closing the handle cancels the read, and its completion still gets queued to the port
+            ReleaseFileHandle(pWait->directory.hDirectory);
+            break;
+        case MON_REGKEY:
+            if (pWait->regkey.hRegisteredWait)
+            {
+                // This blocks until a callback that is already running returns, so afterwards fPosted says for sure whether a completion was queued
+                ::UnregisterWaitEx(pWait->regkey.hRegisteredWait, INVALID_HANDLE_VALUE);
+                pWait->regkey.hRegisteredWait = NULL;
+
+                if (pWait->fPending && !pWait->regkey.fPosted)
+                {
+                    pWait->fPending = FALSE;
+                    --pWaiterContext->cWaitsPending;
+                }
+            }
+            break;
+        default:
+            Assert(false);
+        }
+
+        if (!pWait->fPending)
+        {
+            WaitDestroy(pWait);
+        }
+    }
+}
+
+static void WaitDestroy(
+    __in_opt MON_WAIT *pWait
+    )
+{
+    if (NULL != pWait)
+    {
+        switch (pWait->type)
+        {
+        case MON_DIRECTORY:
+            ReleaseFileHandle(pWait->directory.hDirectory);
+            break;
+        case MON_REGKEY:
+            if (pWait->regkey.hRegisteredWait)
+            {
+                ::UnregisterWaitEx(pWait->regkey.hRegisteredWait, INVALID_HANDLE_VALUE);
+            }
+            ReleaseHandle(pWait->regkey.hEvent);
+            break;
+        default:
+            Assert(false);
+        }
+
+        MemFree(pWait);
+    }
+}
+
+static VOID CALLBACK RegKeyWaitCallback(
+    __in PVOID pvContext,
+    __in BOOLEAN /*fTimedOut*/
+    )
+{
+    MON_WAIT *pWait = reinterpret_cast<MON_WAIT *>(pvContext);
+
+    if (::PostQueuedCompletionStatus(pWait->regkey.hCompletionPort, 0, MON_COMPLETION_KEY_WAIT, &pWait->overlapped))
+    {
+        pWait->regkey.fPosted = TRUE;
+    }
+    else
+    {
+        TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to queue regkey notification to waiter thread");
+    }
+}
+
 static DWORD WINAPI WaiterThread(
     __in_bcount(sizeof(MON_WAITER_CONTEXT)) LPVOID pvContext
     )
 {
     HRESULT hr = S_OK;
-    HRESULT hrTemp = S_OK;
-    DWORD dwRet = 0;
-    BOOL fAgain = FALSE;
-    BOOL fContinue = TRUE;
-    BOOL fNotify = FALSE;
+    DWORD er = ERROR_SUCCESS;
     BOOL fRet = FALSE;
+    BOOL fStop = FALSE;
     MSG msg = { };
-    MON_ADD_MESSAGE *pAddMessage = NULL;
+    MON_REQUEST *pAddRequest = NULL;
     MON_REMOVE_MESSAGE *pRemoveMessage = NULL;
     MON_WAITER_CONTEXT *pWaiterContext = reinterpret_cast<MON_WAITER_CONTEXT *>(pvContext);
-    DWORD dwRequestIndex;
-    DWORD dwNewRequestIndex;
-    // If we have one or more requests pending notification, this is the period we intend to wait for multiple objects (shortest amount of time to next potential notify)
     DWORD dwWait = 0;
-    DWORD uCurrentTime = 0;
-    DWORD uLastTimeInMs = ::GetTickCount();
-    DWORD uDeltaInMs = 0;
-    DWORD cRequestsPendingBeforeLoop = 0;
-    LPWSTR sczDirectory = NULL;
-    bool rgfProcessedIndex[MON_MAX_MONITORS_PER_THREAD + 1] = { };
-    MON_INTERNAL_TEMPORARY_WAIT * pInternalWait = NULL;
+    DWORD cbTransferred = 0;
+    ULONG_PTR ulCompletionKey = 0;
+    LPOVERLAPPED pOverlapped = NULL;
 
     // Ensure the thread has a message queue
     ::PeekMessage(&msg, NULL, WM_USER, WM_USER, PM_NOREMOVE);
+    pWaiterContext->timers.dwLastTime = ::GetTickCount();
     pWaiterContext->fWaiterThreadMessageQueueInitialized = TRUE;
 
     do
     {
-        dwRet = ::WaitForMultipleObjects(pWaiterContext->cHandles - pWaiterContext->cRequestsFailing, pWaiterContext->rgHandles, FALSE, pWaiterContext->cRequestsPending > 0 ? dwWait : INFINITE);
+        // Sleep until the next pending notification is due, or forever if there is none
+        dwWait = TimerWheelGetWait(&pWaiterContext->timers, ::GetTickCount());
 
-        uCurrentTime = ::GetTickCount();
-        uDeltaInMs = uCurrentTime - uLastTimeInMs;
-        uLastTimeInMs = uCurrentTime;
-
-        if (WAIT_OBJECT_0 == dwRet)
+        // Drain what has queued up before going back to the timers, so a burst of changes doesn't cost a timer pass per change
+        for (DWORD i = 0; i < MON_COMPLETION_BATCH; ++i)
         {
-            do
+            pOverlapped = NULL;
+            fRet = ::GetQueuedCompletionStatus(pWaiterContext->hCompletionPort, &cbTransferred, &ulCompletionKey, &pOverlapped, 0 == i ? dwWait : 0);
+            if (!fRet && NULL == pOverlapped)
             {
-                fRet = ::PeekMessage(&msg, reinterpret_cast<HWND>(-1), 0, 0, PM_REMOVE);
-                fAgain = fRet;
-                if (fRet)
+                er = ::GetLastError();
+                if (WAIT_TIMEOUT == er)
                 {
-                    switch (msg.message)
-                    {
-                        case MON_MESSAGE_ADD:
-                            pAddMessage = reinterpret_cast<MON_ADD_MESSAGE *>(msg.wParam);
-
-                            // Don't just blindly put it at the end of the array - it must be before any failing requests
-                            // for WaitForMultipleObjects() to succeed
-                            dwNewRequestIndex = pWaiterContext->cRequests - pWaiterContext->cRequestsFailing;
-                            if (FAILED(pAddMessage->request.hrStatus))
-                            {
-                                ++pWaiterContext->cRequestsFailing;
-                            }
-
-                            hr = MemInsertIntoArray(reinterpret_cast<void **>(&pWaiterContext->rgHandles), dwNewRequestIndex + 1, 1, pWaiterContext->cHandles, sizeof(HANDLE), MON_ARRAY_GROWTH);
-                            ExitOnFailure(hr, "Failed to insert additional handle");
-                            ++pWaiterContext->cHandles;
-
-                            // Ugh - directory types start with INVALID_HANDLE_VALUE instead of NULL
-                            if (MON_DIRECTORY == pAddMessage->request.type)
-                            {
-                                pWaiterContext->rgHandles[dwNewRequestIndex + 1] = INVALID_HANDLE_VALUE;
-                            }
-
-                            hr = MemInsertIntoArray(reinterpret_cast<void **>(&pWaiterContext->rgRequests), dwNewRequestIndex, 1, pWaiterContext->cRequests, sizeof(MON_REQUEST), MON_ARRAY_GROWTH);
-                            ExitOnFailure(hr, "Failed to insert additional request struct");
-                            ++pWaiterContext->cRequests;
-
-                            pWaiterContext->rgRequests[dwNewRequestIndex] = pAddMessage->request;
-                            pWaiterContext->rgHandles[dwNewRequestIndex + 1] = pAddMessage->handle;
-
-                            ReleaseNullMem(pAddMessage);
-                            break;
-
-                        case MON_MESSAGE_REMOVE:
-                            pRemoveMessage = reinterpret_cast<MON_REMOVE_MESSAGE *>(msg.wParam);
-
-                            // Find the request to remove
-                            hr = FindRequestIndex(pWaiterContext, pRemoveMessage, &dwRequestIndex);
-                            if (E_NOTFOUND == hr)
-                            {
-                                // Coordinator sends removes blindly to all waiter threads, so maybe this one wasn't intended for us
-                                hr = S_OK;
-                            }
-                            else
-                            {
-                                ExitOnFailure(hr, "Failed to find request index for remove message");
-
-                                hr = RemoveRequest(pWaiterContext, dwRequestIndex);
-                                ExitOnFailure(hr, "Failed to remove request after request from coordinator thread.");
-                            }
-
-                            MonRemoveMessageDestroy(pRemoveMessage);
-                            pRemoveMessage = NULL;
-                            break;
-
-                        case MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS:
-                            if (::PeekMessage(&msg, NULL, MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS, MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS, PM_NOREMOVE))
-                            {
-                                // If there is another a pending retry failed wait message, skip this one
-                                continue;
-                            }
-
-                            ZeroMemory(rgfProcessedIndex, sizeof(rgfProcessedIndex));
-                            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
-                            { 
-                                if (rgfProcessedIndex[i])
-                                {
-                                    // if we already processed this item due to UpdateWaitStatus swapping array indices, then skip it
-                                    continue;
-                                }
-
-                                if (MON_DIRECTORY == pWaiterContext->rgRequests[i].type && pWaiterContext->rgRequests[i].fNetwork && FAILED(pWaiterContext->rgRequests[i].hrStatus))
-                                {
-                                    // This is not a failure, just record this in the request's status
-                                    hrTemp = InitiateWait(pWaiterContext->rgRequests + i, pWaiterContext->rgHandles + i + 1);
-
-                                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, i, &dwNewRequestIndex);
-                                    ExitOnFailure(hr, "Failed to update wait status");
-                                    hrTemp = S_OK;
-
-                                    if (dwNewRequestIndex != i)
-                                    {
-                                        // If this request was moved to the end of the list, reprocess this index and mark the new index for skipping
-                                        rgfProcessedIndex[dwNewRequestIndex] = true;
-                                        --i;
-                                    }
-                                }
-                            }
-                        break;
+                    break;
+                }
+                ExitOnWin32Error(er, hr, "Failed to dequeue completion");
+            }
 
-                        case MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS:
-                            if (::PeekMessage(&msg, NULL, MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS, MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS, PM_NOREMOVE))
-                            {
-                                // If there is another a pending retry successful wait message, skip this one
-                                continue;
-                            }
-
-                            ZeroMemory(rgfProcessedIndex, sizeof(rgfProcessedIndex));
-                            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
-                            { 
-                                if (rgfProcessedIndex[i])
-                                {
-                                    // if we already processed this item due to UpdateWaitStatus swapping array indices, then skip it
-                                    continue;
-                                }
-
-                                if (MON_DIRECTORY == pWaiterContext->rgRequests[i].type && pWaiterContext->rgRequests[i].fNetwork && SUCCEEDED(pWaiterContext->rgRequests[i].hrStatus))
-                                {
-                                    // This is not a failure, just record this in the request's status
-                                    hrTemp = InitiateWait(pWaiterContext->rgRequests + i, pWaiterContext->rgHandles + i + 1);
-
-                                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, i, &dwNewRequestIndex);
-                                    ExitOnFailure(hr, "Failed to update wait status");
-                                    hrTemp = S_OK;
-
-                                    if (dwNewRequestIndex != i)
-                                    {
-                                        // If this request was moved to the end of the list, reprocess this index and mark the new index for skipping
-                                        rgfProcessedIndex[dwNewRequestIndex] = true;
-                                        --i;
-                                    }
-                                }
-                            }
-                            break;
-
-                        case MON_MESSAGE_NETWORK_STATUS_UPDATE:
-                            if (::PeekMessage(&msg, NULL, MON_MESSAGE_NETWORK_STATUS_UPDATE, MON_MESSAGE_NETWORK_STATUS_UPDATE, PM_NOREMOVE))
-                            {
-                                // If there is another a pending network status update message, skip this one
-                                continue;
-                            }
-
-                            ZeroMemory(rgfProcessedIndex, sizeof(rgfProcessedIndex));
-                            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
-                            { 
-                                if (rgfProcessedIndex[i])
-                                {
-                                    // if we already processed this item due to UpdateWaitStatus swapping array indices, then skip it
-                                    continue;
-                                }
-
-                                if (MON_DIRECTORY == pWaiterContext->rgRequests[i].type && pWaiterContext->rgRequests[i].fNetwork)
-                                {
-                                    // Failures here get recorded in the request's status
-                                    hrTemp = InitiateWait(pWaiterContext->rgRequests + i, pWaiterContext->rgHandles + i + 1);
-
-                                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, i, &dwNewRequestIndex);
-                                    ExitOnFailure(hr, "Failed to update wait status");
-                                    hrTemp = S_OK;
-
-                                    if (dwNewRequestIndex != i)
-                                    {
-                                        // If this request was moved to the end of the list, reprocess this index and mark the new index for skipping
-                                        rgfProcessedIndex[dwNewRequestIndex] = true;
-                                        --i;
-                                    }
-                                }
-                            }
-                            break;
-
-                        case MON_MESSAGE_DRIVE_STATUS_UPDATE:
-                            ZeroMemory(rgfProcessedIndex, sizeof(rgfProcessedIndex));
-                            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
-                            { 
-                                if (rgfProcessedIndex[i])
-                                {
-                                    // if we already processed this item due to UpdateWaitStatus swapping array indices, then skip it
-                                    continue;
-                                }
-
-                                if (MON_DIRECTORY == pWaiterContext->rgRequests[i].type && pWaiterContext->rgRequests[i].sczOriginalPathRequest[0] == static_cast<WCHAR>(msg.wParam))
-                                {
-                                    // Failures here get recorded in the request's status
-                                    if (static_cast<BOOL>(msg.lParam))
-                                    {
-                                        hrTemp = InitiateWait(pWaiterContext->rgRequests + i, pWaiterContext->rgHandles + i + 1);
-                                    }
-                                    else
-                                    {
-                                        // If the message says the drive is disconnected, don't even try to wait, just mark it as gone
-                                        hrTemp = E_PATHNOTFOUND;
-                                    }
-
-                                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, i, &dwNewRequestIndex);
-                                    ExitOnFailure(hr, "Failed to update wait status");
-                                    hrTemp = S_OK;
-
-                                    if (dwNewRequestIndex != i)
-                                    {
-                                        // If this request was moved to the end of the list, reprocess this index and mark the new index for skipping
-                                        rgfProcessedIndex[dwNewRequestIndex] = true;
-                                        --i;
-                                    }
-                                }
-                            }
-                            break;
-
-                        case MON_MESSAGE_DRIVE_QUERY_REMOVE:
-                            pInternalWait = reinterpret_cast<MON_INTERNAL_TEMPORARY_WAIT *>(msg.wParam);
-                            // Only do any work if message is not yet out of date
-                            // While it could become out of date while doing this processing, sending thread will check response to guard against this
-                            if (pInternalWait->dwSendIteration == static_cast<DWORD>(msg.lParam))
-                            {
-                                for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
-                                { 
-                                    if (MON_DIRECTORY == pWaiterContext->rgRequests[i].type && pWaiterContext->rgHandles[i + 1] == reinterpret_cast<HANDLE>(pInternalWait->pvContext))
-                                    {
-                                        // Release handles ASAP so the remove request will succeed
-                                        if (pWaiterContext->rgRequests[i].hNotify)
-                                        {
-                                            UnregisterDeviceNotification(pWaiterContext->rgRequests[i].hNotify);
-                                            pWaiterContext->rgRequests[i].hNotify = NULL;
-                                        }
-                                        ::FindCloseChangeNotification(pWaiterContext->rgHandles[i + 1]);
-                                        pWaiterContext->rgHandles[i + 1] = INVALID_HANDLE_VALUE;
-
-                                        // Reply to unblock our reply to the remove request
-                                        pInternalWait->dwReceiveIteration = static_cast<DWORD>(msg.lParam);
-                                        if (!::SetEvent(pInternalWait->hWait))
-                                        {
-                                            TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to set event to notify coordinator thread that removable device handle was released, this could be due to wndproc no longer waiting for waiter thread's response");
-                                        }
-
-                                        // Drive is disconnecting, don't even try to wait, just mark it as gone
-                                        hrTemp = E_PATHNOTFOUND;
-
-                                        hr = UpdateWaitStatus(hrTemp, pWaiterContext, i, &dwNewRequestIndex);
-                                        ExitOnFailure(hr, "Failed to update wait status");
-                                        hrTemp = S_OK;
-                                        break;
-                                    }
-                                }
-                            }
-                            break;
-
-                        case MON_MESSAGE_STOP:
-                            // Stop requested, so abort the whole thread
-                            Trace(REPORT_DEBUG, "Waiter thread was told to stop");
-                            fAgain = FALSE;
-                            fContinue = FALSE;
-                            ExitFunction1(hr = static_cast<HRESULT>(msg.wParam));
-
-                        default:
-                            Assert(false);
-                            break;
-                    }
+            // A failed read (for example because its directory was deleted or the handle closed) still dequeues its wait, and re-waiting sorts it out
+            if (MON_COMPLETION_KEY_MESSAGE == ulCompletionKey)
+            {
+                hr = ProcessWaiterMessages(pWaiterContext, &pAddRequest, &pRemoveMessage, &fStop);
+                ExitOnFailure(hr, "Failed to process waiter thread messages");
+
+                if (fStop)
+                {
+                    // Stop requested, so abort the whole thread
+                    Trace(REPORT_DEBUG, "Waiter thread was told to stop");
+                    ExitFunction();
                 }
-            } while (fAgain);
+            }
+            else if (MON_COMPLETION_KEY_WAIT == ulCompletionKey)
+            {
+                hr = WaitCompleted(pWaiterContext, reinterpret_cast<MON_WAIT *>(pOverlapped));
+                ExitOnFailure(hr, "Failed to process completed wait");
+            }
+            else
+            {
+                Assert(false);
+            }
+        }
+
+        // Now that all triggered waits have pushed their silence periods out, fire whatever is finally due
+        TimerWheelAdvance(pWaiterContext, ::GetTickCount());
+    } while (!fStop);
+
+    // Don't bother firing pending notifications. We were told to stop monitoring, so client doesn't care.
+
+LExit:
+    MonRequestDestroy(pAddRequest);
+    MonRemoveMessageDestroy(pRemoveMessage);
+
+    for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
+    {
+        if (pWaiterContext->rgpRequests[i]->fPendingFire)
+        {
+            TimerWheelRemove(&pWaiterContext->timers, pWaiterContext->rgpRequests[i]);
+        }
+        AbandonWait(pWaiterContext, pWaiterContext->rgpRequests[i]);
+        MonRequestDestroy(pWaiterContext->rgpRequests[i]);
+    }
+    ReleaseNullMem(pWaiterContext->rgpRequests);
+    pWaiterContext->cRequests = 0;
+
+    // Cancelled directory reads still complete to the port and own their buffers until then
+    while (0 < pWaiterContext->cWaitsPending)
+    {
+        pOverlapped = NULL;
+        fRet = ::GetQueuedCompletionStatus(pWaiterContext->hCompletionPort, &cbTransferred, &ulCompletionKey, &pOverlapped, MON_THREAD_WAIT_CANCELLED_IN_MS);
+        if (NULL == pOverlapped)
+        {
+            if (!fRet && WAIT_TIMEOUT == ::GetLastError())
+            {
+                TraceError(HRESULT_FROM_WIN32(WAIT_TIMEOUT), "Gave up waiting for %u cancelled waits to complete", pWaiterContext->cWaitsPending);
+                break;
+            }
+            else if (!fRet)
+            {
+                break;
+            }
+        }
+        else if (MON_COMPLETION_KEY_WAIT == ulCompletionKey)
+        {
+            --pWaiterContext->cWaitsPending;
+            WaitDestroy(reinterpret_cast<MON_WAIT *>(pOverlapped));
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        // If waiter thread fails, notify general callback of an error
+        Assert(pWaiterContext->vpfMonGeneral);
+        pWaiterContext->vpfMonGeneral(hr, pWaiterContext->pvContext);
+
+        // And tell coordinator to shut down too
+        if (!::PostThreadMessageW(pWaiterContext->dwCoordinatorThreadId, MON_MESSAGE_STOP, 0, 0))
+        {
+            TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to send message to coordinator thread to stop (due to general failure).");
         }
-        else if (dwRet > WAIT_OBJECT_0 && dwRet - WAIT_OBJECT_0 < pWaiterContext->cHandles)
+    }
+
+    return hr;
+}
+
+static HRESULT ProcessWaiterMessages(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __inout MON_REQUEST **ppAddRequest,
+    __inout MON_REMOVE_MESSAGE **ppRemoveMessage,
+    __out BOOL *pfStop
+    )
+{
+    HRESULT hr = S_OK;
+    HRESULT hrTemp = S_OK;
+    MSG msg = { };
+    MON_REQUEST *pRequest = NULL;
+    DWORD dwRequestIndex = 0;
+    HANDLE hAdded = NULL;
+    MON_INTERNAL_TEMPORARY_WAIT *pInternalWait = NULL;
+
+    // A wakeup may have been queued for messages an earlier wakeup already processed, so there may be nothing to do here
+    while (::PeekMessage(&msg, reinterpret_cast<HWND>(-1), 0, 0, PM_REMOVE))
+    {
+        switch (msg.message)
         {
-            // OK a handle fired - only notify if it's the actual target, and not just some parent waiting for the target child to exist
-            dwRequestIndex = dwRet - WAIT_OBJECT_0 - 1;
-            fNotify = (pWaiterContext->rgRequests[dwRequestIndex].dwPathHierarchyIndex == pWaiterContext->rgRequests[dwRequestIndex].cPathHierarchy - 1);
-
-            // Initiate re-waits before we notify callback, to ensure we don't miss a single update
-            hrTemp = InitiateWait(pWaiterContext->rgRequests + dwRequestIndex, pWaiterContext->rgHandles + dwRequestIndex + 1);
-            hr = UpdateWaitStatus(hrTemp, pWaiterContext, dwRequestIndex, &dwRequestIndex);
-            ExitOnFailure(hr, "Failed to update wait status");
-            hrTemp = S_OK;
-
-            // If there were no errors and we were already waiting on the right target, or if we weren't yet but are able to now, it's a successful notify
-            if (SUCCEEDED(pWaiterContext->rgRequests[dwRequestIndex].hrStatus) && (fNotify || (pWaiterContext->rgRequests[dwRequestIndex].dwPathHierarchyIndex == pWaiterContext->rgRequests[dwRequestIndex].cPathHierarchy - 1)))
+        case MON_MESSAGE_ADD:
+            *ppAddRequest = reinterpret_cast<MON_REQUEST *>(msg.wParam);
+
+            hr = MemEnsureArraySize(reinterpret_cast<void **>(&pWaiterContext->rgpRequests), pWaiterContext->cRequests + 1, sizeof(MON_REQUEST *), MON_ARRAY_GROWTH);
+            ExitOnFailure(hr, "Failed to grow request array");
+
+            pRequest = *ppAddRequest;
+            pWaiterContext->rgpRequests[pWaiterContext->cRequests] = pRequest;
+            ++pWaiterContext->cRequests;
+            *ppAddRequest = NULL;
+
+            // This is not a failure, just record this in the request's status
+            pRequest->hrStatus = InitiateWait(pWaiterContext, pRequest);
+
+            // Let the thread that added the request know it's being watched now
+            hAdded = pRequest->hAdded;
+            pRequest->hAdded = NULL;
+            if (hAdded && !::SetEvent(hAdded))
             {
-                Trace(REPORT_DEBUG, "Changes detected, waiting for silence period index %u", dwRequestIndex);
+                TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to set event to notify that request was added");
+            }
+            break;
+
+        case MON_MESSAGE_REMOVE:
+            *ppRemoveMessage = reinterpret_cast<MON_REMOVE_MESSAGE *>(msg.wParam);
+
+            // Find the request to remove
+            hr = FindRequestIndex(pWaiterContext, *ppRemoveMessage, &dwRequestIndex);
+            if (E_NOTFOUND == hr)
+            {
+                // Nothing to remove (the request may never have been successfully added)
+                hr = S_OK;
+            }
+            else
+            {
+                ExitOnFailure(hr, "Failed to find request index for remove message");
 
-                if (0 < pWaiterContext->rgRequests[dwRequestIndex].dwMaxSilencePeriodInMs)
+                RemoveRequest(pWaiterContext, dwRequestIndex);
+            }
+
+            MonRemoveMessageDestroy(*ppRemoveMessage);
+            *ppRemoveMessage = NULL;
+            break;
+
+        case MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS:
+            if (::PeekMessage(&msg, NULL, MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS, MON_MESSAGE_NETWORK_RETRY_FAILED_NETWORK_WAITS, PM_NOREMOVE))
+            {
+                // If there is another a pending retry failed wait message, skip this one
+                continue;
+            }
+
+            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
+            {
+                pRequest = pWaiterContext->rgpRequests[i];
+                if (MON_DIRECTORY == pRequest->type && pRequest->fNetwork && FAILED(pRequest->hrStatus))
                 {
-                    pWaiterContext->rgRequests[dwRequestIndex].dwSilencePeriodInMs = 0;
-                    pWaiterContext->rgRequests[dwRequestIndex].fSkipDeltaAdd = TRUE;
+                    // This is not a failure, just record this in the request's status
+                    hrTemp = InitiateWait(pWaiterContext, pRequest);
 
-                    if (!pWaiterContext->rgRequests[dwRequestIndex].fPendingFire)
-                    {
-                        pWaiterContext->rgRequests[dwRequestIndex].fPendingFire = TRUE;
-                        ++pWaiterContext->cRequestsPending;
-                    }
+                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, pRequest);
+                    ExitOnFailure(hr, "Failed to update wait status");
                 }
-                else
+            }
+            break;
+
+        case MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS:
+            if (::PeekMessage(&msg, NULL, MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS, MON_MESSAGE_NETWORK_RETRY_SUCCESSFUL_NETWORK_WAITS, PM_NOREMOVE))
+            {
+                // If there is another a pending retry successful wait message, skip this one
+                continue;
+            }
+
+            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
+            {
+                pRequest = pWaiterContext->rgpRequests[i];
+                if (MON_DIRECTORY == pRequest->type && pRequest->fNetwork && SUCCEEDED(pRequest->hrStatus))
                 {
-                    // If no silence period, notify immediately
-                    Notify(S_OK, pWaiterContext, pWaiterContext->rgRequests + dwRequestIndex);
+                    // This is not a failure, just record this in the request's status
+                    hrTemp = InitiateWait(pWaiterContext, pRequest);
+
+                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, pRequest);
+                    ExitOnFailure(hr, "Failed to update wait status");
                 }
             }
-        }
-        else if (WAIT_TIMEOUT != dwRet)
-        {
-            ExitWithLastError(hr, "Failed to wait for multiple objects with return code %u", dwRet);
-        }
+            break;
 
-        // OK, now that we've checked all triggered handles (resetting silence period timers appropriately), check for any pending notifications that we can finally fire
-        // And set dwWait appropriately so we awaken at the right time to fire the next pending notification (in case no further writes occur during that time)
-        if (0 < pWaiterContext->cRequestsPending)
-        {
-            // Start at max value and find the lowest wait we can below that
-            dwWait = DWORD_MAX;
-            cRequestsPendingBeforeLoop = pWaiterContext->cRequestsPending;
+        case MON_MESSAGE_NETWORK_STATUS_UPDATE:
+            if (::PeekMessage(&msg, NULL, MON_MESSAGE_NETWORK_STATUS_UPDATE, MON_MESSAGE_NETWORK_STATUS_UPDATE, PM_NOREMOVE))
+            {
+                // If there is another a pending network status update message, skip this one
+                continue;
+            }
 
             for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
             {
-                if (pWaiterContext->rgRequests[i].fPendingFire)
+                pRequest = pWaiterContext->rgpRequests[i];
+                if (MON_DIRECTORY == pRequest->type && pRequest->fNetwork)
                 {
-                    if (0 == cRequestsPendingBeforeLoop)
-                    {
-                        Assert(FALSE);
-                        hr = HRESULT_FROM_WIN32(ERROR_EA_LIST_INCONSISTENT);
-                        ExitOnFailure(hr, "Phantom pending fires were found!");
-                    }
-                    --cRequestsPendingBeforeLoop;
+                    // Failures here get recorded in the request's status
+                    hrTemp = InitiateWait(pWaiterContext, pRequest);
 
-                    dwRequestIndex = i;
+                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, pRequest);
+                    ExitOnFailure(hr, "Failed to update wait status");
+                }
+            }
+            break;
 
-                    if (pWaiterContext->rgRequests[dwRequestIndex].fSkipDeltaAdd)
+        case MON_MESSAGE_DRIVE_STATUS_UPDATE:
+            for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
+            {
+                pRequest = pWaiterContext->rgpRequests[i];
+                if (MON_DIRECTORY == pRequest->type && pRequest->sczOriginalPathRequest[0] == static_cast<WCHAR>(msg.wParam))
+                {
+                    // Failures here get recorded in the request's status
+                    if (static_cast<BOOL>(msg.lParam))
                     {
-                        pWaiterContext->rgRequests[dwRequestIndex].fSkipDeltaAdd = FALSE;
+                        hrTemp = InitiateWait(pWaiterContext, pRequest);
                     }
                     else
                     {
-                        pWaiterContext->rgRequests[dwRequestIndex].dwSilencePeriodInMs += uDeltaInMs;
+                        // If the message says the drive is disconnected, don't even try to wait, just mark it as gone
+                        AbandonWait(pWaiterContext, pRequest);
+                        hrTemp = E_PATHNOTFOUND;
                     }
 
-                    // silence period has elapsed without further notifications, so reset pending-related variables, and finally fire a notify!
-                    if (pWaiterContext->rgRequests[dwRequestIndex].dwSilencePeriodInMs >= pWaiterContext->rgRequests[dwRequestIndex].dwMaxSilencePeriodInMs)
-                    {
-                        Trace(REPORT_DEBUG, "Silence period surpassed, notifying %u ms late", pWaiterContext->rgRequests[dwRequestIndex].dwSilencePeriodInMs - pWaiterContext->rgRequests[dwRequestIndex].dwMaxSilencePeriodInMs);
-                        Notify(S_OK, pWaiterContext, pWaiterContext->rgRequests + dwRequestIndex);
-                    }
-                    else
+                    hr = UpdateWaitStatus(hrTemp, pWaiterContext, pRequest);
+                    ExitOnFailure(hr, "Failed to update wait status");
+                }
+            }
+            break;
+
+        case MON_MESSAGE_DRIVE_QUERY_REMOVE:
+            pInternalWait = reinterpret_cast<MON_INTERNAL_TEMPORARY_WAIT *>(msg.wParam);
+            // Only do any work if message is not yet out of date
+            // While it could become out of date while doing this processing, sending thread will check response to guard against this
+            if (pInternalWait->dwSendIteration == static_cast<DWORD>(msg.lParam))
+            {
+                for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
+                {
+                    pRequest = pWaiterContext->rgpRequests[i];
+                    if (MON_DIRECTORY == pRequest->type && pRequest->pWait && pRequest->pWait->directory.hDirectory == reinterpret_cast<HANDLE>(pInternalWait->pvContext))
                     {
-                        // set dwWait to the shortest interval period so that if no changes occur, WaitForMultipleObjects
-                        // wakes the thread back up when it's time to fire the next pending notification
-                        if (dwWait > pWaiterContext->rgRequests[dwRequestIndex].dwMaxSilencePeriodInMs - pWaiterContext->rgRequests[dwRequestIndex].dwSilencePeriodInMs)
+                        // Release handles ASAP so the remove request will succeed
+                        AbandonWait(pWaiterContext, pRequest);
+
+                        // Reply to unblock our reply to the remove request
+                        pInternalWait->dwReceiveIteration = static_cast<DWORD>(msg.lParam);
+                        if (!::SetEvent(pInternalWait->hWait))
                         {
-                            dwWait = pWaiterContext->rgRequests[dwRequestIndex].dwMaxSilencePeriodInMs - pWaiterContext->rgRequests[dwRequestIndex].dwSilencePeriodInMs;
+                            TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to set event to notify coordinator thread that removable device handle was released, this could be due to wndproc no longer waiting for waiter thread's response");
                         }
+
+                        // Drive is disconnecting, don't even try to wait, just mark it as gone
+                        hrTemp = E_PATHNOTFOUND;
+
+                        hr = UpdateWaitStatus(hrTemp, pWaiterContext, pRequest);
+                        ExitOnFailure(hr, "Failed to update wait status");
+                        break;
                     }
                 }
             }
+            break;
 
-            // Some post-loop list validation for sanity checking
-            if (0 < cRequestsPendingBeforeLoop)
-            {
-                Assert(FALSE);
-                hr = HRESULT_FROM_WIN32(PEERDIST_ERROR_MISSING_DATA);
-                ExitOnFailure(hr, "Missing %u pending fires! Total pending fires: %u, wait: %u", cRequestsPendingBeforeLoop, pWaiterContext->cRequestsPending, dwWait);
-            }
-            if (0 < pWaiterContext->cRequestsPending && DWORD_MAX == dwWait)
-            {
-                Assert(FALSE);
-                hr = HRESULT_FROM_WIN32(ERROR_CANT_WAIT);
-                ExitOnFailure(hr, "Pending fires exist, but wait was infinite", cRequestsPendingBeforeLoop);
-            }
+        case MON_MESSAGE_STOP:
+            *pfStop = TRUE;
+            ExitFunction1(hr = static_cast<HRESULT>(msg.wParam));
+
+        default:
+            Assert(false);
+            break;
         }
-    } while (fContinue);
+    }
 
-    // Don't bother firing pending notifications. We were told to stop monitoring, so client doesn't care.
+LExit:
+    return hr;
+}
+
+static HRESULT WaitCompleted(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in MON_WAIT *pWait
+    )
+{
+    HRESULT hr = S_OK;
+    HRESULT hrTemp = S_OK;
+    BOOL fNotify = FALSE;
+    MON_REQUEST *pRequest = pWait->pRequest;
+
+    pWait->fPending = FALSE;
+    --pWaiterContext->cWaitsPending;
+
+    if (NULL == pRequest)
+    {
+        // The request moved on to another wait, or was removed, after this one was cancelled
+        WaitDestroy(pWait);
+        ExitFunction();
+    }
+
+    // OK a wait fired - only notify if it's the actual target, and not just some parent waiting for the target child to exist
+    fNotify = (pRequest->dwPathHierarchyIndex == pRequest->cPathHierarchy - 1);
+
+    // Initiate re-waits before we notify callback, to ensure we don't miss a single update
+    hrTemp = InitiateWait(pWaiterContext, pRequest);
+    hr = UpdateWaitStatus(hrTemp, pWaiterContext, pRequest);
+    ExitOnFailure(hr, "Failed to update wait status");
+
+    // If there were no errors and we were already waiting on the right target, or if we weren't yet but are able to now, it's a successful notify
+    if (SUCCEEDED(pRequest->hrStatus) && (fNotify || (pRequest->dwPathHierarchyIndex == pRequest->cPathHierarchy - 1)))
+    {
+        if (0 < pRequest->dwMaxSilencePeriodInMs)
+        {
+            Trace(REPORT_DEBUG, "Changes detected, waiting for silence period for %ls", pRequest->rgsczPathHierarchy[pRequest->cPathHierarchy - 1]);
+            TimerWheelSchedule(&pWaiterContext->timers, pRequest, ::GetTickCount());
+        }
+        else
+        {
+            // If no silence period, notify immediately
+            Notify(S_OK, pWaiterContext, pRequest);
+        }
+    }
 
 LExit:
-    ReleaseStr(sczDirectory);
-    MonAddMessageDestroy(pAddMessage);
-    MonRemoveMessageDestroy(pRemoveMessage);
+    return hr;
+}
 
-    for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
+static void TimerWheelSchedule(
+    __inout MON_TIMER_WHEEL *pTimers,
+    __inout MON_REQUEST *pRequest,
+    __in DWORD dwNow
+    )
+{
+    pRequest->dwFireTime = dwNow + pRequest->dwMaxSilencePeriodInMs;
+
+    // A request that is already pending stays in its earlier slot, and gets moved along when that slot comes up
+    if (!pRequest->fPendingFire)
+    {
+        pRequest->fPendingFire = TRUE;
+        ++pTimers->cPending;
+
+        TimerWheelInsert(pTimers, pRequest);
+    }
+}
+
+static void TimerWheelInsert(
+    __inout MON_TIMER_WHEEL *pTimers,
+    __inout MON_REQUEST *pRequest
+    )
+{
+    pRequest->dwTimerSlot = (pRequest->dwFireTime / MON_TIMER_WHEEL_RESOLUTION_IN_MS) % MON_TIMER_WHEEL_SLOTS;
+    pRequest->pNextTimer = pTimers->rgpSlots[pRequest->dwTimerSlot];
+    pTimers->rgpSlots[pRequest->dwTimerSlot] = pRequest;
+}
+
+static void TimerWheelRemove(
+    __inout MON_TIMER_WHEEL *pTimers,
+    __inout MON_REQUEST *pRequest
+    )
+{
+    MON_REQUEST **ppLink = pTimers->rgpSlots + pRequest->dwTimerSlot;
+
+    while (*ppLink && *ppLink != pRequest)
+    {
+        ppLink = &(*ppLink)->pNextTimer;
+    }
+
+    if (*ppLink)
+    {
+        *ppLink = pRequest->pNextTimer;
+        --pTimers->cPending;
+    }
+
+    pRequest->pNextTimer = NULL;
+    pRequest->fPendingFire = FALSE;
+}
+
+static void TimerWheelAdvance(
+    __in MON_WAITER_CONTEXT *pWaiterContext,
+    __in DWORD dwNow
+    )
+{
+    MON_TIMER_WHEEL *pTimers = &pWaiterContext->timers;
+    DWORD dwSlot = pTimers->dwLastTime / MON_TIMER_WHEEL_RESOLUTION_IN_MS;
+    DWORD cSlots = dwNow / MON_TIMER_WHEEL_RESOLUTION_IN_MS - dwSlot + 1;
+    MON_REQUEST *pRequest = NULL;
+    MON_REQUEST *pNext = NULL;
+
+    if (MON_TIMER_WHEEL_SLOTS < cSlots)
     {
-        MonRequestDestroy(pWaiterContext->rgRequests + i);
+        cSlots = MON_TIMER_WHEEL_SLOTS;
+    }
+
+    // The slot we were in last time is looked at again, since more may have come due in it since
+    for (DWORD i = 0; i < cSlots && 0 < pTimers->cPending; ++i)
+    {
+        dwSlot %= MON_TIMER_WHEEL_SLOTS;
+        pRequest = pTimers->rgpSlots[dwSlot];
+        pTimers->rgpSlots[dwSlot] = NULL;
 
-        switch (pWaiterContext->rgRequests[i].type)
+        while (pRequest)
         {
-        case MON_DIRECTORY:
-            if (INVALID_HANDLE_VALUE != pWaiterContext->rgHandles[i + 1])
+            pNext = pRequest->pNextTimer;
+            pRequest->pNextTimer = NULL;
+
+            if (static_cast<LONG>(dwNow - pRequest->dwFireTime) >= 0)
             {
-                ::FindCloseChangeNotification(pWaiterContext->rgHandles[i + 1]);
+                // silence period has elapsed without further notifications, so finally fire a notify!
+                Trace(REPORT_DEBUG, "Silence period surpassed, notifying %u ms late", dwNow - pRequest->dwFireTime);
+                pRequest->fPendingFire = FALSE;
+                --pTimers->cPending;
+
+                Notify(S_OK, pWaiterContext, pRequest);
             }
-            break;
-        case MON_REGKEY:
-            ReleaseHandle(pWaiterContext->rgHandles[i + 1]);
-            break;
-        default:
-            Assert(false);
+            else
+            {
+                // Either there were more changes since it was scheduled, or it isn't due until a later turn of the wheel
+                TimerWheelInsert(pTimers, pRequest);
+            }
+
+            pRequest = pNext;
         }
+
+        ++dwSlot;
     }
 
-    if (FAILED(hr))
-    {
-        // If waiter thread fails, notify general callback of an error
-        Assert(pWaiterContext->vpfMonGeneral);
-        pWaiterContext->vpfMonGeneral(hr, pWaiterContext->pvContext);
+    pTimers->dwLastTime = dwNow;
+}
 
-        // And tell coordinator to shut all other waiters down
-        if (!::PostThreadMessageW(pWaiterContext->dwCoordinatorThreadId, MON_MESSAGE_STOP, 0, 0))
+static DWORD TimerWheelGetWait(
+    __in MON_TIMER_WHEEL *pTimers,
+    __in DWORD dwNow
+    )
+{
+    DWORD dwSlot = dwNow / MON_TIMER_WHEEL_RESOLUTION_IN_MS;
+
+    if (0 < pTimers->cPending)
+    {
+        for (DWORD i = 0; i < MON_TIMER_WHEEL_SLOTS; ++i)
         {
-            TraceError(HRESULT_FROM_WIN32(::GetLastError()), "Failed to send message to coordinator thread to stop (due to general failure).");
+            if (pTimers->rgpSlots[(dwSlot + i) % MON_TIMER_WHEEL_SLOTS])
+            {
+                // Wake up once the clock has moved past this slot
+                return (i + 1) * MON_TIMER_WHEEL_RESOLUTION_IN_MS - dwNow % MON_TIMER_WHEEL_RESOLUTION_IN_MS;
+            }
         }
     }
 
-    return hr;
+    return INFINITE;
 }
 
 static void Notify(
@@ -1532,13 +1822,9 @@ static void Notify(
 {
     if (pRequest->fPendingFire)
     {
-        --pWaiterContext->cRequestsPending;
+        TimerWheelRemove(&pWaiterContext->timers, pRequest);
     }
 
-    pRequest->fPendingFire = FALSE;
-    pRequest->fSkipDeltaAdd = FALSE;
-    pRequest->dwSilencePeriodInMs = 0;
-
     switch (pRequest->type)
     {
     case MON_DIRECTORY:
@@ -1579,19 +1865,19 @@ static HRESULT FindRequestIndex(
 
     for (DWORD i = 0; i < pWaiterContext->cRequests; ++i)
     {
-        if (pWaiterContext->rgRequests[i].type == pMessage->type)
+        if (pWaiterContext->rgpRequests[i]->type == pMessage->type)
         {
-            switch (pWaiterContext->rgRequests[i].type)
+            switch (pWaiterContext->rgpRequests[i]->type)
             {
             case MON_DIRECTORY:
-                if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pWaiterContext->rgRequests[i].rgsczPathHierarchy[pWaiterContext->rgRequests[i].cPathHierarchy - 1], -1, pMessage->directory.sczDirectory, -1) && pWaiterContext->rgRequests[i].fRecursive == pMessage->fRecursive)
+                if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pWaiterContext->rgpRequests[i]->rgsczPathHierarchy[pWaiterContext->rgpRequests[i]->cPathHierarchy - 1], -1, pMessage->directory.sczDirectory, -1) && pWaiterContext->rgpRequests[i]->fRecursive == pMessage->fRecursive)
                 {
                     *pdwIndex = i;
                     ExitFunction1(hr = S_OK);
                 }
                 break;
             case MON_REGKEY:
-                if (reinterpret_cast<DWORD_PTR>(pMessage->regkey.hkRoot) == reinterpret_cast<DWORD_PTR>(pWaiterContext->rgRequests[i].regkey.hkRoot) && CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pWaiterContext->rgRequests[i].rgsczPathHierarchy[pWaiterContext->rgRequests[i].cPathHierarchy - 1], -1, pMessage->regkey.sczSubKey, -1) && pWaiterContext->rgRequests[i].fRecursive == pMessage->fRecursive && pWaiterContext->rgRequests[i].regkey.kbKeyBitness == pMessage->regkey.kbKeyBitness)
+                if (reinterpret_cast<DWORD_PTR>(pMessage->regkey.hkRoot) == reinterpret_cast<DWORD_PTR>(pWaiterContext->rgpRequests[i]->regkey.hkRoot) && CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, pWaiterContext->rgpRequests[i]->rgsczPathHierarchy[pWaiterContext->rgpRequests[i]->cPathHierarchy - 1], -1, pMessage->regkey.sczSubKey, -1) && pWaiterContext->rgpRequests[i]->fRecursive == pMessage->fRecursive && pWaiterContext->rgpRequests[i]->regkey.kbKeyBitness == pMessage->regkey.kbKeyBitness)
                 {
                     *pdwIndex = i;
                     ExitFunction1(hr = S_OK);
@@ -1609,53 +1895,23 @@ LExit:
     return hr;
 }
 
-static HRESULT RemoveRequest(
+static void RemoveRequest(
     __inout MON_WAITER_CONTEXT *pWaiterContext,
     __in DWORD dwRequestIndex
     )
 {
-    HRESULT hr = S_OK;
-
-    MonRequestDestroy(pWaiterContext->rgRequests + dwRequestIndex);
+    MON_REQUEST *pRequest = pWaiterContext->rgpRequests[dwRequestIndex];
 
-    switch (pWaiterContext->rgRequests[dwRequestIndex].type)
-    {
-    case MON_DIRECTORY:
-        if (pWaiterContext->rgHandles[dwRequestIndex + 1] != INVALID_HANDLE_VALUE)
-        {
-            ::FindCloseChangeNotification(pWaiterContext->rgHandles[dwRequestIndex + 1]);
-        }
-        break;
-    case MON_REGKEY:
-        ReleaseHandle(pWaiterContext->rgHandles[dwRequestIndex + 1]);
-        break;
-    default:
-        Assert(false);
-    }
-
-    if (pWaiterContext->rgRequests[dwRequestIndex].fPendingFire)
+    if (pRequest->fPendingFire)
     {
-        --pWaiterContext->cRequestsPending;
+        TimerWheelRemove(&pWaiterContext->timers, pRequest);
     }
 
-    if (FAILED(pWaiterContext->rgRequests[dwRequestIndex].hrStatus))
-    {
-        --pWaiterContext->cRequestsFailing;
-    }
+    AbandonWait(pWaiterContext, pRequest);
+    MonRequestDestroy(pRequest);
 
-    MemRemoveFromArray(reinterpret_cast<void *>(pWaiterContext->rgHandles), dwRequestIndex + 1, 1, pWaiterContext->cHandles, sizeof(HANDLE), TRUE);
-    --pWaiterContext->cHandles;
-    MemRemoveFromArray(reinterpret_cast<void *>(pWaiterContext->rgRequests), dwRequestIndex, 1, pWaiterContext->cRequests, sizeof(MON_REQUEST), TRUE);
+    MemRemoveFromArray(reinterpret_cast<void *>(pWaiterContext->rgpRequests), dwRequestIndex, 1, pWaiterContext->cRequests, sizeof(MON_REQUEST *), TRUE);
     --pWaiterContext->cRequests;
-
-    // Notify coordinator thread that a wait was removed
-    if (!::PostThreadMessageW(pWaiterContext->dwCoordinatorThreadId, MON_MESSAGE_REMOVED, static_cast<WPARAM>(::GetCurrentThreadId()), 0))
-    {
-        ExitWithLastError(hr, "Failed to send message to coordinator thread to confirm directory was removed.");
-    }
-
-LExit:
-    return hr;
 }
 
 static REGSAM GetRegKeyBitness(
@@ -1676,40 +1932,6 @@ static REGSAM GetRegKeyBitness(
     }
 }
 
-static HRESULT DuplicateRemoveMessage(
-    __in MON_REMOVE_MESSAGE *pMessage,
-    __out MON_REMOVE_MESSAGE **ppMessage
-    )
-{
-    HRESULT hr = S_OK;
-
-    *ppMessage = reinterpret_cast<MON_REMOVE_MESSAGE *>(MemAlloc(sizeof(MON_REMOVE_MESSAGE), TRUE));
-    ExitOnNull(*ppMessage, hr, E_OUTOFMEMORY, "Failed to allocate copy of remove message");
-
-    (*ppMessage)->type = pMessage->type;
-    (*ppMessage)->fRecursive = pMessage->fRecursive;
-
-    switch (pMessage->type)
-    {
-    case MON_DIRECTORY:
-        hr = StrAllocString(&(*ppMessage)->directory.sczDirectory, pMessage->directory.sczDirectory, 0);
-        ExitOnFailure(hr, "Failed to copy directory");
-        break;
-    case MON_REGKEY:
-        (*ppMessage)->regkey.hkRoot = pMessage->regkey.hkRoot;
-        (*ppMessage)->regkey.kbKeyBitness = pMessage->regkey.kbKeyBitness;
-        hr = StrAllocString(&(*ppMessage)->regkey.sczSubKey, pMessage->regkey.sczSubKey, 0);
-        ExitOnFailure(hr, "Failed to copy subkey");
-        break;
-    default:
-        Assert(false);
-        break;
-    }
-
-LExit:
-    return hr;
-}
-
 static LRESULT CALLBACK MonWndProc(
     __in HWND hWnd,
     __in UINT uMsg,
@@ -1727,7 +1949,6 @@ static LRESULT CALLBACK MonWndProc(
     BOOL fArrival = FALSE;
     BOOL fReturnTrue = FALSE;
     CREATESTRUCT *pCreateStruct = NULL;
-    MON_WAITER_CONTEXT *pWaiterContext = NULL;
     MON_STRUCT *pm = NULL;
 
     // keep track of the MON_STRUCT pointer that was passed in on init, associate it with the window
@@ -1761,61 +1982,8 @@ static LRESULT CALLBACK MonWndProc(
                 {
                     if (dwUnitMask & 0x1)
                     {
-                        // This drive had a status update, so send it out to all threads
-                        if (!::PostThreadMessageW(::GetCurrentThreadId(), MON_MESSAGE_DRIVE_STATUS_UPDATE, static_cast<WPARAM>(chDrive), static_cast<LPARAM>(fArrival)))
-                        {
-                            ExitWithLastError(hr, "Failed to send drive status update with drive %wc and arrival %ls", chDrive, fArrival ? L"TRUE" : L"FALSE");
-                        }
-                    }
-                    dwUnitMask >>= 1;
-                    ++chDrive;
-
-                    if (chDrive == 'z')
-                    {
-                        hr = E_UNEXPECTED;
-                        ExitOnFailure(hr, "UnitMask showed drives beyond z:. Remaining UnitMask at this point: %u", dwUnitMask);
-                    }
-                }
-            }
-        }
-        // We can only process device query remove messages if we have a MON_STRUCT pointer
-        else if (DBT_DEVICEQUERYREMOVE == wParam)
-        {
-            pm = reinterpret_cast<MON_STRUCT*>(::GetWindowLongPtrW(hWnd, GWLP_USERDATA));
-            if (!pm)
-            {
-                hr = E_POINTER;
-                ExitOnFailure(hr, "DBT_DEVICEQUERYREMOVE message received with no MON_STRUCT pointer, so message was ignored");
-            }
-
-            fReturnTrue = TRUE;
-
-            pHdr = reinterpret_cast<DEV_BROADCAST_HDR*>(lParam);
-            if (DBT_DEVTYP_HANDLE == pHdr->dbch_devicetype)
-            {
-                // We must wait for the actual wait handle to be released by waiter thread before telling windows to proceed with device removal, otherwise it could fail
-                // due to handles still being open, so use a MON_INTERNAL_TEMPORARY_WAIT struct to send and receive a reply from a waiter thread
-                pm->internalWait.hWait = ::CreateEventW(NULL, TRUE, FALSE, NULL);
-                ExitOnNullWithLastError(pm->internalWait.hWait, hr, "Failed to create anonymous event for waiter to notify wndproc device can be removed");
-
-                pHandle = reinterpret_cast<DEV_BROADCAST_HANDLE*>(lParam);
-                pm->internalWait.pvContext = pHandle->dbch_handle;
-                pm->internalWait.dwReceiveIteration = pm->internalWait.dwSendIteration - 1;
-                // This drive had a status update, so send it out to all threads
-                for (DWORD i = 0; i < pm->cWaiterThreads; ++i)
-                {
-                    pWaiterContext = pm->rgWaiterThreads[i].pWaiterContext;
-
-                    if (!::PostThreadMessageW(pWaiterContext->dwWaiterThreadId, MON_MESSAGE_DRIVE_QUERY_REMOVE, reinterpret_cast<WPARAM>(&pm->internalWait), static_cast<LPARAM>(pm->internalWait.dwSendIteration)))
-                    {
-                        ExitWithLastError(hr, "Failed to send message to waiter thread to notify of drive query remove");
-                    }
-
-                    if (!::SetEvent(pWaiterContext->rgHandles[0]))
-                    {
-                        ExitWithLastError(hr, "Failed to set event to notify waiter thread of incoming drive query remove message");
-                    }
-                }
+                        hr = PostWaiterMessage(pm->pWaiterContext, MON_MESSAGE_DRIVE_QUERY_REMOVE, reinterpret_cast<WPARAM>(&pm->internalWait), static_cast<LPARAM>(pm->internalWait.dwSendIteration));
+                ExitOnFailure(hr, "Failed to send message to waiter thread to notify of drive query remove");
 
                 er = ::WaitForSingleObject(pm->internalWait.hWait, MON_THREAD_WAIT_REMOVE_DEVICE);
                 // Make sure any waiter thread processing really old messages can immediately know that we're no longer waiting for a response
@@ -1829,7 +1997,7 @@ static LRESULT CALLBACK MonWndProc(
                 }
                 else if (WAIT_TIMEOUT == er)
                 {
-                    TraceError(HRESULT_FROM_WIN32(er), "No response from any waiter thread for query remove message");
+                    TraceError(HRESULT_FROM_WIN32(er), "No response from waiter thread for query remove message");
                 }
                 else
                 {
@@ -1933,18 +2101,10 @@ LExit:
 static HRESULT UpdateWaitStatus(
     __in HRESULT hrNewStatus,
     __inout MON_WAITER_CONTEXT *pWaiterContext,
-    __in DWORD dwRequestIndex,
-    __out_opt DWORD *pdwNewRequestIndex
+    __inout MON_REQUEST *pRequest
     )
 {
     HRESULT hr = S_OK;
-    DWORD dwNewRequestIndex;
-    MON_REQUEST *pRequest = pWaiterContext->rgRequests + dwRequestIndex;
-
-    if (NULL != pdwNewRequestIndex)
-    {
-        *pdwNewRequestIndex = dwRequestIndex;
-    }
 
     if (SUCCEEDED(pRequest->hrStatus) || SUCCEEDED(hrNewStatus))
     {
@@ -1962,38 +2122,14 @@ static HRESULT UpdateWaitStatus(
             {
                 ExitWithLastError(hr, "Failed to send message to coordinator thread to notify a network wait started to fail");
             }
-
-            // Move the failing wait to the end of the list of waits and increment cRequestsFailing so WaitForMultipleObjects isn't passed an invalid handle
-            ++pWaiterContext->cRequestsFailing;
-            dwNewRequestIndex = pWaiterContext->cRequests - 1;
-            MemArraySwapItems(reinterpret_cast<void *>(pWaiterContext->rgHandles), dwRequestIndex + 1, dwNewRequestIndex + 1, sizeof(*pWaiterContext->rgHandles));
-            MemArraySwapItems(reinterpret_cast<void *>(pWaiterContext->rgRequests), dwRequestIndex, dwNewRequestIndex, sizeof(*pWaiterContext->rgRequests));
-            // Reset pRequest to the newly swapped item
-            pRequest = pWaiterContext->rgRequests + dwNewRequestIndex;
-            if (NULL != pdwNewRequestIndex)
-            {
-                *pdwNewRequestIndex = dwNewRequestIndex;
-            }
         }
         else if (FAILED(pRequest->hrStatus) && SUCCEEDED(hrNewStatus))
         {
-            Assert(pWaiterContext->cRequestsFailing > 0);
             // If it's a network wait, notify coordinator thread that a network wait is succeeding again
             if (pRequest->fNetwork && !::PostThreadMessageW(pWaiterContext->dwCoordinatorThreadId, MON_MESSAGE_NETWORK_WAIT_SUCCEEDED, 0, 0))
             {
                 ExitWithLastError(hr, "Failed to send message to coordinator thread to notify a network wait is succeeding again");
             }
-
-            --pWaiterContext->cRequestsFailing;
-            dwNewRequestIndex = 0;
-            MemArraySwapItems(reinterpret_cast<void *>(pWaiterContext->rgHandles), dwRequestIndex + 1, dwNewRequestIndex + 1, sizeof(*pWaiterContext->rgHandles));
-            MemArraySwapItems(reinterpret_cast<void *>(pWaiterContext->rgRequests), dwRequestIndex, dwNewRequestIndex, sizeof(*pWaiterContext->rgRequests));
-            // Reset pRequest to the newly swapped item
-            pRequest = pWaiterContext->rgRequests + dwNewRequestIndex;
-            if (NULL != pdwNewRequestIndex)
-            {
-                *pdwNewRequestIndex = dwNewRequestIndex;
-            }
         }
     }
 
@@ -89,6 +89,7 @@
 #include "condutil.h" // NOTE: This must come after varutil.h since it uses it.
 #include "wiutil.h"
 #include "wuautil.h"
+#include "xmlreaderutil.h"
 #include <comutil.h>  // This header is needed for msxml2.h to compile correctly
 #include <msxml2.h>   // This file is needed to include xmlutil.h
 #include "xmlutil.h"
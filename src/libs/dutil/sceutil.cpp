@@ -34,7 +34,39 @@ typedef DWORD DB_URESERVE;
 
 #ifndef SKIP_SCE_COMPILE // If the sce headers don't support 64-bit, don't build for 64-bit
 
+// Number of prepared accessors (and their index rowsets) kept open per database
+#define SCE_PREPARED_CACHE_SIZE 32
+
+// Values are laid out in slots of at least this size, rounded up to a power of two,
+// so a prepared accessor can be reused by values of similar length
+#define SCE_PREPARED_MIN_VALUE_SIZE 64
+
+// Larger values don't keep a buffer around in the cache
+#define SCE_PREPARED_MAX_VALUE_SIZE (64 * 1024)
+
 // structs
+struct SCE_PREPARED
+{
+    SCE_TABLE_SCHEMA *pTableSchema;
+    SCE_INDEX_SCHEMA *pIndexSchema; // NULL when the accessor is for inserting and updating through the table rowset
+    BOOL fRange;
+
+    DWORD cBindings;
+    DBBINDING *rgBinding;
+    BYTE *pbData;
+
+    IRowsetIndex *pIRowsetIndex;
+    IRowset *pIRowset;
+    IAccessor *pIAccessor;
+    HACCESSOR hAccessor;
+
+    volatile LONG cReferences; // Query results and rows still positioned on pIRowset
+    BOOL fOrphaned; // No longer in the cache, freed when the last reference is released
+    DWORD dwLastUsed;
+};
+
+struct SCE_QUERY;
+
 struct SCE_DATABASE_INTERNAL
 {
     // In case we call DllGetClassObject on a specific file
@@ -55,6 +87,14 @@ struct SCE_DATABASE_INTERNAL
 
     // If the database was opened as read-only, we copied it here - so delete it on close
     LPWSTR sczTempDbFile;
+
+    // Index seeks and accessors prepared by earlier queries and updates
+    SCE_PREPARED *rgpPrepared[SCE_PREPARED_CACHE_SIZE];
+    DWORD cPrepared;
+    DWORD dwPreparedTick;
+
+    // The last freed query, kept so the next one doesn't have to allocate its bindings
+    SCE_QUERY *pSpareQuery;
 };
 
 struct SCE_ROW
@@ -70,6 +110,9 @@ struct SCE_ROW
     DBBINDING *rgBinding;
     SIZE_T cbOffset;
     BYTE *pbData;
+
+    SCE_PREPARED *pPrepared; // The prepared query whose rowset this row came from
+    SCE_DATABASE *pBatchDatabase; // Set when this row is reused to insert a batch of rows
 };
 
 struct SCE_QUERY
@@ -81,6 +124,7 @@ struct SCE_QUERY
     // Accessor build-up members
     DWORD dwBindingIndex;
     DBBINDING *rgBinding;
+    DWORD cBindingsAllocated;
     SIZE_T cbOffset;
     BYTE *pbData;
 };
@@ -90,6 +134,7 @@ struct SCE_QUERY_RESULTS
     SCE_DATABASE_INTERNAL *pDatabaseInternal;
     IRowset *pIRowset;
     SCE_TABLE_SCHEMA *pTableSchema;
+    SCE_PREPARED *pPrepared;
 };
 
 extern const int SCE_ROW_HANDLE_BYTES = sizeof(SCE_ROW);
@@ -206,6 +251,55 @@ static HRESULT SetDatabaseSchemaInfo(
     __in LPCWSTR wzSchemaType,
     __in DWORD dwVersion
     );
+static HRESULT OpenIndexRowset(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal,
+    __in const SCE_TABLE_SCHEMA *pTableSchema,
+    __in const SCE_INDEX_SCHEMA *pIndexSchema,
+    __out IRowsetIndex **ppIRowsetIndex,
+    __out IRowset **ppIRowset
+    );
+static HRESULT AcquirePrepared(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal,
+    __in SCE_TABLE_SCHEMA *pTableSchema,
+    __in_opt SCE_INDEX_SCHEMA *pIndexSchema,
+    __in BOOL fRange,
+    __in_ecount(cBindings) const DBBINDING *rgBinding,
+    __in DWORD cBindings,
+    __in_opt const BYTE *pbData,
+    __out SCE_PREPARED **ppPrepared
+    );
+static HRESULT CreatePrepared(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal,
+    __in SCE_TABLE_SCHEMA *pTableSchema,
+    __in_opt SCE_INDEX_SCHEMA *pIndexSchema,
+    __in BOOL fRange,
+    __in_ecount(cBindings) const DBBINDING *rgBinding,
+    __in DWORD cBindings,
+    __out SCE_PREPARED **ppPrepared
+    );
+static BOOL PreparedMatches(
+    __in const SCE_PREPARED *pPrepared,
+    __in const SCE_TABLE_SCHEMA *pTableSchema,
+    __in_opt const SCE_INDEX_SCHEMA *pIndexSchema,
+    __in BOOL fRange,
+    __in_ecount(cBindings) const DBBINDING *rgBinding,
+    __in DWORD cBindings
+    );
+static DBBYTEOFFSET PreparedValueSize(
+    __in DBBYTEOFFSET cbValue
+    );
+static void ReleasePreparedReference(
+    __in_opt SCE_PREPARED *pPrepared
+    );
+static void ReleasePrepared(
+    __in_opt SCE_PREPARED *pPrepared
+    );
+static void ReleasePreparedCache(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal
+    );
+static void ReleaseQuery(
+    __in SCE_QUERY *pQuery
+    );
 static void ReleaseDatabase(
     SCE_DATABASE *pDatabase
     );
@@ -614,6 +708,8 @@ extern "C" HRESULT DAPI SceCommitTransaction(
         {
             hr = pDatabaseInternal->pITransactionLocal->Abort(NULL, FALSE, FALSE);
             ExitOnFailure(hr, "Failed to abort transaction");
+
+            ReleasePreparedCache(pDatabaseInternal);
         }
         else
         {
@@ -656,6 +752,9 @@ extern "C" HRESULT DAPI SceRollbackTransaction(
         ExitOnFailure(hr, "Failed to abort transaction");
         pDatabaseInternal->fPendingChanges = FALSE;
 
+        // Don't trust rowsets opened during the transaction to survive the abort
+        ReleasePreparedCache(pDatabaseInternal);
+
         pDatabaseInternal->fRollbackTransaction = FALSE;
     }
     else
@@ -732,43 +831,64 @@ extern "C" HRESULT DAPI SceFinishUpdate(
 {
     HRESULT hr = S_OK;
     SCE_ROW *pRow = reinterpret_cast<SCE_ROW *>(rowHandle);
+    SCE_PREPARED *pPrepared = NULL;
     IAccessor *pIAccessor = NULL;
     IRowsetChange *pIRowsetChange = NULL;
     DBBINDSTATUS *rgBindStatus = NULL;
     HACCESSOR hAccessor = DB_NULL_HACCESSOR;
+    BYTE *pbData = pRow->pbData;
     HROW hRow = DB_NULL_HROW;
 
-    hr = pRow->pIRowset->QueryInterface(IID_IAccessor, reinterpret_cast<void **>(&pIAccessor));
-    ExitOnFailure(hr, "Failed to get IAccessor interface");
+    // Rows written through the table rowset share an accessor with earlier rows of the same shape
+    if (pRow->pIRowset == pRow->pTableSchema->pIRowset)
+    {
+        hr = AcquirePrepared(pRow->pDatabaseInternal, pRow->pTableSchema, NULL, FALSE, pRow->rgBinding, pRow->dwBindingIndex, pRow->pbData, &pPrepared);
+        ExitOnFailure(hr, "Failed to prepare accessor");
+    }
 
-// This can be used when stepping through the debugger to see bind failures
-#ifdef DEBUG
-    if (0 < pRow->dwBindingIndex)
+    if (pPrepared)
     {
-        hr = MemEnsureArraySize(reinterpret_cast<void **>(&rgBindStatus), pRow->dwBindingIndex, sizeof(DBBINDSTATUS), 0);
-        ExitOnFailure(hr, "Failed to ensure binding status array size");
+        hAccessor = pPrepared->hAccessor;
+        pbData = pPrepared->pbData;
     }
+    else
+    {
+        hr = pRow->pIRowset->QueryInterface(IID_IAccessor, reinterpret_cast<void **>(&pIAccessor));
+        ExitOnFailure(hr, "Failed to get IAccessor interface");
+
+// This can be used when stepping through the debugger to see bind failures
+#ifdef DEBUG
+        if (0 < pRow->dwBindingIndex)
+        {
+            hr = MemEnsureArraySize(reinterpret_cast<void **>(&rgBindStatus), pRow->dwBindingIndex, sizeof(DBBINDSTATUS), 0);
+            ExitOnFailure(hr, "Failed to ensure binding status array size");
+        }
 #endif
 
-    hr = pIAccessor->CreateAccessor(DBACCESSOR_ROWDATA, pRow->dwBindingIndex, pRow->rgBinding, 0, &hAccessor, rgBindStatus);
-    ExitOnFailure(hr, "Failed to create accessor");
+        hr = pIAccessor->CreateAccessor(DBACCESSOR_ROWDATA, pRow->dwBindingIndex, pRow->rgBinding, 0, &hAccessor, rgBindStatus);
+        ExitOnFailure(hr, "Failed to create accessor");
+    }
 
     hr = pRow->pIRowset->QueryInterface(IID_IRowsetChange, reinterpret_cast<void **>(&pIRowsetChange));
     ExitOnFailure(hr, "Failed to get IRowsetChange interface");
 
     if (pRow->fInserting)
     {
-        hr = pIRowsetChange->InsertRow(DB_NULL_HCHAPTER, hAccessor, pRow->pbData, &hRow);
+        // Rows inserted as part of a batch are never read back, so don't hold on to them
+        hr = pIRowsetChange->InsertRow(DB_NULL_HCHAPTER, hAccessor, pbData, pRow->pBatchDatabase ? NULL : &hRow);
         ExitOnFailure(hr, "Failed to insert new row");
 
-        pRow->hRow = hRow;
-        ReleaseNullObject(pRow->pIRowset);
-        pRow->pIRowset = pRow->pTableSchema->pIRowset;
-        pRow->pIRowset->AddRef();
+        if (!pRow->pBatchDatabase)
+        {
+            pRow->hRow = hRow;
+            ReleaseNullObject(pRow->pIRowset);
+            pRow->pIRowset = pRow->pTableSchema->pIRowset;
+            pRow->pIRowset->AddRef();
+        }
     }
     else
     {
-        hr = pIRowsetChange->SetData(pRow->hRow, hAccessor, pRow->pbData);
+        hr = pIRowsetChange->SetData(pRow->hRow, hAccessor, pbData);
         ExitOnFailure(hr, "Failed to update existing row");
     }
 
@@ -782,7 +902,14 @@ extern "C" HRESULT DAPI SceFinishUpdate(
     }
 
 LExit:
-    if (DB_NULL_HACCESSOR != hAccessor)
+    // A batch row starts over for the next insert, keeping its buffers
+    if (pRow->pBatchDatabase)
+    {
+        pRow->dwBindingIndex = 0;
+        pRow->cbOffset = 0;
+    }
+
+    if (!pPrepared && DB_NULL_HACCESSOR != hAccessor)
     {
         pIAccessor->ReleaseAccessor(hAccessor, NULL);
     }
@@ -793,6 +920,69 @@ LExit:
     return hr;
 }
 
+extern "C" HRESULT DAPI SceBeginInsertBatch(
+    __in SCE_DATABASE *pDatabase,
+    __in DWORD dwTableIndex,
+    __deref_out_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE *pRowHandle
+    )
+{
+    HRESULT hr = S_OK;
+    BOOL fInTransaction = FALSE;
+    SCE_ROW_HANDLE rowHandle = NULL;
+
+    hr = SceBeginTransaction(pDatabase);
+    ExitOnFailure(hr, "Failed to begin transaction for insert batch");
+    fInTransaction = TRUE;
+
+    hr = ScePrepareInsert(pDatabase, dwTableIndex, &rowHandle);
+    ExitOnFailure(hr, "Failed to prepare row for insert batch");
+
+    reinterpret_cast<SCE_ROW *>(rowHandle)->pBatchDatabase = pDatabase;
+
+    *pRowHandle = rowHandle;
+    rowHandle = NULL;
+
+LExit:
+    ReleaseSceRow(rowHandle);
+    if (FAILED(hr) && fInTransaction)
+    {
+        SceRollbackTransaction(pDatabase);
+    }
+
+    return hr;
+}
+
+extern "C" HRESULT DAPI SceEndInsertBatch(
+    __inout_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE *pRowHandle,
+    __in BOOL fCommit
+    )
+{
+    HRESULT hr = S_OK;
+    SCE_ROW *pRow = reinterpret_cast<SCE_ROW *>(*pRowHandle);
+    SCE_DATABASE *pDatabase = pRow->pBatchDatabase;
+
+    if (fCommit)
+    {
+        hr = SceCommitTransaction(pDatabase);
+        ExitOnFailure(hr, "Failed to commit insert batch");
+    }
+    else
+    {
+        hr = SceRollbackTransaction(pDatabase);
+        ExitOnFailure(hr, "Failed to rollback insert batch");
+    }
+
+LExit:
+    // The caller no longer has a handle to the transaction, so roll back a failed commit here
+    if (FAILED(hr) && fCommit)
+    {
+        SceRollbackTransaction(pDatabase);
+    }
+    ReleaseNullSceRow(*pRowHandle);
+
+    return hr;
+}
+
 extern "C" HRESULT DAPI SceSetColumnBinary(
     __in_bcount(SCE_ROW_HANDLE_BYTES) SCE_ROW_HANDLE rowHandle,
     __in DWORD dwColumnIndex,
@@ -1175,24 +1365,49 @@ extern "C" HRESULT DAPI SceBeginQuery(
 {
     HRESULT hr = S_OK;
     size_t cbAllocSize = 0;
-    SCE_QUERY *psq = static_cast<SCE_QUERY*>(MemAlloc(sizeof(SCE_QUERY), TRUE));
-    ExitOnNull(psq, hr, E_OUTOFMEMORY, "Failed to allocate new sce query");
+    SCE_DATABASE_INTERNAL *pDatabaseInternal = reinterpret_cast<SCE_DATABASE_INTERNAL *>(pDatabase->sdbHandle);
+    SCE_TABLE_SCHEMA *pTableSchema = &(pDatabase->pdsSchema->rgTables[dwTableIndex]);
+    SCE_QUERY *psq = reinterpret_cast<SCE_QUERY *>(::InterlockedExchangePointer(reinterpret_cast<PVOID *>(&pDatabaseInternal->pSpareQuery), NULL));
 
-    psq->pTableSchema = &(pDatabase->pdsSchema->rgTables[dwTableIndex]);
-    psq->pIndexSchema = &(psq->pTableSchema->rgIndexes[dwIndex]);
-    psq->pDatabaseInternal = reinterpret_cast<SCE_DATABASE_INTERNAL *>(pDatabase->sdbHandle);
+    // Reuse the last freed query and its buffers if it has room for this table's columns
+    if (psq && psq->cBindingsAllocated < pTableSchema->cColumns)
+    {
+        ReleaseQuery(psq);
+        psq = NULL;
+    }
 
-    hr = ::SizeTMult(sizeof(DBBINDING), psq->pTableSchema->cColumns, &cbAllocSize);
-    ExitOnFailure(hr, "Overflow while calculating allocation size for DBBINDING to begin query, columns: %u", psq->pTableSchema->cColumns);
+    if (psq)
+    {
+        memset(psq->rgBinding, 0, sizeof(DBBINDING) * psq->cBindingsAllocated);
+        psq->dwBindingIndex = 0;
+        psq->cbOffset = 0;
+    }
+    else
+    {
+        psq = static_cast<SCE_QUERY*>(MemAlloc(sizeof(SCE_QUERY), TRUE));
+        ExitOnNull(psq, hr, E_OUTOFMEMORY, "Failed to allocate new sce query");
 
-    psq->rgBinding = static_cast<DBBINDING *>(MemAlloc(cbAllocSize, TRUE));
-    ExitOnNull(psq, hr, E_OUTOFMEMORY, "Failed to allocate DBBINDINGs for new sce query");
+        hr = ::SizeTMult(sizeof(DBBINDING), pTableSchema->cColumns, &cbAllocSize);
+        ExitOnFailure(hr, "Overflow while calculating allocation size for DBBINDING to begin query, columns: %u", pTableSchema->cColumns);
+
+        psq->rgBinding = static_cast<DBBINDING *>(MemAlloc(cbAllocSize, TRUE));
+        ExitOnNull(psq->rgBinding, hr, E_OUTOFMEMORY, "Failed to allocate DBBINDINGs for new sce query");
+
+        psq->cBindingsAllocated = pTableSchema->cColumns;
+    }
+
+    psq->pTableSchema = pTableSchema;
+    psq->pIndexSchema = &(pTableSchema->rgIndexes[dwIndex]);
+    psq->pDatabaseInternal = pDatabaseInternal;
 
     *psqhHandle = static_cast<SCE_QUERY_HANDLE>(psq);
     psq = NULL;
 
 LExit:
-    ReleaseSceQuery(psq);
+    if (psq)
+    {
+        ReleaseQuery(psq);
+    }
 
     return hr;
 }
@@ -1406,6 +1621,13 @@ extern "C" HRESULT DAPI SceGetNextResultRow(
     pRow->pIRowset = pQueryResults->pIRowset;
     pRow->pIRowset->AddRef();
 
+    // The prepared query can't be positioned again while this row is held
+    if (pQueryResults->pPrepared)
+    {
+        pRow->pPrepared = pQueryResults->pPrepared;
+        ::InterlockedIncrement(&pRow->pPrepared->cReferences);
+    }
+
     *pRowHandle = reinterpret_cast<SCE_ROW_HANDLE>(pRow);
     pRow = NULL;
     hRow = DB_NULL_HROW;
@@ -1431,6 +1653,7 @@ extern "C" void DAPI SceFreeRow(
         pRow->pIRowset->ReleaseRows(1, &pRow->hRow, NULL, NULL, NULL);
     }
     ReleaseObject(pRow->pIRowset);
+    ReleasePreparedReference(pRow->pPrepared);
     ReleaseMem(pRow->rgBinding);
     ReleaseMem(pRow->pbData);
     ReleaseMem(pRow);
@@ -1442,9 +1665,11 @@ void DAPI SceFreeQuery(
 {
     SCE_QUERY *pQuery = reinterpret_cast<SCE_QUERY *>(sqhHandle);
 
-    ReleaseMem(pQuery->rgBinding);
-    ReleaseMem(pQuery->pbData);
-    ReleaseMem(pQuery);
+    // Keep the query for the next SceBeginQuery unless there already is one
+    if (NULL != ::InterlockedCompareExchangePointer(reinterpret_cast<PVOID *>(&pQuery->pDatabaseInternal->pSpareQuery), pQuery, NULL))
+    {
+        ReleaseQuery(pQuery);
+    }
 }
 
 void DAPI SceFreeQueryResults(
@@ -1454,6 +1679,7 @@ void DAPI SceFreeQueryResults(
     SCE_QUERY_RESULTS *pQueryResults = reinterpret_cast<SCE_QUERY_RESULTS *>(sqrhHandle);
 
     ReleaseObject(pQueryResults->pIRowset);
+    ReleasePreparedReference(pQueryResults->pPrepared);
     ReleaseMem(pQueryResults);
 }
 
@@ -1528,48 +1754,44 @@ static HRESULT RunQuery(
     )
 {
     HRESULT hr = S_OK;
-    DBID tableID = { };
-    DBID indexID = { };
     IAccessor *pIAccessor = NULL;
     IRowsetIndex *pIRowsetIndex = NULL;
     IRowset *pIRowset = NULL;
     HACCESSOR hAccessor = DB_NULL_HACCESSOR;
+    BYTE *pbData = NULL;
     SCE_QUERY *pQuery = reinterpret_cast<SCE_QUERY *>(psqhHandle);
     SCE_QUERY_RESULTS *pQueryResults = NULL;
-    DBPROPSET rgdbpIndexPropSet[1];
-    DBPROP rgdbpIndexProp[1];
+    SCE_PREPARED *pPrepared = NULL;
 
-    rgdbpIndexPropSet[0].cProperties     = 1;
-    rgdbpIndexPropSet[0].guidPropertySet = DBPROPSET_ROWSET;
-    rgdbpIndexPropSet[0].rgProperties    = rgdbpIndexProp;
-
-    rgdbpIndexProp[0].dwPropertyID       = DBPROP_IRowsetIndex;
-    rgdbpIndexProp[0].dwOptions          = DBPROPOPTIONS_REQUIRED;
-    rgdbpIndexProp[0].colid              = DB_NULLID;
-    rgdbpIndexProp[0].vValue.vt          = VT_BOOL;
-    rgdbpIndexProp[0].vValue.boolVal     = VARIANT_TRUE;
-
-    tableID.eKind = DBKIND_NAME;
-    tableID.uName.pwszName = const_cast<WCHAR *>(pQuery->pTableSchema->wzName);
-
-    indexID.eKind = DBKIND_NAME;
-    indexID.uName.pwszName = const_cast<WCHAR *>(pQuery->pIndexSchema->wzName);
+    hr = AcquirePrepared(pQuery->pDatabaseInternal, pQuery->pTableSchema, pQuery->pIndexSchema, fRange, pQuery->rgBinding, pQuery->dwBindingIndex, pQuery->pbData, &pPrepared);
+    ExitOnFailure(hr, "Failed to prepare query");
 
-    hr = pQuery->pDatabaseInternal->pIOpenRowset->OpenRowset(NULL, &tableID, &indexID, IID_IRowsetIndex, _countof(rgdbpIndexPropSet), rgdbpIndexPropSet, (IUnknown**) &pIRowsetIndex);
-    ExitOnFailure(hr, "Failed to open IRowsetIndex");
+    if (pPrepared)
+    {
+        pIRowsetIndex = pPrepared->pIRowsetIndex;
+        pIRowsetIndex->AddRef();
+        pIRowset = pPrepared->pIRowset;
+        pIRowset->AddRef();
+        hAccessor = pPrepared->hAccessor;
+        pbData = pPrepared->pbData;
+    }
+    else
+    {
+        hr = OpenIndexRowset(pQuery->pDatabaseInternal, pQuery->pTableSchema, pQuery->pIndexSchema, &pIRowsetIndex, &pIRowset);
+        ExitOnFailure(hr, "Failed to open index rowset");
 
-    hr = pIRowsetIndex->QueryInterface(IID_IRowset, reinterpret_cast<void **>(&pIRowset));
-    ExitOnFailure(hr, "Failed to get IRowset interface from IRowsetIndex");
+        hr = pIRowset->QueryInterface(IID_IAccessor, reinterpret_cast<void **>(&pIAccessor));
+        ExitOnFailure(hr, "Failed to get IAccessor interface");
 
-    hr = pIRowset->QueryInterface(IID_IAccessor, reinterpret_cast<void **>(&pIAccessor));
-    ExitOnFailure(hr, "Failed to get IAccessor interface");
+        hr = pIAccessor->CreateAccessor(DBACCESSOR_ROWDATA, pQuery->dwBindingIndex, pQuery->rgBinding, 0, &hAccessor, NULL);
+        ExitOnFailure(hr, "Failed to create accessor");
 
-    hr = pIAccessor->CreateAccessor(DBACCESSOR_ROWDATA, pQuery->dwBindingIndex, pQuery->rgBinding, 0, &hAccessor, NULL);
-    ExitOnFailure(hr, "Failed to create accessor");
+        pbData = pQuery->pbData;
+    }
 
     if (!fRange)
     {
-        hr = pIRowsetIndex->Seek(hAccessor, pQuery->dwBindingIndex, pQuery->pbData, DBSEEK_FIRSTEQ);
+        hr = pIRowsetIndex->Seek(hAccessor, pQuery->dwBindingIndex, pbData, DBSEEK_FIRSTEQ);
         if (DB_E_NOTFOUND == hr)
         {
             ExitFunction1(hr = E_NOTFOUND);
@@ -1581,7 +1803,7 @@ static HRESULT RunQuery(
         // If ALL columns in the index were specified, do a full key match
         if (pQuery->dwBindingIndex == pQuery->pIndexSchema->cColumns)
         {
-            hr = pIRowsetIndex->SetRange(hAccessor, pQuery->dwBindingIndex, pQuery->pbData, 0, NULL, DBRANGE_MATCH);
+            hr = pIRowsetIndex->SetRange(hAccessor, pQuery->dwBindingIndex, pbData, 0, NULL, DBRANGE_MATCH);
         }
         else
         {
@@ -1589,7 +1811,7 @@ static HRESULT RunQuery(
             // We really want to use DBRANGE_MATCH_N_SHIFT here, but SQL CE doesn't appear to support it
             // So instead, we set the start and end to the same partial key, and then allow inclusive matching
             // This appears to accomplish the same thing
-            hr = pIRowsetIndex->SetRange(hAccessor, pQuery->dwBindingIndex, pQuery->pbData, pQuery->dwBindingIndex, pQuery->pbData, 0);
+            hr = pIRowsetIndex->SetRange(hAccessor, pQuery->dwBindingIndex, pbData, pQuery->dwBindingIndex, pbData, 0);
         }
         if (DB_E_NOTFOUND == hr || E_NOTFOUND == hr)
         {
@@ -1606,11 +1828,17 @@ static HRESULT RunQuery(
     pQueryResults->pIRowset = pIRowset;
     pIRowset = NULL;
 
+    if (pPrepared)
+    {
+        pQueryResults->pPrepared = pPrepared;
+        ::InterlockedIncrement(&pPrepared->cReferences);
+    }
+
     *ppQueryResults = pQueryResults;
     pQueryResults = NULL;
 
 LExit:
-    if (DB_NULL_HACCESSOR != hAccessor)
+    if (pIAccessor && DB_NULL_HACCESSOR != hAccessor)
     {
         pIAccessor->ReleaseAccessor(hAccessor, NULL);
     }
@@ -1618,11 +1846,328 @@ LExit:
     ReleaseObject(pIRowset);
     ReleaseObject(pIRowsetIndex);
     ReleaseMem(pQueryResults);
-    ReleaseSceQueryResults(pQueryResults);
 
     return hr;
 }
 
+static HRESULT OpenIndexRowset(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal,
+    __in const SCE_TABLE_SCHEMA *pTableSchema,
+    __in const SCE_INDEX_SCHEMA *pIndexSchema,
+    __out IRowsetIndex **ppIRowsetIndex,
+    __out IRowset **ppIRowset
+    )
+{
+    HRESULT hr = S_OK;
+    DBID tableID = { };
+    DBID indexID = { };
+    IRowsetIndex *pIRowsetIndex = NULL;
+    DBPROPSET rgdbpIndexPropSet[1];
+    DBPROP rgdbpIndexProp[1];
+
+    rgdbpIndexPropSet[0].cProperties     = 1;
+    rgdbpIndexPropSet[0].guidPropertySet = DBPROPSET_ROWSET;
+    rgdbpIndexPropSet[0].rgProperties    = rgdbpIndexProp;
+
+    rgdbpIndexProp[0].dwPropertyID       = DBPROP_IRowsetIndex;
+    rgdbpIndexProp[0].dwOptions          = DBPROPOPTIONS_REQUIRED;
+    rgdbpIndexProp[0].colid              = DB_NULLID;
+    rgdbpIndexProp[0].vValue.vt          = VT_BOOL;
+    rgdbpIndexProp[0].vValue.boolVal     = VARIANT_TRUE;
+
+    tableID.eKind = DBKIND_NAME;
+    tableID.uName.pwszName = const_cast<WCHAR *>(pTableSchema->wzName);
+
+    indexID.eKind = DBKIND_NAME;
+    indexID.uName.pwszName = const_cast<WCHAR *>(pIndexSchema->wzName);
+
+    hr = pDatabaseInternal->pIOpenRowset->OpenRowset(NULL, &tableID, &indexID, IID_IRowsetIndex, _countof(rgdbpIndexPropSet), rgdbpIndexPropSet, (IUnknown**) &pIRowsetIndex);
+    ExitOnFailure(hr, "Failed to open IRowsetIndex");
+
+    hr = pIRowsetIndex->QueryInterface(IID_IRowset, reinterpret_cast<void **>(ppIRowset));
+    ExitOnFailure(hr, "Failed to get IRowset interface from IRowsetIndex");
+
+    *ppIRowsetIndex = pIRowsetIndex;
+    pIRowsetIndex = NULL;
+
+LExit:
+    ReleaseObject(pIRowsetIndex);
+
+    return hr;
+}
+
+// Finds an idle prepared accessor whose bindings have the same columns, types and value slot sizes,
+// preparing a new one if there is none, and copies the values in pbData into its buffer.
+// Returns S_OK with *ppPrepared set to NULL when the values can't be prepared.
+static HRESULT AcquirePrepared(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal,
+    __in SCE_TABLE_SCHEMA *pTableSchema,
+    __in_opt SCE_INDEX_SCHEMA *pIndexSchema,
+    __in BOOL fRange,
+    __in_ecount(cBindings) const DBBINDING *rgBinding,
+    __in DWORD cBindings,
+    __in_opt const BYTE *pbData,
+    __out SCE_PREPARED **ppPrepared
+    )
+{
+    HRESULT hr = S_OK;
+    SCE_PREPARED *pPrepared = NULL;
+    DWORD dwEvict = SCE_PREPARED_CACHE_SIZE;
+
+    *ppPrepared = NULL;
+
+    if (0 == cBindings)
+    {
+        ExitFunction();
+    }
+
+    for (DWORD i = 0; i < cBindings; ++i)
+    {
+        if (SCE_PREPARED_MAX_VALUE_SIZE < rgBinding[i].cbMaxLen)
+        {
+            ExitFunction();
+        }
+    }
+
+    for (DWORD i = 0; i < pDatabaseInternal->cPrepared; ++i)
+    {
+        SCE_PREPARED *pCandidate = pDatabaseInternal->rgpPrepared[i];
+
+        // An index rowset can only be positioned for one query at a time, accessors on the table rowset can be shared
+        if (pCandidate->pIndexSchema && 0 < pCandidate->cReferences)
+        {
+            continue;
+        }
+
+        if (PreparedMatches(pCandidate, pTableSchema, pIndexSchema, fRange, rgBinding, cBindings))
+        {
+            pPrepared = pCandidate;
+            break;
+        }
+
+        if (0 == pCandidate->cReferences && (SCE_PREPARED_CACHE_SIZE == dwEvict || pCandidate->dwLastUsed < pDatabaseInternal->rgpPrepared[dwEvict]->dwLastUsed))
+        {
+            dwEvict = i;
+        }
+    }
+
+    if (!pPrepared)
+    {
+        if (SCE_PREPARED_CACHE_SIZE == pDatabaseInternal->cPrepared)
+        {
+            // Everything in the cache is busy, so let the caller do it the slow way
+            if (SCE_PREPARED_CACHE_SIZE == dwEvict)
+            {
+                ExitFunction();
+            }
+
+            ReleasePrepared(pDatabaseInternal->rgpPrepared[dwEvict]);
+            pDatabaseInternal->rgpPrepared[dwEvict] = pDatabaseInternal->rgpPrepared[pDatabaseInternal->cPrepared - 1];
+            --pDatabaseInternal->cPrepared;
+        }
+
+        hr = CreatePrepared(pDatabaseInternal, pTableSchema, pIndexSchema, fRange, rgBinding, cBindings, &pPrepared);
+        ExitOnFailure(hr, "Failed to prepare accessor for table: %ls", pTableSchema->wzName);
+
+        pDatabaseInternal->rgpPrepared[pDatabaseInternal->cPrepared] = pPrepared;
+        ++pDatabaseInternal->cPrepared;
+    }
+
+    for (DWORD i = 0; i < cBindings; ++i)
+    {
+        const DBBINDING *pBinding = rgBinding + i;
+        const DBBINDING *pPreparedBinding = pPrepared->rgBinding + i;
+
+        memcpy(pPrepared->pbData + pPreparedBinding->obLength, pbData + pBinding->obLength, sizeof(DBBYTEOFFSET));
+        memcpy(pPrepared->pbData + pPreparedBinding->obValue, pbData + pBinding->obValue, pBinding->cbMaxLen);
+        memcpy(pPrepared->pbData + pPreparedBinding->obStatus, pbData + pBinding->obStatus, sizeof(DBSTATUS));
+    }
+
+    pPrepared->dwLastUsed = ++pDatabaseInternal->dwPreparedTick;
+    *ppPrepared = pPrepared;
+
+LExit:
+    return hr;
+}
+
+static HRESULT CreatePrepared(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal,
+    __in SCE_TABLE_SCHEMA *pTableSchema,
+    __in_opt SCE_INDEX_SCHEMA *pIndexSchema,
+    __in BOOL fRange,
+    __in_ecount(cBindings) const DBBINDING *rgBinding,
+    __in DWORD cBindings,
+    __out SCE_PREPARED **ppPrepared
+    )
+{
+    HRESULT hr = S_OK;
+    SCE_PREPARED *pPrepared = NULL;
+    SIZE_T cbOffset = 0;
+
+    pPrepared = static_cast<SCE_PREPARED *>(MemAlloc(sizeof(SCE_PREPARED), TRUE));
+    ExitOnNull(pPrepared, hr, E_OUTOFMEMORY, "Failed to allocate prepared accessor");
+
+    pPrepared->pTableSchema = pTableSchema;
+    pPrepared->pIndexSchema = pIndexSchema;
+    pPrepared->fRange = fRange;
+    pPrepared->cBindings = cBindings;
+
+    pPrepared->rgBinding = static_cast<DBBINDING *>(MemAlloc(sizeof(DBBINDING) * cBindings, TRUE));
+    ExitOnNull(pPrepared->rgBinding, hr, E_OUTOFMEMORY, "Failed to allocate prepared bindings");
+
+    // Same layout as SetColumnValue() but each value gets a slot that fits similar values
+    for (DWORD i = 0; i < cBindings; ++i)
+    {
+        DBBINDING *pBinding = pPrepared->rgBinding + i;
+
+        *pBinding = rgBinding[i];
+        pBinding->cbMaxLen = PreparedValueSize(rgBinding[i].cbMaxLen);
+        pBinding->obLength = cbOffset;
+        cbOffset += sizeof(DBBYTEOFFSET);
+        pBinding->obValue = cbOffset;
+        cbOffset += pBinding->cbMaxLen;
+        pBinding->obStatus = cbOffset;
+        cbOffset += sizeof(DBSTATUS);
+    }
+
+    pPrepared->pbData = static_cast<BYTE *>(MemAlloc(cbOffset, TRUE));
+    ExitOnNull(pPrepared->pbData, hr, E_OUTOFMEMORY, "Failed to allocate prepared data buffer");
+
+    if (pIndexSchema)
+    {
+        hr = OpenIndexRowset(pDatabaseInternal, pTableSchema, pIndexSchema, &pPrepared->pIRowsetIndex, &pPrepared->pIRowset);
+        ExitOnFailure(hr, "Failed to open index rowset for prepared query");
+    }
+    else
+    {
+        pPrepared->pIRowset = pTableSchema->pIRowset;
+        pPrepared->pIRowset->AddRef();
+    }
+
+    hr = pPrepared->pIRowset->QueryInterface(IID_IAccessor, reinterpret_cast<void **>(&pPrepared->pIAccessor));
+    ExitOnFailure(hr, "Failed to get IAccessor interface");
+
+    hr = pPrepared->pIAccessor->CreateAccessor(DBACCESSOR_ROWDATA, cBindings, pPrepared->rgBinding, 0, &pPrepared->hAccessor, NULL);
+    ExitOnFailure(hr, "Failed to create prepared accessor");
+
+    *ppPrepared = pPrepared;
+    pPrepared = NULL;
+
+LExit:
+    ReleasePrepared(pPrepared);
+
+    return hr;
+}
+
+static BOOL PreparedMatches(
+    __in const SCE_PREPARED *pPrepared,
+    __in const SCE_TABLE_SCHEMA *pTableSchema,
+    __in_opt const SCE_INDEX_SCHEMA *pIndexSchema,
+    __in BOOL fRange,
+    __in_ecount(cBindings) const DBBINDING *rgBinding,
+    __in DWORD cBindings
+    )
+{
+    if (pPrepared->pTableSchema != pTableSchema || pPrepared->pIndexSchema != pIndexSchema || pPrepared->fRange != fRange || pPrepared->cBindings != cBindings)
+    {
+        return FALSE;
+    }
+
+    // The table may have been closed and reopened since the accessor was created
+    if (!pIndexSchema && pPrepared->pIRowset != pTableSchema->pIRowset)
+    {
+        return FALSE;
+    }
+
+    for (DWORD i = 0; i < cBindings; ++i)
+    {
+        const DBBINDING *pPreparedBinding = pPrepared->rgBinding + i;
+
+        if (pPreparedBinding->iOrdinal != rgBinding[i].iOrdinal || pPreparedBinding->wType != rgBinding[i].wType || pPreparedBinding->cbMaxLen != PreparedValueSize(rgBinding[i].cbMaxLen))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static DBBYTEOFFSET PreparedValueSize(
+    __in DBBYTEOFFSET cbValue
+    )
+{
+    DBBYTEOFFSET cbSlot = SCE_PREPARED_MIN_VALUE_SIZE;
+
+    while (cbSlot < cbValue)
+    {
+        cbSlot <<= 1;
+    }
+
+    return cbSlot;
+}
+
+static void ReleasePreparedReference(
+    __in_opt SCE_PREPARED *pPrepared
+    )
+{
+    if (pPrepared && 0 == ::InterlockedDecrement(&pPrepared->cReferences) && pPrepared->fOrphaned)
+    {
+        ReleasePrepared(pPrepared);
+    }
+}
+
+static void ReleasePrepared(
+    __in_opt SCE_PREPARED *pPrepared
+    )
+{
+    if (pPrepared)
+    {
+        if (DB_NULL_HACCESSOR != pPrepared->hAccessor)
+        {
+            pPrepared->pIAccessor->ReleaseAccessor(pPrepared->hAccessor, NULL);
+        }
+        ReleaseObject(pPrepared->pIAccessor);
+        ReleaseObject(pPrepared->pIRowset);
+        ReleaseObject(pPrepared->pIRowsetIndex);
+        ReleaseMem(pPrepared->rgBinding);
+        ReleaseMem(pPrepared->pbData);
+        ReleaseMem(pPrepared);
+    }
+}
+
+static void ReleasePreparedCache(
+    __in SCE_DATABASE_INTERNAL *pDatabaseInternal
+    )
+{
+    for (DWORD i = 0; i < pDatabaseInternal->cPrepared; ++i)
+    {
+        SCE_PREPARED *pPrepared = pDatabaseInternal->rgpPrepared[i];
+
+        // Results and rows still using a prepared query free it when they are done with it
+        if (0 < pPrepared->cReferences)
+        {
+            pPrepared->fOrphaned = TRUE;
+        }
+        else
+        {
+            ReleasePrepared(pPrepared);
+        }
+
+        pDatabaseInternal->rgpPrepared[i] = NULL;
+    }
+
+    pDatabaseInternal->cPrepared = 0;
+}
+
+static void ReleaseQuery(
+    __in SCE_QUERY *pQuery
+    )
+{
+    ReleaseMem(pQuery->rgBinding);
+    ReleaseMem(pQuery->pbData);
+    ReleaseMem(pQuery);
+}
+
 static HRESULT FillOutColumnDescFromSchema(
     __in const SCE_COLUMN_SCHEMA *pColumnSchema,
     __out DBCOLUMNDESC *pColumnDesc
@@ -1988,7 +2533,7 @@ static HRESULT SetColumnValue(
         *ppbBuffer = reinterpret_cast<BYTE *>(MemAlloc(cbNewOffset, TRUE));
         ExitOnNull(*ppbBuffer, hr, E_OUTOFMEMORY, "Failed to allocate buffer while setting row string");
     }
-    else
+    else if (MemSize(*ppbBuffer) < cbNewOffset) // reused queries and batch rows keep their buffer
     {
         *ppbBuffer = reinterpret_cast<BYTE *>(MemReAlloc(*ppbBuffer, cbNewOffset, TRUE));
         ExitOnNull(*ppbBuffer, hr, E_OUTOFMEMORY, "Failed to reallocate buffer while setting row string");
@@ -1998,10 +2543,7 @@ static HRESULT SetColumnValue(
     *pcbOffset += sizeof(DBBYTEOFFSET);
     memcpy(*ppbBuffer + *pcbOffset, pbData, cbSize);
     *pcbOffset += cbSize;
-    if (NULL == pbData)
-    {
-        *(reinterpret_cast<DBSTATUS *>(*ppbBuffer + *pcbOffset)) = DBSTATUS_S_ISNULL;
-    }
+    *(reinterpret_cast<DBSTATUS *>(*ppbBuffer + *pcbOffset)) = (NULL == pbData) ? DBSTATUS_S_ISNULL : DBSTATUS_S_OK;
     *pcbOffset += sizeof(DBSTATUS);
 
 LExit:
@@ -2446,6 +2988,12 @@ static void ReleaseDatabaseInternal(
 
     if (NULL != pDatabaseInternal)
     {
+        ReleasePreparedCache(pDatabaseInternal);
+        if (NULL != pDatabaseInternal->pSpareQuery)
+        {
+            ReleaseQuery(pDatabaseInternal->pSpareQuery);
+        }
+
         ReleaseObject(pDatabaseInternal->pITransactionLocal);
         ReleaseObject(pDatabaseInternal->pIOpenRowset);
         ReleaseObject(pDatabaseInternal->pISessionProperties);
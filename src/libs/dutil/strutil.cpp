@@ -330,6 +330,89 @@ extern "C" HRESULT DAPI StrAllocString(
     return AllocStringHelper(ppwz, wzSource, cchSource, FALSE);
 }
 
+/********************************************************************
+StrAllocArena - allocates a new string in an arena, or reuses dynamic
+string memory like StrAlloc when ppwz already points to a string or
+there is no arena
+
+NOTE: free the string with StrFree as usual, it is a no-op when the string is in the arena
+********************************************************************/
+extern "C" HRESULT DAPI StrAllocArena(
+    __in_opt MEM_ARENA_HANDLE hArena,
+    __deref_out_ecount_part(cch, 0) LPWSTR* ppwz,
+    __in DWORD_PTR cch
+    )
+{
+    Assert(ppwz && cch);
+
+    HRESULT hr = S_OK;
+
+    if (*ppwz || !hArena)
+    {
+        ExitFunction1(hr = AllocHelper(ppwz, cch, FALSE));
+    }
+
+    if (cch >= MAXDWORD / sizeof(WCHAR))
+    {
+        hr = E_OUTOFMEMORY;
+        ExitOnFailure(hr, "Not enough memory to allocate string of size: %u", cch);
+    }
+
+    *ppwz = static_cast<LPWSTR>(MemArenaAlloc(hArena, sizeof(WCHAR) * cch, TRUE));
+    if (!*ppwz)
+    {
+        // The arena has no room for it, StrFree() works on heap strings too.
+        hr = AllocHelper(ppwz, cch, FALSE);
+        ExitOnFailure(hr, "failed to allocate string, len: %u", cch);
+    }
+
+LExit:
+    return hr;
+}
+
+/********************************************************************
+StrAllocStringArena - copies a string into an arena, or reuses dynamic
+string memory like StrAllocString when ppwz already points to a string
+or there is no arena
+
+NOTE: free the string with StrFree as usual, it is a no-op when the string is in the arena
+NOTE: if cchSource == 0, length of wzSource is used instead
+********************************************************************/
+extern "C" HRESULT DAPI StrAllocStringArena(
+    __in_opt MEM_ARENA_HANDLE hArena,
+    __deref_out_ecount_z(cchSource+1) LPWSTR* ppwz,
+    __in_z LPCWSTR wzSource,
+    __in DWORD_PTR cchSource
+    )
+{
+    Assert(ppwz && wzSource);
+
+    HRESULT hr = S_OK;
+    DWORD_PTR cchNeeded = 0;
+
+    if (*ppwz || !hArena)
+    {
+        ExitFunction1(hr = AllocStringHelper(ppwz, wzSource, cchSource, FALSE));
+    }
+
+    if (0 == cchSource)
+    {
+        cchSource = lstrlenW(wzSource);
+    }
+
+    hr = ::ULongPtrAdd(cchSource, 1, &cchNeeded); // add one for the null terminator
+    ExitOnFailure(hr, "source string is too long");
+
+    // Exactly the size of the string since arena strings are not expected to grow.
+    hr = StrAllocArena(hArena, ppwz, cchNeeded);
+    ExitOnFailure(hr, "Failed to allocate arena string.");
+
+    hr = ::StringCchCopyNExW(*ppwz, cchNeeded, wzSource, cchSource, NULL, NULL, STRSAFE_FILL_BEHIND_NULL);
+
+LExit:
+    return hr;
+}
+
 /********************************************************************
 StrAllocStringSecure - allocates or reuses dynamic string memory and 
 copies in an existing string. If the memory needs to reallocated, 
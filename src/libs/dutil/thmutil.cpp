@@ -51,6 +51,69 @@ struct MEMBUFFER_FOR_RICHEDIT
     DWORD iData;
 };
 
+// A precompiled theme is the parsed theme written with a BUFF_WRITER: fixed size records
+// for the numbers followed by the strings they own. Handles are never saved, they are
+// recreated or decoded from their sources when the theme is loaded.
+const DWORD THEME_BINARY_MAGIC = 0x4D485457; // "WTHM"
+const DWORD THEME_BINARY_VERSION = 1;
+
+struct THEME_RECORD
+{
+    BOOL fAutoResize;
+    DWORD dwStyle;
+    DWORD dwFontId;
+    int nHeight;
+    int nMinimumHeight;
+    int nWidth;
+    int nMinimumWidth;
+    int nSourceX;
+    int nSourceY;
+    UINT uStringId;
+    DWORD cFonts;
+    DWORD cPages;
+    DWORD cImageLists;
+    DWORD cControls;
+};
+
+struct THEME_FONT_RECORD
+{
+    LOGFONTW lf;
+    COLORREF crForeground;
+    DWORD dwSystemForeground;
+    COLORREF crBackground;
+    DWORD dwSystemBackground;
+};
+
+struct THEME_CONTROL_RECORD
+{
+    DWORD type;
+    DWORD wPageId;
+    int nX;
+    int nY;
+    int nHeight;
+    int nWidth;
+    int nSourceX;
+    int nSourceY;
+    UINT uStringId;
+    BOOL fDisableVariableFunctionality;
+    DWORD rgdwImageList[4]; // index + 1 into THEME::rgImageLists, or 0
+    DWORD dwStyle;
+    DWORD dwExtendedStyle;
+    DWORD dwInternalStyle;
+    DWORD dwFontId;
+    DWORD dwFontHoverId;
+    DWORD dwFontSelectedId;
+    DWORD wBillboardInterval;
+    BOOL fBillboardLoops;
+    BOOL fLastRadioButton;
+    DWORD cControls;
+    DWORD cActions;
+    DWORD cColumns;
+    DWORD cTabs;
+    DWORD cConditionalText;
+    DWORD cConditionalNotes;
+};
+
 
 // prototypes
 static HRESULT RegisterWindowClasses(
@@ -62,21 +125,51 @@ static HRESULT ParseTheme(
     __in IXMLDOMDocument* pixd,
     __out THEME** ppTheme
     );
-static HRESULT ParseImage(
+static HRESULT AllocateTheme(
     __in_opt HMODULE hModule,
     __in_z_opt LPCWSTR wzRelativePath,
+    __out THEME** ppTheme
+    );
+static HRESULT ParseImageSource(
+    __in THEME* pTheme,
     __in IXMLDOMNode* pElement,
+    __in_z LPCWSTR wzResourceAttribute,
+    __in_z LPCWSTR wzFileAttribute,
+    __inout THEME_IMAGE_SOURCE* pSource
+    );
+static HRESULT GetImageSourceFile(
+    __in const THEME* pTheme,
+    __in_z LPCWSTR wzFile,
+    __deref_out_z LPWSTR* psczPath
+    );
+static HRESULT LoadImageSource(
+    __in const THEME* pTheme,
+    __in const THEME_IMAGE_SOURCE* pSource,
     __out HBITMAP* phImage
     );
-static HRESULT ParseIcon(
-    __in_opt HMODULE hModule,
-    __in_z_opt LPCWSTR wzRelativePath,
-    __in IXMLDOMNode* pElement,
+static HRESULT LoadIconSource(
+    __in const THEME* pTheme,
+    __in const THEME_IMAGE_SOURCE* pSource,
     __out HICON* phIcon
     );
+static HRESULT LoadWindowIcon(
+    __in THEME* pTheme
+    );
+static HRESULT LoadControlImage(
+    __in THEME* pTheme,
+    __in THEME_CONTROL* pControl
+    );
+static HRESULT LoadImageList(
+    __in const THEME* pTheme,
+    __in THEME_IMAGELIST* pImageList
+    );
+static BOOL ControlHasImage(
+    __in const THEME_CONTROL* pControl
+    );
+static HRESULT CreateFontHandles(
+    __in THEME_FONT* pFont
+    );
 static HRESULT ParseWindow(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMElement* pElement,
     __in THEME* pTheme
     );
@@ -91,28 +184,20 @@ static HRESULT ParseFonts(
     __in THEME* pTheme
     );
 static HRESULT ParsePages(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pElement,
     __in THEME* pTheme
     );
 static HRESULT ParseImageLists(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pElement,
     __in THEME* pTheme
     );
 static HRESULT ParseControls(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pElement,
     __in THEME* pTheme,
     __in_opt THEME_CONTROL* pParentControl,
     __in_opt THEME_PAGE* pPage
     );
 static HRESULT ParseControl(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pixn,
     __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
@@ -121,15 +206,15 @@ static HRESULT ParseControl(
     );
 static HRESULT ParseActions(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl
     );
 static HRESULT ParseColumns(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl
     );
 static HRESULT ParseRadioButtons(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pixn,
     __in THEME* pTheme,
     __in_opt THEME_CONTROL* pParentControl,
@@ -137,23 +222,78 @@ static HRESULT ParseRadioButtons(
     );
 static HRESULT ParseTabs(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl
     );
 static HRESULT ParseText(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
     __inout BOOL* pfAnyChildren
 );
 static HRESULT ParseTooltips(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
     __inout BOOL* pfAnyChildren
     );
 static HRESULT ParseNotes(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
     __out BOOL* pfAnyChildren
     );
+static HRESULT GetAttributeString(
+    __in_opt MEM_ARENA_HANDLE hArena,
+    __in IXMLDOMNode* pixn,
+    __in_z LPCWSTR wzAttribute,
+    __deref_out_z LPWSTR* psczValue
+    );
+static BOOL IsThemeBuffer(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer
+    );
+static HRESULT WriteRecord(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cbRecord) const void* pvRecord,
+    __in SIZE_T cbRecord
+    );
+static HRESULT ReadRecord(
+    __in BUFF_READER* pReader,
+    __out_bcount(cbRecord) void* pvRecord,
+    __in SIZE_T cbRecord
+    );
+static HRESULT WriteThemeString(
+    __in BUFF_WRITER* pWriter,
+    __in_z_opt LPCWSTR wz
+    );
+static HRESULT ReadThemeString(
+    __in BUFF_READER* pReader,
+    __in THEME* pTheme,
+    __deref_out_z_opt LPWSTR* psczValue
+    );
+static HRESULT WriteImageSource(
+    __in BUFF_WRITER* pWriter,
+    __in const THEME_IMAGE_SOURCE* pSource
+    );
+static HRESULT ReadImageSource(
+    __in BUFF_READER* pReader,
+    __in THEME* pTheme,
+    __out THEME_IMAGE_SOURCE* pSource
+    );
+static HRESULT WriteControls(
+    __in BUFF_WRITER* pWriter,
+    __in const THEME* pTheme,
+    __in DWORD cControls,
+    __in_ecount(cControls) const THEME_CONTROL* rgControls
+    );
+static HRESULT ReadControls(
+    __in BUFF_READER* pReader,
+    __in THEME* pTheme,
+    __in DWORD cControls,
+    __out DWORD* pcControls,
+    __deref_out_ecount(cControls) THEME_CONTROL** prgControls
+    );
 static HRESULT StopBillboard(
     __in THEME* pTheme,
     __in DWORD dwControl
@@ -165,7 +305,7 @@ static HRESULT StartBillboard(
 static HRESULT FindImageList(
     __in THEME* pTheme,
     __in_z LPCWSTR wzImageListName,
-    __out HIMAGELIST *phImageList
+    __out THEME_IMAGELIST** ppImageList
     );
 static HRESULT LoadControls(
     __in THEME* pTheme,
@@ -422,17 +562,37 @@ DAPI_(HRESULT) ThemeLoadFromFile(
     HRESULT hr = S_OK;
     IXMLDOMDocument* pixd = NULL;
     LPWSTR sczRelativePath = NULL;
-
-    hr = XmlLoadDocumentFromFile(wzThemeFile, &pixd);
-    ExitOnFailure(hr, "Failed to load theme resource as XML document.");
+    BYTE* pbTheme = NULL;
+    DWORD cbTheme = 0;
 
     hr = PathGetDirectory(wzThemeFile, &sczRelativePath);
     ExitOnFailure(hr, "Failed to get relative path from theme file.");
 
-    hr = ParseTheme(NULL, sczRelativePath, pixd, ppTheme);
-    ExitOnFailure(hr, "Failed to parse theme.");
+    // Peek at the start of the file to see if it holds a precompiled theme.
+    hr = FileReadPartial(&pbTheme, &cbTheme, wzThemeFile, FALSE, 0, sizeof(THEME_BINARY_MAGIC), TRUE);
+    ExitOnFailure(hr, "Failed to read theme file: %ls", wzThemeFile);
+
+    if (IsThemeBuffer(pbTheme, cbTheme))
+    {
+        ReleaseNullMem(pbTheme);
+
+        hr = FileRead(&pbTheme, &cbTheme, wzThemeFile);
+        ExitOnFailure(hr, "Failed to read precompiled theme file: %ls", wzThemeFile);
+
+        hr = ThemeLoadFromBuffer(pbTheme, cbTheme, NULL, sczRelativePath, ppTheme);
+        ExitOnFailure(hr, "Failed to load precompiled theme.");
+    }
+    else
+    {
+        hr = XmlLoadDocumentFromFile(wzThemeFile, &pixd);
+        ExitOnFailure(hr, "Failed to load theme resource as XML document.");
+
+        hr = ParseTheme(NULL, sczRelativePath, pixd, ppTheme);
+        ExitOnFailure(hr, "Failed to parse theme.");
+    }
 
 LExit:
+    ReleaseMem(pbTheme);
     ReleaseStr(sczRelativePath);
     ReleaseObject(pixd);
 
@@ -455,6 +615,14 @@ DAPI_(HRESULT) ThemeLoadFromResource(
     hr = ResReadData(hModule, szResource, &pvResource, &cbResource);
     ExitOnFailure(hr, "Failed to read theme from resource.");
 
+    if (IsThemeBuffer(static_cast<const BYTE*>(pvResource), cbResource))
+    {
+        hr = ThemeLoadFromBuffer(static_cast<const BYTE*>(pvResource), cbResource, hModule, NULL, ppTheme);
+        ExitOnFailure(hr, "Failed to load precompiled theme from resource.");
+
+        ExitFunction();
+    }
+
     hr = StrAllocStringAnsi(&sczXml, reinterpret_cast<LPCSTR>(pvResource), cbResource, CP_UTF8);
     ExitOnFailure(hr, "Failed to convert XML document data from UTF-8 to unicode string.");
 
@@ -472,6 +640,274 @@ LExit:
 }
 
 
+DAPI_(HRESULT) ThemeLoadFromBuffer(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in_opt HMODULE hModule,
+    __in_z_opt LPCWSTR wzRelativePath,
+    __out THEME** ppTheme
+    )
+{
+    HRESULT hr = S_OK;
+    BUFF_READER reader = { };
+    DWORD dwMagic = 0;
+    DWORD dwVersion = 0;
+    THEME_RECORD record = { };
+    THEME_FONT_RECORD fontRecord = { };
+    THEME* pTheme = NULL;
+
+    BuffReaderInitialize(&reader, pbBuffer, cbBuffer, 0);
+
+    hr = BuffReaderReadNumber(&reader, &dwMagic);
+    ExitOnFailure(hr, "Failed to read precompiled theme magic.");
+
+    hr = BuffReaderReadNumber(&reader, &dwVersion);
+    ExitOnFailure(hr, "Failed to read precompiled theme version.");
+
+    if (THEME_BINARY_MAGIC != dwMagic || THEME_BINARY_VERSION != dwVersion)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        ExitOnRootFailure(hr, "Unsupported precompiled theme, magic: 0x%x, version: %u", dwMagic, dwVersion);
+    }
+
+    hr = AllocateTheme(hModule, wzRelativePath, &pTheme);
+    ExitOnFailure(hr, "Failed to allocate theme.");
+
+    hr = ReadRecord(&reader, &record, sizeof(record));
+    ExitOnFailure(hr, "Failed to read theme.");
+
+    pTheme->fAutoResize = record.fAutoResize;
+    pTheme->dwStyle = record.dwStyle;
+    pTheme->dwFontId = record.dwFontId;
+    pTheme->nHeight = record.nHeight;
+    pTheme->nMinimumHeight = record.nMinimumHeight;
+    pTheme->nWidth = record.nWidth;
+    pTheme->nMinimumWidth = record.nMinimumWidth;
+    pTheme->nSourceX = record.nSourceX;
+    pTheme->nSourceY = record.nSourceY;
+    pTheme->uStringId = record.uStringId;
+
+    hr = ReadThemeString(&reader, pTheme, &pTheme->sczCaption);
+    ExitOnFailure(hr, "Failed to read theme caption.");
+
+    hr = ReadImageSource(&reader, pTheme, &pTheme->iconSource);
+    ExitOnFailure(hr, "Failed to read theme icon.");
+
+    hr = ReadImageSource(&reader, pTheme, &pTheme->imageSource);
+    ExitOnFailure(hr, "Failed to read theme image.");
+
+    if (record.cFonts)
+    {
+        hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pTheme->rgFonts), sizeof(THEME_FONT), record.cFonts);
+        ExitOnFailure(hr, "Failed to allocate theme fonts.");
+
+        pTheme->cFonts = record.cFonts;
+
+        for (DWORD i = 0; i < pTheme->cFonts; ++i)
+        {
+            THEME_FONT* pFont = pTheme->rgFonts + i;
+
+            hr = ReadRecord(&reader, &fontRecord, sizeof(fontRecord));
+            ExitOnFailure(hr, "Failed to read font %u.", i);
+
+            pFont->lf = fontRecord.lf;
+            pFont->dwSystemForeground = fontRecord.dwSystemForeground;
+            pFont->crForeground = fontRecord.dwSystemForeground ? ::GetSysColor(fontRecord.dwSystemForeground) : fontRecord.crForeground;
+            pFont->dwSystemBackground = fontRecord.dwSystemBackground;
+            pFont->crBackground = fontRecord.dwSystemBackground ? ::GetSysColor(fontRecord.dwSystemBackground) : fontRecord.crBackground;
+
+            hr = CreateFontHandles(pFont);
+            ExitOnFailure(hr, "Failed to create font %u.", i);
+        }
+    }
+
+    if (record.cPages)
+    {
+        hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pTheme->rgPages), sizeof(THEME_PAGE), record.cPages);
+        ExitOnFailure(hr, "Failed to allocate theme pages.");
+
+        pTheme->cPages = record.cPages;
+
+        for (DWORD i = 0; i < pTheme->cPages; ++i)
+        {
+            THEME_PAGE* pPage = pTheme->rgPages + i;
+
+            pPage->wId = static_cast<WORD>(i + 1);
+
+            hr = ReadThemeString(&reader, pTheme, &pPage->sczName);
+            ExitOnFailure(hr, "Failed to read page name.");
+
+            hr = BuffReaderReadNumber(&reader, &pPage->cControlIndices);
+            ExitOnFailure(hr, "Failed to read page control count.");
+        }
+    }
+
+    if (record.cImageLists)
+    {
+        hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pTheme->rgImageLists), sizeof(THEME_IMAGELIST), record.cImageLists);
+        ExitOnFailure(hr, "Failed to allocate theme image lists.");
+
+        pTheme->cImageLists = record.cImageLists;
+
+        for (DWORD i = 0; i < pTheme->cImageLists; ++i)
+        {
+            THEME_IMAGELIST* pImageList = pTheme->rgImageLists + i;
+            DWORD cImages = 0;
+
+            hr = ReadThemeString(&reader, pTheme, &pImageList->sczName);
+            ExitOnFailure(hr, "Failed to read image list name.");
+
+            hr = BuffReaderReadNumber(&reader, &cImages);
+            ExitOnFailure(hr, "Failed to read image list count.");
+
+            if (cImages)
+            {
+                hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pImageList->rgImages), sizeof(THEME_IMAGE_SOURCE), cImages);
+                ExitOnFailure(hr, "Failed to allocate image list sources.");
+
+                pImageList->cImages = cImages;
+
+                for (DWORD j = 0; j < cImages; ++j)
+                {
+                    hr = ReadImageSource(&reader, pTheme, pImageList->rgImages + j);
+                    ExitOnFailure(hr, "Failed to read image %u of image list: %ls", j, pImageList->sczName);
+                }
+            }
+        }
+    }
+
+    if (record.cControls)
+    {
+        hr = ReadControls(&reader, pTheme, record.cControls, &pTheme->cControls, &pTheme->rgControls);
+        ExitOnFailure(hr, "Failed to read theme controls.");
+    }
+
+    if (reader.iData != reader.cbData)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        ExitOnRootFailure(hr, "Unexpected data at the end of the precompiled theme.");
+    }
+
+    // Same as parsing the XML: only the window icon and background are needed up front.
+    hr = LoadWindowIcon(pTheme);
+    ExitOnFailure(hr, "Failed to load window icon.");
+
+    hr = LoadImageSource(pTheme, &pTheme->imageSource, &pTheme->hImage);
+    ExitOnFailure(hr, "Failed to load theme image.");
+
+    *ppTheme = pTheme;
+    pTheme = NULL;
+
+LExit:
+    if (pTheme)
+    {
+        ThemeFree(pTheme);
+    }
+
+    return hr;
+}
+
+
+DAPI_(HRESULT) ThemeSaveToBuffer(
+    __in const THEME* pTheme,
+    __deref_out_bcount(*pcbBuffer) BYTE** ppbBuffer,
+    __out SIZE_T* pcbBuffer
+    )
+{
+    HRESULT hr = S_OK;
+    BUFF_WRITER writer = { };
+    THEME_RECORD record = { };
+    THEME_FONT_RECORD fontRecord = { };
+
+    AssertSz(!pTheme->hwndParent, "Save the theme before its controls are loaded.");
+
+    hr = BuffWriterWriteNumber(&writer, THEME_BINARY_MAGIC);
+    ExitOnFailure(hr, "Failed to write precompiled theme magic.");
+
+    hr = BuffWriterWriteNumber(&writer, THEME_BINARY_VERSION);
+    ExitOnFailure(hr, "Failed to write precompiled theme version.");
+
+    record.fAutoResize = pTheme->fAutoResize;
+    record.dwStyle = pTheme->dwStyle;
+    record.dwFontId = pTheme->dwFontId;
+    record.nHeight = pTheme->nHeight;
+    record.nMinimumHeight = pTheme->nMinimumHeight;
+    record.nWidth = pTheme->nWidth;
+    record.nMinimumWidth = pTheme->nMinimumWidth;
+    record.nSourceX = pTheme->nSourceX;
+    record.nSourceY = pTheme->nSourceY;
+    record.uStringId = pTheme->uStringId;
+    record.cFonts = pTheme->cFonts;
+    record.cPages = pTheme->cPages;
+    record.cImageLists = pTheme->cImageLists;
+    record.cControls = pTheme->cControls;
+
+    hr = WriteRecord(&writer, &record, sizeof(record));
+    ExitOnFailure(hr, "Failed to write theme.");
+
+    hr = WriteThemeString(&writer, pTheme->sczCaption);
+    ExitOnFailure(hr, "Failed to write theme caption.");
+
+    hr = WriteImageSource(&writer, &pTheme->iconSource);
+    ExitOnFailure(hr, "Failed to write theme icon.");
+
+    hr = WriteImageSource(&writer, &pTheme->imageSource);
+    ExitOnFailure(hr, "Failed to write theme image.");
+
+    for (DWORD i = 0; i < pTheme->cFonts; ++i)
+    {
+        const THEME_FONT* pFont = pTheme->rgFonts + i;
+
+        fontRecord.lf = pFont->lf;
+        fontRecord.crForeground = pFont->crForeground;
+        fontRecord.dwSystemForeground = pFont->dwSystemForeground;
+        fontRecord.crBackground = pFont->crBackground;
+        fontRecord.dwSystemBackground = pFont->dwSystemBackground;
+
+        hr = WriteRecord(&writer, &fontRecord, sizeof(fontRecord));
+        ExitOnFailure(hr, "Failed to write font %u.", i);
+    }
+
+    for (DWORD i = 0; i < pTheme->cPages; ++i)
+    {
+        const THEME_PAGE* pPage = pTheme->rgPages + i;
+
+        hr = WriteThemeString(&writer, pPage->sczName);
+        ExitOnFailure(hr, "Failed to write page name.");
+
+        hr = BuffWriterWriteNumber(&writer, pPage->cControlIndices);
+        ExitOnFailure(hr, "Failed to write page control count.");
+    }
+
+    for (DWORD i = 0; i < pTheme->cImageLists; ++i)
+    {
+        const THEME_IMAGELIST* pImageList = pTheme->rgImageLists + i;
+
+        hr = WriteThemeString(&writer, pImageList->sczName);
+        ExitOnFailure(hr, "Failed to write image list name.");
+
+        hr = BuffWriterWriteNumber(&writer, pImageList->cImages);
+        ExitOnFailure(hr, "Failed to write image list count.");
+
+        for (DWORD j = 0; j < pImageList->cImages; ++j)
+        {
+            hr = WriteImageSource(&writer, pImageList->rgImages + j);
+            ExitOnFailure(hr, "Failed to write image %u of image list: %ls", j, pImageList->sczName);
+        }
+    }
+
+    hr = WriteControls(&writer, pTheme, pTheme->cControls, pTheme->rgControls);
+    ExitOnFailure(hr, "Failed to write theme controls.");
+
+    BuffWriterDetach(&writer, ppbBuffer, pcbBuffer);
+
+LExit:
+    BuffWriterUninitialize(&writer);
+
+    return hr;
+}
+
+
 DAPI_(void) ThemeFree(
     __in THEME* pTheme
     )
@@ -499,6 +935,7 @@ DAPI_(void) ThemeFree(
         }
 
         ReleaseMem(pTheme->rgControls);
+        ReleaseMem(pTheme->rgImageLists);
         ReleaseMem(pTheme->rgPages);
         ReleaseMem(pTheme->rgFonts);
 
@@ -508,6 +945,9 @@ DAPI_(void) ThemeFree(
         }
 
         ReleaseStr(pTheme->sczCaption);
+
+        // Last, since the strings released above may live in it.
+        ReleaseMemArena(pTheme->hArena);
         ReleaseMem(pTheme);
     }
 }
@@ -1173,13 +1613,17 @@ DAPI_(HRESULT) ThemeDrawControl(
     )
 {
     HRESULT hr = S_OK;
-    const THEME_CONTROL* pControl = FindControlFromHWnd(pTheme, pdis->hwndItem);
+    THEME_CONTROL* pControl = const_cast<THEME_CONTROL*>(FindControlFromHWnd(pTheme, pdis->hwndItem));
 
     AssertSz(pControl, "Expected control window from owner draw window.");
     AssertSz(pControl->hWnd == pdis->hwndItem, "Expected control window to match owner draw window.");
     AssertSz(pControl->nWidth < 1 || pControl->nWidth == pdis->rcItem.right - pdis->rcItem.left, "Expected control window width to match owner draw window width.");
     AssertSz(pControl->nHeight < 1 || pControl->nHeight == pdis->rcItem.bottom - pdis->rcItem.top, "Expected control window height to match owner draw window height.");
 
+    // Controls on pages that are never shown are never drawn, so their images are never decoded.
+    hr = LoadControlImage(pTheme, pControl);
+    ExitOnFailure(hr, "Failed to load control image.");
+
     switch (pControl->type)
     {
     case THEME_CONTROL_TYPE_BUTTON:
@@ -1570,8 +2014,6 @@ static HRESULT ParseTheme(
     __out THEME** ppTheme
     )
 {
-    static WORD wThemeId = 0;
-
     HRESULT hr = S_OK;
     THEME* pTheme = NULL;
     IXMLDOMElement *pThemeElement = NULL;
@@ -1579,13 +2021,11 @@ static HRESULT ParseTheme(
     hr = pixd->get_documentElement(&pThemeElement);
     ExitOnFailure(hr, "Failed to get theme element.");
 
-    pTheme = static_cast<THEME*>(MemAlloc(sizeof(THEME), TRUE));
-    ExitOnNull(pTheme, hr, E_OUTOFMEMORY, "Failed to allocate memory for theme.");
-
-    pTheme->wId = ++wThemeId;
+    hr = AllocateTheme(hModule, wzRelativePath, &pTheme);
+    ExitOnFailure(hr, "Failed to allocate theme.");
 
     // Parse the optional background resource image.
-    hr = ParseImage(hModule, wzRelativePath, pThemeElement, &pTheme->hImage);
+    hr = ParseImageSource(pTheme, pThemeElement, L"ImageResource", L"ImageFile", &pTheme->imageSource);
     ExitOnFailure(hr, "Failed while parsing theme image.");
 
     // Parse the fonts.
@@ -1593,9 +2033,13 @@ static HRESULT ParseTheme(
     ExitOnFailure(hr, "Failed to parse theme fonts.");
 
     // Parse the window element.
-    hr = ParseWindow(hModule, wzRelativePath, pThemeElement, pTheme);
+    hr = ParseWindow(pThemeElement, pTheme);
     ExitOnFailure(hr, "Failed to parse theme window element.");
 
+    // The background is needed for the first paint so it is the only image decoded up front.
+    hr = LoadImageSource(pTheme, &pTheme->imageSource, &pTheme->hImage);
+    ExitOnFailure(hr, "Failed to load theme image.");
+
     *ppTheme = pTheme;
     pTheme = NULL;
 
@@ -1610,65 +2054,134 @@ LExit:
     return hr;
 }
 
-static HRESULT ParseImage(
+static HRESULT AllocateTheme(
     __in_opt HMODULE hModule,
     __in_z_opt LPCWSTR wzRelativePath,
-    __in IXMLDOMNode* pElement,
-    __out HBITMAP* phImage
+    __out THEME** ppTheme
     )
 {
-    HRESULT hr = S_OK;
-    BSTR bstr = NULL;
-    LPWSTR sczImageFile = NULL;
-    int iResourceId = 0;
-    Gdiplus::Bitmap* pBitmap = NULL;
+    static WORD wThemeId = 0;
 
-    hr = XmlGetAttribute(pElement, L"ImageResource", &bstr);
-    ExitOnFailure(hr, "Failed to get image resource attribute.");
+    HRESULT hr = S_OK;
+    THEME* pTheme = NULL;
 
-    if (S_OK == hr)
-    {
-        iResourceId = wcstol(bstr, NULL, 10);
+    pTheme = static_cast<THEME*>(MemAlloc(sizeof(THEME), TRUE));
+    ExitOnNull(pTheme, hr, E_OUTOFMEMORY, "Failed to allocate memory for theme.");
 
-        hr = GdipBitmapFromResource(hModule, MAKEINTRESOURCE(iResourceId), &pBitmap);
-        // Don't fail.
-    }
+    pTheme->wId = ++wThemeId;
+    pTheme->hModule = hModule;
 
-    ReleaseNullBSTR(bstr);
+    // Strings parsed from the theme live exactly as long as the theme.
+    hr = MemArenaCreate(0, &pTheme->hArena);
+    ExitOnFailure(hr, "Failed to create theme arena.");
 
-    // Parse the optional background image from a given file.
-    if (!pBitmap)
+    if (wzRelativePath)
     {
-        hr = XmlGetAttribute(pElement, L"ImageFile", &bstr);
-        ExitOnFailure(hr, "Failed to get image file attribute.");
-
-        if (S_OK == hr)
-        {
-            if (wzRelativePath)
-            {
-                hr = PathConcat(wzRelativePath, bstr, &sczImageFile);
-                ExitOnFailure(hr, "Failed to combine image file path.");
-            }
-            else
-            {
-                hr = PathRelativeToModule(&sczImageFile, bstr, hModule);
-                ExitOnFailure(hr, "Failed to get image filename.");
-            }
-
-            hr = GdipBitmapFromFile(sczImageFile, &pBitmap);
-            // Don't fail.
-        }
+        hr = StrAllocStringArena(pTheme->hArena, &pTheme->sczRelativePath, wzRelativePath, 0);
+        ExitOnFailure(hr, "Failed to copy theme relative path.");
     }
 
-    // If there is an image, convert it into a bitmap handle.
-    if (pBitmap)
+    *ppTheme = pTheme;
+    pTheme = NULL;
+
+LExit:
+    if (pTheme)
     {
-        Gdiplus::Color black;
-        Gdiplus::Status gs = pBitmap->GetHBITMAP(black, phImage);
-        ExitOnGdipFailure(gs, hr, "Failed to convert GDI+ bitmap into HBITMAP.");
+        ThemeFree(pTheme);
     }
 
-    hr = S_OK;
+    return hr;
+}
+
+static HRESULT ParseImageSource(
+    __in THEME* pTheme,
+    __in IXMLDOMNode* pElement,
+    __in_z LPCWSTR wzResourceAttribute,
+    __in_z LPCWSTR wzFileAttribute,
+    __inout THEME_IMAGE_SOURCE* pSource
+    )
+{
+    HRESULT hr = S_OK;
+
+    hr = GetAttributeString(pTheme->hArena, pElement, wzResourceAttribute, &pSource->sczResource);
+    if (E_NOTFOUND == hr)
+    {
+        hr = S_OK;
+    }
+    ExitOnFailure(hr, "Failed to get %ls attribute.", wzResourceAttribute);
+
+    hr = GetAttributeString(pTheme->hArena, pElement, wzFileAttribute, &pSource->sczFile);
+    if (E_NOTFOUND == hr)
+    {
+        hr = S_OK;
+    }
+    ExitOnFailure(hr, "Failed to get %ls attribute.", wzFileAttribute);
+
+LExit:
+    return hr;
+}
+
+static HRESULT GetImageSourceFile(
+    __in const THEME* pTheme,
+    __in_z LPCWSTR wzFile,
+    __deref_out_z LPWSTR* psczPath
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (pTheme->sczRelativePath)
+    {
+        hr = PathConcat(pTheme->sczRelativePath, wzFile, psczPath);
+        ExitOnFailure(hr, "Failed to combine image file path.");
+    }
+    else
+    {
+        hr = PathRelativeToModule(psczPath, wzFile, pTheme->hModule);
+        ExitOnFailure(hr, "Failed to get image filename.");
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT LoadImageSource(
+    __in const THEME* pTheme,
+    __in const THEME_IMAGE_SOURCE* pSource,
+    __out HBITMAP* phImage
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR sczImageFile = NULL;
+    int iResourceId = 0;
+    Gdiplus::Bitmap* pBitmap = NULL;
+
+    if (pSource->sczResource)
+    {
+        iResourceId = wcstol(pSource->sczResource, NULL, 10);
+
+        hr = GdipBitmapFromResource(pTheme->hModule, MAKEINTRESOURCE(iResourceId), &pBitmap);
+        // Don't fail.
+    }
+
+    // Fall back to the image from a given file.
+    if (!pBitmap && pSource->sczFile)
+    {
+        hr = GetImageSourceFile(pTheme, pSource->sczFile, &sczImageFile);
+        ExitOnFailure(hr, "Failed to get image file path.");
+
+        hr = GdipBitmapFromFile(sczImageFile, &pBitmap);
+        // Don't fail.
+    }
+
+    // If there is an image, convert it into a bitmap handle.
+    if (pBitmap)
+    {
+        Gdiplus::Color black;
+        Gdiplus::Status gs = pBitmap->GetHBITMAP(black, phImage);
+        ExitOnGdipFailure(gs, hr, "Failed to convert GDI+ bitmap into HBITMAP.");
+    }
+
+    hr = S_OK;
 
 LExit:
     if (pBitmap)
@@ -1677,70 +2190,171 @@ LExit:
     }
 
     ReleaseStr(sczImageFile);
-    ReleaseBSTR(bstr);
 
     return hr;
 }
 
 
-static HRESULT ParseIcon(
-    __in_opt HMODULE hModule,
-    __in_z_opt LPCWSTR wzRelativePath,
-    __in IXMLDOMNode* pElement,
+static HRESULT LoadIconSource(
+    __in const THEME* pTheme,
+    __in const THEME_IMAGE_SOURCE* pSource,
     __out HICON* phIcon
     )
 {
     HRESULT hr = S_OK;
-    BSTR bstr = NULL;
     LPWSTR sczImageFile = NULL;
     int iResourceId = 0;
 
-    hr = XmlGetAttribute(pElement, L"IconResource", &bstr);
-    ExitOnFailure(hr, "Failed to get icon resource attribute.");
-
-    if (S_OK == hr)
+    if (pSource->sczResource)
     {
-        iResourceId = wcstol(bstr, NULL, 10);
+        iResourceId = wcstol(pSource->sczResource, NULL, 10);
 
-        *phIcon = reinterpret_cast<HICON>(::LoadImageW(hModule, MAKEINTRESOURCEW(iResourceId), IMAGE_ICON, 0, 0, LR_DEFAULTSIZE));
+        *phIcon = reinterpret_cast<HICON>(::LoadImageW(pTheme->hModule, MAKEINTRESOURCEW(iResourceId), IMAGE_ICON, 0, 0, LR_DEFAULTSIZE));
         ExitOnNullWithLastError(*phIcon, hr, "Failed to load icon.");
     }
-    else
+    else if (pSource->sczFile)
     {
-        ReleaseNullBSTR(bstr);
+        hr = GetImageSourceFile(pTheme, pSource->sczFile, &sczImageFile);
+        ExitOnFailure(hr, "Failed to get icon file path.");
 
-        hr = XmlGetAttribute(pElement, L"IconFile", &bstr);
-        ExitOnFailure(hr, "Failed to get icon file attribute.");
+        *phIcon = reinterpret_cast<HICON>(::LoadImageW(NULL, sczImageFile, IMAGE_ICON, 0, 0, LR_DEFAULTSIZE | LR_LOADFROMFILE));
+        ExitOnNullWithLastError(*phIcon, hr, "Failed to load icon: %ls.", sczImageFile);
+    }
 
-        if (S_OK == hr)
+LExit:
+    ReleaseStr(sczImageFile);
+
+    return hr;
+}
+
+
+static HRESULT LoadWindowIcon(
+    __in THEME* pTheme
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR sczIconFile = NULL;
+
+    // The window icon resource is a resource name rather than an id.
+    if (pTheme->iconSource.sczResource)
+    {
+        pTheme->hIcon = ::LoadIconW(pTheme->hModule, pTheme->iconSource.sczResource);
+        ExitOnNullWithLastError(pTheme->hIcon, hr, "Failed to load window icon from IconResource.");
+    }
+
+    if (pTheme->iconSource.sczFile)
+    {
+        hr = GetImageSourceFile(pTheme, pTheme->iconSource.sczFile, &sczIconFile);
+        ExitOnFailure(hr, "Failed to get icon filename.");
+
+        pTheme->hIcon = ::LoadImageW(NULL, sczIconFile, IMAGE_ICON, 0, 0, LR_DEFAULTSIZE | LR_LOADFROMFILE);
+        ExitOnNullWithLastError(pTheme->hIcon, hr, "Failed to load window icon from IconFile: %ls.", pTheme->iconSource.sczFile);
+    }
+
+    pTheme->iconSource.fLoaded = TRUE;
+
+LExit:
+    ReleaseStr(sczIconFile);
+
+    return hr;
+}
+
+
+static HRESULT LoadControlImage(
+    __in THEME* pTheme,
+    __in THEME_CONTROL* pControl
+    )
+{
+    HRESULT hr = S_OK;
+
+    // Only try once, a missing image falls back to the theme image for good.
+    if (!pControl->imageSource.fLoaded)
+    {
+        pControl->imageSource.fLoaded = TRUE;
+
+        hr = LoadImageSource(pTheme, &pControl->imageSource, &pControl->hImage);
+        ExitOnFailure(hr, "Failed to load control image.");
+    }
+
+    if (!pControl->iconSource.fLoaded)
+    {
+        pControl->iconSource.fLoaded = TRUE;
+
+        hr = LoadIconSource(pTheme, &pControl->iconSource, &pControl->hIcon);
+        ExitOnFailure(hr, "Failed to load control icon.");
+    }
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT LoadImageList(
+    __in const THEME* pTheme,
+    __in THEME_IMAGELIST* pImageList
+    )
+{
+    HRESULT hr = S_OK;
+    HBITMAP hBitmap = NULL;
+    BITMAP bm = { };
+    int iRetVal = 0;
+
+    if (pImageList->hImageList)
+    {
+        ExitFunction();
+    }
+
+    for (DWORD i = 0; i < pImageList->cImages; ++i)
+    {
+        if (hBitmap)
         {
-            if (wzRelativePath)
-            {
-                hr = PathConcat(wzRelativePath, bstr, &sczImageFile);
-                ExitOnFailure(hr, "Failed to combine image file path.");
-            }
-            else
-            {
-                hr = PathRelativeToModule(&sczImageFile, bstr, hModule);
-                ExitOnFailure(hr, "Failed to get image filename.");
-            }
+            ::DeleteObject(hBitmap);
+            hBitmap = NULL;
+        }
+
+        hr = LoadImageSource(pTheme, pImageList->rgImages + i, &hBitmap);
+        ExitOnFailure(hr, "Failed to load image: %u", i);
+
+        if (0 == i)
+        {
+            ::GetObjectW(hBitmap, sizeof(BITMAP), &bm);
+
+            pImageList->hImageList = ImageList_Create(bm.bmWidth, bm.bmHeight, ILC_COLOR24, pImageList->cImages, 0);
+            ExitOnNullWithLastError(pImageList->hImageList, hr, "Failed to create image list.");
+        }
 
-            *phIcon = reinterpret_cast<HICON>(::LoadImageW(NULL, sczImageFile, IMAGE_ICON, 0, 0, LR_DEFAULTSIZE | LR_LOADFROMFILE));
-            ExitOnNullWithLastError(*phIcon, hr, "Failed to load icon: %ls.", sczImageFile);
+        iRetVal = ImageList_Add(pImageList->hImageList, hBitmap, NULL);
+        if (-1 == iRetVal)
+        {
+            ExitWithLastError(hr, "Failed to add image %u to image list.", i);
         }
     }
 
 LExit:
-    ReleaseStr(sczImageFile);
-    ReleaseBSTR(bstr);
+    if (FAILED(hr) && pImageList->hImageList)
+    {
+        ImageList_Destroy(pImageList->hImageList);
+        pImageList->hImageList = NULL;
+    }
+
+    if (hBitmap)
+    {
+        ::DeleteObject(hBitmap);
+    }
 
     return hr;
 }
 
 
+static BOOL ControlHasImage(
+    __in const THEME_CONTROL* pControl
+    )
+{
+    return pControl->hImage || pControl->imageSource.sczResource || pControl->imageSource.sczFile;
+}
+
+
 static HRESULT ParseWindow(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMElement* pElement,
     __in THEME* pTheme
     )
@@ -1748,7 +2362,6 @@ static HRESULT ParseWindow(
     HRESULT hr = S_OK;
     IXMLDOMNode* pixn = NULL;
     BSTR bstr = NULL;
-    LPWSTR sczIconFile = NULL;
 
     hr = XmlSelectSingleNode(pElement, L"Window", &pixn);
     if (S_FALSE == hr)
@@ -1802,40 +2415,12 @@ static HRESULT ParseWindow(
     }
     ExitOnFailure(hr, "Failed to get window FontId attribute.");
 
-    // Get the optional window icon from a resource.
-    hr = XmlGetAttribute(pixn, L"IconResource", &bstr);
-    ExitOnFailure(hr, "Failed to get window IconResource attribute.");
-
-    if (S_OK == hr)
-    {
-        pTheme->hIcon = ::LoadIconW(hModule, bstr);
-        ExitOnNullWithLastError(pTheme->hIcon, hr, "Failed to load window icon from IconResource.");
-
-        ReleaseNullBSTR(bstr);
-    }
-
-    // Get the optional window icon from a file.
-    hr = XmlGetAttribute(pixn, L"IconFile", &bstr);
-    ExitOnFailure(hr, "Failed to get window IconFile attribute.");
-
-    if (S_OK == hr)
-    {
-        if (wzRelativePath)
-        {
-            hr = PathConcat(wzRelativePath, bstr, &sczIconFile);
-            ExitOnFailure(hr, "Failed to combine icon file path.");
-        }
-        else
-        {
-            hr = PathRelativeToModule(&sczIconFile, bstr, hModule);
-            ExitOnFailure(hr, "Failed to get icon filename.");
-        }
-
-        pTheme->hIcon = ::LoadImageW(NULL, sczIconFile, IMAGE_ICON, 0, 0, LR_DEFAULTSIZE | LR_LOADFROMFILE);
-        ExitOnNullWithLastError(pTheme->hIcon, hr, "Failed to load window icon from IconFile: %ls.", bstr);
+    // Get the optional window icon from a resource or a file.
+    hr = ParseImageSource(pTheme, pixn, L"IconResource", L"IconFile", &pTheme->iconSource);
+    ExitOnFailure(hr, "Failed to get window icon attributes.");
 
-        ReleaseNullBSTR(bstr);
-    }
+    hr = LoadWindowIcon(pTheme);
+    ExitOnFailure(hr, "Failed to load window icon.");
 
     hr = XmlGetAttributeNumber(pixn, L"SourceX", reinterpret_cast<DWORD*>(&pTheme->nSourceX));
     if (S_FALSE == hr)
@@ -1877,24 +2462,23 @@ static HRESULT ParseWindow(
             ExitOnRootFailure(hr, "Window elements must contain the Caption or StringId attribute.");
         }
 
-        hr = StrAllocString(&pTheme->sczCaption, bstr, 0);
+        hr = StrAllocStringArena(pTheme->hArena, &pTheme->sczCaption, bstr, 0);
         ExitOnFailure(hr, "Failed to copy window Caption attribute.");
     }
 
     // Parse any image lists.
-    hr = ParseImageLists(hModule, wzRelativePath, pixn, pTheme);
+    hr = ParseImageLists(pixn, pTheme);
     ExitOnFailure(hr, "Failed to parse image lists.");
 
     // Parse the pages.
-    hr = ParsePages(hModule, wzRelativePath, pixn, pTheme);
+    hr = ParsePages(pixn, pTheme);
     ExitOnFailure(hr, "Failed to parse theme pages.");
 
     // Parse the non-paged controls.
-    hr = ParseControls(hModule, wzRelativePath, pixn, pTheme, NULL, NULL);
+    hr = ParseControls(pixn, pTheme, NULL, NULL);
     ExitOnFailure(hr, "Failed to parse theme controls.");
 
 LExit:
-    ReleaseStr(sczIconFile);
     ReleaseBSTR(bstr);
     ReleaseObject(pixn);
 
@@ -1995,22 +2579,14 @@ static HRESULT ParseFonts(
             ExitOnRootFailure(hr, "Theme font id duplicated.");
         }
 
-        pFont->hFont = ::CreateFontIndirectW(&lf);
-        ExitOnNullWithLastError(pFont->hFont, hr, "Failed to create font %u.", dwId);
-
+        pFont->lf = lf;
         pFont->crForeground = crForeground;
-        if (THEME_INVISIBLE_COLORREF != pFont->crForeground)
-        {
-            pFont->hForeground = dwSystemForegroundColor ? ::GetSysColorBrush(dwSystemForegroundColor) : ::CreateSolidBrush(pFont->crForeground);
-            ExitOnNullWithLastError(pFont->hForeground, hr, "Failed to create text foreground brush.");
-        }
-
+        pFont->dwSystemForeground = dwSystemForegroundColor;
         pFont->crBackground = crBackground;
-        if (THEME_INVISIBLE_COLORREF != pFont->crBackground)
-        {
-            pFont->hBackground = dwSystemBackgroundColor ? ::GetSysColorBrush(dwSystemBackgroundColor) : ::CreateSolidBrush(pFont->crBackground);
-            ExitOnNullWithLastError(pFont->hBackground, hr, "Failed to create text background brush.");
-        }
+        pFont->dwSystemBackground = dwSystemBackgroundColor;
+
+        hr = CreateFontHandles(pFont);
+        ExitOnFailure(hr, "Failed to create font %u.", dwId);
 
         ReleaseNullBSTR(bstrName);
         ReleaseNullObject(pixn);
@@ -2031,6 +2607,32 @@ LExit:
 }
 
 
+static HRESULT CreateFontHandles(
+    __in THEME_FONT* pFont
+    )
+{
+    HRESULT hr = S_OK;
+
+    pFont->hFont = ::CreateFontIndirectW(&pFont->lf);
+    ExitOnNullWithLastError(pFont->hFont, hr, "Failed to create font.");
+
+    if (THEME_INVISIBLE_COLORREF != pFont->crForeground)
+    {
+        pFont->hForeground = pFont->dwSystemForeground ? ::GetSysColorBrush(pFont->dwSystemForeground) : ::CreateSolidBrush(pFont->crForeground);
+        ExitOnNullWithLastError(pFont->hForeground, hr, "Failed to create text foreground brush.");
+    }
+
+    if (THEME_INVISIBLE_COLORREF != pFont->crBackground)
+    {
+        pFont->hBackground = pFont->dwSystemBackground ? ::GetSysColorBrush(pFont->dwSystemBackground) : ::CreateSolidBrush(pFont->crBackground);
+        ExitOnNullWithLastError(pFont->hBackground, hr, "Failed to create text background brush.");
+    }
+
+LExit:
+    return hr;
+}
+
+
 static HRESULT GetFontColor(
     __in IXMLDOMNode* pixn,
     __in_z LPCWSTR wzAttributeName,
@@ -2103,8 +2705,6 @@ LExit:
 }
 
 static HRESULT ParsePages(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pElement,
     __in THEME* pTheme
     )
@@ -2136,14 +2736,14 @@ static HRESULT ParsePages(
 
         pPage->wId = static_cast<WORD>(iPage + 1);
 
-        hr = XmlGetAttributeEx(pixn, L"Name", &pPage->sczName);
+        hr = GetAttributeString(pTheme->hArena, pixn, L"Name", &pPage->sczName);
         if (E_NOTFOUND == hr)
         {
             hr = S_OK;
         }
         ExitOnFailure(hr, "Failed when querying page Name.");
 
-        hr = ParseControls(hModule, wzRelativePath, pixn, pTheme, NULL, pPage);
+        hr = ParseControls(pixn, pTheme, NULL, pPage);
         ExitOnFailure(hr, "Failed to parse page controls.");
 
         ++iPage;
@@ -2168,8 +2768,6 @@ LExit:
 
 
 static HRESULT ParseImageLists(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pElement,
     __in THEME* pTheme
     )
@@ -2180,12 +2778,9 @@ static HRESULT ParseImageLists(
     IXMLDOMNodeList* pixnlImages = NULL;
     IXMLDOMNode* pixnImage = NULL;
     DWORD dwImageListIndex = 0;
-    DWORD dwImageCount = 0;
-    HBITMAP hBitmap = NULL;
-    BITMAP bm = { };
+    THEME_IMAGELIST* pImageList = NULL;
     BSTR bstr = NULL;
     DWORD i = 0;
-    int iRetVal = 0;
 
     hr = XmlSelectNodes(pElement, L"ImageList", &pixnlImageLists);
     ExitOnFailure(hr, "Failed to find ImageList elements.");
@@ -2203,6 +2798,8 @@ static HRESULT ParseImageLists(
 
     while (S_OK == (hr = XmlNextElement(pixnlImageLists, &pixnImageList, NULL)))
     {
+        pImageList = pTheme->rgImageLists + dwImageListIndex;
+
         hr = XmlGetAttribute(pixnImageList, L"Name", &bstr);
         if (S_FALSE == hr)
         {
@@ -2210,53 +2807,40 @@ static HRESULT ParseImageLists(
         }
         ExitOnFailure(hr, "Failed to find ImageList/@Name attribute.");
 
-        hr = StrAllocString(&pTheme->rgImageLists[dwImageListIndex].sczName, bstr, 0);
+        hr = StrAllocStringArena(pTheme->hArena, &pImageList->sczName, bstr, 0);
         ExitOnFailure(hr, "Failed to make copy of ImageList name.");
 
+        ReleaseNullBSTR(bstr);
+
         hr = XmlSelectNodes(pixnImageList, L"Image", &pixnlImages);
         ExitOnFailure(hr, "Failed to select child Image nodes.");
 
-        hr = pixnlImages->get_length(reinterpret_cast<long*>(&dwImageCount));
+        hr = pixnlImages->get_length(reinterpret_cast<long*>(&pImageList->cImages));
         ExitOnFailure(hr, "Failed to count the number of images in list.");
 
-        if (0 < dwImageCount)
+        // The images are only decoded when a list view control using the list is loaded.
+        if (0 < pImageList->cImages)
         {
+            hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pImageList->rgImages), sizeof(THEME_IMAGE_SOURCE), pImageList->cImages);
+            ExitOnFailure(hr, "Failed to allocate image list sources.");
+
             i = 0;
             while (S_OK == (hr = XmlNextElement(pixnlImages, &pixnImage, NULL)))
             {
-                if (hBitmap)
-                {
-                    ::DeleteObject(hBitmap);
-                    hBitmap = NULL;
-                }
-                hr = ParseImage(hModule, wzRelativePath, pixnImage, &hBitmap);
+                hr = ParseImageSource(pTheme, pixnImage, L"ImageResource", L"ImageFile", pImageList->rgImages + i);
                 ExitOnFailure(hr, "Failed to parse image: %u", i);
 
-                if (0 == i)
-                {
-                    ::GetObjectW(hBitmap, sizeof(BITMAP), &bm);
-
-                    pTheme->rgImageLists[dwImageListIndex].hImageList = ImageList_Create(bm.bmWidth, bm.bmHeight, ILC_COLOR24, dwImageCount, 0);
-                    ExitOnNullWithLastError(pTheme->rgImageLists[dwImageListIndex].hImageList, hr, "Failed to create image list.");
-                }
-
-                iRetVal = ImageList_Add(pTheme->rgImageLists[dwImageListIndex].hImageList, hBitmap, NULL);
-                if (-1 == iRetVal)
-                {
-                    ExitWithLastError(hr, "Failed to add image %u to image list.", i);
-                }
-
                 ++i;
+                ReleaseNullObject(pixnImage);
             }
         }
+
+        ReleaseNullObject(pixnlImages);
+        ReleaseNullObject(pixnImageList);
         ++dwImageListIndex;
     }
 
 LExit:
-    if (hBitmap)
-    {
-        ::DeleteObject(hBitmap);
-    }
     ReleaseBSTR(bstr);
     ReleaseObject(pixnlImageLists);
     ReleaseObject(pixnImageList);
@@ -2305,8 +2889,6 @@ static void GetControls(
 }
 
 static HRESULT ParseControls(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pElement,
     __in THEME* pTheme,
     __in_opt THEME_CONTROL* pParentControl,
@@ -2325,7 +2907,7 @@ static HRESULT ParseControls(
 
     GetControls(pTheme, pParentControl, &pcControls, &prgControls);
 
-    hr = ParseRadioButtons(hModule, wzRelativePath, pElement, pTheme, pParentControl, pPage);
+    hr = ParseRadioButtons(pElement, pTheme, pParentControl, pPage);
     ExitOnFailure(hr, "Failed to parse radio buttons.");
 
     hr = XmlSelectNodes(pElement, L"Billboard|Button|Checkbox|Combobox|CommandLink|Editbox|Hyperlink|Hypertext|ImageControl|Label|ListView|Panel|Progressbar|Richedit|Static|Tabs|TreeView", &pixnl);
@@ -2440,7 +3022,7 @@ static HRESULT ParseControls(
             // billboard children are always the size of the billboard
             BOOL fBillboardSizing = pParentControl && THEME_CONTROL_TYPE_BILLBOARD == pParentControl->type;
 
-            hr = ParseControl(hModule, wzRelativePath, pixn, pTheme, pControl, fBillboardSizing, pPage);
+            hr = ParseControl(pixn, pTheme, pControl, fBillboardSizing, pPage);
             ExitOnFailure(hr, "Failed to parse control.");
 
             if (fBillboardSizing)
@@ -2482,8 +3064,6 @@ LExit:
 
 
 static HRESULT ParseControl(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pixn,
     __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
@@ -2498,21 +3078,21 @@ static HRESULT ParseControl(
     BOOL fAnyTextChildren = FALSE;
     BOOL fAnyNoteChildren = FALSE;
 
-    hr = XmlGetAttributeEx(pixn, L"Name", &pControl->sczName);
+    hr = GetAttributeString(pTheme->hArena, pixn, L"Name", &pControl->sczName);
     if (E_NOTFOUND == hr)
     {
         hr = S_OK;
     }
     ExitOnFailure(hr, "Failed when querying control Name attribute.");
 
-    hr = XmlGetAttributeEx(pixn, L"EnableCondition", &pControl->sczEnableCondition);
+    hr = GetAttributeString(pTheme->hArena, pixn, L"EnableCondition", &pControl->sczEnableCondition);
     if (E_NOTFOUND == hr)
     {
         hr = S_OK;
     }
     ExitOnFailure(hr, "Failed when querying control EnableCondition attribute.");
 
-    hr = XmlGetAttributeEx(pixn, L"VisibleCondition", &pControl->sczVisibleCondition);
+    hr = GetAttributeString(pTheme->hArena, pixn, L"VisibleCondition", &pControl->sczVisibleCondition);
     if (E_NOTFOUND == hr)
     {
         hr = S_OK;
@@ -2550,8 +3130,8 @@ static HRESULT ParseControl(
         ExitOnFailure(hr, "Failed to find control Width attribute.");
     }
 
-    // Parse the optional background resource image.
-    hr = ParseImage(hModule, wzRelativePath, pixn, &pControl->hImage);
+    // Parse the optional background resource image, it is decoded the first time the control is drawn.
+    hr = ParseImageSource(pTheme, pixn, L"ImageResource", L"ImageFile", &pControl->imageSource);
     ExitOnFailure(hr, "Failed while parsing control image.");
 
     hr = XmlGetAttributeNumber(pixn, L"SourceX", reinterpret_cast<DWORD*>(&pControl->nSourceX));
@@ -2635,18 +3215,18 @@ static HRESULT ParseControl(
         ExitOnFailure(hr, "Failed when querying control DisableAutomaticBehavior attribute.");
     }
 
-    hr = ParseActions(pixn, pControl);
+    hr = ParseActions(pixn, pTheme, pControl);
     ExitOnFailure(hr, "Failed to parse action nodes of the control.");
 
-    hr = ParseText(pixn, pControl, &fAnyTextChildren);
+    hr = ParseText(pixn, pTheme, pControl, &fAnyTextChildren);
     ExitOnFailure(hr, "Failed to parse text nodes of the control.");
 
-    hr = ParseTooltips(pixn, pControl, &fAnyTextChildren);
+    hr = ParseTooltips(pixn, pTheme, pControl, &fAnyTextChildren);
     ExitOnFailure(hr, "Failed to parse control Tooltip.");
 
     if (THEME_CONTROL_TYPE_COMMANDLINK == pControl->type)
     {
-        hr = ParseNotes(pixn, pControl, &fAnyNoteChildren);
+        hr = ParseNotes(pixn, pTheme, pControl, &fAnyNoteChildren);
         ExitOnFailure(hr, "Failed to parse note text nodes of the control.");
     }
 
@@ -2675,7 +3255,7 @@ static HRESULT ParseControl(
 
                 if (S_OK == hr)
                 {
-                    hr = StrAllocString(&pControl->sczText, bstrText, 0);
+                    hr = StrAllocStringArena(pTheme->hArena, &pControl->sczText, bstrText, 0);
                     ExitOnFailure(hr, "Failed to copy control text.");
 
                     ReleaseNullBSTR(bstrText);
@@ -2705,12 +3285,12 @@ static HRESULT ParseControl(
         }
         ExitOnFailure(hr, "Failed when querying Billboard/@Interval attribute.");
 
-        hr = ParseControls(hModule, wzRelativePath, pixn, pTheme, pControl, pPage);
+        hr = ParseControls(pixn, pTheme, pControl, pPage);
         ExitOnFailure(hr, "Failed to parse billboard children.");
     }
     else if (THEME_CONTROL_TYPE_COMMANDLINK == pControl->type)
     {
-        hr = ParseIcon(hModule, wzRelativePath, pixn, &pControl->hIcon);
+        hr = ParseImageSource(pTheme, pixn, L"IconResource", L"IconFile", &pControl->iconSource);
         ExitOnFailure(hr, "Failed while parsing control icon.");
     }
     else if (THEME_CONTROL_TYPE_EDITBOX == pControl->type)
@@ -2781,7 +3361,7 @@ static HRESULT ParseControl(
         {
             ExitOnFailure(hr, "Failed when querying ListView/@ImageList attribute.");
 
-            hr = FindImageList(pTheme, bstrText, &pControl->rghImageList[0]);
+            hr = FindImageList(pTheme, bstrText, &pControl->rgpImageList[0]);
             ExitOnFailure(hr, "Failed to find image list %ls while setting ImageList for ListView.", bstrText);
         }
 
@@ -2790,7 +3370,7 @@ static HRESULT ParseControl(
         {
             ExitOnFailure(hr, "Failed when querying ListView/@ImageListSmall attribute.");
 
-            hr = FindImageList(pTheme, bstrText, &pControl->rghImageList[1]);
+            hr = FindImageList(pTheme, bstrText, &pControl->rgpImageList[1]);
             ExitOnFailure(hr, "Failed to find image list %ls while setting ImageListSmall for ListView.", bstrText);
         }
 
@@ -2799,7 +3379,7 @@ static HRESULT ParseControl(
         {
             ExitOnFailure(hr, "Failed when querying ListView/@ImageListState attribute.");
 
-            hr = FindImageList(pTheme, bstrText, &pControl->rghImageList[2]);
+            hr = FindImageList(pTheme, bstrText, &pControl->rgpImageList[2]);
             ExitOnFailure(hr, "Failed to find image list %ls while setting ImageListState for ListView.", bstrText);
         }
 
@@ -2808,21 +3388,21 @@ static HRESULT ParseControl(
         {
             ExitOnFailure(hr, "Failed when querying ListView/@ImageListGroupHeader attribute.");
 
-            hr = FindImageList(pTheme, bstrText, &pControl->rghImageList[3]);
+            hr = FindImageList(pTheme, bstrText, &pControl->rgpImageList[3]);
             ExitOnFailure(hr, "Failed to find image list %ls while setting ImageListGroupHeader for ListView.", bstrText);
         }
 
-        hr = ParseColumns(pixn, pControl);
+        hr = ParseColumns(pixn, pTheme, pControl);
         ExitOnFailure(hr, "Failed to parse columns.");
     }
     else if (THEME_CONTROL_TYPE_PANEL == pControl->type)
     {
-        hr = ParseControls(hModule, wzRelativePath, pixn, pTheme, pControl, pPage);
+        hr = ParseControls(pixn, pTheme, pControl, pPage);
         ExitOnFailure(hr, "Failed to parse panel children.");
     }
     else if (THEME_CONTROL_TYPE_RADIOBUTTON == pControl->type)
     {
-        hr = XmlGetAttributeEx(pixn, L"Value", &pControl->sczValue);
+        hr = GetAttributeString(pTheme->hArena, pixn, L"Value", &pControl->sczValue);
         if (E_NOTFOUND == hr)
         {
             hr = S_OK;
@@ -2831,7 +3411,7 @@ static HRESULT ParseControl(
     }
     else if (THEME_CONTROL_TYPE_TAB == pControl->type)
     {
-        hr = ParseTabs(pixn, pControl);
+        hr = ParseTabs(pixn, pTheme, pControl);
         ExitOnFailure(hr, "Failed to parse tabs");
     }
     else if (THEME_CONTROL_TYPE_TREEVIEW == pControl->type)
@@ -2914,6 +3494,7 @@ LExit:
 
 static HRESULT ParseActions(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl
     )
 {
@@ -2949,14 +3530,14 @@ static HRESULT ParseActions(
             {
                 pAction->type = THEME_ACTION_TYPE_BROWSE_DIRECTORY;
 
-                hr = XmlGetAttributeEx(pixnChild, L"VariableName", &pAction->BrowseDirectory.sczVariableName);
+                hr = GetAttributeString(pTheme->hArena, pixnChild, L"VariableName", &pAction->BrowseDirectory.sczVariableName);
                 ExitOnFailure(hr, "Failed when querying BrowseDirectoryAction/@VariableName attribute.");
             }
             else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, bstrType, -1, L"ChangePageAction", -1))
             {
                 pAction->type = THEME_ACTION_TYPE_CHANGE_PAGE;
 
-                hr = XmlGetAttributeEx(pixnChild, L"Page", &pAction->ChangePage.sczPageName);
+                hr = GetAttributeString(pTheme->hArena, pixnChild, L"Page", &pAction->ChangePage.sczPageName);
                 ExitOnFailure(hr, "Failed when querying ChangePageAction/@Page attribute.");
 
                 hr = XmlGetYesNoAttribute(pixnChild, L"Cancel", &pAction->ChangePage.fCancel);
@@ -2975,7 +3556,7 @@ static HRESULT ParseActions(
                 ExitOnFailure(hr, "Unexpected element encountered: %ls", bstrType);
             }
 
-            hr = XmlGetAttributeEx(pixnChild, L"Condition", &pAction->sczCondition);
+            hr = GetAttributeString(pTheme->hArena, pixnChild, L"Condition", &pAction->sczCondition);
             if (E_NOTFOUND != hr)
             {
                 ExitOnFailure(hr, "Failed when querying %ls/@Condition attribute.", bstrType);
@@ -3009,6 +3590,7 @@ LExit:
 
 static HRESULT ParseColumns(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl
     )
 {
@@ -3049,7 +3631,7 @@ static HRESULT ParseColumns(
             }
             ExitOnFailure(hr, "Failed to get expands attribute.");
 
-            hr = StrAllocString(&(pControl->ptcColumns[i].pszName), bstrText, 0);
+            hr = StrAllocStringArena(pTheme->hArena, &(pControl->ptcColumns[i].pszName), bstrText, 0);
             ExitOnFailure(hr, "Failed to copy column name.");
 
             ++i;
@@ -3067,8 +3649,6 @@ LExit:
 
 
 static HRESULT ParseRadioButtons(
-    __in_opt HMODULE hModule,
-    __in_opt LPCWSTR wzRelativePath,
     __in IXMLDOMNode* pixn,
     __in THEME* pTheme,
     __in_opt THEME_CONTROL* pParentControl,
@@ -3130,7 +3710,7 @@ static HRESULT ParseRadioButtons(
                 pControl = *prgControls + iControl;
                 pControl->type = THEME_CONTROL_TYPE_RADIOBUTTON;
 
-                hr = ParseControl(hModule, wzRelativePath, pixnChild, pTheme, pControl, FALSE, pPage);
+                hr = ParseControl(pixnChild, pTheme, pControl, FALSE, pPage);
                 ExitOnFailure(hr, "Failed to parse control.");
 
                 if (fFirst)
@@ -3139,7 +3719,7 @@ static HRESULT ParseRadioButtons(
                     fFirst = FALSE;
                 }
 
-                hr = StrAllocString(&pControl->sczVariable, sczName, 0);
+                hr = StrAllocStringArena(pTheme->hArena, &pControl->sczVariable, sczName, 0);
                 ExitOnFailure(hr, "Failed to copy radio button variable.");
 
                 if (pPage)
@@ -3171,6 +3751,7 @@ LExit:
 
 static HRESULT ParseTabs(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl
     )
 {
@@ -3197,7 +3778,7 @@ static HRESULT ParseTabs(
             hr = XmlGetText(pixnChild, &bstrText);
             ExitOnFailure(hr, "Failed to get inner text of tab element.");
 
-            hr = StrAllocString(&(pControl->pttTabs[i].pszName), bstrText, 0);
+            hr = StrAllocStringArena(pTheme->hArena, &(pControl->pttTabs[i].pszName), bstrText, 0);
             ExitOnFailure(hr, "Failed to copy tab name.");
 
             ++i;
@@ -3216,6 +3797,7 @@ LExit:
 
 static HRESULT ParseText(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
     __inout BOOL* pfAnyChildren
     )
@@ -3244,7 +3826,7 @@ static HRESULT ParseText(
         {
             THEME_CONDITIONAL_TEXT* pConditionalText = pControl->rgConditionalText + i;
 
-            hr = XmlGetAttributeEx(pixnChild, L"Condition", &pConditionalText->sczCondition);
+            hr = GetAttributeString(pTheme->hArena, pixnChild, L"Condition", &pConditionalText->sczCondition);
             if (E_NOTFOUND == hr)
             {
                 hr = S_OK;
@@ -3258,7 +3840,7 @@ static HRESULT ParseText(
             {
                 if (pConditionalText->sczCondition)
                 {
-                    hr = StrAllocString(&pConditionalText->sczText, bstrText, 0);
+                    hr = StrAllocStringArena(pTheme->hArena, &pConditionalText->sczText, bstrText, 0);
                     ExitOnFailure(hr, "Failed to copy text to conditional text.");
 
                     ++i;
@@ -3271,7 +3853,7 @@ static HRESULT ParseText(
                         ExitOnFailure(hr, "Unconditional text for the '%ls' control is specified multiple times.", pControl->sczName);
                     }
 
-                    hr = StrAllocString(&pControl->sczText, bstrText, 0);
+                    hr = StrAllocStringArena(pTheme->hArena, &pControl->sczText, bstrText, 0);
                     ExitOnFailure(hr, "Failed to copy text to control.");
 
                     // Unconditional text entries aren't stored in the conditional text list.
@@ -3294,6 +3876,7 @@ LExit:
 
 static HRESULT ParseTooltips(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
     __inout BOOL* pfAnyChildren
 )
@@ -3314,7 +3897,7 @@ static HRESULT ParseTooltips(
 
         if (S_OK == hr)
         {
-            hr = StrAllocString(&pControl->sczTooltip, bstrText, 0);
+            hr = StrAllocStringArena(pTheme->hArena, &pControl->sczTooltip, bstrText, 0);
             ExitOnFailure(hr, "Failed to copy tooltip text to control.");
         }
     }
@@ -3329,6 +3912,7 @@ LExit:
 
 static HRESULT ParseNotes(
     __in IXMLDOMNode* pixn,
+    __in THEME* pTheme,
     __in THEME_CONTROL* pControl,
     __out BOOL* pfAnyChildren
     )
@@ -3360,7 +3944,7 @@ static HRESULT ParseNotes(
         {
             THEME_CONDITIONAL_TEXT* pConditionalNote = pControl->rgConditionalNotes + i;
 
-            hr = XmlGetAttributeEx(pixnChild, L"Condition", &pConditionalNote->sczCondition);
+            hr = GetAttributeString(pTheme->hArena, pixnChild, L"Condition", &pConditionalNote->sczCondition);
             if (E_NOTFOUND == hr)
             {
                 hr = S_OK;
@@ -3374,7 +3958,7 @@ static HRESULT ParseNotes(
             {
                 if (pConditionalNote->sczCondition)
                 {
-                    hr = StrAllocString(&pConditionalNote->sczText, bstrText, 0);
+                    hr = StrAllocStringArena(pTheme->hArena, &pConditionalNote->sczText, bstrText, 0);
                     ExitOnFailure(hr, "Failed to copy text to conditional note text.");
 
                     ++i;
@@ -3387,7 +3971,7 @@ static HRESULT ParseNotes(
                         ExitOnFailure(hr, "Unconditional note text for the '%ls' control is specified multiple times.", pControl->sczName);
                     }
 
-                    hr = StrAllocString(&pControl->sczNote, bstrText, 0);
+                    hr = StrAllocStringArena(pTheme->hArena, &pControl->sczNote, bstrText, 0);
                     ExitOnFailure(hr, "Failed to copy text to command link control.");
 
                     // Unconditional note entries aren't stored in the conditional notes list.
@@ -3408,7 +3992,531 @@ LExit:
 }
 
 
-static HRESULT StartBillboard(
+static BOOL IsThemeBuffer(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer
+    )
+{
+    SIZE_T iBuffer = 0;
+    DWORD dwMagic = 0;
+
+    return SUCCEEDED(BuffReadNumber(pbBuffer, cbBuffer, &iBuffer, &dwMagic)) && THEME_BINARY_MAGIC == dwMagic;
+}
+
+
+static HRESULT WriteRecord(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cbRecord) const void* pvRecord,
+    __in SIZE_T cbRecord
+    )
+{
+    return BuffWriterWriteStream(pWriter, static_cast<const BYTE*>(pvRecord), cbRecord);
+}
+
+
+static HRESULT ReadRecord(
+    __in BUFF_READER* pReader,
+    __out_bcount(cbRecord) void* pvRecord,
+    __in SIZE_T cbRecord
+    )
+{
+    HRESULT hr = S_OK;
+    const BYTE* pbRecord = NULL;
+    SIZE_T cbRead = 0;
+
+    hr = BuffReaderReadStreamView(pReader, &pbRecord, &cbRead);
+    ExitOnFailure(hr, "Failed to read record.");
+
+    // A record of a different size was written by a different version of the structs.
+    if (cbRecord != cbRead)
+    {
+        hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        ExitOnRootFailure(hr, "Record size: %Iu doesn't match expected size: %Iu", cbRead, cbRecord);
+    }
+
+    memcpy(pvRecord, pbRecord, cbRecord);
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT WriteThemeString(
+    __in BUFF_WRITER* pWriter,
+    __in_z_opt LPCWSTR wz
+    )
+{
+    HRESULT hr = S_OK;
+
+    // The buffer can't tell a missing string from an empty one, and the theme can.
+    hr = BuffWriterWriteNumber(pWriter, wz ? 1 : 0);
+    ExitOnFailure(hr, "Failed to write string presence.");
+
+    if (wz)
+    {
+        hr = BuffWriterWriteString(pWriter, wz);
+        ExitOnFailure(hr, "Failed to write string.");
+    }
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT ReadThemeString(
+    __in BUFF_READER* pReader,
+    __in THEME* pTheme,
+    __deref_out_z_opt LPWSTR* psczValue
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD fPresent = 0;
+    LPCWSTR wz = NULL;
+    DWORD cch = 0;
+
+    hr = BuffReaderReadNumber(pReader, &fPresent);
+    ExitOnFailure(hr, "Failed to read string presence.");
+
+    if (fPresent)
+    {
+        hr = BuffReaderReadStringView(pReader, &wz, &cch);
+        ExitOnFailure(hr, "Failed to read string.");
+
+        if (cch)
+        {
+            hr = StrAllocStringArena(pTheme->hArena, psczValue, wz, cch);
+        }
+        else
+        {
+            hr = StrAllocStringArena(pTheme->hArena, psczValue, L"", 0);
+        }
+        ExitOnFailure(hr, "Failed to copy string.");
+    }
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT WriteImageSource(
+    __in BUFF_WRITER* pWriter,
+    __in const THEME_IMAGE_SOURCE* pSource
+    )
+{
+    HRESULT hr = S_OK;
+
+    hr = WriteThemeString(pWriter, pSource->sczResource);
+    ExitOnFailure(hr, "Failed to write image resource.");
+
+    hr = WriteThemeString(pWriter, pSource->sczFile);
+    ExitOnFailure(hr, "Failed to write image file.");
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT ReadImageSource(
+    __in BUFF_READER* pReader,
+    __in THEME* pTheme,
+    __out THEME_IMAGE_SOURCE* pSource
+    )
+{
+    HRESULT hr = S_OK;
+
+    hr = ReadThemeString(pReader, pTheme, &pSource->sczResource);
+    ExitOnFailure(hr, "Failed to read image resource.");
+
+    hr = ReadThemeString(pReader, pTheme, &pSource->sczFile);
+    ExitOnFailure(hr, "Failed to read image file.");
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT WriteControls(
+    __in BUFF_WRITER* pWriter,
+    __in const THEME* pTheme,
+    __in DWORD cControls,
+    __in_ecount(cControls) const THEME_CONTROL* rgControls
+    )
+{
+    HRESULT hr = S_OK;
+    THEME_CONTROL_RECORD record = { };
+
+    for (DWORD i = 0; i < cControls; ++i)
+    {
+        const THEME_CONTROL* pControl = rgControls + i;
+
+        memset(&record, 0, sizeof(record));
+        record.type = pControl->type;
+        record.wPageId = pControl->wPageId;
+        record.nX = pControl->nX;
+        record.nY = pControl->nY;
+        record.nHeight = pControl->nHeight;
+        record.nWidth = pControl->nWidth;
+        record.nSourceX = pControl->nSourceX;
+        record.nSourceY = pControl->nSourceY;
+        record.uStringId = pControl->uStringId;
+        record.fDisableVariableFunctionality = pControl->fDisableVariableFunctionality;
+        record.dwStyle = pControl->dwStyle;
+        record.dwExtendedStyle = pControl->dwExtendedStyle;
+        record.dwInternalStyle = pControl->dwInternalStyle;
+        record.dwFontId = pControl->dwFontId;
+        record.dwFontHoverId = pControl->dwFontHoverId;
+        record.dwFontSelectedId = pControl->dwFontSelectedId;
+        record.wBillboardInterval = pControl->wBillboardInterval;
+        record.fBillboardLoops = pControl->fBillboardLoops;
+        record.fLastRadioButton = pControl->fLastRadioButton;
+        record.cControls = pControl->cControls;
+        record.cActions = pControl->cActions;
+        record.cColumns = pControl->cColumns;
+        record.cTabs = pControl->cTabs;
+        record.cConditionalText = pControl->cConditionalText;
+        record.cConditionalNotes = pControl->cConditionalNotes;
+
+        for (DWORD j = 0; j < countof(pControl->rgpImageList); ++j)
+        {
+            if (pControl->rgpImageList[j])
+            {
+                record.rgdwImageList[j] = static_cast<DWORD>(pControl->rgpImageList[j] - pTheme->rgImageLists) + 1;
+            }
+        }
+
+        hr = WriteRecord(pWriter, &record, sizeof(record));
+        ExitOnFailure(hr, "Failed to write control.");
+
+        hr = WriteThemeString(pWriter, pControl->sczName);
+        ExitOnFailure(hr, "Failed to write control name.");
+
+        hr = WriteThemeString(pWriter, pControl->sczText);
+        ExitOnFailure(hr, "Failed to write control text.");
+
+        hr = WriteThemeString(pWriter, pControl->sczTooltip);
+        ExitOnFailure(hr, "Failed to write control tooltip.");
+
+        hr = WriteThemeString(pWriter, pControl->sczNote);
+        ExitOnFailure(hr, "Failed to write control note.");
+
+        hr = WriteThemeString(pWriter, pControl->sczEnableCondition);
+        ExitOnFailure(hr, "Failed to write control enable condition.");
+
+        hr = WriteThemeString(pWriter, pControl->sczVisibleCondition);
+        ExitOnFailure(hr, "Failed to write control visible condition.");
+
+        hr = WriteThemeString(pWriter, pControl->sczValue);
+        ExitOnFailure(hr, "Failed to write control value.");
+
+        hr = WriteThemeString(pWriter, pControl->sczVariable);
+        ExitOnFailure(hr, "Failed to write control variable.");
+
+        hr = WriteImageSource(pWriter, &pControl->imageSource);
+        ExitOnFailure(hr, "Failed to write control image.");
+
+        hr = WriteImageSource(pWriter, &pControl->iconSource);
+        ExitOnFailure(hr, "Failed to write control icon.");
+
+        hr = WriteControls(pWriter, pTheme, pControl->cControls, pControl->rgControls);
+        ExitOnFailure(hr, "Failed to write child controls.");
+
+        for (DWORD j = 0; j < pControl->cActions; ++j)
+        {
+            const THEME_ACTION* pAction = pControl->rgActions + j;
+
+            hr = BuffWriterWriteNumber(pWriter, pAction->type);
+            ExitOnFailure(hr, "Failed to write action type.");
+
+            hr = WriteThemeString(pWriter, pAction->sczCondition);
+            ExitOnFailure(hr, "Failed to write action condition.");
+
+            switch (pAction->type)
+            {
+            case THEME_ACTION_TYPE_BROWSE_DIRECTORY:
+                hr = WriteThemeString(pWriter, pAction->BrowseDirectory.sczVariableName);
+                ExitOnFailure(hr, "Failed to write action variable name.");
+                break;
+
+            case THEME_ACTION_TYPE_CHANGE_PAGE:
+                hr = WriteThemeString(pWriter, pAction->ChangePage.sczPageName);
+                ExitOnFailure(hr, "Failed to write action page name.");
+
+                hr = BuffWriterWriteNumber(pWriter, pAction->ChangePage.fCancel);
+                ExitOnFailure(hr, "Failed to write action cancel.");
+                break;
+            }
+        }
+
+        for (DWORD j = 0; j < pControl->cColumns; ++j)
+        {
+            const THEME_COLUMN* pColumn = pControl->ptcColumns + j;
+
+            hr = WriteThemeString(pWriter, pColumn->pszName);
+            ExitOnFailure(hr, "Failed to write column name.");
+
+            hr = BuffWriterWriteNumber(pWriter, pColumn->uStringId);
+            ExitOnFailure(hr, "Failed to write column string id.");
+
+            hr = BuffWriterWriteNumber(pWriter, static_cast<DWORD>(pColumn->nBaseWidth));
+            ExitOnFailure(hr, "Failed to write column width.");
+
+            hr = BuffWriterWriteNumber(pWriter, pColumn->fExpands);
+            ExitOnFailure(hr, "Failed to write column expands.");
+        }
+
+        for (DWORD j = 0; j < pControl->cTabs; ++j)
+        {
+            hr = WriteThemeString(pWriter, pControl->pttTabs[j].pszName);
+            ExitOnFailure(hr, "Failed to write tab name.");
+
+            hr = BuffWriterWriteNumber(pWriter, pControl->pttTabs[j].uStringId);
+            ExitOnFailure(hr, "Failed to write tab string id.");
+        }
+
+        for (DWORD j = 0; j < pControl->cConditionalText; ++j)
+        {
+            hr = WriteThemeString(pWriter, pControl->rgConditionalText[j].sczCondition);
+            ExitOnFailure(hr, "Failed to write conditional text condition.");
+
+            hr = WriteThemeString(pWriter, pControl->rgConditionalText[j].sczText);
+            ExitOnFailure(hr, "Failed to write conditional text.");
+        }
+
+        for (DWORD j = 0; j < pControl->cConditionalNotes; ++j)
+        {
+            hr = WriteThemeString(pWriter, pControl->rgConditionalNotes[j].sczCondition);
+            ExitOnFailure(hr, "Failed to write conditional note condition.");
+
+            hr = WriteThemeString(pWriter, pControl->rgConditionalNotes[j].sczText);
+            ExitOnFailure(hr, "Failed to write conditional note.");
+        }
+    }
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT ReadControls(
+    __in BUFF_READER* pReader,
+    __in THEME* pTheme,
+    __in DWORD cControls,
+    __out DWORD* pcControls,
+    __deref_out_ecount(cControls) THEME_CONTROL** prgControls
+    )
+{
+    HRESULT hr = S_OK;
+    THEME_CONTROL_RECORD record = { };
+
+    hr = MemAllocArray(reinterpret_cast<LPVOID*>(prgControls), sizeof(THEME_CONTROL), cControls);
+    ExitOnFailure(hr, "Failed to allocate controls.");
+
+    // Counts are set as soon as their arrays exist so a partially read theme can still be freed.
+    *pcControls = cControls;
+
+    for (DWORD i = 0; i < cControls; ++i)
+    {
+        THEME_CONTROL* pControl = *prgControls + i;
+
+        hr = ReadRecord(pReader, &record, sizeof(record));
+        ExitOnFailure(hr, "Failed to read control.");
+
+        pControl->type = static_cast<THEME_CONTROL_TYPE>(record.type);
+        pControl->wPageId = static_cast<WORD>(record.wPageId);
+        pControl->nX = record.nX;
+        pControl->nY = record.nY;
+        pControl->nHeight = record.nHeight;
+        pControl->nWidth = record.nWidth;
+        pControl->nSourceX = record.nSourceX;
+        pControl->nSourceY = record.nSourceY;
+        pControl->uStringId = record.uStringId;
+        pControl->fDisableVariableFunctionality = record.fDisableVariableFunctionality;
+        pControl->dwStyle = record.dwStyle;
+        pControl->dwExtendedStyle = record.dwExtendedStyle;
+        pControl->dwInternalStyle = record.dwInternalStyle;
+        pControl->dwFontId = record.dwFontId;
+        pControl->dwFontHoverId = record.dwFontHoverId;
+        pControl->dwFontSelectedId = record.dwFontSelectedId;
+        pControl->wBillboardInterval = static_cast<WORD>(record.wBillboardInterval);
+        pControl->fBillboardLoops = record.fBillboardLoops;
+        pControl->fLastRadioButton = record.fLastRadioButton;
+
+        for (DWORD j = 0; j < countof(pControl->rgpImageList); ++j)
+        {
+            if (record.rgdwImageList[j])
+            {
+                if (pTheme->cImageLists < record.rgdwImageList[j])
+                {
+                    hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+                    ExitOnRootFailure(hr, "Control refers to unknown image list: %u", record.rgdwImageList[j]);
+                }
+
+                pControl->rgpImageList[j] = pTheme->rgImageLists + record.rgdwImageList[j] - 1;
+            }
+        }
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczName);
+        ExitOnFailure(hr, "Failed to read control name.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczText);
+        ExitOnFailure(hr, "Failed to read control text.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczTooltip);
+        ExitOnFailure(hr, "Failed to read control tooltip.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczNote);
+        ExitOnFailure(hr, "Failed to read control note.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczEnableCondition);
+        ExitOnFailure(hr, "Failed to read control enable condition.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczVisibleCondition);
+        ExitOnFailure(hr, "Failed to read control visible condition.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczValue);
+        ExitOnFailure(hr, "Failed to read control value.");
+
+        hr = ReadThemeString(pReader, pTheme, &pControl->sczVariable);
+        ExitOnFailure(hr, "Failed to read control variable.");
+
+        hr = ReadImageSource(pReader, pTheme, &pControl->imageSource);
+        ExitOnFailure(hr, "Failed to read control image.");
+
+        hr = ReadImageSource(pReader, pTheme, &pControl->iconSource);
+        ExitOnFailure(hr, "Failed to read control icon.");
+
+        if (record.cControls)
+        {
+            hr = ReadControls(pReader, pTheme, record.cControls, &pControl->cControls, &pControl->rgControls);
+            ExitOnFailure(hr, "Failed to read child controls.");
+        }
+
+        if (record.cActions)
+        {
+            hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pControl->rgActions), sizeof(THEME_ACTION), record.cActions);
+            ExitOnFailure(hr, "Failed to allocate actions.");
+
+            pControl->cActions = record.cActions;
+
+            for (DWORD j = 0; j < pControl->cActions; ++j)
+            {
+                THEME_ACTION* pAction = pControl->rgActions + j;
+                DWORD dwType = 0;
+
+                hr = BuffReaderReadNumber(pReader, &dwType);
+                ExitOnFailure(hr, "Failed to read action type.");
+
+                pAction->type = static_cast<THEME_ACTION_TYPE>(dwType);
+
+                hr = ReadThemeString(pReader, pTheme, &pAction->sczCondition);
+                ExitOnFailure(hr, "Failed to read action condition.");
+
+                switch (pAction->type)
+                {
+                case THEME_ACTION_TYPE_BROWSE_DIRECTORY:
+                    hr = ReadThemeString(pReader, pTheme, &pAction->BrowseDirectory.sczVariableName);
+                    ExitOnFailure(hr, "Failed to read action variable name.");
+                    break;
+
+                case THEME_ACTION_TYPE_CHANGE_PAGE:
+                    hr = ReadThemeString(pReader, pTheme, &pAction->ChangePage.sczPageName);
+                    ExitOnFailure(hr, "Failed to read action page name.");
+
+                    hr = BuffReaderReadNumber(pReader, reinterpret_cast<DWORD*>(&pAction->ChangePage.fCancel));
+                    ExitOnFailure(hr, "Failed to read action cancel.");
+                    break;
+                }
+
+                if (!pAction->sczCondition)
+                {
+                    pControl->pDefaultAction = pAction;
+                }
+            }
+        }
+
+        if (record.cColumns)
+        {
+            hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pControl->ptcColumns), sizeof(THEME_COLUMN), record.cColumns);
+            ExitOnFailure(hr, "Failed to allocate columns.");
+
+            pControl->cColumns = record.cColumns;
+
+            for (DWORD j = 0; j < pControl->cColumns; ++j)
+            {
+                THEME_COLUMN* pColumn = pControl->ptcColumns + j;
+
+                hr = ReadThemeString(pReader, pTheme, &pColumn->pszName);
+                ExitOnFailure(hr, "Failed to read column name.");
+
+                hr = BuffReaderReadNumber(pReader, reinterpret_cast<DWORD*>(&pColumn->uStringId));
+                ExitOnFailure(hr, "Failed to read column string id.");
+
+                hr = BuffReaderReadNumber(pReader, reinterpret_cast<DWORD*>(&pColumn->nBaseWidth));
+                ExitOnFailure(hr, "Failed to read column width.");
+
+                hr = BuffReaderReadNumber(pReader, reinterpret_cast<DWORD*>(&pColumn->fExpands));
+                ExitOnFailure(hr, "Failed to read column expands.");
+            }
+        }
+
+        if (record.cTabs)
+        {
+            hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pControl->pttTabs), sizeof(THEME_TAB), record.cTabs);
+            ExitOnFailure(hr, "Failed to allocate tabs.");
+
+            pControl->cTabs = record.cTabs;
+
+            for (DWORD j = 0; j < pControl->cTabs; ++j)
+            {
+                hr = ReadThemeString(pReader, pTheme, &pControl->pttTabs[j].pszName);
+                ExitOnFailure(hr, "Failed to read tab name.");
+
+                hr = BuffReaderReadNumber(pReader, reinterpret_cast<DWORD*>(&pControl->pttTabs[j].uStringId));
+                ExitOnFailure(hr, "Failed to read tab string id.");
+            }
+        }
+
+        if (record.cConditionalText)
+        {
+            hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pControl->rgConditionalText), sizeof(THEME_CONDITIONAL_TEXT), record.cConditionalText);
+            ExitOnFailure(hr, "Failed to allocate conditional text.");
+
+            pControl->cConditionalText = record.cConditionalText;
+
+            for (DWORD j = 0; j < pControl->cConditionalText; ++j)
+            {
+                hr = ReadThemeString(pReader, pTheme, &pControl->rgConditionalText[j].sczCondition);
+                ExitOnFailure(hr, "Failed to read conditional text condition.");
+
+                hr = ReadThemeString(pReader, pTheme, &pControl->rgConditionalText[j].sczText);
+                ExitOnFailure(hr, "Failed to read conditional text.");
+            }
+        }
+
+        if (record.cConditionalNotes)
+        {
+            hr = MemAllocArray(reinterpret_cast<LPVOID*>(&pControl->rgConditionalNotes), sizeof(THEME_CONDITIONAL_TEXT), record.cConditionalNotes);
+            ExitOnFailure(hr, "Failed to allocate conditional notes.");
+
+            pControl->cConditionalNotes = record.cConditionalNotes;
+
+            for (DWORD j = 0; j < pControl->cConditionalNotes; ++j)
+            {
+                hr = ReadThemeString(pReader, pTheme, &pControl->rgConditionalNotes[j].sczCondition);
+                ExitOnFailure(hr, "Failed to read conditional note condition.");
+
+                hr = ReadThemeString(pReader, pTheme, &pControl->rgConditionalNotes[j].sczText);
+                ExitOnFailure(hr, "Failed to read conditional note.");
+            }
+        }
+    }
+
+LExit:
+    return hr;
+}
+
+
+static HRESULT StartBillboard(
     __in THEME* pTheme,
     __in DWORD dwControl
     )
@@ -3439,6 +4547,32 @@ LExit:
 }
 
 
+static HRESULT GetAttributeString(
+    __in_opt MEM_ARENA_HANDLE hArena,
+    __in IXMLDOMNode* pixn,
+    __in_z LPCWSTR wzAttribute,
+    __deref_out_z LPWSTR* psczValue
+    )
+{
+    HRESULT hr = S_OK;
+    BSTR bstr = NULL;
+
+    hr = XmlGetAttribute(pixn, wzAttribute, &bstr);
+    if (S_FALSE == hr)
+    {
+        ExitFunction1(hr = E_NOTFOUND);
+    }
+    ExitOnFailure(hr, "Failed to get attribute: %ls", wzAttribute);
+
+    hr = StrAllocStringArena(hArena, psczValue, bstr, 0);
+    ExitOnFailure(hr, "Failed to copy attribute: %ls", wzAttribute);
+
+LExit:
+    ReleaseBSTR(bstr);
+
+    return hr;
+}
+
 static HRESULT StopBillboard(
     __in THEME* pTheme,
     __in DWORD dwControl
@@ -3468,7 +4602,7 @@ static HRESULT StopBillboard(
 static HRESULT FindImageList(
     __in THEME* pTheme,
     __in_z LPCWSTR wzImageListName,
-    __out HIMAGELIST *phImageList
+    __out THEME_IMAGELIST** ppImageList
     )
 {
     HRESULT hr = S_OK;
@@ -3477,7 +4611,7 @@ static HRESULT FindImageList(
     {
         if (CSTR_EQUAL == ::CompareStringW(LOCALE_NEUTRAL, 0, pTheme->rgImageLists[i].sczName, -1, wzImageListName, -1))
         {
-            *phImageList = pTheme->rgImageLists[i].hImageList;
+            *ppImageList = pTheme->rgImageLists + i;
             ExitFunction1(hr = S_OK);
         }
     }
@@ -3714,6 +4848,7 @@ static void FreeImageList(
     if (pImageList)
     {
         ReleaseStr(pImageList->sczName);
+        ReleaseMem(pImageList->rgImages);
         ImageList_Destroy(pImageList->hImageList);
     }
 }
@@ -4659,7 +5794,7 @@ static HRESULT LoadControls(
             __fallthrough;
         case THEME_CONTROL_TYPE_BUTTON:
             wzWindowClass = WC_BUTTONW;
-            if (pControl->hImage || (pTheme->hImage && 0 <= pControl->nSourceX && 0 <= pControl->nSourceY))
+            if (ControlHasImage(pControl) || (pTheme->hImage && 0 <= pControl->nSourceX && 0 <= pControl->nSourceY))
             {
                 dwWindowBits |= BS_OWNERDRAW;
                 pControl->dwInternalStyle |= INTERNAL_CONTROL_STYLE_OWNER_DRAW;
@@ -4693,7 +5828,7 @@ static HRESULT LoadControls(
             break;
 
         case THEME_CONTROL_TYPE_IMAGE: // images are basically just owner drawn static controls (so we can draw .jpgs and .pngs instead of just bitmaps).
-            if (pControl->hImage || (pTheme->hImage && 0 <= pControl->nSourceX && 0 <= pControl->nSourceY))
+            if (ControlHasImage(pControl) || (pTheme->hImage && 0 <= pControl->nSourceX && 0 <= pControl->nSourceY))
             {
                 wzWindowClass = WC_STATICW;
                 dwWindowBits |= SS_OWNERDRAW;
@@ -4712,7 +5847,7 @@ static HRESULT LoadControls(
 
         case THEME_CONTROL_TYPE_LISTVIEW:
             // If thmutil is handling the image list for this listview, tell Windows not to free it when the control is destroyed.
-            if (pControl->rghImageList[0] || pControl->rghImageList[1] || pControl->rghImageList[2] || pControl->rghImageList[3])
+            if (pControl->rgpImageList[0] || pControl->rgpImageList[1] || pControl->rgpImageList[2] || pControl->rgpImageList[3])
             {
                 pControl->dwStyle |= LVS_SHAREIMAGELISTS;
             }
@@ -4720,7 +5855,7 @@ static HRESULT LoadControls(
             break;
 
         case THEME_CONTROL_TYPE_PROGRESSBAR:
-            if (pControl->hImage || (pTheme->hImage && 0 <= pControl->nSourceX && 0 <= pControl->nSourceY))
+            if (ControlHasImage(pControl) || (pTheme->hImage && 0 <= pControl->nSourceX && 0 <= pControl->nSourceY))
             {
                 wzWindowClass = WC_STATICW; // no such thing as an owner drawn progress bar so we'll make our own out of a static control.
                 dwWindowBits |= SS_OWNERDRAW;
@@ -4854,6 +5989,9 @@ static HRESULT LoadControls(
                 ::SendMessageW(pControl->hWnd, BCM_SETNOTE, 0, reinterpret_cast<WPARAM>(pControl->sczNote));
             }
 
+            hr = LoadControlImage(pTheme, pControl);
+            ExitOnFailure(hr, "Failed to load command link image.");
+
             if (pControl->hImage)
             {
                 ::SendMessageW(pControl->hWnd, BM_SETIMAGE, IMAGE_BITMAP, reinterpret_cast<LPARAM>(pControl->hImage));
@@ -4874,6 +6012,17 @@ static HRESULT LoadControls(
         {
             ::SendMessageW(pControl->hWnd, LVM_SETEXTENDEDLISTVIEWSTYLE, 0, pControl->dwExtendedStyle);
 
+            for (DWORD j = 0; j < countof(pControl->rgpImageList); ++j)
+            {
+                if (pControl->rgpImageList[j])
+                {
+                    hr = LoadImageList(pTheme, pControl->rgpImageList[j]);
+                    ExitOnFailure(hr, "Failed to load image list: %ls", pControl->rgpImageList[j]->sczName);
+
+                    pControl->rghImageList[j] = pControl->rgpImageList[j]->hImageList;
+                }
+            }
+
             hr = SizeListViewColumns(pControl);
             ExitOnFailure(hr, "Failed to get size of list view columns.");
 
@@ -2,17 +2,103 @@
 
 #include "precomp.h"
 
-struct VARIABLE_ENUM_STRUCT
+// Formatted values may reference other formatted values; this bounds how deep that can go
+// so a variable that (indirectly) references itself fails instead of recursing forever.
+#define VARIABLE_FORMAT_MAX_DEPTH 32
+
+#define VARIABLE_GROW_COUNT 32
+
+struct VARIABLE_ENTRY
 {
+    LPWSTR sczName;
+    VARIABLE_VALUE value;
 };
 
 struct VARIABLES_STRUCT
 {
+    CRITICAL_SECTION csAccess;
+
+    // Variables in the order they were added, which is also the enumeration order.
+    VARIABLE_ENTRY* rgVariables;
+    DWORD cVariables;
+
+    // Name to entry index. Stores offsets into rgVariables so the array can grow underneath it.
+    STRINGDICT_HANDLE sdVariables;
+
+    // Incremented whenever a variable is added so enumerations can detect it.
+    DWORD dwGeneration;
+};
+
+struct VARIABLE_ENUM_STRUCT
+{
+    VARIABLES_STRUCT* pVariables;
+    DWORD iVariable;
+    DWORD dwGeneration;
+};
+
+struct VARIABLE_FORMAT_BUFFER
+{
+    LPWSTR scz;
+    DWORD cch;
+    DWORD cchCapacity;
 };
 
 const int VARIABLE_ENUM_HANDLE_BYTES = sizeof(VARIABLE_ENUM_STRUCT);
 const int VARIABLES_HANDLE_BYTES = sizeof(VARIABLES_STRUCT);
 
+static HRESULT FindVariable(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __out VARIABLE_ENTRY** ppVariable
+    );
+static HRESULT GetVariableWithValue(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __out VARIABLE_ENTRY** ppVariable
+    );
+static HRESULT SetVariableValue(
+    __in VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __in const VARIABLE_VALUE* pValue,
+    __in BOOL fSetMetadata
+    );
+static HRESULT CopyValue(
+    __in const VARIABLE_VALUE* pSource,
+    __in VARIABLE_VALUE* pTarget
+    );
+static void UninitializeValue(
+    __in VARIABLE_VALUE* pValue
+    );
+static HRESULT ValueGetNumeric(
+    __in const VARIABLE_VALUE* pValue,
+    __out LONGLONG* pllValue
+    );
+static HRESULT ValueGetString(
+    __in const VARIABLE_VALUE* pValue,
+    __out_z LPWSTR* psczValue
+    );
+static HRESULT ValueGetVersion(
+    __in const VARIABLE_VALUE* pValue,
+    __out DWORD64* pqwValue
+    );
+static HRESULT FormatString(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzIn,
+    __in DWORD dwDepth,
+    __inout VARIABLE_FORMAT_BUFFER* pBuffer
+    );
+static HRESULT FormatVariable(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __in DWORD dwDepth,
+    __inout VARIABLE_FORMAT_BUFFER* pBuffer
+    );
+static HRESULT AppendFormatBuffer(
+    __inout VARIABLE_FORMAT_BUFFER* pBuffer,
+    __in_ecount(cch) LPCWSTR wz,
+    __in DWORD cch
+    );
+
 // function definitions
 
 /********************************************************************
@@ -22,8 +108,26 @@ extern "C" HRESULT DAPI VarCreate(
     __out_bcount(VARIABLES_HANDLE_BYTES) VARIABLES_HANDLE* ppVariables
     )
 {
-    UNREFERENCED_PARAMETER(ppVariables);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariables = NULL;
+
+    ExitOnNull(ppVariables, hr, E_INVALIDARG, "Handle not specified while creating variables.");
+
+    pVariables = static_cast<VARIABLES_STRUCT*>(MemAlloc(sizeof(VARIABLES_STRUCT), TRUE));
+    ExitOnNull(pVariables, hr, E_OUTOFMEMORY, "Failed to allocate variables object.");
+
+    ::InitializeCriticalSection(&pVariables->csAccess);
+
+    hr = DictCreateWithEmbeddedKey(&pVariables->sdVariables, 0, reinterpret_cast<void**>(&pVariables->rgVariables), offsetof(VARIABLE_ENTRY, sczName), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create variable name index.");
+
+    *ppVariables = pVariables;
+    pVariables = NULL;
+
+LExit:
+    ReleaseVariables(pVariables);
+
+    return hr;
 }
 
 /********************************************************************
@@ -35,8 +139,30 @@ extern "C" void DAPI VarDestroy(
     __in_opt PFN_FREEVARIABLECONTEXT vpfFreeVariableContext
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(vpfFreeVariableContext);
+    VARIABLES_STRUCT* pVariablesStruct = static_cast<VARIABLES_STRUCT*>(pVariables);
+
+    if (!pVariablesStruct)
+    {
+        return;
+    }
+
+    for (DWORD i = 0; i < pVariablesStruct->cVariables; ++i)
+    {
+        VARIABLE_ENTRY* pVariable = pVariablesStruct->rgVariables + i;
+
+        if (vpfFreeVariableContext && pVariable->value.pvContext)
+        {
+            vpfFreeVariableContext(pVariable->value.pvContext);
+        }
+
+        UninitializeValue(&pVariable->value);
+        ReleaseStr(pVariable->sczName);
+    }
+
+    ReleaseMem(pVariablesStruct->rgVariables);
+    ReleaseDict(pVariablesStruct->sdVariables);
+    ::DeleteCriticalSection(&pVariablesStruct->csAccess);
+    MemFree(pVariablesStruct);
 }
 
 /********************************************************************
@@ -46,7 +172,11 @@ extern "C" void DAPI VarFreeValue(
     __in VARIABLE_VALUE* pValue
     )
 {
-    UNREFERENCED_PARAMETER(pValue);
+    if (pValue)
+    {
+        UninitializeValue(pValue);
+        MemFree(pValue);
+    }
 }
 
 /********************************************************************
@@ -58,13 +188,49 @@ extern "C" HRESULT DAPI VarEscapeString(
     __out_z LPWSTR* psczOut
     )
 {
-    UNREFERENCED_PARAMETER(wzIn);
-    UNREFERENCED_PARAMETER(psczOut);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    LPCWSTR wzRead = NULL;
+    LPWSTR wzWrite = NULL;
+    DWORD cchEscaped = 0;
+
+    ExitOnNull(wzIn, hr, E_INVALIDARG, "String to escape not specified.");
+
+    // Every special character becomes a four character escape sequence, so size the output once.
+    for (wzRead = wzIn; *wzRead; ++wzRead)
+    {
+        cchEscaped += (L'[' == *wzRead || L']' == *wzRead || L'{' == *wzRead || L'}' == *wzRead) ? 4 : 1;
+    }
+
+    hr = StrAlloc(psczOut, static_cast<DWORD_PTR>(cchEscaped) + 1);
+    ExitOnFailure(hr, "Failed to allocate buffer for escaped string.");
+
+    wzWrite = *psczOut;
+    for (wzRead = wzIn; *wzRead; ++wzRead)
+    {
+        if (L'[' == *wzRead || L']' == *wzRead || L'{' == *wzRead || L'}' == *wzRead)
+        {
+            *wzWrite++ = L'[';
+            *wzWrite++ = L'\\';
+            *wzWrite++ = *wzRead;
+            *wzWrite++ = L']';
+        }
+        else
+        {
+            *wzWrite++ = *wzRead;
+        }
+    }
+    *wzWrite = L'\0';
+
+LExit:
+    return hr;
 }
 
 /********************************************************************
 VarFormatString - similar to MsiFormatRecord.
+
+NOTE: [name] expands to the variable's formatted value or to nothing
+      if the variable does not exist, [\c] expands to the character c,
+      and [] or an unterminated [ are copied literally.
 ********************************************************************/
 extern "C" HRESULT DAPI VarFormatString(
     __in C_VARIABLES_HANDLE pVariables,
@@ -73,11 +239,37 @@ extern "C" HRESULT DAPI VarFormatString(
     __out_opt DWORD* pcchOut
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzIn);
-    UNREFERENCED_PARAMETER(psczOut);
-    UNREFERENCED_PARAMETER(pcchOut);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = const_cast<VARIABLES_STRUCT*>(static_cast<const VARIABLES_STRUCT*>(pVariables));
+    VARIABLE_FORMAT_BUFFER buffer = { };
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while formatting string.");
+    ExitOnNull(wzIn, hr, E_INVALIDARG, "String not specified while formatting string.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    hr = FormatString(pVariablesStruct, wzIn, 0, &buffer);
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    ExitOnFailure(hr, "Failed to format string.");
+
+    if (psczOut)
+    {
+        ReleaseStr(*psczOut);
+        *psczOut = buffer.scz;
+        buffer.scz = NULL;
+    }
+
+    if (pcchOut)
+    {
+        *pcchOut = buffer.cch;
+    }
+
+LExit:
+    ReleaseStr(buffer.scz);
+
+    return hr;
 }
 
 /********************************************************************
@@ -89,10 +281,39 @@ extern "C" HRESULT DAPI VarGetFormatted(
     __out_z LPWSTR* psczValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(psczValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = const_cast<VARIABLES_STRUCT*>(static_cast<const VARIABLES_STRUCT*>(pVariables));
+    VARIABLE_FORMAT_BUFFER buffer = { };
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while getting formatted value.");
+    ExitOnNull(wzVariable, hr, E_INVALIDARG, "Variable name not specified while getting formatted value.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    hr = FormatVariable(pVariablesStruct, wzVariable, 0, &buffer);
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get formatted value of variable: %ls", wzVariable);
+
+    if (!buffer.scz)
+    {
+        hr = StrAllocString(&buffer.scz, L"", 0);
+        ExitOnFailure(hr, "Failed to allocate empty formatted value.");
+    }
+
+    ReleaseStr(*psczValue);
+    *psczValue = buffer.scz;
+    buffer.scz = NULL;
+
+LExit:
+    ReleaseStr(buffer.scz);
+
+    return hr;
 }
 
 /********************************************************************
@@ -106,10 +327,30 @@ extern "C" HRESULT DAPI VarGetNumeric(
     __out LONGLONG* pllValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(pllValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = const_cast<VARIABLES_STRUCT*>(static_cast<const VARIABLES_STRUCT*>(pVariables));
+    VARIABLE_ENTRY* pVariable = NULL;
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while getting numeric value.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    hr = GetVariableWithValue(pVariablesStruct, wzVariable, &pVariable);
+    if (SUCCEEDED(hr))
+    {
+        hr = ValueGetNumeric(&pVariable->value, pllValue);
+    }
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get value as numeric for variable: %ls", wzVariable);
+
+LExit:
+    return hr;
 }
 
 /********************************************************************
@@ -123,10 +364,30 @@ extern "C" HRESULT DAPI VarGetString(
     __out_z LPWSTR* psczValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(psczValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = const_cast<VARIABLES_STRUCT*>(static_cast<const VARIABLES_STRUCT*>(pVariables));
+    VARIABLE_ENTRY* pVariable = NULL;
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while getting string value.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    hr = GetVariableWithValue(pVariablesStruct, wzVariable, &pVariable);
+    if (SUCCEEDED(hr))
+    {
+        hr = ValueGetString(&pVariable->value, psczValue);
+    }
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get value as string for variable: %ls", wzVariable);
+
+LExit:
+    return hr;
 }
 
 /********************************************************************
@@ -140,14 +401,37 @@ extern "C" HRESULT DAPI VarGetVersion(
     __in DWORD64* pqwValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(pqwValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = const_cast<VARIABLES_STRUCT*>(static_cast<const VARIABLES_STRUCT*>(pVariables));
+    VARIABLE_ENTRY* pVariable = NULL;
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while getting version value.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    hr = GetVariableWithValue(pVariablesStruct, wzVariable, &pVariable);
+    if (SUCCEEDED(hr))
+    {
+        hr = ValueGetVersion(&pVariable->value, pqwValue);
+    }
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get value as version for variable: %ls", wzVariable);
+
+LExit:
+    return hr;
 }
 
 /********************************************************************
 VarGetValue - gets the value of a variable along with its metadata.
+
+NOTE: the returned value is a copy and must be freed with VarFreeValue.
+      The context pointer is shared with the stored variable.
 ********************************************************************/
 extern "C" HRESULT DAPI VarGetValue(
     __in C_VARIABLES_HANDLE pVariables,
@@ -155,10 +439,39 @@ extern "C" HRESULT DAPI VarGetValue(
     __out VARIABLE_VALUE** ppValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(ppValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = const_cast<VARIABLES_STRUCT*>(static_cast<const VARIABLES_STRUCT*>(pVariables));
+    VARIABLE_ENTRY* pVariable = NULL;
+    VARIABLE_VALUE* pValue = NULL;
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while getting value.");
+
+    pValue = static_cast<VARIABLE_VALUE*>(MemAlloc(sizeof(VARIABLE_VALUE), TRUE));
+    ExitOnNull(pValue, hr, E_OUTOFMEMORY, "Failed to allocate variable value.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    hr = FindVariable(pVariablesStruct, wzVariable, &pVariable);
+    if (SUCCEEDED(hr))
+    {
+        hr = CopyValue(&pVariable->value, pValue);
+    }
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to copy value of variable: %ls", wzVariable);
+
+    *ppValue = pValue;
+    pValue = NULL;
+
+LExit:
+    ReleaseVariableValue(pValue);
+
+    return hr;
 }
 
 /********************************************************************
@@ -172,10 +485,12 @@ extern "C" HRESULT DAPI VarSetNumeric(
     __in LONGLONG llValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(llValue);
-    return E_NOTIMPL;
+    VARIABLE_VALUE value = { };
+
+    value.type = VARIABLE_VALUE_TYPE_NUMERIC;
+    value.llValue = llValue;
+
+    return SetVariableValue(static_cast<VARIABLES_STRUCT*>(pVariables), wzVariable, &value, FALSE);
 }
 
 /********************************************************************
@@ -189,10 +504,32 @@ extern "C" HRESULT DAPI VarSetString(
     __in_z_opt LPCWSTR wzValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(wzValue);
-    return E_NOTIMPL;
+    VARIABLE_VALUE value = { };
+
+    value.type = wzValue ? VARIABLE_VALUE_TYPE_STRING : VARIABLE_VALUE_TYPE_NONE;
+    value.sczValue = const_cast<LPWSTR>(wzValue);
+
+    return SetVariableValue(static_cast<VARIABLES_STRUCT*>(pVariables), wzVariable, &value, FALSE);
+}
+
+/********************************************************************
+VarSetFormatted - sets the value of the variable to a string that is
+                  expanded with VarFormatString whenever the formatted
+                  value is requested, and adds the variable to the
+                  group if necessary.
+********************************************************************/
+extern "C" HRESULT DAPI VarSetFormatted(
+    __in VARIABLES_HANDLE pVariables,
+    __in_z LPCWSTR wzVariable,
+    __in_z_opt LPCWSTR wzValue
+    )
+{
+    VARIABLE_VALUE value = { };
+
+    value.type = wzValue ? VARIABLE_VALUE_TYPE_FORMATTED : VARIABLE_VALUE_TYPE_NONE;
+    value.sczValue = const_cast<LPWSTR>(wzValue);
+
+    return SetVariableValue(static_cast<VARIABLES_STRUCT*>(pVariables), wzVariable, &value, FALSE);
 }
 
 /********************************************************************
@@ -206,15 +543,20 @@ extern "C" HRESULT DAPI VarSetVersion(
     __in DWORD64 qwValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(qwValue);
-    return E_NOTIMPL;
+    VARIABLE_VALUE value = { };
+
+    value.type = VARIABLE_VALUE_TYPE_VERSION;
+    value.qwValue = qwValue;
+
+    return SetVariableValue(static_cast<VARIABLES_STRUCT*>(pVariables), wzVariable, &value, FALSE);
 }
 
 /********************************************************************
 VarSetValue - sets the value of the variable along with its metadata.
               Also adds the variable to the group if necessary.
+
+NOTE: the caller remains responsible for any context the new value
+      replaces.
 ********************************************************************/
 extern "C" HRESULT DAPI VarSetValue(
     __in VARIABLES_HANDLE pVariables,
@@ -222,15 +564,19 @@ extern "C" HRESULT DAPI VarSetValue(
     __in VARIABLE_VALUE* pValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(wzVariable);
-    UNREFERENCED_PARAMETER(pValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+
+    ExitOnNull(pValue, hr, E_INVALIDARG, "Value not specified while setting variable.");
+
+    hr = SetVariableValue(static_cast<VARIABLES_STRUCT*>(pVariables), wzVariable, pValue, TRUE);
+
+LExit:
+    return hr;
 }
 
 /********************************************************************
-VarStartEnum - starts the enumeration of the variable group.  There
-               is no guarantee for the order of the variable enumeration.
+VarStartEnum - starts the enumeration of the variable group.  Variables
+               are enumerated in the order they were first added.
 
 NOTE: caller is responsible for calling VarFinishEnum even if function fails
 ********************************************************************/
@@ -240,10 +586,33 @@ extern "C" HRESULT DAPI VarStartEnum(
     __out VARIABLE_VALUE** ppValue
     )
 {
-    UNREFERENCED_PARAMETER(pVariables);
-    UNREFERENCED_PARAMETER(ppEnum);
-    UNREFERENCED_PARAMETER(ppValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLES_STRUCT* pVariablesStruct = static_cast<VARIABLES_STRUCT*>(pVariables);
+    VARIABLE_ENUM_STRUCT* pEnum = NULL;
+
+    ExitOnNull(pVariablesStruct, hr, E_INVALIDARG, "Variables not specified while starting enumeration.");
+    ExitOnNull(ppEnum, hr, E_INVALIDARG, "Enum handle not specified while starting enumeration.");
+
+    pEnum = static_cast<VARIABLE_ENUM_STRUCT*>(MemAlloc(sizeof(VARIABLE_ENUM_STRUCT), TRUE));
+    ExitOnNull(pEnum, hr, E_OUTOFMEMORY, "Failed to allocate variable enumeration.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+    pEnum->pVariables = pVariablesStruct;
+    pEnum->iVariable = 0;
+    pEnum->dwGeneration = pVariablesStruct->dwGeneration;
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    *ppEnum = pEnum;
+
+    hr = VarNextVariable(pEnum, ppValue);
+    if (E_NOMOREITEMS == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get first variable.");
+
+LExit:
+    return hr;
 }
 
 /********************************************************************
@@ -258,9 +627,51 @@ extern "C" HRESULT DAPI VarNextVariable(
     __out VARIABLE_VALUE** ppValue
     )
 {
-    UNREFERENCED_PARAMETER(pEnum);
-    UNREFERENCED_PARAMETER(ppValue);
-    return E_NOTIMPL;
+    HRESULT hr = S_OK;
+    VARIABLE_ENUM_STRUCT* pEnumStruct = static_cast<VARIABLE_ENUM_STRUCT*>(pEnum);
+    VARIABLES_STRUCT* pVariablesStruct = NULL;
+    VARIABLE_VALUE* pValue = NULL;
+
+    ExitOnNull(pEnumStruct, hr, E_INVALIDARG, "Enum handle not specified while enumerating variables.");
+    pVariablesStruct = pEnumStruct->pVariables;
+
+    pValue = static_cast<VARIABLE_VALUE*>(MemAlloc(sizeof(VARIABLE_VALUE), TRUE));
+    ExitOnNull(pValue, hr, E_OUTOFMEMORY, "Failed to allocate variable value.");
+
+    ::EnterCriticalSection(&pVariablesStruct->csAccess);
+
+    if (pEnumStruct->dwGeneration != pVariablesStruct->dwGeneration)
+    {
+        hr = E_INVALIDSTATE;
+    }
+    else if (pEnumStruct->iVariable >= pVariablesStruct->cVariables)
+    {
+        hr = E_NOMOREITEMS;
+    }
+    else
+    {
+        hr = CopyValue(&pVariablesStruct->rgVariables[pEnumStruct->iVariable].value, pValue);
+        if (SUCCEEDED(hr))
+        {
+            ++pEnumStruct->iVariable;
+        }
+    }
+
+    ::LeaveCriticalSection(&pVariablesStruct->csAccess);
+
+    if (E_NOMOREITEMS == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get next variable, the variables may have changed during enumeration.");
+
+    *ppValue = pValue;
+    pValue = NULL;
+
+LExit:
+    ReleaseVariableValue(pValue);
+
+    return hr;
 }
 
 /********************************************************************
@@ -270,5 +681,414 @@ extern "C" void DAPI VarFinishEnum(
     __in_bcount(VARIABLE_ENUM_HANDLE_BYTES) VARIABLE_ENUM_HANDLE pEnum
     )
 {
-    UNREFERENCED_PARAMETER(pEnum);
+    ReleaseMem(pEnum);
+}
+
+// Static functions
+
+static HRESULT FindVariable(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __out VARIABLE_ENTRY** ppVariable
+    )
+{
+    HRESULT hr = S_OK;
+
+    ExitOnNull(wzVariable, hr, E_INVALIDARG, "Variable name not specified.");
+
+    hr = DictGetValue(pVariables->sdVariables, wzVariable, reinterpret_cast<void**>(ppVariable));
+
+LExit:
+    return hr;
+}
+
+static HRESULT GetVariableWithValue(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __out VARIABLE_ENTRY** ppVariable
+    )
+{
+    HRESULT hr = FindVariable(pVariables, wzVariable, ppVariable);
+
+    // A variable that was explicitly set to nothing is indistinguishable from a missing one.
+    if (SUCCEEDED(hr) && VARIABLE_VALUE_TYPE_NONE == (*ppVariable)->value.type)
+    {
+        hr = E_NOTFOUND;
+    }
+
+    return hr;
+}
+
+static HRESULT SetVariableValue(
+    __in VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __in const VARIABLE_VALUE* pValue,
+    __in BOOL fSetMetadata
+    )
+{
+    HRESULT hr = S_OK;
+    BOOL fLocked = FALSE;
+    VARIABLE_ENTRY* pVariable = NULL;
+    VARIABLE_VALUE newValue = { };
+
+    ExitOnNull(pVariables, hr, E_INVALIDARG, "Variables not specified while setting variable.");
+    ExitOnNull(wzVariable, hr, E_INVALIDARG, "Variable name not specified while setting variable.");
+    ExitOnNull(*wzVariable, hr, E_INVALIDARG, "Variable name cannot be empty.");
+
+    hr = CopyValue(pValue, &newValue);
+    ExitOnFailure(hr, "Failed to copy new value of variable: %ls", wzVariable);
+
+    ::EnterCriticalSection(&pVariables->csAccess);
+    fLocked = TRUE;
+
+    hr = FindVariable(pVariables, wzVariable, &pVariable);
+    if (E_NOTFOUND == hr)
+    {
+        hr = MemEnsureArraySize(reinterpret_cast<void**>(&pVariables->rgVariables), pVariables->cVariables + 1, sizeof(VARIABLE_ENTRY), VARIABLE_GROW_COUNT);
+        ExitOnFailure(hr, "Failed to grow variable array.");
+
+        pVariable = pVariables->rgVariables + pVariables->cVariables;
+        memset(pVariable, 0, sizeof(VARIABLE_ENTRY));
+
+        hr = StrAllocString(&pVariable->sczName, wzVariable, 0);
+        ExitOnFailure(hr, "Failed to copy variable name: %ls", wzVariable);
+
+        hr = DictAddValue(pVariables->sdVariables, pVariable);
+        if (FAILED(hr))
+        {
+            ReleaseNullStr(pVariable->sczName);
+        }
+        ExitOnFailure(hr, "Failed to index variable: %ls", wzVariable);
+
+        ++pVariables->cVariables;
+        ++pVariables->dwGeneration;
+    }
+    ExitOnFailure(hr, "Failed to find variable: %ls", wzVariable);
+
+    if (!fSetMetadata)
+    {
+        newValue.fHidden = pVariable->value.fHidden;
+        newValue.pvContext = pVariable->value.pvContext;
+    }
+
+    UninitializeValue(&pVariable->value);
+    pVariable->value = newValue;
+    memset(&newValue, 0, sizeof(newValue));
+
+LExit:
+    if (fLocked)
+    {
+        ::LeaveCriticalSection(&pVariables->csAccess);
+    }
+
+    UninitializeValue(&newValue);
+
+    return hr;
+}
+
+static HRESULT CopyValue(
+    __in const VARIABLE_VALUE* pSource,
+    __in VARIABLE_VALUE* pTarget
+    )
+{
+    HRESULT hr = S_OK;
+
+    // Copy the whole union so values of type none round-trip unchanged.
+    memcpy(pTarget, pSource, sizeof(VARIABLE_VALUE));
+
+    if (VARIABLE_VALUE_TYPE_STRING == pSource->type || VARIABLE_VALUE_TYPE_FORMATTED == pSource->type)
+    {
+        pTarget->sczValue = NULL;
+
+        if (pSource->sczValue)
+        {
+            hr = StrAllocString(&pTarget->sczValue, pSource->sczValue, 0);
+            ExitOnFailure(hr, "Failed to copy string value.");
+        }
+    }
+
+LExit:
+    return hr;
+}
+
+static void UninitializeValue(
+    __in VARIABLE_VALUE* pValue
+    )
+{
+    if (VARIABLE_VALUE_TYPE_STRING == pValue->type || VARIABLE_VALUE_TYPE_FORMATTED == pValue->type)
+    {
+        ReleaseNullStr(pValue->sczValue);
+    }
+
+    pValue->type = VARIABLE_VALUE_TYPE_NONE;
+}
+
+static HRESULT ValueGetNumeric(
+    __in const VARIABLE_VALUE* pValue,
+    __out LONGLONG* pllValue
+    )
+{
+    HRESULT hr = S_OK;
+
+    switch (pValue->type)
+    {
+    case VARIABLE_VALUE_TYPE_NUMERIC:
+        *pllValue = pValue->llValue;
+        break;
+    case VARIABLE_VALUE_TYPE_STRING: __fallthrough;
+    case VARIABLE_VALUE_TYPE_FORMATTED:
+        hr = StrStringToInt64(pValue->sczValue, 0, pllValue);
+        if (FAILED(hr))
+        {
+            hr = DISP_E_TYPEMISMATCH;
+        }
+        break;
+    case VARIABLE_VALUE_TYPE_VERSION:
+        *pllValue = static_cast<LONGLONG>(pValue->qwValue);
+        break;
+    default:
+        hr = E_INVALIDARG;
+        break;
+    }
+
+    return hr;
+}
+
+static HRESULT ValueGetString(
+    __in const VARIABLE_VALUE* pValue,
+    __out_z LPWSTR* psczValue
+    )
+{
+    HRESULT hr = S_OK;
+
+    switch (pValue->type)
+    {
+    case VARIABLE_VALUE_TYPE_NUMERIC:
+        hr = StrAllocFormatted(psczValue, L"%I64d", pValue->llValue);
+        ExitOnFailure(hr, "Failed to convert int64 to string.");
+        break;
+    case VARIABLE_VALUE_TYPE_STRING: __fallthrough;
+    case VARIABLE_VALUE_TYPE_FORMATTED:
+        hr = StrAllocString(psczValue, pValue->sczValue, 0);
+        ExitOnFailure(hr, "Failed to copy string value.");
+        break;
+    case VARIABLE_VALUE_TYPE_VERSION:
+        hr = StrAllocFormatted(psczValue, L"%hu.%hu.%hu.%hu",
+            (WORD)(pValue->qwValue >> 48),
+            (WORD)(pValue->qwValue >> 32),
+            (WORD)(pValue->qwValue >> 16),
+            (WORD)pValue->qwValue);
+        ExitOnFailure(hr, "Failed to convert version to string.");
+        break;
+    default:
+        hr = E_INVALIDARG;
+        break;
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT ValueGetVersion(
+    __in const VARIABLE_VALUE* pValue,
+    __out DWORD64* pqwValue
+    )
+{
+    HRESULT hr = S_OK;
+
+    switch (pValue->type)
+    {
+    case VARIABLE_VALUE_TYPE_NUMERIC:
+        *pqwValue = static_cast<DWORD64>(pValue->llValue);
+        break;
+    case VARIABLE_VALUE_TYPE_STRING: __fallthrough;
+    case VARIABLE_VALUE_TYPE_FORMATTED:
+        hr = FileVersionFromStringEx(pValue->sczValue, 0, pqwValue);
+        if (FAILED(hr))
+        {
+            hr = DISP_E_TYPEMISMATCH;
+        }
+        break;
+    case VARIABLE_VALUE_TYPE_VERSION:
+        *pqwValue = pValue->qwValue;
+        break;
+    default:
+        hr = E_INVALIDARG;
+        break;
+    }
+
+    return hr;
+}
+
+// Expands wzIn into pBuffer in a single left-to-right pass. Must be called with the lock held.
+static HRESULT FormatString(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzIn,
+    __in DWORD dwDepth,
+    __inout VARIABLE_FORMAT_BUFFER* pBuffer
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzRead = wzIn;
+    LPCWSTR wzOpen = NULL;
+    LPCWSTR wzClose = NULL;
+    LPWSTR sczName = NULL;
+    DWORD cchName = 0;
+
+    if (VARIABLE_FORMAT_MAX_DEPTH < dwDepth)
+    {
+        hr = E_INVALIDDATA;
+        ExitOnRootFailure(hr, "Variable references are nested too deeply, a variable may reference itself.");
+    }
+
+    for (;;)
+    {
+        wzOpen = wcschr(wzRead, L'[');
+        wzClose = wzOpen ? wcschr(wzOpen + 1, L']') : NULL;
+
+        if (!wzClose)
+        {
+            // No more expanders, an unterminated one is treated as literal text.
+            hr = AppendFormatBuffer(pBuffer, wzRead, lstrlenW(wzRead));
+            ExitOnFailure(hr, "Failed to append string.");
+            break;
+        }
+
+        cchName = static_cast<DWORD>(wzClose - wzOpen - 1);
+
+        if (0 == cchName)
+        {
+            // [] is copied as is.
+            hr = AppendFormatBuffer(pBuffer, wzRead, static_cast<DWORD>(wzClose - wzRead) + 1);
+            ExitOnFailure(hr, "Failed to append string.");
+        }
+        else
+        {
+            hr = AppendFormatBuffer(pBuffer, wzRead, static_cast<DWORD>(wzOpen - wzRead));
+            ExitOnFailure(hr, "Failed to append string.");
+
+            if (2 <= cchName && L'\\' == wzOpen[1])
+            {
+                // Escape sequence, copy the character.
+                hr = AppendFormatBuffer(pBuffer, wzOpen + 2, 1);
+                ExitOnFailure(hr, "Failed to append escaped character.");
+            }
+            else
+            {
+                hr = StrAllocString(&sczName, wzOpen + 1, cchName);
+                ExitOnFailure(hr, "Failed to get variable name.");
+
+                hr = FormatVariable(pVariables, sczName, dwDepth, pBuffer);
+                if (E_NOTFOUND == hr)
+                {
+                    // Missing variables expand to nothing.
+                    hr = S_OK;
+                }
+                ExitOnFailure(hr, "Failed to format variable: %ls", sczName);
+            }
+        }
+
+        wzRead = wzClose + 1;
+    }
+
+    // Make sure an empty result is still a valid string.
+    hr = AppendFormatBuffer(pBuffer, L"", 0);
+    ExitOnFailure(hr, "Failed to terminate formatted string.");
+
+LExit:
+    ReleaseStr(sczName);
+
+    return hr;
+}
+
+// Appends the formatted value of a variable to pBuffer. Must be called with the lock held.
+static HRESULT FormatVariable(
+    __in const VARIABLES_STRUCT* pVariables,
+    __in_z LPCWSTR wzVariable,
+    __in DWORD dwDepth,
+    __inout VARIABLE_FORMAT_BUFFER* pBuffer
+    )
+{
+    HRESULT hr = S_OK;
+    VARIABLE_ENTRY* pVariable = NULL;
+    WCHAR wzNumber[24] = { };
+    const VARIABLE_VALUE* pValue = NULL;
+
+    hr = GetVariableWithValue(pVariables, wzVariable, &pVariable);
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction();
+    }
+    ExitOnFailure(hr, "Failed to get variable: %ls", wzVariable);
+
+    pValue = &pVariable->value;
+
+    switch (pValue->type)
+    {
+    case VARIABLE_VALUE_TYPE_NUMERIC:
+        hr = ::StringCchPrintfW(wzNumber, countof(wzNumber), L"%I64d", pValue->llValue);
+        ExitOnFailure(hr, "Failed to convert int64 to string.");
+
+        hr = AppendFormatBuffer(pBuffer, wzNumber, lstrlenW(wzNumber));
+        break;
+    case VARIABLE_VALUE_TYPE_VERSION:
+        hr = ::StringCchPrintfW(wzNumber, countof(wzNumber), L"%hu.%hu.%hu.%hu",
+            (WORD)(pValue->qwValue >> 48),
+            (WORD)(pValue->qwValue >> 32),
+            (WORD)(pValue->qwValue >> 16),
+            (WORD)pValue->qwValue);
+        ExitOnFailure(hr, "Failed to convert version to string.");
+
+        hr = AppendFormatBuffer(pBuffer, wzNumber, lstrlenW(wzNumber));
+        break;
+    case VARIABLE_VALUE_TYPE_STRING:
+        hr = AppendFormatBuffer(pBuffer, pValue->sczValue, lstrlenW(pValue->sczValue));
+        break;
+    case VARIABLE_VALUE_TYPE_FORMATTED:
+        hr = FormatString(pVariables, pValue->sczValue, dwDepth + 1, pBuffer);
+        break;
+    default:
+        hr = E_INVALIDARG;
+        break;
+    }
+    ExitOnFailure(hr, "Failed to append value of variable: %ls", wzVariable);
+
+LExit:
+    return hr;
+}
+
+static HRESULT AppendFormatBuffer(
+    __inout VARIABLE_FORMAT_BUFFER* pBuffer,
+    __in_ecount(cch) LPCWSTR wz,
+    __in DWORD cch
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD cchRequired = 0;
+    DWORD cchCapacity = 0;
+
+    hr = ::DWordAdd(pBuffer->cch, cch, &cchRequired);
+    ExitOnFailure(hr, "Overflow while calculating formatted string length.");
+
+    hr = ::DWordAdd(cchRequired, 1, &cchRequired);
+    ExitOnFailure(hr, "Overflow while calculating formatted string length.");
+
+    if (cchRequired > pBuffer->cchCapacity)
+    {
+        // Grow geometrically so formatting stays linear in the output length.
+        cchCapacity = max(cchRequired, pBuffer->cchCapacity * 2);
+        cchCapacity = max(cchCapacity, 64);
+
+        hr = StrAlloc(&pBuffer->scz, cchCapacity);
+        ExitOnFailure(hr, "Failed to grow formatted string.");
+
+        pBuffer->cchCapacity = cchCapacity;
+    }
+
+    memcpy(pBuffer->scz + pBuffer->cch, wz, sizeof(WCHAR) * cch);
+    pBuffer->cch += cch;
+    pBuffer->scz[pBuffer->cch] = L'\0';
+
+LExit:
+    return hr;
 }
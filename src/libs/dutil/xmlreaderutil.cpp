@@ -0,0 +1,1267 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+const DWORD XML_READER_STACK_INCREMENT = 16;
+const DWORD XML_READER_ATTRIBUTE_INCREMENT = 16;
+const DWORD XML_READER_COMPILE_STRING_INCREMENT = 256;
+
+// A string already in the compiled string table, indexed by its value.
+typedef struct _XML_READER_COMPILE_STRING
+{
+    LPCWSTR wzValue;
+    DWORD iString;
+} XML_READER_COMPILE_STRING;
+
+// Prototypes
+static HRESULT ReadStartTag(
+    __in XML_READER* pReader
+    );
+static HRESULT ReadEndTag(
+    __in XML_READER* pReader
+    );
+static HRESULT ReadMarkup(
+    __in XML_READER* pReader,
+    __out BOOL* pfText
+    );
+static HRESULT ReadCompiledNode(
+    __in XML_READER* pReader
+    );
+static HRESULT CompileString(
+    __in STRINGDICT_HANDLE sdStrings,
+    __inout XML_READER_COMPILE_STRING** prgStrings,
+    __inout DWORD* pcStrings,
+    __in BUFF_WRITER* pStringTable,
+    __in_z LPCWSTR wzValue,
+    __out DWORD* piString
+    );
+static HRESULT WriteRecord(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cbRecord) const void* pvRecord,
+    __in SIZE_T cbRecord
+    );
+static HRESULT DecodeInPlace(
+    __in LPWSTR wzStart,
+    __in LPCWSTR wzEnd,
+    __in BOOL fAttribute
+    );
+static HRESULT DecodeCharacterReference(
+    __in_ecount(cchReference) LPCWSTR wzReference,
+    __in DWORD cchReference,
+    __inout LPWSTR* ppwzWrite
+    );
+static HRESULT SkipPast(
+    __inout LPWSTR* ppwz,
+    __in_z LPCWSTR wzTerminator
+    );
+static LPWSTR SkipWhitespace(
+    __in_z LPWSTR wz
+    );
+static BOOL IsWhitespace(
+    __in WCHAR wch
+    );
+static BOOL IsNameChar(
+    __in WCHAR wch
+    );
+
+
+DAPI_(HRESULT) XmlReaderInitialize(
+    __in_z LPCWSTR wzXml,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+
+    memset(pReader, 0, sizeof(XML_READER));
+
+    hr = StrAllocString(&pReader->sczXml, wzXml, 0);
+    ExitOnFailure(hr, "Failed to allocate xml string.");
+
+    pReader->pwz = pReader->sczXml;
+
+LExit:
+    return hr;
+}
+
+
+DAPI_(HRESULT) XmlReaderInitializeFromBuffer(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    int cchXml = 0;
+
+    memset(pReader, 0, sizeof(XML_READER));
+
+    if (INT_MAX < cbBuffer)
+    {
+        ExitOnFailure(hr = E_INVALIDARG, "Xml buffer is too large: %Iu bytes.", cbBuffer);
+    }
+
+    if (2 <= cbBuffer && 0xFF == pbBuffer[0] && 0xFE == pbBuffer[1])
+    {
+        // UTF-16 with a byte order mark can be used as is.
+        cchXml = static_cast<int>((cbBuffer - 2) / sizeof(WCHAR));
+
+        hr = StrAlloc(&pReader->sczXml, cchXml + 1);
+        ExitOnFailure(hr, "Failed to allocate xml string.");
+
+        memcpy(pReader->sczXml, pbBuffer + 2, cchXml * sizeof(WCHAR));
+    }
+    else
+    {
+        // Anything else must be UTF-8, optionally with a byte order mark.
+        if (3 <= cbBuffer && 0xEF == pbBuffer[0] && 0xBB == pbBuffer[1] && 0xBF == pbBuffer[2])
+        {
+            pbBuffer += 3;
+            cbBuffer -= 3;
+        }
+
+        if (cbBuffer)
+        {
+            cchXml = ::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, reinterpret_cast<LPCSTR>(pbBuffer), static_cast<int>(cbBuffer), NULL, 0);
+            if (!cchXml)
+            {
+                ExitWithLastError(hr, "Failed to get length of xml buffer as unicode.");
+            }
+        }
+
+        hr = StrAlloc(&pReader->sczXml, cchXml + 1);
+        ExitOnFailure(hr, "Failed to allocate xml string.");
+
+        if (cchXml && !::MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, reinterpret_cast<LPCSTR>(pbBuffer), static_cast<int>(cbBuffer), pReader->sczXml, cchXml))
+        {
+            ExitWithLastError(hr, "Failed to convert xml buffer to unicode.");
+        }
+    }
+
+    pReader->sczXml[cchXml] = L'\0';
+    pReader->pwz = pReader->sczXml;
+
+LExit:
+    return hr;
+}
+
+
+DAPI_(HRESULT) XmlReaderInitializeFromFile(
+    __in_z LPCWSTR wzPath,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    BYTE* pbFile = NULL;
+    DWORD cbFile = 0;
+
+    hr = FileRead(&pbFile, &cbFile, wzPath);
+    ExitOnFailure(hr, "Failed to read xml file: %ls", wzPath);
+
+    hr = XmlReaderInitializeFromBuffer(pbFile, cbFile, pReader);
+    ExitOnFailure(hr, "Failed to initialize reader for xml file: %ls", wzPath);
+
+LExit:
+    ReleaseMem(pbFile);
+
+    return hr;
+}
+
+
+DAPI_(BOOL) XmlReaderIsCompiled(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer
+    )
+{
+    return sizeof(XML_READER_COMPILED_HEADER) <= cbBuffer && XML_READER_COMPILED_SIGNATURE == reinterpret_cast<const XML_READER_COMPILED_HEADER*>(pbBuffer)->dwSignature;
+}
+
+
+/********************************************************************
+ XmlReaderInitializeFromCompiled - reads a document produced by
+                                   XmlReaderCompile.
+
+ NOTE: Every record is validated here so reading the nodes afterwards
+       is nothing more than walking the arrays.
+********************************************************************/
+DAPI_(HRESULT) XmlReaderInitializeFromCompiled(
+    __in_bcount(cbBuffer) const BYTE* pbBuffer,
+    __in SIZE_T cbBuffer,
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    const XML_READER_COMPILED_HEADER* pHeader = reinterpret_cast<const XML_READER_COMPILED_HEADER*>(pbBuffer);
+    const XML_READER_COMPILED_NODE* pNode = NULL;
+    const XML_READER_COMPILED_ATTRIBUTE* pAttribute = NULL;
+    DWORD64 cbExpected = 0;
+    DWORD cElements = 0;
+    BOOL fDocumentElement = FALSE;
+
+    memset(pReader, 0, sizeof(XML_READER));
+
+    if (!XmlReaderIsCompiled(pbBuffer, cbBuffer))
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Buffer is not a compiled xml document.");
+    }
+    else if (XML_READER_COMPILED_VERSION != pHeader->dwVersion)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Unsupported compiled xml document version: %u", pHeader->dwVersion);
+    }
+
+    cbExpected = sizeof(XML_READER_COMPILED_HEADER) + static_cast<DWORD64>(pHeader->cNodes) * sizeof(XML_READER_COMPILED_NODE) + static_cast<DWORD64>(pHeader->cAttributes) * sizeof(XML_READER_COMPILED_ATTRIBUTE) + static_cast<DWORD64>(pHeader->cchStrings) * sizeof(WCHAR);
+    if (cbExpected != cbBuffer || !pHeader->cchStrings)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml document is corrupt, expected %I64u bytes but found %Iu.", cbExpected, cbBuffer);
+    }
+
+    // Keep a copy so the records are aligned and the caller's buffer can go away.
+    pReader->pbCompiled = static_cast<BYTE*>(MemAlloc(cbBuffer, FALSE));
+    ExitOnNull(pReader->pbCompiled, hr, E_OUTOFMEMORY, "Failed to allocate compiled xml document.");
+
+    memcpy(pReader->pbCompiled, pbBuffer, cbBuffer);
+
+    pHeader = reinterpret_cast<const XML_READER_COMPILED_HEADER*>(pReader->pbCompiled);
+    pReader->rgCompiledNodes = reinterpret_cast<const XML_READER_COMPILED_NODE*>(pHeader + 1);
+    pReader->cCompiledNodes = pHeader->cNodes;
+    pReader->rgCompiledAttributes = reinterpret_cast<const XML_READER_COMPILED_ATTRIBUTE*>(pReader->rgCompiledNodes + pHeader->cNodes);
+    pReader->wzCompiledStrings = reinterpret_cast<LPCWSTR>(pReader->rgCompiledAttributes + pHeader->cAttributes);
+
+    if (L'\0' != pReader->wzCompiledStrings[pHeader->cchStrings - 1])
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml string table is not terminated.");
+    }
+
+    for (DWORD i = 0; i < pHeader->cAttributes; ++i)
+    {
+        pAttribute = pReader->rgCompiledAttributes + i;
+        if (pHeader->cchStrings <= pAttribute->iName || pHeader->cchStrings <= pAttribute->iValue)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml attribute %u refers to a string outside of the string table.", i);
+        }
+    }
+
+    for (DWORD i = 0; i < pHeader->cNodes; ++i)
+    {
+        pNode = pReader->rgCompiledNodes + i;
+        if (pHeader->cchStrings <= pNode->iString)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml node %u refers to a string outside of the string table.", i);
+        }
+        else if (pHeader->cAttributes < pNode->iFirstAttribute || pHeader->cAttributes - pNode->iFirstAttribute < pNode->cAttributes)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml node %u refers to attributes outside of the attribute table.", i);
+        }
+
+        switch (pNode->node)
+        {
+        case XML_READER_NODE_ELEMENT:
+            if (!cElements && fDocumentElement)
+            {
+                ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml document has more than one document element.");
+            }
+
+            fDocumentElement = TRUE;
+            ++cElements;
+            break;
+
+        case XML_READER_NODE_END_ELEMENT:
+            if (!cElements)
+            {
+                ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml end element %u does not have an element.", i);
+            }
+
+            --cElements;
+            break;
+
+        case XML_READER_NODE_TEXT:
+            if (!cElements)
+            {
+                ExitOnFailure(hr = E_INVALIDDATA, "Text is not allowed outside of the compiled xml document element.");
+            }
+            break;
+
+        default:
+            ExitOnFailure(hr = E_INVALIDDATA, "Compiled xml node %u has an invalid type: %u", i, pNode->node);
+        }
+    }
+
+    if (cElements || !fDocumentElement)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Unexpected end of compiled xml document.");
+    }
+
+LExit:
+    return hr;
+}
+
+
+/********************************************************************
+ XmlReaderCompile - reads the rest of the document into the compiled
+                    form, storing each distinct string once.
+
+ NOTE: Free the compiled document with ReleaseMem.
+********************************************************************/
+DAPI_(HRESULT) XmlReaderCompile(
+    __in XML_READER* pReader,
+    __deref_out_bcount(*pcbCompiled) BYTE** ppbCompiled,
+    __out SIZE_T* pcbCompiled
+    )
+{
+    HRESULT hr = S_OK;
+    STRINGDICT_HANDLE sdStrings = NULL;
+    XML_READER_COMPILE_STRING* rgStrings = NULL;
+    DWORD cStrings = 0;
+    BUFF_WRITER nodes = { };
+    BUFF_WRITER attributes = { };
+    BUFF_WRITER strings = { };
+    XML_READER_NODE node = XML_READER_NODE_NONE;
+    XML_READER_COMPILED_HEADER header = { };
+    XML_READER_COMPILED_NODE compiledNode = { };
+    XML_READER_COMPILED_ATTRIBUTE compiledAttribute = { };
+    BYTE* pbCompiled = NULL;
+    SIZE_T cbCompiled = 0;
+    BYTE* pb = NULL;
+
+    hr = DictCreateWithEmbeddedKey(&sdStrings, 0, reinterpret_cast<void**>(&rgStrings), offsetof(XML_READER_COMPILE_STRING, wzValue), DICT_FLAG_NONE);
+    ExitOnFailure(hr, "Failed to create compiled xml string index.");
+
+    for (;;)
+    {
+        hr = XmlReaderRead(pReader, &node);
+        if (E_NOMOREITEMS == hr)
+        {
+            break;
+        }
+        ExitOnFailure(hr, "Failed to read xml node to compile.");
+
+        compiledNode.node = node;
+        compiledNode.iFirstAttribute = header.cAttributes;
+        compiledNode.cAttributes = 0;
+
+        hr = CompileString(sdStrings, &rgStrings, &cStrings, &strings, XML_READER_NODE_TEXT == node ? pReader->wzText : pReader->wzName, &compiledNode.iString);
+        ExitOnFailure(hr, "Failed to compile xml node string.");
+
+        if (XML_READER_NODE_ELEMENT == node)
+        {
+            for (DWORD i = 0; i < pReader->cAttributes; ++i)
+            {
+                hr = CompileString(sdStrings, &rgStrings, &cStrings, &strings, pReader->rgAttributes[i].wzName, &compiledAttribute.iName);
+                ExitOnFailure(hr, "Failed to compile xml attribute name.");
+
+                hr = CompileString(sdStrings, &rgStrings, &cStrings, &strings, pReader->rgAttributes[i].wzValue, &compiledAttribute.iValue);
+                ExitOnFailure(hr, "Failed to compile xml attribute value.");
+
+                hr = WriteRecord(&attributes, &compiledAttribute, sizeof(compiledAttribute));
+                ExitOnFailure(hr, "Failed to write compiled xml attribute.");
+
+                ++header.cAttributes;
+            }
+
+            compiledNode.cAttributes = pReader->cAttributes;
+        }
+
+        hr = WriteRecord(&nodes, &compiledNode, sizeof(compiledNode));
+        ExitOnFailure(hr, "Failed to write compiled xml node.");
+
+        ++header.cNodes;
+    }
+
+    header.dwSignature = XML_READER_COMPILED_SIGNATURE;
+    header.dwVersion = XML_READER_COMPILED_VERSION;
+    header.cchStrings = static_cast<DWORD>(strings.cbData / sizeof(WCHAR));
+
+    cbCompiled = sizeof(header) + nodes.cbData + attributes.cbData + strings.cbData;
+    pbCompiled = static_cast<BYTE*>(MemAlloc(cbCompiled, FALSE));
+    ExitOnNull(pbCompiled, hr, E_OUTOFMEMORY, "Failed to allocate compiled xml document.");
+
+    pb = pbCompiled;
+    memcpy(pb, &header, sizeof(header));
+    pb += sizeof(header);
+    if (nodes.cbData)
+    {
+        memcpy(pb, nodes.pbData, nodes.cbData);
+        pb += nodes.cbData;
+    }
+    if (attributes.cbData)
+    {
+        memcpy(pb, attributes.pbData, attributes.cbData);
+        pb += attributes.cbData;
+    }
+    if (strings.cbData)
+    {
+        memcpy(pb, strings.pbData, strings.cbData);
+    }
+
+    *ppbCompiled = pbCompiled;
+    pbCompiled = NULL;
+    *pcbCompiled = cbCompiled;
+    hr = S_OK;
+
+LExit:
+    ReleaseMem(pbCompiled);
+    BuffWriterUninitialize(&strings);
+    BuffWriterUninitialize(&attributes);
+    BuffWriterUninitialize(&nodes);
+    ReleaseDict(sdStrings);
+    ReleaseMem(rgStrings);
+
+    return hr;
+}
+
+
+DAPI_(void) XmlReaderUninitialize(
+    __in XML_READER* pReader
+    )
+{
+    ReleaseMem(pReader->pbCompiled);
+    ReleaseStr(pReader->sczXml);
+    ReleaseMem(pReader->rgAttributes);
+    ReleaseMem(pReader->rgwzElements);
+
+    memset(pReader, 0, sizeof(XML_READER));
+}
+
+
+/********************************************************************
+ XmlReaderRead - moves to the next element, end element or text node.
+
+ NOTE: Comments, processing instructions and whitespace-only text are
+       skipped. A self-closing element is reported as an element
+       followed by its end element. Returns E_NOMOREITEMS once the
+       document element has been closed.
+********************************************************************/
+DAPI_(HRESULT) XmlReaderRead(
+    __in XML_READER* pReader,
+    __out_opt XML_READER_NODE* pNode
+    )
+{
+    HRESULT hr = S_OK;
+    BOOL fText = FALSE;
+    LPWSTR wzTextEnd = NULL;
+    LPCWSTR wz = NULL;
+
+    pReader->wzText = NULL;
+
+    if (pReader->pbCompiled)
+    {
+        hr = ReadCompiledNode(pReader);
+        ExitFunction();
+    }
+
+    if (pReader->fEmptyElement)
+    {
+        pReader->fEmptyElement = FALSE;
+        pReader->node = XML_READER_NODE_END_ELEMENT;
+        pReader->dwDepth = pReader->cElements;
+        --pReader->cElements;
+
+        ExitFunction();
+    }
+
+    for (;;)
+    {
+        if (pReader->fTagPending || L'<' == *pReader->pwz)
+        {
+            pReader->fTagPending = FALSE;
+            ++pReader->pwz;
+
+            hr = ReadMarkup(pReader, &fText);
+            ExitOnFailure(hr, "Failed to read xml markup.");
+
+            if (XML_READER_NODE_NONE != pReader->node || fText)
+            {
+                break;
+            }
+        }
+        else if (L'\0' == *pReader->pwz)
+        {
+            if (pReader->cElements || !pReader->fDocumentElementRead)
+            {
+                ExitOnFailure(hr = E_INVALIDDATA, "Unexpected end of xml document.");
+            }
+
+            pReader->node = XML_READER_NODE_NONE;
+            ExitFunction1(hr = E_NOMOREITEMS);
+        }
+        else
+        {
+            wzTextEnd = wcschr(pReader->pwz, L'<');
+            if (!wzTextEnd)
+            {
+                wzTextEnd = pReader->pwz + lstrlenW(pReader->pwz);
+            }
+
+            for (wz = pReader->pwz; wz < wzTextEnd && IsWhitespace(*wz); ++wz)
+            {
+            }
+
+            if (wz == wzTextEnd)
+            {
+                pReader->pwz = wzTextEnd;
+                continue;
+            }
+            else if (!pReader->cElements)
+            {
+                ExitOnFailure(hr = E_INVALIDDATA, "Text is not allowed outside of the xml document element.");
+            }
+
+            pReader->fTagPending = (L'<' == *wzTextEnd);
+
+            hr = DecodeInPlace(pReader->pwz, wzTextEnd, FALSE);
+            ExitOnFailure(hr, "Failed to decode xml text.");
+
+            pReader->wzText = pReader->pwz;
+            pReader->pwz = wzTextEnd;
+            fText = TRUE;
+            break;
+        }
+    }
+
+    if (fText)
+    {
+        pReader->node = XML_READER_NODE_TEXT;
+        pReader->dwDepth = pReader->cElements + 1;
+    }
+
+LExit:
+    if (pNode)
+    {
+        *pNode = pReader->node;
+    }
+
+    return hr;
+}
+
+
+/********************************************************************
+ XmlReaderNextElement - moves to the next child element of the element
+                        at dwParentDepth, skipping anything else. Use a
+                        parent depth of 0 to read the document element.
+
+ NOTE: Returns S_FALSE once the parent element has ended.
+********************************************************************/
+DAPI_(HRESULT) XmlReaderNextElement(
+    __in XML_READER* pReader,
+    __in DWORD dwParentDepth,
+    __out_opt LPCWSTR* pwzElement
+    )
+{
+    HRESULT hr = S_OK;
+    XML_READER_NODE node = XML_READER_NODE_NONE;
+
+    for (;;)
+    {
+        hr = XmlReaderRead(pReader, &node);
+        if (E_NOMOREITEMS == hr)
+        {
+            ExitFunction1(hr = S_FALSE);
+        }
+        ExitOnFailure(hr, "Failed to read next xml node.");
+
+        if (XML_READER_NODE_ELEMENT == node && dwParentDepth + 1 == pReader->dwDepth)
+        {
+            break;
+        }
+        else if (XML_READER_NODE_END_ELEMENT == node && pReader->dwDepth <= dwParentDepth)
+        {
+            ExitFunction1(hr = S_FALSE);
+        }
+    }
+
+    if (pwzElement)
+    {
+        *pwzElement = pReader->wzName;
+    }
+
+LExit:
+    return hr;
+}
+
+
+/********************************************************************
+ XmlReaderReadElementText - reads all text within the current element,
+                            leaving the reader on its end element.
+
+*********************************************************************/
+DAPI_(HRESULT) XmlReaderReadElementText(
+    __in XML_READER* pReader,
+    __deref_out_z LPWSTR* psczText
+    )
+{
+    HRESULT hr = S_OK;
+    XML_READER_NODE node = XML_READER_NODE_NONE;
+    DWORD dwDepth = pReader->dwDepth;
+
+    if (XML_READER_NODE_ELEMENT != pReader->node)
+    {
+        ExitOnFailure(hr = E_INVALIDSTATE, "Xml reader is not positioned on an element.");
+    }
+
+    hr = StrAllocString(psczText, L"", 0);
+    ExitOnFailure(hr, "Failed to initialize element text.");
+
+    for (;;)
+    {
+        hr = XmlReaderRead(pReader, &node);
+        ExitOnFailure(hr, "Failed to read xml element content.");
+
+        if (XML_READER_NODE_TEXT == node)
+        {
+            hr = StrAllocConcat(psczText, pReader->wzText, 0);
+            ExitOnFailure(hr, "Failed to append element text.");
+        }
+        else if (XML_READER_NODE_END_ELEMENT == node && dwDepth == pReader->dwDepth)
+        {
+            break;
+        }
+    }
+
+LExit:
+    return hr;
+}
+
+
+DAPI_(HRESULT) XmlReaderGetAttributeValue(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out_z LPCWSTR* pwzValue
+    )
+{
+    HRESULT hr = S_OK;
+
+    if (XML_READER_NODE_ELEMENT != pReader->node)
+    {
+        ExitOnFailure(hr = E_INVALIDSTATE, "Xml reader is not positioned on an element to read attribute: %ls", wzAttribute);
+    }
+
+    for (DWORD i = 0; i < pReader->cAttributes; ++i)
+    {
+        if (0 == wcscmp(wzAttribute, pReader->rgAttributes[i].wzName))
+        {
+            *pwzValue = pReader->rgAttributes[i].wzValue;
+            ExitFunction();
+        }
+    }
+
+    hr = E_NOTFOUND;
+
+LExit:
+    return hr;
+}
+
+
+DAPI_(HRESULT) XmlReaderGetAttribute(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __deref_out_z LPWSTR* psczValue
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzValue = NULL;
+
+    hr = XmlReaderGetAttributeValue(pReader, wzAttribute, &wzValue);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to find attribute: %ls", wzAttribute);
+
+        hr = StrAllocStringArena(pReader->hArena, psczValue, wzValue, 0);
+        ExitOnFailure(hr, "Failed to copy attribute: %ls", wzAttribute);
+    }
+
+LExit:
+    return hr;
+}
+
+
+DAPI_(HRESULT) XmlReaderGetYesNoAttribute(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out BOOL* pfYes
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzValue = NULL;
+
+    hr = XmlReaderGetAttributeValue(pReader, wzAttribute, &wzValue);
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to find attribute: %ls", wzAttribute);
+
+        *pfYes = CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, 0, wzValue, -1, L"yes", -1);
+    }
+
+LExit:
+    return hr;
+}
+
+
+/********************************************************************
+ XmlReaderGetAttributeNumber - like XmlGetAttributeNumber, returns
+                               S_FALSE when the attribute is missing.
+
+*********************************************************************/
+DAPI_(HRESULT) XmlReaderGetAttributeNumber(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out DWORD* pdwValue
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzValue = NULL;
+
+    hr = XmlReaderGetAttributeValue(pReader, wzAttribute, &wzValue);
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction1(hr = S_FALSE);
+    }
+    ExitOnFailure(hr, "Failed to find attribute: %ls", wzAttribute);
+
+    *pdwValue = wcstoul(wzValue, NULL, 10);
+
+LExit:
+    return hr;
+}
+
+
+/********************************************************************
+ XmlReaderGetAttributeLargeNumber - like XmlGetAttributeLargeNumber,
+                                    returns S_FALSE and zero when the
+                                    attribute is missing.
+
+*********************************************************************/
+DAPI_(HRESULT) XmlReaderGetAttributeLargeNumber(
+    __in const XML_READER* pReader,
+    __in_z LPCWSTR wzAttribute,
+    __out DWORD64* pdw64Value
+    )
+{
+    HRESULT hr = S_OK;
+    LPCWSTR wzValue = NULL;
+    LONGLONG ll = 0;
+
+    *pdw64Value = 0;
+
+    hr = XmlReaderGetAttributeValue(pReader, wzAttribute, &wzValue);
+    if (E_NOTFOUND == hr)
+    {
+        ExitFunction1(hr = S_FALSE);
+    }
+    ExitOnFailure(hr, "Failed to find attribute: %ls", wzAttribute);
+
+    hr = StrStringToInt64(wzValue, 0, &ll);
+    ExitOnFailure(hr, "Failed to treat attribute value as number.");
+
+    *pdw64Value = ll;
+
+LExit:
+    return hr;
+}
+
+
+// Static functions
+
+static HRESULT ReadCompiledNode(
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    const XML_READER_COMPILED_NODE* pNode = NULL;
+    const XML_READER_COMPILED_ATTRIBUTE* pAttribute = NULL;
+
+    if (pReader->iCompiledNode == pReader->cCompiledNodes)
+    {
+        pReader->node = XML_READER_NODE_NONE;
+        ExitFunction1(hr = E_NOMOREITEMS);
+    }
+
+    pNode = pReader->rgCompiledNodes + pReader->iCompiledNode;
+    ++pReader->iCompiledNode;
+
+    pReader->node = static_cast<XML_READER_NODE>(pNode->node);
+
+    switch (pReader->node)
+    {
+    case XML_READER_NODE_ELEMENT:
+        if (pNode->cAttributes)
+        {
+            hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pReader->rgAttributes), pNode->cAttributes, sizeof(XML_READER_ATTRIBUTE), XML_READER_ATTRIBUTE_INCREMENT);
+            ExitOnFailure(hr, "Failed to grow xml attribute array.");
+        }
+
+        for (DWORD i = 0; i < pNode->cAttributes; ++i)
+        {
+            pAttribute = pReader->rgCompiledAttributes + pNode->iFirstAttribute + i;
+            pReader->rgAttributes[i].wzName = pReader->wzCompiledStrings + pAttribute->iName;
+            pReader->rgAttributes[i].wzValue = pReader->wzCompiledStrings + pAttribute->iValue;
+        }
+        pReader->cAttributes = pNode->cAttributes;
+
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pReader->rgwzElements), pReader->cElements + 1, sizeof(LPCWSTR), XML_READER_STACK_INCREMENT);
+        ExitOnFailure(hr, "Failed to grow xml element stack.");
+
+        pReader->rgwzElements[pReader->cElements] = pReader->wzCompiledStrings + pNode->iString;
+        ++pReader->cElements;
+
+        pReader->dwDepth = pReader->cElements;
+        pReader->wzName = pReader->wzCompiledStrings + pNode->iString;
+        pReader->fDocumentElementRead = TRUE;
+        break;
+
+    case XML_READER_NODE_END_ELEMENT:
+        pReader->dwDepth = pReader->cElements;
+        pReader->wzName = pReader->rgwzElements[pReader->cElements - 1];
+        pReader->cAttributes = 0;
+        --pReader->cElements;
+        break;
+
+    case XML_READER_NODE_TEXT:
+        pReader->wzText = pReader->wzCompiledStrings + pNode->iString;
+        pReader->dwDepth = pReader->cElements + 1;
+        break;
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT CompileString(
+    __in STRINGDICT_HANDLE sdStrings,
+    __inout XML_READER_COMPILE_STRING** prgStrings,
+    __inout DWORD* pcStrings,
+    __in BUFF_WRITER* pStringTable,
+    __in_z LPCWSTR wzValue,
+    __out DWORD* piString
+    )
+{
+    HRESULT hr = S_OK;
+    XML_READER_COMPILE_STRING* pString = NULL;
+
+    hr = DictGetValue(sdStrings, wzValue, reinterpret_cast<void**>(&pString));
+    if (E_NOTFOUND != hr)
+    {
+        ExitOnFailure(hr, "Failed to find compiled xml string: %ls", wzValue);
+
+        *piString = pString->iString;
+        ExitFunction();
+    }
+
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(prgStrings), *pcStrings + 1, sizeof(XML_READER_COMPILE_STRING), XML_READER_COMPILE_STRING_INCREMENT);
+    ExitOnFailure(hr, "Failed to grow compiled xml string array.");
+
+    pString = *prgStrings + *pcStrings;
+    pString->wzValue = wzValue;
+    pString->iString = static_cast<DWORD>(pStringTable->cbData / sizeof(WCHAR));
+
+    hr = WriteRecord(pStringTable, wzValue, (lstrlenW(wzValue) + 1) * sizeof(WCHAR));
+    ExitOnFailure(hr, "Failed to write compiled xml string: %ls", wzValue);
+
+    hr = DictAddValue(sdStrings, pString);
+    ExitOnFailure(hr, "Failed to index compiled xml string: %ls", wzValue);
+
+    ++(*pcStrings);
+    *piString = pString->iString;
+
+LExit:
+    return hr;
+}
+
+static HRESULT WriteRecord(
+    __in BUFF_WRITER* pWriter,
+    __in_bcount(cbRecord) const void* pvRecord,
+    __in SIZE_T cbRecord
+    )
+{
+    HRESULT hr = S_OK;
+
+    hr = BuffWriterReserve(pWriter, cbRecord);
+    ExitOnFailure(hr, "Failed to reserve space for compiled xml record.");
+
+    memcpy(pWriter->pbData + pWriter->cbData, pvRecord, cbRecord);
+    pWriter->cbData += cbRecord;
+
+LExit:
+    return hr;
+}
+
+// Reads the markup following a '<', setting the node for elements and end elements and pfText for CDATA.
+// Anything else is skipped, leaving the node at XML_READER_NODE_NONE.
+static HRESULT ReadMarkup(
+    __in XML_READER* pReader,
+    __out BOOL* pfText
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR wzCData = NULL;
+    LPWSTR wzCDataEnd = NULL;
+
+    pReader->node = XML_READER_NODE_NONE;
+    *pfText = FALSE;
+
+    if (L'?' == *pReader->pwz)
+    {
+        hr = SkipPast(&pReader->pwz, L"?>");
+        ExitOnFailure(hr, "Failed to find end of xml processing instruction.");
+    }
+    else if (0 == wcsncmp(pReader->pwz, L"!--", 3))
+    {
+        hr = SkipPast(&pReader->pwz, L"-->");
+        ExitOnFailure(hr, "Failed to find end of xml comment.");
+    }
+    else if (0 == wcsncmp(pReader->pwz, L"![CDATA[", 8))
+    {
+        if (!pReader->cElements)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "CDATA is not allowed outside of the xml document element.");
+        }
+
+        wzCData = pReader->pwz + 8;
+        wzCDataEnd = wcsstr(wzCData, L"]]>");
+        if (!wzCDataEnd)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Failed to find end of xml CDATA section.");
+        }
+
+        *wzCDataEnd = L'\0';
+        pReader->pwz = wzCDataEnd + 3;
+        pReader->wzText = wzCData;
+        *pfText = TRUE;
+    }
+    else if (L'!' == *pReader->pwz)
+    {
+        // Document type declarations would bring in entities we don't expand, so refuse them.
+        ExitOnFailure(hr = E_INVALIDDATA, "Xml document type declarations are not supported.");
+    }
+    else if (L'/' == *pReader->pwz)
+    {
+        hr = ReadEndTag(pReader);
+        ExitOnFailure(hr, "Failed to read xml end element.");
+    }
+    else
+    {
+        hr = ReadStartTag(pReader);
+        ExitOnFailure(hr, "Failed to read xml element.");
+    }
+
+LExit:
+    return hr;
+}
+
+static HRESULT ReadStartTag(
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR wzName = pReader->pwz;
+    LPWSTR wzNameEnd = NULL;
+    LPWSTR wzAttributeName = NULL;
+    LPWSTR wzAttributeNameEnd = NULL;
+    LPWSTR wzValue = NULL;
+    LPWSTR wzValueEnd = NULL;
+    LPWSTR wz = NULL;
+    BOOL fEmpty = FALSE;
+
+    if (!pReader->cElements && pReader->fDocumentElementRead)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Xml document has more than one document element.");
+    }
+
+    for (wz = wzName; IsNameChar(*wz); ++wz)
+    {
+    }
+
+    if (wz == wzName)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Xml element is missing its name.");
+    }
+
+    wzNameEnd = wz;
+    pReader->cAttributes = 0;
+
+    for (;;)
+    {
+        wzAttributeName = SkipWhitespace(wz);
+
+        if (L'/' == *wzAttributeName && L'>' == wzAttributeName[1])
+        {
+            fEmpty = TRUE;
+            wz = wzAttributeName + 2;
+            break;
+        }
+        else if (L'>' == *wzAttributeName)
+        {
+            wz = wzAttributeName + 1;
+            break;
+        }
+        else if (wzAttributeName == wz || !IsNameChar(*wzAttributeName))
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Invalid xml markup in element: %.*ls", static_cast<int>(wzNameEnd - wzName), wzName);
+        }
+
+        for (wz = wzAttributeName; IsNameChar(*wz); ++wz)
+        {
+        }
+        wzAttributeNameEnd = wz;
+
+        wz = SkipWhitespace(wz);
+        if (L'=' != *wz)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Xml attribute is missing its value in element: %.*ls", static_cast<int>(wzNameEnd - wzName), wzName);
+        }
+
+        wz = SkipWhitespace(wz + 1);
+        if (L'"' != *wz && L'\'' != *wz)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Xml attribute value is not quoted in element: %.*ls", static_cast<int>(wzNameEnd - wzName), wzName);
+        }
+
+        wzValue = wz + 1;
+        wzValueEnd = wcschr(wzValue, *wz);
+        if (!wzValueEnd)
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Failed to find end of xml attribute value in element: %.*ls", static_cast<int>(wzNameEnd - wzName), wzName);
+        }
+
+        // Everything up to the closing quote has been looked at, so it's safe to terminate in place now.
+        *wzAttributeNameEnd = L'\0';
+        wz = wzValueEnd + 1;
+
+        hr = DecodeInPlace(wzValue, wzValueEnd, TRUE);
+        ExitOnFailure(hr, "Failed to decode xml attribute: %ls", wzAttributeName);
+
+        hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pReader->rgAttributes), pReader->cAttributes + 1, sizeof(XML_READER_ATTRIBUTE), XML_READER_ATTRIBUTE_INCREMENT);
+        ExitOnFailure(hr, "Failed to grow xml attribute array.");
+
+        pReader->rgAttributes[pReader->cAttributes].wzName = wzAttributeName;
+        pReader->rgAttributes[pReader->cAttributes].wzValue = wzValue;
+        ++pReader->cAttributes;
+    }
+
+    *wzNameEnd = L'\0';
+    pReader->pwz = wz;
+
+    hr = MemEnsureArraySize(reinterpret_cast<LPVOID*>(&pReader->rgwzElements), pReader->cElements + 1, sizeof(LPCWSTR), XML_READER_STACK_INCREMENT);
+    ExitOnFailure(hr, "Failed to grow xml element stack.");
+
+    pReader->rgwzElements[pReader->cElements] = wzName;
+    ++pReader->cElements;
+
+    pReader->node = XML_READER_NODE_ELEMENT;
+    pReader->dwDepth = pReader->cElements;
+    pReader->wzName = wzName;
+    pReader->fEmptyElement = fEmpty;
+    pReader->fDocumentElementRead = TRUE;
+
+LExit:
+    return hr;
+}
+
+static HRESULT ReadEndTag(
+    __in XML_READER* pReader
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR wzName = pReader->pwz + 1;
+    LPWSTR wzNameEnd = NULL;
+    LPWSTR wz = NULL;
+
+    for (wzNameEnd = wzName; IsNameChar(*wzNameEnd); ++wzNameEnd)
+    {
+    }
+
+    wz = SkipWhitespace(wzNameEnd);
+    if (L'>' != *wz)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Invalid xml end element: %.*ls", static_cast<int>(wzNameEnd - wzName), wzName);
+    }
+
+    *wzNameEnd = L'\0';
+
+    if (!pReader->cElements || 0 != wcscmp(wzName, pReader->rgwzElements[pReader->cElements - 1]))
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Xml end element does not match its element: %ls", wzName);
+    }
+
+    pReader->pwz = wz + 1;
+    pReader->node = XML_READER_NODE_END_ELEMENT;
+    pReader->dwDepth = pReader->cElements;
+    pReader->wzName = pReader->rgwzElements[pReader->cElements - 1];
+    pReader->cAttributes = 0;
+    --pReader->cElements;
+
+LExit:
+    return hr;
+}
+
+// Expands entity and character references and normalizes line endings (and, in attributes,
+// whitespace) of the range, terminating the result in place since it can only get shorter.
+static HRESULT DecodeInPlace(
+    __in LPWSTR wzStart,
+    __in LPCWSTR wzEnd,
+    __in BOOL fAttribute
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR wzWrite = wzStart;
+    LPCWSTR wzRead = wzStart;
+    LPCWSTR wzReferenceEnd = NULL;
+    WCHAR wch = L'\0';
+
+    while (wzRead < wzEnd)
+    {
+        wch = *wzRead;
+
+        if (L'&' == wch)
+        {
+            for (wzReferenceEnd = wzRead + 1; wzReferenceEnd < wzEnd && L';' != *wzReferenceEnd; ++wzReferenceEnd)
+            {
+            }
+
+            if (wzReferenceEnd == wzEnd)
+            {
+                ExitOnFailure(hr = E_INVALIDDATA, "Unterminated xml entity reference.");
+            }
+
+            hr = DecodeCharacterReference(wzRead + 1, static_cast<DWORD>(wzReferenceEnd - wzRead - 1), &wzWrite);
+            ExitOnFailure(hr, "Failed to decode xml entity reference.");
+
+            wzRead = wzReferenceEnd + 1;
+            continue;
+        }
+        else if (L'\r' == wch)
+        {
+            if (wzRead + 1 < wzEnd && L'\n' == wzRead[1])
+            {
+                ++wzRead;
+            }
+
+            wch = fAttribute ? L' ' : L'\n';
+        }
+        else if (fAttribute && (L'\n' == wch || L'\t' == wch))
+        {
+            wch = L' ';
+        }
+
+        *wzWrite = wch;
+        ++wzWrite;
+        ++wzRead;
+    }
+
+    *wzWrite = L'\0';
+
+LExit:
+    return hr;
+}
+
+static HRESULT DecodeCharacterReference(
+    __in_ecount(cchReference) LPCWSTR wzReference,
+    __in DWORD cchReference,
+    __inout LPWSTR* ppwzWrite
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR wzWrite = *ppwzWrite;
+    LPWSTR wzNumberEnd = NULL;
+    DWORD dwCodePoint = 0;
+
+    if (2 == cchReference && 0 == wcsncmp(wzReference, L"lt", 2))
+    {
+        *wzWrite++ = L'<';
+    }
+    else if (2 == cchReference && 0 == wcsncmp(wzReference, L"gt", 2))
+    {
+        *wzWrite++ = L'>';
+    }
+    else if (3 == cchReference && 0 == wcsncmp(wzReference, L"amp", 3))
+    {
+        *wzWrite++ = L'&';
+    }
+    else if (4 == cchReference && 0 == wcsncmp(wzReference, L"quot", 4))
+    {
+        *wzWrite++ = L'"';
+    }
+    else if (4 == cchReference && 0 == wcsncmp(wzReference, L"apos", 4))
+    {
+        *wzWrite++ = L'\'';
+    }
+    else if (1 < cchReference && L'#' == *wzReference)
+    {
+        if (L'x' == wzReference[1])
+        {
+            dwCodePoint = wcstoul(wzReference + 2, &wzNumberEnd, 16);
+        }
+        else
+        {
+            dwCodePoint = wcstoul(wzReference + 1, &wzNumberEnd, 10);
+        }
+
+        if (wzNumberEnd != wzReference + cchReference || !dwCodePoint || 0x10FFFF < dwCodePoint || (0xD800 <= dwCodePoint && dwCodePoint <= 0xDFFF))
+        {
+            ExitOnFailure(hr = E_INVALIDDATA, "Invalid xml character reference: &%.*ls;", cchReference, wzReference);
+        }
+
+        if (0xFFFF < dwCodePoint)
+        {
+            dwCodePoint -= 0x10000;
+            *wzWrite++ = static_cast<WCHAR>(0xD800 + (dwCodePoint >> 10));
+            *wzWrite++ = static_cast<WCHAR>(0xDC00 + (dwCodePoint & 0x3FF));
+        }
+        else
+        {
+            *wzWrite++ = static_cast<WCHAR>(dwCodePoint);
+        }
+    }
+    else
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Unknown xml entity reference: &%.*ls;", cchReference, wzReference);
+    }
+
+    *ppwzWrite = wzWrite;
+
+LExit:
+    return hr;
+}
+
+static HRESULT SkipPast(
+    __inout LPWSTR* ppwz,
+    __in_z LPCWSTR wzTerminator
+    )
+{
+    HRESULT hr = S_OK;
+    LPWSTR wz = wcsstr(*ppwz, wzTerminator);
+
+    if (!wz)
+    {
+        ExitOnFailure(hr = E_INVALIDDATA, "Failed to find xml terminator: %ls", wzTerminator);
+    }
+
+    *ppwz = wz + lstrlenW(wzTerminator);
+
+LExit:
+    return hr;
+}
+
+static LPWSTR SkipWhitespace(
+    __in_z LPWSTR wz
+    )
+{
+    while (IsWhitespace(*wz))
+    {
+        ++wz;
+    }
+
+    return wz;
+}
+
+static BOOL IsWhitespace(
+    __in WCHAR wch
+    )
+{
+    return L' ' == wch || L'\t' == wch || L'\r' == wch || L'\n' == wch;
+}
+
+static BOOL IsNameChar(
+    __in WCHAR wch
+    )
+{
+    return L'\0' != wch && !IsWhitespace(wch) && L'/' != wch && L'>' != wch && L'<' != wch && L'=' != wch && L'"' != wch && L'\'' != wch && L'&' != wch;
+}
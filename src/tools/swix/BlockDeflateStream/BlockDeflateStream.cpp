@@ -4,24 +4,59 @@
 
 using namespace WixToolset;
 using namespace ZLib;
+using namespace System::Collections::Generic;
+using namespace System::Threading;
 
 BlockDeflateStream::BlockDeflateStream(System::IO::Stream^ output, BlockDeflateCompressionLevel level)
 {
-    this->pzStream = new z_stream();
-    int err = deflateInit2(this->pzStream, (int)level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
-    checkErr(err);
+    this->initialize(output, level);
+}
 
-    this->output = output;
+BlockDeflateStream::BlockDeflateStream(System::IO::Stream^ output, BlockDeflateCompressionLevel level, int threads)
+{
+    this->initialize(output, level);
+
+    if (threads > 1)
+    {
+        this->sync = gcnew System::Object();
+        this->work = gcnew Queue<BlockDeflateJob^>();
+        this->inFlight = gcnew Queue<BlockDeflateJob^>();
+        this->freeJobs = gcnew Stack<BlockDeflateJob^>();
+
+        this->workers = gcnew array<Thread^>(threads);
+        for (int i = 0; i < threads; ++i)
+        {
+            this->workers[i] = gcnew Thread(gcnew ThreadStart(this, &BlockDeflateStream::workerThread));
+            this->workers[i]->IsBackground = true;
+            this->workers[i]->Start();
+        }
+    }
 }
 
 BlockDeflateStream::~BlockDeflateStream()
 {
     this->Flush();
+    this->stopWorkers();
 
-    delete this->pzStream;
     this->output = nullptr;
 }
 
+void BlockDeflateStream::initialize(System::IO::Stream^ output, BlockDeflateCompressionLevel level)
+{
+    this->pzStream = new z_stream();
+    int err = deflateInit2(this->pzStream, (int)level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    checkErr(err);
+
+    this->output = output;
+    this->level = level;
+    this->blockSizes = gcnew List<int>();
+}
+
+IList<int>^ BlockDeflateStream::BlockSizes::get()
+{
+    return this->blockSizes;
+}
+
 void BlockDeflateStream::checkErr(int err)
 {
     if (err != Z_OK)
@@ -30,32 +65,34 @@ void BlockDeflateStream::checkErr(int err)
     }
 }
 
-int BlockDeflateStream::Deflate(array<System::Byte>^ buffer, int offset, int count)
+int BlockDeflateStream::deflateBlock(z_stream* pzStream, array<System::Byte>^ buffer, int offset, int count, array<System::Byte>^% outputBuffer)
 {
     int err = Z_OK;
-    int compressed = 0;
-
-    array<System::Byte>^ outputBuffer = gcnew array<System::Byte>((count + 128 ) * 2);
+    int required = (count + 128) * 2;
     pin_ptr<System::Byte> pinInput = nullptr;
     pin_ptr<System::Byte> pinOutput = nullptr;
 
+    // Reuse the output buffer across blocks, only growing it for a larger block.
+    if (outputBuffer == nullptr || outputBuffer->Length < required)
+    {
+        outputBuffer = gcnew array<System::Byte>(required);
+    }
+
     // Point the zStream to the fixed input buffer at the appropriate offset.
     pinInput = &buffer[offset];
-    this->pzStream->next_in = (Bytef*)pinInput;
-    this->pzStream->avail_in = count - offset;
+    pzStream->next_in = (Bytef*)pinInput;
+    pzStream->avail_in = count;
 
-    // Point the zStream to a clean output buffer.
-    System::Array::Clear(outputBuffer, 0, outputBuffer->Length);
     pinOutput = &outputBuffer[0];
-    this->pzStream->next_out = (Bytef*)pinOutput;
-    this->pzStream->avail_out = outputBuffer->Length;
+    pzStream->next_out = (Bytef*)pinOutput;
+    pzStream->avail_out = outputBuffer->Length;
 
-    // Compress.
-    err = deflate(this->pzStream, Z_FULL_FLUSH);
+    // Compress. The full flush byte aligns the output and resets the dictionary, so each block stands on its own.
+    err = deflate(pzStream, Z_FULL_FLUSH);
     checkErr(err);
 
     // Available in should be zero after doing a successful flush.
-    if (this->pzStream->avail_in)
+    if (pzStream->avail_in)
     {
         checkErr(Z_BUF_ERROR);
     }
@@ -63,11 +100,183 @@ int BlockDeflateStream::Deflate(array<System::Byte>^ buffer, int offset, int cou
     pinInput = nullptr;
     pinOutput = nullptr;
 
-    // Write any available ouput into the output stream.
-    compressed = outputBuffer->Length - this->pzStream->avail_out;
-    this->output->Write(outputBuffer, 0, compressed);
+    return outputBuffer->Length - pzStream->avail_out;
+}
+
+int BlockDeflateStream::Deflate(array<System::Byte>^ buffer, int offset, int count)
+{
+    int compressed = 0;
+    BlockDeflateJob^ job = nullptr;
+
+    if (this->inFlight == nullptr)
+    {
+        compressed = deflateBlock(this->pzStream, buffer, offset, count, this->outputBuffer);
+
+        // Write any available ouput into the output stream.
+        this->output->Write(this->outputBuffer, 0, compressed);
+        this->blockSizes->Add(compressed);
+
+        return compressed;
+    }
+
+    // The caller is free to reuse its buffer as soon as this returns, so the block is copied into a pooled job.
+    job = (this->freeJobs->Count > 0) ? this->freeJobs->Pop() : gcnew BlockDeflateJob();
+    if (job->input == nullptr || job->input->Length < count)
+    {
+        job->input = gcnew array<System::Byte>(count);
+    }
+    System::Buffer::BlockCopy(buffer, offset, job->input, 0, count);
+    job->count = count;
+    job->compressed = 0;
+    job->done = false;
+    job->error = nullptr;
+
+    this->inFlight->Enqueue(job);
+
+    Monitor::Enter(this->sync);
+    try
+    {
+        this->work->Enqueue(job);
+        Monitor::PulseAll(this->sync);
+    }
+    finally
+    {
+        Monitor::Exit(this->sync);
+    }
+
+    // Returns what was written by this call, which is whatever earlier blocks finished since.
+    return this->writeCompleted(false);
+}
+
+void BlockDeflateStream::workerThread()
+{
+    BlockDeflateJob^ job = nullptr;
+    z_stream* pzWorkerStream = new z_stream();
+    int err = deflateInit2(pzWorkerStream, (int)this->level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+
+    while (true)
+    {
+        Monitor::Enter(this->sync);
+        try
+        {
+            while (this->work->Count == 0 && !this->stopping)
+            {
+                Monitor::Wait(this->sync);
+            }
+
+            job = (this->work->Count > 0) ? this->work->Dequeue() : nullptr;
+        }
+        finally
+        {
+            Monitor::Exit(this->sync);
+        }
+
+        if (job == nullptr)
+        {
+            break;
+        }
+
+        // Failures are handed back with the block, and thrown on the calling thread when it gets to that block.
+        try
+        {
+            checkErr(err);
+            job->compressed = deflateBlock(pzWorkerStream, job->input, 0, job->count, job->output);
+        }
+        catch (System::Exception^ e)
+        {
+            job->error = e;
+        }
+
+        Monitor::Enter(this->sync);
+        try
+        {
+            job->done = true;
+            Monitor::PulseAll(this->sync);
+        }
+        finally
+        {
+            Monitor::Exit(this->sync);
+        }
+    }
+
+    if (err == Z_OK)
+    {
+        deflateEnd(pzWorkerStream);
+    }
+    delete pzWorkerStream;
+}
+
+int BlockDeflateStream::writeCompleted(bool wait)
+{
+    int written = 0;
+    bool done = false;
+    BlockDeflateJob^ job = nullptr;
+
+    // Bound how far the workers can get ahead of the output so large inputs don't buffer in memory.
+    int maxInFlight = (this->workers != nullptr) ? this->workers->Length * 2 : 0;
+
+    while (this->inFlight->Count > 0)
+    {
+        job = this->inFlight->Peek();
+
+        Monitor::Enter(this->sync);
+        try
+        {
+            while (!job->done && (wait || this->inFlight->Count > maxInFlight))
+            {
+                Monitor::Wait(this->sync);
+            }
+
+            done = job->done;
+        }
+        finally
+        {
+            Monitor::Exit(this->sync);
+        }
+
+        if (!done)
+        {
+            break;
+        }
+
+        this->inFlight->Dequeue();
+        if (job->error != nullptr)
+        {
+            throw job->error;
+        }
+
+        this->output->Write(job->output, 0, job->compressed);
+        this->blockSizes->Add(job->compressed);
+        written += job->compressed;
+
+        this->freeJobs->Push(job);
+    }
+
+    return written;
+}
+
+void BlockDeflateStream::stopWorkers()
+{
+    if (this->workers != nullptr)
+    {
+        Monitor::Enter(this->sync);
+        try
+        {
+            this->stopping = true;
+            Monitor::PulseAll(this->sync);
+        }
+        finally
+        {
+            Monitor::Exit(this->sync);
+        }
+
+        for (int i = 0; i < this->workers->Length; ++i)
+        {
+            this->workers[i]->Join();
+        }
 
-    return compressed;
+        this->workers = nullptr;
+    }
 }
 
 void BlockDeflateStream::Flush()
@@ -75,17 +284,27 @@ void BlockDeflateStream::Flush()
     if (this->pzStream)
     {
         int err = Z_OK;
-        array<System::Byte>^ outputBuffer = gcnew array<System::Byte>(64 * 1024 + 128);
         pin_ptr<System::Byte> pinOutput = nullptr;
 
+        // Blocks compressed on worker threads have to be out before the end of the stream.
+        if (this->inFlight != nullptr)
+        {
+            this->writeCompleted(true);
+            this->stopWorkers();
+        }
+
+        if (this->outputBuffer == nullptr || this->outputBuffer->Length < 64 * 1024 + 128)
+        {
+            this->outputBuffer = gcnew array<System::Byte>(64 * 1024 + 128);
+        }
+
         // Continue until there's no more output
         while (err != Z_STREAM_END)
         {
             // Set the output buffers and make the input buffer empty.
-            System::Array::Clear(outputBuffer, 0, outputBuffer->Length);
-            pinOutput = &outputBuffer[0];
+            pinOutput = &this->outputBuffer[0];
             this->pzStream->next_out = (Bytef*)pinOutput;
-            this->pzStream->avail_out = outputBuffer->Length;
+            this->pzStream->avail_out = this->outputBuffer->Length;
 
             this->pzStream->avail_in = 0;
 
@@ -101,11 +320,13 @@ void BlockDeflateStream::Flush()
             }
 
             // Write any available ouput into the output stream.
-            int ready = outputBuffer->Length - this->pzStream->avail_out;
-            output->Write(outputBuffer, 0, ready);
+            int ready = this->outputBuffer->Length - this->pzStream->avail_out;
+            output->Write(this->outputBuffer, 0, ready);
         }
 
         err = deflateEnd(this->pzStream);
+        delete this->pzStream;
+        this->pzStream = nullptr;
         checkErr(err);
     }
 }
@@ -12,20 +12,56 @@ namespace WixToolset
         Default = -1,
     };
 
+    // A block waiting to be compressed by a worker thread. Jobs and their buffers are reused once the block is written.
+    private ref class BlockDeflateJob
+    {
+    public:
+        array<System::Byte>^ input;
+        int count;
+        array<System::Byte>^ output;
+        int compressed;
+        bool done;
+        System::Exception^ error;
+    };
+
     public ref class BlockDeflateStream
     {
     public:
         BlockDeflateStream(System::IO::Stream^ output, BlockDeflateCompressionLevel level);
+        // Compresses blocks on the given number of worker threads. Blocks are still written to the output in order, and only from the calling thread.
+        BlockDeflateStream(System::IO::Stream^ output, BlockDeflateCompressionLevel level, int threads);
         ~BlockDeflateStream();
 
         int Deflate(array<System::Byte>^ buffer, int offset, int count);
         void Flush();
 
+        // Compressed size of each block written to the output so far, in order.
+        property System::Collections::Generic::IList<int>^ BlockSizes
+        {
+            System::Collections::Generic::IList<int>^ get();
+        }
+
     private:
+        void initialize(System::IO::Stream^ output, BlockDeflateCompressionLevel level);
         static void checkErr(int err);
+        static int deflateBlock(ZLib::z_stream* pzStream, array<System::Byte>^ buffer, int offset, int count, array<System::Byte>^% outputBuffer);
+        void workerThread();
+        int writeCompleted(bool wait);
+        void stopWorkers();
 
     private:
         System::IO::Stream^ output;
         ZLib::z_stream* pzStream;
+        BlockDeflateCompressionLevel level;
+        array<System::Byte>^ outputBuffer;
+        System::Collections::Generic::List<int>^ blockSizes;
+
+        // Only used when compressing on worker threads.
+        array<System::Threading::Thread^>^ workers;
+        System::Object^ sync;
+        System::Collections::Generic::Queue<BlockDeflateJob^>^ work;
+        System::Collections::Generic::Queue<BlockDeflateJob^>^ inFlight;
+        System::Collections::Generic::Stack<BlockDeflateJob^>^ freeJobs;
+        bool stopping;
     };
 }
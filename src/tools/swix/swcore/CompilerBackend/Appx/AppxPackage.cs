@@ -57,12 +57,19 @@ namespace WixToolset.Simplified.CompilerBackend.Appx
             this.blockMapFiles.Add(blockMapFile);
 
             ZipCrc crc = new ZipCrc();
-            BlockDeflateStream deflate = (level == CompressionLevel.NoCompression) ? null : new BlockDeflateStream(this.BaseStream, (BlockDeflateCompressionLevel)level);
+            byte[] buffer = new byte[64 * 1024];
+
+            // Files spanning several blocks get their blocks compressed in parallel.
+            BlockDeflateStream deflate = null;
+            if (level != CompressionLevel.NoCompression)
+            {
+                int threads = (stream.Length > buffer.Length) ? Environment.ProcessorCount : 1;
+                deflate = new BlockDeflateStream(this.BaseStream, (BlockDeflateCompressionLevel)level, threads);
+            }
 
             long outputStart = this.BaseStream.Position;
 
             int read = 0;
-            byte[] buffer = new byte[64 * 1024];
             while (0 < (read = stream.Read(buffer, 0, buffer.Length)))
             {
                 crc.UpdateCrc(buffer, 0, read);
@@ -77,7 +84,8 @@ namespace WixToolset.Simplified.CompilerBackend.Appx
                 long compressedBlockSize = 0;
                 if (deflate != null)
                 {
-                    compressedBlockSize = deflate.Deflate(buffer, 0, read);
+                    // The compressed size is filled in once the block has been written.
+                    deflate.Deflate(buffer, 0, read);
                 }
                 else
                 {
@@ -92,6 +100,11 @@ namespace WixToolset.Simplified.CompilerBackend.Appx
             if (deflate != null)
             {
                 deflate.Flush();
+
+                for (int i = 0; i < deflate.BlockSizes.Count; ++i)
+                {
+                    blockMapFile.Blocks[i].CompressedSize = deflate.BlockSizes[i];
+                }
             }
             else
             {
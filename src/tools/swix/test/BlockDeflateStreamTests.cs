@@ -0,0 +1,107 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+using System;
+using System.IO;
+using System.IO.Compression;
+using Xunit;
+
+namespace WixToolset.Simplified.Test
+{
+    public class BlockDeflateStreamTests
+    {
+        private const int BlockSize = 64 * 1024;
+
+        [Fact]
+        public void ParallelMatchesSequential()
+        {
+            byte[] data = CreateData(4 * 1024 * 1024 + 123);
+
+            int[] sequentialBlockSizes;
+            byte[] sequential = Compress(data, 1, out sequentialBlockSizes);
+            int[] parallelBlockSizes;
+            byte[] parallel = Compress(data, 4, out parallelBlockSizes);
+
+            // Every block is compressed on its own, so which thread compressed it makes no difference to the output.
+            Assert.Equal(sequential, parallel);
+            Assert.Equal(sequentialBlockSizes, parallelBlockSizes);
+            Assert.Equal(data, Inflate(parallel));
+        }
+
+        [Fact]
+        public void BlockSizesAddUp()
+        {
+            byte[] data = CreateData(10 * BlockSize + 1);
+
+            using (MemoryStream output = new MemoryStream())
+            {
+                BlockDeflateStream deflate = new BlockDeflateStream(output, BlockDeflateCompressionLevel.Default, 3);
+                Feed(deflate, data);
+                deflate.Flush();
+
+                long blocksEnd = 0;
+                foreach (int size in deflate.BlockSizes)
+                {
+                    blocksEnd += size;
+                }
+
+                // Only the final empty block comes after the last data block.
+                Assert.Equal(11, deflate.BlockSizes.Count);
+                Assert.True(output.Length > blocksEnd);
+                Assert.True(output.Length - blocksEnd <= 8);
+            }
+        }
+
+        private static byte[] CreateData(int length)
+        {
+            // Repetitive text with some noise, so it compresses but not trivially.
+            Random random = new Random(42);
+            byte[] data = new byte[length];
+            byte[] text = System.Text.Encoding.ASCII.GetBytes("<File Source=\"bin\\Release\\Component.dll\" Size=\"12345\" />\r\n");
+
+            for (int i = 0; i < length; ++i)
+            {
+                data[i] = (0 == random.Next(16)) ? (byte)random.Next(256) : text[i % text.Length];
+            }
+
+            return data;
+        }
+
+        private static void Feed(BlockDeflateStream deflate, byte[] data)
+        {
+            byte[] buffer = new byte[BlockSize];
+            for (int offset = 0; offset < data.Length; offset += BlockSize)
+            {
+                int count = Math.Min(BlockSize, data.Length - offset);
+
+                // Reuse one buffer like the packager does, so the stream can't hold on to it.
+                Buffer.BlockCopy(data, offset, buffer, 0, count);
+                deflate.Deflate(buffer, 0, count);
+            }
+        }
+
+        private static byte[] Compress(byte[] data, int threads, out int[] blockSizes)
+        {
+            using (MemoryStream output = new MemoryStream())
+            {
+                BlockDeflateStream deflate = new BlockDeflateStream(output, BlockDeflateCompressionLevel.Default, threads);
+                Feed(deflate, data);
+                deflate.Flush();
+
+                blockSizes = new int[deflate.BlockSizes.Count];
+                deflate.BlockSizes.CopyTo(blockSizes, 0);
+
+                return output.ToArray();
+            }
+        }
+
+        private static byte[] Inflate(byte[] compressed)
+        {
+            using (DeflateStream inflate = new DeflateStream(new MemoryStream(compressed), CompressionMode.Decompress))
+            using (MemoryStream output = new MemoryStream())
+            {
+                inflate.CopyTo(output);
+                return output.ToArray();
+            }
+        }
+    }
+}
@@ -22,7 +22,13 @@ static THEME_ASSIGN_CONTROL_ID vrgInitControls[] = {
 static HRESULT ProcessCommandLine(
     __in_z_opt LPCWSTR wzCommandLine,
     __out_z LPWSTR* psczThemeFile,
-    __out_z LPWSTR* psczWxlFile
+    __out_z LPWSTR* psczWxlFile,
+    __out_z LPWSTR* psczCompileFile
+    );
+static HRESULT CompileTheme(
+    __in HINSTANCE hInstance,
+    __in_z_opt LPCWSTR wzThemeFile,
+    __in_z LPCWSTR wzCompileFile
     );
 static HRESULT CreateTheme(
     __in HINSTANCE hInstance,
@@ -63,6 +69,7 @@ int WINAPI wWinMain(
     BOOL fComInitialized = FALSE;
     LPWSTR sczThemeFile = NULL;
     LPWSTR sczWxlFile = NULL;
+    LPWSTR sczCompileFile = NULL;
     ATOM atom = 0;
     HWND hWnd = NULL;
 
@@ -76,9 +83,17 @@ int WINAPI wWinMain(
     ExitOnFailure(hr, "Failed to initialize COM.");
     fComInitialized = TRUE;
 
-    hr = ProcessCommandLine(lpCmdLine, &sczThemeFile, &sczWxlFile);
+    hr = ProcessCommandLine(lpCmdLine, &sczThemeFile, &sczWxlFile, &sczCompileFile);
     ExitOnFailure(hr, "Failed to process command line.");
 
+    if (sczCompileFile)
+    {
+        hr = CompileTheme(hInstance, sczThemeFile, sczCompileFile);
+        ExitOnFailure(hr, "Failed to compile theme.");
+
+        ExitFunction();
+    }
+
     hr = CreateTheme(hInstance, &vpTheme);
     ExitOnFailure(hr, "Failed to create theme.");
 
@@ -170,6 +185,7 @@ LExit:
 
     ReleaseStr(sczThemeFile);
     ReleaseStr(sczWxlFile);
+    ReleaseStr(sczCompileFile);
     return hr;
 }
 
@@ -180,7 +196,8 @@ LExit:
 static HRESULT ProcessCommandLine(
     __in_z_opt LPCWSTR wzCommandLine,
     __out_z LPWSTR* psczThemeFile,
-    __out_z LPWSTR* psczWxlFile
+    __out_z LPWSTR* psczWxlFile,
+    __out_z LPWSTR* psczCompileFile
     )
 {
     HRESULT hr = S_OK;
@@ -205,6 +222,18 @@ static HRESULT ProcessCommandLine(
 
                     ++i;
                 }
+                else if (CSTR_EQUAL == ::CompareStringW(LOCALE_INVARIANT, NORM_IGNORECASE, &argv[i][1], -1, L"compile", -1))
+                {
+                    if (i + 1 >= argc)
+                    {
+                        ExitOnRootFailure(hr = E_INVALIDARG, "Must specify a path to write the compiled theme to.");
+                    }
+
+                    ++i;
+
+                    hr = StrAllocString(psczCompileFile, argv[i], 0);
+                    ExitOnFailure(hr, "Failed to copy path to compiled theme.");
+                }
             }
             else
             {
@@ -231,6 +260,44 @@ LExit:
     return hr;
 }
 
+//
+// CompileTheme - writes the theme file as a precompiled theme that loads without parsing XML.
+//
+static HRESULT CompileTheme(
+    __in HINSTANCE hInstance,
+    __in_z_opt LPCWSTR wzThemeFile,
+    __in_z LPCWSTR wzCompileFile
+    )
+{
+    HRESULT hr = S_OK;
+    THEME* pTheme = NULL;
+    BYTE* pbTheme = NULL;
+    SIZE_T cbTheme = 0;
+
+    if (!wzThemeFile)
+    {
+        ExitOnRootFailure(hr = E_INVALIDARG, "Must specify a theme file to compile.");
+    }
+
+    hr = ThemeInitialize(hInstance);
+    ExitOnFailure(hr, "Failed to initialize theme manager.");
+
+    hr = ThemeLoadFromFile(wzThemeFile, &pTheme);
+    ExitOnFailure(hr, "Failed to load theme: %ls", wzThemeFile);
+
+    hr = ThemeSaveToBuffer(pTheme, &pbTheme, &cbTheme);
+    ExitOnFailure(hr, "Failed to save theme: %ls", wzThemeFile);
+
+    hr = FileWrite(wzCompileFile, FILE_ATTRIBUTE_NORMAL, pbTheme, static_cast<DWORD>(cbTheme), NULL);
+    ExitOnFailure(hr, "Failed to write compiled theme: %ls", wzCompileFile);
+
+LExit:
+    ReleaseMem(pbTheme);
+    ThemeFree(pTheme);
+
+    return hr;
+}
+
 static HRESULT CreateTheme(
     __in HINSTANCE hInstance,
     __out THEME** ppTheme
@@ -511,8 +511,17 @@ namespace WixToolset.Bind
                 command.Execute();
             }
 
+            // The engine loads the compiled manifest without parsing any xml.
+            string compiledManifestPath = Path.Combine(this.TempFilesLocation, "bundle-manifest.bin");
+            {
+                CompileBurnManifestCommand command = new CompileBurnManifestCommand();
+                command.ManifestPath = manifestPath;
+                command.OutputPath = compiledManifestPath;
+                command.Execute();
+            }
+
             WixBundleContainerRow uxContainer = containers[Compiler.BurnUXContainerId];
-            this.CreateContainer(uxContainer, uxContainerPayloads, manifestPath);
+            this.CreateContainer(uxContainer, uxContainerPayloads, compiledManifestPath);
 
             // Copy the burn.exe to a writable location then mark it to be moved to its final build location. Note
             // that today, the x64 Burn uses the x86 stub.
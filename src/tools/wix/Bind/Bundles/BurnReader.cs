@@ -103,7 +103,16 @@ namespace WixToolset.Bind.Bundles
 
             Directory.CreateDirectory(Path.GetDirectoryName(manifestPath));
             File.Delete(manifestPath);
-            File.Move(manifestOriginalPath, manifestPath);
+
+            if (CompileBurnManifestCommand.IsCompiled(manifestOriginalPath))
+            {
+                CompileBurnManifestCommand.Decompile(manifestOriginalPath, manifestPath);
+                File.Delete(manifestOriginalPath);
+            }
+            else
+            {
+                File.Move(manifestOriginalPath, manifestPath);
+            }
 
             XmlDocument document = new XmlDocument();
             document.Load(manifestPath);
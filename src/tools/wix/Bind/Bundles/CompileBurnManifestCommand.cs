@@ -0,0 +1,227 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+namespace WixToolset.Bind.Bundles
+{
+    using System;
+    using System.Collections.Generic;
+    using System.IO;
+    using System.Text;
+    using System.Xml;
+
+    /// <summary>
+    /// Compiles the burn manifest into the form the engine loads without parsing xml.
+    /// </summary>
+    /// <remarks>The layout matches XML_READER_COMPILED_HEADER and friends in dutil's xmlreaderutil.h: the header,
+    /// the node records, the attribute records then a table of null terminated UTF-16 strings referenced by
+    /// their offset in characters. Empty elements are written as an element followed by its end element.</remarks>
+    internal class CompileBurnManifestCommand : ICommand
+    {
+        public const UInt32 Signature = 0x4C4D5842; // "BXML"
+        public const UInt32 Version = 1;
+
+        private const UInt32 NodeElement = 1;
+        private const UInt32 NodeEndElement = 2;
+        private const UInt32 NodeText = 3;
+
+        public string ManifestPath { private get; set; }
+
+        public string OutputPath { private get; set; }
+
+        public void Execute()
+        {
+            List<UInt32[]> nodes = new List<UInt32[]>();
+            List<UInt32[]> attributes = new List<UInt32[]>();
+            Dictionary<string, UInt32> strings = new Dictionary<string, UInt32>(StringComparer.Ordinal);
+            StringBuilder stringTable = new StringBuilder();
+
+            XmlReaderSettings settings = new XmlReaderSettings();
+            settings.DtdProcessing = DtdProcessing.Prohibit;
+            settings.IgnoreComments = true;
+            settings.IgnoreProcessingInstructions = true;
+            settings.IgnoreWhitespace = true;
+
+            using (XmlReader reader = XmlReader.Create(this.ManifestPath, settings))
+            {
+                while (reader.Read())
+                {
+                    switch (reader.NodeType)
+                    {
+                        case XmlNodeType.Element:
+                            bool empty = reader.IsEmptyElement;
+                            UInt32 name = CompileString(strings, stringTable, reader.Name);
+                            UInt32 firstAttribute = (UInt32)attributes.Count;
+
+                            while (reader.MoveToNextAttribute())
+                            {
+                                attributes.Add(new UInt32[] { CompileString(strings, stringTable, reader.Name), CompileString(strings, stringTable, reader.Value) });
+                            }
+
+                            nodes.Add(new UInt32[] { NodeElement, name, firstAttribute, (UInt32)attributes.Count - firstAttribute });
+
+                            if (empty)
+                            {
+                                nodes.Add(new UInt32[] { NodeEndElement, name, (UInt32)attributes.Count, 0 });
+                            }
+                            break;
+
+                        case XmlNodeType.EndElement:
+                            nodes.Add(new UInt32[] { NodeEndElement, CompileString(strings, stringTable, reader.Name), (UInt32)attributes.Count, 0 });
+                            break;
+
+                        case XmlNodeType.Text:
+                        case XmlNodeType.CDATA:
+                            nodes.Add(new UInt32[] { NodeText, CompileString(strings, stringTable, reader.Value), (UInt32)attributes.Count, 0 });
+                            break;
+                    }
+                }
+            }
+
+            using (BinaryWriter writer = new BinaryWriter(File.Open(this.OutputPath, FileMode.Create, FileAccess.Write)))
+            {
+                writer.Write(Signature);
+                writer.Write(Version);
+                writer.Write((UInt32)nodes.Count);
+                writer.Write((UInt32)attributes.Count);
+                writer.Write((UInt32)stringTable.Length);
+
+                foreach (UInt32[] node in nodes)
+                {
+                    foreach (UInt32 value in node)
+                    {
+                        writer.Write(value);
+                    }
+                }
+
+                foreach (UInt32[] attribute in attributes)
+                {
+                    writer.Write(attribute[0]);
+                    writer.Write(attribute[1]);
+                }
+
+                writer.Write(Encoding.Unicode.GetBytes(stringTable.ToString()));
+            }
+        }
+
+        /// <summary>
+        /// Checks whether a file starts with the compiled manifest signature.
+        /// </summary>
+        /// <param name="path">Path to the manifest.</param>
+        /// <returns>True if the manifest is compiled.</returns>
+        public static bool IsCompiled(string path)
+        {
+            using (BinaryReader reader = new BinaryReader(File.OpenRead(path)))
+            {
+                return 4 <= reader.BaseStream.Length && Signature == reader.ReadUInt32();
+            }
+        }
+
+        /// <summary>
+        /// Writes a compiled manifest back out as xml.
+        /// </summary>
+        /// <param name="compiledPath">Path to the compiled manifest.</param>
+        /// <param name="xmlPath">Path to write the xml manifest to.</param>
+        public static void Decompile(string compiledPath, string xmlPath)
+        {
+            using (BinaryReader reader = new BinaryReader(File.OpenRead(compiledPath)))
+            {
+                if (Signature != reader.ReadUInt32() || Version != reader.ReadUInt32())
+                {
+                    throw new InvalidDataException(String.Format("The burn manifest '{0}' is not a supported compiled manifest.", compiledPath));
+                }
+
+                int nodeCount = (int)reader.ReadUInt32();
+                int attributeCount = (int)reader.ReadUInt32();
+                int stringsLength = (int)reader.ReadUInt32();
+
+                UInt32[] nodes = new UInt32[nodeCount * 4];
+                for (int i = 0; i < nodes.Length; ++i)
+                {
+                    nodes[i] = reader.ReadUInt32();
+                }
+
+                UInt32[] attributes = new UInt32[attributeCount * 2];
+                for (int i = 0; i < attributes.Length; ++i)
+                {
+                    attributes[i] = reader.ReadUInt32();
+                }
+
+                string stringTable = Encoding.Unicode.GetString(reader.ReadBytes(stringsLength * 2));
+
+                // Names are written as they were read, so prefixes and namespace declarations come back unchanged.
+                using (StreamWriter writer = new StreamWriter(xmlPath, false, new UTF8Encoding(false)))
+                {
+                    writer.Write("<?xml version=\"1.0\" encoding=\"utf-8\"?>");
+
+                    for (int i = 0; i < nodeCount; ++i)
+                    {
+                        UInt32 type = nodes[i * 4];
+                        string value = GetString(stringTable, nodes[i * 4 + 1]);
+
+                        if (NodeElement == type)
+                        {
+                            writer.Write("<{0}", value);
+
+                            for (UInt32 j = 0; j < nodes[i * 4 + 3]; ++j)
+                            {
+                                UInt32 attribute = nodes[i * 4 + 2] + j;
+                                writer.Write(" {0}=\"{1}\"", GetString(stringTable, attributes[attribute * 2]), Escape(GetString(stringTable, attributes[attribute * 2 + 1]), true));
+                            }
+
+                            writer.Write(">");
+                        }
+                        else if (NodeEndElement == type)
+                        {
+                            writer.Write("</{0}>", value);
+                        }
+                        else
+                        {
+                            writer.Write(Escape(value, false));
+                        }
+                    }
+                }
+            }
+        }
+
+        private static UInt32 CompileString(Dictionary<string, UInt32> strings, StringBuilder stringTable, string value)
+        {
+            UInt32 index;
+            if (!strings.TryGetValue(value, out index))
+            {
+                index = (UInt32)stringTable.Length;
+                stringTable.Append(value);
+                stringTable.Append('\0');
+
+                strings.Add(value, index);
+            }
+
+            return index;
+        }
+
+        private static string GetString(string stringTable, UInt32 index)
+        {
+            int end = stringTable.IndexOf('\0', (int)index);
+            return stringTable.Substring((int)index, end - (int)index);
+        }
+
+        private static string Escape(string value, bool attribute)
+        {
+            StringBuilder escaped = new StringBuilder(value.Length);
+            foreach (char c in value)
+            {
+                switch (c)
+                {
+                    case '&': escaped.Append("&amp;"); break;
+                    case '<': escaped.Append("&lt;"); break;
+                    case '>': escaped.Append("&gt;"); break;
+                    case '"': escaped.Append(attribute ? "&quot;" : "\""); break;
+                    case '\r': escaped.Append("&#xD;"); break;
+                    case '\n': escaped.Append(attribute ? "&#xA;" : "\n"); break;
+                    case '\t': escaped.Append(attribute ? "&#x9;" : "\t"); break;
+                    default: escaped.Append(c); break;
+                }
+            }
+
+            return escaped.ToString();
+        }
+    }
+}
@@ -0,0 +1,101 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+
+namespace CfgTests
+{
+    public ref class ManyValuesSync : public CfgTest
+    {
+    public:
+        [Fact]
+        [Trait("Name", "ManyValuesSyncTest")]
+        void ManyValuesSyncTest()
+        {
+            const DWORD cValues = 200;
+            HRESULT hr = S_OK;
+            LPWSTR sczDirRemote = NULL;
+            LPWSTR sczPathRemote = NULL;
+            LPWSTR sczName = NULL;
+            LPWSTR sczValue = NULL;
+            CFGDB_HANDLE cdhLocal = NULL;
+            CFGDB_HANDLE cdhRemote = NULL;
+
+            hr = PathExpand(&sczDirRemote, L"%TEMP%\\TestManyValuesSync\\", PATH_EXPAND_ENVIRONMENT);
+            ExitOnFailure(hr, "Failed to expand path to remote database");
+
+            hr = PathConcat(sczDirRemote, L"Remote.sdf", &sczPathRemote);
+            ExitOnFailure(hr, "Failed to concat path to remote database");
+
+            hr = DirEnsureDelete(sczDirRemote, TRUE, TRUE);
+            if (E_PATHNOTFOUND != hr)
+            {
+                ExitOnFailure(hr, "Failed to delete remote database directory");
+            }
+            hr = S_OK;
+
+            TestInitialize();
+
+            hr = CfgInitialize(&cdhLocal, BackgroundStatusCallback, BackgroundConflictsFoundCallback, reinterpret_cast<LPVOID>(m_pContext));
+            ExitOnFailure(hr, "Failed to initialize user settings engine");
+
+            hr = CfgResumeBackgroundThread(cdhLocal);
+            ExitOnFailure(hr, "Failed to resume background thread");
+
+            hr = CfgCreateRemoteDatabase(sczPathRemote, &cdhRemote);
+            ExitOnFailure(hr, "Failed to create remote database");
+
+            hr = CfgSetProduct(cdhLocal, L"TestManyValuesSync", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to set product in local db");
+
+            // Every set goes through the value and history inserts, so this reuses the prepared inserts many times.
+            for (DWORD i = 0; i < cValues; ++i)
+            {
+                hr = StrAllocFormatted(&sczName, L"Folder%u\\Value%u", i % 20, i);
+                ExitOnFailure(hr, "Failed to format value name");
+
+                hr = StrAllocFormatted(&sczValue, L"Data%u", i * 7);
+                ExitOnFailure(hr, "Failed to format value");
+
+                hr = CfgSetString(cdhLocal, sczName, sczValue);
+                ExitOnFailure(hr, "Failed to set value in local db");
+            }
+
+            hr = CfgRememberDatabase(cdhLocal, cdhRemote, L"Remote", TRUE);
+            ExitOnFailure(hr, "Failed to record remote database in database list");
+            WaitForSyncNoResolve(cdhRemote);
+
+            hr = CfgSetProduct(cdhRemote, L"TestManyValuesSync", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to set product in remote db");
+
+            for (DWORD i = 0; i < cValues; ++i)
+            {
+                hr = StrAllocFormatted(&sczName, L"Folder%u\\Value%u", i % 20, i);
+                ExitOnFailure(hr, "Failed to format value name");
+
+                hr = StrAllocFormatted(&sczValue, L"Data%u", i * 7);
+                ExitOnFailure(hr, "Failed to format value");
+
+                ExpectString(cdhRemote, sczName, sczValue);
+            }
+
+            hr = CfgForgetDatabase(cdhLocal, cdhRemote, L"Remote");
+            ExitOnFailure(hr, "Failed to forget remote database from database list");
+
+            hr = CfgRemoteDisconnect(cdhRemote);
+            ExitOnFailure(hr, "Failed to disconnect remote database");
+
+            hr = CfgUninitialize(cdhLocal);
+            ExitOnFailure(hr, "Failed to shutdown user settings engine");
+
+        LExit:
+            ReleaseStr(sczValue);
+            ReleaseStr(sczName);
+            ReleaseStr(sczPathRemote);
+            ReleaseStr(sczDirRemote);
+            TestUninitialize();
+        }
+    };
+}
@@ -0,0 +1,202 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+
+namespace CfgTests
+{
+    public ref class SyncWatermark : public CfgTest
+    {
+    public:
+        [Fact]
+        [Trait("Name", "SyncWatermarkTest")]
+        void SyncWatermarkTest()
+        {
+            const DWORD cValues = 10;
+            HRESULT hr = S_OK;
+            LPWSTR sczDirRemote = NULL;
+            LPWSTR sczPathRemote = NULL;
+            LPWSTR sczPathBackup = NULL;
+            LPWSTR sczName = NULL;
+            CFGDB_HANDLE cdhLocal = NULL;
+            CFGDB_HANDLE cdhRemote = NULL;
+
+            hr = PathExpand(&sczDirRemote, L"%TEMP%\\TestSyncWatermark\\", PATH_EXPAND_ENVIRONMENT);
+            ExitOnFailure(hr, "Failed to expand path to remote database");
+
+            hr = PathConcat(sczDirRemote, L"Remote.sdf", &sczPathRemote);
+            ExitOnFailure(hr, "Failed to concat path to remote database");
+
+            hr = PathConcat(sczDirRemote, L"Backup.sdf", &sczPathBackup);
+            ExitOnFailure(hr, "Failed to concat path to remote database backup");
+
+            hr = DirEnsureDelete(sczDirRemote, TRUE, TRUE);
+            if (E_PATHNOTFOUND != hr)
+            {
+                ExitOnFailure(hr, "Failed to delete remote database directory");
+            }
+            hr = S_OK;
+
+            TestInitialize();
+
+            hr = CfgInitialize(&cdhLocal, BackgroundStatusCallback, BackgroundConflictsFoundCallback, reinterpret_cast<LPVOID>(m_pContext));
+            ExitOnFailure(hr, "Failed to initialize user settings engine");
+
+            hr = CfgResumeBackgroundThread(cdhLocal);
+            ExitOnFailure(hr, "Failed to resume background thread");
+
+            hr = CfgCreateRemoteDatabase(sczPathRemote, &cdhRemote);
+            ExitOnFailure(hr, "Failed to create remote database");
+
+            // Watermarks are only recorded for registered products
+            hr = CfgRegisterProduct(cdhLocal, L"TestSyncWatermark", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to register product in local db");
+
+            hr = CfgSetProduct(cdhLocal, L"TestSyncWatermark", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to set product in local db");
+
+            for (DWORD i = 0; i < cValues; ++i)
+            {
+                hr = StrAllocFormatted(&sczName, L"Value%u", i);
+                ExitOnFailure(hr, "Failed to format value name");
+
+                hr = CfgSetString(cdhLocal, sczName, L"Original");
+                ExitOnFailure(hr, "Failed to set value in local db");
+            }
+
+            // The remote database has no watermark yet, so the first sync compares every value
+            hr = TestHookCollectSyncStatistics(L"TestSyncWatermark");
+            ExitOnFailure(hr, "Failed to start collecting sync statistics");
+
+            hr = CfgRememberDatabase(cdhLocal, cdhRemote, L"Remote", TRUE);
+            ExitOnFailure(hr, "Failed to record remote database in database list");
+            WaitForSyncNoResolve(cdhRemote);
+
+            ExpectSyncStatistics(FALSE, cValues);
+
+            hr = CfgSetProduct(cdhRemote, L"TestSyncWatermark", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to set product in remote db");
+
+            ExpectString(cdhRemote, L"Value0", L"Original");
+            ExpectString(cdhRemote, L"Value9", L"Original");
+
+            // Keep a copy of the remote database as of this sync to restore later
+            DisconnectRemote(cdhLocal, &cdhRemote);
+
+            hr = FileEnsureCopy(sczPathRemote, sczPathBackup, TRUE);
+            ExitOnFailure(hr, "Failed to back up remote database");
+
+            ConnectRemote(cdhLocal, sczPathRemote, &cdhRemote);
+
+            // Both databases agree on the watermarks, so only the changed value is compared and transferred
+            hr = TestHookCollectSyncStatistics(L"TestSyncWatermark");
+            ExitOnFailure(hr, "Failed to start collecting sync statistics");
+
+            WaitForSqlCeTimestampChange();
+            hr = CfgSetString(cdhLocal, L"Value3", L"Changed");
+            ExitOnFailure(hr, "Failed to change value in local db");
+            WaitForSyncNoResolve(cdhRemote);
+
+            ExpectSyncStatistics(TRUE, 1);
+
+            hr = CfgSetProduct(cdhRemote, L"TestSyncWatermark", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to set product in remote db");
+
+            ExpectString(cdhRemote, L"Value3", L"Changed");
+            ExpectString(cdhRemote, L"Value4", L"Original");
+
+            // Restoring the older copy replaces the remote database's watermark, so the next sync compares every value again
+            DisconnectRemote(cdhLocal, &cdhRemote);
+
+            hr = FileEnsureCopy(sczPathBackup, sczPathRemote, TRUE);
+            ExitOnFailure(hr, "Failed to restore remote database");
+
+            hr = TestHookCollectSyncStatistics(L"TestSyncWatermark");
+            ExitOnFailure(hr, "Failed to start collecting sync statistics");
+
+            ConnectRemote(cdhLocal, sczPathRemote, &cdhRemote);
+
+            ExpectSyncStatistics(FALSE, cValues);
+
+            hr = CfgSetProduct(cdhRemote, L"TestSyncWatermark", L"1.0.0.0", L"abcdabcdabcdabcd");
+            ExitOnFailure(hr, "Failed to set product in remote db");
+
+            ExpectString(cdhRemote, L"Value3", L"Changed");
+            ExpectString(cdhRemote, L"Value4", L"Original");
+
+            hr = CfgForgetDatabase(cdhLocal, cdhRemote, L"Remote");
+            ExitOnFailure(hr, "Failed to forget remote database from database list");
+
+            hr = CfgRemoteDisconnect(cdhRemote);
+            ExitOnFailure(hr, "Failed to disconnect remote database");
+
+            hr = CfgUninitialize(cdhLocal);
+            ExitOnFailure(hr, "Failed to shutdown user settings engine");
+
+        LExit:
+            TestHookCollectSyncStatistics(NULL);
+            ReleaseStr(sczName);
+            ReleaseStr(sczPathBackup);
+            ReleaseStr(sczPathRemote);
+            ReleaseStr(sczDirRemote);
+            TestUninitialize();
+        }
+
+    private:
+        void ConnectRemote(CFGDB_HANDLE cdhLocal, LPCWSTR wzPath, CFGDB_HANDLE *pcdhRemote)
+        {
+            HRESULT hr = S_OK;
+
+            hr = CfgOpenRemoteDatabase(wzPath, pcdhRemote);
+            ExitOnFailure(hr, "Failed to open remote database");
+
+            hr = CfgRememberDatabase(cdhLocal, *pcdhRemote, L"Remote", TRUE);
+            ExitOnFailure(hr, "Failed to record remote database in database list");
+            WaitForSyncNoResolve(*pcdhRemote);
+
+        LExit:
+            return;
+        }
+
+        void DisconnectRemote(CFGDB_HANDLE cdhLocal, CFGDB_HANDLE *pcdhRemote)
+        {
+            HRESULT hr = S_OK;
+
+            hr = CfgForgetDatabase(cdhLocal, *pcdhRemote, L"Remote");
+            ExitOnFailure(hr, "Failed to forget remote database from database list");
+
+            hr = CfgRemoteDisconnect(*pcdhRemote);
+            ExitOnFailure(hr, "Failed to disconnect remote database");
+            *pcdhRemote = NULL;
+
+        LExit:
+            return;
+        }
+
+        // A full sync is the first one after the watermarks are missing or disagree, any syncs after it are incremental
+        void ExpectSyncStatistics(BOOL fExpectIncremental, DWORD cExpectedValuesCompared)
+        {
+            HRESULT hr = S_OK;
+            SYNC_STATISTICS statistics = { };
+
+            hr = TestHookGetSyncStatistics(&statistics);
+            ExitOnFailure(hr, "Failed to get sync statistics");
+
+            if (fExpectIncremental)
+            {
+                Assert::Equal<DWORD>(0, statistics.cFullSyncs);
+                Assert::True(0 < statistics.cIncrementalSyncs);
+            }
+            else
+            {
+                Assert::Equal<DWORD>(1, statistics.cFullSyncs);
+            }
+            Assert::Equal<DWORD>(cExpectedValuesCompared, statistics.cValuesCompared);
+
+        LExit:
+            return;
+        }
+    };
+}
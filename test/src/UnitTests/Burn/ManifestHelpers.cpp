@@ -17,22 +17,34 @@ namespace Test
 {
 namespace Bootstrapper
 {
-    void LoadBundleXmlHelper(LPCWSTR wzDocument, IXMLDOMElement** ppixeBundle)
+    void LoadBundleXmlHelper(LPCWSTR wzDocument, XML_READER* pReader)
     {
         HRESULT hr = S_OK;
-        IXMLDOMDocument* pixdDocument = NULL;
-        try
-        {
-            hr = XmlLoadDocument(wzDocument, &pixdDocument);
-            TestThrowOnFailure(hr, L"Failed to load XML document.");
 
-            hr = pixdDocument->get_documentElement(ppixeBundle);
-            TestThrowOnFailure(hr, L"Failed to get bundle element.");
-        }
-        finally
+        hr = XmlReaderInitialize(wzDocument, pReader);
+        TestThrowOnFailure(hr, L"Failed to load XML document.");
+
+        hr = XmlReaderNextElement(pReader, 0, NULL);
+        TestThrowOnFailure(hr, L"Failed to get bundle element.");
+    }
+
+    BOOL NextBundleElementHelper(XML_READER* pReader, LPCWSTR wzElement)
+    {
+        HRESULT hr = S_OK;
+        LPCWSTR wzName = NULL;
+
+        do
         {
-            ReleaseObject(pixdDocument);
-        }
+            hr = XmlReaderNextElement(pReader, 1, &wzName);
+            TestThrowOnFailure(hr, L"Failed to get next bundle element.");
+
+            if (S_FALSE == hr)
+            {
+                return FALSE;
+            }
+        } while (wzElement && CSTR_EQUAL != ::CompareStringW(LOCALE_INVARIANT, 0, wzName, -1, wzElement, -1));
+
+        return TRUE;
     }
 }
 }
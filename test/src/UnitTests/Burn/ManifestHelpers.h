@@ -14,7 +14,8 @@ namespace Bootstrapper
 {
 
 
-void LoadBundleXmlHelper(LPCWSTR wzDocument, IXMLDOMElement** ppixeBundle);
+void LoadBundleXmlHelper(LPCWSTR wzDocument, XML_READER* pReader);
+BOOL NextBundleElementHelper(XML_READER* pReader, LPCWSTR wzElement);
 
 
 }
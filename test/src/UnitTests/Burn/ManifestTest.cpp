@@ -48,7 +48,444 @@ namespace Bootstrapper
             }
             finally
             {
-                //CoreUninitialize(&engineState);
+                UninitializeManifest(&engineState);
+            }
+        }
+
+        [NamedFact]
+        void ManifestLoadManyPayloadsTest()
+        {
+            const DWORD cPayloads = 200;
+            const DWORD cPackages = 10;
+            const DWORD cPayloadsPerPackage = cPayloads / cPackages;
+            HRESULT hr = S_OK;
+            BURN_ENGINE_STATE engineState = { };
+            BURN_ENGINE_STATE arenaEngineState = { };
+            LPWSTR sczDocument = NULL;
+            LPSTR sczUtf8Document = NULL;
+            DWORD cArenaAllocations = 0;
+            DWORD cArenaBlocks = 0;
+            LPWSTR wzWrite = NULL;
+            size_t cchRemaining = 0;
+
+            try
+            {
+                cchRemaining = 1024 + cPayloads * 192 + cPackages * (256 + cPayloadsPerPackage * 40);
+                hr = StrAlloc(&sczDocument, cchRemaining);
+                TestThrowOnFailure(hr, L"Failed to allocate manifest.");
+
+                wzWrite = sczDocument;
+                hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0,
+                    L"<Bundle>"
+                    L"<UX><Payload Id='ux.dll' FilePath='ux.dll' Packaging='embedded' SourcePath='ux.dll' Hash='000000000000' /></UX>"
+                    L"<Variable Id='Variable1' Type='numeric' Value='1' Hidden='no' Persisted='no' />");
+                TestThrowOnFailure(hr, L"Failed to format manifest header.");
+
+                for (DWORD i = 0; i < cPayloads; ++i)
+                {
+                    hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"<Payload Id='Payload%u' FilePath='files\\payload%u.dat' FileSize='%u' Packaging='external' SourcePath='payload%u.dat' Hash='0123456789ABCDEF' />", i, i, i, i);
+                    TestThrowOnFailure1(hr, L"Failed to format payload %u.", i);
+                }
+
+                hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0,
+                    L"<Registration Id='{D54F896D-1952-43e6-9C67-B5652240618C}' Tag='foo' ProviderKey='foo' Version='1.0.0.0' ExecutableName='setup.exe' PerMachine='no' />"
+                    L"<Chain>");
+                TestThrowOnFailure(hr, L"Failed to format registration.");
+
+                for (DWORD i = 0; i < cPackages; ++i)
+                {
+                    hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"<ExePackage Id='Package%u' Cache='yes' CacheId='Package%u' Size='1' InstallSize='1' PerMachine='no' Permanent='no' Vital='yes' DetectCondition='' InstallArguments='' UninstallArguments='' RepairArguments=''>", i, i);
+                    TestThrowOnFailure1(hr, L"Failed to format package %u.", i);
+
+                    for (DWORD j = 0; j < cPayloadsPerPackage; ++j)
+                    {
+                        hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"<PayloadRef Id='Payload%u' />", i * cPayloadsPerPackage + j);
+                        TestThrowOnFailure1(hr, L"Failed to format payload reference for package %u.", i);
+                    }
+
+                    hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"</ExePackage>");
+                    TestThrowOnFailure1(hr, L"Failed to close package %u.", i);
+                }
+
+                hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"</Chain></Bundle>");
+                TestThrowOnFailure(hr, L"Failed to format manifest footer.");
+
+                hr = StrAnsiAllocString(&sczUtf8Document, sczDocument, 0, CP_UTF8);
+                TestThrowOnFailure(hr, L"Failed to convert manifest to UTF-8.");
+
+                hr = VariableInitialize(&engineState.variables);
+                TestThrowOnFailure(hr, L"Failed to initialize variables.");
+
+                hr = ManifestLoadXmlFromBuffer(reinterpret_cast<BYTE*>(sczUtf8Document), lstrlenA(sczUtf8Document), &engineState);
+                TestThrowOnFailure(hr, L"Failed to load manifest.");
+
+                Assert::Equal<DWORD>(cPayloads, engineState.payloads.cPayloads);
+                Assert::Equal<DWORD>(cPackages, engineState.packages.cPackages);
+                Assert::Equal<DWORD>(cPayloadsPerPackage, engineState.packages.rgPackages[cPackages - 1].cPayloads);
+                Assert::True(&engineState.payloads.rgPayloads[cPayloads - 1] == engineState.packages.rgPackages[cPackages - 1].rgPayloads[cPayloadsPerPackage - 1].pPayload);
+
+                UninitializeManifest(&engineState);
+
+                // The same manifest with its strings allocated from an arena.
+                hr = VariableInitialize(&arenaEngineState.variables);
+                TestThrowOnFailure(hr, L"Failed to initialize variables.");
+
+                hr = MemArenaCreate(0, &arenaEngineState.hManifestArena);
+                TestThrowOnFailure(hr, L"Failed to create manifest arena.");
+
+                hr = ManifestLoadXmlFromBuffer(reinterpret_cast<BYTE*>(sczUtf8Document), lstrlenA(sczUtf8Document), &arenaEngineState);
+                TestThrowOnFailure(hr, L"Failed to load manifest into arena.");
+
+                MemArenaGetStatistics(arenaEngineState.hManifestArena, &cArenaAllocations, &cArenaBlocks, NULL);
+
+                Assert::Equal<DWORD>(cPayloads, arenaEngineState.payloads.cPayloads);
+                NativeAssert::StringEqual(L"files\\payload7.dat", arenaEngineState.payloads.rgPayloads[7].sczFilePath);
+                Assert::True(cArenaAllocations > cPayloads * 4);
+                Assert::True(cArenaBlocks < cArenaAllocations / 100);
+
+                Assert::True(&arenaEngineState.payloads.rgPayloads[cPayloads - 1] == arenaEngineState.packages.rgPackages[cPackages - 1].rgPayloads[cPayloadsPerPackage - 1].pPayload);
+            }
+            finally
+            {
+                UninitializeManifest(&arenaEngineState);
+                ReleaseMemArena(arenaEngineState.hManifestArena);
+                UninitializeManifest(&engineState);
+                ReleaseStr(sczUtf8Document);
+                ReleaseStr(sczDocument);
+            }
+        }
+
+        [NamedFact]
+        void ManifestLoadCompiledTest()
+        {
+            HRESULT hr = S_OK;
+            BURN_ENGINE_STATE xmlState = { };
+            BURN_ENGINE_STATE compiledState = { };
+            BURN_ENGINE_STATE binderState = { };
+            XML_READER reader = { };
+            BYTE* pbCompiled = NULL;
+            SIZE_T cbCompiled = 0;
+            String^ manifestPath = nullptr;
+            String^ binderCompiledPath = nullptr;
+            try
+            {
+                LPCSTR szDocument =
+                    "<?xml version='1.0' encoding='utf-8'?>"
+                    "<BurnManifest xmlns='http://wixtoolset.org/schemas/v4/2008/Burn'>"
+                    "    <!-- comments and whitespace are not compiled -->"
+                    "    <Condition>VersionNT &gt;= v6.1 AND <![CDATA[Installed <> 1]]></Condition>"
+                    "    <Log PathVariable='WixBundleLog' Prefix='Setup' Extension='.log' />"
+                    "    <RelatedBundle Id='{5A3A2D8B-1D2F-4F0C-9B4E-5C9A8E7D6F10}' Action='Upgrade' />"
+                    "    <Variable Id='Variable1' Type='numeric' Value='1' Hidden='no' Persisted='no' />"
+                    "    <Variable Id='Variable2' Type='string' Value='a &amp; &quot;b&quot;' Hidden='no' Persisted='yes' />"
+                    "    <Variable Id='Variable3' Type='version' Value='v1.2.3.4' Hidden='no' Persisted='no' />"
+                    "    <RegistrySearch Id='Search1' Type='exists' Root='HKLM' Key='SOFTWARE\\Microsoft' Variable='Variable1' Condition='Variable1 = 1' />"
+                    "    <DirectorySearch Id='Search2' Type='exists' Path='[WindowsFolder]' Variable='Variable4' />"
+                    "    <UX>"
+                    "        <Payload Id='ux.dll' FilePath='ux.dll' Packaging='embedded' SourcePath='ux.dll' Hash='000000000000' />"
+                    "    </UX>"
+                    "    <Container Id='Container1' FilePath='container1.cab' Attached='no' DownloadUrl='http://example.com/container1.cab' Hash='0123456789ABCDEF' />"
+                    "    <Payload Id='Payload1' FilePath='package1.msi' FileSize='1234' Packaging='embedded' Container='Container1' SourcePath='a1' Hash='0123456789ABCDEF' />"
+                    "    <Payload Id='Payload2' FilePath='package2.exe' FileSize='5678' Packaging='external' SourcePath='package2.exe' DownloadUrl='http://example.com/package2.exe' Hash='FEDCBA9876543210' />"
+                    "    <RollbackBoundary Id='Boundary1' Vital='yes' Transaction='no' />"
+                    "    <Registration Id='{D54F896D-1952-43e6-9C67-B5652240618C}' Tag='foo' ProviderKey='foo' Version='1.0.0.0' ExecutableName='setup.exe' PerMachine='yes'>"
+                    "        <Arp Register='yes' DisplayName='Product &#x4E2D;' DisplayVersion='1.0.0.0' Publisher='Publisher' />"
+                    "    </Registration>"
+                    "    <Chain DisableRollback='no' DisableSystemRestore='yes' ParallelCache='no'>"
+                    "        <MsiPackage Id='Package1' Cache='yes' CacheId='{E0B5A5B6-4B2D-4F0C-8A5E-7C9D8E6F5A41}v1.0.0.0' Size='1234' InstallSize='4321' PerMachine='yes' Permanent='no' Vital='yes' RollbackBoundaryForward='Boundary1' LogPathVariable='Package1Log' InstallCondition='Variable1 = 1' ProductCode='{E0B5A5B6-4B2D-4F0C-8A5E-7C9D8E6F5A41}' Language='1033' Version='1.0.0.0' DisplayInternalUI='no' UpgradeCode='{0F1E2D3C-4B5A-6978-8796-A5B4C3D2E1F0}'>"
+                    "            <MsiFeature Id='Feature1' AddLocalCondition='Variable1' />"
+                    "            <MsiFeature Id='Feature2' />"
+                    "            <MsiProperty Id='PROPERTY1' Value='[Variable2]' RollbackValue='' />"
+                    "            <RelatedPackage Id='{0F1E2D3C-4B5A-6978-8796-A5B4C3D2E1F0}' MaxVersion='1.0.0.0' MaxInclusive='no' OnlyDetect='no' LangInclusive='yes'>"
+                    "                <Language Id='1033' />"
+                    "                <Language Id='1041' />"
+                    "            </RelatedPackage>"
+                    "            <Provides Key='{E0B5A5B6-4B2D-4F0C-8A5E-7C9D8E6F5A41}' Version='1.0.0.0' DisplayName='Package1' />"
+                    "            <PayloadRef Id='Payload1' />"
+                    "        </MsiPackage>"
+                    "        <ExePackage Id='Package2' Cache='yes' CacheId='Package2' Size='5678' InstallSize='5678' PerMachine='yes' Permanent='no' Vital='no' DetectCondition='Variable3 &gt;= v1.2' InstallArguments='/q' UninstallArguments='/u /q' RepairArguments='' Repairable='no' Protocol='none'>"
+                    "            <ExitCode Type='2' Code='3010' />"
+                    "            <ExitCode Type='1' Code='*' />"
+                    "            <PayloadRef Id='Payload2' />"
+                    "        </ExePackage>"
+                    "    </Chain>"
+                    "</BurnManifest>";
+
+                hr = VariableInitialize(&xmlState.variables);
+                TestThrowOnFailure(hr, L"Failed to initialize variables.");
+
+                hr = VariableInitialize(&compiledState.variables);
+                TestThrowOnFailure(hr, L"Failed to initialize variables.");
+
+                hr = VariableInitialize(&binderState.variables);
+                TestThrowOnFailure(hr, L"Failed to initialize variables.");
+
+                hr = ManifestLoadFromBuffer((BYTE*)szDocument, lstrlenA(szDocument), &xmlState);
+                TestThrowOnFailure(hr, L"Failed to load manifest from XML.");
+
+                hr = XmlReaderInitializeFromBuffer((BYTE*)szDocument, lstrlenA(szDocument), &reader);
+                TestThrowOnFailure(hr, L"Failed to initialize xml reader.");
+
+                hr = XmlReaderCompile(&reader, &pbCompiled, &cbCompiled);
+                TestThrowOnFailure(hr, L"Failed to compile manifest.");
+
+                Assert::True(XmlReaderIsCompiled(pbCompiled, cbCompiled));
+                Assert::True(cbCompiled < static_cast<SIZE_T>(lstrlenA(szDocument)) * sizeof(WCHAR));
+
+                hr = ManifestLoadFromBuffer(pbCompiled, cbCompiled, &compiledState);
+                TestThrowOnFailure(hr, L"Failed to load compiled manifest.");
+
+                VerifyEngineStatesEqual(&xmlState, &compiledState);
+
+                // Spot check that the loads did not agree on nothing.
+                NativeAssert::StringEqual(L"VersionNT >= v6.1 AND Installed <> 1", compiledState.condition.sczConditionString);
+                Assert::Equal<String^>(gcnew String(L"a & \"b\""), VariableGetStringHelper(&compiledState.variables, L"Variable2"));
+                NativeAssert::StringEqual(L"Product \x4E2D", compiledState.registration.sczDisplayName);
+                Assert::Equal<DWORD>(2, compiledState.packages.cPackages);
+                Assert::Equal<DWORD>(2, compiledState.packages.rgPackages[0].Msi.rgRelatedMsis[0].cLanguages);
+                Assert::True(compiledState.packages.rgPackages[1].Exe.rgExitCodes[1].fWildcard);
+
+                // A truncated compiled manifest is rejected rather than read past its end.
+                hr = ManifestLoadFromBuffer(pbCompiled, cbCompiled - sizeof(WCHAR), &compiledState);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDDATA);
+
+                // Bundles carry the binder's compiled form, not XmlReaderCompile's, so load that through the engine too.
+                array<Byte>^ rgbDocument = gcnew array<Byte>(lstrlenA(szDocument));
+                System::Runtime::InteropServices::Marshal::Copy(IntPtr(const_cast<LPSTR>(szDocument)), rgbDocument, 0, rgbDocument->Length);
+
+                manifestPath = System::IO::Path::GetTempFileName();
+                binderCompiledPath = System::IO::Path::GetTempFileName();
+                System::IO::File::WriteAllBytes(manifestPath, rgbDocument);
+
+                CompileWithBinder(manifestPath, binderCompiledPath);
+
+                array<Byte>^ rgbBinderCompiled = System::IO::File::ReadAllBytes(binderCompiledPath);
+                pin_ptr<Byte> pbBinderCompiled = &rgbBinderCompiled[0];
+                Assert::True(XmlReaderIsCompiled(pbBinderCompiled, rgbBinderCompiled->Length));
+
+                hr = ManifestLoadFromBuffer(pbBinderCompiled, rgbBinderCompiled->Length, &binderState);
+                TestThrowOnFailure(hr, L"Failed to load manifest compiled by the binder.");
+
+                VerifyEngineStatesEqual(&xmlState, &binderState);
+            }
+            finally
+            {
+                if (binderCompiledPath)
+                {
+                    System::IO::File::Delete(binderCompiledPath);
+                }
+                if (manifestPath)
+                {
+                    System::IO::File::Delete(manifestPath);
+                }
+                UninitializeManifest(&binderState);
+                UninitializeManifest(&compiledState);
+                UninitializeManifest(&xmlState);
+                ReleaseMem(pbCompiled);
+                XmlReaderUninitialize(&reader);
+            }
+        }
+
+    private:
+        static void UninitializeManifest(BURN_ENGINE_STATE* pEngineState)
+        {
+            PackagesUninitialize(&pEngineState->packages);
+            PayloadsUninitialize(&pEngineState->payloads);
+            PayloadsUninitialize(&pEngineState->userExperience.payloads);
+            ContainersUninitialize(&pEngineState->containers);
+            CatalogUninitialize(&pEngineState->catalogs);
+            RegistrationUninitialize(&pEngineState->registration);
+            SearchesUninitialize(&pEngineState->searches);
+            memset(&pEngineState->searches, 0, sizeof(BURN_SEARCHES));
+
+            ReleaseNullStr(pEngineState->condition.sczConditionString);
+            ReleaseNullStr(pEngineState->log.sczPathVariable);
+            ReleaseNullStr(pEngineState->log.sczPrefix);
+            ReleaseNullStr(pEngineState->log.sczExtension);
+
+            if (pEngineState->variables.rgVariables)
+            {
+                VariablesUninitialize(&pEngineState->variables);
+                memset(&pEngineState->variables, 0, sizeof(BURN_VARIABLES));
+            }
+        }
+
+        // CompileBurnManifestCommand is internal to the binder, so it is reached through reflection.
+        static void CompileWithBinder(String^ manifestPath, String^ compiledPath)
+        {
+            Type^ commandType = Reflection::Assembly::Load("wix")->GetType("WixToolset.Bind.Bundles.CompileBurnManifestCommand", true);
+            Object^ command = Activator::CreateInstance(commandType, true);
+
+            commandType->GetProperty("ManifestPath")->SetValue(command, manifestPath, nullptr);
+            commandType->GetProperty("OutputPath")->SetValue(command, compiledPath, nullptr);
+            commandType->GetMethod("Execute")->Invoke(command, nullptr);
+        }
+
+        static void VerifyStringsEqual(LPCWSTR wzExpected, LPCWSTR wzActual)
+        {
+            if (!wzExpected || !wzActual)
+            {
+                Assert::True(wzExpected == wzActual);
+            }
+            else
+            {
+                NativeAssert::StringEqual(wzExpected, wzActual);
+            }
+        }
+
+        static void VerifyEngineStatesEqual(BURN_ENGINE_STATE* pExpected, BURN_ENGINE_STATE* pActual)
+        {
+            VerifyStringsEqual(pExpected->condition.sczConditionString, pActual->condition.sczConditionString);
+            VerifyStringsEqual(pExpected->log.sczPathVariable, pActual->log.sczPathVariable);
+            VerifyStringsEqual(pExpected->log.sczPrefix, pActual->log.sczPrefix);
+            VerifyStringsEqual(pExpected->log.sczExtension, pActual->log.sczExtension);
+            Assert::Equal<BOOL>(pExpected->fDisableRollback, pActual->fDisableRollback);
+            Assert::Equal<BOOL>(pExpected->fDisableSystemRestore, pActual->fDisableSystemRestore);
+            Assert::Equal<BOOL>(pExpected->fParallelCacheAndExecute, pActual->fParallelCacheAndExecute);
+
+            Assert::Equal<DWORD>(pExpected->variables.cVariables, pActual->variables.cVariables);
+            for (DWORD i = 0; i < pExpected->variables.cVariables; ++i)
+            {
+                BURN_VARIABLE* pExpectedVariable = pExpected->variables.rgVariables + i;
+                BURN_VARIABLE* pActualVariable = pActual->variables.rgVariables + i;
+
+                VerifyStringsEqual(pExpectedVariable->sczName, pActualVariable->sczName);
+                Assert::Equal<DWORD>(pExpectedVariable->Value.Type, pActualVariable->Value.Type);
+                Assert::Equal<BOOL>(pExpectedVariable->fPersisted, pActualVariable->fPersisted);
+                Assert::Equal<String^>(VariableGetStringHelper(&pExpected->variables, pExpectedVariable->sczName), VariableGetStringHelper(&pActual->variables, pActualVariable->sczName));
+            }
+
+            Assert::Equal<DWORD>(pExpected->searches.cSearches, pActual->searches.cSearches);
+            for (DWORD i = 0; i < pExpected->searches.cSearches; ++i)
+            {
+                VerifyStringsEqual(pExpected->searches.rgSearches[i].sczKey, pActual->searches.rgSearches[i].sczKey);
+                VerifyStringsEqual(pExpected->searches.rgSearches[i].sczVariable, pActual->searches.rgSearches[i].sczVariable);
+                VerifyStringsEqual(pExpected->searches.rgSearches[i].sczCondition, pActual->searches.rgSearches[i].sczCondition);
+                Assert::Equal<DWORD>(pExpected->searches.rgSearches[i].Type, pActual->searches.rgSearches[i].Type);
+            }
+
+            Assert::Equal<DWORD>(pExpected->containers.cContainers, pActual->containers.cContainers);
+            for (DWORD i = 0; i < pExpected->containers.cContainers; ++i)
+            {
+                VerifyStringsEqual(pExpected->containers.rgContainers[i].sczId, pActual->containers.rgContainers[i].sczId);
+                VerifyStringsEqual(pExpected->containers.rgContainers[i].sczFilePath, pActual->containers.rgContainers[i].sczFilePath);
+                VerifyStringsEqual(pExpected->containers.rgContainers[i].downloadSource.sczUrl, pActual->containers.rgContainers[i].downloadSource.sczUrl);
+                Assert::Equal<DWORD>(pExpected->containers.rgContainers[i].cbHash, pActual->containers.rgContainers[i].cbHash);
+            }
+
+            VerifyPayloadsEqual(&pExpected->userExperience.payloads, &pActual->userExperience.payloads, pExpected->containers.rgContainers, pActual->containers.rgContainers);
+            VerifyPayloadsEqual(&pExpected->payloads, &pActual->payloads, pExpected->containers.rgContainers, pActual->containers.rgContainers);
+
+            VerifyStringsEqual(pExpected->registration.sczId, pActual->registration.sczId);
+            VerifyStringsEqual(pExpected->registration.sczTag, pActual->registration.sczTag);
+            VerifyStringsEqual(pExpected->registration.sczProviderKey, pActual->registration.sczProviderKey);
+            VerifyStringsEqual(pExpected->registration.sczExecutableName, pActual->registration.sczExecutableName);
+            VerifyStringsEqual(pExpected->registration.sczDisplayName, pActual->registration.sczDisplayName);
+            VerifyStringsEqual(pExpected->registration.sczPublisher, pActual->registration.sczPublisher);
+            Assert::Equal<DWORD64>(pExpected->registration.qwVersion, pActual->registration.qwVersion);
+            Assert::Equal<BOOL>(pExpected->registration.fPerMachine, pActual->registration.fPerMachine);
+            Assert::Equal<BOOL>(pExpected->registration.fRegisterArp, pActual->registration.fRegisterArp);
+            Assert::Equal<DWORD>(pExpected->registration.cUpgradeCodes, pActual->registration.cUpgradeCodes);
+            for (DWORD i = 0; i < pExpected->registration.cUpgradeCodes; ++i)
+            {
+                VerifyStringsEqual(pExpected->registration.rgsczUpgradeCodes[i], pActual->registration.rgsczUpgradeCodes[i]);
+            }
+
+            Assert::Equal<DWORD>(pExpected->packages.cRollbackBoundaries, pActual->packages.cRollbackBoundaries);
+            Assert::Equal<DWORD>(pExpected->packages.cPackages, pActual->packages.cPackages);
+            for (DWORD i = 0; i < pExpected->packages.cPackages; ++i)
+            {
+                VerifyPackagesEqual(pExpected, pActual, pExpected->packages.rgPackages + i, pActual->packages.rgPackages + i);
+            }
+        }
+
+        static void VerifyPayloadsEqual(BURN_PAYLOADS* pExpected, BURN_PAYLOADS* pActual, BURN_CONTAINER* rgExpectedContainers, BURN_CONTAINER* rgActualContainers)
+        {
+            Assert::Equal<DWORD>(pExpected->cPayloads, pActual->cPayloads);
+            for (DWORD i = 0; i < pExpected->cPayloads; ++i)
+            {
+                BURN_PAYLOAD* pExpectedPayload = pExpected->rgPayloads + i;
+                BURN_PAYLOAD* pActualPayload = pActual->rgPayloads + i;
+
+                VerifyStringsEqual(pExpectedPayload->sczKey, pActualPayload->sczKey);
+                VerifyStringsEqual(pExpectedPayload->sczFilePath, pActualPayload->sczFilePath);
+                VerifyStringsEqual(pExpectedPayload->sczSourcePath, pActualPayload->sczSourcePath);
+                VerifyStringsEqual(pExpectedPayload->downloadSource.sczUrl, pActualPayload->downloadSource.sczUrl);
+                Assert::Equal<DWORD>(pExpectedPayload->packaging, pActualPayload->packaging);
+                Assert::Equal<DWORD64>(pExpectedPayload->qwFileSize, pActualPayload->qwFileSize);
+                Assert::Equal<DWORD>(pExpectedPayload->cbHash, pActualPayload->cbHash);
+                Assert::True(0 == memcmp(pExpectedPayload->pbHash, pActualPayload->pbHash, pExpectedPayload->cbHash));
+                Assert::Equal<INT_PTR>(pExpectedPayload->pContainer ? pExpectedPayload->pContainer - rgExpectedContainers : -1, pActualPayload->pContainer ? pActualPayload->pContainer - rgActualContainers : -1);
+            }
+        }
+
+        static void VerifyPackagesEqual(BURN_ENGINE_STATE* pExpectedState, BURN_ENGINE_STATE* pActualState, BURN_PACKAGE* pExpected, BURN_PACKAGE* pActual)
+        {
+            VerifyStringsEqual(pExpected->sczId, pActual->sczId);
+            VerifyStringsEqual(pExpected->sczCacheId, pActual->sczCacheId);
+            VerifyStringsEqual(pExpected->sczInstallCondition, pActual->sczInstallCondition);
+            VerifyStringsEqual(pExpected->sczLogPathVariable, pActual->sczLogPathVariable);
+            Assert::Equal<DWORD>(pExpected->type, pActual->type);
+            Assert::Equal<DWORD>(pExpected->cacheType, pActual->cacheType);
+            Assert::Equal<DWORD64>(pExpected->qwSize, pActual->qwSize);
+            Assert::Equal<DWORD64>(pExpected->qwInstallSize, pActual->qwInstallSize);
+            Assert::Equal<BOOL>(pExpected->fPerMachine, pActual->fPerMachine);
+            Assert::Equal<BOOL>(pExpected->fUninstallable, pActual->fUninstallable);
+            Assert::Equal<BOOL>(pExpected->fVital, pActual->fVital);
+            Assert::Equal<DWORD>(pExpected->cDependencyProviders, pActual->cDependencyProviders);
+
+            Assert::Equal<DWORD>(pExpected->cPayloads, pActual->cPayloads);
+            for (DWORD i = 0; i < pExpected->cPayloads; ++i)
+            {
+                Assert::Equal<INT_PTR>(pExpected->rgPayloads[i].pPayload - pExpectedState->payloads.rgPayloads, pActual->rgPayloads[i].pPayload - pActualState->payloads.rgPayloads);
+            }
+
+            if (BURN_PACKAGE_TYPE_MSI == pExpected->type)
+            {
+                VerifyStringsEqual(pExpected->Msi.sczProductCode, pActual->Msi.sczProductCode);
+                VerifyStringsEqual(pExpected->Msi.sczUpgradeCode, pActual->Msi.sczUpgradeCode);
+                Assert::Equal<DWORD64>(pExpected->Msi.qwVersion, pActual->Msi.qwVersion);
+                Assert::Equal<DWORD>(pExpected->Msi.dwLanguage, pActual->Msi.dwLanguage);
+
+                Assert::Equal<DWORD>(pExpected->Msi.cFeatures, pActual->Msi.cFeatures);
+                for (DWORD i = 0; i < pExpected->Msi.cFeatures; ++i)
+                {
+                    VerifyStringsEqual(pExpected->Msi.rgFeatures[i].sczId, pActual->Msi.rgFeatures[i].sczId);
+                    VerifyStringsEqual(pExpected->Msi.rgFeatures[i].sczAddLocalCondition, pActual->Msi.rgFeatures[i].sczAddLocalCondition);
+                }
+
+                Assert::Equal<DWORD>(pExpected->Msi.cProperties, pActual->Msi.cProperties);
+                for (DWORD i = 0; i < pExpected->Msi.cProperties; ++i)
+                {
+                    VerifyStringsEqual(pExpected->Msi.rgProperties[i].sczId, pActual->Msi.rgProperties[i].sczId);
+                    VerifyStringsEqual(pExpected->Msi.rgProperties[i].sczValue, pActual->Msi.rgProperties[i].sczValue);
+                    VerifyStringsEqual(pExpected->Msi.rgProperties[i].sczRollbackValue, pActual->Msi.rgProperties[i].sczRollbackValue);
+                }
+
+                Assert::Equal<DWORD>(pExpected->Msi.cRelatedMsis, pActual->Msi.cRelatedMsis);
+                for (DWORD i = 0; i < pExpected->Msi.cRelatedMsis; ++i)
+                {
+                    BURN_RELATED_MSI* pExpectedRelated = pExpected->Msi.rgRelatedMsis + i;
+                    BURN_RELATED_MSI* pActualRelated = pActual->Msi.rgRelatedMsis + i;
+
+                    VerifyStringsEqual(pExpectedRelated->sczUpgradeCode, pActualRelated->sczUpgradeCode);
+                    Assert::Equal<DWORD64>(pExpectedRelated->qwMaxVersion, pActualRelated->qwMaxVersion);
+                    Assert::Equal<BOOL>(pExpectedRelated->fMaxInclusive, pActualRelated->fMaxInclusive);
+                    Assert::Equal<BOOL>(pExpectedRelated->fLangInclusive, pActualRelated->fLangInclusive);
+                    Assert::Equal<DWORD>(pExpectedRelated->cLanguages, pActualRelated->cLanguages);
+                    Assert::True(0 == memcmp(pExpectedRelated->rgdwLanguages, pActualRelated->rgdwLanguages, pExpectedRelated->cLanguages * sizeof(DWORD)));
+                }
+            }
+            else if (BURN_PACKAGE_TYPE_EXE == pExpected->type)
+            {
+                VerifyStringsEqual(pExpected->Exe.sczDetectCondition, pActual->Exe.sczDetectCondition);
+                VerifyStringsEqual(pExpected->Exe.sczInstallArguments, pActual->Exe.sczInstallArguments);
+                VerifyStringsEqual(pExpected->Exe.sczUninstallArguments, pActual->Exe.sczUninstallArguments);
+                VerifyStringsEqual(pExpected->Exe.sczRepairArguments, pActual->Exe.sczRepairArguments);
+                Assert::Equal<DWORD>(pExpected->Exe.protocol, pActual->Exe.protocol);
+
+                Assert::Equal<DWORD>(pExpected->Exe.cExitCodes, pActual->Exe.cExitCodes);
+                Assert::True(0 == memcmp(pExpected->Exe.rgExitCodes, pActual->Exe.rgExitCodes, pExpected->Exe.cExitCodes * sizeof(BURN_EXE_EXIT_CODE)));
             }
         }
     };
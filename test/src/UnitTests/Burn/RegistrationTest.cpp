@@ -61,7 +61,7 @@ namespace Bootstrapper
         void RegisterBasicTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             LPWSTR sczCurrentProcess = NULL;
             BURN_VARIABLES variables = { };
             BURN_USER_EXPERIENCE userExperience = { };
@@ -89,15 +89,17 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
                 hr = VariableInitialize(&variables);
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
-                hr = UserExperienceParseFromXml(&userExperience, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"UX"));
+                hr = UserExperienceParseFromXml(&userExperience, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse UX from XML.");
 
-                hr = RegistrationParseFromXml(&registration, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"Registration"));
+                hr = RegistrationParseFromXml(&registration, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse registration from XML.");
 
                 hr = PlanSetResumeCommand(&registration, BOOTSTRAPPER_ACTION_INSTALL, &command, &logging);
@@ -130,7 +132,7 @@ namespace Bootstrapper
             finally
             {
                 ReleaseStr(sczCurrentProcess);
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 UserExperienceUninitialize(&userExperience);
                 RegistrationUninitialize(&registration);
                 VariablesUninitialize(&variables);
@@ -149,7 +151,7 @@ namespace Bootstrapper
         void RegisterArpMinimumTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             LPWSTR sczCurrentProcess = NULL;
             BURN_VARIABLES variables = { };
             BURN_USER_EXPERIENCE userExperience = { };
@@ -177,15 +179,17 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
                 hr = VariableInitialize(&variables);
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
-                hr = UserExperienceParseFromXml(&userExperience, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"UX"));
+                hr = UserExperienceParseFromXml(&userExperience, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse UX from XML.");
 
-                hr = RegistrationParseFromXml(&registration, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"Registration"));
+                hr = RegistrationParseFromXml(&registration, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse registration from XML.");
 
                 hr = PlanSetResumeCommand(&registration, BOOTSTRAPPER_ACTION_INSTALL, &command, &logging);
@@ -240,7 +244,7 @@ namespace Bootstrapper
             finally
             {
                 ReleaseStr(sczCurrentProcess);
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 UserExperienceUninitialize(&userExperience);
                 RegistrationUninitialize(&registration);
                 VariablesUninitialize(&variables);
@@ -259,7 +263,7 @@ namespace Bootstrapper
         void RegisterArpFullTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             LPWSTR sczCurrentProcess = NULL;
             BURN_VARIABLES variables = { };
             BURN_USER_EXPERIENCE userExperience = { };
@@ -289,15 +293,17 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
                 hr = VariableInitialize(&variables);
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
-                hr = UserExperienceParseFromXml(&userExperience, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"UX"));
+                hr = UserExperienceParseFromXml(&userExperience, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse UX from XML.");
 
-                hr = RegistrationParseFromXml(&registration, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"Registration"));
+                hr = RegistrationParseFromXml(&registration, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse registration from XML.");
 
                 hr = PlanSetResumeCommand(&registration, BOOTSTRAPPER_ACTION_INSTALL, &command, &logging);
@@ -363,7 +369,7 @@ namespace Bootstrapper
             finally
             {
                 ReleaseStr(sczCurrentProcess);
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 UserExperienceUninitialize(&userExperience);
                 RegistrationUninitialize(&registration);
                 VariablesUninitialize(&variables);
@@ -382,7 +388,7 @@ namespace Bootstrapper
         void ResumeTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             LPWSTR sczCurrentProcess = NULL;
             BURN_VARIABLES variables = { };
             BURN_USER_EXPERIENCE userExperience = { };
@@ -419,15 +425,17 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
                 hr = VariableInitialize(&variables);
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
-                hr = UserExperienceParseFromXml(&userExperience, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"UX"));
+                hr = UserExperienceParseFromXml(&userExperience, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse UX from XML.");
 
-                hr = RegistrationParseFromXml(&registration, pixeBundle);
+                Assert::True(NextBundleElementHelper(&reader, L"Registration"));
+                hr = RegistrationParseFromXml(&registration, &reader);
                 TestThrowOnFailure(hr, L"Failed to parse registration from XML.");
 
                 hr = PlanSetResumeCommand(&registration, BOOTSTRAPPER_ACTION_INSTALL, &command, &logging);
@@ -495,7 +503,7 @@ namespace Bootstrapper
             finally
             {
                 ReleaseStr(sczCurrentProcess);
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 UserExperienceUninitialize(&userExperience);
                 RegistrationUninitialize(&registration);
                 VariablesUninitialize(&variables);
@@ -0,0 +1,188 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+
+#define TEST_UPGRADE_CODE L"{B3A9E3C1-31A7-4CB5-9A6C-0BCC3B9C9A11}"
+#define TEST_ADDON_CODE L"{3A5C2F4D-8E0E-4C7B-A0B8-55B1A55E1F22}"
+#define TEST_DETECT_CODE L"{C6B1D0A4-0E56-4BB8-9E2B-4D0C7D3A8F33}"
+#define TEST_PATCH_CODE L"{5D0E7B9A-2C4F-47A1-8C1E-9F6A2B3C4D44}"
+
+namespace Microsoft
+{
+namespace Tools
+{
+namespace WindowsInstallerXml
+{
+namespace Test
+{
+namespace Bootstrapper
+{
+    using namespace System;
+    using namespace WixTest;
+    using namespace Xunit;
+
+    public ref class RelatedBundleTest : BurnUnitTest
+    {
+    public:
+        [NamedFact]
+        void RelatedBundleCodesRelationTypeTest()
+        {
+            HRESULT hr = S_OK;
+            LPCWSTR rgwzUpgradeCodes[] = { TEST_UPGRADE_CODE };
+            LPCWSTR rgwzAddonCodes[] = { TEST_ADDON_CODE };
+            LPCWSTR rgwzDetectCodes[] = { TEST_DETECT_CODE, TEST_UPGRADE_CODE };
+            LPCWSTR rgwzPatchCodes[] = { TEST_PATCH_CODE };
+            LPCWSTR rgwzOther[] = { L"{00000000-0000-0000-0000-000000000000}" };
+            LPCWSTR rgwzUpgradeLower[] = { L"{b3a9e3c1-31a7-4cb5-9a6c-0bcc3b9c9a11}" };
+            LPCWSTR rgwzDetect[] = { TEST_DETECT_CODE };
+            LPCWSTR rgwzAddon[] = { TEST_ADDON_CODE };
+            LPCWSTR rgwzPatch[] = { TEST_PATCH_CODE };
+            BURN_REGISTRATION registration = { };
+            BURN_RELATED_BUNDLE_CODES codes = { };
+
+            try
+            {
+                InitializeRegistrationCodes(&registration, rgwzUpgradeCodes, 1, rgwzAddonCodes, 1, rgwzDetectCodes, 2, rgwzPatchCodes, 1);
+
+                hr = RelatedBundleCodesInitialize(&registration, &codes);
+                TestThrowOnFailure(hr, L"Failed to initialize related bundle codes.");
+
+                // Our upgrade code is also one of our detect codes, so it is only indexed once.
+                Assert::Equal<DWORD>(4, codes.cCodes);
+
+                // Upgrade codes match case-insensitively and upgrade wins over detect.
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_UPGRADE, RelationType(&codes, rgwzUpgradeLower, 1, NULL, 0, NULL, 0, NULL, 0));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_DETECT, RelationType(&codes, rgwzDetect, 1, NULL, 0, NULL, 0, NULL, 0));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_DEPENDENT, RelationType(&codes, rgwzAddon, 1, NULL, 0, NULL, 0, NULL, 0));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_DEPENDENT, RelationType(&codes, rgwzPatch, 1, NULL, 0, NULL, 0, NULL, 0));
+
+                // Their addon and patch codes relate to our detect and upgrade codes.
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_ADDON, RelationType(&codes, rgwzOther, 1, rgwzDetect, 1, NULL, 0, NULL, 0));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_ADDON, RelationType(&codes, NULL, 0, rgwzUpgradeLower, 1, rgwzDetect, 1, NULL, 0));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_PATCH, RelationType(&codes, NULL, 0, rgwzAddon, 1, rgwzUpgradeLower, 1, NULL, 0));
+
+                // Their detect codes.
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_DETECT, RelationType(&codes, NULL, 0, NULL, 0, NULL, 0, rgwzDetect, 1));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_DEPENDENT, RelationType(&codes, NULL, 0, NULL, 0, NULL, 0, rgwzPatch, 1));
+
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_NONE, RelationType(&codes, rgwzOther, 1, rgwzOther, 1, rgwzOther, 1, rgwzOther, 1));
+                Assert::Equal<DWORD>(BOOTSTRAPPER_RELATION_NONE, RelationType(&codes, NULL, 0, NULL, 0, NULL, 0, NULL, 0));
+            }
+            finally
+            {
+                RelatedBundleCodesUninitialize(&codes);
+            }
+        }
+
+        [NamedFact]
+        void RelatedBundleCodesSyntheticArpTest()
+        {
+            const DWORD cEntries = 10000;
+            const DWORD cCodesPerEntry = 3;
+            HRESULT hr = S_OK;
+            LPCWSTR rgwzUpgradeCodes[] = { TEST_UPGRADE_CODE };
+            LPCWSTR rgwzAddonCodes[] = { TEST_ADDON_CODE };
+            LPCWSTR rgwzDetectCodes[] = { TEST_DETECT_CODE };
+            LPCWSTR rgwzPatchCodes[] = { TEST_PATCH_CODE };
+            BURN_REGISTRATION registration = { };
+            BURN_RELATED_BUNDLE_CODES codes = { };
+            LPWSTR* rgsczEntryCodes = NULL;
+            DWORD rgcRelations[BOOTSTRAPPER_RELATION_UPDATE + 1] = { };
+
+            try
+            {
+                InitializeRegistrationCodes(&registration, rgwzUpgradeCodes, 1, rgwzAddonCodes, 1, rgwzDetectCodes, 1, rgwzPatchCodes, 1);
+
+                // Every entry gets its own upgrade codes, except that every 100th one upgrades us
+                // and the one after it is an addon of ours.
+                rgsczEntryCodes = static_cast<LPWSTR*>(MemAlloc(sizeof(LPWSTR) * cEntries * cCodesPerEntry, TRUE));
+                Assert::True(NULL != rgsczEntryCodes);
+
+                for (DWORD i = 0; i < cEntries * cCodesPerEntry; ++i)
+                {
+                    hr = StrAllocFormatted(&rgsczEntryCodes[i], L"{%08X-0000-0000-0000-%012u}", i / cCodesPerEntry, i % cCodesPerEntry);
+                    TestThrowOnFailure(hr, L"Failed to format synthetic code.");
+                }
+
+                for (DWORD i = 0; i < cEntries; i += 100)
+                {
+                    hr = StrAllocString(&rgsczEntryCodes[i * cCodesPerEntry + 2], TEST_UPGRADE_CODE, 0);
+                    TestThrowOnFailure(hr, L"Failed to copy upgrade code.");
+                }
+
+                hr = RelatedBundleCodesInitialize(&registration, &codes);
+                TestThrowOnFailure(hr, L"Failed to initialize related bundle codes.");
+
+                for (DWORD i = 0; i < cEntries; ++i)
+                {
+                    LPWSTR* rgsczCodes = rgsczEntryCodes + i * cCodesPerEntry;
+                    BOOL fAddon = 1 == i % 100;
+                    LPWSTR rgsczAddon[] = { const_cast<LPWSTR>(TEST_DETECT_CODE) };
+
+                    BOOTSTRAPPER_RELATION_TYPE relationType = RelatedBundleCodesDetermineRelationType(&codes, rgsczCodes, cCodesPerEntry, fAddon ? rgsczAddon : NULL, fAddon ? 1 : 0, NULL, 0, rgsczCodes, cCodesPerEntry);
+                    ++rgcRelations[relationType];
+                }
+
+                Assert::Equal<DWORD>(cEntries / 100, rgcRelations[BOOTSTRAPPER_RELATION_UPGRADE]);
+                Assert::Equal<DWORD>(cEntries / 100, rgcRelations[BOOTSTRAPPER_RELATION_ADDON]);
+                Assert::Equal<DWORD>(cEntries - 2 * (cEntries / 100), rgcRelations[BOOTSTRAPPER_RELATION_NONE]);
+            }
+            finally
+            {
+                RelatedBundleCodesUninitialize(&codes);
+
+                if (rgsczEntryCodes)
+                {
+                    StrArrayFree(rgsczEntryCodes, cEntries * cCodesPerEntry);
+                }
+            }
+        }
+
+    private:
+        void InitializeRegistrationCodes(
+            __in BURN_REGISTRATION* pRegistration,
+            __in_ecount(cUpgradeCodes) LPCWSTR* rgwzUpgradeCodes,
+            __in DWORD cUpgradeCodes,
+            __in_ecount(cAddonCodes) LPCWSTR* rgwzAddonCodes,
+            __in DWORD cAddonCodes,
+            __in_ecount(cDetectCodes) LPCWSTR* rgwzDetectCodes,
+            __in DWORD cDetectCodes,
+            __in_ecount(cPatchCodes) LPCWSTR* rgwzPatchCodes,
+            __in DWORD cPatchCodes
+            )
+        {
+            pRegistration->rgsczUpgradeCodes = const_cast<LPWSTR*>(rgwzUpgradeCodes);
+            pRegistration->cUpgradeCodes = cUpgradeCodes;
+            pRegistration->rgsczAddonCodes = const_cast<LPWSTR*>(rgwzAddonCodes);
+            pRegistration->cAddonCodes = cAddonCodes;
+            pRegistration->rgsczDetectCodes = const_cast<LPWSTR*>(rgwzDetectCodes);
+            pRegistration->cDetectCodes = cDetectCodes;
+            pRegistration->rgsczPatchCodes = const_cast<LPWSTR*>(rgwzPatchCodes);
+            pRegistration->cPatchCodes = cPatchCodes;
+        }
+
+        DWORD RelationType(
+            __in BURN_RELATED_BUNDLE_CODES* pCodes,
+            __in_ecount(cUpgradeCodes) LPCWSTR* rgwzUpgradeCodes,
+            __in DWORD cUpgradeCodes,
+            __in_ecount(cAddonCodes) LPCWSTR* rgwzAddonCodes,
+            __in DWORD cAddonCodes,
+            __in_ecount(cPatchCodes) LPCWSTR* rgwzPatchCodes,
+            __in DWORD cPatchCodes,
+            __in_ecount(cDetectCodes) LPCWSTR* rgwzDetectCodes,
+            __in DWORD cDetectCodes
+            )
+        {
+            return RelatedBundleCodesDetermineRelationType(pCodes,
+                const_cast<LPWSTR*>(rgwzUpgradeCodes), cUpgradeCodes,
+                const_cast<LPWSTR*>(rgwzAddonCodes), cAddonCodes,
+                const_cast<LPWSTR*>(rgwzPatchCodes), cPatchCodes,
+                const_cast<LPWSTR*>(rgwzDetectCodes), cDetectCodes);
+        }
+    };
+}
+}
+}
+}
+}
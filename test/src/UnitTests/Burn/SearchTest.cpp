@@ -50,7 +50,7 @@ namespace Bootstrapper
         void DirectorySearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             try
@@ -71,10 +71,13 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -86,7 +89,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -96,7 +99,7 @@ namespace Bootstrapper
         void FileSearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             ULARGE_INTEGER uliVersion = { };
@@ -122,10 +125,13 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -138,7 +144,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -148,7 +154,7 @@ namespace Bootstrapper
         void RegistrySearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             HKEY hkey32 = NULL;
@@ -217,10 +223,13 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -261,7 +270,7 @@ namespace Bootstrapper
             {
                 ReleaseRegKey(hkey32);
                 ReleaseRegKey(hkey64);
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
 
@@ -280,7 +289,7 @@ namespace Bootstrapper
         void MsiComponentSearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             try
@@ -315,10 +324,13 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -347,7 +359,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -357,7 +369,7 @@ namespace Bootstrapper
         void MsiProductSearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             try
@@ -379,10 +391,13 @@ namespace Bootstrapper
                     L"</Bundle>";
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -398,7 +413,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -408,7 +423,7 @@ namespace Bootstrapper
         void MsiFeatureSearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             try
@@ -422,10 +437,13 @@ namespace Bootstrapper
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -433,7 +451,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -443,7 +461,7 @@ namespace Bootstrapper
         void ConditionalSearchTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             try
@@ -459,10 +477,13 @@ namespace Bootstrapper
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -475,7 +496,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -484,7 +505,7 @@ namespace Bootstrapper
         void NoSearchesTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             BURN_SEARCHES searches = { };
             try
@@ -497,10 +518,13 @@ namespace Bootstrapper
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = SearchesParseFromXml(&searches, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, NULL))
+                {
+                    hr = SearchParseFromXml(&searches, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // execute searches
                 hr = SearchesExecute(&searches, &variables);
@@ -508,7 +532,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
                 SearchesUninitialize(&searches);
             }
@@ -0,0 +1,284 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+
+// Keep in sync with the constants in section.cpp.
+#define TEST_BURN_SECTION_MAGIC 0x00f14300
+#define TEST_BURN_SECTION_VERSION 0x00000002
+
+const DWORD TEST_SECTION_SIZE = 0x200;
+const DWORD TEST_UX_CONTAINER_SIZE = 0x1000;
+const DWORD TEST_ATTACHED_CONTAINER_SIZE = 0x800;
+const DWORD TEST_SIGNATURE_SIZE = 0x100;
+
+typedef struct _SECTION_TEST_BUNDLE
+{
+    DWORD dwSectionOffset;
+    DWORD dwVersion;
+    BOOL fBadDosSignature;
+    BOOL fNoBurnSection;
+    BOOL fSigned;
+    BOOL fOriginalSignature;
+    BOOL fAttachedContainerPresent;
+} SECTION_TEST_BUNDLE;
+
+static HRESULT WriteTestBundle(
+    __in_z LPCWSTR wzPath,
+    __in const SECTION_TEST_BUNDLE* pBundle
+    );
+
+
+namespace Microsoft
+{
+namespace Tools
+{
+namespace WindowsInstallerXml
+{
+namespace Test
+{
+namespace Bootstrapper
+{
+    using namespace System;
+    using namespace WixTest;
+    using namespace Xunit;
+
+    public ref class SectionTest : BurnUnitTest
+    {
+    public:
+        [NamedFact]
+        void SectionParseTest()
+        {
+            SECTION_TEST_BUNDLE bundle = { };
+            BURN_SECTION section = { };
+            DWORD64 qwOffset = 0;
+            DWORD64 qwSize = 0;
+            BOOL fPresent = FALSE;
+
+            // Unsigned bundle with its attached container.
+            bundle.dwSectionOffset = 0x400;
+            bundle.dwVersion = TEST_BURN_SECTION_VERSION;
+            bundle.fAttachedContainerPresent = TRUE;
+            ParseAllWays(&bundle, S_OK, &section);
+            try
+            {
+                DWORD cbStub = bundle.dwSectionOffset + TEST_SECTION_SIZE;
+
+                NativeAssert::Equal<DWORD>(cbStub, section.cbStub);
+                NativeAssert::Equal<DWORD>(cbStub + TEST_UX_CONTAINER_SIZE, section.cbEngineSize);
+                NativeAssert::Equal<DWORD64>(cbStub + TEST_UX_CONTAINER_SIZE + TEST_ATTACHED_CONTAINER_SIZE, section.qwBundleSize);
+                NativeAssert::Equal<DWORD>(bundle.dwSectionOffset + 8 + sizeof(GUID) + sizeof(DWORD), section.dwOriginalChecksumAndSignatureOffset);
+                NativeAssert::Equal<DWORD>(BURN_CONTAINER_TYPE_CABINET, section.dwFormat);
+                NativeAssert::Equal<DWORD>(2, section.cContainers);
+
+                NativeAssert::Succeeded(SectionGetAttachedContainerInfo(&section, 0, BURN_CONTAINER_TYPE_CABINET, &qwOffset, &qwSize, &fPresent), "Failed to get UX container info.");
+                NativeAssert::Equal<DWORD64>(cbStub, qwOffset);
+                NativeAssert::Equal<DWORD64>(TEST_UX_CONTAINER_SIZE, qwSize);
+                Assert::True(fPresent);
+
+                NativeAssert::Succeeded(SectionGetAttachedContainerInfo(&section, 1, BURN_CONTAINER_TYPE_CABINET, &qwOffset, &qwSize, &fPresent), "Failed to get attached container info.");
+                NativeAssert::Equal<DWORD64>(cbStub + TEST_UX_CONTAINER_SIZE, qwOffset);
+                NativeAssert::Equal<DWORD64>(TEST_ATTACHED_CONTAINER_SIZE, qwSize);
+                Assert::True(fPresent);
+            }
+            finally
+            {
+                SectionUninitialize(&section);
+            }
+
+            // Without its attached container, with the section far enough in that a small window has to move to reach it.
+            bundle.dwSectionOffset = 0x30000;
+            bundle.fAttachedContainerPresent = FALSE;
+            ParseAllWays(&bundle, S_OK, &section);
+            try
+            {
+                NativeAssert::Succeeded(SectionGetAttachedContainerInfo(&section, 1, BURN_CONTAINER_TYPE_CABINET, &qwOffset, &qwSize, &fPresent), "Failed to get attached container info.");
+                Assert::False(fPresent);
+            }
+            finally
+            {
+                SectionUninitialize(&section);
+            }
+
+            // Signed bundle uses the signature to find the end of the engine.
+            bundle.fSigned = TRUE;
+            ParseAllWays(&bundle, S_OK, &section);
+            try
+            {
+                NativeAssert::Equal<DWORD>(bundle.dwSectionOffset + TEST_SECTION_SIZE + TEST_UX_CONTAINER_SIZE + TEST_SIGNATURE_SIZE, section.cbEngineSize);
+            }
+            finally
+            {
+                SectionUninitialize(&section);
+            }
+
+            // The original signature wins over the current one.
+            bundle.fOriginalSignature = TRUE;
+            ParseAllWays(&bundle, S_OK, &section);
+            try
+            {
+                NativeAssert::Equal<DWORD>(bundle.dwSectionOffset + TEST_SECTION_SIZE + TEST_UX_CONTAINER_SIZE + TEST_SIGNATURE_SIZE / 2, section.cbEngineSize);
+            }
+            finally
+            {
+                SectionUninitialize(&section);
+            }
+
+            // Corrupt bundles fail the same way however they are read.
+            bundle.fBadDosSignature = TRUE;
+            ParseAllWays(&bundle, HRESULT_FROM_WIN32(ERROR_INVALID_DATA), &section);
+
+            bundle.fBadDosSignature = FALSE;
+            bundle.fNoBurnSection = TRUE;
+            ParseAllWays(&bundle, HRESULT_FROM_WIN32(ERROR_INVALID_DATA), &section);
+
+            bundle.fNoBurnSection = FALSE;
+            bundle.dwVersion = TEST_BURN_SECTION_VERSION + 1;
+            ParseAllWays(&bundle, HRESULT_FROM_WIN32(ERROR_INVALID_DATA), &section);
+        }
+
+    private:
+        // Parses the bundle through the handle, through a mapping of the whole file and through a
+        // mapping with the smallest window, verifies they all agree and returns the first.
+        void ParseAllWays(const SECTION_TEST_BUNDLE* pBundle, HRESULT hrExpected, BURN_SECTION* pSection)
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczPath = NULL;
+            HANDLE hFile = INVALID_HANDLE_VALUE;
+            BURN_SECTION rgSections[3] = { };
+            BOOL rgfMapped[3] = { FALSE, TRUE, TRUE };
+            SIZE_T rgcbWindow[3] = { 0, 0, 1 };
+            GUID rgguidBundleId[3] = { };
+
+            try
+            {
+                hr = PathCreateTempFile(NULL, L"SectionTest_%05i.exe", 10000, FILE_ATTRIBUTE_NORMAL, &sczPath, NULL);
+                TestThrowOnFailure(hr, L"Failed to create temp file.");
+
+                hr = WriteTestBundle(sczPath, pBundle);
+                TestThrowOnFailure(hr, L"Failed to write test bundle.");
+
+                hFile = ::CreateFileW(sczPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+                Assert::True(INVALID_HANDLE_VALUE != hFile);
+
+                for (DWORD i = 0; i < countof(rgSections); ++i)
+                {
+                    hr = SectionParse(rgSections + i, hFile, INVALID_HANDLE_VALUE, rgfMapped[i], rgcbWindow[i], rgguidBundleId + i);
+                    NativeAssert::ValidReturnCode(hr, hrExpected);
+                }
+
+                if (SUCCEEDED(hrExpected))
+                {
+                    for (DWORD i = 1; i < countof(rgSections); ++i)
+                    {
+                        NativeAssert::Equal<DWORD>(rgSections[0].cbStub, rgSections[i].cbStub);
+                        NativeAssert::Equal<DWORD>(rgSections[0].cbEngineSize, rgSections[i].cbEngineSize);
+                        NativeAssert::Equal<DWORD64>(rgSections[0].qwBundleSize, rgSections[i].qwBundleSize);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwChecksumOffset, rgSections[i].dwChecksumOffset);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwCertificateTableOffset, rgSections[i].dwCertificateTableOffset);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwOriginalChecksumAndSignatureOffset, rgSections[i].dwOriginalChecksumAndSignatureOffset);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwOriginalChecksum, rgSections[i].dwOriginalChecksum);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwOriginalSignatureOffset, rgSections[i].dwOriginalSignatureOffset);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwOriginalSignatureSize, rgSections[i].dwOriginalSignatureSize);
+                        NativeAssert::Equal<DWORD>(rgSections[0].dwFormat, rgSections[i].dwFormat);
+                        NativeAssert::Equal<DWORD>(rgSections[0].cContainers, rgSections[i].cContainers);
+                        Assert::True(0 == memcmp(rgSections[0].rgcbContainers, rgSections[i].rgcbContainers, sizeof(DWORD) * rgSections[0].cContainers));
+                        Assert::True(::IsEqualGUID(rgguidBundleId[0], rgguidBundleId[i]));
+                    }
+
+                    *pSection = rgSections[0];
+                    memset(rgSections, 0, sizeof(BURN_SECTION));
+                }
+            }
+            finally
+            {
+                for (DWORD i = 0; i < countof(rgSections); ++i)
+                {
+                    SectionUninitialize(rgSections + i);
+                }
+
+                ReleaseFile(hFile);
+
+                if (sczPath)
+                {
+                    FileEnsureDelete(sczPath);
+                }
+                ReleaseStr(sczPath);
+            }
+        }
+    };
+}
+}
+}
+}
+}
+
+
+static HRESULT WriteTestBundle(
+    __in_z LPCWSTR wzPath,
+    __in const SECTION_TEST_BUNDLE* pBundle
+    )
+{
+    HRESULT hr = S_OK;
+    DWORD cbStub = pBundle->dwSectionOffset + TEST_SECTION_SIZE;
+    DWORD cbEngine = cbStub + TEST_UX_CONTAINER_SIZE + (pBundle->fSigned ? TEST_SIGNATURE_SIZE : 0);
+    DWORD cbFile = cbEngine + (pBundle->fAttachedContainerPresent ? TEST_ATTACHED_CONTAINER_SIZE : 0);
+    BYTE* pbFile = NULL;
+    IMAGE_DOS_HEADER* pDosHeader = NULL;
+    IMAGE_NT_HEADERS* pNtHeader = NULL;
+    IMAGE_SECTION_HEADER* pSectionHeaders = NULL;
+    DWORD* pdwBurnSection = NULL;
+    GUID guidBundleId = { 0x4c85a4f1, 0x8e25, 0x4fd3, { 0x92, 0x0b, 0x6a, 0x3f, 0x4f, 0x13, 0x2c, 0x55 } };
+
+    pbFile = static_cast<BYTE*>(MemAlloc(cbFile, TRUE));
+    ExitOnNull(pbFile, hr, E_OUTOFMEMORY, "Failed to allocate test bundle.");
+
+    // Fill the containers so a read from the wrong offset would be noticed.
+    for (DWORD i = cbStub; i < cbFile; ++i)
+    {
+        pbFile[i] = static_cast<BYTE>(i);
+    }
+
+    pDosHeader = reinterpret_cast<IMAGE_DOS_HEADER*>(pbFile);
+    pDosHeader->e_magic = pBundle->fBadDosSignature ? 0 : IMAGE_DOS_SIGNATURE;
+    pDosHeader->e_lfanew = 0x80;
+
+    pNtHeader = reinterpret_cast<IMAGE_NT_HEADERS*>(pbFile + pDosHeader->e_lfanew);
+    pNtHeader->Signature = IMAGE_NT_SIGNATURE;
+    pNtHeader->FileHeader.NumberOfSections = 2;
+    pNtHeader->FileHeader.SizeOfOptionalHeader = sizeof(IMAGE_OPTIONAL_HEADER);
+
+    if (pBundle->fSigned)
+    {
+        pNtHeader->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_SECURITY].VirtualAddress = cbStub + TEST_UX_CONTAINER_SIZE;
+        pNtHeader->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_SECURITY].Size = TEST_SIGNATURE_SIZE;
+    }
+
+    pSectionHeaders = IMAGE_FIRST_SECTION(pNtHeader);
+    memcpy(pSectionHeaders[0].Name, ".text\0\0\0", sizeof(pSectionHeaders[0].Name));
+    memcpy(pSectionHeaders[1].Name, pBundle->fNoBurnSection ? ".rsrc\0\0\0" : ".wixburn", sizeof(pSectionHeaders[1].Name));
+    pSectionHeaders[1].PointerToRawData = pBundle->dwSectionOffset;
+    pSectionHeaders[1].SizeOfRawData = TEST_SECTION_SIZE;
+
+    pdwBurnSection = reinterpret_cast<DWORD*>(pbFile + pBundle->dwSectionOffset);
+    *pdwBurnSection++ = TEST_BURN_SECTION_MAGIC;
+    *pdwBurnSection++ = pBundle->dwVersion;
+    memcpy(pdwBurnSection, &guidBundleId, sizeof(GUID));
+    pdwBurnSection += sizeof(GUID) / sizeof(DWORD);
+    *pdwBurnSection++ = cbStub;
+    *pdwBurnSection++ = 0x12345678; // original checksum
+    *pdwBurnSection++ = pBundle->fOriginalSignature ? cbStub + TEST_UX_CONTAINER_SIZE : 0;
+    *pdwBurnSection++ = pBundle->fOriginalSignature ? TEST_SIGNATURE_SIZE / 2 : 0;
+    *pdwBurnSection++ = BURN_CONTAINER_TYPE_CABINET;
+    *pdwBurnSection++ = 2;
+    *pdwBurnSection++ = TEST_UX_CONTAINER_SIZE;
+    *pdwBurnSection++ = TEST_ATTACHED_CONTAINER_SIZE;
+
+    hr = FileWrite(wzPath, FILE_ATTRIBUTE_NORMAL, pbFile, cbFile, NULL);
+    ExitOnFailure(hr, "Failed to write test bundle: %ls", wzPath);
+
+LExit:
+    ReleaseMem(pbFile);
+
+    return hr;
+}
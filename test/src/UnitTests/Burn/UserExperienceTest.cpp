@@ -0,0 +1,167 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+
+typedef struct _PROGRESS_COUNTING_BA
+{
+    BOOL fDeliverEveryTick;
+    BOOL fCancel;
+    DWORD cCacheAcquireProgress;
+    DWORD64 dw64LastProgress;
+    DWORD cExecuteProgress;
+    DWORD dwLastExecutePercentage;
+} PROGRESS_COUNTING_BA;
+
+static HRESULT WINAPI ProgressCountingBAProc(
+    __in BOOTSTRAPPER_APPLICATION_MESSAGE message,
+    __in const LPVOID pvArgs,
+    __inout LPVOID pvResults,
+    __in_opt LPVOID pvContext
+    );
+
+
+namespace Microsoft
+{
+namespace Tools
+{
+namespace WindowsInstallerXml
+{
+namespace Test
+{
+namespace Bootstrapper
+{
+    using namespace System;
+    using namespace WixTest;
+    using namespace Xunit;
+
+    public ref class UserExperienceTest : BurnUnitTest
+    {
+    public:
+        [NamedFact]
+        void UserExperienceCoalescesProgressTest()
+        {
+            const DWORD64 cbPayload = 2ull * 1024 * 1024 * 1024;
+            const DWORD64 cbChunk = 64 * 1024;
+            const DWORD cTicksPerPayload = static_cast<DWORD>(cbPayload / cbChunk);
+            HRESULT hr = S_OK;
+            BURN_USER_EXPERIENCE userExperience = { };
+            PROGRESS_COUNTING_BA ba = { };
+            LPCWSTR wzPackage = L"Package";
+            LPCWSTR rgwzPayloads[] = { L"Payload1", L"Payload2" };
+            DWORD cCancelChecks = 0;
+            int nResult = IDNOACTION;
+
+            ::InitializeCriticalSection(&userExperience.csProgress);
+            try
+            {
+                userExperience.pfnBAProc = ProgressCountingBAProc;
+                userExperience.pvBAProcContext = &ba;
+                userExperience.dwProgressInterval = BURN_PROGRESS_DEFAULT_INTERVAL;
+                userExperience.dwProgressMinimumDelta = BURN_PROGRESS_DEFAULT_MINIMUM_DELTA;
+
+                hr = UserExperienceOnApplyBegin(&userExperience, 1);
+                TestThrowOnFailure(hr, L"Failed OnApplyBegin.");
+
+                // A synthetic copy of two large payloads in small chunks.
+                for (DWORD i = 0; i < countof(rgwzPayloads); ++i)
+                {
+                    for (DWORD j = 1; j <= cTicksPerPayload; ++j)
+                    {
+                        DWORD64 dw64Progress = j * cbChunk;
+                        DWORD dwOverall = static_cast<DWORD>((i * cbPayload + dw64Progress) * 100 / (countof(rgwzPayloads) * cbPayload));
+
+                        hr = UserExperienceOnCacheAcquireProgress(&userExperience, wzPackage, rgwzPayloads[i], dw64Progress, cbPayload, dwOverall);
+                        TestThrowOnFailure(hr, L"Failed OnCacheAcquireProgress.");
+                    }
+
+                    // The final tick of each payload is never coalesced.
+                    Assert::Equal<DWORD64>(cbPayload, ba.dw64LastProgress);
+                }
+
+                Assert::True(ba.cCacheAcquireProgress >= 4);
+                Assert::True(ba.cCacheAcquireProgress < cTicksPerPayload / 10);
+
+                // A tick that moves less than the minimum delta still reaches the BA within the poll interval,
+                // so a cancel request is never starved.
+                hr = UserExperienceOnExecuteProgress(&userExperience, wzPackage, 50, 50, &nResult);
+                TestThrowOnFailure(hr, L"Failed OnExecuteProgress.");
+                Assert::Equal<DWORD>(1, ba.cExecuteProgress);
+
+                ba.fCancel = TRUE;
+                do
+                {
+                    ::Sleep(50);
+                    ++cCancelChecks;
+
+                    hr = UserExperienceOnExecuteProgress(&userExperience, wzPackage, 50, 50, &nResult);
+                    TestThrowOnFailure(hr, L"Failed OnExecuteProgress.");
+                } while (IDCANCEL != nResult && 100 > cCancelChecks);
+
+                Assert::Equal<int>(IDCANCEL, nResult);
+                Assert::True(cCancelChecks < 100);
+
+                // The BA can ask for every tick.
+                ba.fCancel = FALSE;
+                ba.fDeliverEveryTick = TRUE;
+                ba.cCacheAcquireProgress = 0;
+
+                hr = UserExperienceOnApplyBegin(&userExperience, 1);
+                TestThrowOnFailure(hr, L"Failed OnApplyBegin.");
+
+                for (DWORD j = 1; j <= 1000; ++j)
+                {
+                    hr = UserExperienceOnCacheAcquireProgress(&userExperience, wzPackage, rgwzPayloads[0], j, 1000, 0);
+                    TestThrowOnFailure(hr, L"Failed OnCacheAcquireProgress.");
+                }
+
+                Assert::Equal<DWORD>(1000, ba.cCacheAcquireProgress);
+            }
+            finally
+            {
+                ::DeleteCriticalSection(&userExperience.csProgress);
+            }
+        }
+    };
+}
+}
+}
+}
+}
+
+
+static HRESULT WINAPI ProgressCountingBAProc(
+    __in BOOTSTRAPPER_APPLICATION_MESSAGE message,
+    __in const LPVOID pvArgs,
+    __inout LPVOID pvResults,
+    __in_opt LPVOID pvContext
+    )
+{
+    PROGRESS_COUNTING_BA* pBA = reinterpret_cast<PROGRESS_COUNTING_BA*>(pvContext);
+
+    switch (message)
+    {
+    case BOOTSTRAPPER_APPLICATION_MESSAGE_ONAPPLYBEGIN:
+        if (pBA->fDeliverEveryTick)
+        {
+            BA_ONAPPLYBEGIN_RESULTS* pResults = reinterpret_cast<BA_ONAPPLYBEGIN_RESULTS*>(pvResults);
+            pResults->dwProgressInterval = 0;
+            pResults->dwProgressMinimumDelta = 0;
+        }
+        break;
+
+    case BOOTSTRAPPER_APPLICATION_MESSAGE_ONCACHEACQUIREPROGRESS:
+        ++pBA->cCacheAcquireProgress;
+        pBA->dw64LastProgress = reinterpret_cast<BA_ONCACHEACQUIREPROGRESS_ARGS*>(pvArgs)->dw64Progress;
+        reinterpret_cast<BA_ONCACHEACQUIREPROGRESS_RESULTS*>(pvResults)->fCancel = pBA->fCancel;
+        break;
+
+    case BOOTSTRAPPER_APPLICATION_MESSAGE_ONEXECUTEPROGRESS:
+        ++pBA->cExecuteProgress;
+        pBA->dwLastExecutePercentage = reinterpret_cast<BA_ONEXECUTEPROGRESS_ARGS*>(pvArgs)->dwProgressPercentage;
+        reinterpret_cast<BA_ONEXECUTEPROGRESS_RESULTS*>(pvResults)->fCancel = pBA->fCancel;
+        break;
+    }
+
+    return S_OK;
+}
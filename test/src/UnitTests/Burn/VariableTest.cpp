@@ -72,7 +72,7 @@ namespace Bootstrapper
         void VariablesParseXmlTest()
         {
             HRESULT hr = S_OK;
-            IXMLDOMElement* pixeBundle = NULL;
+            XML_READER reader = { };
             BURN_VARIABLES variables = { };
             try
             {
@@ -89,10 +89,13 @@ namespace Bootstrapper
                 TestThrowOnFailure(hr, L"Failed to initialize variables.");
 
                 // load XML document
-                LoadBundleXmlHelper(wzDocument, &pixeBundle);
+                LoadBundleXmlHelper(wzDocument, &reader);
 
-                hr = VariablesParseFromXml(&variables, pixeBundle);
-                TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                while (NextBundleElementHelper(&reader, L"Variable"))
+                {
+                    hr = VariableParseFromXml(&variables, &reader);
+                    TestThrowOnFailure(hr, L"Failed to parse searches from XML.");
+                }
 
                 // get and verify variable values
                 Assert::Equal((int)BURN_VARIANT_TYPE_NUMERIC, VariableGetTypeHelper(&variables, L"Var1"));
@@ -106,7 +109,7 @@ namespace Bootstrapper
             }
             finally
             {
-                ReleaseObject(pixeBundle);
+                XmlReaderUninitialize(&reader);
                 VariablesUninitialize(&variables);
             }
         }
@@ -27,6 +27,7 @@
 #include <strutil.h>
 #include <wiutil.h>
 #include <xmlutil.h>
+#include <xmlreaderutil.h>
 #include <dictutil.h>
 #include <deputil.h>
 
@@ -51,6 +52,7 @@
 #include "update.h"
 #include "pseudobundle.h"
 #include "registration.h"
+#include "relatedbundle.h"
 #include "plan.h"
 #include "pipe.h"
 #include "logging.h"
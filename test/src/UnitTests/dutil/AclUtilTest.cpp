@@ -0,0 +1,126 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace DutilTests
+{
+    public ref class AclUtil
+    {
+    public:
+        [Fact]
+        void AclUtilMergeExplicitAccessTest()
+        {
+            HRESULT hr = S_OK;
+            PSID psidEveryone = NULL;
+            PSID psidUsers = NULL;
+            ACL* pAcl = NULL;
+            ACL* pAclRemerged = NULL;
+            const DWORD cEntries = 3;
+            EXPLICIT_ACCESSW rgEntries[cEntries] = { };
+
+            try
+            {
+                hr = AclGetWellKnownSid(WinWorldSid, &psidEveryone);
+                NativeAssert::Succeeded(hr, "Failed to get Everyone sid.");
+
+                hr = AclGetWellKnownSid(WinBuiltinUsersSid, &psidUsers);
+                NativeAssert::Succeeded(hr, "Failed to get Users sid.");
+
+                // The later SET_ACCESS for Everyone replaces the first one, like it would have if they were applied one at a time.
+                SetEntry(&rgEntries[0], psidEveryone, FILE_READ_DATA, SUB_CONTAINERS_AND_OBJECTS_INHERIT);
+                SetEntry(&rgEntries[1], psidUsers, FILE_READ_DATA | FILE_WRITE_DATA, SUB_CONTAINERS_AND_OBJECTS_INHERIT);
+                SetEntry(&rgEntries[2], psidEveryone, FILE_WRITE_DATA, SUB_CONTAINERS_AND_OBJECTS_INHERIT);
+
+                hr = AclMergeExplicitAccess(NULL, rgEntries, cEntries, &pAcl);
+                NativeAssert::ValidReturnCode(hr, S_OK);
+                NativeAssert::Equal<DWORD>(2, pAcl->AceCount);
+                NativeAssert::Equal<DWORD>(FILE_WRITE_DATA, GetAllowedMask(pAcl, psidEveryone));
+                NativeAssert::Equal<DWORD>(FILE_READ_DATA | FILE_WRITE_DATA, GetAllowedMask(pAcl, psidUsers));
+
+                // Applying the same entries again doesn't change anything, so there's nothing to write back.
+                hr = AclMergeExplicitAccess(pAcl, rgEntries, cEntries, &pAclRemerged);
+                NativeAssert::ValidReturnCode(hr, S_FALSE);
+                NativeAssert::Equal<DWORD>(2, pAclRemerged->AceCount);
+
+                AclFreeDacl(pAclRemerged);
+                pAclRemerged = NULL;
+
+                SetEntry(&rgEntries[0], psidUsers, FILE_READ_DATA, SUB_CONTAINERS_AND_OBJECTS_INHERIT);
+
+                hr = AclMergeExplicitAccess(pAcl, rgEntries, 1, &pAclRemerged);
+                NativeAssert::ValidReturnCode(hr, S_OK);
+                NativeAssert::Equal<DWORD>(2, pAclRemerged->AceCount);
+                NativeAssert::Equal<DWORD>(FILE_WRITE_DATA, GetAllowedMask(pAclRemerged, psidEveryone));
+                NativeAssert::Equal<DWORD>(FILE_READ_DATA, GetAllowedMask(pAclRemerged, psidUsers));
+            }
+            finally
+            {
+                if (pAclRemerged)
+                {
+                    AclFreeDacl(pAclRemerged);
+                }
+                if (pAcl)
+                {
+                    AclFreeDacl(pAcl);
+                }
+                ReleaseSid(psidUsers);
+                ReleaseSid(psidEveryone);
+            }
+        }
+
+        [Fact]
+        void AclUtilCompareSecurityDescriptorStringsTest()
+        {
+            HRESULT hr = S_OK;
+            BOOL fEqual = FALSE;
+
+            // Different spellings of the same rights and trustee describe the same descriptor.
+            hr = AclCompareSecurityDescriptorStrings(L"D:(A;;GX;;;SY)", L"D:(A;;0x20000000;;;S-1-5-18)", &fEqual);
+            NativeAssert::Succeeded(hr, "Failed to compare equivalent SDDLs.");
+            Assert::True(fEqual);
+
+            hr = AclCompareSecurityDescriptorStrings(L"D:", L"D:", &fEqual);
+            NativeAssert::Succeeded(hr, "Failed to compare empty DACLs.");
+            Assert::True(fEqual);
+
+            hr = AclCompareSecurityDescriptorStrings(L"D:(A;;GX;;;SY)", L"D:(A;;GA;;;SY)", &fEqual);
+            NativeAssert::Succeeded(hr, "Failed to compare SDDLs with different rights.");
+            Assert::False(fEqual);
+
+            hr = AclCompareSecurityDescriptorStrings(L"D:(A;;GX;;;SY)", L"D:(A;;GX;;;BU)", &fEqual);
+            NativeAssert::Succeeded(hr, "Failed to compare SDDLs with different trustees.");
+            Assert::False(fEqual);
+        }
+
+    private:
+        void SetEntry(EXPLICIT_ACCESSW* pea, PSID psid, DWORD dwPermissions, DWORD dwInheritance)
+        {
+            memset(pea, 0, sizeof(EXPLICIT_ACCESSW));
+            pea->grfAccessMode = SET_ACCESS;
+            pea->grfAccessPermissions = dwPermissions;
+            pea->grfInheritance = dwInheritance;
+            ::BuildTrusteeWithSidW(&pea->Trustee, psid);
+        }
+
+        DWORD GetAllowedMask(ACL* pAcl, PSID psid)
+        {
+            ACCESS_ALLOWED_ACE* pAce = NULL;
+
+            for (DWORD i = 0; i < pAcl->AceCount; ++i)
+            {
+                Assert::True(::GetAce(pAcl, i, reinterpret_cast<LPVOID*>(&pAce)));
+
+                if (ACCESS_ALLOWED_ACE_TYPE == pAce->Header.AceType && ::EqualSid(reinterpret_cast<PSID>(&pAce->SidStart), psid))
+                {
+                    return pAce->Mask;
+                }
+            }
+
+            return 0;
+        }
+    };
+}
@@ -0,0 +1,222 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace DutilTests
+{
+    public ref class BuffUtil
+    {
+    public:
+        [Fact]
+        void BuffUtilWriterReaderTest()
+        {
+            HRESULT hr = S_OK;
+            BUFF_WRITER writer = { };
+            BUFF_READER reader = { };
+            BYTE* pbBuffer = NULL;
+            SIZE_T cbBuffer = 0;
+            SIZE_T iBuffer = 0;
+            BYTE rgbStream[] = { 1, 2, 3, 4, 5 };
+            DWORD dw = 0;
+            DWORD64 qw = 0;
+            LPWSTR sczValue = NULL;
+            LPSTR sczAnsiValue = NULL;
+            LPCWSTR wzView = NULL;
+            DWORD cchView = 0;
+            const BYTE* pbView = NULL;
+            SIZE_T cbView = 0;
+
+            try
+            {
+                // The first values go through the old API so the writer has to pick up an existing buffer.
+                hr = BuffWriteNumber(&pbBuffer, &cbBuffer, 42);
+                NativeAssert::Succeeded(hr, "Failed to write number.");
+
+                hr = BuffWriteString(&pbBuffer, &cbBuffer, L"first");
+                NativeAssert::Succeeded(hr, "Failed to write string.");
+
+                hr = BuffWriterAttach(&writer, pbBuffer, cbBuffer);
+                NativeAssert::Succeeded(hr, "Failed to attach writer.");
+                pbBuffer = NULL;
+                cbBuffer = 0;
+
+                hr = BuffWriterReserve(&writer, 4096);
+                NativeAssert::Succeeded(hr, "Failed to reserve space.");
+                Assert::True(4096 <= writer.cbCapacity - writer.cbData);
+
+                hr = BuffWriterWriteNumber64(&writer, 0x0123456789ABCDEF);
+                NativeAssert::Succeeded(hr, "Failed to write 64-bit number.");
+
+                hr = BuffWriterWriteString(&writer, NULL);
+                NativeAssert::Succeeded(hr, "Failed to write empty string.");
+
+                hr = BuffWriterWriteString(&writer, L"second");
+                NativeAssert::Succeeded(hr, "Failed to write string.");
+
+                hr = BuffWriterWriteStringAnsi(&writer, "third");
+                NativeAssert::Succeeded(hr, "Failed to write ANSI string.");
+
+                hr = BuffWriterWriteStream(&writer, rgbStream, sizeof(rgbStream));
+                NativeAssert::Succeeded(hr, "Failed to write stream.");
+
+                BuffWriterDetach(&writer, &pbBuffer, &cbBuffer);
+                Assert::True(NULL == writer.pbData);
+
+                // The old API reads what the writer wrote.
+                hr = BuffReadNumber(pbBuffer, cbBuffer, &iBuffer, &dw);
+                NativeAssert::Succeeded(hr, "Failed to read number.");
+                NativeAssert::Equal<DWORD>(42, dw);
+
+                hr = BuffReadString(pbBuffer, cbBuffer, &iBuffer, &sczValue);
+                NativeAssert::Succeeded(hr, "Failed to read string.");
+                NativeAssert::StringEqual(L"first", sczValue);
+
+                // And the reader continues where it left off.
+                BuffReaderInitialize(&reader, pbBuffer, cbBuffer, iBuffer);
+
+                hr = BuffReaderReadNumber64(&reader, &qw);
+                NativeAssert::Succeeded(hr, "Failed to read 64-bit number.");
+                NativeAssert::Equal<DWORD64>(0x0123456789ABCDEF, qw);
+
+                hr = BuffReaderReadStringView(&reader, &wzView, &cchView);
+                NativeAssert::Succeeded(hr, "Failed to read empty string.");
+                NativeAssert::Equal<DWORD>(0, cchView);
+                NativeAssert::StringEqual(L"", wzView);
+
+                hr = BuffReaderReadStringView(&reader, &wzView, &cchView);
+                NativeAssert::Succeeded(hr, "Failed to read string view.");
+                NativeAssert::Equal<DWORD>(6, cchView);
+                Assert::True(0 == memcmp(L"second", wzView, cchView * sizeof(WCHAR)));
+                Assert::True(reinterpret_cast<const BYTE*>(wzView) > pbBuffer && reinterpret_cast<const BYTE*>(wzView) < pbBuffer + cbBuffer);
+
+                hr = BuffReaderReadStringAnsi(&reader, &sczAnsiValue);
+                NativeAssert::Succeeded(hr, "Failed to read ANSI string.");
+                Assert::True(0 == lstrcmpA("third", sczAnsiValue));
+
+                hr = BuffReaderReadStreamView(&reader, &pbView, &cbView);
+                NativeAssert::Succeeded(hr, "Failed to read stream view.");
+                NativeAssert::Equal<SIZE_T>(sizeof(rgbStream), cbView);
+                Assert::True(0 == memcmp(rgbStream, pbView, cbView));
+
+                NativeAssert::Equal<SIZE_T>(cbBuffer, reader.iData);
+
+                // Reading past the end fails and leaves the cursor alone.
+                hr = BuffReaderReadNumber(&reader, &dw);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDARG);
+                NativeAssert::Equal<SIZE_T>(cbBuffer, reader.iData);
+
+                // A count that claims more characters than remain fails without moving the cursor.
+                BuffReaderInitialize(&reader, pbBuffer, sizeof(DWORD) + sizeof(DWORD) + sizeof(WCHAR), sizeof(DWORD));
+
+                hr = BuffReaderReadStringView(&reader, &wzView, &cchView);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDARG);
+                NativeAssert::Equal<SIZE_T>(sizeof(DWORD), reader.iData);
+            }
+            finally
+            {
+                ReleaseStr(sczAnsiValue);
+                ReleaseStr(sczValue);
+                ReleaseBuffer(pbBuffer);
+                BuffWriterUninitialize(&writer);
+            }
+        }
+
+        [Fact]
+        void BuffUtilWriterReaderMatchTest()
+        {
+            const DWORD cRecords = 1000;
+            HRESULT hr = S_OK;
+            BUFF_WRITER writer = { };
+            BUFF_READER reader = { };
+            BYTE* pbOld = NULL;
+            SIZE_T cbOld = 0;
+            BYTE* pbNew = NULL;
+            SIZE_T cbNew = 0;
+            SIZE_T iBuffer = 0;
+            LPWSTR sczValue = NULL;
+            LPCWSTR wzView = NULL;
+            DWORD cchView = 0;
+            DWORD dw = 0;
+            DWORD64 qw = 0;
+
+            try
+            {
+                for (DWORD i = 0; i < cRecords; ++i)
+                {
+                    hr = BuffWriteNumber(&pbOld, &cbOld, i);
+                    NativeAssert::Succeeded(hr, "Failed to write number {0}", i);
+
+                    hr = BuffWriteString(&pbOld, &cbOld, L"SerializedVariableName");
+                    NativeAssert::Succeeded(hr, "Failed to write string {0}", i);
+
+                    hr = BuffWriteNumber64(&pbOld, &cbOld, i);
+                    NativeAssert::Succeeded(hr, "Failed to write 64-bit number {0}", i);
+                }
+
+                for (DWORD i = 0; i < cRecords; ++i)
+                {
+                    hr = BuffWriterWriteNumber(&writer, i);
+                    NativeAssert::Succeeded(hr, "Failed to write number {0}", i);
+
+                    hr = BuffWriterWriteString(&writer, L"SerializedVariableName");
+                    NativeAssert::Succeeded(hr, "Failed to write string {0}", i);
+
+                    hr = BuffWriterWriteNumber64(&writer, i);
+                    NativeAssert::Succeeded(hr, "Failed to write 64-bit number {0}", i);
+                }
+
+                BuffWriterDetach(&writer, &pbNew, &cbNew);
+
+                NativeAssert::Equal<SIZE_T>(cbOld, cbNew);
+                Assert::True(0 == memcmp(pbOld, pbNew, cbNew));
+
+                for (DWORD i = 0; i < cRecords; ++i)
+                {
+                    hr = BuffReadNumber(pbOld, cbOld, &iBuffer, &dw);
+                    NativeAssert::Succeeded(hr, "Failed to read number {0}", i);
+                    NativeAssert::Equal<DWORD>(i, dw);
+
+                    hr = BuffReadString(pbOld, cbOld, &iBuffer, &sczValue);
+                    NativeAssert::Succeeded(hr, "Failed to read string {0}", i);
+                    NativeAssert::StringEqual(L"SerializedVariableName", sczValue);
+
+                    hr = BuffReadNumber64(pbOld, cbOld, &iBuffer, &qw);
+                    NativeAssert::Succeeded(hr, "Failed to read 64-bit number {0}", i);
+                    NativeAssert::Equal<DWORD64>(i, qw);
+                }
+
+                BuffReaderInitialize(&reader, pbNew, cbNew, 0);
+
+                for (DWORD i = 0; i < cRecords; ++i)
+                {
+                    hr = BuffReaderReadNumber(&reader, &dw);
+                    NativeAssert::Succeeded(hr, "Failed to read number {0}", i);
+                    NativeAssert::Equal<DWORD>(i, dw);
+
+                    hr = BuffReaderReadStringView(&reader, &wzView, &cchView);
+                    NativeAssert::Succeeded(hr, "Failed to read string {0}", i);
+                    NativeAssert::Equal<DWORD>(lstrlenW(L"SerializedVariableName"), cchView);
+                    Assert::True(0 == memcmp(L"SerializedVariableName", wzView, cchView * sizeof(WCHAR)));
+
+                    hr = BuffReaderReadNumber64(&reader, &qw);
+                    NativeAssert::Succeeded(hr, "Failed to read 64-bit number {0}", i);
+                    NativeAssert::Equal<DWORD64>(i, qw);
+                }
+
+                NativeAssert::Equal<SIZE_T>(cbOld, iBuffer);
+                NativeAssert::Equal<SIZE_T>(cbNew, reader.iData);
+            }
+            finally
+            {
+                ReleaseStr(sczValue);
+                ReleaseBuffer(pbNew);
+                ReleaseBuffer(pbOld);
+                BuffWriterUninitialize(&writer);
+            }
+        }
+    };
+}
@@ -31,7 +31,65 @@ namespace DutilTests
             StringListTestHelper(DICT_FLAG_CASEINSENSITIVE, numIterations);
         }
 
+        [Fact]
+        void DictUtilGrowTest()
+        {
+            GrowTestHelper(DICT_FLAG_NONE, numIterations);
+
+            GrowTestHelper(DICT_FLAG_CASEINSENSITIVE, numIterations);
+        }
+
     private:
+        void GrowTestHelper(DICT_FLAG dfFlags, DWORD dwNumItems)
+        {
+            HRESULT hr = S_OK;
+            LPWSTR* rgsczKeys = NULL;
+            STRINGDICT_HANDLE sdValues = NULL;
+
+            try
+            {
+                rgsczKeys = static_cast<LPWSTR*>(MemAlloc(sizeof(LPWSTR) * dwNumItems, TRUE));
+                Assert::True(NULL != rgsczKeys);
+
+                for (DWORD i = 0; i < dwNumItems; ++i)
+                {
+                    hr = StrAllocFormatted(&rgsczKeys[i], L"Grow.Key_%u_%u", i, i * 7919);
+                    NativeAssert::Succeeded(hr, "Failed to allocate key {0}", i);
+                }
+
+                // Start with no size hint so the dictionary has to grow many times.
+                hr = DictCreateStringList(&sdValues, 0, dfFlags);
+                NativeAssert::Succeeded(hr, "Failed to create dictionary of keys");
+
+                for (DWORD i = 0; i < dwNumItems; ++i)
+                {
+                    hr = DictAddKey(sdValues, rgsczKeys[i]);
+                    NativeAssert::Succeeded(hr, "Failed to add key {0} to dict", i);
+                }
+
+                for (DWORD i = 0; i < dwNumItems; ++i)
+                {
+                    hr = DictKeyExists(sdValues, rgsczKeys[i]);
+                    NativeAssert::Succeeded(hr, "Failed to find key {0}", i);
+                }
+
+                hr = DictKeyExists(sdValues, L"Grow.Key_Missing");
+                NativeAssert::ValidReturnCode(hr, E_NOTFOUND);
+            }
+            finally
+            {
+                if (rgsczKeys)
+                {
+                    for (DWORD i = 0; i < dwNumItems; ++i)
+                    {
+                        ReleaseStr(rgsczKeys[i]);
+                    }
+                }
+                ReleaseMem(rgsczKeys);
+                ReleaseDict(sdValues);
+            }
+        }
+
         void EmbeddedKeyTestHelper(DICT_FLAG dfFlags, DWORD dwNumIterations)
         {
             HRESULT hr = S_OK;
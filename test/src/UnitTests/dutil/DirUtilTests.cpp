@@ -66,5 +66,162 @@ namespace DutilTests
                 ReleaseStr(sczCurrentDir);
             }
         }
+
+        [Fact]
+        void DirUtilEnumerateTreeTest()
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczRoot = NULL;
+            LPWSTR sczPath = NULL;
+            LPWSTR* rgsczDirectories = NULL;
+            DWORD cDirectories = 0;
+            LPCWSTR rgwzCreate[] = { L"c\\2", L"c\\1", L"A\\deep\\er", L"A\\2", L"A\\1", L"b\\2", L"b\\1" };
+            LPCWSTR rgwzExpected[] = { L"", L"A\\", L"b\\", L"c\\", L"A\\1\\", L"A\\2\\", L"A\\deep\\", L"b\\1\\", L"b\\2\\", L"c\\1\\", L"c\\2\\", L"A\\deep\\er\\" };
+
+            try
+            {
+                hr = CreateTestRoot(&sczRoot);
+                NativeAssert::Succeeded(hr, "Failed to create test root.");
+
+                for (DWORD i = 0; i < countof(rgwzCreate); ++i)
+                {
+                    hr = StrAllocFormatted(&sczPath, L"%ls%ls", sczRoot, rgwzCreate[i]);
+                    NativeAssert::Succeeded(hr, "Failed to format path.");
+
+                    hr = DirEnsureExists(sczPath, NULL);
+                    NativeAssert::Succeeded(hr, "Failed to create directory: {0}", sczPath);
+                }
+
+                // Files are never returned.
+                hr = StrAllocFormatted(&sczPath, L"%lsA\\file.txt", sczRoot);
+                NativeAssert::Succeeded(hr, "Failed to format path.");
+
+                hr = FileWrite(sczPath, FILE_ATTRIBUTE_NORMAL, reinterpret_cast<LPCBYTE>("file"), 4, NULL);
+                NativeAssert::Succeeded(hr, "Failed to write file: {0}", sczPath);
+
+                // The order is the same no matter how many threads do the walk.
+                for (DWORD cThreads = 1; cThreads <= 4; cThreads += 3)
+                {
+                    hr = DirEnumerateTree(sczRoot, cThreads, &rgsczDirectories, &cDirectories);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                    NativeAssert::Equal<DWORD>(12, cDirectories);
+
+                    for (DWORD i = 0; i < cDirectories; ++i)
+                    {
+                        hr = StrAllocFormatted(&sczPath, L"%ls%ls", sczRoot, rgwzExpected[i]);
+                        NativeAssert::Succeeded(hr, "Failed to format path.");
+
+                        NativeAssert::StringEqual(sczPath, rgsczDirectories[i]);
+                    }
+
+                    ReleaseNullStrArray(rgsczDirectories, cDirectories);
+                }
+
+                hr = StrAllocFormatted(&sczPath, L"%lsmissing\\", sczRoot);
+                NativeAssert::Succeeded(hr, "Failed to format path.");
+
+                hr = DirEnumerateTree(sczPath, 0, &rgsczDirectories, &cDirectories);
+                NativeAssert::ValidReturnCode(hr, S_FALSE);
+                NativeAssert::Equal<DWORD>(0, cDirectories);
+            }
+            finally
+            {
+                ReleaseStrArray(rgsczDirectories, cDirectories);
+                DeleteTestRoot(sczRoot);
+                ReleaseStr(sczPath);
+                ReleaseStr(sczRoot);
+            }
+        }
+
+        [Fact]
+        void DirUtilEnumerateTreeParallelMatchesSerialTest()
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczRoot = NULL;
+            LPWSTR sczPath = NULL;
+            LPWSTR* rgsczSerial = NULL;
+            DWORD cSerial = 0;
+            LPWSTR* rgsczParallel = NULL;
+            DWORD cParallel = 0;
+            const DWORD cFanOut = 20;
+
+            try
+            {
+                hr = CreateTestRoot(&sczRoot);
+                NativeAssert::Succeeded(hr, "Failed to create test root.");
+
+                // Generate a tree of cFanOut directories with cFanOut children each, which each have one more child.
+                for (DWORD i = 0; i < cFanOut; ++i)
+                {
+                    for (DWORD j = 0; j < cFanOut; ++j)
+                    {
+                        hr = StrAllocFormatted(&sczPath, L"%ls%u\\%u\\leaf", sczRoot, i, j);
+                        NativeAssert::Succeeded(hr, "Failed to format path.");
+
+                        hr = DirEnsureExists(sczPath, NULL);
+                        NativeAssert::Succeeded(hr, "Failed to create directory: {0}", sczPath);
+                    }
+                }
+
+                hr = DirEnumerateTree(sczRoot, 1, &rgsczSerial, &cSerial);
+                NativeAssert::Succeeded(hr, "Failed to enumerate tree with one thread.");
+
+                hr = DirEnumerateTree(sczRoot, 0, &rgsczParallel, &cParallel);
+                NativeAssert::Succeeded(hr, "Failed to enumerate tree with default threads.");
+
+                NativeAssert::Equal<DWORD>(1 + cFanOut + 2 * cFanOut * cFanOut, cSerial);
+                NativeAssert::Equal<DWORD>(cSerial, cParallel);
+
+                for (DWORD i = 0; i < cSerial; ++i)
+                {
+                    NativeAssert::StringEqual(rgsczSerial[i], rgsczParallel[i]);
+                }
+            }
+            finally
+            {
+                ReleaseStrArray(rgsczParallel, cParallel);
+                ReleaseStrArray(rgsczSerial, cSerial);
+                DeleteTestRoot(sczRoot);
+                ReleaseStr(sczPath);
+                ReleaseStr(sczRoot);
+            }
+        }
+
+    private:
+        HRESULT CreateTestRoot(LPWSTR* psczRoot)
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczCurrentDir = NULL;
+            LPWSTR sczGuid = NULL;
+
+            hr = GuidCreate(&sczGuid);
+            ExitOnFailure(hr, "Failed to create guid.");
+
+            hr = DirGetCurrent(&sczCurrentDir);
+            ExitOnFailure(hr, "Failed to get current directory.");
+
+            hr = PathConcat(sczCurrentDir, sczGuid, psczRoot);
+            ExitOnFailure(hr, "Failed to combine current directory with guid.");
+
+            hr = PathBackslashTerminate(psczRoot);
+            ExitOnFailure(hr, "Failed to backslash terminate test root.");
+
+            hr = DirEnsureExists(*psczRoot, NULL);
+            ExitOnFailure(hr, "Failed to create test root.");
+
+        LExit:
+            ReleaseStr(sczGuid);
+            ReleaseStr(sczCurrentDir);
+
+            return hr;
+        }
+
+        void DeleteTestRoot(LPCWSTR wzRoot)
+        {
+            if (wzRoot)
+            {
+                DirEnsureDelete(wzRoot, TRUE, TRUE);
+            }
+        }
     };
 }
@@ -8,6 +8,27 @@ using namespace WixTest;
 
 namespace DutilTests
 {
+    struct CopyProgress
+    {
+        DWORD cCalls;
+        DWORD64 qwLastCopied;
+        DWORD64 qwCancelAfter;
+    };
+
+    static HRESULT CALLBACK CopyProgressCallback(
+        __in DWORD64 qwCopied,
+        __in DWORD64 /*qwTotal*/,
+        __in_opt LPVOID pvContext
+        )
+    {
+        CopyProgress* pProgress = static_cast<CopyProgress*>(pvContext);
+
+        ++pProgress->cCalls;
+        pProgress->qwLastCopied = qwCopied;
+
+        return (pProgress->qwCancelAfter && pProgress->qwCancelAfter <= qwCopied) ? E_ABORT : S_OK;
+    }
+
     public ref class FileUtil
     {
     public:
@@ -46,7 +67,287 @@ namespace DutilTests
             }
         }
 
+        [Fact]
+        void FileUtilMappedViewTest()
+        {
+            const DWORD cbFile = 1024 * 1024 + 17;
+            HRESULT hr = S_OK;
+            LPWSTR sczPath = NULL;
+            HANDLE hFile = INVALID_HANDLE_VALUE;
+            FILE_MAPPED_VIEW view = { };
+            BYTE* pbFile = NULL;
+            BYTE* pbRead = NULL;
+            const BYTE* pbView = NULL;
+            SIZE_T cbRead = 0;
+
+            try
+            {
+                pbFile = static_cast<BYTE*>(MemAlloc(cbFile, FALSE));
+                pbRead = static_cast<BYTE*>(MemAlloc(cbFile, TRUE));
+                Assert::True(pbFile && pbRead);
+
+                for (DWORD i = 0; i < cbFile; ++i)
+                {
+                    pbFile[i] = static_cast<BYTE>(i * 7 + (i >> 12));
+                }
+
+                hr = PathCreateTempFile(NULL, L"FileUtilMappedViewTest_%05i.bin", 10000, FILE_ATTRIBUTE_NORMAL, &sczPath, NULL);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                hr = FileWrite(sczPath, FILE_ATTRIBUTE_NORMAL, pbFile, cbFile, NULL);
+                NativeAssert::Succeeded(hr, "Failed to write temp file: {0}", sczPath);
+
+                hFile = ::CreateFileW(sczPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+                Assert::True(INVALID_HANDLE_VALUE != hFile);
+
+                // Ask for a tiny window so it is clamped to the smallest one and has to move repeatedly.
+                hr = FileMappedViewInitialize(&view, hFile, 1);
+                NativeAssert::Succeeded(hr, "Failed to map file.");
+                NativeAssert::Equal<DWORD64>(cbFile, view.qwFileSize);
+                Assert::True(view.cbWindowMax < cbFile);
+
+                // A single read larger than the window crosses several windows.
+                hr = FileMappedViewRead(&view, 0, pbRead, cbFile, &cbRead);
+                NativeAssert::Succeeded(hr, "Failed to read whole file.");
+                NativeAssert::Equal<SIZE_T>(cbFile, cbRead);
+                Assert::True(0 == memcmp(pbFile, pbRead, cbFile));
+
+                // Backwards and unaligned.
+                hr = FileMappedViewGet(&view, 12345, 100, &pbView);
+                NativeAssert::Succeeded(hr, "Failed to get unaligned view.");
+                Assert::True(0 == memcmp(pbFile + 12345, pbView, 100));
+
+                hr = FileMappedViewGet(&view, cbFile - 10, 10, &pbView);
+                NativeAssert::Succeeded(hr, "Failed to get view at end of file.");
+                Assert::True(0 == memcmp(pbFile + cbFile - 10, pbView, 10));
+
+                // Reads stop at the end of the file but views past it fail.
+                hr = FileMappedViewRead(&view, cbFile - 10, pbRead, 100, &cbRead);
+                NativeAssert::Succeeded(hr, "Failed to read past end of file.");
+                NativeAssert::Equal<SIZE_T>(10, cbRead);
+
+                hr = FileMappedViewRead(&view, cbFile + 1, pbRead, 100, &cbRead);
+                NativeAssert::Succeeded(hr, "Failed to read after end of file.");
+                NativeAssert::Equal<SIZE_T>(0, cbRead);
+
+                hr = FileMappedViewGet(&view, cbFile - 10, 11, &pbView);
+                NativeAssert::ValidReturnCode(hr, HRESULT_FROM_WIN32(ERROR_HANDLE_EOF));
+            }
+            finally
+            {
+                FileMappedViewUninitialize(&view);
+                ReleaseFile(hFile);
+
+                if (sczPath)
+                {
+                    FileEnsureDelete(sczPath);
+                }
+
+                ReleaseStr(sczPath);
+                ReleaseMem(pbRead);
+                ReleaseMem(pbFile);
+            }
+        }
+
+        [Fact]
+        void FileUtilCopyTest()
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczSource = NULL;
+            LPWSTR sczTarget = NULL;
+            CopyProgress progress = { };
+            DWORD64 qwCopied = 0;
+
+            try
+            {
+                // Not a multiple of any buffer size so the last block is short.
+                CreateCopySource(3 * 1024 * 1024 + 123, &sczSource);
+
+                hr = PathCreateTempFile(NULL, L"FileUtilCopyTarget_%05i.bin", 10000, FILE_ATTRIBUTE_NORMAL, &sczTarget, NULL);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                hr = FileCopy(sczSource, sczTarget, FILE_COPY_FLAGS_NONE, 1024 * 1024, CopyProgressCallback, &progress, &qwCopied);
+                NativeAssert::Succeeded(hr, "Failed to copy file: {0}", sczSource);
+                NativeAssert::Equal<DWORD64>(3 * 1024 * 1024 + 123, qwCopied);
+                NativeAssert::Equal<DWORD>(4, progress.cCalls);
+                NativeAssert::Equal<DWORD64>(qwCopied, progress.qwLastCopied);
+                VerifyCopy(sczSource, sczTarget);
+
+                hr = FileCopy(sczSource, sczTarget, FILE_COPY_FLAGS_FAIL_IF_EXISTS, 0, NULL, NULL, NULL);
+                NativeAssert::ValidReturnCode(hr, HRESULT_FROM_WIN32(ERROR_FILE_EXISTS));
+
+                // Canceling from the callback fails the copy and cleans up the target.
+                progress.qwCancelAfter = 1;
+
+                hr = FileCopy(sczSource, sczTarget, FILE_COPY_FLAGS_NONE, 0, CopyProgressCallback, &progress, NULL);
+                NativeAssert::ValidReturnCode(hr, E_ABORT);
+                Assert::False(FileExistsEx(sczTarget, NULL));
+            }
+            finally
+            {
+                if (sczSource)
+                {
+                    FileEnsureDelete(sczSource);
+                }
+
+                if (sczTarget)
+                {
+                    FileEnsureDelete(sczTarget);
+                }
+
+                ReleaseStr(sczTarget);
+                ReleaseStr(sczSource);
+            }
+        }
+
+        [Fact]
+        void FileUtilCopyUsingHandlesTest()
+        {
+            const DWORD64 cbFile = 1024 * 1024 + 4097;
+            HRESULT hr = S_OK;
+            LPWSTR sczSource = NULL;
+            LPWSTR sczTarget = NULL;
+            HANDLE hSource = INVALID_HANDLE_VALUE;
+            HANDLE hTarget = INVALID_HANDLE_VALUE;
+            DWORD64 qwCopied = 0;
+
+            try
+            {
+                CreateCopySource(cbFile, &sczSource);
+
+                hr = PathCreateTempFile(NULL, L"FileUtilCopyTarget_%05i.bin", 10000, FILE_ATTRIBUTE_NORMAL, &sczTarget, NULL);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                // A small synchronous buffer that doesn't evenly divide the file.
+                hSource = ::CreateFileW(sczSource, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+                Assert::True(INVALID_HANDLE_VALUE != hSource);
+
+                hTarget = ::CreateFileW(sczTarget, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+                Assert::True(INVALID_HANDLE_VALUE != hTarget);
+
+                hr = FileCopyUsingHandlesEx(hSource, hTarget, 0, 4 * 1024, NULL, NULL, &qwCopied);
+                NativeAssert::Succeeded(hr, "Failed to copy file with handles.");
+                NativeAssert::Equal<DWORD64>(cbFile, qwCopied);
+
+                ReleaseFile(hTarget);
+                ReleaseFile(hSource);
+
+                VerifyCopy(sczSource, sczTarget);
+
+                // Files under the threshold ignore the unbuffered flag and still copy.
+                hr = FileCopy(sczSource, sczTarget, FILE_COPY_FLAGS_UNBUFFERED, 0, NULL, NULL, &qwCopied);
+                NativeAssert::Succeeded(hr, "Failed to copy file unbuffered.");
+                NativeAssert::Equal<DWORD64>(cbFile, qwCopied);
+
+                VerifyCopy(sczSource, sczTarget);
+            }
+            finally
+            {
+                ReleaseFile(hTarget);
+                ReleaseFile(hSource);
+
+                if (sczSource)
+                {
+                    FileEnsureDelete(sczSource);
+                }
+
+                if (sczTarget)
+                {
+                    FileEnsureDelete(sczTarget);
+                }
+
+                ReleaseStr(sczTarget);
+                ReleaseStr(sczSource);
+            }
+        }
+
     private:
+        void CreateCopySource(DWORD64 cbFile, LPWSTR* psczPath)
+        {
+            const DWORD cbBlock = 64 * 1024;
+            HRESULT hr = S_OK;
+            HANDLE hFile = INVALID_HANDLE_VALUE;
+            BYTE* pbBlock = NULL;
+            DWORD cbWrite = 0;
+
+            try
+            {
+                pbBlock = static_cast<BYTE*>(MemAlloc(cbBlock, FALSE));
+                Assert::True(NULL != pbBlock);
+
+                hr = PathCreateTempFile(NULL, L"FileUtilCopySource_%05i.bin", 10000, FILE_ATTRIBUTE_NORMAL, psczPath, &hFile);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                for (DWORD64 qwOffset = 0; qwOffset < cbFile; qwOffset += cbWrite)
+                {
+                    cbWrite = static_cast<DWORD>(min(cbBlock, cbFile - qwOffset));
+
+                    // Vary every block so a misplaced block doesn't compare equal.
+                    for (DWORD i = 0; i < cbWrite; ++i)
+                    {
+                        pbBlock[i] = static_cast<BYTE>(i * 7 + (qwOffset >> 16));
+                    }
+
+                    hr = FileWriteHandle(hFile, pbBlock, cbWrite);
+                    NativeAssert::Succeeded(hr, "Failed to write temp file: {0}", *psczPath);
+                }
+            }
+            finally
+            {
+                ReleaseFile(hFile);
+                ReleaseMem(pbBlock);
+            }
+        }
+
+        void VerifyCopy(LPCWSTR wzSource, LPCWSTR wzTarget)
+        {
+            HRESULT hr = S_OK;
+            FILE_MAPPED_VIEW viewSource = { };
+            FILE_MAPPED_VIEW viewTarget = { };
+            HANDLE hSource = INVALID_HANDLE_VALUE;
+            HANDLE hTarget = INVALID_HANDLE_VALUE;
+            const BYTE* pbSource = NULL;
+            const BYTE* pbTarget = NULL;
+            SIZE_T cb = 0;
+
+            try
+            {
+                hSource = ::CreateFileW(wzSource, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+                Assert::True(INVALID_HANDLE_VALUE != hSource);
+
+                hTarget = ::CreateFileW(wzTarget, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+                Assert::True(INVALID_HANDLE_VALUE != hTarget);
+
+                hr = FileMappedViewInitialize(&viewSource, hSource, 0);
+                NativeAssert::Succeeded(hr, "Failed to map file: {0}", wzSource);
+
+                hr = FileMappedViewInitialize(&viewTarget, hTarget, 0);
+                NativeAssert::Succeeded(hr, "Failed to map file: {0}", wzTarget);
+
+                NativeAssert::Equal<DWORD64>(viewSource.qwFileSize, viewTarget.qwFileSize);
+
+                for (DWORD64 qwOffset = 0; qwOffset < viewSource.qwFileSize; qwOffset += cb)
+                {
+                    cb = static_cast<SIZE_T>(min(1024 * 1024, viewSource.qwFileSize - qwOffset));
+
+                    hr = FileMappedViewGet(&viewSource, qwOffset, cb, &pbSource);
+                    NativeAssert::Succeeded(hr, "Failed to get view of file: {0}", wzSource);
+
+                    hr = FileMappedViewGet(&viewTarget, qwOffset, cb, &pbTarget);
+                    NativeAssert::Succeeded(hr, "Failed to get view of file: {0}", wzTarget);
+
+                    Assert::True(0 == memcmp(pbSource, pbTarget, cb));
+                }
+            }
+            finally
+            {
+                FileMappedViewUninitialize(&viewTarget);
+                FileMappedViewUninitialize(&viewSource);
+                ReleaseFile(hTarget);
+                ReleaseFile(hSource);
+            }
+        }
+
         void TestFile(LPWSTR wzDir, LPCWSTR wzTempDir, LPWSTR wzFileName, DWORD dwExpectedStringLength, FILE_ENCODING feExpectedEncoding)
         {
             HRESULT hr = S_OK;
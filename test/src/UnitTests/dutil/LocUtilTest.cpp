@@ -0,0 +1,226 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace DutilTests
+{
+    public ref class LocUtil
+    {
+    public:
+        [Fact]
+        void LocUtilLocalizeStringTest()
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczPath = NULL;
+            LPWSTR sczValue = NULL;
+            WIX_LOCALIZATION* pWixLoc = NULL;
+            LOC_STRING* pLocString = NULL;
+            LOC_CONTROL* pLocControl = NULL;
+
+            hr = XmlInitialize();
+            NativeAssert::Succeeded(hr, "Failed to initialize xml.");
+
+            try
+            {
+                WriteWxl(L"%TEMP%\\LocUtilTest\\Localize.wxl",
+                    L"<WixLocalization Culture='en-us' Language='1033' xmlns='http://wixtoolset.org/schemas/v4/wxl'>"
+                    L"<String Id='Name'>World</String>"
+                    L"<String Id='Greeting'>Hello</String>"
+                    L"<String Id='Name'>Duplicate</String>"
+                    L"<String Id='Nested'>#(loc.Name)</String>"
+                    L"<UI Control='Button' X='1' Width='30'>Click</UI>"
+                    L"</WixLocalization>",
+                    &sczPath);
+
+                hr = LocLoadFromFile(sczPath, &pWixLoc);
+                NativeAssert::Succeeded(hr, "Failed to load localization file.");
+                NativeAssert::Equal<DWORD>(1033, pWixLoc->dwLangId);
+
+                hr = LocAddString(pWixLoc, L"Empty", L"", FALSE);
+                NativeAssert::Succeeded(hr, "Failed to add empty localization string.");
+
+                hr = StrAllocString(&sczValue, L"#(loc.Greeting), #(loc.Name)!#(loc.Empty)#(loc.Missing) #(loc.Oops #(loc.Name)) #(loc.Nested)", 0);
+                NativeAssert::Succeeded(hr, "Failed to copy string to localize.");
+
+                hr = LocLocalizeString(pWixLoc, &sczValue);
+                NativeAssert::Succeeded(hr, "Failed to localize string.");
+
+                // The first definition of a duplicated id wins, unknown ids are left alone, and
+                // localized text isn't localized again.
+                NativeAssert::StringEqual(L"Hello, World!#(loc.Missing) #(loc.Oops World) #(loc.Name)", sczValue);
+
+                hr = StrAllocString(&sczValue, L"No tokens #(loc.", 0);
+                NativeAssert::Succeeded(hr, "Failed to copy string to localize.");
+
+                hr = LocLocalizeString(pWixLoc, &sczValue);
+                NativeAssert::Succeeded(hr, "Failed to localize string without tokens.");
+                NativeAssert::StringEqual(L"No tokens #(loc.", sczValue);
+
+                hr = LocGetString(pWixLoc, L"#(loc.Greeting)", &pLocString);
+                NativeAssert::Succeeded(hr, "Failed to get localization string.");
+                NativeAssert::StringEqual(L"Hello", pLocString->wzText);
+
+                hr = LocGetString(pWixLoc, L"#(loc.greeting)", &pLocString);
+                NativeAssert::ValidReturnCode(hr, E_NOTFOUND);
+
+                hr = LocAddString(pWixLoc, L"Added", L"New", FALSE);
+                NativeAssert::Succeeded(hr, "Failed to add localization string.");
+
+                // Strings that were already indexed are still found after the array grows.
+                hr = StrAllocString(&sczValue, L"#(loc.Added) #(loc.Greeting)", 0);
+                NativeAssert::Succeeded(hr, "Failed to copy string to localize.");
+
+                hr = LocLocalizeString(pWixLoc, &sczValue);
+                NativeAssert::Succeeded(hr, "Failed to localize string with added string.");
+                NativeAssert::StringEqual(L"New Hello", sczValue);
+
+                hr = LocGetControl(pWixLoc, L"Button", &pLocControl);
+                NativeAssert::Succeeded(hr, "Failed to get localized control.");
+                NativeAssert::Equal(1, pLocControl->nX);
+                NativeAssert::Equal(LOC_CONTROL_NOT_SET, pLocControl->nY);
+                NativeAssert::Equal(30, pLocControl->nWidth);
+                NativeAssert::StringEqual(L"Click", pLocControl->wzText);
+
+                hr = LocGetControl(pWixLoc, L"Missing", &pLocControl);
+                NativeAssert::ValidReturnCode(hr, E_NOTFOUND);
+            }
+            finally
+            {
+                LocFree(pWixLoc);
+                ReleaseStr(sczValue);
+                ReleaseStr(sczPath);
+                XmlUninitialize();
+            }
+        }
+
+        [Fact]
+        void LocUtilManyStringsTest()
+        {
+            const DWORD cStrings = 200;
+            const DWORD cControls = 50;
+            const DWORD cTokensPerControl = 4;
+            HRESULT hr = S_OK;
+            LPWSTR sczPath = NULL;
+            LPWSTR sczContents = NULL;
+            LPWSTR sczValue = NULL;
+            LPWSTR sczExpected = NULL;
+            LPWSTR wzWrite = NULL;
+            size_t cchRemaining = 0;
+            WIX_LOCALIZATION* pWixLoc = NULL;
+            LOC_CONTROL* pLocControl = NULL;
+
+            hr = XmlInitialize();
+            NativeAssert::Succeeded(hr, "Failed to initialize xml.");
+
+            try
+            {
+                cchRemaining = (cStrings + cControls) * 96 + 256;
+                hr = StrAlloc(&sczContents, cchRemaining);
+                NativeAssert::Succeeded(hr, "Failed to allocate wxl contents.");
+
+                wzWrite = sczContents;
+                hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"<WixLocalization Culture='en-us' xmlns='http://wixtoolset.org/schemas/v4/wxl'>");
+                NativeAssert::Succeeded(hr, "Failed to format wxl header.");
+
+                for (DWORD i = 0; i < cStrings; ++i)
+                {
+                    hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"<String Id='String%u'>Text for string %u</String>", i, i);
+                    NativeAssert::Succeeded(hr, "Failed to format string {0}.", i);
+                }
+
+                for (DWORD i = 0; i < cControls; ++i)
+                {
+                    hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"<UI Control='Control%u' X='%u'>Control %u</UI>", i, i, i);
+                    NativeAssert::Succeeded(hr, "Failed to format control {0}.", i);
+                }
+
+                hr = ::StringCchPrintfExW(wzWrite, cchRemaining, &wzWrite, &cchRemaining, 0, L"</WixLocalization>");
+                NativeAssert::Succeeded(hr, "Failed to format wxl footer.");
+
+                WriteWxl(L"%TEMP%\\LocUtilTest\\Many.wxl", sczContents, &sczPath);
+
+                hr = LocLoadFromFile(sczPath, &pWixLoc);
+                NativeAssert::Succeeded(hr, "Failed to load localization file.");
+
+                NativeAssert::Equal<DWORD>(cStrings, pWixLoc->cLocStrings);
+                NativeAssert::Equal<DWORD>(cControls, pWixLoc->cLocControls);
+
+                // Localize the way a theme does: every control's text, and a lookup of every control.
+                for (DWORD i = 0; i < cControls; ++i)
+                {
+                    hr = StrAllocString(&sczValue, L"", 0);
+                    NativeAssert::Succeeded(hr, "Failed to reset control text.");
+
+                    for (DWORD j = 0; j < cTokensPerControl; ++j)
+                    {
+                        hr = StrAllocConcatFormatted(&sczValue, L"#(loc.String%u) ", (i * cTokensPerControl + j) * 7 % cStrings);
+                        NativeAssert::Succeeded(hr, "Failed to format control text.");
+                    }
+
+                    hr = LocLocalizeString(pWixLoc, &sczValue);
+                    NativeAssert::Succeeded(hr, "Failed to localize control {0}.", i);
+
+                    hr = LocGetControl(pWixLoc, pWixLoc->rgLocControls[i].wzControl, &pLocControl);
+                    NativeAssert::Succeeded(hr, "Failed to get control {0}.", i);
+                    NativeAssert::Equal<DWORD>(i, pLocControl->nX);
+
+                    hr = StrAllocString(&sczExpected, L"", 0);
+                    NativeAssert::Succeeded(hr, "Failed to reset expected text.");
+
+                    for (DWORD j = 0; j < cTokensPerControl; ++j)
+                    {
+                        hr = StrAllocConcatFormatted(&sczExpected, L"Text for string %u ", (i * cTokensPerControl + j) * 7 % cStrings);
+                        NativeAssert::Succeeded(hr, "Failed to format expected text.");
+                    }
+
+                    NativeAssert::StringEqual(sczExpected, sczValue);
+                }
+            }
+            finally
+            {
+                LocFree(pWixLoc);
+                ReleaseStr(sczExpected);
+                ReleaseStr(sczValue);
+                ReleaseStr(sczContents);
+                ReleaseStr(sczPath);
+                XmlUninitialize();
+            }
+        }
+
+    private:
+        void WriteWxl(LPCWSTR wzPath, LPCWSTR wzContents, LPWSTR* psczPath)
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczDirectory = NULL;
+            LPWSTR sczContents = NULL;
+
+            try
+            {
+                hr = PathExpand(psczPath, wzPath, PATH_EXPAND_ENVIRONMENT);
+                NativeAssert::Succeeded(hr, "Failed to get path to temp wxl file.");
+
+                hr = PathGetDirectory(*psczPath, &sczDirectory);
+                NativeAssert::Succeeded(hr, "Failed to get directory of temp wxl file.");
+
+                hr = DirEnsureExists(sczDirectory, NULL);
+                NativeAssert::Succeeded(hr, "Failed to ensure temp directory exists: {0}", sczDirectory);
+
+                // Write UTF-16 with a byte order mark so the parser doesn't have to guess.
+                hr = StrAllocFormatted(&sczContents, L"\xFEFF%ls", wzContents);
+                NativeAssert::Succeeded(hr, "Failed to format wxl contents.");
+
+                hr = FileWrite(*psczPath, 0, reinterpret_cast<LPCBYTE>(sczContents), lstrlenW(sczContents) * sizeof(WCHAR), NULL);
+                NativeAssert::Succeeded(hr, "Failed to write wxl file: {0}", *psczPath);
+            }
+            finally
+            {
+                ReleaseStr(sczContents);
+                ReleaseStr(sczDirectory);
+            }
+        }
+    };
+}
@@ -427,6 +427,91 @@ namespace DutilTests
             }
         }
 
+        [Fact]
+        void MemUtilArenaTest()
+        {
+            HRESULT hr = S_OK;
+            MEM_ARENA_HANDLE hArena = NULL;
+            BYTE* pbSmall = NULL;
+            BYTE* pbLarge = NULL;
+            LPVOID pvMoved = NULL;
+            LPWSTR sczArena = NULL;
+            LPWSTR sczHeap = NULL;
+            LPWSTR sczLarge = NULL;
+            DWORD cAllocations = 0;
+            DWORD cBlocks = 0;
+            SIZE_T cbAllocated = 0;
+
+            try
+            {
+                hr = MemArenaCreate(4096, &hArena);
+                NativeAssert::Succeeded(hr, "Failed to create arena.");
+
+                pbSmall = static_cast<BYTE*>(MemArenaAlloc(hArena, 10, TRUE));
+                Assert::True(NULL != pbSmall);
+                Assert::True(0 == (reinterpret_cast<ULONG_PTR>(pbSmall) & (MEMORY_ALLOCATION_ALIGNMENT - 1)));
+                NativeAssert::Equal<SIZE_T>(10, MemSize(pbSmall));
+                memcpy(pbSmall, "arena", 6);
+
+                // Freeing leaves the memory with the arena.
+                hr = MemFree(pbSmall);
+                NativeAssert::Succeeded(hr, "Failed to free arena allocation.");
+                Assert::True(0 == memcmp(pbSmall, "arena", 6));
+
+                // Shrinking stays put and growing moves to the heap with the contents.
+                pvMoved = MemReAlloc(pbSmall, 8, FALSE);
+                Assert::True(pbSmall == pvMoved);
+
+                pvMoved = MemReAlloc(pbSmall, 64 * 1024, TRUE);
+                Assert::True(NULL != pvMoved && pbSmall != pvMoved);
+                Assert::True(0 == memcmp(pvMoved, "arena", 6));
+                NativeAssert::Equal<SIZE_T>(64 * 1024, MemSize(pvMoved));
+
+                // Larger than a block gets its own block.
+                pbLarge = static_cast<BYTE*>(MemArenaAlloc(hArena, 10000, FALSE));
+                Assert::True(NULL != pbLarge);
+                NativeAssert::Equal<SIZE_T>(10000, MemSize(pbLarge));
+
+                hr = StrAllocStringArena(hArena, &sczArena, L"arena string", 0);
+                NativeAssert::Succeeded(hr, "Failed to allocate arena string.");
+                NativeAssert::StringEqual(L"arena string", sczArena);
+
+                // strutil keeps working on arena strings.
+                hr = StrAllocConcat(&sczArena, L" that grew past its original allocation", 0);
+                NativeAssert::Succeeded(hr, "Failed to grow arena string.");
+                NativeAssert::StringEqual(L"arena string that grew past its original allocation", sczArena);
+
+                // Without an arena the usual allocation is used.
+                hr = StrAllocStringArena(NULL, &sczHeap, L"heap string", 0);
+                NativeAssert::Succeeded(hr, "Failed to allocate heap string.");
+                NativeAssert::StringEqual(L"heap string", sczHeap);
+
+                // Too large for an arena block, so strings fall back to the heap and free normally.
+                Assert::True(NULL == MemArenaAlloc(hArena, 1024 * 1024, FALSE));
+
+                hr = StrAllocArena(hArena, &sczLarge, 1024 * 1024);
+                NativeAssert::Succeeded(hr, "Failed to allocate large arena string.");
+                NativeAssert::Equal<SIZE_T>(1024 * 1024 * sizeof(WCHAR), MemSize(sczLarge));
+
+                hr = StrFree(sczLarge);
+                sczLarge = NULL;
+                NativeAssert::Succeeded(hr, "Failed to free large string.");
+
+                MemArenaGetStatistics(hArena, &cAllocations, &cBlocks, &cbAllocated);
+                NativeAssert::Equal<DWORD>(3, cAllocations);
+                NativeAssert::Equal<DWORD>(2, cBlocks);
+                Assert::True(cbAllocated >= 10 + 10000 + sizeof(L"arena string"));
+            }
+            finally
+            {
+                ReleaseStr(sczLarge);
+                ReleaseStr(sczHeap);
+                ReleaseStr(sczArena);
+                ReleaseMem(pvMoved);
+                ReleaseMemArena(hArena);
+            }
+        }
+
     private:
         void SetItem(ArrayValue *pValue, DWORD dwValue)
         {
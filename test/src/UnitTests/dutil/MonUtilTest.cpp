@@ -423,6 +423,146 @@ namespace DutilTests
             }
         }
 
+        void TestStress(MON_HANDLE handle, Results *pResults)
+        {
+            const DWORD cDirectories = 4000;
+            const DWORD cRegKeys = 1000;
+            HRESULT hr = S_OK;
+            LPWSTR sczBaseDir = NULL;
+            LPWSTR sczDir = NULL;
+            LPWSTR sczFile = NULL;
+            LPWSTR sczRegKey = NULL;
+            LPCWSTR wzBaseRegKey = L"Software\\MonUtilStressTest\\";
+            DWORD rgdwDirectoriesWritten[] = { 0, cDirectories / 2 - 1, cDirectories - 1 };
+            DWORD rgdwRegKeysWritten[] = { 0, cRegKeys - 1 };
+            HKEY hk = NULL;
+
+            try
+            {
+                hr = PathExpand(&sczBaseDir, L"%TEMP%\\MonUtilStressTest\\", PATH_EXPAND_ENVIRONMENT);
+                NativeAssert::ValidReturnCode(hr, S_OK);
+
+                RemoveDirectory(sczBaseDir);
+
+                hr = RegDelete(HKEY_CURRENT_USER, wzBaseRegKey, REG_KEY_DEFAULT, TRUE);
+                NativeAssert::ValidReturnCode(hr, S_OK, S_FALSE, E_PATHNOTFOUND);
+
+                for (DWORD i = 0; i < cDirectories; ++i)
+                {
+                    hr = StrAllocFormatted(&sczDir, L"%ls%u\\", sczBaseDir, i);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = DirEnsureExists(sczDir, NULL);
+                    NativeAssert::ValidReturnCode(hr, S_OK, S_FALSE);
+                }
+
+                for (DWORD i = 0; i < cRegKeys; ++i)
+                {
+                    hr = StrAllocFormatted(&sczRegKey, L"%ls%u\\", wzBaseRegKey, i);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = RegCreate(HKEY_CURRENT_USER, sczRegKey, KEY_SET_VALUE, &hk);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                    ReleaseRegKey(hk);
+                }
+
+                // Every add returns once its wait is active, so the writes below are all seen
+                for (DWORD i = 0; i < cDirectories; ++i)
+                {
+                    hr = StrAllocFormatted(&sczDir, L"%ls%u\\", sczBaseDir, i);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = MonAddDirectory(handle, sczDir, FALSE, SILENCEPERIOD, NULL);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                }
+
+                for (DWORD i = 0; i < cRegKeys; ++i)
+                {
+                    hr = StrAllocFormatted(&sczRegKey, L"%ls%u\\", wzBaseRegKey, i);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = MonAddRegKey(handle, HKEY_CURRENT_USER, sczRegKey, REG_KEY_DEFAULT, FALSE, SILENCEPERIOD, NULL);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                }
+
+                for (DWORD i = 0; i < countof(rgdwDirectoriesWritten); ++i)
+                {
+                    hr = StrAllocFormatted(&sczFile, L"%ls%u\\file.txt", sczBaseDir, rgdwDirectoriesWritten[i]);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = FileFromString(sczFile, 0, L"contents", FILE_ENCODING_UTF16_WITH_BOM);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                }
+
+                for (DWORD i = 0; i < countof(rgdwRegKeysWritten); ++i)
+                {
+                    hr = StrAllocFormatted(&sczRegKey, L"%ls%u\\", wzBaseRegKey, rgdwRegKeysWritten[i]);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = RegOpen(HKEY_CURRENT_USER, sczRegKey, KEY_SET_VALUE, &hk);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = RegWriteString(hk, L"valuename", L"testvalue");
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                    ReleaseRegKey(hk);
+                }
+
+                ::Sleep(FULLWAIT);
+                Assert::Equal<DWORD>(countof(rgdwDirectoriesWritten), pResults->cDirectories);
+                Assert::Equal<DWORD>(countof(rgdwRegKeysWritten), pResults->cRegKeys);
+
+                // A burst of writes inside the silence period is a single notification
+                for (DWORD i = 0; i < 5; ++i)
+                {
+                    hr = FileFromString(sczFile, 0, L"contents2", FILE_ENCODING_UTF16_WITH_BOM);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                    ::Sleep(PREWAIT);
+                }
+
+                ::Sleep(FULLWAIT);
+                Assert::Equal<DWORD>(countof(rgdwDirectoriesWritten) + 1, pResults->cDirectories);
+
+                for (DWORD i = 0; i < cDirectories; ++i)
+                {
+                    hr = StrAllocFormatted(&sczDir, L"%ls%u\\", sczBaseDir, i);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = MonRemoveDirectory(handle, sczDir, FALSE);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                }
+
+                for (DWORD i = 0; i < cRegKeys; ++i)
+                {
+                    hr = StrAllocFormatted(&sczRegKey, L"%ls%u\\", wzBaseRegKey, i);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+
+                    hr = MonRemoveRegKey(handle, HKEY_CURRENT_USER, sczRegKey, REG_KEY_DEFAULT, FALSE);
+                    NativeAssert::ValidReturnCode(hr, S_OK);
+                }
+                ::Sleep(FULLWAIT);
+
+                hr = FileFromString(sczFile, 0, L"contents3", FILE_ENCODING_UTF16_WITH_BOM);
+                NativeAssert::ValidReturnCode(hr, S_OK);
+
+                ::Sleep(FULLWAIT);
+                Assert::Equal<DWORD>(countof(rgdwDirectoriesWritten) + 1, pResults->cDirectories);
+                Assert::Equal<DWORD>(countof(rgdwRegKeysWritten), pResults->cRegKeys);
+
+                RemoveDirectory(sczBaseDir);
+
+                hr = RegDelete(HKEY_CURRENT_USER, wzBaseRegKey, REG_KEY_DEFAULT, TRUE);
+                NativeAssert::ValidReturnCode(hr, S_OK, S_FALSE, E_PATHNOTFOUND);
+            }
+            finally
+            {
+                ReleaseRegKey(hk);
+                ReleaseStr(sczBaseDir);
+                ReleaseStr(sczDir);
+                ReleaseStr(sczFile);
+                ReleaseStr(sczRegKey);
+            }
+        }
+
         [Fact]
         void MonUtilTest()
         {
@@ -468,6 +608,8 @@ namespace DutilTests
                 ClearResults(pResults);
                 TestMoreThan64(handle, pResults);
                 ClearResults(pResults);
+                TestStress(handle, pResults);
+                ClearResults(pResults);
             }
             finally
             {
@@ -427,6 +427,119 @@ namespace DutilTests
             VerifyRow(&value1, row);
         }
 
+        void TestInsertBatchAndRepeatedQueries(SCE_DATABASE *pDatabase)
+        {
+            const DWORD cRows = 500;
+            HRESULT hr = S_OK;
+            BYTE binary[8] = { 0x12, 0x34 };
+            WCHAR wzString[MAX_PATH] = { };
+            SCE_ROW_HANDLE batchRow = NULL;
+            SCE_QUERY_HANDLE query = NULL;
+            SCE_ROW_HANDLE row = NULL;
+            SCE_ROW_HANDLE heldRow = NULL;
+            DWORD64 qwValue = 0;
+
+            // A rolled back batch leaves nothing behind
+            hr = SceBeginInsertBatch(pDatabase, TABLE_A, &batchRow);
+            NativeAssert::Succeeded(hr, "Failed to begin insert batch");
+
+            InsertBatchRow(batchRow, binary, sizeof(binary), 1000, L"rolledback");
+
+            hr = SceEndInsertBatch(&batchRow, FALSE);
+            NativeAssert::Succeeded(hr, "Failed to roll back insert batch");
+            NativeAssert::True(NULL == batchRow);
+
+            hr = SceBeginInsertBatch(pDatabase, TABLE_A, &batchRow);
+            NativeAssert::Succeeded(hr, "Failed to begin insert batch");
+
+            // Strings of different lengths exercise more than one prepared layout
+            for (DWORD i = 0; i < cRows; ++i)
+            {
+                hr = ::StringCchPrintfW(wzString, countof(wzString), L"batch%0*u", i % 100 + 1, i);
+                NativeAssert::Succeeded(hr, "Failed to format string");
+
+                InsertBatchRow(batchRow, binary, sizeof(binary), 1000, wzString);
+            }
+
+            hr = SceEndInsertBatch(&batchRow, TRUE);
+            NativeAssert::Succeeded(hr, "Failed to commit insert batch");
+
+            // The same point query over and over reuses the prepared seek
+            for (DWORD i = 0; i < cRows; ++i)
+            {
+                hr = ::StringCchPrintfW(wzString, countof(wzString), L"batch%0*u", i % 100 + 1, i);
+                NativeAssert::Succeeded(hr, "Failed to format string");
+
+                hr = SceBeginQuery(pDatabase, TABLE_A, 1, &query);
+                NativeAssert::Succeeded(hr, "Failed to begin query");
+
+                hr = SceSetQueryColumnDword(query, 1000);
+                NativeAssert::Succeeded(hr, "Failed to set query column dword");
+
+                hr = SceSetQueryColumnString(query, wzString);
+                NativeAssert::Succeeded(hr, "Failed to set query column string");
+
+                hr = SceRunQueryExact(&query, &row);
+                NativeAssert::Succeeded(hr, "Failed to find batch row {0}", i);
+
+                hr = SceGetColumnQword(row, TABLE_A_QWORD, &qwValue);
+                NativeAssert::Succeeded(hr, "Failed to get qword value");
+                NativeAssert::Equal<DWORD64>(lstrlenW(wzString), qwValue);
+
+                // Hold the first row so the rest can't seek on its rowset
+                if (0 == i)
+                {
+                    heldRow = row;
+                    row = NULL;
+                }
+
+                ReleaseNullSceRow(row);
+            }
+
+            hr = SceGetColumnQword(heldRow, TABLE_A_QWORD, &qwValue);
+            NativeAssert::Succeeded(hr, "Failed to get qword value from held row");
+            NativeAssert::Equal<DWORD64>(6, qwValue);
+            ReleaseNullSceRow(heldRow);
+
+            hr = SceBeginQuery(pDatabase, TABLE_A, 1, &query);
+            NativeAssert::Succeeded(hr, "Failed to begin query");
+
+            hr = SceSetQueryColumnDword(query, 1000);
+            NativeAssert::Succeeded(hr, "Failed to set query column dword");
+
+            hr = SceSetQueryColumnString(query, L"rolledback");
+            NativeAssert::Succeeded(hr, "Failed to set query column string");
+
+            hr = SceRunQueryExact(&query, &row);
+            NativeAssert::ValidReturnCode(hr, E_NOTFOUND);
+        }
+
+        void InsertBatchRow(SCE_ROW_HANDLE batchRow, BYTE *pbBinary, DWORD cbBinary, DWORD dwValue, LPCWSTR wzValue)
+        {
+            HRESULT hr = S_OK;
+
+            hr = SceSetColumnBinary(batchRow, TABLE_A_BINARY, pbBinary, cbBinary);
+            NativeAssert::Succeeded(hr, "Failed to set binary value");
+
+            hr = SceSetColumnDword(batchRow, TABLE_A_DWORD, dwValue);
+            NativeAssert::Succeeded(hr, "Failed to set dword value");
+
+            hr = SceSetColumnQword(batchRow, TABLE_A_QWORD, lstrlenW(wzValue));
+            NativeAssert::Succeeded(hr, "Failed to set qword value");
+
+            hr = SceSetColumnBool(batchRow, TABLE_A_BOOL, FALSE);
+            NativeAssert::Succeeded(hr, "Failed to set bool value");
+
+            hr = SceSetColumnString(batchRow, TABLE_A_STRING, wzValue);
+            NativeAssert::Succeeded(hr, "Failed to set string value");
+
+            hr = SceSetColumnNull(batchRow, TABLE_A_DWORD_NULLABLE);
+            NativeAssert::Succeeded(hr, "Failed to set null value");
+
+            hr = SceFinishUpdate(batchRow);
+            NativeAssert::Succeeded(hr, "Failed to insert batch row");
+        }
+
         [Fact]
         void SceUtilTest()
         {
@@ -455,6 +568,7 @@ namespace DutilTests
                 NativeAssert::Succeeded(hr, "Failed to ensure database schema");
 
                 TestIndex(pDatabase);
+                TestInsertBatchAndRepeatedQueries(pDatabase);
 
                 hr = SceCloseDatabase(pDatabase);
                 pDatabase = NULL;
@@ -0,0 +1,286 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace DutilTests
+{
+    public ref class ThmUtil
+    {
+    public:
+        [Fact]
+        void ThmUtilPrecompiledThemeTest()
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczThemeFile = NULL;
+            LPWSTR sczCompiledFile = NULL;
+            THEME* pTheme = NULL;
+            THEME* pCompiledTheme = NULL;
+            THEME* pCompiledFromFile = NULL;
+            BYTE* pbTheme = NULL;
+            SIZE_T cbTheme = 0;
+
+            try
+            {
+                hr = ThemeInitialize(::GetModuleHandleW(NULL));
+                NativeAssert::Succeeded(hr, "Failed to initialize theme manager.");
+
+                CreateThemeFile(2, &sczThemeFile);
+
+                hr = ThemeLoadFromFile(sczThemeFile, &pTheme);
+                NativeAssert::Succeeded(hr, "Failed to load theme: {0}", sczThemeFile);
+
+                // Image lists are only decoded when a list view using them is loaded.
+                NativeAssert::Equal<DWORD>(1, pTheme->cImageLists);
+                Assert::True(NULL == pTheme->rgImageLists[0].hImageList);
+
+                hr = ThemeSaveToBuffer(pTheme, &pbTheme, &cbTheme);
+                NativeAssert::Succeeded(hr, "Failed to save theme.");
+
+                hr = ThemeLoadFromBuffer(pbTheme, cbTheme, NULL, NULL, &pCompiledTheme);
+                NativeAssert::Succeeded(hr, "Failed to load precompiled theme.");
+                VerifyTheme(pTheme, pCompiledTheme);
+
+                // The same file name works for either format.
+                hr = PathCreateTempFile(NULL, L"ThmUtilTest_%05i.thm", 10000, FILE_ATTRIBUTE_NORMAL, &sczCompiledFile, NULL);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                hr = FileWrite(sczCompiledFile, FILE_ATTRIBUTE_NORMAL, pbTheme, static_cast<DWORD>(cbTheme), NULL);
+                NativeAssert::Succeeded(hr, "Failed to write precompiled theme: {0}", sczCompiledFile);
+
+                hr = ThemeLoadFromFile(sczCompiledFile, &pCompiledFromFile);
+                NativeAssert::Succeeded(hr, "Failed to load precompiled theme file: {0}", sczCompiledFile);
+                VerifyTheme(pTheme, pCompiledFromFile);
+
+                // A truncated buffer is rejected rather than read past its end.
+                hr = ThemeLoadFromBuffer(pbTheme, cbTheme - 1, NULL, NULL, &pCompiledTheme);
+                Assert::True(FAILED(hr));
+            }
+            finally
+            {
+                ThemeFree(pCompiledFromFile);
+                ThemeFree(pCompiledTheme);
+                ThemeFree(pTheme);
+                ThemeUninitialize();
+
+                if (sczCompiledFile)
+                {
+                    FileEnsureDelete(sczCompiledFile);
+                }
+
+                if (sczThemeFile)
+                {
+                    FileEnsureDelete(sczThemeFile);
+                }
+
+                ReleaseMem(pbTheme);
+                ReleaseStr(sczCompiledFile);
+                ReleaseStr(sczThemeFile);
+            }
+        }
+
+        [Fact]
+        void ThmUtilManyPagesTest()
+        {
+            const DWORD cPages = 20;
+            HRESULT hr = S_OK;
+            LPWSTR sczThemeFile = NULL;
+            LPWSTR sczCompiledFile = NULL;
+            THEME* pTheme = NULL;
+            THEME* pCompiledFromFile = NULL;
+            BYTE* pbTheme = NULL;
+            SIZE_T cbTheme = 0;
+
+            try
+            {
+                hr = ThemeInitialize(::GetModuleHandleW(NULL));
+                NativeAssert::Succeeded(hr, "Failed to initialize theme manager.");
+
+                CreateThemeFile(cPages, &sczThemeFile);
+
+                hr = ThemeLoadFromFile(sczThemeFile, &pTheme);
+                NativeAssert::Succeeded(hr, "Failed to load theme: {0}", sczThemeFile);
+                NativeAssert::Equal<DWORD>(cPages, pTheme->cPages);
+
+                hr = ThemeSaveToBuffer(pTheme, &pbTheme, &cbTheme);
+                NativeAssert::Succeeded(hr, "Failed to save theme.");
+
+                hr = PathCreateTempFile(NULL, L"ThmUtilTest_%05i.thm", 10000, FILE_ATTRIBUTE_NORMAL, &sczCompiledFile, NULL);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                hr = FileWrite(sczCompiledFile, FILE_ATTRIBUTE_NORMAL, pbTheme, static_cast<DWORD>(cbTheme), NULL);
+                NativeAssert::Succeeded(hr, "Failed to write precompiled theme: {0}", sczCompiledFile);
+
+                hr = ThemeLoadFromFile(sczCompiledFile, &pCompiledFromFile);
+                NativeAssert::Succeeded(hr, "Failed to load precompiled theme: {0}", sczCompiledFile);
+                VerifyTheme(pTheme, pCompiledFromFile);
+            }
+            finally
+            {
+                ThemeFree(pCompiledFromFile);
+                ThemeFree(pTheme);
+                ThemeUninitialize();
+
+                if (sczCompiledFile)
+                {
+                    FileEnsureDelete(sczCompiledFile);
+                }
+
+                if (sczThemeFile)
+                {
+                    FileEnsureDelete(sczThemeFile);
+                }
+
+                ReleaseMem(pbTheme);
+                ReleaseStr(sczCompiledFile);
+                ReleaseStr(sczThemeFile);
+            }
+        }
+
+    private:
+        void CreateThemeFile(DWORD cPages, LPWSTR* psczThemeFile)
+        {
+            HRESULT hr = S_OK;
+            LPWSTR sczTheme = NULL;
+            LPSTR sczUtf8 = NULL;
+
+            try
+            {
+                hr = StrAllocString(&sczTheme,
+                    L"<?xml version='1.0' encoding='utf-8'?>"
+                    L"<Theme xmlns='http://wixtoolset.org/schemas/v4/thmutil'>"
+                    L"<Font Id='0' Height='-12' Weight='500' Foreground='windowtext' Background='window'>Segoe UI</Font>"
+                    L"<Font Id='1' Height='-24' Weight='700' Foreground='ff0000'>Segoe UI</Font>"
+                    L"<Window Width='485' Height='300' HexStyle='100a0000' FontId='0' Caption='ThmUtil'>"
+                    L"<ImageList Name='Icons'><Image ImageFile='missing.png'/></ImageList>"
+                    L"<Label X='11' Y='11' Width='-11' Height='30' FontId='1'>Header</Label>"
+                    L"<ListView Name='List' X='11' Y='50' Width='-11' Height='80' FontId='0' ImageList='Icons'>"
+                    L"<Column Width='100' Expands='yes'>Name</Column>"
+                    L"</ListView>", 0);
+                NativeAssert::Succeeded(hr, "Failed to start theme.");
+
+                for (DWORD i = 0; i < cPages; ++i)
+                {
+                    hr = StrAllocConcatFormatted(&sczTheme,
+                        L"<Page Name='Page%u'>"
+                        L"<Label Name='Label%u' X='11' Y='112' Width='-11' Height='30' FontId='0' VisibleCondition='Show%u'>Label %u</Label>"
+                        L"<Checkbox Name='Check%u' X='11' Y='150' Width='-11' Height='17' FontId='0'>Check %u</Checkbox>"
+                        L"<Button Name='Next%u' X='-11' Y='-11' Width='75' Height='23' FontId='0'>"
+                        L"<Text>Next</Text><Text Condition='Last%u'>Finish</Text>"
+                        L"<ChangePageAction Page='Page%u'/>"
+                        L"</Button>"
+                        L"</Page>", i, i, i, i, i, i, i, i, (i + 1) % cPages);
+                    NativeAssert::Succeeded(hr, "Failed to add page {0}", i);
+                }
+
+                hr = StrAllocConcat(&sczTheme, L"</Window></Theme>", 0);
+                NativeAssert::Succeeded(hr, "Failed to finish theme.");
+
+                hr = StrAnsiAllocString(&sczUtf8, sczTheme, 0, CP_UTF8);
+                NativeAssert::Succeeded(hr, "Failed to convert theme to UTF-8.");
+
+                hr = PathCreateTempFile(NULL, L"ThmUtilTest_%05i.xml", 10000, FILE_ATTRIBUTE_NORMAL, psczThemeFile, NULL);
+                NativeAssert::Succeeded(hr, "Failed to create temp file.");
+
+                hr = FileWrite(*psczThemeFile, FILE_ATTRIBUTE_NORMAL, reinterpret_cast<LPCBYTE>(sczUtf8), lstrlenA(sczUtf8), NULL);
+                NativeAssert::Succeeded(hr, "Failed to write theme: {0}", *psczThemeFile);
+            }
+            finally
+            {
+                ReleaseStr(sczUtf8);
+                ReleaseStr(sczTheme);
+            }
+        }
+
+        void VerifyTheme(const THEME* pExpected, const THEME* pActual)
+        {
+            NativeAssert::StringEqual(pExpected->sczCaption, pActual->sczCaption);
+            NativeAssert::Equal<DWORD>(pExpected->dwStyle, pActual->dwStyle);
+            NativeAssert::Equal<DWORD>(pExpected->nWidth, pActual->nWidth);
+            NativeAssert::Equal<DWORD>(pExpected->nHeight, pActual->nHeight);
+
+            NativeAssert::Equal<DWORD>(pExpected->cFonts, pActual->cFonts);
+            for (DWORD i = 0; i < pExpected->cFonts; ++i)
+            {
+                NativeAssert::Equal<DWORD>(pExpected->rgFonts[i].lf.lfHeight, pActual->rgFonts[i].lf.lfHeight);
+                NativeAssert::Equal<DWORD>(pExpected->rgFonts[i].lf.lfWeight, pActual->rgFonts[i].lf.lfWeight);
+                NativeAssert::Equal<DWORD>(pExpected->rgFonts[i].crForeground, pActual->rgFonts[i].crForeground);
+                NativeAssert::Equal<DWORD>(pExpected->rgFonts[i].crBackground, pActual->rgFonts[i].crBackground);
+                Assert::True(NULL != pActual->rgFonts[i].hFont);
+            }
+
+            NativeAssert::Equal<DWORD>(pExpected->cPages, pActual->cPages);
+            for (DWORD i = 0; i < pExpected->cPages; ++i)
+            {
+                NativeAssert::StringEqual(pExpected->rgPages[i].sczName, pActual->rgPages[i].sczName);
+                NativeAssert::Equal<DWORD>(pExpected->rgPages[i].cControlIndices, pActual->rgPages[i].cControlIndices);
+            }
+
+            NativeAssert::Equal<DWORD>(pExpected->cImageLists, pActual->cImageLists);
+            for (DWORD i = 0; i < pExpected->cImageLists; ++i)
+            {
+                NativeAssert::StringEqual(pExpected->rgImageLists[i].sczName, pActual->rgImageLists[i].sczName);
+                NativeAssert::Equal<DWORD>(pExpected->rgImageLists[i].cImages, pActual->rgImageLists[i].cImages);
+                Assert::True(NULL == pActual->rgImageLists[i].hImageList);
+            }
+
+            VerifyControls(pExpected, pExpected->cControls, pExpected->rgControls, pActual, pActual->cControls, pActual->rgControls);
+        }
+
+        void VerifyControls(const THEME* pExpectedTheme, DWORD cExpected, const THEME_CONTROL* rgExpected, const THEME* pActualTheme, DWORD cActual, const THEME_CONTROL* rgActual)
+        {
+            NativeAssert::Equal<DWORD>(cExpected, cActual);
+
+            for (DWORD i = 0; i < cExpected; ++i)
+            {
+                const THEME_CONTROL* pExpected = rgExpected + i;
+                const THEME_CONTROL* pActual = rgActual + i;
+
+                NativeAssert::Equal<DWORD>(pExpected->type, pActual->type);
+                NativeAssert::Equal<DWORD>(pExpected->wPageId, pActual->wPageId);
+                NativeAssert::Equal<DWORD>(pExpected->nX, pActual->nX);
+                NativeAssert::Equal<DWORD>(pExpected->nWidth, pActual->nWidth);
+                NativeAssert::Equal<DWORD>(pExpected->dwStyle, pActual->dwStyle);
+                NativeAssert::Equal<DWORD>(pExpected->dwFontId, pActual->dwFontId);
+                NativeAssert::StringEqual(pExpected->sczName, pActual->sczName);
+                NativeAssert::StringEqual(pExpected->sczText, pActual->sczText);
+                NativeAssert::StringEqual(pExpected->sczVisibleCondition, pActual->sczVisibleCondition);
+                NativeAssert::Equal<DWORD>(pExpected->cConditionalText, pActual->cConditionalText);
+                NativeAssert::Equal<DWORD>(pExpected->cColumns, pActual->cColumns);
+                NativeAssert::Equal<DWORD>(pExpected->cActions, pActual->cActions);
+                NativeAssert::Equal<DWORD>(GetImageListIndex(pExpectedTheme, pExpected), GetImageListIndex(pActualTheme, pActual));
+
+                for (DWORD j = 0; j < pExpected->cConditionalText; ++j)
+                {
+                    NativeAssert::StringEqual(pExpected->rgConditionalText[j].sczCondition, pActual->rgConditionalText[j].sczCondition);
+                    NativeAssert::StringEqual(pExpected->rgConditionalText[j].sczText, pActual->rgConditionalText[j].sczText);
+                }
+
+                for (DWORD j = 0; j < pExpected->cColumns; ++j)
+                {
+                    NativeAssert::StringEqual(pExpected->ptcColumns[j].pszName, pActual->ptcColumns[j].pszName);
+                    NativeAssert::Equal<DWORD>(pExpected->ptcColumns[j].nBaseWidth, pActual->ptcColumns[j].nBaseWidth);
+                    NativeAssert::Equal<DWORD>(pExpected->ptcColumns[j].fExpands, pActual->ptcColumns[j].fExpands);
+                }
+
+                for (DWORD j = 0; j < pExpected->cActions; ++j)
+                {
+                    NativeAssert::Equal<DWORD>(pExpected->rgActions[j].type, pActual->rgActions[j].type);
+                    NativeAssert::StringEqual(pExpected->rgActions[j].ChangePage.sczPageName, pActual->rgActions[j].ChangePage.sczPageName);
+                }
+
+                Assert::True((NULL == pExpected->pDefaultAction) == (NULL == pActual->pDefaultAction));
+
+                VerifyControls(pExpectedTheme, pExpected->cControls, pExpected->rgControls, pActualTheme, pActual->cControls, pActual->rgControls);
+            }
+        }
+
+        DWORD GetImageListIndex(const THEME* pTheme, const THEME_CONTROL* pControl)
+        {
+            return pControl->rgpImageList[0] ? static_cast<DWORD>(pControl->rgpImageList[0] - pTheme->rgImageLists) + 1 : 0;
+        }
+    };
+}
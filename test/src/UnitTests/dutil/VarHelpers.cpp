@@ -24,6 +24,14 @@ namespace DutilTests
         NativeAssert::Succeeded(hr, gcnew String("Failed to set {0} to: {1}"), gcnew String(wzVariable), llValue);
     }
 
+    void VarSetFormattedHelper(VARIABLES_HANDLE pVariables, LPCWSTR wzVariable, LPCWSTR wzValue)
+    {
+        HRESULT hr = S_OK;
+
+        hr = VarSetFormatted(pVariables, wzVariable, wzValue);
+        NativeAssert::Succeeded(hr, "Failed to set {0} to: {1}", wzVariable, wzValue);
+    }
+
     void VarSetVersionHelper(VARIABLES_HANDLE pVariables, LPCWSTR wzVariable, DWORD64 qwValue)
     {
         HRESULT hr = S_OK;
@@ -27,7 +27,7 @@ namespace DutilTests
     public ref class VarUtil
     {
     public:
-        [NamedFact(Skip = "varutil Not Implemented Yet.")]
+        [NamedFact]
         void VarUtilBasicTest()
         {
             HRESULT hr = S_OK;
@@ -76,7 +76,7 @@ namespace DutilTests
             }
         }
 
-        [NamedFact(Skip = "varutil Not Implemented Yet.")]
+        [NamedFact]
         void VarUtilFormatTest()
         {
             HRESULT hr = S_OK;
@@ -127,16 +127,64 @@ namespace DutilTests
             }
         }
 
-        [NamedFact(Skip = "varutil Not Implemented Yet.")]
+        [NamedFact]
+        void VarUtilFormattedTest()
+        {
+            HRESULT hr = S_OK;
+            VARIABLES_HANDLE pVariables = NULL;
+
+            try
+            {
+                hr = VarCreate(&pVariables);
+                NativeAssert::Succeeded(hr, "Failed to initialize variables.");
+
+                VarSetStringHelper(pVariables, L"NAME", L"World");
+                VarSetStringHelper(pVariables, L"LITERAL", L"[NAME]");
+                VarSetFormattedHelper(pVariables, L"GREETING", L"Hello [NAME]");
+                VarSetFormattedHelper(pVariables, L"NESTED", L"[GREETING]!");
+                VarSetFormattedHelper(pVariables, L"ESCAPED", L"[\\[]NAME[\\]]");
+                VarSetFormattedHelper(pVariables, L"SELF", L"[SELF]");
+
+                // string values are never expanded, formatted values are expanded recursively
+                VarGetFormattedHelper(pVariables, L"LITERAL", L"[NAME]");
+                VarGetStringHelper(pVariables, L"GREETING", L"Hello [NAME]");
+                VarGetFormattedHelper(pVariables, L"GREETING", L"Hello World");
+                VarGetFormattedHelper(pVariables, L"NESTED", L"Hello World!");
+                VarGetFormattedHelper(pVariables, L"ESCAPED", L"[NAME]");
+                VarFormatStringHelper(pVariables, L"<[NESTED]> <[LITERAL]>", L"<Hello World!> <[NAME]>");
+
+                // a variable that references itself fails rather than recursing forever
+                LPWSTR scz = NULL;
+                hr = VarGetFormatted(pVariables, L"SELF", &scz);
+                ReleaseStr(scz);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDDATA);
+
+                // setting a variable to null removes its value
+                VarSetStringHelper(pVariables, L"NAME", NULL);
+                VarGetFormattedHelper(pVariables, L"GREETING", L"Hello ");
+
+                LONGLONG llValue = 0;
+                hr = VarGetNumeric(pVariables, L"NAME", &llValue);
+                NativeAssert::ValidReturnCode(hr, E_NOTFOUND);
+            }
+            finally
+            {
+                ReleaseVariables(pVariables);
+            }
+        }
+
+        [NamedFact]
         void VarUtilEscapeTest()
         {
             // test string escaping
             VarEscapeStringHelper(L"[", L"[\\[]");
             VarEscapeStringHelper(L"]", L"[\\]]");
             VarEscapeStringHelper(L" [TEXT] ", L" [\\[]TEXT[\\]] ");
+            VarEscapeStringHelper(L"{TEXT}", L"[\\{]TEXT[\\}]");
+            VarEscapeStringHelper(L"", L"");
         }
 
-        [NamedFact(Skip = "varutil Not Implemented Yet.")]
+        [NamedFact(Skip = "condutil Not Implemented Yet.")]
         void VarUtilConditionTest()
         {
             HRESULT hr = S_OK;
@@ -312,7 +360,7 @@ namespace DutilTests
             }
         }
 
-        [NamedFact(Skip = "varutil Not Implemented Yet.")]
+        [NamedFact]
         void VarUtilValueTest()
         {
             HRESULT hr = S_OK;
@@ -345,7 +393,7 @@ namespace DutilTests
             }
         }
 
-        [NamedFact(Skip = "varutil Not Implemented Yet.")]
+        [NamedFact]
         void VarUtilEnumTest()
         {
             HRESULT hr = S_OK;
@@ -363,6 +411,9 @@ namespace DutilTests
                 hr = VarStartEnum(pVariables, &pEnum, &pValue);
                 NativeAssert::ValidReturnCode(hr, E_NOMOREITEMS);
 
+                VarFinishEnum(pEnum);
+                pEnum = NULL;
+
                 // set variables
                 InitNumericValue(pVariables, values + 0, 2, FALSE, 0, L"PROP1");
                 InitStringValue(pVariables, values + 1, L"VAL2", FALSE, 0, L"PROP2");
@@ -375,13 +426,14 @@ namespace DutilTests
 
                 hr = VarStartEnum(pVariables, &pEnum, &pValue);
                 
-                for (DWORD i = dwIndex - 1; i; --i)
+                for (DWORD i = dwIndex; i; --i)
                 {
                     NativeAssert::ValidReturnCode(hr, S_OK);
 
                     VarUtilContext* pContext = reinterpret_cast<VarUtilContext*>(pValue->pvContext);
                     pContext->dw += 1;
 
+                    ReleaseNullVariableValue(pValue);
                     hr = VarNextVariable(pEnum, &pValue);
                 }
 
@@ -398,13 +450,14 @@ namespace DutilTests
 
                 hr = VarStartEnum(pVariables, &pEnum, &pValue);
 
-                for (DWORD i = dwIndex - 1; i; --i)
+                for (DWORD i = dwIndex; i; --i)
                 {
                     NativeAssert::ValidReturnCode(hr, S_OK);
 
                     VarUtilContext* pContext = reinterpret_cast<VarUtilContext*>(pValue->pvContext);
                     pContext->dw += 1;
 
+                    ReleaseNullVariableValue(pValue);
                     hr = VarNextVariable(pEnum, &pValue);
                 }
 
@@ -424,6 +477,146 @@ namespace DutilTests
             }
         }
 
+        [NamedFact]
+        void VarUtilEnumOrderTest()
+        {
+            HRESULT hr = S_OK;
+            const DWORD cVariables = 100;
+            VARIABLES_HANDLE pVariables = NULL;
+            VARIABLE_ENUM_HANDLE pEnum = NULL;
+            VARIABLE_VALUE* pValue = NULL;
+            LPWSTR sczName = NULL;
+            DWORD cEnumerated = 0;
+
+            try
+            {
+                hr = VarCreate(&pVariables);
+                NativeAssert::Succeeded(hr, "Failed to initialize variables.");
+
+                // add in reverse name order so the enumeration can't be sorted by name
+                for (DWORD i = 0; i < cVariables; ++i)
+                {
+                    hr = StrAllocFormatted(&sczName, L"Var%03u", cVariables - i);
+                    NativeAssert::Succeeded(hr, "Failed to format variable name.");
+
+                    VarSetNumericHelper(pVariables, sczName, i);
+                }
+
+                // updating an existing variable must not move it
+                VarSetStringHelper(pVariables, L"Var050", L"50");
+
+                hr = VarStartEnum(pVariables, &pEnum, &pValue);
+                while (S_OK == hr)
+                {
+                    LONGLONG llValue = 0;
+
+                    if (VARIABLE_VALUE_TYPE_NUMERIC == pValue->type)
+                    {
+                        llValue = pValue->llValue;
+                    }
+                    else
+                    {
+                        hr = StrStringToInt64(pValue->sczValue, 0, &llValue);
+                        NativeAssert::Succeeded(hr, "Failed to parse updated value.");
+                    }
+
+                    NativeAssert::Equal<LONGLONG>(cEnumerated, llValue);
+                    ++cEnumerated;
+
+                    ReleaseNullVariableValue(pValue);
+                    hr = VarNextVariable(pEnum, &pValue);
+                }
+                NativeAssert::ValidReturnCode(hr, E_NOMOREITEMS);
+                NativeAssert::Equal<DWORD>(cVariables, cEnumerated);
+
+                VarFinishEnum(pEnum);
+                pEnum = NULL;
+
+                // adding a variable invalidates an enumeration in progress
+                hr = VarStartEnum(pVariables, &pEnum, &pValue);
+                NativeAssert::Succeeded(hr, "Failed to start enumeration.");
+                ReleaseNullVariableValue(pValue);
+
+                VarSetNumericHelper(pVariables, L"Added", 1);
+
+                hr = VarNextVariable(pEnum, &pValue);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDSTATE);
+            }
+            finally
+            {
+                VarFinishEnum(pEnum);
+                ReleaseVariableValue(pValue);
+                ReleaseStr(sczName);
+                ReleaseVariables(pVariables);
+            }
+        }
+
+        [NamedFact]
+        void VarUtilManyVariablesTest()
+        {
+            HRESULT hr = S_OK;
+            const DWORD cVariables = 10000;
+            const DWORD cReferences = 100;
+            VARIABLES_HANDLE pVariables = NULL;
+            LPWSTR sczName = NULL;
+            LPWSTR sczFormat = NULL;
+            LPWSTR sczExpected = NULL;
+            LPWSTR scz = NULL;
+            LONGLONG llValue = 0;
+
+            try
+            {
+                hr = VarCreate(&pVariables);
+                NativeAssert::Succeeded(hr, "Failed to initialize variables.");
+
+                for (DWORD i = 0; i < cVariables; ++i)
+                {
+                    hr = StrAllocFormatted(&sczName, L"Many.Variable%u", i);
+                    NativeAssert::Succeeded(hr, "Failed to format variable name.");
+
+                    hr = VarSetNumeric(pVariables, sczName, i);
+                    NativeAssert::Succeeded(hr, "Failed to set variable {0}", sczName);
+                }
+
+                for (DWORD i = 0; i < cVariables; ++i)
+                {
+                    hr = StrAllocFormatted(&sczName, L"Many.Variable%u", i);
+                    NativeAssert::Succeeded(hr, "Failed to format variable name.");
+
+                    hr = VarGetNumeric(pVariables, sczName, &llValue);
+                    NativeAssert::Succeeded(hr, "Failed to get variable {0}", sczName);
+                    NativeAssert::Equal<LONGLONG>(i, llValue);
+                }
+
+                for (DWORD i = 0; i < cReferences; ++i)
+                {
+                    hr = StrAllocFormatted(&sczName, L"[Many.Variable%u] ", i * 97);
+                    NativeAssert::Succeeded(hr, "Failed to format variable reference.");
+
+                    hr = StrAllocConcat(&sczFormat, sczName, 0);
+                    NativeAssert::Succeeded(hr, "Failed to build format string.");
+
+                    hr = StrAllocFormatted(&sczName, L"%u ", i * 97);
+                    NativeAssert::Succeeded(hr, "Failed to format expected value.");
+
+                    hr = StrAllocConcat(&sczExpected, sczName, 0);
+                    NativeAssert::Succeeded(hr, "Failed to build expected string.");
+                }
+
+                hr = VarFormatString(pVariables, sczFormat, &scz, NULL);
+                NativeAssert::Succeeded(hr, "Failed to format string.");
+                NativeAssert::StringEqual(sczExpected, scz);
+            }
+            finally
+            {
+                ReleaseStr(scz);
+                ReleaseStr(sczExpected);
+                ReleaseStr(sczFormat);
+                ReleaseStr(sczName);
+                ReleaseVariables(pVariables);
+            }
+        }
+
     private:
         void InitNoneValue(VARIABLES_HANDLE pVariables, VARIABLE_VALUE* pValue, BOOL fHidden, DWORD dw, LPCWSTR wz)
         {
@@ -504,7 +697,7 @@ namespace DutilTests
                 NativeAssert::Succeeded(hr, "Failed to get value: {0}", pExpectedContext->scz);
 
                 NativeAssert::Equal<DWORD>(pExpectedValue->type, pActualValue->type);
-                NativeAssert::InRange<DWORD>(pExpectedValue->type, VARIABLE_VALUE_TYPE_NONE, VARIABLE_VALUE_TYPE_STRING);
+                NativeAssert::InRange<DWORD>(pExpectedValue->type, VARIABLE_VALUE_TYPE_NONE, VARIABLE_VALUE_TYPE_FORMATTED);
 
                 switch (pExpectedValue->type)
                 {
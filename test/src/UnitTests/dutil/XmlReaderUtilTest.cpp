@@ -0,0 +1,237 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace DutilTests
+{
+    public ref class XmlReaderUtil
+    {
+    public:
+        [Fact]
+        void XmlReaderUtilElementTest()
+        {
+            HRESULT hr = S_OK;
+            XML_READER reader = { };
+            LPCSTR szDocument =
+                "\xEF\xBB\xBF<?xml version='1.0' encoding='utf-8'?>\r\n"
+                "<!-- leading comment -->\r\n"
+                "<Root xmlns='http://example.com/test' Name=\"a &amp; b &lt;c&gt; &#65;&#x42;\" Multi='one\r\ntwo\tthree'>\r\n"
+                "    <Child Id='1' Enabled='yes' Size='12345678901' />\r\n"
+                "    <Skipped><Deeper Id='x'><Child Id='not a direct child' /></Deeper></Skipped>\r\n"
+                "    <Child Id='2' Enabled='no'>text &quot;here&quot;<![CDATA[ <raw> & ]]></Child>\r\n"
+                "</Root>\r\n";
+            LPCWSTR wzElement = NULL;
+            LPCWSTR wzValue = NULL;
+            LPWSTR sczValue = NULL;
+            BOOL fYes = FALSE;
+            DWORD dwValue = 0;
+            DWORD64 qwValue = 0;
+            DWORD dwRootDepth = 0;
+
+            try
+            {
+                hr = XmlReaderInitializeFromBuffer(reinterpret_cast<const BYTE*>(szDocument), lstrlenA(szDocument), &reader);
+                NativeAssert::Succeeded(hr, "Failed to initialize xml reader.");
+
+                hr = XmlReaderNextElement(&reader, 0, &wzElement);
+                NativeAssert::Succeeded(hr, "Failed to read document element.");
+                NativeAssert::StringEqual(L"Root", wzElement);
+
+                dwRootDepth = reader.dwDepth;
+                NativeAssert::Equal<DWORD>(1, dwRootDepth);
+
+                hr = XmlReaderGetAttributeValue(&reader, L"Name", &wzValue);
+                NativeAssert::Succeeded(hr, "Failed to get Root/@Name.");
+                NativeAssert::StringEqual(L"a & b <c> AB", wzValue);
+
+                hr = XmlReaderGetAttribute(&reader, L"Multi", &sczValue);
+                NativeAssert::Succeeded(hr, "Failed to get Root/@Multi.");
+                NativeAssert::StringEqual(L"one two three", sczValue);
+
+                hr = XmlReaderGetAttributeValue(&reader, L"Missing", &wzValue);
+                NativeAssert::ValidReturnCode(hr, E_NOTFOUND);
+
+                // First child closes itself.
+                hr = XmlReaderNextElement(&reader, dwRootDepth, &wzElement);
+                NativeAssert::Succeeded(hr, "Failed to read first child.");
+                NativeAssert::StringEqual(L"Child", wzElement);
+
+                hr = XmlReaderGetAttributeNumber(&reader, L"Id", &dwValue);
+                NativeAssert::Succeeded(hr, "Failed to get Child/@Id.");
+                NativeAssert::Equal<DWORD>(1, dwValue);
+
+                hr = XmlReaderGetYesNoAttribute(&reader, L"Enabled", &fYes);
+                NativeAssert::Succeeded(hr, "Failed to get Child/@Enabled.");
+                Assert::True(fYes);
+
+                hr = XmlReaderGetAttributeLargeNumber(&reader, L"Size", &qwValue);
+                NativeAssert::Succeeded(hr, "Failed to get Child/@Size.");
+                NativeAssert::Equal<DWORD64>(12345678901, qwValue);
+
+                hr = XmlReaderGetAttributeNumber(&reader, L"Missing", &dwValue);
+                NativeAssert::ValidReturnCode(hr, S_FALSE);
+
+                // Skipped's subtree is stepped over without being reported.
+                hr = XmlReaderNextElement(&reader, dwRootDepth, &wzElement);
+                NativeAssert::Succeeded(hr, "Failed to read skipped child.");
+                NativeAssert::StringEqual(L"Skipped", wzElement);
+
+                hr = XmlReaderNextElement(&reader, dwRootDepth, &wzElement);
+                NativeAssert::Succeeded(hr, "Failed to read second child.");
+                NativeAssert::StringEqual(L"Child", wzElement);
+
+                hr = XmlReaderGetYesNoAttribute(&reader, L"Enabled", &fYes);
+                NativeAssert::Succeeded(hr, "Failed to get Child/@Enabled.");
+                Assert::False(fYes);
+
+                hr = XmlReaderReadElementText(&reader, &sczValue);
+                NativeAssert::Succeeded(hr, "Failed to read Child text.");
+                NativeAssert::StringEqual(L"text \"here\" <raw> & ", sczValue);
+
+                hr = XmlReaderNextElement(&reader, dwRootDepth, &wzElement);
+                NativeAssert::ValidReturnCode(hr, S_FALSE);
+
+                hr = XmlReaderNextElement(&reader, 0, &wzElement);
+                NativeAssert::ValidReturnCode(hr, S_FALSE);
+            }
+            finally
+            {
+                ReleaseStr(sczValue);
+                XmlReaderUninitialize(&reader);
+            }
+        }
+
+        [Fact]
+        void XmlReaderUtilCompiledTest()
+        {
+            HRESULT hr = S_OK;
+            HRESULT hrCompiled = S_OK;
+            XML_READER reader = { };
+            XML_READER compiledReader = { };
+            LPCWSTR wzDocument =
+                L"<?xml version='1.0'?>\r\n"
+                L"<Root xmlns='http://example.com/test' Name='a &amp; b'>\r\n"
+                L"    <Child Id='1' Enabled='yes' />\r\n"
+                L"    <Child Id='2' Enabled='yes'>text<![CDATA[ <raw> ]]></Child>\r\n"
+                L"    <!-- comment -->\r\n"
+                L"    <Empty></Empty>\r\n"
+                L"</Root>";
+            BYTE* pbCompiled = NULL;
+            SIZE_T cbCompiled = 0;
+            DWORD cNodes = 0;
+
+            try
+            {
+                hr = XmlReaderInitialize(wzDocument, &reader);
+                NativeAssert::Succeeded(hr, "Failed to initialize xml reader.");
+
+                hr = XmlReaderCompile(&reader, &pbCompiled, &cbCompiled);
+                NativeAssert::Succeeded(hr, "Failed to compile xml document.");
+                Assert::True(XmlReaderIsCompiled(pbCompiled, cbCompiled));
+                Assert::False(XmlReaderIsCompiled(reinterpret_cast<const BYTE*>(wzDocument), lstrlenW(wzDocument) * sizeof(WCHAR)));
+
+                XmlReaderUninitialize(&reader);
+
+                hr = XmlReaderInitialize(wzDocument, &reader);
+                NativeAssert::Succeeded(hr, "Failed to initialize xml reader.");
+
+                hr = XmlReaderInitializeFromCompiled(pbCompiled, cbCompiled, &compiledReader);
+                NativeAssert::Succeeded(hr, "Failed to initialize compiled xml reader.");
+
+                // Both readers report exactly the same nodes.
+                for (;;)
+                {
+                    hr = XmlReaderRead(&reader, NULL);
+                    hrCompiled = XmlReaderRead(&compiledReader, NULL);
+                    NativeAssert::ValidReturnCode(hrCompiled, hr);
+                    if (E_NOMOREITEMS == hr)
+                    {
+                        break;
+                    }
+                    NativeAssert::Succeeded(hr, "Failed to read node {0}.", cNodes);
+
+                    NativeAssert::Equal<DWORD>(reader.node, compiledReader.node);
+                    NativeAssert::Equal<DWORD>(reader.dwDepth, compiledReader.dwDepth);
+                    if (XML_READER_NODE_TEXT == reader.node)
+                    {
+                        NativeAssert::StringEqual(reader.wzText, compiledReader.wzText);
+                    }
+                    else
+                    {
+                        NativeAssert::StringEqual(reader.wzName, compiledReader.wzName);
+                    }
+
+                    if (XML_READER_NODE_ELEMENT == reader.node)
+                    {
+                        NativeAssert::Equal<DWORD>(reader.cAttributes, compiledReader.cAttributes);
+                        for (DWORD i = 0; i < reader.cAttributes; ++i)
+                        {
+                            NativeAssert::StringEqual(reader.rgAttributes[i].wzName, compiledReader.rgAttributes[i].wzName);
+                            NativeAssert::StringEqual(reader.rgAttributes[i].wzValue, compiledReader.rgAttributes[i].wzValue);
+                        }
+                    }
+
+                    ++cNodes;
+                }
+
+                NativeAssert::Equal<DWORD>(10, cNodes);
+
+                // Every reference is checked when the compiled document is loaded.
+                XmlReaderUninitialize(&compiledReader);
+
+                reinterpret_cast<XML_READER_COMPILED_NODE*>(pbCompiled + sizeof(XML_READER_COMPILED_HEADER))->iString = 0xFFFF;
+
+                hr = XmlReaderInitializeFromCompiled(pbCompiled, cbCompiled, &compiledReader);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDDATA);
+
+                hr = XmlReaderInitializeFromCompiled(pbCompiled, cbCompiled - 1, &compiledReader);
+                NativeAssert::ValidReturnCode(hr, E_INVALIDDATA);
+            }
+            finally
+            {
+                ReleaseMem(pbCompiled);
+                XmlReaderUninitialize(&compiledReader);
+                XmlReaderUninitialize(&reader);
+            }
+        }
+
+        [Fact]
+        void XmlReaderUtilInvalidDocumentTest()
+        {
+            ExpectInvalid(L"<Root><Child></Root>");
+            ExpectInvalid(L"<Root>");
+            ExpectInvalid(L"<Root Attribute=unquoted />");
+            ExpectInvalid(L"<Root Attribute='&unknown;' />");
+            ExpectInvalid(L"<Root/><Second/>");
+            ExpectInvalid(L"<!DOCTYPE Root [<!ENTITY e 'x'>]><Root>&e;</Root>");
+        }
+
+    private:
+        void ExpectInvalid(LPCWSTR wzDocument)
+        {
+            HRESULT hr = S_OK;
+            XML_READER reader = { };
+
+            try
+            {
+                hr = XmlReaderInitialize(wzDocument, &reader);
+                NativeAssert::Succeeded(hr, "Failed to initialize xml reader.");
+
+                do
+                {
+                    hr = XmlReaderRead(&reader, NULL);
+                } while (S_OK == hr);
+
+                NativeAssert::ValidReturnCode(hr, E_INVALIDDATA);
+            }
+            finally
+            {
+                XmlReaderUninitialize(&reader);
+            }
+        }
+    };
+}
@@ -5,16 +5,20 @@
 #include <windows.h>
 #include <strsafe.h>
 #include <ShlObj.h>
+#include <commctrl.h>
 
 // Include error.h before dutil.h
 #include "error.h"
 #include <dutil.h>
 
+#include <aclutil.h>
+#include <buffutil.h>
 #include <dictutil.h>
 #include <dirutil.h>
 #include <fileutil.h>
 #include <guidutil.h>
 #include <iniutil.h>
+#include <locutil.h>
 #include <memutil.h>
 #include <pathutil.h>
 #include <strutil.h>
@@ -23,6 +27,9 @@
 #include <uriutil.h>
 #include <varutil.h>
 #include <condutil.h>
+#include <thmutil.h>
+#include <xmlutil.h>
+#include <xmlreaderutil.h>
 
 #include "VarHelpers.h"
 
@@ -0,0 +1,218 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace ExtTests
+{
+    public ref class ComPlusCollectionIndex
+    {
+    public:
+        [Fact]
+        void ComPlusCollectionIndexFindByKeyTest()
+        {
+            CFakeCatalogCollection* pColl = new CFakeCatalogCollection();
+            CPI_COLLECTION_INDEX index = { };
+
+            try
+            {
+                pColl->Append(new CFakeCatalogObject(L"{11111111-1111-1111-1111-111111111111}", L"Alpha"));
+                pColl->Append(new CFakeCatalogObject(L"{22222222-2222-2222-2222-222222222222}", L"Beta"));
+                pColl->Append(new CFakeCatalogObject(L"{33333333-3333-3333-3333-333333333333}", L"Gamma"));
+
+                CpiCollectionIndexInitialize(pColl, &index);
+
+                ExpectObject(pColl->ObjectAt(1), FindByStringKey(&index, L"{22222222-2222-2222-2222-222222222222}"));
+                ExpectObject(pColl->ObjectAt(2), FindByStringKey(&index, L"{33333333-3333-3333-3333-333333333333}"));
+                ExpectObject(NULL, FindByStringKey(&index, L"{44444444-4444-4444-4444-444444444444}"));
+
+                ExpectObject(pColl->ObjectAt(0), FindByName(&index, L"Alpha"));
+                ExpectObject(pColl->ObjectAt(2), FindByName(&index, L"Gamma"));
+                ExpectObject(NULL, FindByName(&index, L"gamma"));
+                ExpectObject(NULL, FindByName(&index, L"Delta"));
+
+                // GUID keys don't convert to integers.
+                ExpectObject(NULL, FindByIntegerKey(&index, 1));
+
+                // The collection is only walked once no matter how many lookups there are.
+                NativeAssert::Equal<long>(3, pColl->cGetItem);
+                NativeAssert::Equal<long>(0, pColl->cPopulate);
+            }
+            finally
+            {
+                CpiCollectionIndexUninitialize(&index);
+                pColl->Release();
+            }
+        }
+
+        [Fact]
+        void ComPlusCollectionIndexFindByIntegerKeyTest()
+        {
+            CFakeCatalogCollection* pColl = new CFakeCatalogCollection();
+            CPI_COLLECTION_INDEX index = { };
+
+            try
+            {
+                pColl->Append(new CFakeCatalogObject(0L, L"QueryInterface"));
+                pColl->Append(new CFakeCatalogObject(1L, L"AddRef"));
+                pColl->Append(new CFakeCatalogObject(7L, L"DoWork"));
+
+                CpiCollectionIndexInitialize(pColl, &index);
+
+                ExpectObject(pColl->ObjectAt(0), FindByIntegerKey(&index, 0));
+                ExpectObject(pColl->ObjectAt(2), FindByIntegerKey(&index, 7));
+                ExpectObject(NULL, FindByIntegerKey(&index, 2));
+
+                // Integer keys can still be found by their string form.
+                ExpectObject(pColl->ObjectAt(1), FindByStringKey(&index, L"1"));
+                ExpectObject(pColl->ObjectAt(2), FindByName(&index, L"DoWork"));
+
+                NativeAssert::Equal<long>(3, pColl->cGetItem);
+            }
+            finally
+            {
+                CpiCollectionIndexUninitialize(&index);
+                pColl->Release();
+            }
+        }
+
+        [Fact]
+        void ComPlusCollectionIndexDuplicatesTest()
+        {
+            CFakeCatalogCollection* pColl = new CFakeCatalogCollection();
+            CPI_COLLECTION_INDEX index = { };
+
+            try
+            {
+                pColl->Append(new CFakeCatalogObject(L"{AAAAAAAA-AAAA-AAAA-AAAA-AAAAAAAAAAAA}", L"First"));
+                pColl->Append(new CFakeCatalogObject(L"{aaaaaaaa-aaaa-aaaa-aaaa-aaaaaaaaaaaa}", L"Second"));
+                pColl->Append(new CFakeCatalogObject(L"{BBBBBBBB-BBBB-BBBB-BBBB-BBBBBBBBBBBB}", L"Shared"));
+                pColl->Append(new CFakeCatalogObject(L"{CCCCCCCC-CCCC-CCCC-CCCC-CCCCCCCCCCCC}", L"Shared"));
+                pColl->Append(new CFakeCatalogObject(5L, L"Five"));
+                pColl->Append(new CFakeCatalogObject(5L, L"AlsoFive"));
+
+                CpiCollectionIndexInitialize(pColl, &index);
+
+                // The first of any duplicates wins, like it did when the collection was searched in order.
+                ExpectObject(pColl->ObjectAt(0), FindByStringKey(&index, L"{aaaaaaaa-aaaa-aaaa-aaaa-aaaaaaaaaaaa}"));
+                ExpectObject(pColl->ObjectAt(2), FindByName(&index, L"Shared"));
+                ExpectObject(pColl->ObjectAt(4), FindByIntegerKey(&index, 5));
+
+                // Later duplicates can still be found by anything they don't share.
+                ExpectObject(pColl->ObjectAt(1), FindByName(&index, L"Second"));
+                ExpectObject(pColl->ObjectAt(3), FindByStringKey(&index, L"{CCCCCCCC-CCCC-CCCC-CCCC-CCCCCCCCCCCC}"));
+            }
+            finally
+            {
+                CpiCollectionIndexUninitialize(&index);
+                pColl->Release();
+            }
+        }
+
+        [Fact]
+        void ComPlusCollectionIndexSaveChangesTest()
+        {
+            HRESULT hr = S_OK;
+            CFakeCatalogCollection* pColl = new CFakeCatalogCollection();
+            CPI_COLLECTION_INDEX index = { };
+
+            try
+            {
+                pColl->Append(new CFakeCatalogObject(L"{11111111-1111-1111-1111-111111111111}", L"Alpha"));
+                pColl->Append(new CFakeCatalogObject(L"{22222222-2222-2222-2222-222222222222}", L"Beta"));
+                pColl->Append(new CFakeCatalogObject(L"{33333333-3333-3333-3333-333333333333}", L"Gamma"));
+                pColl->Append(new CFakeCatalogObject(L"{44444444-4444-4444-4444-444444444444}", L"Delta"));
+
+                CpiCollectionIndexInitialize(pColl, &index);
+
+                // Nothing changed yet, so there's nothing to save.
+                hr = CpiCollectionIndexSaveChanges(&index);
+                NativeAssert::Succeeded(hr, "Failed to save unchanged collection.");
+                NativeAssert::Equal<long>(0, pColl->cSaveChanges);
+
+                hr = CpiCollectionIndexRemoveByStringKey(&index, L"{22222222-2222-2222-2222-222222222222}");
+                NativeAssert::ValidReturnCode(hr, S_OK);
+                ExpectObject(NULL, FindByStringKey(&index, L"{22222222-2222-2222-2222-222222222222}"));
+                ExpectObject(NULL, FindByName(&index, L"Beta"));
+
+                // The objects after a removed one move up, so the next removal has to use the new position.
+                hr = CpiCollectionIndexRemoveByStringKey(&index, L"{33333333-3333-3333-3333-333333333333}");
+                NativeAssert::ValidReturnCode(hr, S_OK);
+                NativeAssert::Equal<long>(2, pColl->cRemove);
+                ExpectObject(pColl->ObjectAt(1), FindByName(&index, L"Delta"));
+
+                hr = CpiCollectionIndexRemoveByStringKey(&index, L"{33333333-3333-3333-3333-333333333333}");
+                NativeAssert::ValidReturnCode(hr, S_FALSE);
+                NativeAssert::Equal<long>(2, pColl->cRemove);
+
+                NativeAssert::Equal<long>(4, pColl->cGetItem);
+                NativeAssert::Equal<long>(0, pColl->cPopulate);
+
+                hr = CpiCollectionIndexSaveChanges(&index);
+                NativeAssert::Succeeded(hr, "Failed to save changed collection.");
+                NativeAssert::Equal<long>(1, pColl->cSaveChanges);
+
+                // The catalog may change objects when they're saved, so the next lookup repopulates and sees the change.
+                pColl->ObjectAt(0)->SetName(L"Renamed");
+
+                ExpectObject(pColl->ObjectAt(0), FindByName(&index, L"Renamed"));
+                ExpectObject(NULL, FindByName(&index, L"Alpha"));
+                ExpectObject(pColl->ObjectAt(1), FindByStringKey(&index, L"{44444444-4444-4444-4444-444444444444}"));
+                NativeAssert::Equal<long>(1, pColl->cPopulate);
+                NativeAssert::Equal<long>(6, pColl->cGetItem);
+
+                hr = CpiCollectionIndexSaveChanges(&index);
+                NativeAssert::Succeeded(hr, "Failed to save collection again.");
+                NativeAssert::Equal<long>(1, pColl->cSaveChanges);
+            }
+            finally
+            {
+                CpiCollectionIndexUninitialize(&index);
+                pColl->Release();
+            }
+        }
+
+    private:
+        // The fake collection keeps its own reference, so the returned object stays valid.
+        ICatalogObject* FindByStringKey(CPI_COLLECTION_INDEX* pIndex, LPCWSTR wzKey)
+        {
+            ICatalogObject* piObj = NULL;
+
+            HRESULT hr = CpiCollectionIndexFindByStringKey(pIndex, wzKey, &piObj);
+            NativeAssert::Succeeded(hr, "Failed to find object by key: {0}", wzKey);
+
+            ReleaseObject(piObj);
+            return piObj;
+        }
+
+        ICatalogObject* FindByIntegerKey(CPI_COLLECTION_INDEX* pIndex, long lKey)
+        {
+            ICatalogObject* piObj = NULL;
+
+            HRESULT hr = CpiCollectionIndexFindByIntegerKey(pIndex, lKey, &piObj);
+            NativeAssert::Succeeded(hr, "Failed to find object by integer key.");
+
+            ReleaseObject(piObj);
+            return piObj;
+        }
+
+        ICatalogObject* FindByName(CPI_COLLECTION_INDEX* pIndex, LPCWSTR wzName)
+        {
+            ICatalogObject* piObj = NULL;
+
+            HRESULT hr = CpiCollectionIndexFindByName(pIndex, wzName, &piObj);
+            NativeAssert::Succeeded(hr, "Failed to find object by name: {0}", wzName);
+
+            ReleaseObject(piObj);
+            return piObj;
+        }
+
+        void ExpectObject(CFakeCatalogObject* pExpected, ICatalogObject* piActual)
+        {
+            Assert::True(static_cast<ICatalogObject*>(pExpected) == piActual);
+        }
+    };
+}
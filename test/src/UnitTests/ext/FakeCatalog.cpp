@@ -0,0 +1,328 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+
+using namespace Xunit;
+
+
+namespace ExtTests
+{
+    CFakeCatalogObject::CFakeCatalogObject(LPCWSTR wzKey, LPCWSTR wzName)
+    {
+        m_cReferences = 1;
+        ::VariantInit(&m_vtKey);
+        m_vtKey.vt = VT_BSTR;
+        m_vtKey.bstrVal = ::SysAllocString(wzKey);
+        m_bstrName = ::SysAllocString(wzName);
+    }
+
+    CFakeCatalogObject::CFakeCatalogObject(long lKey, LPCWSTR wzName)
+    {
+        m_cReferences = 1;
+        ::VariantInit(&m_vtKey);
+        m_vtKey.vt = VT_I4;
+        m_vtKey.lVal = lKey;
+        m_bstrName = ::SysAllocString(wzName);
+    }
+
+    CFakeCatalogObject::~CFakeCatalogObject()
+    {
+        ::VariantClear(&m_vtKey);
+        ReleaseBSTR(m_bstrName);
+    }
+
+    void CFakeCatalogObject::SetName(LPCWSTR wzName)
+    {
+        ReleaseBSTR(m_bstrName);
+        m_bstrName = ::SysAllocString(wzName);
+    }
+
+    STDMETHODIMP CFakeCatalogObject::QueryInterface(const IID& riid, void** ppvObject)
+    {
+        if (::IsEqualIID(__uuidof(ICatalogObject), riid) || ::IsEqualIID(IID_IDispatch, riid) || ::IsEqualIID(IID_IUnknown, riid))
+        {
+            *ppvObject = static_cast<ICatalogObject*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        *ppvObject = NULL;
+        return E_NOINTERFACE;
+    }
+
+    STDMETHODIMP_(ULONG) CFakeCatalogObject::AddRef()
+    {
+        return ::InterlockedIncrement(&m_cReferences);
+    }
+
+    STDMETHODIMP_(ULONG) CFakeCatalogObject::Release()
+    {
+        long l = ::InterlockedDecrement(&m_cReferences);
+        if (0 < l)
+        {
+            return l;
+        }
+
+        delete this;
+        return 0;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::GetTypeInfoCount(UINT*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::GetTypeInfo(UINT, LCID, ITypeInfo**)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::GetIDsOfNames(const IID&, LPOLESTR*, UINT, LCID, DISPID*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::Invoke(DISPID, const IID&, LCID, WORD, DISPPARAMS*, VARIANT*, EXCEPINFO*, UINT*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::get_Value(BSTR, VARIANT*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::put_Value(BSTR, VARIANT)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::get_Key(VARIANT* pvarRetVal)
+    {
+        ::VariantInit(pvarRetVal);
+        return ::VariantCopy(pvarRetVal, &m_vtKey);
+    }
+
+    STDMETHODIMP CFakeCatalogObject::get_Name(VARIANT* pvarRetVal)
+    {
+        ::VariantInit(pvarRetVal);
+        pvarRetVal->vt = VT_BSTR;
+        pvarRetVal->bstrVal = ::SysAllocString(m_bstrName);
+        return pvarRetVal->bstrVal ? S_OK : E_OUTOFMEMORY;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::IsPropertyReadOnly(BSTR, VARIANT_BOOL*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::get_Valid(VARIANT_BOOL* pbRetVal)
+    {
+        *pbRetVal = VARIANT_TRUE;
+        return S_OK;
+    }
+
+    STDMETHODIMP CFakeCatalogObject::IsPropertyWriteOnly(BSTR, VARIANT_BOOL*)
+    {
+        return E_NOTIMPL;
+    }
+
+
+    CFakeCatalogCollection::CFakeCatalogCollection()
+    {
+        cGetItem = 0;
+        cRemove = 0;
+        cPopulate = 0;
+        cSaveChanges = 0;
+
+        m_cReferences = 1;
+        m_cChanges = 0;
+        m_cObjects = 0;
+    }
+
+    CFakeCatalogCollection::~CFakeCatalogCollection()
+    {
+        for (long i = 0; i < m_cObjects; ++i)
+        {
+            m_rgpObjects[i]->Release();
+        }
+    }
+
+    // Takes over the caller's reference to the object.
+    void CFakeCatalogCollection::Append(CFakeCatalogObject* pObject)
+    {
+        Assert::True(FAKE_CATALOG_MAX_OBJECTS > m_cObjects);
+
+        m_rgpObjects[m_cObjects] = pObject;
+        ++m_cObjects;
+    }
+
+    CFakeCatalogObject* CFakeCatalogCollection::ObjectAt(long lIndex)
+    {
+        Assert::True(0 <= lIndex && lIndex < m_cObjects);
+
+        return m_rgpObjects[lIndex];
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::QueryInterface(const IID& riid, void** ppvObject)
+    {
+        if (::IsEqualIID(__uuidof(ICatalogCollection), riid) || ::IsEqualIID(IID_IDispatch, riid) || ::IsEqualIID(IID_IUnknown, riid))
+        {
+            *ppvObject = static_cast<ICatalogCollection*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        *ppvObject = NULL;
+        return E_NOINTERFACE;
+    }
+
+    STDMETHODIMP_(ULONG) CFakeCatalogCollection::AddRef()
+    {
+        return ::InterlockedIncrement(&m_cReferences);
+    }
+
+    STDMETHODIMP_(ULONG) CFakeCatalogCollection::Release()
+    {
+        long l = ::InterlockedDecrement(&m_cReferences);
+        if (0 < l)
+        {
+            return l;
+        }
+
+        delete this;
+        return 0;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::GetTypeInfoCount(UINT*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::GetTypeInfo(UINT, LCID, ITypeInfo**)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::GetIDsOfNames(const IID&, LPOLESTR*, UINT, LCID, DISPID*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::Invoke(DISPID, const IID&, LCID, WORD, DISPPARAMS*, VARIANT*, EXCEPINFO*, UINT*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get__NewEnum(IUnknown**)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_Item(long lIndex, IDispatch** ppCatalogObject)
+    {
+        ++cGetItem;
+
+        if (0 > lIndex || lIndex >= m_cObjects)
+        {
+            return E_INVALIDARG;
+        }
+
+        return m_rgpObjects[lIndex]->QueryInterface(IID_IDispatch, reinterpret_cast<void**>(ppCatalogObject));
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_Count(long* plObjectCount)
+    {
+        *plObjectCount = m_cObjects;
+        return S_OK;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::Remove(long lIndex)
+    {
+        ++cRemove;
+
+        if (0 > lIndex || lIndex >= m_cObjects)
+        {
+            return E_INVALIDARG;
+        }
+
+        m_rgpObjects[lIndex]->Release();
+
+        for (long i = lIndex + 1; i < m_cObjects; ++i)
+        {
+            m_rgpObjects[i - 1] = m_rgpObjects[i];
+        }
+
+        --m_cObjects;
+        ++m_cChanges;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::Add(IDispatch**)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::Populate()
+    {
+        ++cPopulate;
+        return S_OK;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::SaveChanges(long* pcChanges)
+    {
+        ++cSaveChanges;
+
+        *pcChanges = m_cChanges;
+        m_cChanges = 0;
+
+        return S_OK;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::GetCollection(BSTR, VARIANT, IDispatch**)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_Name(VARIANT*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_AddEnabled(VARIANT_BOOL*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_RemoveEnabled(VARIANT_BOOL*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::GetUtilInterface(IDispatch**)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_DataStoreMajorVersion(long*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::get_DataStoreMinorVersion(long*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::PopulateByKey(SAFEARRAY*)
+    {
+        return E_NOTIMPL;
+    }
+
+    STDMETHODIMP CFakeCatalogCollection::PopulateByQuery(BSTR, long)
+    {
+        return E_NOTIMPL;
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+namespace ExtTests
+{
+    const long FAKE_CATALOG_MAX_OBJECTS = 16;
+
+    // In-memory stand-in for a COM+ catalog object with just a key and a name.
+    class CFakeCatalogObject : public ICatalogObject
+    {
+    public:
+        CFakeCatalogObject(LPCWSTR wzKey, LPCWSTR wzName);
+        CFakeCatalogObject(long lKey, LPCWSTR wzName);
+        ~CFakeCatalogObject();
+
+        void SetName(LPCWSTR wzName);
+
+    public: // IUnknown
+        virtual STDMETHODIMP QueryInterface(const IID& riid, void** ppvObject);
+        virtual STDMETHODIMP_(ULONG) AddRef();
+        virtual STDMETHODIMP_(ULONG) Release();
+
+    public: // IDispatch
+        virtual STDMETHODIMP GetTypeInfoCount(UINT* pctinfo);
+        virtual STDMETHODIMP GetTypeInfo(UINT iTInfo, LCID lcid, ITypeInfo** ppTInfo);
+        virtual STDMETHODIMP GetIDsOfNames(const IID& riid, LPOLESTR* rgszNames, UINT cNames, LCID lcid, DISPID* rgDispId);
+        virtual STDMETHODIMP Invoke(DISPID dispIdMember, const IID& riid, LCID lcid, WORD wFlags, DISPPARAMS* pDispParams, VARIANT* pVarResult, EXCEPINFO* pExcepInfo, UINT* puArgErr);
+
+    public: // ICatalogObject
+        virtual STDMETHODIMP get_Value(BSTR bstrPropName, VARIANT* pvarRetVal);
+        virtual STDMETHODIMP put_Value(BSTR bstrPropName, VARIANT val);
+        virtual STDMETHODIMP get_Key(VARIANT* pvarRetVal);
+        virtual STDMETHODIMP get_Name(VARIANT* pvarRetVal);
+        virtual STDMETHODIMP IsPropertyReadOnly(BSTR bstrPropName, VARIANT_BOOL* pbRetVal);
+        virtual STDMETHODIMP get_Valid(VARIANT_BOOL* pbRetVal);
+        virtual STDMETHODIMP IsPropertyWriteOnly(BSTR bstrPropName, VARIANT_BOOL* pbRetVal);
+
+    private:
+        long m_cReferences;
+        VARIANT m_vtKey;
+        BSTR m_bstrName;
+    };
+
+    // In-memory stand-in for a COM+ catalog collection that counts the calls
+    // the collection index makes so tests can tell when it goes back to the catalog.
+    class CFakeCatalogCollection : public ICatalogCollection
+    {
+    public:
+        CFakeCatalogCollection();
+        ~CFakeCatalogCollection();
+
+        void Append(CFakeCatalogObject* pObject);
+        CFakeCatalogObject* ObjectAt(long lIndex);
+
+        long cGetItem;
+        long cRemove;
+        long cPopulate;
+        long cSaveChanges;
+
+    public: // IUnknown
+        virtual STDMETHODIMP QueryInterface(const IID& riid, void** ppvObject);
+        virtual STDMETHODIMP_(ULONG) AddRef();
+        virtual STDMETHODIMP_(ULONG) Release();
+
+    public: // IDispatch
+        virtual STDMETHODIMP GetTypeInfoCount(UINT* pctinfo);
+        virtual STDMETHODIMP GetTypeInfo(UINT iTInfo, LCID lcid, ITypeInfo** ppTInfo);
+        virtual STDMETHODIMP GetIDsOfNames(const IID& riid, LPOLESTR* rgszNames, UINT cNames, LCID lcid, DISPID* rgDispId);
+        virtual STDMETHODIMP Invoke(DISPID dispIdMember, const IID& riid, LCID lcid, WORD wFlags, DISPPARAMS* pDispParams, VARIANT* pVarResult, EXCEPINFO* pExcepInfo, UINT* puArgErr);
+
+    public: // ICatalogCollection
+        virtual STDMETHODIMP get__NewEnum(IUnknown** ppEnumVariant);
+        virtual STDMETHODIMP get_Item(long lIndex, IDispatch** ppCatalogObject);
+        virtual STDMETHODIMP get_Count(long* plObjectCount);
+        virtual STDMETHODIMP Remove(long lIndex);
+        virtual STDMETHODIMP Add(IDispatch** ppCatalogObject);
+        virtual STDMETHODIMP Populate();
+        virtual STDMETHODIMP SaveChanges(long* pcChanges);
+        virtual STDMETHODIMP GetCollection(BSTR bstrCollName, VARIANT varObjectKey, IDispatch** ppCatalogCollection);
+        virtual STDMETHODIMP get_Name(VARIANT* pVarNamel);
+        virtual STDMETHODIMP get_AddEnabled(VARIANT_BOOL* pVarBool);
+        virtual STDMETHODIMP get_RemoveEnabled(VARIANT_BOOL* pVarBool);
+        virtual STDMETHODIMP GetUtilInterface(IDispatch** ppIDispatch);
+        virtual STDMETHODIMP get_DataStoreMajorVersion(long* plMajorVersion);
+        virtual STDMETHODIMP get_DataStoreMinorVersion(long* plMinorVersionl);
+        virtual STDMETHODIMP PopulateByKey(SAFEARRAY* psaKeys);
+        virtual STDMETHODIMP PopulateByQuery(BSTR bstrQueryString, long lQueryType);
+
+    private:
+        long m_cReferences;
+        long m_cChanges;
+        CFakeCatalogObject* m_rgpObjects[FAKE_CATALOG_MAX_OBJECTS];
+        long m_cObjects;
+    };
+}
@@ -0,0 +1,103 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace ExtTests
+{
+    public ref class FirewallRules
+    {
+    public:
+        [Fact]
+        void FirewallRulesPlanActionTest()
+        {
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ADD, FwRulePlanAction(WCA_TODO_INSTALL, FALSE));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ADD, FwRulePlanAction(WCA_TODO_REINSTALL, FALSE));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ENABLE, FwRulePlanAction(WCA_TODO_INSTALL, TRUE));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ENABLE, FwRulePlanAction(WCA_TODO_REINSTALL, TRUE));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_REMOVE, FwRulePlanAction(WCA_TODO_UNINSTALL, TRUE));
+
+            // Removing a rule that isn't there is skipped.
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_NONE, FwRulePlanAction(WCA_TODO_UNINSTALL, FALSE));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_NONE, FwRulePlanAction(WCA_TODO_UNKNOWN, TRUE));
+        }
+
+        [Fact]
+        void FirewallRulesSnapshotTest()
+        {
+            HRESULT hr = S_OK;
+            FW_RULE_SNAPSHOT snapshot = { };
+
+            try
+            {
+                hr = DictCreateStringList(&snapshot.sdNames, 0, DICT_FLAG_CASEINSENSITIVE);
+                NativeAssert::Succeeded(hr, "Failed to create firewall rule name dictionary.");
+
+                hr = FwRuleSnapshotAdd(&snapshot, L"Existing Rule");
+                NativeAssert::Succeeded(hr, "Failed to add existing rule to snapshot.");
+                NativeAssert::Equal<DWORD>(1, snapshot.cNames);
+
+                Assert::True(FwRuleSnapshotContains(&snapshot, L"EXISTING RULE"));
+                NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ENABLE, FwRulePlanAction(WCA_TODO_INSTALL, FwRuleSnapshotContains(&snapshot, L"Existing Rule")));
+                NativeAssert::Equal<DWORD>(FW_RULE_ACTION_REMOVE, FwRulePlanAction(WCA_TODO_UNINSTALL, FwRuleSnapshotContains(&snapshot, L"Existing Rule")));
+
+                Assert::False(FwRuleSnapshotContains(&snapshot, L"New Rule"));
+                NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ADD, FwRulePlanAction(WCA_TODO_INSTALL, FwRuleSnapshotContains(&snapshot, L"New Rule")));
+                NativeAssert::Equal<DWORD>(FW_RULE_ACTION_NONE, FwRulePlanAction(WCA_TODO_UNINSTALL, FwRuleSnapshotContains(&snapshot, L"New Rule")));
+            }
+            finally
+            {
+                FwRuleSnapshotUninitialize(&snapshot);
+            }
+        }
+
+        [Fact]
+        void FirewallRulesSnapshotDuplicateAddTest()
+        {
+            HRESULT hr = S_OK;
+            FW_RULE_SNAPSHOT snapshot = { };
+
+            try
+            {
+                hr = DictCreateStringList(&snapshot.sdNames, 0, DICT_FLAG_CASEINSENSITIVE);
+                NativeAssert::Succeeded(hr, "Failed to create firewall rule name dictionary.");
+
+                NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ADD, FwRulePlanAction(WCA_TODO_INSTALL, FwRuleSnapshotContains(&snapshot, L"Shared Rule")));
+
+                hr = FwRuleSnapshotAdd(&snapshot, L"Shared Rule");
+                NativeAssert::Succeeded(hr, "Failed to remember added rule.");
+                NativeAssert::Equal<DWORD>(1, snapshot.cNames);
+
+                // A second exception with the same name enables the rule the first one added.
+                NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ENABLE, FwRulePlanAction(WCA_TODO_INSTALL, FwRuleSnapshotContains(&snapshot, L"shared rule")));
+
+                hr = FwRuleSnapshotAdd(&snapshot, L"shared rule");
+                NativeAssert::Succeeded(hr, "Failed to remember enabled rule.");
+                NativeAssert::Equal<DWORD>(1, snapshot.cNames);
+            }
+            finally
+            {
+                FwRuleSnapshotUninitialize(&snapshot);
+            }
+        }
+
+        [Fact]
+        void FirewallRulesWithoutSnapshotTest()
+        {
+            HRESULT hr = S_OK;
+            FW_RULE_SNAPSHOT snapshot = { };
+
+            // Without a snapshot every rule may exist, so each one is looked up instead.
+            Assert::True(FwRuleSnapshotContains(&snapshot, L"Any Rule"));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_ENABLE, FwRulePlanAction(WCA_TODO_INSTALL, FwRuleSnapshotContains(&snapshot, L"Any Rule")));
+            NativeAssert::Equal<DWORD>(FW_RULE_ACTION_REMOVE, FwRulePlanAction(WCA_TODO_UNINSTALL, FwRuleSnapshotContains(&snapshot, L"Any Rule")));
+
+            hr = FwRuleSnapshotAdd(&snapshot, L"Any Rule");
+            NativeAssert::Succeeded(hr, "Failed to ignore rule without a snapshot.");
+            NativeAssert::Equal<DWORD>(0, snapshot.cNames);
+        }
+    };
+}
@@ -0,0 +1,153 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+#include "precomp.h"
+
+using namespace System;
+using namespace Xunit;
+using namespace WixTest;
+
+namespace ExtTests
+{
+    public ref class UrlAcl
+    {
+    public:
+        [Fact]
+        void UrlAclSnapshotDiffAddTest()
+        {
+            URLACL_SNAPSHOT before = { };
+            URLACL_SNAPSHOT after = { };
+            URLACL_ACTION rgActions[3] = { };
+
+            try
+            {
+                AddExisting(&before, L"http://+:80/Other/", L"D:(A;;GX;;;SY)");
+
+                AddAuthored(&after, L"http://+:80/New/", L"D:(A;;GX;;;SY)", WCA_TODO_INSTALL, heReplace);
+                AddAuthored(&after, L"http://+:80/NewIgnore/", L"D:(A;;GX;;;SY)", WCA_TODO_INSTALL, heIgnore);
+                AddAuthored(&after, L"http://+:80/NewFail/", L"D:(A;;GX;;;SY)", WCA_TODO_REINSTALL, heFail);
+
+                UrlAclSnapshotDiff(&before, &after, rgActions);
+
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_ADD, rgActions[0]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_ADD, rgActions[1]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_ADD, rgActions[2]);
+            }
+            finally
+            {
+                UrlAclSnapshotUninitialize(&after);
+                UrlAclSnapshotUninitialize(&before);
+            }
+        }
+
+        [Fact]
+        void UrlAclSnapshotDiffRemoveTest()
+        {
+            URLACL_SNAPSHOT before = { };
+            URLACL_SNAPSHOT after = { };
+            URLACL_ACTION rgActions[2] = { };
+
+            try
+            {
+                AddExisting(&before, L"http://+:80/Existing/", L"D:(A;;GX;;;SY)");
+
+                AddAuthored(&after, L"http://+:80/Existing/", L"D:", WCA_TODO_UNINSTALL, heIgnore);
+
+                // Uninstall removes even without a matching reservation, since removing one that isn't there is ignored.
+                AddAuthored(&after, L"http://+:80/Missing/", L"D:", WCA_TODO_UNINSTALL, heReplace);
+
+                UrlAclSnapshotDiff(&before, &after, rgActions);
+
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_REMOVE, rgActions[0]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_REMOVE, rgActions[1]);
+            }
+            finally
+            {
+                UrlAclSnapshotUninitialize(&after);
+                UrlAclSnapshotUninitialize(&before);
+            }
+        }
+
+        [Fact]
+        void UrlAclSnapshotDiffUnchangedTest()
+        {
+            URLACL_SNAPSHOT before = { };
+            URLACL_SNAPSHOT after = { };
+            URLACL_ACTION rgActions[3] = { };
+
+            try
+            {
+                AddExisting(&before, L"http://+:80/Same/", L"D:(A;;GX;;;SY)");
+                AddExisting(&before, L"http://+:80/Spelled/", L"D:(A;;0x20000000;;;S-1-5-18)");
+                AddExisting(&before, L"http://+:80/Ignored/", L"D:(A;;GA;;;BU)");
+
+                // HTTP.sys matches URL prefixes case-insensitively and returns its own spelling of the SDDL.
+                AddAuthored(&after, L"HTTP://+:80/same/", L"D:(A;;GX;;;SY)", WCA_TODO_INSTALL, heReplace);
+                AddAuthored(&after, L"http://+:80/Spelled/", L"D:(A;;GX;;;SY)", WCA_TODO_REINSTALL, heReplace);
+                AddAuthored(&after, L"http://+:80/Ignored/", L"D:(A;;GX;;;SY)", WCA_TODO_INSTALL, heIgnore);
+
+                UrlAclSnapshotDiff(&before, &after, rgActions);
+
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_NONE, rgActions[0]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_NONE, rgActions[1]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_NONE, rgActions[2]);
+            }
+            finally
+            {
+                UrlAclSnapshotUninitialize(&after);
+                UrlAclSnapshotUninitialize(&before);
+            }
+        }
+
+        [Fact]
+        void UrlAclSnapshotDiffChangedSddlTest()
+        {
+            URLACL_SNAPSHOT before = { };
+            URLACL_SNAPSHOT after = { };
+            URLACL_ACTION rgActions[3] = { };
+
+            try
+            {
+                AddExisting(&before, L"http://+:80/Rights/", L"D:(A;;GX;;;SY)");
+                AddExisting(&before, L"http://+:80/Trustee/", L"D:(A;;GX;;;SY)");
+                AddExisting(&before, L"http://+:80/Fail/", L"D:(A;;GX;;;SY)");
+
+                AddAuthored(&after, L"http://+:80/Rights/", L"D:(A;;GA;;;SY)", WCA_TODO_INSTALL, heReplace);
+                AddAuthored(&after, L"http://+:80/Trustee/", L"D:(A;;GX;;;BU)", WCA_TODO_INSTALL, heReplace);
+
+                // An existing reservation that has to fail the install is scheduled so it fails when applied.
+                AddAuthored(&after, L"http://+:80/Fail/", L"D:(A;;GX;;;SY)", WCA_TODO_INSTALL, heFail);
+
+                UrlAclSnapshotDiff(&before, &after, rgActions);
+
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_CHANGE, rgActions[0]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_CHANGE, rgActions[1]);
+                NativeAssert::Equal<DWORD>(URLACL_ACTION_CHANGE, rgActions[2]);
+
+                // The existing SDDL is what rollback restores.
+                NativeAssert::StringEqual(L"D:(A;;GX;;;SY)", UrlAclSnapshotFind(&before, L"HTTP://+:80/RIGHTS/"));
+                Assert::True(NULL == UrlAclSnapshotFind(&before, L"http://+:80/Missing/"));
+            }
+            finally
+            {
+                UrlAclSnapshotUninitialize(&after);
+                UrlAclSnapshotUninitialize(&before);
+            }
+        }
+
+    private:
+        void AddExisting(URLACL_SNAPSHOT* pSnapshot, LPCWSTR wzUrl, LPCWSTR wzSddl)
+        {
+            HRESULT hr = UrlAclSnapshotAdd(pSnapshot, wzUrl, wzSddl, WCA_TODO_UNKNOWN, 0);
+            NativeAssert::Succeeded(hr, "Failed to add existing reservation: {0}", wzUrl);
+
+            hr = UrlAclSnapshotIndex(pSnapshot);
+            NativeAssert::Succeeded(hr, "Failed to index existing reservations.");
+        }
+
+        void AddAuthored(URLACL_SNAPSHOT* pSnapshot, LPCWSTR wzUrl, LPCWSTR wzSddl, WCA_TODO todo, int iHandleExisting)
+        {
+            HRESULT hr = UrlAclSnapshotAdd(pSnapshot, wzUrl, wzSddl, todo, iHandleExisting);
+            NativeAssert::Succeeded(hr, "Failed to add authored reservation: {0}", wzUrl);
+        }
+    };
+}
@@ -0,0 +1,24 @@
+#pragma once
+// Copyright (c) .NET Foundation and contributors. All rights reserved. Licensed under the Microsoft Reciprocal License. See LICENSE.TXT file in the project root for full license information.
+
+
+#include <windows.h>
+#include <msiquery.h>
+#include <strsafe.h>
+#include <netfw.h>
+#include <comadmin.h>
+#include <http.h>
+
+#include <wcautil.h>
+#include <dictutil.h>
+#include <strutil.h>
+#include <wiutil.h>
+
+#include "fwrules.h"
+#include "cputilexec.h"
+#include "urlacl.h"
+
+#pragma managed
+#include <vcclr.h>
+
+#include "FakeCatalog.h"
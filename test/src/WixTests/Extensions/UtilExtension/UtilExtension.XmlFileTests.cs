@@ -5,6 +5,7 @@ namespace WixTest.Tests.Extensions.UtilExtension
     using System;
     using System.IO;
     using System.Collections.Generic;
+    using System.Text;
     using WixTest;
     using WixTest.Verifiers;
     using WixTest.Verifiers.Extensions;
@@ -243,6 +244,45 @@ namespace WixTest.Tests.Extensions.UtilExtension
             Assert.False(File.Exists(fileName), String.Format("XMLFile '{0}' was not removed on Rollback.", fileName));
         }
 
+        [NamedFact]
+        [Description("Verify that a large existing xml file is put back exactly the way it was on rollback and its rollback journal is removed.")]
+        [Priority(2)]
+        [RuntimeTest]
+        public void XmlFile_RollbackLargeExistingFile()
+        {
+            string sourceFile = Path.Combine(XmlFileTests.TestDataDirectory, @"product_rollback.wxs");
+            string targetFile = Utilities.FileUtilities.GetUniqueFileName();
+
+            // Create a test.xml that is far too large to have been carried in CustomActionData.
+            string contents = File.ReadAllText(Path.Combine(XmlFileTests.TestDataDirectory, @"test.xml"));
+            StringBuilder builder = new StringBuilder(contents.Substring(0, contents.LastIndexOf("</Root>")));
+            for (int i = 0; i < 100000; ++i)
+            {
+                builder.AppendFormat("  <Item id=\"{0}\">Item number {0} of a large xml file.</Item>\r\n", i);
+            }
+            builder.Append("</Root>\r\n");
+            File.WriteAllText(targetFile, builder.ToString());
+
+            DateTime lastWriteTime = new DateTime(2000, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+            File.SetLastWriteTimeUtc(targetFile, lastWriteTime);
+            byte[] originalBytes = File.ReadAllBytes(targetFile);
+
+            // build the msi and pass targetfile as a param to the .wxs file
+            string msiFile = Builder.BuildPackage(Environment.CurrentDirectory, sourceFile, "test.msi", string.Format("-dTargetFile=\"{0}\" -ext WixUtilExtension", targetFile), "-ext WixUtilExtension");
+
+            MSIExec.InstallProduct(msiFile, MSIExec.MSIExecReturnCode.ERROR_INSTALL_FAILURE);
+
+            // Verify the file and its modified date were restored
+            Assert.True(File.Exists(targetFile), String.Format("XMLFile '{0}' was removed on Rollback.", targetFile));
+            Assert.Equal(originalBytes, File.ReadAllBytes(targetFile));
+            Assert.Equal(lastWriteTime, File.GetLastWriteTimeUtc(targetFile));
+
+            // Verify the rollback journal didn't outlive the install
+            string installerFolder = Path.Combine(Environment.GetFolderPath(Environment.SpecialFolder.Windows), "Installer");
+            string[] journals = Directory.GetFiles(installerFolder, "wix{00000000-0000-0000-0005-000000000011}.*");
+            Assert.True(0 == journals.Length, String.Format("Rollback journal '{0}' was not removed on Rollback.", 0 < journals.Length ? journals[0] : null));
+        }
+
         #region Helper Methods
         /// <summary>
         /// verifies the transformation done using XMLFile in XMLFile.wix